@@ -0,0 +1,489 @@
+/****************************************************************************
+ * examples/fatbench/fatbench_main.c
+ *
+ *   Copyright (C) 2014 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mount.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include <nuttx/fs/fs.h>
+#include <nuttx/fs/mkfatfs.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifndef CONFIG_EXAMPLES_FATBENCH_NSECTORS
+#  define CONFIG_EXAMPLES_FATBENCH_NSECTORS 4096
+#endif
+
+#ifndef CONFIG_EXAMPLES_FATBENCH_SECTORSIZE
+#  define CONFIG_EXAMPLES_FATBENCH_SECTORSIZE 512
+#endif
+
+#ifndef CONFIG_EXAMPLES_FATBENCH_NFILES
+#  define CONFIG_EXAMPLES_FATBENCH_NFILES 64
+#endif
+
+#ifndef CONFIG_EXAMPLES_FATBENCH_STREAMSIZE
+#  define CONFIG_EXAMPLES_FATBENCH_STREAMSIZE 262144
+#endif
+
+#define FATBENCH_DEVPATH    "/dev/fatbench"
+#define FATBENCH_MOUNTPT    "/mnt/fatbench"
+#define FATBENCH_DIRPATH    FATBENCH_MOUNTPT "/dir"
+#define FATBENCH_STREAMPATH FATBENCH_MOUNTPT "/stream.dat"
+#define FATBENCH_SMALLSIZE  100
+#define FATBENCH_IOSIZE     512
+#define FATBENCH_NSEEKS     64
+#define FATBENCH_NBLOCKS    (CONFIG_EXAMPLES_FATBENCH_STREAMSIZE / FATBENCH_IOSIZE)
+
+/****************************************************************************
+ * Private Function Prototypes
+ ****************************************************************************/
+
+static ssize_t fatbench_read(FAR struct inode *inode, FAR unsigned char *buffer,
+                             size_t start_sector, unsigned int nsectors);
+static ssize_t fatbench_write(FAR struct inode *inode,
+                              FAR const unsigned char *buffer,
+                              size_t start_sector, unsigned int nsectors);
+static int     fatbench_geometry(FAR struct inode *inode,
+                                 FAR struct geometry *geometry);
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* A RAM disk that counts the sectors transferred */
+
+static const struct block_operations g_bops =
+{
+  NULL,              /* open */
+  NULL,              /* close */
+  fatbench_read,     /* read */
+  fatbench_write,    /* write */
+  fatbench_geometry, /* geometry */
+  NULL               /* ioctl */
+};
+
+static FAR uint8_t *g_disk;
+static unsigned long g_nreads;
+static unsigned long g_nrequests;
+static unsigned long g_nwrites;
+
+static struct fat_format_s g_fmt = FAT_FORMAT_INITIALIZER;
+static char g_iobuffer[FATBENCH_IOSIZE];
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: fatbench_read, fatbench_write, and fatbench_geometry
+ *
+ * Description:
+ *   Block driver methods of the counting RAM disk.
+ *
+ ****************************************************************************/
+
+static ssize_t fatbench_read(FAR struct inode *inode, FAR unsigned char *buffer,
+                             size_t start_sector, unsigned int nsectors)
+{
+  if (start_sector + nsectors > CONFIG_EXAMPLES_FATBENCH_NSECTORS)
+    {
+      return -EINVAL;
+    }
+
+  memcpy(buffer, &g_disk[start_sector * CONFIG_EXAMPLES_FATBENCH_SECTORSIZE],
+         nsectors * CONFIG_EXAMPLES_FATBENCH_SECTORSIZE);
+  g_nreads += nsectors;
+  g_nrequests++;
+  return nsectors;
+}
+
+static ssize_t fatbench_write(FAR struct inode *inode,
+                              FAR const unsigned char *buffer,
+                              size_t start_sector, unsigned int nsectors)
+{
+  if (start_sector + nsectors > CONFIG_EXAMPLES_FATBENCH_NSECTORS)
+    {
+      return -EINVAL;
+    }
+
+  memcpy(&g_disk[start_sector * CONFIG_EXAMPLES_FATBENCH_SECTORSIZE], buffer,
+         nsectors * CONFIG_EXAMPLES_FATBENCH_SECTORSIZE);
+  g_nwrites += nsectors;
+  return nsectors;
+}
+
+static int fatbench_geometry(FAR struct inode *inode,
+                             FAR struct geometry *geometry)
+{
+  memset(geometry, 0, sizeof(struct geometry));
+  geometry->geo_available    = true;
+  geometry->geo_writeenabled = true;
+  geometry->geo_nsectors     = CONFIG_EXAMPLES_FATBENCH_NSECTORS;
+  geometry->geo_sectorsize   = CONFIG_EXAMPLES_FATBENCH_SECTORSIZE;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: fatbench_begin and fatbench_end
+ *
+ * Description:
+ *   Reset the counters before an operation and report the sectors
+ *   transferred per operation afterward.
+ *
+ ****************************************************************************/
+
+static void fatbench_begin(void)
+{
+  g_nreads    = 0;
+  g_nrequests = 0;
+  g_nwrites   = 0;
+}
+
+static void fatbench_end(FAR const char *name, int nops)
+{
+  printf("%-16s %6d %8lu %8lu %8lu %6lu.%02lu %6lu.%02lu\n",
+         name, nops, g_nreads, g_nrequests, g_nwrites,
+         g_nreads / nops, (g_nreads * 100 / nops) % 100,
+         g_nwrites / nops, (g_nwrites * 100 / nops) % 100);
+}
+
+/****************************************************************************
+ * Name: fatbench_filename
+ ****************************************************************************/
+
+static void fatbench_filename(FAR char *path, int index)
+{
+  sprintf(path, FATBENCH_DIRPATH "/FILE%04d.TXT", index);
+}
+
+/****************************************************************************
+ * Name: fatbench_stat
+ *
+ * Description:
+ *   stat() every small file.
+ *
+ ****************************************************************************/
+
+static int fatbench_stat(FAR const char *name)
+{
+  struct stat buf;
+  char path[64];
+  int i;
+
+  fatbench_begin();
+  for (i = 0; i < CONFIG_EXAMPLES_FATBENCH_NFILES; i++)
+    {
+      fatbench_filename(path, i);
+      if (stat(path, &buf) < 0 || buf.st_size != FATBENCH_SMALLSIZE)
+        {
+          printf("fatbench: stat(%s) failed: %d\n", path, errno);
+          return ERROR;
+        }
+    }
+
+  fatbench_end(name, CONFIG_EXAMPLES_FATBENCH_NFILES);
+  return OK;
+}
+
+/****************************************************************************
+ * Name: fatbench_run
+ *
+ * Description:
+ *   Perform each of the operations on the mounted volume.
+ *
+ ****************************************************************************/
+
+static int fatbench_run(void)
+{
+  FAR struct dirent *entry;
+  FAR DIR *dirp;
+  FAR char *bigbuffer;
+  char path[64];
+  ssize_t nbytes;
+  int nentries;
+  int total;
+  int fd;
+  int i;
+
+  if (mkdir(FATBENCH_DIRPATH, 0777) < 0)
+    {
+      printf("fatbench: mkdir(%s) failed: %d\n", FATBENCH_DIRPATH, errno);
+      return ERROR;
+    }
+
+  printf("Operation         count    reads requests  writes reads/op writes/op\n");
+
+  /* Create the small files */
+
+  memset(g_iobuffer, 'x', FATBENCH_SMALLSIZE);
+
+  fatbench_begin();
+  for (i = 0; i < CONFIG_EXAMPLES_FATBENCH_NFILES; i++)
+    {
+      fatbench_filename(path, i);
+      fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+      if (fd < 0)
+        {
+          printf("fatbench: open(%s) failed: %d\n", path, errno);
+          return ERROR;
+        }
+
+      nbytes = write(fd, g_iobuffer, FATBENCH_SMALLSIZE);
+      close(fd);
+
+      if (nbytes != FATBENCH_SMALLSIZE)
+        {
+          printf("fatbench: write(%s) failed: %d\n", path, errno);
+          return ERROR;
+        }
+    }
+
+  fatbench_end("create", CONFIG_EXAMPLES_FATBENCH_NFILES);
+
+  /* Look up each file */
+
+  if (fatbench_stat("stat") < 0)
+    {
+      return ERROR;
+    }
+
+  /* List the directory */
+
+  fatbench_begin();
+  dirp = opendir(FATBENCH_DIRPATH);
+  if (!dirp)
+    {
+      printf("fatbench: opendir(%s) failed: %d\n", FATBENCH_DIRPATH, errno);
+      return ERROR;
+    }
+
+  for (nentries = 0; (entry = readdir(dirp)) != NULL; nentries++);
+  closedir(dirp);
+  fatbench_end("readdir", nentries > 0 ? nentries : 1);
+
+  /* Write a large file sequentially */
+
+  fd = open(FATBENCH_STREAMPATH, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if (fd < 0)
+    {
+      printf("fatbench: open(%s) failed: %d\n", FATBENCH_STREAMPATH, errno);
+      return ERROR;
+    }
+
+  fatbench_begin();
+  for (total = 0; total < CONFIG_EXAMPLES_FATBENCH_STREAMSIZE;
+       total += FATBENCH_IOSIZE)
+    {
+      memset(g_iobuffer, total / FATBENCH_IOSIZE, FATBENCH_IOSIZE);
+      nbytes = write(fd, g_iobuffer, FATBENCH_IOSIZE);
+      if (nbytes != FATBENCH_IOSIZE)
+        {
+          printf("fatbench: write failed: %d\n", errno);
+          close(fd);
+          return ERROR;
+        }
+    }
+
+  close(fd);
+  fatbench_end("stream write", CONFIG_EXAMPLES_FATBENCH_STREAMSIZE /
+               FATBENCH_IOSIZE);
+
+  /* The file system meta-data should still be cached */
+
+  if (fatbench_stat("stat again") < 0)
+    {
+      return ERROR;
+    }
+
+  /* Read the large file back */
+
+  fd = open(FATBENCH_STREAMPATH, O_RDONLY);
+  if (fd < 0)
+    {
+      printf("fatbench: open(%s) failed: %d\n", FATBENCH_STREAMPATH, errno);
+      return ERROR;
+    }
+
+  fatbench_begin();
+  for (total = 0; total < CONFIG_EXAMPLES_FATBENCH_STREAMSIZE;
+       total += FATBENCH_IOSIZE)
+    {
+      nbytes = read(fd, g_iobuffer, FATBENCH_IOSIZE);
+      if (nbytes != FATBENCH_IOSIZE ||
+          (uint8_t)g_iobuffer[0] != (uint8_t)(total / FATBENCH_IOSIZE))
+        {
+          printf("fatbench: read failed: %d\n", errno);
+          close(fd);
+          return ERROR;
+        }
+    }
+
+  fatbench_end("stream read", FATBENCH_NBLOCKS);
+
+  /* Read one block at scattered positions in the large file */
+
+  fatbench_begin();
+  for (i = 0; i < FATBENCH_NSEEKS; i++)
+    {
+      total = (int)(((unsigned long)i * 7919) % FATBENCH_NBLOCKS);
+      if (lseek(fd, (off_t)total * FATBENCH_IOSIZE, SEEK_SET) < 0 ||
+          read(fd, g_iobuffer, FATBENCH_IOSIZE) != FATBENCH_IOSIZE ||
+          (uint8_t)g_iobuffer[0] != (uint8_t)total)
+        {
+          printf("fatbench: seek and read failed: %d\n", errno);
+          close(fd);
+          return ERROR;
+        }
+    }
+
+  fatbench_end("seek and read", FATBENCH_NSEEKS);
+
+  /* Read the whole large file with one read() */
+
+  bigbuffer = (FAR char *)malloc(CONFIG_EXAMPLES_FATBENCH_STREAMSIZE);
+  if (bigbuffer)
+    {
+      fatbench_begin();
+      if (lseek(fd, 0, SEEK_SET) < 0 ||
+          read(fd, bigbuffer, CONFIG_EXAMPLES_FATBENCH_STREAMSIZE) !=
+            CONFIG_EXAMPLES_FATBENCH_STREAMSIZE)
+        {
+          printf("fatbench: read failed: %d\n", errno);
+          free(bigbuffer);
+          close(fd);
+          return ERROR;
+        }
+
+      fatbench_end("whole file read", 1);
+      free(bigbuffer);
+    }
+
+  close(fd);
+
+  /* Remove everything */
+
+  fatbench_begin();
+  for (i = 0; i < CONFIG_EXAMPLES_FATBENCH_NFILES; i++)
+    {
+      fatbench_filename(path, i);
+      if (unlink(path) < 0)
+        {
+          printf("fatbench: unlink(%s) failed: %d\n", path, errno);
+          return ERROR;
+        }
+    }
+
+  fatbench_end("unlink", CONFIG_EXAMPLES_FATBENCH_NFILES);
+
+  (void)unlink(FATBENCH_STREAMPATH);
+  (void)rmdir(FATBENCH_DIRPATH);
+  return OK;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * fatbench_main
+ ****************************************************************************/
+
+int fatbench_main(int argc, char *argv[])
+{
+  int ret;
+
+  /* Create and format the RAM disk */
+
+  g_disk = (FAR uint8_t *)malloc(CONFIG_EXAMPLES_FATBENCH_NSECTORS *
+                                 CONFIG_EXAMPLES_FATBENCH_SECTORSIZE);
+  if (!g_disk)
+    {
+      printf("fatbench: Failed to allocate the RAM disk\n");
+      return EXIT_FAILURE;
+    }
+
+  ret = register_blockdriver(FATBENCH_DEVPATH, &g_bops, 0, NULL);
+  if (ret < 0)
+    {
+      printf("fatbench: register_blockdriver failed: %d\n", ret);
+      free(g_disk);
+      return EXIT_FAILURE;
+    }
+
+  ret = mkfatfs(FATBENCH_DEVPATH, &g_fmt);
+  if (ret < 0)
+    {
+      printf("fatbench: mkfatfs failed: %d\n", errno);
+      goto errout;
+    }
+
+  /* Mount it and run the test */
+
+  fatbench_begin();
+  ret = mount(FATBENCH_DEVPATH, FATBENCH_MOUNTPT, "vfat", 0, NULL);
+  if (ret < 0)
+    {
+      printf("fatbench: mount failed: %d\n", errno);
+      goto errout;
+    }
+
+  printf("fatbench: mount: %lu reads, %lu writes\n", g_nreads, g_nwrites);
+
+  ret = fatbench_run();
+  (void)umount(FATBENCH_MOUNTPT);
+
+errout:
+  (void)unregister_blockdriver(FATBENCH_DEVPATH);
+  free(g_disk);
+  return ret < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
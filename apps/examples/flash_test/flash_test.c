@@ -69,7 +69,7 @@ int flash_test_main(int argc, char *argv[])
   int           logsector;
   uint16_t      seq;
   struct smart_format_s fmt;
-  uint16_t     *sectors;
+  smart_sector_t *sectors;
   uint16_t     *seqs;
   char         *buffer;
   struct smart_read_write_s readwrite;
@@ -121,9 +121,10 @@ int flash_test_main(int argc, char *argv[])
 
   printf("FLASH Test on device with:\n");
   printf("   Sector size:  %10d\n", fmt.sectorsize);
-  printf("   Sector count: %10d\n", fmt.nsectors);
+  printf("   Sector count: %10lu\n", (unsigned long)fmt.nsectors);
   printf("   Avail bytes:  %10d\n", fmt.availbytes);
-  printf("   Total size:   %10d\n", fmt.sectorsize * fmt.nsectors);
+  printf("   Total size:   %10lu\n",
+         (unsigned long)fmt.sectorsize * fmt.nsectors);
 
   /* Allocate buffers to use */
 
@@ -142,7 +143,7 @@ int flash_test_main(int argc, char *argv[])
       goto errout_with_driver;
     }
 
-  sectors = (uint16_t *) malloc(fmt.nsectors << 1);
+  sectors = (smart_sector_t *) malloc(fmt.nsectors * sizeof(smart_sector_t));
   if (sectors == NULL)
     {
       (void) free(seqs);
@@ -170,7 +171,7 @@ int flash_test_main(int argc, char *argv[])
 
       /* Save the sector in our array */
      
-      sectors[x] = (uint16_t) logsector;
+      sectors[x] = (smart_sector_t) logsector;
       seqs[x] = seq++;
 
       /* Now write some data to the sector */
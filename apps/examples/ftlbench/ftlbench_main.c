@@ -0,0 +1,468 @@
+/****************************************************************************
+ * examples/ftlbench/ftlbench_main.c
+ *
+ *   Copyright (C) 2014 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <nuttx/fs/fs.h>
+#include <nuttx/fs/ioctl.h>
+#include <nuttx/mtd/mtd.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Configuration ************************************************************/
+
+#ifndef CONFIG_RAMMTD
+#  error "CONFIG_RAMMTD is required"
+#endif
+
+/* This must exactly match the default configuration in drivers/mtd/rammtd.c */
+
+#ifndef CONFIG_RAMMTD_ERASESIZE
+#  define CONFIG_RAMMTD_ERASESIZE 4096
+#endif
+
+#ifndef CONFIG_EXAMPLES_FTLBENCH_NEBLOCKS
+#  define CONFIG_EXAMPLES_FTLBENCH_NEBLOCKS 64
+#endif
+
+#ifndef CONFIG_EXAMPLES_FTLBENCH_NWRITES
+#  define CONFIG_EXAMPLES_FTLBENCH_NWRITES 4096
+#endif
+
+#ifndef CONFIG_EXAMPLES_FTLBENCH_MINOR
+#  define CONFIG_EXAMPLES_FTLBENCH_MINOR 0
+#endif
+
+#define FTLBENCH_FLASHSIZE \
+  (CONFIG_RAMMTD_ERASESIZE * CONFIG_EXAMPLES_FTLBENCH_NEBLOCKS)
+
+/* 90% of the writes of the "hot" test go to 10% of the sectors, like the
+ * FAT and directory sectors of a FAT file system.
+ */
+
+#define FTLBENCH_HOTPERCENT 10
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* An MTD driver that counts the operations on the RAM MTD driver */
+
+struct ftlbench_mtd_s
+{
+  struct mtd_dev_s mtd;              /* Must be first */
+  FAR struct mtd_dev_s *lower;       /* The RAM MTD driver */
+  uint32_t blkper;                   /* R/W blocks per erase block */
+  unsigned long nprogrammed;         /* R/W blocks written */
+  unsigned long nerased;             /* Erase blocks erased */
+  uint32_t erasecount[CONFIG_EXAMPLES_FTLBENCH_NEBLOCKS];
+};
+
+/****************************************************************************
+ * Private Function Prototypes
+ ****************************************************************************/
+
+static int     ftlbench_erase(FAR struct mtd_dev_s *dev, off_t startblock,
+                              size_t nblocks);
+static ssize_t ftlbench_bread(FAR struct mtd_dev_s *dev, off_t startblock,
+                              size_t nblocks, FAR uint8_t *buf);
+static ssize_t ftlbench_bwrite(FAR struct mtd_dev_s *dev, off_t startblock,
+                               size_t nblocks, FAR const uint8_t *buf);
+static ssize_t ftlbench_byteread(FAR struct mtd_dev_s *dev, off_t offset,
+                                 size_t nbytes, FAR uint8_t *buf);
+static int     ftlbench_ioctl(FAR struct mtd_dev_s *dev, int cmd,
+                              unsigned long arg);
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static struct ftlbench_mtd_s g_mtd;
+static FAR uint8_t *g_simflash;
+static FAR uint8_t *g_sector;
+static FAR uint16_t *g_version;      /* Expected version of each sector */
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: ftlbench_erase, ftlbench_bread, ftlbench_bwrite,
+ *       ftlbench_byteread, and ftlbench_ioctl
+ *
+ * Description:
+ *   MTD driver methods of the counting MTD driver.
+ *
+ ****************************************************************************/
+
+static int ftlbench_erase(FAR struct mtd_dev_s *dev, off_t startblock,
+                          size_t nblocks)
+{
+  FAR struct ftlbench_mtd_s *priv = (FAR struct ftlbench_mtd_s *)dev;
+  size_t i;
+
+  for (i = 0; i < nblocks; i++)
+    {
+      priv->erasecount[startblock + i]++;
+    }
+
+  priv->nerased += nblocks;
+  return MTD_ERASE(priv->lower, startblock, nblocks);
+}
+
+static ssize_t ftlbench_bread(FAR struct mtd_dev_s *dev, off_t startblock,
+                              size_t nblocks, FAR uint8_t *buf)
+{
+  FAR struct ftlbench_mtd_s *priv = (FAR struct ftlbench_mtd_s *)dev;
+  return MTD_BREAD(priv->lower, startblock, nblocks, buf);
+}
+
+static ssize_t ftlbench_bwrite(FAR struct mtd_dev_s *dev, off_t startblock,
+                               size_t nblocks, FAR const uint8_t *buf)
+{
+  FAR struct ftlbench_mtd_s *priv = (FAR struct ftlbench_mtd_s *)dev;
+
+  priv->nprogrammed += nblocks;
+  return MTD_BWRITE(priv->lower, startblock, nblocks, buf);
+}
+
+static ssize_t ftlbench_byteread(FAR struct mtd_dev_s *dev, off_t offset,
+                                 size_t nbytes, FAR uint8_t *buf)
+{
+  FAR struct ftlbench_mtd_s *priv = (FAR struct ftlbench_mtd_s *)dev;
+  return MTD_READ(priv->lower, offset, nbytes, buf);
+}
+
+static int ftlbench_ioctl(FAR struct mtd_dev_s *dev, int cmd,
+                          unsigned long arg)
+{
+  FAR struct ftlbench_mtd_s *priv = (FAR struct ftlbench_mtd_s *)dev;
+  return MTD_IOCTL(priv->lower, cmd, arg);
+}
+
+/****************************************************************************
+ * Name: ftlbench_fill and ftlbench_check
+ *
+ * Description:
+ *   Create and check the content of a sector.  Each sector holds its
+ *   sector number and the number of times it has been written.
+ *
+ ****************************************************************************/
+
+static void ftlbench_fill(size_t sector, uint16_t version, size_t sectorsize)
+{
+  size_t i;
+
+  for (i = 0; i < sectorsize; i++)
+    {
+      g_sector[i] = (uint8_t)(sector + version + i);
+    }
+
+  memcpy(g_sector, &sector, sizeof(size_t));
+  memcpy(&g_sector[sizeof(size_t)], &version, sizeof(uint16_t));
+}
+
+static bool ftlbench_check(size_t sector, uint16_t version, size_t sectorsize)
+{
+  size_t i;
+
+  if (version == 0)
+    {
+      /* Never written */
+
+      return true;
+    }
+
+  if (memcmp(g_sector, &sector, sizeof(size_t)) != 0 ||
+      memcmp(&g_sector[sizeof(size_t)], &version, sizeof(uint16_t)) != 0)
+    {
+      return false;
+    }
+
+  for (i = sizeof(size_t) + sizeof(uint16_t); i < sectorsize; i++)
+    {
+      if (g_sector[i] != (uint8_t)(sector + version + i))
+        {
+          return false;
+        }
+    }
+
+  return true;
+}
+
+/****************************************************************************
+ * Name: ftlbench_run
+ *
+ * Description:
+ *   Write 'nwrites' sectors and report the write amplification (R/W blocks
+ *   programmed per sector written) and the erase counts.  If 'hot' is
+ *   true, most writes go to a small region.  Otherwise sectors are written
+ *   sequentially ('nwrites' equal to the number of sectors) or randomly.
+ *
+ ****************************************************************************/
+
+static int ftlbench_run(FAR struct inode *inode, FAR const char *name,
+                        FAR const struct geometry *geo, size_t nwrites,
+                        bool random, bool hot)
+{
+  unsigned long nprogrammed = g_mtd.nprogrammed;
+  unsigned long nerased     = g_mtd.nerased;
+  unsigned long total       = 0;
+  unsigned long wa;
+  uint32_t minerase = UINT32_MAX;
+  uint32_t maxerase = 0;
+  size_t nhot;
+  size_t sector;
+  size_t i;
+  ssize_t ret;
+
+  nhot = geo->geo_nsectors * FTLBENCH_HOTPERCENT / 100;
+  if (nhot < 1)
+    {
+      nhot = 1;
+    }
+
+  for (i = 0; i < nwrites; i++)
+    {
+      if (!random)
+        {
+          sector = i % geo->geo_nsectors;
+        }
+      else if (hot && (rand() % 100) >= FTLBENCH_HOTPERCENT)
+        {
+          sector = rand() % nhot;
+        }
+      else
+        {
+          sector = rand() % geo->geo_nsectors;
+        }
+
+      g_version[sector]++;
+      ftlbench_fill(sector, g_version[sector], geo->geo_sectorsize);
+
+      ret = inode->u.i_bops->write(inode, g_sector, sector, 1);
+      if (ret != 1)
+        {
+          printf("ftlbench: %s: write sector %lu failed: %ld\n",
+                 name, (unsigned long)sector, (long)ret);
+          return ret < 0 ? ret : -EIO;
+        }
+    }
+
+  /* Read everything back */
+
+  for (sector = 0; sector < geo->geo_nsectors; sector++)
+    {
+      ret = inode->u.i_bops->read(inode, g_sector, sector, 1);
+      if (ret != 1 ||
+          !ftlbench_check(sector, g_version[sector], geo->geo_sectorsize))
+        {
+          printf("ftlbench: %s: sector %lu does not verify\n",
+                 name, (unsigned long)sector);
+          return -EIO;
+        }
+    }
+
+  /* Report the results */
+
+  for (i = 0; i < CONFIG_EXAMPLES_FTLBENCH_NEBLOCKS; i++)
+    {
+      if (g_mtd.erasecount[i] < minerase)
+        {
+          minerase = g_mtd.erasecount[i];
+        }
+
+      if (g_mtd.erasecount[i] > maxerase)
+        {
+          maxerase = g_mtd.erasecount[i];
+        }
+
+      total += g_mtd.erasecount[i];
+    }
+
+  nprogrammed = g_mtd.nprogrammed - nprogrammed;
+  nerased     = g_mtd.nerased - nerased;
+  wa          = nprogrammed * 100 / nwrites;
+
+  printf("%-10s %7lu %9lu %4lu.%02lu %7lu %6lu %6lu %6lu\n",
+         name, (unsigned long)nwrites, nprogrammed, wa / 100, wa % 100,
+         nerased, (unsigned long)minerase, (unsigned long)maxerase,
+         total / CONFIG_EXAMPLES_FTLBENCH_NEBLOCKS);
+  return OK;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * ftlbench_main
+ ****************************************************************************/
+
+int ftlbench_main(int argc, char *argv[])
+{
+  FAR struct inode *inode;
+  struct geometry geo;
+  char devname[16];
+  int ret;
+  int i;
+
+  /* Create the RAM MTD driver and wrap it in the counting MTD driver */
+
+  g_simflash = (FAR uint8_t *)malloc(FTLBENCH_FLASHSIZE);
+  if (!g_simflash)
+    {
+      printf("ftlbench: Failed to allocate the simulated FLASH\n");
+      return EXIT_FAILURE;
+    }
+
+  memset(&g_mtd, 0, sizeof(struct ftlbench_mtd_s));
+  g_mtd.lower = rammtd_initialize(g_simflash, FTLBENCH_FLASHSIZE);
+  if (!g_mtd.lower)
+    {
+      printf("ftlbench: Failed to create RAM MTD instance\n");
+      free(g_simflash);
+      return EXIT_FAILURE;
+    }
+
+  (void)MTD_IOCTL(g_mtd.lower, MTDIOC_BULKERASE, 0);
+
+  g_mtd.mtd.erase  = ftlbench_erase;
+  g_mtd.mtd.bread  = ftlbench_bread;
+  g_mtd.mtd.bwrite = ftlbench_bwrite;
+  g_mtd.mtd.read   = ftlbench_byteread;
+  g_mtd.mtd.ioctl  = ftlbench_ioctl;
+
+  /* Put the FTL on top of it and open the FTL block driver */
+
+  ret = ftl_initialize(CONFIG_EXAMPLES_FTLBENCH_MINOR, &g_mtd.mtd);
+  if (ret < 0)
+    {
+      printf("ftlbench: ftl_initialize failed: %d\n", ret);
+      return EXIT_FAILURE;
+    }
+
+  printf("ftlbench: Initialization: %lu blocks programmed, %lu erased\n",
+         g_mtd.nprogrammed, g_mtd.nerased);
+
+  snprintf(devname, 16, "/dev/mtdblock%d", CONFIG_EXAMPLES_FTLBENCH_MINOR);
+  ret = open_blockdriver(devname, 0, &inode);
+  if (ret < 0)
+    {
+      printf("ftlbench: open_blockdriver(%s) failed: %d\n", devname, ret);
+      return EXIT_FAILURE;
+    }
+
+  ret = inode->u.i_bops->geometry(inode, &geo);
+  if (ret < 0)
+    {
+      printf("ftlbench: geometry failed: %d\n", ret);
+      goto errout;
+    }
+
+  printf("ftlbench: %d erase blocks of %d bytes, %lu sectors of %lu bytes\n",
+         CONFIG_EXAMPLES_FTLBENCH_NEBLOCKS, CONFIG_RAMMTD_ERASESIZE,
+         (unsigned long)geo.geo_nsectors, (unsigned long)geo.geo_sectorsize);
+
+  g_sector  = (FAR uint8_t *)malloc(geo.geo_sectorsize);
+  g_version = (FAR uint16_t *)zalloc(geo.geo_nsectors * sizeof(uint16_t));
+  if (!g_sector || !g_version)
+    {
+      printf("ftlbench: Failed to allocate buffers\n");
+      ret = -ENOMEM;
+      goto errout;
+    }
+
+  /* Run the tests.  Write amplification is the number of R/W blocks
+   * programmed per sector written.
+   */
+
+  srand(1);
+  printf("%-10s %7s %9s %7s %7s %6s %6s %6s\n", "Test", "Writes",
+         "Programs", "WA", "Erases", "MinEC", "MaxEC", "AvgEC");
+
+  ret = ftlbench_run(inode, "sequential", &geo, geo.geo_nsectors,
+                     false, false);
+  if (ret == OK)
+    {
+      ret = ftlbench_run(inode, "random", &geo,
+                         CONFIG_EXAMPLES_FTLBENCH_NWRITES, true, false);
+    }
+
+  if (ret == OK)
+    {
+      ret = ftlbench_run(inode, "hot", &geo,
+                         CONFIG_EXAMPLES_FTLBENCH_NWRITES, true, true);
+    }
+
+  /* Show the wear of each erase block */
+
+  printf("Erase counts:\n");
+  for (i = 0; i < CONFIG_EXAMPLES_FTLBENCH_NEBLOCKS; i++)
+    {
+      printf("%6lu%s", (unsigned long)g_mtd.erasecount[i],
+             (i & 7) == 7 ? "\n" : "");
+    }
+
+  printf("\n");
+
+errout:
+  (void)close_blockdriver(inode);
+  if (g_sector)
+    {
+      free(g_sector);
+    }
+
+  if (g_version)
+    {
+      free(g_version);
+    }
+
+  return ret < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
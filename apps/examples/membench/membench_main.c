@@ -0,0 +1,306 @@
+/****************************************************************************
+ * examples/membench/membench_main.c
+ *
+ *   Copyright (C) 2014 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <crc16.h>
+#include <crc32.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifndef CONFIG_EXAMPLES_MEMBENCH_MAXSIZE
+#  define CONFIG_EXAMPLES_MEMBENCH_MAXSIZE 4096
+#endif
+
+#ifndef CONFIG_EXAMPLES_MEMBENCH_TOTAL
+#  define CONFIG_EXAMPLES_MEMBENCH_TOTAL 1048576
+#endif
+
+/* Extra space so that the buffers can be misaligned */
+
+#define MEMBENCH_SLACK 8
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* One operation on 'size' bytes of the source and/or destination buffer */
+
+typedef void (*membench_func_t)(FAR uint8_t *dest, FAR const uint8_t *src,
+                                size_t size);
+
+struct membench_test_s
+{
+  FAR const char *name;
+  membench_func_t func;
+};
+
+/****************************************************************************
+ * Private Function Prototypes
+ ****************************************************************************/
+
+static void membench_memcpy(FAR uint8_t *dest, FAR const uint8_t *src,
+                            size_t size);
+static void membench_memset(FAR uint8_t *dest, FAR const uint8_t *src,
+                            size_t size);
+static void membench_memcmp(FAR uint8_t *dest, FAR const uint8_t *src,
+                            size_t size);
+static void membench_memchr(FAR uint8_t *dest, FAR const uint8_t *src,
+                            size_t size);
+static void membench_strlen(FAR uint8_t *dest, FAR const uint8_t *src,
+                            size_t size);
+static void membench_crc16(FAR uint8_t *dest, FAR const uint8_t *src,
+                           size_t size);
+static void membench_crc32(FAR uint8_t *dest, FAR const uint8_t *src,
+                           size_t size);
+#ifdef CONFIG_LIBC_CRC32C
+static void membench_crc32c(FAR uint8_t *dest, FAR const uint8_t *src,
+                            size_t size);
+#endif
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static const struct membench_test_s g_tests[] =
+{
+  { "memcpy", membench_memcpy },
+  { "memset", membench_memset },
+  { "memcmp", membench_memcmp },
+  { "memchr", membench_memchr },
+  { "strlen", membench_strlen },
+  { "crc16",  membench_crc16  },
+  { "crc32",  membench_crc32  },
+#ifdef CONFIG_LIBC_CRC32C
+  { "crc32c", membench_crc32c },
+#endif
+};
+
+#define NTESTS (sizeof(g_tests) / sizeof(struct membench_test_s))
+
+/* Source and destination offsets from word alignment */
+
+static const uint8_t g_offsets[][2] =
+{
+  { 0, 0 }, { 1, 1 }, { 1, 3 }
+};
+
+#define NOFFSETS (sizeof(g_offsets) / sizeof(g_offsets[0]))
+
+/* Results are accumulated here so that the compiler cannot discard the
+ * calls.
+ */
+
+static volatile uintptr_t g_sink;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static void membench_memcpy(FAR uint8_t *dest, FAR const uint8_t *src,
+                            size_t size)
+{
+  g_sink += (uintptr_t)memcpy(dest, src, size);
+}
+
+static void membench_memset(FAR uint8_t *dest, FAR const uint8_t *src,
+                            size_t size)
+{
+  g_sink += (uintptr_t)memset(dest, 0x5a, size);
+}
+
+static void membench_memcmp(FAR uint8_t *dest, FAR const uint8_t *src,
+                            size_t size)
+{
+  /* The buffers are equal so that all bytes are compared */
+
+  g_sink += memcmp(dest, src, size);
+}
+
+static void membench_memchr(FAR uint8_t *dest, FAR const uint8_t *src,
+                            size_t size)
+{
+  /* The byte is not present so that all bytes are examined */
+
+  g_sink += (uintptr_t)memchr(src, 0xff, size);
+}
+
+static void membench_strlen(FAR uint8_t *dest, FAR const uint8_t *src,
+                            size_t size)
+{
+  g_sink += strlen((FAR const char *)src);
+}
+
+static void membench_crc16(FAR uint8_t *dest, FAR const uint8_t *src,
+                           size_t size)
+{
+  g_sink += crc16(src, size);
+}
+
+static void membench_crc32(FAR uint8_t *dest, FAR const uint8_t *src,
+                           size_t size)
+{
+  g_sink += crc32(src, size);
+}
+
+#ifdef CONFIG_LIBC_CRC32C
+static void membench_crc32c(FAR uint8_t *dest, FAR const uint8_t *src,
+                            size_t size)
+{
+  g_sink += crc32c(src, size);
+}
+#endif
+
+/****************************************************************************
+ * Name: membench_run
+ *
+ * Description:
+ *   Repeat one test until CONFIG_EXAMPLES_MEMBENCH_TOTAL bytes have been
+ *   processed and return the throughput in kilobytes per second.
+ *
+ ****************************************************************************/
+
+static unsigned long membench_run(FAR const struct membench_test_s *test,
+                                  FAR uint8_t *dest, FAR uint8_t *src,
+                                  size_t size)
+{
+  struct timespec start;
+  struct timespec end;
+  uint64_t elapsed;
+  uint64_t nbytes;
+  unsigned long count;
+  unsigned long i;
+
+  /* Set up the buffers:  Equal, non-zero contents without the memchr()
+   * byte, with a string terminator at the end of the source.
+   */
+
+  memset(src, 0x20, size);
+  memset(dest, 0x20, size);
+  src[size - 1] = '\0';
+  dest[size - 1] = '\0';
+
+  count = (CONFIG_EXAMPLES_MEMBENCH_TOTAL + size - 1) / size;
+
+  (void)clock_gettime(CLOCK_REALTIME, &start);
+  for (i = 0; i < count; i++)
+    {
+      test->func(dest, src, size);
+    }
+
+  (void)clock_gettime(CLOCK_REALTIME, &end);
+
+  elapsed = (uint64_t)(end.tv_sec - start.tv_sec) * 1000000000 +
+            (end.tv_nsec - start.tv_nsec);
+  nbytes  = (uint64_t)count * size;
+
+  /* Avoid division by zero with a coarse clock */
+
+  if (elapsed == 0)
+    {
+      return 0;
+    }
+
+  return (unsigned long)((nbytes * 1000000000 / elapsed) / 1024);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * membench_main
+ ****************************************************************************/
+
+int membench_main(int argc, char *argv[])
+{
+  FAR uint8_t *srcbuf;
+  FAR uint8_t *destbuf;
+  unsigned long kbps;
+  size_t size;
+  int test;
+  int off;
+
+  srcbuf  = (FAR uint8_t *)malloc(CONFIG_EXAMPLES_MEMBENCH_MAXSIZE + MEMBENCH_SLACK);
+  destbuf = (FAR uint8_t *)malloc(CONFIG_EXAMPLES_MEMBENCH_MAXSIZE + MEMBENCH_SLACK);
+  if (!srcbuf || !destbuf)
+    {
+      printf("membench: Failed to allocate buffers\n");
+      free(srcbuf);
+      free(destbuf);
+      return 1;
+    }
+
+  printf("membench: Throughput in KB/sec (src/dest offset)\n");
+  printf("%-8s %6s", "", "size");
+  for (off = 0; off < NOFFSETS; off++)
+    {
+      printf("      %d/%d", g_offsets[off][0], g_offsets[off][1]);
+    }
+
+  printf("\n");
+
+  for (test = 0; test < NTESTS; test++)
+    {
+      for (size = 8; size <= CONFIG_EXAMPLES_MEMBENCH_MAXSIZE; size *= 8)
+        {
+          printf("%-8s %6lu", g_tests[test].name, (unsigned long)size);
+          for (off = 0; off < NOFFSETS; off++)
+            {
+              kbps = membench_run(&g_tests[test],
+                                  destbuf + g_offsets[off][1],
+                                  srcbuf + g_offsets[off][0], size);
+              printf(" %9lu", kbps);
+            }
+
+          printf("\n");
+        }
+    }
+
+  free(srcbuf);
+  free(destbuf);
+  return 0;
+}
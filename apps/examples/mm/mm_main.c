@@ -1,7 +1,7 @@
 /****************************************************************************
  * examples/mm/mm_main.c
  *
- *   Copyright (C) 2011 Gregory Nutt. All rights reserved.
+ *   Copyright (C) 2011, 2014 Gregory Nutt. All rights reserved.
  *   Author: Gregory Nutt <gnutt@nuttx.org>
  *
  * Redistribution and use in source and binary forms, with or without
@@ -37,9 +37,13 @@
  * Included Files
  ****************************************************************************/
 
+#include <nuttx/config.h>
+
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 /****************************************************************************
  * Pre-processor Definitions
@@ -64,6 +68,38 @@
 # define SIZEOF_MM_ALLOCNODE   8
 #endif
 
+/* Benchmark configuration */
+
+#ifndef CONFIG_EXAMPLES_MM_NBENCH
+#  define CONFIG_EXAMPLES_MM_NBENCH 100000
+#endif
+
+#ifndef CONFIG_EXAMPLES_MM_NLIVE
+#  define CONFIG_EXAMPLES_MM_NLIVE 64
+#endif
+
+/* Most benchmark allocations are small (up to MMBENCH_SMALL bytes).  One in
+ * MMBENCH_LARGE_RATE is larger (up to MMBENCH_LARGE bytes).
+ */
+
+#define MMBENCH_SMALL      240
+#define MMBENCH_LARGE      2048
+#define MMBENCH_LARGE_RATE 16
+
+/* Latency test configuration */
+
+#ifndef CONFIG_EXAMPLES_MM_NLATENCY
+#  define CONFIG_EXAMPLES_MM_NLATENCY 20000
+#endif
+
+#ifndef CONFIG_EXAMPLES_MM_LATLIVE
+#  define CONFIG_EXAMPLES_MM_LATLIVE 256
+#endif
+
+/* Latency test allocations are of random sizes up to MMLAT_MAXSIZE bytes */
+
+#define MMLAT_MAXSIZE      4096
+
 /****************************************************************************
  * Private Data
  ****************************************************************************/
@@ -118,6 +154,14 @@ static const int alignment[NTEST_ALLOCS/2] =
 static void        *allocs[NTEST_ALLOCS];
 static struct       mallinfo alloc_info;
 
+#ifdef CONFIG_EXAMPLES_MM_BENCHMARK
+static void        *bench_allocs[CONFIG_EXAMPLES_MM_NLIVE];
+#endif
+
+#ifdef CONFIG_EXAMPLES_MM_LATENCY
+static void        *lat_allocs[CONFIG_EXAMPLES_MM_LATLIVE];
+#endif
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
@@ -262,6 +306,173 @@ static void do_frees(void **mem, const int *size, const int *seq, int n)
     }
 }
 
+#ifdef CONFIG_EXAMPLES_MM_BENCHMARK
+static void mm_showfragmentation(const char *when)
+{
+  int frag = 0;
+
+  alloc_info = mallinfo();
+
+  /* Fragmentation is the percentage of the free memory that is not in the
+   * largest free chunk.
+   */
+
+  if (alloc_info.fordblks > 0)
+    {
+      frag = (int)(((int64_t)(alloc_info.fordblks - alloc_info.mxordblk) *
+                    100) / alloc_info.fordblks);
+    }
+
+  printf("mm_benchmark: %-6s free=%d chunks=%d largest=%d fragmentation=%d%%\n",
+         when, alloc_info.fordblks, alloc_info.ordblks, alloc_info.mxordblk,
+         frag);
+}
+
+static size_t mm_benchsize(void)
+{
+  int r = rand();
+
+  if ((r % MMBENCH_LARGE_RATE) == 0)
+    {
+      return MMBENCH_SMALL + (r / MMBENCH_LARGE_RATE) %
+             (MMBENCH_LARGE - MMBENCH_SMALL);
+    }
+
+  return 1 + (r / MMBENCH_LARGE_RATE) % MMBENCH_SMALL;
+}
+
+static void mm_benchmark(void)
+{
+  struct timespec start;
+  struct timespec end;
+  uint32_t msec;
+  int nfailed = 0;
+  int i;
+  int j;
+
+  srand(1);
+  mm_showfragmentation("before");
+
+  (void)clock_gettime(CLOCK_REALTIME, &start);
+  for (i = 0; i < CONFIG_EXAMPLES_MM_NBENCH; i++)
+    {
+      /* Replace one of the live allocations, chosen at random */
+
+      j = rand() % CONFIG_EXAMPLES_MM_NLIVE;
+      free(bench_allocs[j]);
+
+      bench_allocs[j] = malloc(mm_benchsize());
+      if (bench_allocs[j] == NULL)
+        {
+          nfailed++;
+        }
+      else
+        {
+          *(uint8_t *)bench_allocs[j] = (uint8_t)i;
+        }
+    }
+
+  (void)clock_gettime(CLOCK_REALTIME, &end);
+
+  for (j = 0; j < CONFIG_EXAMPLES_MM_NLIVE; j++)
+    {
+      free(bench_allocs[j]);
+      bench_allocs[j] = NULL;
+    }
+
+  msec = (uint32_t)((end.tv_sec - start.tv_sec) * 1000 +
+                    (end.tv_nsec - start.tv_nsec) / 1000000);
+
+  printf("mm_benchmark: %d allocations (%d failed) in %lu msec",
+         CONFIG_EXAMPLES_MM_NBENCH, nfailed, (unsigned long)msec);
+  if (msec > 0)
+    {
+      printf(", %lu allocations/sec",
+             (unsigned long)(((uint64_t)CONFIG_EXAMPLES_MM_NBENCH * 1000) /
+                             msec));
+    }
+
+  printf("\n");
+  mm_showfragmentation("after");
+}
+#endif
+
+#ifdef CONFIG_EXAMPLES_MM_LATENCY
+static uint32_t mm_elapsed(FAR const struct timespec *start,
+                           FAR const struct timespec *end)
+{
+  return (uint32_t)((end->tv_sec - start->tv_sec) * 1000000000 +
+                    (end->tv_nsec - start->tv_nsec));
+}
+
+static void mm_latency(void)
+{
+  struct timespec start;
+  struct timespec end;
+  uint64_t malloc_total = 0;
+  uint64_t free_total = 0;
+  uint32_t malloc_max = 0;
+  uint32_t free_max = 0;
+  uint32_t elapsed;
+  int nfailed = 0;
+  int i;
+  int j;
+
+  srand(2);
+
+  for (i = 0; i < CONFIG_EXAMPLES_MM_NLATENCY; i++)
+    {
+      /* Replace one of the live allocations, chosen at random, timing the
+       * free() and the malloc() separately.
+       */
+
+      j = rand() % CONFIG_EXAMPLES_MM_LATLIVE;
+
+      (void)clock_gettime(CLOCK_REALTIME, &start);
+      free(lat_allocs[j]);
+      (void)clock_gettime(CLOCK_REALTIME, &end);
+
+      elapsed     = mm_elapsed(&start, &end);
+      free_total += elapsed;
+      if (elapsed > free_max)
+        {
+          free_max = elapsed;
+        }
+
+      (void)clock_gettime(CLOCK_REALTIME, &start);
+      lat_allocs[j] = malloc(1 + rand() % MMLAT_MAXSIZE);
+      (void)clock_gettime(CLOCK_REALTIME, &end);
+
+      elapsed       = mm_elapsed(&start, &end);
+      malloc_total += elapsed;
+      if (elapsed > malloc_max)
+        {
+          malloc_max = elapsed;
+        }
+
+      if (lat_allocs[j] == NULL)
+        {
+          nfailed++;
+        }
+    }
+
+  for (j = 0; j < CONFIG_EXAMPLES_MM_LATLIVE; j++)
+    {
+      free(lat_allocs[j]);
+      lat_allocs[j] = NULL;
+    }
+
+  printf("mm_latency: %d allocations (%d failed)\n",
+         CONFIG_EXAMPLES_MM_NLATENCY, nfailed);
+  printf("mm_latency: malloc average %lu nsec, worst case %lu nsec\n",
+         (unsigned long)(malloc_total / CONFIG_EXAMPLES_MM_NLATENCY),
+         (unsigned long)malloc_max);
+  printf("mm_latency: free   average %lu nsec, worst case %lu nsec\n",
+         (unsigned long)(free_total / CONFIG_EXAMPLES_MM_NLATENCY),
+         (unsigned long)free_max);
+}
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -295,6 +506,18 @@ int mm_main(int argc, char *argv[])
 
   do_frees(allocs, alloc_sizes, random1, NTEST_ALLOCS);
 
+#ifdef CONFIG_EXAMPLES_MM_BENCHMARK
+  /* Measure the speed of small, short-lived allocations */
+
+  mm_benchmark();
+#endif
+
+#ifdef CONFIG_EXAMPLES_MM_LATENCY
+  /* Measure the worst case time to allocate and free memory */
+
+  mm_latency();
+#endif
+
   printf("TEST COMPLETE\n");
   return 0;
 }
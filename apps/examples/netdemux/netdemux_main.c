@@ -0,0 +1,413 @@
+/****************************************************************************
+ * examples/netdemux/netdemux_main.c
+ *
+ *   Copyright (C) 2014 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/socket.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <errno.h>
+
+#include <netinet/in.h>
+
+#include <nuttx/net/uip/uip.h>
+#include <nuttx/net/uip/uip-arch.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifndef CONFIG_EXAMPLES_NETDEMUX_NCONNS
+#  define CONFIG_EXAMPLES_NETDEMUX_NCONNS 100
+#endif
+
+/* The TCP listener port, the first of the bound UDP ports, and the first
+ * of the remote ports.
+ */
+
+#define NETDEMUX_TCPPORT  5471
+#define NETDEMUX_UDPPORT  6000
+#define NETDEMUX_RPORT    20000
+
+/* The injected packets travel between two TEST-NET-1 addresses */
+
+#define NETDEMUX_LOCALIP  0xc0000202 /* 192.0.2.2 */
+#define NETDEMUX_REMOTEIP 0xc0000201 /* 192.0.2.1 */
+
+/* The initial sequence number of every injected connection */
+
+#define NETDEMUX_ISN      0x00001000
+
+/* The size of the payload of each UDP datagram */
+
+#define NETDEMUX_UDPSIZE  8
+
+#define IPBUF  ((struct uip_ip_hdr *)&g_dev.d_buf[UIP_LLH_LEN])
+#define TCPBUF ((struct uip_tcpip_hdr *)&g_dev.d_buf[UIP_LLH_LEN])
+#define UDPBUF ((struct uip_udpip_hdr *)&g_dev.d_buf[UIP_LLH_LEN])
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct netdemux_stats_s
+{
+  uint64_t total;   /* Total time in uip_input() (nsec) */
+  uint32_t max;     /* Worst case time in uip_input() (nsec) */
+  int npackets;     /* Number of packets input */
+  int nreplies;     /* Number of packets that produced a reply */
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* A dummy network device that is not registered.  Packets are injected
+ * directly into uip_input() through it and any replies are discarded.
+ */
+
+static struct uip_driver_s g_dev;
+#ifdef CONFIG_NET_MULTIBUFFER
+static uint16_t g_pktbuf[(CONFIG_NET_BUFSIZE + 3) / 2];
+#endif
+
+static int g_udpsd[CONFIG_EXAMPLES_NETDEMUX_NCONNS];
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: netdemux_ipheader
+ *
+ * Description:
+ *   Complete the IPv4 header of the packet in the device buffer.
+ *
+ ****************************************************************************/
+
+static void netdemux_ipheader(uint8_t proto, uint16_t iplen)
+{
+  FAR struct uip_ip_hdr *pbuf = IPBUF;
+  in_addr_t addr;
+
+  pbuf->vhl         = 0x45;
+  pbuf->tos         = 0;
+  pbuf->len[0]      = (iplen >> 8);
+  pbuf->len[1]      = (iplen & 0xff);
+  pbuf->ipid[0]     = 0;
+  pbuf->ipid[1]     = 0;
+  pbuf->ipoffset[0] = 0;
+  pbuf->ipoffset[1] = 0;
+  pbuf->ttl         = UIP_TTL;
+  pbuf->proto       = proto;
+
+  addr = HTONL(NETDEMUX_REMOTEIP);
+  memcpy(pbuf->srcipaddr, &addr, sizeof(in_addr_t));
+  addr = HTONL(NETDEMUX_LOCALIP);
+  memcpy(pbuf->destipaddr, &addr, sizeof(in_addr_t));
+
+  pbuf->ipchksum    = 0;
+  pbuf->ipchksum    = ~(uip_ipchksum(&g_dev));
+
+  g_dev.d_len       = iplen;
+}
+
+/****************************************************************************
+ * Name: netdemux_tcpsegment
+ *
+ * Description:
+ *   Build a TCP segment from the remote port to the listener port.
+ *
+ ****************************************************************************/
+
+static void netdemux_tcpsegment(uint16_t rport, uint8_t flags)
+{
+  FAR struct uip_tcpip_hdr *pbuf = TCPBUF;
+
+  memset(pbuf, 0, UIP_IPTCPH_LEN);
+
+  pbuf->srcport   = HTONS(rport);
+  pbuf->destport  = HTONS(NETDEMUX_TCPPORT);
+  pbuf->seqno[0]  = (NETDEMUX_ISN >> 24) & 0xff;
+  pbuf->seqno[1]  = (NETDEMUX_ISN >> 16) & 0xff;
+  pbuf->seqno[2]  = (NETDEMUX_ISN >> 8) & 0xff;
+  pbuf->seqno[3]  = NETDEMUX_ISN & 0xff;
+  pbuf->tcpoffset = (UIP_TCPH_LEN / 4) << 4;
+  pbuf->flags     = flags;
+  pbuf->wnd[0]    = (CONFIG_NET_RECEIVE_WINDOW >> 8);
+  pbuf->wnd[1]    = (CONFIG_NET_RECEIVE_WINDOW & 0xff);
+
+  netdemux_ipheader(UIP_PROTO_TCP, UIP_IPTCPH_LEN);
+
+  pbuf->tcpchksum = 0;
+  pbuf->tcpchksum = ~(uip_tcpchksum(&g_dev));
+}
+
+/****************************************************************************
+ * Name: netdemux_udpdatagram
+ *
+ * Description:
+ *   Build a UDP datagram from the remote host to a local port.
+ *
+ ****************************************************************************/
+
+static void netdemux_udpdatagram(uint16_t lport)
+{
+  FAR struct uip_udpip_hdr *pbuf = UDPBUF;
+
+  memset(pbuf, 0, UIP_IPUDPH_LEN + NETDEMUX_UDPSIZE);
+
+  pbuf->srcport   = HTONS(NETDEMUX_RPORT);
+  pbuf->destport  = HTONS(lport);
+  pbuf->udplen    = HTONS(UIP_UDPH_LEN + NETDEMUX_UDPSIZE);
+  pbuf->udpchksum = 0; /* No checksum */
+
+  netdemux_ipheader(UIP_PROTO_UDP, UIP_IPUDPH_LEN + NETDEMUX_UDPSIZE);
+}
+
+/****************************************************************************
+ * Name: netdemux_input
+ *
+ * Description:
+ *   Pass the packet in the device buffer to uip_input() and time it.
+ *
+ ****************************************************************************/
+
+static void netdemux_input(FAR struct netdemux_stats_s *stats)
+{
+  struct timespec start;
+  struct timespec end;
+  uip_lock_t flags;
+  uint32_t elapsed;
+
+  flags = uip_lock();
+  (void)clock_gettime(CLOCK_REALTIME, &start);
+  (void)uip_input(&g_dev);
+  (void)clock_gettime(CLOCK_REALTIME, &end);
+  uip_unlock(flags);
+
+  elapsed = (uint32_t)((end.tv_sec - start.tv_sec) * 1000000000 +
+                       (end.tv_nsec - start.tv_nsec));
+
+  stats->total += elapsed;
+  if (elapsed > stats->max)
+    {
+      stats->max = elapsed;
+    }
+
+  stats->npackets++;
+  if (g_dev.d_len > 0)
+    {
+      stats->nreplies++;
+    }
+}
+
+/****************************************************************************
+ * Name: netdemux_report
+ ****************************************************************************/
+
+static void netdemux_report(FAR const char *what,
+                            FAR const struct netdemux_stats_s *stats)
+{
+  printf("netdemux: %s: %d packets (%d replies)\n",
+         what, stats->npackets, stats->nreplies);
+
+  if (stats->npackets > 0)
+    {
+      printf("netdemux: %s: average %lu nsec, worst case %lu nsec\n", what,
+             (unsigned long)(stats->total / stats->npackets),
+             (unsigned long)stats->max);
+    }
+}
+
+/****************************************************************************
+ * Name: netdemux_tcp
+ *
+ * Description:
+ *   Create CONFIG_EXAMPLES_NETDEMUX_NCONNS connections in the backlog of a
+ *   listening socket by injecting a SYN from each of as many remote ports.
+ *   Each SYN must first fail to match any existing connection.  Then
+ *   inject the same SYNs again.  This time each matches one of the
+ *   connections.
+ *
+ ****************************************************************************/
+
+static void netdemux_tcp(void)
+{
+  struct netdemux_stats_s stats;
+  struct sockaddr_in addr;
+  int sd;
+  int i;
+
+  sd = socket(PF_INET, SOCK_STREAM, 0);
+  if (sd < 0)
+    {
+      printf("netdemux: TCP socket failed: %d\n", errno);
+      return;
+    }
+
+  addr.sin_family      = AF_INET;
+  addr.sin_port        = HTONS(NETDEMUX_TCPPORT);
+  addr.sin_addr.s_addr = INADDR_ANY;
+
+  if (bind(sd, (struct sockaddr*)&addr, sizeof(struct sockaddr_in)) < 0)
+    {
+      printf("netdemux: TCP bind failed: %d\n", errno);
+      goto errout;
+    }
+
+  if (listen(sd, CONFIG_EXAMPLES_NETDEMUX_NCONNS) < 0)
+    {
+      printf("netdemux: listen failed: %d\n", errno);
+      goto errout;
+    }
+
+  /* SYNs for new connections */
+
+  memset(&stats, 0, sizeof(struct netdemux_stats_s));
+  for (i = 0; i < CONFIG_EXAMPLES_NETDEMUX_NCONNS; i++)
+    {
+      netdemux_tcpsegment(NETDEMUX_RPORT + i, TCP_SYN);
+      netdemux_input(&stats);
+    }
+
+  netdemux_report("TCP new", &stats);
+
+  /* Repeated SYNs for the connections in the SYN_RCVD state */
+
+  memset(&stats, 0, sizeof(struct netdemux_stats_s));
+  for (i = 0; i < CONFIG_EXAMPLES_NETDEMUX_NCONNS; i++)
+    {
+      netdemux_tcpsegment(NETDEMUX_RPORT + i, TCP_SYN);
+      netdemux_input(&stats);
+    }
+
+  netdemux_report("TCP active", &stats);
+
+  /* Closing the listener also frees all of the connections in its backlog */
+
+errout:
+  close(sd);
+}
+
+/****************************************************************************
+ * Name: netdemux_udp
+ *
+ * Description:
+ *   Bind CONFIG_EXAMPLES_NETDEMUX_NCONNS UDP sockets to consecutive ports
+ *   and then inject one datagram to each port.
+ *
+ ****************************************************************************/
+
+static void netdemux_udp(void)
+{
+  struct netdemux_stats_s stats;
+  struct sockaddr_in addr;
+  int nsockets;
+  int i;
+
+  for (nsockets = 0;
+       nsockets < CONFIG_EXAMPLES_NETDEMUX_NCONNS;
+       nsockets++)
+    {
+      g_udpsd[nsockets] = socket(PF_INET, SOCK_DGRAM, 0);
+      if (g_udpsd[nsockets] < 0)
+        {
+          printf("netdemux: UDP socket %d failed: %d\n", nsockets, errno);
+          break;
+        }
+
+      addr.sin_family      = AF_INET;
+      addr.sin_port        = HTONS(NETDEMUX_UDPPORT + nsockets);
+      addr.sin_addr.s_addr = INADDR_ANY;
+
+      if (bind(g_udpsd[nsockets], (struct sockaddr*)&addr,
+               sizeof(struct sockaddr_in)) < 0)
+        {
+          printf("netdemux: UDP bind %d failed: %d\n", nsockets, errno);
+          close(g_udpsd[nsockets]);
+          break;
+        }
+    }
+
+  memset(&stats, 0, sizeof(struct netdemux_stats_s));
+  for (i = 0; i < nsockets; i++)
+    {
+      netdemux_udpdatagram(NETDEMUX_UDPPORT + i);
+      netdemux_input(&stats);
+    }
+
+  netdemux_report("UDP", &stats);
+
+  for (i = 0; i < nsockets; i++)
+    {
+      close(g_udpsd[i]);
+    }
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * netdemux_main
+ ****************************************************************************/
+
+int netdemux_main(int argc, char *argv[])
+{
+  /* Initialize the dummy device */
+
+  memset(&g_dev, 0, sizeof(struct uip_driver_s));
+#ifdef CONFIG_NET_MULTIBUFFER
+  g_dev.d_buf     = (FAR uint8_t *)g_pktbuf;
+#endif
+  g_dev.d_ipaddr  = HTONL(NETDEMUX_LOCALIP);
+  g_dev.d_netmask = HTONL(0xffffff00);
+
+  printf("netdemux: %d connections\n", CONFIG_EXAMPLES_NETDEMUX_NCONNS);
+
+  netdemux_tcp();
+  netdemux_udp();
+
+  printf("netdemux: Done\n");
+  return 0;
+}
@@ -173,6 +173,30 @@ void barrier_test(void);
 
 void priority_inheritance(void);
 
+/* wdogbench.c **************************************************************/
+
+#ifdef CONFIG_EXAMPLES_OSTEST_WDOGBENCH
+void wdog_benchmark(void);
+#endif
+
+/* sembench.c ***************************************************************/
+
+#ifdef CONFIG_EXAMPLES_OSTEST_SEMBENCH
+void sem_benchmark(void);
+#endif
+
+/* smpbench.c ***************************************************************/
+
+#ifdef CONFIG_EXAMPLES_OSTEST_SMPBENCH
+void smp_benchmark(void);
+#endif
+
+/* switchbench.c ************************************************************/
+
+#ifdef CONFIG_EXAMPLES_OSTEST_SWITCHBENCH
+void switch_benchmark(void);
+#endif
+
 /* vfork.c ******************************************************************/
 
 #if defined(CONFIG_ARCH_HAVE_VFORK) && defined(CONFIG_SCHED_WAITPID) && \
@@ -427,6 +427,38 @@ static int user_main(int argc, char *argv[])
       check_test_memory_usage();
 #endif
 
+#ifdef CONFIG_EXAMPLES_OSTEST_WDOGBENCH
+      /* Measure the cost of watchdog timer queue operations */
+
+      printf("\nuser_main: watchdog timer benchmark\n");
+      wdog_benchmark();
+      check_test_memory_usage();
+#endif
+
+#ifdef CONFIG_EXAMPLES_OSTEST_SEMBENCH
+      /* Measure the cost of waking one of many waiting threads */
+
+      printf("\nuser_main: semaphore wake-up benchmark\n");
+      sem_benchmark();
+      check_test_memory_usage();
+#endif
+
+#ifdef CONFIG_EXAMPLES_OSTEST_SWITCHBENCH
+      /* Measure the context switch time with many ready-to-run threads */
+
+      printf("\nuser_main: context switch benchmark\n");
+      switch_benchmark();
+      check_test_memory_usage();
+#endif
+
+#ifdef CONFIG_EXAMPLES_OSTEST_SMPBENCH
+      /* Measure how CPU bound work scales with the number of CPUs */
+
+      printf("\nuser_main: SMP benchmark\n");
+      smp_benchmark();
+      check_test_memory_usage();
+#endif
+
 #if !defined(CONFIG_DISABLE_PTHREAD) && CONFIG_RR_INTERVAL > 0
       /* Verify round robin scheduling */
 
@@ -0,0 +1,227 @@
+/****************************************************************************
+ * examples/ostest/sembench.c
+ *
+ *   Copyright (C) 2014 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+#include <semaphore.h>
+
+#include "ostest.h"
+
+#ifdef CONFIG_EXAMPLES_OSTEST_SEMBENCH
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifndef CONFIG_EXAMPLES_OSTEST_SEMBENCH_NTHREADS
+#  define CONFIG_EXAMPLES_OSTEST_SEMBENCH_NTHREADS 200
+#endif
+
+#ifndef CONFIG_EXAMPLES_OSTEST_SEMBENCH_NROUNDS
+#  define CONFIG_EXAMPLES_OSTEST_SEMBENCH_NROUNDS 10
+#endif
+
+#define NTHREADS CONFIG_EXAMPLES_OSTEST_SEMBENCH_NTHREADS
+#define NROUNDS  CONFIG_EXAMPLES_OSTEST_SEMBENCH_NROUNDS
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static sem_t g_sembench_sems[NTHREADS];
+static volatile bool g_sembench_stop;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static FAR void *sembench_thread(FAR void *parameter)
+{
+  FAR sem_t *sem = &g_sembench_sems[(intptr_t)parameter];
+
+  /* Block on our own semaphore until told to stop */
+
+  while (!g_sembench_stop)
+    {
+      while (sem_wait(sem) < 0);
+    }
+
+  return NULL;
+}
+
+/* Wait until the first 'nthreads' threads are blocked on their
+ * semaphores.  The threads run at a lower priority than the caller, so
+ * this requires that the caller sleep.
+ */
+
+static void sembench_waitblocked(int nthreads)
+{
+  int value;
+  int i;
+
+  for (i = 0; i < nthreads; i++)
+    {
+      while (sem_getvalue(&g_sembench_sems[i], &value) == OK && value >= 0)
+        {
+          usleep(10*1000);
+        }
+    }
+}
+
+static uint32_t sembench_elapsed(FAR const struct timespec *start)
+{
+  struct timespec now;
+
+  (void)clock_gettime(CLOCK_REALTIME, &now);
+  return (uint32_t)((now.tv_sec - start->tv_sec) * 1000000 +
+                    (now.tv_nsec - start->tv_nsec) / 1000);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: sem_benchmark
+ *
+ * Description:
+ *   Block CONFIG_EXAMPLES_OSTEST_SEMBENCH_NTHREADS threads, each on its own
+ *   semaphore, and report the time spent in sem_post() to wake them.  The
+ *   threads are woken in the reverse of the order in which they blocked.
+ *   The threads have lower priority than this thread so that sem_post()
+ *   does not cause a context switch and only the cost of finding the
+ *   waiting thread (with interrupts disabled) is measured.
+ *
+ ****************************************************************************/
+
+void sem_benchmark(void)
+{
+  pthread_t threads[NTHREADS];
+  pthread_attr_t attr;
+  struct sched_param sparam;
+  struct timespec start;
+  uint32_t usec = 0;
+  int nthreads;
+  int status;
+  int round;
+  int i;
+
+  status = sched_getparam(getpid(), &sparam);
+  if (status != 0)
+    {
+      printf("sem_benchmark: ERROR sched_getparam failed\n");
+      sparam.sched_priority = PTHREAD_DEFAULT_PRIORITY;
+    }
+
+  sparam.sched_priority--;
+  g_sembench_stop = false;
+
+  /* Start the threads */
+
+  for (nthreads = 0; nthreads < NTHREADS; nthreads++)
+    {
+      sem_init(&g_sembench_sems[nthreads], 0, 0);
+
+      (void)pthread_attr_init(&attr);
+      (void)pthread_attr_setschedparam(&attr, &sparam);
+      (void)pthread_attr_setstacksize(&attr, PTHREAD_STACK_MIN);
+
+      status = pthread_create(&threads[nthreads], &attr, sembench_thread,
+                              (pthread_addr_t)((intptr_t)nthreads));
+      if (status != 0)
+        {
+          printf("sem_benchmark: Only %d threads could be created "
+                 "(see CONFIG_MAX_TASKS)\n", nthreads);
+          sem_destroy(&g_sembench_sems[nthreads]);
+          break;
+        }
+    }
+
+  if (nthreads < 1)
+    {
+      printf("sem_benchmark: ERROR no threads\n");
+      return;
+    }
+
+  /* Wake all of the threads, last blocked first, and wait for them to block
+   * again.
+   */
+
+  sembench_waitblocked(nthreads);
+  for (round = 0; round < NROUNDS; round++)
+    {
+      (void)clock_gettime(CLOCK_REALTIME, &start);
+      for (i = nthreads - 1; i >= 0; i--)
+        {
+          sem_post(&g_sembench_sems[i]);
+        }
+
+      usec += sembench_elapsed(&start);
+      sembench_waitblocked(nthreads);
+    }
+
+  printf("sem_benchmark: %d waiting threads %d sem_post %8lu usec "
+         "%6lu nsec/post\n", nthreads, nthreads * NROUNDS,
+         (unsigned long)usec,
+         (unsigned long)(((uint64_t)usec * 1000) / (nthreads * NROUNDS)));
+
+  /* Stop the threads */
+
+  g_sembench_stop = true;
+  for (i = 0; i < nthreads; i++)
+    {
+      sem_post(&g_sembench_sems[i]);
+    }
+
+  for (i = 0; i < nthreads; i++)
+    {
+      (void)pthread_join(threads[i], NULL);
+      sem_destroy(&g_sembench_sems[i]);
+    }
+}
+
+#endif /* CONFIG_EXAMPLES_OSTEST_SEMBENCH */
@@ -0,0 +1,191 @@
+/****************************************************************************
+ * examples/ostest/smpbench.c
+ *
+ *   Copyright (C) 2014 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+
+#include "ostest.h"
+
+#ifdef CONFIG_EXAMPLES_OSTEST_SMPBENCH
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifndef CONFIG_EXAMPLES_OSTEST_SMPBENCH_NLOOPS
+#  define CONFIG_EXAMPLES_OSTEST_SMPBENCH_NLOOPS 10000000
+#endif
+
+#define NLOOPS CONFIG_EXAMPLES_OSTEST_SMPBENCH_NLOOPS
+
+/* CPU 0 is left to the IDLE task:  On the simulator, the system timer (and
+ * so the time measurement) only advances when CPU 0 is idle.
+ */
+
+#define NWORKERS (CONFIG_SMP_NCPUS - 1)
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static FAR void *smpbench_thread(FAR void *parameter)
+{
+  volatile uint32_t sum = 0;
+  uint32_t i;
+
+  /* Just burn CPU time.  There is no shared data and no system call. */
+
+  for (i = 0; i < NLOOPS; i++)
+    {
+      sum += i;
+    }
+
+  return NULL;
+}
+
+static uint32_t smpbench_elapsed(FAR const struct timespec *start)
+{
+  struct timespec now;
+
+  (void)clock_gettime(CLOCK_REALTIME, &now);
+  return (uint32_t)((now.tv_sec - start->tv_sec) * 1000 +
+                    (now.tv_nsec - start->tv_nsec) / 1000000);
+}
+
+/* Run 'nworkers' CPU bound threads, each pinned to a CPU of its own, and
+ * report how much work is done per second.
+ */
+
+static uint32_t smpbench_run(int nworkers, uint32_t base)
+{
+  pthread_t threads[NWORKERS];
+  pthread_attr_t attr;
+  struct sched_param sparam;
+  struct timespec start;
+  cpu_set_t cpuset;
+  uint32_t msec;
+  uint32_t rate;
+  int status;
+  int i;
+
+  status = sched_getparam(getpid(), &sparam);
+  if (status != 0)
+    {
+      printf("smp_benchmark: ERROR sched_getparam failed\n");
+      sparam.sched_priority = PTHREAD_DEFAULT_PRIORITY;
+    }
+
+  (void)clock_gettime(CLOCK_REALTIME, &start);
+  for (i = 0; i < nworkers; i++)
+    {
+      (void)pthread_attr_init(&attr);
+      (void)pthread_attr_setschedparam(&attr, &sparam);
+
+      CPU_ZERO(&cpuset);
+      CPU_SET(i + 1, &cpuset);
+      (void)pthread_attr_setaffinity_np(&attr, sizeof(cpu_set_t), &cpuset);
+
+      status = pthread_create(&threads[i], &attr, smpbench_thread, NULL);
+      if (status != 0)
+        {
+          printf("smp_benchmark: ERROR pthread_create failed: %d\n", status);
+          nworkers = i;
+          break;
+        }
+    }
+
+  for (i = 0; i < nworkers; i++)
+    {
+      (void)pthread_join(threads[i], NULL);
+    }
+
+  msec = smpbench_elapsed(&start);
+  if (msec == 0)
+    {
+      msec = 1;
+    }
+
+  /* Thousands of loops per second */
+
+  rate = (uint32_t)(((uint64_t)nworkers * NLOOPS) / msec);
+
+  printf("smp_benchmark: %2d CPUs %8lu msec %8lu Kloops/sec "
+         "speedup %lu.%02lu\n",
+         nworkers, (unsigned long)msec, (unsigned long)rate,
+         (unsigned long)(base ? rate / base : 1),
+         (unsigned long)(base ? ((rate % base) * 100) / base : 0));
+
+  return rate;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: smp_benchmark
+ *
+ * Description:
+ *   Measure how the throughput of independent, CPU bound threads scales
+ *   with the number of CPUs:  1 through (CONFIG_SMP_NCPUS-1) threads are
+ *   run, each pinned to a different CPU with pthread_attr_setaffinity_np().
+ *
+ ****************************************************************************/
+
+void smp_benchmark(void)
+{
+  uint32_t base;
+  int nworkers;
+
+  printf("smp_benchmark: Running on CPU%d\n", sched_getcpu());
+
+  base = smpbench_run(1, 0);
+  for (nworkers = 2; nworkers <= NWORKERS; nworkers++)
+    {
+      (void)smpbench_run(nworkers, base);
+    }
+}
+
+#endif /* CONFIG_EXAMPLES_OSTEST_SMPBENCH */
@@ -0,0 +1,201 @@
+/****************************************************************************
+ * examples/ostest/switchbench.c
+ *
+ *   Copyright (C) 2014 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+
+#include "ostest.h"
+
+#ifdef CONFIG_EXAMPLES_OSTEST_SWITCHBENCH
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifndef CONFIG_EXAMPLES_OSTEST_SWITCHBENCH_NTHREADS
+#  define CONFIG_EXAMPLES_OSTEST_SWITCHBENCH_NTHREADS 64
+#endif
+
+#ifndef CONFIG_EXAMPLES_OSTEST_SWITCHBENCH_NROUNDS
+#  define CONFIG_EXAMPLES_OSTEST_SWITCHBENCH_NROUNDS 1000
+#endif
+
+#define NTHREADS CONFIG_EXAMPLES_OSTEST_SWITCHBENCH_NTHREADS
+#define NROUNDS  CONFIG_EXAMPLES_OSTEST_SWITCHBENCH_NROUNDS
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static volatile bool g_switchbench_stop;
+static volatile uint32_t g_switchbench_nyields;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static FAR void *switchbench_thread(FAR void *parameter)
+{
+  /* Give up the CPU to the next thread of the same priority until told to
+   * stop.
+   */
+
+  while (!g_switchbench_stop)
+    {
+      g_switchbench_nyields++;
+      sched_yield();
+    }
+
+  return NULL;
+}
+
+static uint32_t switchbench_elapsed(FAR const struct timespec *start)
+{
+  struct timespec now;
+
+  (void)clock_gettime(CLOCK_REALTIME, &now);
+  return (uint32_t)((now.tv_sec - start->tv_sec) * 1000000 +
+                    (now.tv_nsec - start->tv_nsec) / 1000);
+}
+
+/* Start 'nthreads' threads at our priority and measure the time for them
+ * and us to pass the CPU around by sched_yield().  Every sched_yield()
+ * moves the running task behind all of the other ready-to-run tasks of
+ * the same priority and switches to the next one.
+ */
+
+static void switchbench_run(int nthreads)
+{
+  pthread_t threads[NTHREADS];
+  pthread_attr_t attr;
+  struct sched_param sparam;
+  struct timespec start;
+  uint32_t nswitches;
+  uint32_t usec;
+  int status;
+  int round;
+  int i;
+
+  status = sched_getparam(getpid(), &sparam);
+  if (status != 0)
+    {
+      printf("switch_benchmark: ERROR sched_getparam failed\n");
+      sparam.sched_priority = PTHREAD_DEFAULT_PRIORITY;
+    }
+
+  g_switchbench_stop = false;
+
+  /* Start the threads.  They will not run until we give up the CPU. */
+
+  for (i = 0; i < nthreads; i++)
+    {
+      (void)pthread_attr_init(&attr);
+      (void)pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+      (void)pthread_attr_setschedparam(&attr, &sparam);
+      (void)pthread_attr_setstacksize(&attr, PTHREAD_STACK_MIN);
+
+      status = pthread_create(&threads[i], &attr, switchbench_thread, NULL);
+      if (status != 0)
+        {
+          printf("switch_benchmark: Only %d threads could be created "
+                 "(see CONFIG_MAX_TASKS)\n", i);
+          nthreads = i;
+          break;
+        }
+    }
+
+  /* Let every thread run once before starting the measurement */
+
+  sched_yield();
+
+  g_switchbench_nyields = 0;
+  (void)clock_gettime(CLOCK_REALTIME, &start);
+  for (round = 0; round < NROUNDS; round++)
+    {
+      sched_yield();
+    }
+
+  usec      = switchbench_elapsed(&start);
+  nswitches = g_switchbench_nyields + NROUNDS;
+
+  printf("switch_benchmark: %3d ready threads %7lu switches %8lu usec "
+         "%6lu nsec/switch\n", nthreads, (unsigned long)nswitches,
+         (unsigned long)usec,
+         (unsigned long)(((uint64_t)usec * 1000) / nswitches));
+
+  /* Stop the threads */
+
+  g_switchbench_stop = true;
+  for (i = 0; i < nthreads; i++)
+    {
+      (void)pthread_join(threads[i], NULL);
+    }
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: switch_benchmark
+ *
+ * Description:
+ *   Measure the context switch time with one and with
+ *   CONFIG_EXAMPLES_OSTEST_SWITCHBENCH_NTHREADS other ready-to-run threads
+ *   at the same priority.  Without CONFIG_SCHED_READYBITMAP, the time to
+ *   re-queue the yielding thread grows with the number of ready-to-run
+ *   threads.
+ *
+ ****************************************************************************/
+
+void switch_benchmark(void)
+{
+  switchbench_run(1);
+  switchbench_run(NTHREADS);
+}
+
+#endif /* CONFIG_EXAMPLES_OSTEST_SWITCHBENCH */
@@ -0,0 +1,227 @@
+/****************************************************************************
+ * examples/ostest/wdogbench.c
+ *
+ *   Copyright (C) 2014 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <wdog.h>
+
+#include <nuttx/clock.h>
+
+#include "ostest.h"
+
+#ifdef CONFIG_EXAMPLES_OSTEST_WDOGBENCH
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifndef CONFIG_EXAMPLES_OSTEST_WDOGBENCH_NWDOGS
+#  define CONFIG_EXAMPLES_OSTEST_WDOGBENCH_NWDOGS 10000
+#endif
+
+/* A few watchdogs are left in the pool for use by the OS while the
+ * benchmark runs.
+ */
+
+#define WDBENCH_RESERVE   4
+
+/* Watchdog delays are chosen at random in this range so that none of the
+ * watchdogs expire while the benchmark is running.
+ */
+
+#define WDBENCH_MINDELAY  SEC2TICK(60)
+#define WDBENCH_RANGE     SEC2TICK(60)
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static volatile int g_wdbench_nexpired;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static void wdbench_expiration(int argc, uint32_t arg1)
+{
+  g_wdbench_nexpired++;
+}
+
+static uint32_t wdbench_elapsed(FAR const struct timespec *start)
+{
+  struct timespec now;
+
+  (void)clock_gettime(CLOCK_REALTIME, &now);
+  return (uint32_t)((now.tv_sec - start->tv_sec) * 1000000 +
+                    (now.tv_nsec - start->tv_nsec) / 1000);
+}
+
+static void wdbench_report(FAR const char *what, uint32_t usec, int nops)
+{
+  printf("wdog_benchmark: %-10s %6d operations %8lu usec %6lu nsec/op\n",
+         what, nops, (unsigned long)usec,
+         (unsigned long)(((uint64_t)usec * 1000) / nops));
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: wdog_benchmark
+ *
+ * Description:
+ *   Arm and then cancel as many watchdogs as are available (up to
+ *   CONFIG_EXAMPLES_OSTEST_WDOGBENCH_NWDOGS) with random delays and report
+ *   the time spent in wd_start() and wd_cancel().  Both functions execute
+ *   with interrupts disabled so this is also the time that interrupts were
+ *   held off.
+ *
+ ****************************************************************************/
+
+void wdog_benchmark(void)
+{
+  FAR WDOG_ID *wdogs;
+  struct timespec start;
+  uint32_t usec;
+  int nwdogs;
+  int i;
+
+  wdogs = (FAR WDOG_ID *)malloc(CONFIG_EXAMPLES_OSTEST_WDOGBENCH_NWDOGS *
+                                sizeof(WDOG_ID));
+  if (!wdogs)
+    {
+      printf("wdog_benchmark: ERROR failed to allocate watchdog array\n");
+      return;
+    }
+
+  /* Allocate the watchdogs */
+
+  for (nwdogs = 0; nwdogs < CONFIG_EXAMPLES_OSTEST_WDOGBENCH_NWDOGS; nwdogs++)
+    {
+      wdogs[nwdogs] = wd_create();
+      if (!wdogs[nwdogs])
+        {
+          break;
+        }
+    }
+
+  /* If the pool was exhausted, then return a few watchdogs to the pool for
+   * use by the OS.
+   */
+
+  if (nwdogs < CONFIG_EXAMPLES_OSTEST_WDOGBENCH_NWDOGS)
+    {
+      for (i = 0; i < WDBENCH_RESERVE && nwdogs > 0; i++)
+        {
+          (void)wd_delete(wdogs[--nwdogs]);
+        }
+
+      printf("wdog_benchmark: Only %d watchdogs available "
+             "(see CONFIG_PREALLOC_WDOGS)\n", nwdogs);
+    }
+
+  if (nwdogs < 1)
+    {
+      printf("wdog_benchmark: ERROR no watchdogs available\n");
+      free(wdogs);
+      return;
+    }
+
+  g_wdbench_nexpired = 0;
+  srand(1);
+
+  /* Arm every watchdog with a random delay */
+
+  (void)clock_gettime(CLOCK_REALTIME, &start);
+  for (i = 0; i < nwdogs; i++)
+    {
+      (void)wd_start(wdogs[i], WDBENCH_MINDELAY + rand() % WDBENCH_RANGE,
+                     (wdentry_t)wdbench_expiration, 1, (uint32_t)i);
+    }
+
+  usec = wdbench_elapsed(&start);
+  wdbench_report("wd_start", usec, nwdogs);
+
+  /* Re-arm every watchdog.  This cancels the running watchdog then starts
+   * it again with a new delay.
+   */
+
+  (void)clock_gettime(CLOCK_REALTIME, &start);
+  for (i = 0; i < nwdogs; i++)
+    {
+      (void)wd_start(wdogs[i], WDBENCH_MINDELAY + rand() % WDBENCH_RANGE,
+                     (wdentry_t)wdbench_expiration, 1, (uint32_t)i);
+    }
+
+  usec = wdbench_elapsed(&start);
+  wdbench_report("wd_restart", usec, nwdogs);
+
+  /* Cancel every watchdog, visiting them in a scattered order */
+
+  (void)clock_gettime(CLOCK_REALTIME, &start);
+  for (i = 0; i < nwdogs; i++)
+    {
+      (void)wd_cancel(wdogs[(i * 7919) % nwdogs]);
+    }
+
+  usec = wdbench_elapsed(&start);
+  wdbench_report("wd_cancel", usec, nwdogs);
+
+  if (g_wdbench_nexpired > 0)
+    {
+      printf("wdog_benchmark: ERROR %d watchdogs expired\n",
+             g_wdbench_nexpired);
+    }
+
+  /* Return the watchdogs to the pool */
+
+  for (i = 0; i < nwdogs; i++)
+    {
+      (void)wd_delete(wdogs[i]);
+    }
+
+  free(wdogs);
+}
+
+#endif /* CONFIG_EXAMPLES_OSTEST_WDOGBENCH */
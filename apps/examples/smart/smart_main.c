@@ -48,6 +48,7 @@
 #include <fcntl.h>
 #include <dirent.h>
 #include <string.h>
+#include <time.h>
 #include <errno.h>
 #include <crc32.h>
 #include <debug.h>
@@ -788,6 +789,39 @@ static int smart_directory(void)
   return OK;
 }
 
+/****************************************************************************
+ * Name: smart_scanbench
+ *
+ * Description:
+ *   Measure how long SMART takes to scan the (now populated) volume, as it
+ *   does each time the device is initialized.  The scan is done by a second
+ *   SMART device instance on the same MTD device.
+ *
+ ****************************************************************************/
+
+static void smart_scanbench(FAR struct mtd_dev_s *mtd)
+{
+  struct timespec start;
+  struct timespec end;
+  unsigned long elapsed;
+  int ret;
+
+  (void)clock_gettime(CLOCK_REALTIME, &start);
+  ret = smart_initialize(2, mtd, NULL);
+  (void)clock_gettime(CLOCK_REALTIME, &end);
+
+  if (ret < 0)
+    {
+      message("ERROR: SMART re-initialization failed: %d\n", -ret);
+      return;
+    }
+
+  elapsed = (end.tv_sec - start.tv_sec) * 1000 +
+            (end.tv_nsec - start.tv_nsec) / 1000000;
+  message("\n=== MOUNT SCAN ==============================\n");
+  message("  Scan time:       %lu ms\n", elapsed);
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -823,7 +857,7 @@ int smart_main(int argc, char *argv[])
   /* Initialize to provide SMART on an MTD interface */
 
   MTD_IOCTL(mtd, MTDIOC_BULKERASE, 0);
-  ret = smart_initialize(1, mtd);
+  ret = smart_initialize(1, mtd, NULL);
   if (ret < 0)
     {
       message("ERROR: SMART initialization failed: %d\n", -ret);
@@ -944,6 +978,11 @@ int smart_main(int argc, char *argv[])
       msgflush();
     }
 
+  /* Time a scan of the populated volume */
+
+  smart_scanbench(mtd);
+  msgflush();
+
   /* Delete all files then show memory usage again */
 
   smart_delallfiles();
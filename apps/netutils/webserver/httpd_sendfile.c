@@ -130,9 +130,20 @@ int httpd_sendfile_close(struct httpd_fs_file *file)
 
 int httpd_sendfile_send(int outfd, struct httpd_fs_file *file)
 {
-  if (-1 == sendfile(outfd, file->fd, 0, file->len))
+  off_t offset = 0;
+  ssize_t nsent;
+
+  /* sendfile() may send less than requested.  Continue from the updated
+   * offset until the whole file has been sent.
+   */
+
+  while (offset < file->len)
     {
-      return ERROR;
+      nsent = sendfile(outfd, file->fd, &offset, file->len - offset);
+      if (nsent <= 0)
+        {
+          return ERROR;
+        }
     }
 
   return OK;
@@ -71,7 +71,11 @@ struct xcptcontext
  * Inline functions
  ************************************************************/
 
-#ifndef __ASSEMBLY__
+/* In the SMP configuration, irqsave() and irqrestore() establish a critical
+ * section on all CPUs and cannot be inline (see up_smp.c).
+ */
+
+#if !defined(__ASSEMBLY__) && !defined(CONFIG_SMP)
 static inline irqstate_t irqsave(void)
 {
   return 0;
@@ -97,6 +101,11 @@ extern "C" {
 #define EXTERN extern
 #endif
 
+#if !defined(__ASSEMBLY__) && defined(CONFIG_SMP)
+irqstate_t irqsave(void);
+void irqrestore(irqstate_t flags);
+#endif
+
 #undef EXTERN
 #ifdef __cplusplus
 }
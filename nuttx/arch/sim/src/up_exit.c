@@ -80,6 +80,13 @@ void _exit(int status)
 
   sdbg("TCB=%p exitting\n", tcb);
 
+  /* Enter the critical section.  It is never left by this task:  In the
+   * SMP configuration, the next task continues within the critical
+   * section.
+   */
+
+  (void)irqsave();
+
   /* Destroy the task at the head of the ready to run list. */
 
   (void)task_exit();
@@ -88,7 +95,7 @@ void _exit(int status)
    * head of the list.
    */
 
-  tcb = (struct tcb_s*)g_readytorun.head;
+  tcb = this_task();
   sdbg("New Active Task TCB=%p\n", tcb);
 
   /* The way that we handle signals in the simulation is kind of
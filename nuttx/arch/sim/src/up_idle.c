@@ -62,12 +62,9 @@ static int g_x11refresh = 0;
  * Public Function Prototypes
  ****************************************************************************/
 
-#if defined(CONFIG_SIM_WALLTIME) || defined(CONFIG_SIM_X11FB)
-extern int up_hostusleep(unsigned int usec);
 #ifdef CONFIG_SIM_X11FB
 extern void up_x11update(void);
 #endif
-#endif
 
 /****************************************************************************
  * Private Functions
@@ -94,11 +91,42 @@ extern void up_x11update(void);
 
 void up_idle(void)
 {
+#ifdef CONFIG_SMP
+  irqstate_t flags;
+
+  /* Only CPU 0 processes the timer and drives the simulated devices.  The
+   * other CPUs just wait a bit to avoid spinning on the host.  A
+   * re-schedule request (a host signal) ends the wait early.
+   */
+
+  if (up_cpu_index() != 0)
+    {
+      (void)up_hostusleep(1000000 / CLK_TCK);
+      return;
+    }
+
+  /* The timer processing on CPU 0 must be within the critical section */
+
+  flags = irqsave();
+#endif
+
+#ifdef CONFIG_SCHED_TICKLESS
+  /* If the system is idle, then service the interval timer.  This will
+   * advance the time to the next timer event.
+   */
+
+  up_timer_update();
+#else
   /* If the system is idle, then process "fake" timer interrupts.
    * Hopefully, something will wake up.
    */
 
   sched_process_timer();
+#endif
+
+#ifdef CONFIG_SMP
+  irqrestore(flags);
+#endif
 
   /* Run the network if enabled */
 
@@ -129,7 +157,9 @@ void up_idle(void)
    */
 
 #if defined(CONFIG_SIM_WALLTIME) || defined(CONFIG_SIM_X11FB)
+#ifndef CONFIG_SCHED_TICKLESS
   (void)up_hostusleep(1000000 / CLK_TCK);
+#endif
 
   /* Handle X11-related events */
 
@@ -85,6 +85,12 @@
 
 void up_initialize(void)
 {
+#ifdef CONFIG_SCHED_TICKLESS
+  /* Initialize the free-running time source and the interval timer */
+
+  up_timer_initialize();
+#endif
+
   /* The real purpose of the following is to make sure that syslog
    * is drawn into the link.  It is needed by up_tapdev which is linked
    * separately.
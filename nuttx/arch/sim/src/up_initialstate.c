@@ -81,4 +81,17 @@ void up_initial_state(struct tcb_s *tcb)
   memset(&tcb->xcp, 0, sizeof(struct xcptcontext));
   tcb->xcp.regs[JB_SP] = (uint32_t)tcb->adj_stack_ptr;
   tcb->xcp.regs[JB_PC] = (uint32_t)tcb->start;
+
+#ifdef CONFIG_SMP
+  /* A new task is started by a context switch within the critical section
+   * (see up_smp.c).  It must first leave that critical section.  The IDLE
+   * task (PID 0) is already running outside of any critical section.
+   */
+
+  if (tcb->pid != 0)
+    {
+      tcb->irqcount        = 1;
+      tcb->xcp.regs[JB_PC] = (uint32_t)up_cpu_taskstart;
+    }
+#endif
 }
@@ -162,6 +162,40 @@ extern void up_registerblockdevice(void);
 
 extern char *up_deviceimage(void);
 
+/* up_hostusleep.c ********************************************************/
+
+extern int up_hostusleep(unsigned int usec);
+
+/* up_hosttime.c **********************************************************/
+
+#ifdef CONFIG_SCHED_TICKLESS
+extern uint64_t up_hostgettime(void);
+#endif
+
+/* up_tickless.c **********************************************************/
+
+#ifdef CONFIG_SCHED_TICKLESS
+extern void up_timer_update(void);
+#endif
+
+/* up_simsmp.c ************************************************************/
+
+#ifdef CONFIG_SMP
+extern int  up_hostcpu_index(void);
+extern int  up_hostcpu_start(int cpu);
+extern void up_hostcpu_signal(int cpu);
+extern void up_hostcpu_setirq(int irqset);
+extern int  up_hostcpu_getirq(void);
+#endif
+
+/* up_smp.c ***************************************************************/
+
+#ifdef CONFIG_SMP
+extern void up_cpu_ipi(void);
+extern void up_cpu_idle(void) noreturn_function;
+extern void up_cpu_taskstart(void) noreturn_function;
+#endif
+
 /* up_stdio.c *************************************************************/
 
 extern size_t up_hostread(void *buffer, size_t len);
@@ -203,11 +237,13 @@ extern int up_buttonevent(int x, int y, int buttons);
 #if defined(CONFIG_NET) && !defined(__CYGWIN__)
 extern void tapdev_init(void);
 extern unsigned int tapdev_read(unsigned char *buf, unsigned int buflen);
+extern unsigned int tapdev_tryread(unsigned char *buf, unsigned int buflen);
 extern void tapdev_send(unsigned char *buf, unsigned int buflen);
 
-#define netdev_init()           tapdev_init()
-#define netdev_read(buf,buflen) tapdev_read(buf,buflen)
-#define netdev_send(buf,buflen) tapdev_send(buf,buflen)
+#define netdev_init()              tapdev_init()
+#define netdev_read(buf,buflen)    tapdev_read(buf,buflen)
+#define netdev_tryread(buf,buflen) tapdev_tryread(buf,buflen)
+#define netdev_send(buf,buflen)    tapdev_send(buf,buflen)
 #endif
 
 /* up_wpcap.c *************************************************************/
@@ -217,9 +253,10 @@ extern void wpcap_init(void);
 extern unsigned int wpcap_read(unsigned char *buf, unsigned int buflen);
 extern void wpcap_send(unsigned char *buf, unsigned int buflen);
 
-#define netdev_init()           wpcap_init()
-#define netdev_read(buf,buflen) wpcap_read(buf,buflen)
-#define netdev_send(buf,buflen) wpcap_send(buf,buflen)
+#define netdev_init()              wpcap_init()
+#define netdev_read(buf,buflen)    wpcap_read(buf,buflen)
+#define netdev_tryread(buf,buflen) wpcap_read(buf,buflen) /* Never blocks */
+#define netdev_send(buf,buflen)    wpcap_send(buf,buflen)
 #endif
 
 /* up_uipdriver.c *********************************************************/
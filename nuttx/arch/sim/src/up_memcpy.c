@@ -0,0 +1,136 @@
+/****************************************************************************
+ * arch/sim/src/up_memcpy.c
+ *
+ *   Copyright (C) 2014 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+#include <string.h>
+
+#ifdef CONFIG_ARCH_MEMCPY
+
+/****************************************************************************
+ * Private Definitions
+ ****************************************************************************/
+
+/* The simulation always runs on an x86 host that supports SSE2.  GCC vector
+ * extensions are used so that no host intrinsic headers are required.  The
+ * target attribute enables SSE2 code generation in this function even when
+ * building a 32-bit simulation with default flags.
+ */
+
+#define SSE2_FUNCTION __attribute__((target("sse2")))
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+typedef char sse_t __attribute__((vector_size(16)));
+typedef sse_t sse_unaligned_t __attribute__((aligned(1), may_alias));
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: memcpy
+ *
+ * Description:
+ *   SSE2 memcpy():  Align the destination to 16 bytes, then copy 64 bytes
+ *   per iteration using unaligned loads and aligned stores.
+ *
+ ****************************************************************************/
+
+SSE2_FUNCTION FAR void *memcpy(FAR void *dest, FAR const void *src, size_t n)
+{
+  FAR unsigned char *pout = (FAR unsigned char *)dest;
+  FAR const unsigned char *pin = (FAR const unsigned char *)src;
+
+  if (n >= 64)
+    {
+      FAR sse_t *dv;
+      FAR const sse_unaligned_t *sv;
+
+      /* Copy bytes until the destination is 16-byte aligned */
+
+      while (((uintptr_t)pout & 15) != 0)
+        {
+          *pout++ = *pin++;
+          n--;
+        }
+
+      dv = (FAR sse_t *)pout;
+      sv = (FAR const sse_unaligned_t *)pin;
+
+      while (n >= 64)
+        {
+          sse_t v0 = sv[0];
+          sse_t v1 = sv[1];
+          sse_t v2 = sv[2];
+          sse_t v3 = sv[3];
+
+          dv[0] = v0;
+          dv[1] = v1;
+          dv[2] = v2;
+          dv[3] = v3;
+
+          dv += 4;
+          sv += 4;
+          n  -= 64;
+        }
+
+      while (n >= 16)
+        {
+          *dv++ = *sv++;
+          n    -= 16;
+        }
+
+      pout = (FAR unsigned char *)dv;
+      pin  = (FAR const unsigned char *)sv;
+    }
+
+  while (n-- > 0)
+    {
+      *pout++ = *pin++;
+    }
+
+  return dest;
+}
+
+#endif /* CONFIG_ARCH_MEMCPY */
@@ -0,0 +1,124 @@
+/****************************************************************************
+ * arch/sim/src/up_memset.c
+ *
+ *   Copyright (C) 2014 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+#include <string.h>
+
+#ifdef CONFIG_ARCH_MEMSET
+
+/****************************************************************************
+ * Private Definitions
+ ****************************************************************************/
+
+/* See up_memcpy.c */
+
+#define SSE2_FUNCTION __attribute__((target("sse2")))
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+typedef char sse_t __attribute__((vector_size(16)));
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: memset
+ *
+ * Description:
+ *   SSE2 memset():  Align the destination to 16 bytes, then store 64 bytes
+ *   per iteration.
+ *
+ ****************************************************************************/
+
+SSE2_FUNCTION FAR void *memset(FAR void *s, int c, size_t n)
+{
+  FAR unsigned char *p = (FAR unsigned char *)s;
+
+  if (n >= 64)
+    {
+      FAR sse_t *v;
+      sse_t val;
+
+      /* Replicate the byte into all 16 lanes */
+
+      val = (sse_t){0} + (char)c;
+
+      /* Set bytes until the destination is 16-byte aligned */
+
+      while (((uintptr_t)p & 15) != 0)
+        {
+          *p++ = (unsigned char)c;
+          n--;
+        }
+
+      v = (FAR sse_t *)p;
+      while (n >= 64)
+        {
+          v[0] = val;
+          v[1] = val;
+          v[2] = val;
+          v[3] = val;
+          v   += 4;
+          n   -= 64;
+        }
+
+      while (n >= 16)
+        {
+          *v++ = val;
+          n   -= 16;
+        }
+
+      p = (FAR unsigned char *)v;
+    }
+
+  while (n-- > 0)
+    {
+      *p++ = (unsigned char)c;
+    }
+
+  return s;
+}
+
+#endif /* CONFIG_ARCH_MEMSET */
@@ -75,7 +75,7 @@
 
 void up_release_pending(void)
 {
-  struct tcb_s *rtcb = (struct tcb_s*)g_readytorun.head;
+  struct tcb_s *rtcb = this_task();
 
   sdbg("From TCB=%p\n", rtcb);
 
@@ -96,7 +96,7 @@ void up_release_pending(void)
            * of the g_readytorun task list.
            */
 
-          rtcb = (struct tcb_s*)g_readytorun.head;
+          rtcb = this_task();
           sdbg("New Active Task TCB=%p\n", rtcb);
 
           /* The way that we handle signals in the simulation is kind of
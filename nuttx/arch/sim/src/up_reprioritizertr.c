@@ -103,7 +103,7 @@ void up_reprioritize_rtr(struct tcb_s *tcb, uint8_t priority)
     }
   else
     {
-      struct tcb_s *rtcb = (struct tcb_s*)g_readytorun.head;
+      struct tcb_s *rtcb = this_task();
       bool switch_needed;
 
       sdbg("TCB=%p PRI=%d\n", tcb, priority);
@@ -129,6 +129,15 @@ void up_reprioritize_rtr(struct tcb_s *tcb, uint8_t priority)
 
       switch_needed ^= sched_addreadytorun(tcb);
 
+#ifdef CONFIG_SMP
+      /* In the SMP case, both calls re-assign the tasks to the CPUs and the
+       * XOR above does not tell if the running task of this CPU has
+       * changed.
+       */
+
+      switch_needed = (this_task() != rtcb);
+#endif
+
       /* Now, perform the context switch if one is needed */
 
       if (switch_needed)
@@ -154,7 +163,7 @@ void up_reprioritize_rtr(struct tcb_s *tcb, uint8_t priority)
                * of the g_readytorun task list.
                */
 
-              rtcb = (struct tcb_s*)g_readytorun.head;
+              rtcb = this_task();
               sdbg("New Active Task TCB=%p\n", rtcb);
 
               /* The way that we handle signals in the simulation is kind of
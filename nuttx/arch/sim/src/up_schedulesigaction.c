@@ -100,10 +100,22 @@ void up_schedule_sigaction(struct tcb_s *tcb, sig_deliver_t sigdeliver)
 {
   /* We don't have to anything complex for the simulated target */
 
-  if (tcb == (struct tcb_s*)g_readytorun.head)
+  if (tcb == this_task())
     {
       sigdeliver(tcb);
     }
+#ifdef CONFIG_SMP
+  else if (tcb->task_state == TSTATE_TASK_RUNNING)
+    {
+      /* The task is running on another CPU.  It will take the signal
+       * action when it leaves its critical section in response to the
+       * re-schedule request.
+       */
+
+      tcb->xcp.sigdeliver = sigdeliver;
+      up_cpu_reschedule(tcb->cpu);
+    }
+#endif
   else
     {
       tcb->xcp.sigdeliver = sigdeliver;
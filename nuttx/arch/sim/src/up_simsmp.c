@@ -0,0 +1,206 @@
+/****************************************************************************
+ * arch/sim/src/up_simsmp.c
+ *
+ *   Copyright (C) 2014 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <pthread.h>
+
+/****************************************************************************
+ * Private Definitions
+ ****************************************************************************/
+
+/* This file is compiled with the host compiler and the host header files.
+ * CONFIG_SMP_NCPUS is provided on the command line by the Makefile.
+ */
+
+#ifndef CONFIG_SMP_NCPUS
+#  error "CONFIG_SMP_NCPUS is not defined"
+#endif
+
+/* The host signal used as the inter-processor interrupt */
+
+#define SIM_IPI_SIGNAL SIGUSR1
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+/* These are provided by the NuttX side of the simulation (up_smp.c) */
+
+extern void up_cpu_ipi(void);
+extern void up_cpu_idle(void);
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* Each simulated CPU is a host thread */
+
+static pthread_t g_sim_cputhread[CONFIG_SMP_NCPUS];
+
+/* The index of the CPU that this host thread simulates and whether this
+ * CPU is within (or entering) a critical section.  These are host thread
+ * local so they can be accessed with a single instruction and no
+ * re-schedule request can move the task in between.
+ */
+
+static __thread int g_sim_cpuindex;
+static __thread volatile int g_sim_irqset;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: sim_ipi_handler
+ *
+ * Description:
+ *   The host signal handler that receives the simulated inter-processor
+ *   interrupt.
+ *
+ ****************************************************************************/
+
+static void sim_ipi_handler(int signo)
+{
+  up_cpu_ipi();
+}
+
+/****************************************************************************
+ * Name: sim_cpu_thread
+ *
+ * Description:
+ *   The entry point of the host thread that simulates a CPU.  It runs the
+ *   IDLE loop of the CPU and never returns.
+ *
+ ****************************************************************************/
+
+static void *sim_cpu_thread(void *arg)
+{
+  g_sim_cpuindex = (int)(intptr_t)arg;
+  up_cpu_idle();
+  return NULL;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: up_hostcpu_index
+ ****************************************************************************/
+
+int up_hostcpu_index(void)
+{
+  return g_sim_cpuindex;
+}
+
+/****************************************************************************
+ * Name: up_hostcpu_setirq and up_hostcpu_getirq
+ *
+ * Description:
+ *   Set or get the indication that this CPU is within (or entering) a
+ *   critical section.  Re-schedule requests are held off while it is set.
+ *
+ ****************************************************************************/
+
+void up_hostcpu_setirq(int irqset)
+{
+  g_sim_irqset = irqset;
+}
+
+int up_hostcpu_getirq(void)
+{
+  return g_sim_irqset;
+}
+
+/****************************************************************************
+ * Name: up_hostcpu_start
+ *
+ * Description:
+ *   Create the host thread that simulates CPU 'cpu'.  The first call also
+ *   registers the host thread of CPU 0 (the calling thread) and attaches
+ *   the handler of the simulated inter-processor interrupt.
+ *
+ ****************************************************************************/
+
+int up_hostcpu_start(int cpu)
+{
+  static int initialized = 0;
+  struct sigaction act;
+  int ret;
+
+  if (!initialized)
+    {
+      /* The handler may switch to another task and so must not hold off
+       * further signals.
+       */
+
+      memset(&act, 0, sizeof(struct sigaction));
+      act.sa_handler = sim_ipi_handler;
+      act.sa_flags   = SA_NODEFER;
+      sigemptyset(&act.sa_mask);
+
+      if (sigaction(SIM_IPI_SIGNAL, &act, NULL) < 0)
+        {
+          return -errno;
+        }
+
+      g_sim_cputhread[0] = pthread_self();
+      initialized = 1;
+    }
+
+  ret = pthread_create(&g_sim_cputhread[cpu], NULL, sim_cpu_thread,
+                       (void *)((intptr_t)cpu));
+  return -ret;
+}
+
+/****************************************************************************
+ * Name: up_hostcpu_signal
+ *
+ * Description:
+ *   Send the simulated inter-processor interrupt to CPU 'cpu'.
+ *
+ ****************************************************************************/
+
+void up_hostcpu_signal(int cpu)
+{
+  (void)pthread_kill(g_sim_cputhread[cpu], SIM_IPI_SIGNAL);
+}
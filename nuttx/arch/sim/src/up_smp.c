@@ -0,0 +1,384 @@
+/****************************************************************************
+ * arch/sim/src/up_smp.c
+ *
+ *   Copyright (C) 2014 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdbool.h>
+#include <sched.h>
+#include <assert.h>
+#include <debug.h>
+
+#include <nuttx/arch.h>
+#include <nuttx/spinlock.h>
+
+#include "os_internal.h"
+#include "up_internal.h"
+
+#ifdef CONFIG_SMP
+
+/****************************************************************************
+ * Private Definitions
+ ****************************************************************************/
+
+/* The simulation of multiple CPUs works like this:
+ *
+ * - Each CPU is a host thread (see up_simsmp.c).  A CPU switches between
+ *   NuttX tasks with up_setjmp()/up_longjmp() just as in the single CPU
+ *   simulation.
+ * - irqsave() takes one spinlock that is shared by all CPUs.  The
+ *   nesting count is kept in the TCB of the task.  A context switch only
+ *   occurs within the critical section and the lock is then passed on to
+ *   the next task:  Every task that is not running holds an irqcount of
+ *   at least one and every new task starts with an irqcount of one (see
+ *   up_initial_state() and up_cpu_taskstart()).
+ * - up_cpu_reschedule() is a host signal sent to the other CPU.  If that
+ *   CPU is within (or entering) a critical section, the request is held
+ *   pending until the CPU leaves its critical section.
+ */
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* The spinlock of the critical section shared by all CPUs */
+
+static volatile spinlock_t g_cpu_irqlock = SP_UNLOCKED;
+
+/* A re-schedule request is pending on the CPU */
+
+static volatile bool g_cpu_ipipending[CONFIG_SMP_NCPUS];
+
+/* The CPU has been started (CPU 0 is always running) */
+
+static volatile bool g_cpu_started[CONFIG_SMP_NCPUS] = { true };
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: up_cpu_resume
+ *
+ * Description:
+ *   Handle a re-schedule request:  Make the task selected by the scheduler
+ *   the running task of this CPU and switch to it.
+ *
+ * Assumptions:
+ *   Called within the critical section.
+ *
+ ****************************************************************************/
+
+static void up_cpu_resume(void)
+{
+  struct tcb_s *rtcb = this_task();
+
+  g_cpu_ipipending[up_cpu_index()] = false;
+  if (sched_smp_resume())
+    {
+      /* Save the context of the previous task.  if up_setjmp returns a
+       * non-zero value, then this is really the previous task restarting!
+       */
+
+      if (!up_setjmp(rtcb->xcp.regs))
+        {
+          rtcb = this_task();
+          sdbg("CPU%d: New Active Task TCB=%p\n", up_cpu_index(), rtcb);
+          up_longjmp(rtcb->xcp.regs, 1);
+        }
+    }
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: up_cpu_index
+ *
+ * Description:
+ *   Return the index of the CPU (i.e., of the host thread) that is
+ *   executing the caller.
+ *
+ ****************************************************************************/
+
+int up_cpu_index(void)
+{
+  return up_hostcpu_index();
+}
+
+/****************************************************************************
+ * Name: up_testset
+ *
+ * Description:
+ *   Perform an atomic test and set operation on the provided spinlock.
+ *
+ ****************************************************************************/
+
+spinlock_t up_testset(volatile FAR spinlock_t *lock)
+{
+  return __sync_lock_test_and_set(lock, SP_LOCKED);
+}
+
+/****************************************************************************
+ * Name: irqsave
+ *
+ * Description:
+ *   Enter the critical section shared by all CPUs.  The critical section
+ *   is recursive.
+ *
+ ****************************************************************************/
+
+irqstate_t irqsave(void)
+{
+  struct tcb_s *rtcb;
+
+  /* Hold off re-schedule requests.  After this, the calling task cannot
+   * move to another CPU.
+   */
+
+  up_hostcpu_setirq(true);
+
+  rtcb = this_task();
+  if (rtcb->irqcount == 0)
+    {
+      spin_lock(&g_cpu_irqlock);
+    }
+
+  /* Handle a re-schedule request that arrived while the lock was taken */
+
+  if (++rtcb->irqcount == 1 && g_cpu_ipipending[up_cpu_index()])
+    {
+      up_cpu_resume();
+    }
+
+  return 0;
+}
+
+/****************************************************************************
+ * Name: irqrestore
+ *
+ * Description:
+ *   Leave the critical section shared by all CPUs.  Pending re-schedule
+ *   requests and signals are handled when the outermost critical section
+ *   is left.
+ *
+ ****************************************************************************/
+
+void irqrestore(irqstate_t flags)
+{
+  struct tcb_s *rtcb = this_task();
+  sig_deliver_t sigdeliver;
+
+  DEBUGASSERT(rtcb->irqcount > 0);
+  if (rtcb->irqcount > 1)
+    {
+      rtcb->irqcount--;
+      return;
+    }
+
+  /* Handle a re-schedule request that arrived within the critical
+   * section.  This may switch to another task and return much later,
+   * possibly on another CPU.
+   */
+
+  if (g_cpu_ipipending[up_cpu_index()])
+    {
+      up_cpu_resume();
+    }
+
+  /* Take any signal action that was scheduled while this task was running
+   * on another CPU.
+   */
+
+  sigdeliver = (sig_deliver_t)rtcb->xcp.sigdeliver;
+  rtcb->xcp.sigdeliver = NULL;
+
+  /* Pre-emption that was disabled within the critical section must also
+   * be enabled again within it:  Only the holder of the pre-emption lock
+   * may leave the critical section with pre-emption disabled (see
+   * sched_lock()).
+   */
+
+  DEBUGASSERT(rtcb->lockcount == 0 || g_cpu_schedlock == up_cpu_index());
+
+  /* Then leave the critical section */
+
+  rtcb->irqcount = 0;
+  spin_unlock(&g_cpu_irqlock);
+  up_hostcpu_setirq(false);
+
+  /* A re-schedule request may have been held off between releasing the lock
+   * and the line above.
+   */
+
+  if (g_cpu_ipipending[up_cpu_index()])
+    {
+      up_cpu_ipi();
+    }
+
+  if (sigdeliver)
+    {
+      sdbg("Delivering signals TCB=%p\n", rtcb);
+      sigdeliver(rtcb);
+    }
+}
+
+/****************************************************************************
+ * Name: up_cpu_ipi
+ *
+ * Description:
+ *   Handle the simulated inter-processor interrupt.  This is called from
+ *   the host signal handler (see up_simsmp.c).
+ *
+ ****************************************************************************/
+
+void up_cpu_ipi(void)
+{
+  irqstate_t flags;
+
+  /* If this CPU is within (or entering) the critical section, then the
+   * request remains pending until the CPU leaves the critical section.
+   * Otherwise, handle it now.
+   */
+
+  if (!up_hostcpu_getirq())
+    {
+      flags = irqsave();
+      irqrestore(flags);
+    }
+}
+
+/****************************************************************************
+ * Name: up_cpu_reschedule
+ *
+ * Description:
+ *   Ask another CPU to re-schedule (see include/nuttx/arch.h).
+ *
+ ****************************************************************************/
+
+void up_cpu_reschedule(int cpu)
+{
+  DEBUGASSERT(cpu >= 0 && cpu < CONFIG_SMP_NCPUS && cpu != up_cpu_index());
+
+  g_cpu_ipipending[cpu] = true;
+  if (g_cpu_started[cpu])
+    {
+      up_hostcpu_signal(cpu);
+    }
+}
+
+/****************************************************************************
+ * Name: up_cpu_start
+ *
+ * Description:
+ *   Start another CPU (see include/nuttx/arch.h).  The host thread of the
+ *   CPU runs up_cpu_idle().
+ *
+ ****************************************************************************/
+
+int up_cpu_start(int cpu)
+{
+  int ret;
+
+  DEBUGASSERT(cpu > 0 && cpu < CONFIG_SMP_NCPUS);
+
+  ret = up_hostcpu_start(cpu);
+  if (ret >= 0)
+    {
+      g_cpu_started[cpu] = true;
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: up_cpu_idle
+ *
+ * Description:
+ *   The IDLE loop of CPUs 1 through (CONFIG_SMP_NCPUS-1).  CPU 0 runs the
+ *   IDLE loop in os_start().
+ *
+ ****************************************************************************/
+
+void up_cpu_idle(void)
+{
+  irqstate_t flags;
+
+  sdbg("CPU%d: Beginning Idle Loop\n", up_cpu_index());
+
+  for (;;)
+    {
+      /* Pick up re-schedule requests that were sent before this CPU was
+       * marked as started.  The CPU cannot change in this loop:  The IDLE
+       * task of a CPU never runs on any other CPU.
+       */
+
+      if (g_cpu_ipipending[up_cpu_index()])
+        {
+          flags = irqsave();
+          irqrestore(flags);
+        }
+
+      up_idle();
+    }
+}
+
+/****************************************************************************
+ * Name: up_cpu_taskstart
+ *
+ * Description:
+ *   All new tasks begin here (see up_initial_state()).  The new task is
+ *   started within the critical section of the task that switched to it
+ *   and must leave that critical section before running its entry point.
+ *
+ ****************************************************************************/
+
+void up_cpu_taskstart(void)
+{
+  struct tcb_s *rtcb = this_task();
+
+  irqrestore(0);
+  rtcb->start();
+
+  /* The start function never returns */
+
+  PANIC();
+}
+
+#endif /* CONFIG_SMP */
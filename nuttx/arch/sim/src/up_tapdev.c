@@ -164,6 +164,45 @@ static int up_setmacaddr(void)
   return ret;
 }
 
+static unsigned int tapdev_readtmo(unsigned char *buf, unsigned int buflen,
+                                   long usec)
+{
+  fd_set                fdset;
+  struct timeval        tv;
+  int                   ret;
+
+  /* We can't do anything if we failed to open the tap device */
+
+  if (gtapdevfd < 0)
+    {
+      return 0;
+    }
+
+  /* Wait for data on the tap device (or a timeout) */
+
+  tv.tv_sec  = 0;
+  tv.tv_usec = usec;
+
+  FD_ZERO(&fdset);
+  FD_SET(gtapdevfd, &fdset);
+
+  ret = select(gtapdevfd + 1, &fdset, NULL, NULL, &tv);
+  if(ret == 0)
+    {
+      return 0;
+    }
+
+  ret = read(gtapdevfd, buf, buflen);
+  if (ret < 0)
+    {
+      syslog("TAPDEV: read failed: %d\n", -ret);
+      return 0;
+    }
+
+  dump_ethhdr("read", buf, ret);
+  return ret;
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -207,40 +246,16 @@ void tapdev_init(void)
 
 unsigned int tapdev_read(unsigned char *buf, unsigned int buflen)
 {
-  fd_set                fdset;
-  struct timeval        tv;
-  int                   ret;
-
-  /* We can't do anything if we failed to open the tap device */
-
-  if (gtapdevfd < 0)
-    {
-      return 0;
-    }
-
-  /* Wait for data on the tap device (or a timeout) */
-
-  tv.tv_sec  = 0;
-  tv.tv_usec = 1000;
-
-  FD_ZERO(&fdset);
-  FD_SET(gtapdevfd, &fdset);
+  /* Wait up to 1 millisecond for a frame */
 
-  ret = select(gtapdevfd + 1, &fdset, NULL, NULL, &tv);
-  if(ret == 0)
-    {
-      return 0;
-    }
+  return tapdev_readtmo(buf, buflen, 1000);
+}
 
-  ret = read(gtapdevfd, buf, buflen);
-  if (ret < 0)
-    {
-      syslog("TAPDEV: read failed: %d\n", -ret);
-      return 0;
-    }
+unsigned int tapdev_tryread(unsigned char *buf, unsigned int buflen)
+{
+  /* Only return a frame that is already queued on the tap device */
 
-  dump_ethhdr("read", buf, ret);
-  return ret;
+  return tapdev_readtmo(buf, buflen, 0);
 }
 
 void tapdev_send(unsigned char *buf, unsigned int buflen)
@@ -0,0 +1,313 @@
+/****************************************************************************
+ * arch/sim/src/up_tickless.c
+ *
+ *   Copyright (C) 2014 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Tickless OS Support.
+ *
+ * When CONFIG_SCHED_TICKLESS is enabled, all support for timer interrupts
+ * is suppressed and the platform specific code is expected to provide the
+ * following custom functions.
+ *
+ *   void up_timer_initialize(void): Initializes the timer facilities.
+ *     Called early in the initialization sequence (by up_initialize()).
+ *   int up_timer_gettime(FAR struct timespec *ts):  Returns the current
+ *     time from the platform specific time source.
+ *   int up_timer_cancel(FAR struct timespec *ts):  Cancels the interval
+ *     timer.
+ *   int up_timer_start(FAR const struct timespec *ts): Start (or re-starts)
+ *     the interval timer.
+ *
+ * The RTOS will provide the following interfaces for use by the platform-
+ * specific interval timer implementation:
+ *
+ *   void sched_timer_expiration(void):  Called by the platform-specific
+ *     logic when the interval timer expires.
+ *
+ * The simulation has no timer interrupts.  Instead, the interval timer is
+ * serviced from the IDLE loop by up_timer_update().  By default, the
+ * simulated time simply jumps forward to the next expiration so that
+ * delays complete as quickly as possible.  If CONFIG_SIM_WALLTIME is
+ * selected, then the host time is used as the free-running time source.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include <nuttx/arch.h>
+#include <nuttx/clock.h>
+
+#include "up_internal.h"
+
+#ifdef CONFIG_SCHED_TICKLESS
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* When running in near real time, the IDLE loop will sleep no longer than
+ * this (in microseconds) so that network and X11 events are still polled.
+ */
+
+#define SIM_MAX_IDLE_USEC 10000
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+#ifdef CONFIG_SIM_WALLTIME
+static uint64_t g_start_usec;    /* Host time when the timer was initialized */
+#else
+static uint64_t g_elapsed_usec;  /* Simulated time since initialization */
+#endif
+static uint64_t g_alarm_usec;    /* Time when the interval timer expires */
+static bool     g_timer_active;  /* True: The interval timer is running */
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: up_timer_now
+ *
+ * Description:
+ *   Return the current up-time in microseconds.
+ *
+ ****************************************************************************/
+
+static uint64_t up_timer_now(void)
+{
+#ifdef CONFIG_SIM_WALLTIME
+  return up_hostgettime() - g_start_usec;
+#else
+  return g_elapsed_usec;
+#endif
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: up_timer_initialize
+ *
+ * Description:
+ *   Initializes all platform-specific timer facilities.  This function is
+ *   called early in the initialization sequence by up_intialize().
+ *   On return, the current up-time should be available from
+ *   up_timer_gettime() and the interval timer is ready for use (but not
+ *   actively timing).
+ *
+ * Input Parameters:
+ *   None
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+void up_timer_initialize(void)
+{
+#ifdef CONFIG_SIM_WALLTIME
+  g_start_usec   = up_hostgettime();
+#else
+  g_elapsed_usec = 0;
+#endif
+  g_timer_active = false;
+}
+
+/****************************************************************************
+ * Name: up_timer_gettime
+ *
+ * Description:
+ *   Return the elapsed time since power-up (or, more correctly, since
+ *   up_timer_initialize() was called).
+ *
+ * Input Parameters:
+ *   ts - Provides the location in which to return the up-time.
+ *
+ * Returned Value:
+ *   Zero (OK) is returned on success; a negated errno value is returned on
+ *   any failure.
+ *
+ ****************************************************************************/
+
+int up_timer_gettime(FAR struct timespec *ts)
+{
+  uint64_t now = up_timer_now();
+
+  ts->tv_sec  = now / USEC_PER_SEC;
+  ts->tv_nsec = (now % USEC_PER_SEC) * NSEC_PER_USEC;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: up_timer_cancel
+ *
+ * Description:
+ *   Cancel the interval timer and return the time remaining on the timer.
+ *
+ * Input Parameters:
+ *   ts - Location to return the remaining time.  Zero is returned if the
+ *        timer is not active.  May be NULL.
+ *
+ * Returned Value:
+ *   Zero (OK) is returned on success; a negated errno value is returned on
+ *   any failure.
+ *
+ ****************************************************************************/
+
+int up_timer_cancel(FAR struct timespec *ts)
+{
+  uint64_t now;
+  uint64_t remaining = 0;
+
+  if (g_timer_active)
+    {
+      now = up_timer_now();
+      if (g_alarm_usec > now)
+        {
+          remaining = g_alarm_usec - now;
+        }
+
+      g_timer_active = false;
+    }
+
+  if (ts)
+    {
+      ts->tv_sec  = remaining / USEC_PER_SEC;
+      ts->tv_nsec = (remaining % USEC_PER_SEC) * NSEC_PER_USEC;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: up_timer_start
+ *
+ * Description:
+ *   Start the interval timer.  sched_timer_expiration() will be called at
+ *   the completion of the timeout (unless up_timer_cancel is called to stop
+ *   the timing).
+ *
+ * Input Parameters:
+ *   ts - Provides the time interval until sched_timer_expiration() is
+ *        called.
+ *
+ * Returned Value:
+ *   Zero (OK) is returned on success; a negated errno value is returned on
+ *   any failure.
+ *
+ ****************************************************************************/
+
+int up_timer_start(FAR const struct timespec *ts)
+{
+  g_alarm_usec   = up_timer_now() + (uint64_t)ts->tv_sec * USEC_PER_SEC +
+                   (ts->tv_nsec + NSEC_PER_USEC - 1) / NSEC_PER_USEC;
+  g_timer_active = true;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: up_timer_update
+ *
+ * Description:
+ *   Called from the IDLE loop to service the interval timer.  In the
+ *   simulated time mode, the time advances immediately to the expiration
+ *   of the interval timer.  In the near real-time mode, this will sleep on
+ *   the host until the interval timer expires (or until other events must
+ *   be polled).
+ *
+ * Input Parameters:
+ *   None
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+void up_timer_update(void)
+{
+#ifdef CONFIG_SIM_WALLTIME
+  uint64_t now = up_timer_now();
+  uint64_t wait;
+
+  if (g_timer_active && now >= g_alarm_usec)
+    {
+      g_timer_active = false;
+      sched_timer_expiration();
+    }
+  else
+    {
+      /* Nothing is due yet.  Sleep until the timer expires */
+
+      wait = g_timer_active ? g_alarm_usec - now : SIM_MAX_IDLE_USEC;
+      if (wait > SIM_MAX_IDLE_USEC)
+        {
+          wait = SIM_MAX_IDLE_USEC;
+        }
+
+      (void)up_hostusleep((unsigned int)wait);
+    }
+#else
+  if (g_timer_active)
+    {
+      /* There is nothing else to do.  Jump ahead to the next event. */
+
+      if (g_alarm_usec > g_elapsed_usec)
+        {
+          g_elapsed_usec = g_alarm_usec;
+        }
+
+      g_timer_active = false;
+      sched_timer_expiration();
+    }
+  else
+    {
+      /* Nothing is being timed, but let time progress anyway */
+
+      g_elapsed_usec += USEC_PER_TICK;
+    }
+#endif
+}
+
+#endif /* CONFIG_SCHED_TICKLESS */
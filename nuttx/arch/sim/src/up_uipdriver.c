@@ -65,6 +65,12 @@
 
 #define BUF ((struct ether_header*)g_sim_dev.d_buf)
 
+/* Maximum number of received frames passed to uIP in one batch */
+
+#ifdef CONFIG_NET_PKTQUEUE
+#  define SIM_RXBATCH 8
+#endif
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -86,6 +92,18 @@ struct timer
 static struct timer g_periodic_timer;
 static struct uip_driver_s g_sim_dev;
 
+/* With CONFIG_NET_MULTIBUFFER, the driver provides the uIP buffer.  With
+ * CONFIG_NET_PKTQUEUE, it also provides a queue of receive buffers.
+ */
+
+#ifdef CONFIG_NET_MULTIBUFFER
+static uint8_t g_pktbuf[CONFIG_NET_BUFSIZE + CONFIG_NET_GUARDSIZE];
+#endif
+
+#ifdef CONFIG_NET_PKTQUEUE
+static uint8_t g_rxbuf[SIM_RXBATCH][CONFIG_NET_BUFSIZE + CONFIG_NET_GUARDSIZE];
+#endif
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
@@ -134,10 +152,75 @@ static int sim_uiptxpoll(struct uip_driver_s *dev)
   return 0;
 }
 
+#ifdef CONFIG_NET_PKTQUEUE
+static int sim_txqueue(struct uip_driver_s *dev)
+{
+  /* uip_inputq() has left a complete response in d_buf */
+
+  netdev_send(dev->d_buf, dev->d_len);
+  return OK;
+}
+
+static inline bool sim_rxvalid(uint8_t *buf, unsigned int len)
+{
+  /* Check for valid Ethernet header with destination == our MAC address */
+
+  return len > UIP_LLH_LEN &&
+    up_comparemac(((struct ether_header*)buf)->ether_dhost, &g_sim_dev.d_mac) == 0;
+}
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
 
+#ifdef CONFIG_NET_PKTQUEUE
+void uipdriver_loop(void)
+{
+  struct uip_pktdesc_s rxq[SIM_RXBATCH];
+  unsigned int len;
+  int nrx = 0;
+
+  /* Wait briefly for the first frame, then collect any further frames that
+   * are already queued on the host network device.
+   */
+
+  len = netdev_read(g_rxbuf[0], CONFIG_NET_BUFSIZE);
+  while (len > 0)
+    {
+      if (sim_rxvalid(g_rxbuf[nrx], len))
+        {
+          rxq[nrx].pd_buf = g_rxbuf[nrx];
+          rxq[nrx].pd_len = len;
+          if (++nrx >= SIM_RXBATCH)
+            {
+              break;
+            }
+        }
+
+      len = netdev_tryread(g_rxbuf[nrx], CONFIG_NET_BUFSIZE);
+    }
+
+  /* Disable preemption through to the following so that it behaves a little
+   * more like an interrupt.
+   */
+
+  sched_lock();
+  if (nrx > 0)
+    {
+      (void)uip_inputq(&g_sim_dev, rxq, nrx, sim_txqueue);
+    }
+
+  /* Otherwise, it must be a timeout event */
+
+  else if (timer_expired(&g_periodic_timer))
+    {
+      timer_reset(&g_periodic_timer);
+      uip_timer(&g_sim_dev, sim_uiptxpoll, 1);
+    }
+  sched_unlock();
+}
+#else
 void uipdriver_loop(void)
 {
   /* netdev_read will return 0 on a timeout event and >0 on a data received event */
@@ -206,11 +289,16 @@ void uipdriver_loop(void)
     }
   sched_unlock();
 }
+#endif
 
 int uipdriver_init(void)
 {
   /* Internal initalization */
 
+#ifdef CONFIG_NET_MULTIBUFFER
+  g_sim_dev.d_buf = g_pktbuf;
+#endif
+
   timer_set(&g_periodic_timer, 500);
   netdev_init();
 
@@ -47,6 +47,7 @@
 #include <stdbool.h>
 #include <semaphore.h>
 #include <nuttx/fs/fs.h>
+#include <nuttx/rwbuffer.h>
 
 /****************************************************************************
  * Pre-processor Definitions
@@ -55,6 +56,32 @@
 #define bchlib_semgive(d) sem_post(&(d)->sem)  /* To match bchlib_semtake */
 #define MAX_OPENCNT     (255)                  /* Limit of uint8_t */
 
+/* Configuration ************************************************************/
+/* Read-ahead and write buffering are provided by drivers/rwbuffer.c */
+
+#ifdef CONFIG_FS_READAHEAD
+#  ifndef CONFIG_BCH_NREADAHEAD
+#    define CONFIG_BCH_NREADAHEAD 8
+#  endif
+#else
+#  undef CONFIG_BCH_NREADAHEAD
+#  define CONFIG_BCH_NREADAHEAD 0
+#endif
+
+#ifdef CONFIG_FS_WRITEBUFFER
+#  ifndef CONFIG_BCH_NWRITEBUFFER
+#    define CONFIG_BCH_NWRITEBUFFER 8
+#  endif
+#else
+#  undef CONFIG_BCH_NWRITEBUFFER
+#  define CONFIG_BCH_NWRITEBUFFER 0
+#endif
+
+#undef BCH_HAVE_RWBUFFER
+#if CONFIG_BCH_NREADAHEAD > 0 || CONFIG_BCH_NWRITEBUFFER > 0
+#  define BCH_HAVE_RWBUFFER 1
+#endif
+
 /****************************************************************************
  * Public Types
  ****************************************************************************/
@@ -70,6 +97,10 @@ struct bchlib_s
   bool  dirty;         /* Data has been written to the buffer */
   bool  readonly;      /* true:  Only read operations are supported */
   FAR uint8_t *buffer; /* One sector buffer */
+#ifdef BCH_HAVE_RWBUFFER
+  struct rwbuffer_s rwb;  /* Read-ahead and write buffers */
+#endif
+  struct bch_cachestats_s stats; /* Cache statistics */
 };
 
 /****************************************************************************
@@ -93,6 +124,16 @@ EXTERN const struct file_operations bch_fops;
 EXTERN void bchlib_semtake(FAR struct bchlib_s *bch);
 EXTERN int  bchlib_flushsector(FAR struct bchlib_s *bch);
 EXTERN int  bchlib_readsector(FAR struct bchlib_s *bch, size_t sector);
+EXTERN int  bchlib_flush(FAR struct bchlib_s *bch);
+EXTERN ssize_t bchlib_devread(FAR struct bchlib_s *bch, FAR uint8_t *buffer,
+                              size_t sector, size_t nsectors);
+EXTERN ssize_t bchlib_devwrite(FAR struct bchlib_s *bch,
+                               FAR const uint8_t *buffer, size_t sector,
+                               size_t nsectors);
+EXTERN int  bchlib_cacheinitialize(FAR struct bchlib_s *bch);
+EXTERN void bchlib_cacheuninitialize(FAR struct bchlib_s *bch);
+EXTERN void bchlib_cachestats(FAR struct bchlib_s *bch,
+                              FAR struct bch_cachestats_s *stats);
 
 #undef EXTERN
 #if defined(__cplusplus)
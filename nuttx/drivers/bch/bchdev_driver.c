@@ -148,7 +148,7 @@ static int bch_close(FAR struct file *filep)
   /* Flush any dirty pages remaining in the cache */
 
   bchlib_semtake(bch);
-  (void)bchlib_flushsector(bch);
+  (void)bchlib_flush(bch);
 
   /* Decrement the reference count (I don't use bchlib_decref() because I
    * want the entire close operation to be atomic wrt other driver operations.
@@ -184,7 +184,7 @@ static ssize_t bch_read(FAR struct file *filep, FAR char *buffer, size_t len)
   ret = bchlib_read(bch, buffer, filep->f_pos, len);
   if (ret > 0)
     {
-      filep->f_pos += len;
+      filep->f_pos += ret;
     }
   bchlib_semgive(bch);
   return ret;
@@ -209,7 +209,7 @@ static ssize_t bch_write(FAR struct file *filep, FAR const char *buffer, size_t
       ret = bchlib_write(bch, buffer, filep->f_pos, len);
       if (ret > 0)
         {
-          filep->f_pos += len;
+          filep->f_pos += ret;
         }
       bchlib_semgive(bch);
     }
@@ -220,7 +220,7 @@ static ssize_t bch_write(FAR struct file *filep, FAR const char *buffer, size_t
 /****************************************************************************
  * Name: bch_ioctl
  *
- * Description: Return device geometry
+ * Description: Return the BCH state structure or cache statistics
  *
  ****************************************************************************/
 
@@ -249,6 +249,23 @@ static int bch_ioctl(FAR struct file *filep, int cmd, unsigned long arg)
         }
       bchlib_semgive(bch);
     }
+  else if (cmd == DIOC_CACHESTATS)
+    {
+      FAR struct bch_cachestats_s *stats =
+        (FAR struct bch_cachestats_s *)((uintptr_t)arg);
+
+      if (!stats)
+        {
+          ret = -EINVAL;
+        }
+      else
+        {
+          bchlib_semtake(bch);
+          bchlib_cachestats(bch, stats);
+          bchlib_semgive(bch);
+          ret = OK;
+        }
+    }
 
   return ret;
 }
@@ -41,6 +41,7 @@
 
 #include <sys/types.h>
 #include <stdbool.h>
+#include <string.h>
 #include <errno.h>
 #include <assert.h>
 #include <debug.h>
@@ -65,10 +66,91 @@
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: bchlib_reload
+ *
+ * Description:
+ *   Read sectors from the block driver.  This is also the read-ahead buffer
+ *   reload callout.
+ *
+ ****************************************************************************/
+
+static ssize_t bchlib_reload(FAR void *dev, FAR uint8_t *buffer,
+                             off_t startblock, size_t nblocks)
+{
+  FAR struct bchlib_s *bch = (FAR struct bchlib_s *)dev;
+  FAR struct inode *inode = bch->inode;
+
+  bch->stats.cs_devreads++;
+  return inode->u.i_bops->read(inode, buffer, startblock, nblocks);
+}
+
+/****************************************************************************
+ * Name: bchlib_wrflush
+ *
+ * Description:
+ *   Write sectors to the block driver.  This is also the write buffer
+ *   flush callout.
+ *
+ ****************************************************************************/
+
+static ssize_t bchlib_wrflush(FAR void *dev, FAR const uint8_t *buffer,
+                              off_t startblock, size_t nblocks)
+{
+  FAR struct bchlib_s *bch = (FAR struct bchlib_s *)dev;
+  FAR struct inode *inode = bch->inode;
+
+  bch->stats.cs_devwrites++;
+  return inode->u.i_bops->write(inode, buffer, startblock, nblocks);
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: bchlib_devread
+ *
+ * Description:
+ *   Read sectors from the device, through the read-ahead buffer if there
+ *   is one.
+ *
+ * Assumptions:
+ *   Caller must assume mutual exclusion
+ *
+ ****************************************************************************/
+
+ssize_t bchlib_devread(FAR struct bchlib_s *bch, FAR uint8_t *buffer,
+                       size_t sector, size_t nsectors)
+{
+#ifdef BCH_HAVE_RWBUFFER
+  return rwb_read(&bch->rwb, sector, nsectors, buffer);
+#else
+  return bchlib_reload(bch, buffer, sector, nsectors);
+#endif
+}
+
+/****************************************************************************
+ * Name: bchlib_devwrite
+ *
+ * Description:
+ *   Write sectors to the device, through the write buffer if there is one.
+ *
+ * Assumptions:
+ *   Caller must assume mutual exclusion
+ *
+ ****************************************************************************/
+
+ssize_t bchlib_devwrite(FAR struct bchlib_s *bch, FAR const uint8_t *buffer,
+                        size_t sector, size_t nsectors)
+{
+#ifdef BCH_HAVE_RWBUFFER
+  return rwb_write(&bch->rwb, sector, nsectors, buffer);
+#else
+  return bchlib_wrflush(bch, buffer, sector, nsectors);
+#endif
+}
+
 /****************************************************************************
  * Name: bchlib_flushsector
  *
@@ -82,27 +164,51 @@
 
 int bchlib_flushsector(FAR struct bchlib_s *bch)
 {
-  FAR struct inode *inode;
   ssize_t ret = OK;
 
   if (bch->dirty)
     {
-      inode = bch->inode;
-      ret = inode->u.i_bops->write(inode, bch->buffer, bch->sector, 1);
+      ret = bchlib_devwrite(bch, bch->buffer, bch->sector, 1);
       if (ret < 0)
         {
-          fdbg("Write failed: %d\n");
+          fdbg("Write failed: %d\n", ret);
         }
       bch->dirty = false;
     }
   return (int)ret;
 }
 
+/****************************************************************************
+ * Name: bchlib_flush
+ *
+ * Description:
+ *   Flush the sector buffer and any buffered write data to the device.
+ *
+ * Assumptions:
+ *   Caller must assume mutual exclusion
+ *
+ ****************************************************************************/
+
+int bchlib_flush(FAR struct bchlib_s *bch)
+{
+  int ret = bchlib_flushsector(bch);
+
+#ifdef BCH_HAVE_RWBUFFER
+  if (ret >= 0)
+    {
+      ret = rwb_flush(&bch->rwb);
+    }
+#endif
+
+  return ret;
+}
+
 /****************************************************************************
  * Name: bchlib_readsector
  *
  * Description:
- *   Flush the current contents of the sector buffer (if dirty)
+ *   Flush the current contents of the sector buffer (if dirty) and read
+ *   the requested sector into the sector buffer.
  *
  * Assumptions:
  *   Caller must assume mutual exclusion
@@ -111,23 +217,99 @@ int bchlib_flushsector(FAR struct bchlib_s *bch)
 
 int bchlib_readsector(FAR struct bchlib_s *bch, size_t sector)
 {
-  FAR struct inode *inode;
   ssize_t ret = OK;
 
   if (bch->sector != sector)
     {
-      inode = bch->inode;
-
       (void)bchlib_flushsector(bch);
       bch->sector = (size_t)-1;
+      bch->stats.cs_misses++;
 
-      ret = inode->u.i_bops->read(inode, bch->buffer, sector, 1);
+      ret = bchlib_devread(bch, bch->buffer, sector, 1);
       if (ret < 0)
         {
-          fdbg("Read failed: %d\n");
+          fdbg("Read failed: %d\n", ret);
         }
       bch->sector = sector;
     }
+  else
+    {
+      bch->stats.cs_hits++;
+    }
+
   return (int)ret;
 }
 
+/****************************************************************************
+ * Name: bchlib_cacheinitialize
+ *
+ * Description:
+ *   Set up the read-ahead and write buffers for a new BCH device.  The
+ *   geometry of the device must already be known.
+ *
+ ****************************************************************************/
+
+int bchlib_cacheinitialize(FAR struct bchlib_s *bch)
+{
+#ifdef BCH_HAVE_RWBUFFER
+  bch->rwb.blocksize   = bch->sectsize;
+  bch->rwb.nblocks     = bch->nsectors;
+  bch->rwb.dev         = bch;
+  bch->rwb.rhreload    = bchlib_reload;
+  bch->rwb.wrflush     = bchlib_wrflush;
+#ifdef CONFIG_FS_READAHEAD
+  bch->rwb.rhmaxblocks = CONFIG_BCH_NREADAHEAD;
+#endif
+#ifdef CONFIG_FS_WRITEBUFFER
+  bch->rwb.wrmaxblocks = bch->readonly ? 0 : CONFIG_BCH_NWRITEBUFFER;
+#endif
+
+  return rwb_initialize(&bch->rwb);
+#else
+  return OK;
+#endif
+}
+
+/****************************************************************************
+ * Name: bchlib_cacheuninitialize
+ *
+ * Description:
+ *   Release the read-ahead and write buffers.  The caller should use
+ *   bchlib_flush() first.
+ *
+ ****************************************************************************/
+
+void bchlib_cacheuninitialize(FAR struct bchlib_s *bch)
+{
+#ifdef BCH_HAVE_RWBUFFER
+  rwb_uninitialize(&bch->rwb);
+#endif
+}
+
+/****************************************************************************
+ * Name: bchlib_cachestats
+ *
+ * Description:
+ *   Return a snapshot of the cache statistics.
+ *
+ * Assumptions:
+ *   Caller must assume mutual exclusion
+ *
+ ****************************************************************************/
+
+void bchlib_cachestats(FAR struct bchlib_s *bch,
+                       FAR struct bch_cachestats_s *stats)
+{
+  memcpy(stats, &bch->stats, sizeof(struct bch_cachestats_s));
+
+#ifdef BCH_HAVE_RWBUFFER
+#ifdef CONFIG_FS_READAHEAD
+  stats->cs_rhhits    = bch->rwb.rhhits;
+  stats->cs_rhmisses  = bch->rwb.rhmisses;
+#endif
+#ifdef CONFIG_FS_WRITEBUFFER
+  stats->cs_wrmerges  = bch->rwb.wrmerges;
+  stats->cs_wrflushes = bch->rwb.wrflushes;
+#endif
+#endif
+}
@@ -150,6 +150,17 @@ int bchlib_setup(const char *blkdev, bool readonly, FAR void **handle)
       goto errout_with_bch;
     }
 
+  /* Set up the read-ahead and write buffers */
+
+  ret = bchlib_cacheinitialize(bch);
+  if (ret < 0)
+    {
+      fdbg("Failed to initialize the cache: %d\n", -ret);
+      bchlib_cacheuninitialize(bch);
+      kfree(bch->buffer);
+      goto errout_with_bch;
+    }
+
   *handle = bch;
   return OK;
 
@@ -93,7 +93,7 @@ int bchlib_teardown(FAR void *handle)
 
   /* Flush any pending data to the block driver */
 
-  bchlib_flushsector(bch);
+  bchlib_flush(bch);
 
   /* Close the block driver */
 
@@ -101,6 +101,8 @@ int bchlib_teardown(FAR void *handle)
 
   /* Free the BCH state structure */
 
+  bchlib_cacheuninitialize(bch);
+
   if (bch->buffer)
     {
       kfree(bch->buffer);
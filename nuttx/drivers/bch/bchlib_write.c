@@ -157,10 +157,19 @@ ssize_t bchlib_write(FAR void *handle, FAR const char *buffer, size_t offset, si
           nsectors = bch->nsectors - sector;
         }
 
+      /* The sector buffer must not keep an old copy of any of the sectors
+       * that are about to be overwritten.
+       */
+
+      if (bch->sector >= sector && bch->sector < sector + nsectors)
+        {
+          bch->sector = (size_t)-1;
+        }
+
       /* Write the contiguous sectors */
 
-      ret = bch->inode->u.i_bops->write(bch->inode, (FAR uint8_t *)buffer,
-                                        sector, nsectors);
+      ret = bchlib_devwrite(bch, (FAR const uint8_t *)buffer, sector,
+                            nsectors);
       if (ret < 0)
         {
           fdbg("Write failed: %d\n", ret);
@@ -202,7 +211,10 @@ ssize_t bchlib_write(FAR void *handle, FAR const char *buffer, size_t offset, si
       byteswritten += len;
     }
 
-  /* Finally, flush any cached writes to the device as well */
+  /* Finally, flush any cached writes to the device as well.  If write
+   * buffering is enabled, this only moves the sector into the write buffer
+   * where it is merged with adjacent sectors.
+   */
 
   ret = bchlib_flushsector(bch);
   if (ret < 0)
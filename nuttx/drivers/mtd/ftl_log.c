@@ -0,0 +1,1577 @@
+/****************************************************************************
+ * drivers/mtd/ftl_log.c
+ *
+ *   Copyright (C) 2014 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <sys/ioctl.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <semaphore.h>
+#include <assert.h>
+#include <debug.h>
+#include <errno.h>
+
+#include <nuttx/kmalloc.h>
+#include <nuttx/clock.h>
+#include <nuttx/wqueue.h>
+#include <nuttx/fs/fs.h>
+#include <nuttx/fs/ioctl.h>
+#include <nuttx/mtd/mtd.h>
+#include <nuttx/rwbuffer.h>
+
+/****************************************************************************
+ * Private Definitions
+ ****************************************************************************/
+
+/* Configuration ************************************************************/
+
+#if defined(CONFIG_FS_READAHEAD) || defined(CONFIG_FS_WRITEBUFFER)
+#  define CONFIG_FTL_RWBUFFER 1
+#endif
+
+/* Garbage collection runs before a new erase block is used for host data
+ * if fewer than FTL_GCRESERVE erase blocks are free.  This keeps at least
+ * one free erase block on the media even if power is lost while garbage
+ * collecting.  The spare erase blocks beyond the reserve hold the stale
+ * data that garbage collection needs to make progress.
+ */
+
+#define FTL_GCRESERVE 3
+#define FTL_MINSPARE  (FTL_GCRESERVE + 2)
+
+#ifndef CONFIG_FTL_LOG_OVERPROVISION
+#  define CONFIG_FTL_LOG_OVERPROVISION 10
+#endif
+
+#if CONFIG_FTL_LOG_OVERPROVISION > 50
+#  error "CONFIG_FTL_LOG_OVERPROVISION must not exceed 50 (percent)"
+#endif
+
+#ifndef CONFIG_FTL_LOG_WEARLEVEL
+#  define CONFIG_FTL_LOG_WEARLEVEL 16
+#endif
+
+#ifdef CONFIG_FTL_LOG_BGGC
+#  ifndef CONFIG_SCHED_WORKQUEUE
+#    error "Worker thread support is required (CONFIG_SCHED_WORKQUEUE)"
+#  endif
+#  ifndef CONFIG_FTL_LOG_GCDELAY
+#    define CONFIG_FTL_LOG_GCDELAY 500
+#  endif
+#endif
+
+/* On-media format **********************************************************/
+/* The first R/W block(s) of each erase block hold the erase block header.
+ * The remaining R/W blocks are data slots.  The header is an array of
+ * 32-bit words:
+ *
+ *   [0]      Magic number.  Written when the erase block is erased.
+ *   [1]      Erase count.  Written when the erase block is erased.
+ *   [2]      Sequence number.  Written when the erase block is opened for
+ *            writing; erased while the erase block is free.
+ *   [3...]   The logical sector held in each data slot.  Written after the
+ *            data slot has been written; erased while the slot is unused.
+ *
+ * Each field is programmed only once after an erase, so the header is
+ * updated by re-programming header R/W blocks with more of their erased
+ * bits cleared, as NOR FLASH permits.  The newest copy of a logical sector
+ * is the one in the erase block with the highest sequence number and, in
+ * that erase block, in the highest data slot.  Old copies are never marked
+ * on the media; they are identified when the media is scanned.
+ */
+
+#define FTL_LOG_MAGIC       0x4c54464c  /* "LFTL" */
+#define FTL_ERASED32        0xffffffff
+
+#define FTL_HDR_MAGIC       0           /* Word index of the magic number */
+#define FTL_HDR_ERASECOUNT  1           /* Word index of the erase count */
+#define FTL_HDR_SEQNO       2           /* Word index of the sequence number */
+#define FTL_HDR_MAP         3           /* Word index of the first slot entry */
+
+/* In-memory state **********************************************************/
+
+#define FTL_UNMAPPED        0xffffffff  /* Logical sector not yet written */
+
+#define FTL_BLOCK_FREE      0           /* Erased, header written */
+#define FTL_BLOCK_USED      1           /* Holds data, no longer written */
+#define FTL_BLOCK_ACTIVE    2           /* The erase block being written */
+
+/* Convert between erase block/data slot and physical R/W block numbers */
+
+#define FTL_PBLOCK(d,e,s)   ((uint32_t)(e) * (d)->blkper + (d)->hdrblocks + (s))
+#define FTL_EBLOCK(d,p)     ((p) / (d)->blkper)
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct ftl_struct_s
+{
+  FAR struct mtd_dev_s *mtd;        /* Contained MTD interface */
+  struct mtd_geometry_s geo;        /* Device geometry */
+#ifdef CONFIG_FTL_RWBUFFER
+  struct rwbuffer_s     rwb;        /* Read-ahead/write buffer support */
+#endif
+#ifdef CONFIG_FTL_LOG_BGGC
+  struct work_s         work;       /* Background garbage collection */
+#endif
+  sem_t                 exclsem;    /* Exclusive access to the FTL state */
+  uint16_t              blkper;     /* R/W blocks per erase block */
+  uint16_t              hdrblocks;  /* R/W blocks per erase block header */
+  uint16_t              nslots;     /* Data slots per erase block */
+  uint16_t              nextslot;   /* Next unused slot in the active block */
+  uint16_t              dirtyslot;  /* First slot entry not yet written */
+  int32_t               active;     /* Active erase block (-1: none) */
+#ifdef CONFIG_FTL_LOG_BGGC
+  uint32_t              gcfree;     /* Background garbage collection target */
+#endif
+  uint32_t              nsectors;   /* Number of logical sectors */
+  uint32_t              nfree;      /* Number of free erase blocks */
+  uint32_t              seqno;      /* Next erase block sequence number */
+  FAR uint32_t         *l2p;        /* Logical sector -> physical R/W block */
+  FAR uint32_t         *erasecount; /* Erase count of each erase block */
+  FAR uint32_t         *blkseq;     /* Sequence number of each erase block */
+  FAR uint16_t         *nvalid;     /* Valid data slots in each erase block */
+  FAR uint8_t          *state;      /* State of each erase block */
+  FAR uint32_t         *hdr;        /* Header of the active erase block */
+  FAR uint32_t         *vhdr;       /* Header of an erase block being read */
+  FAR uint8_t          *buffer;     /* One R/W block buffer */
+};
+
+/* Used to replay the erase blocks in sequence order when mounting */
+
+struct ftl_seqblock_s
+{
+  uint32_t seqno;                   /* Sequence number of the erase block */
+  uint32_t eblock;                  /* The erase block number */
+};
+
+/****************************************************************************
+ * Private Function Prototypes
+ ****************************************************************************/
+
+static int     ftl_open(FAR struct inode *inode);
+static int     ftl_close(FAR struct inode *inode);
+static ssize_t ftl_reload(FAR void *priv, FAR uint8_t *buffer,
+                 off_t startblock, size_t nblocks);
+static ssize_t ftl_read(FAR struct inode *inode, unsigned char *buffer,
+                 size_t start_sector, unsigned int nsectors);
+static ssize_t ftl_flush(FAR void *priv, FAR const uint8_t *buffer,
+                 off_t startblock, size_t nblocks);
+static ssize_t ftl_write(FAR struct inode *inode, const unsigned char *buffer,
+                 size_t start_sector, unsigned int nsectors);
+static int     ftl_geometry(FAR struct inode *inode, struct geometry *geometry);
+static int     ftl_ioctl(FAR struct inode *inode, int cmd, unsigned long arg);
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static const struct block_operations g_bops =
+{
+  ftl_open,     /* open     */
+  ftl_close,    /* close    */
+  ftl_read,     /* read     */
+  ftl_write,    /* write    */
+  ftl_geometry, /* geometry */
+  ftl_ioctl     /* ioctl    */
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: ftl_semtake
+ ****************************************************************************/
+
+static void ftl_semtake(FAR struct ftl_struct_s *dev)
+{
+  /* Take the semaphore (perhaps waiting) */
+
+  while (sem_wait(&dev->exclsem) != 0)
+    {
+      /* The only case that an error should occur here is if the wait was
+       * awakened by a signal.
+       */
+
+      ASSERT(errno == EINTR);
+    }
+}
+
+#define ftl_semgive(d) sem_post(&(d)->exclsem)
+
+/****************************************************************************
+ * Name: ftl_readheader
+ *
+ * Description:
+ *   Read the complete header of an erase block.
+ *
+ ****************************************************************************/
+
+static int ftl_readheader(FAR struct ftl_struct_s *dev, uint32_t eblock,
+                          FAR uint32_t *hdr)
+{
+  ssize_t nxfrd;
+
+  nxfrd = MTD_BREAD(dev->mtd, eblock * dev->blkper, dev->hdrblocks,
+                    (FAR uint8_t *)hdr);
+  if (nxfrd != dev->hdrblocks)
+    {
+      fdbg("Read header of erase block %d failed: %d\n", eblock, nxfrd);
+      return -EIO;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: ftl_eraseblock
+ *
+ * Description:
+ *   Erase one erase block and write its header.  The erase block becomes
+ *   free.
+ *
+ ****************************************************************************/
+
+static int ftl_eraseblock(FAR struct ftl_struct_s *dev, uint32_t eblock)
+{
+  FAR uint32_t *hdr = (FAR uint32_t *)dev->buffer;
+  ssize_t nxfrd;
+  int ret;
+
+  ret = MTD_ERASE(dev->mtd, eblock, 1);
+  if (ret < 0)
+    {
+      fdbg("Erase block=%d failed: %d\n", eblock, ret);
+      return ret;
+    }
+
+  dev->erasecount[eblock]++;
+
+  memset(hdr, 0xff, dev->geo.blocksize);
+  hdr[FTL_HDR_MAGIC]      = FTL_LOG_MAGIC;
+  hdr[FTL_HDR_ERASECOUNT] = dev->erasecount[eblock];
+
+  nxfrd = MTD_BWRITE(dev->mtd, eblock * dev->blkper, 1, dev->buffer);
+  if (nxfrd != 1)
+    {
+      fdbg("Write header of erase block %d failed: %d\n", eblock, nxfrd);
+      return -EIO;
+    }
+
+  dev->state[eblock]  = FTL_BLOCK_FREE;
+  dev->nvalid[eblock] = 0;
+  dev->nfree++;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: ftl_flushheader
+ *
+ * Description:
+ *   Write the header R/W blocks of the active erase block that hold new
+ *   slot entries.
+ *
+ ****************************************************************************/
+
+static int ftl_flushheader(FAR struct ftl_struct_s *dev)
+{
+  FAR const uint8_t *hdr = (FAR const uint8_t *)dev->hdr;
+  size_t  first;
+  size_t  last;
+  ssize_t nxfrd;
+
+  if (dev->active >= 0 && dev->dirtyslot < dev->nextslot)
+    {
+      first = (FTL_HDR_MAP + dev->dirtyslot) * sizeof(uint32_t) /
+              dev->geo.blocksize;
+      last  = (FTL_HDR_MAP + dev->nextslot - 1) * sizeof(uint32_t) /
+              dev->geo.blocksize;
+
+      nxfrd = MTD_BWRITE(dev->mtd, dev->active * dev->blkper + first,
+                         last - first + 1, &hdr[first * dev->geo.blocksize]);
+      if (nxfrd != last - first + 1)
+        {
+          fdbg("Write header of erase block %d failed: %d\n",
+               dev->active, nxfrd);
+          return -EIO;
+        }
+
+      dev->dirtyslot = dev->nextslot;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: ftl_openblock
+ *
+ * Description:
+ *   Select the free erase block with the lowest erase count as the new
+ *   active erase block (dynamic wear leveling) and write its sequence
+ *   number.
+ *
+ ****************************************************************************/
+
+static int ftl_openblock(FAR struct ftl_struct_s *dev)
+{
+  uint32_t eblock;
+  int32_t  best = -1;
+  ssize_t  nxfrd;
+
+  DEBUGASSERT(dev->active < 0);
+
+  for (eblock = 0; eblock < dev->geo.neraseblocks; eblock++)
+    {
+      if (dev->state[eblock] == FTL_BLOCK_FREE &&
+          (best < 0 || dev->erasecount[eblock] < dev->erasecount[best]))
+        {
+          best = eblock;
+        }
+    }
+
+  if (best < 0)
+    {
+      fdbg("No free erase block\n");
+      return -ENOSPC;
+    }
+
+  memset(dev->hdr, 0xff, dev->hdrblocks * dev->geo.blocksize);
+  dev->hdr[FTL_HDR_MAGIC]      = FTL_LOG_MAGIC;
+  dev->hdr[FTL_HDR_ERASECOUNT] = dev->erasecount[best];
+  dev->hdr[FTL_HDR_SEQNO]      = dev->seqno;
+
+  /* Once the erase block is no longer free it must not be selected again,
+   * even if its sequence number cannot be written.
+   */
+
+  dev->state[best]  = FTL_BLOCK_ACTIVE;
+  dev->blkseq[best] = dev->seqno++;
+  dev->nfree--;
+  dev->active       = best;
+  dev->nextslot     = 0;
+  dev->dirtyslot    = 0;
+
+  nxfrd = MTD_BWRITE(dev->mtd, best * dev->blkper, 1,
+                     (FAR const uint8_t *)dev->hdr);
+  if (nxfrd != 1)
+    {
+      fdbg("Write header of erase block %d failed: %d\n", best, nxfrd);
+      return -EIO;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: ftl_closeblock
+ *
+ * Description:
+ *   Stop writing to the active erase block.
+ *
+ ****************************************************************************/
+
+static int ftl_closeblock(FAR struct ftl_struct_s *dev)
+{
+  int ret;
+
+  if (dev->active >= 0)
+    {
+      ret = ftl_flushheader(dev);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      dev->state[dev->active] = FTL_BLOCK_USED;
+      dev->active = -1;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: ftl_append
+ *
+ * Description:
+ *   Write logical sectors to the next unused data slots of the active
+ *   erase block, opening new active erase blocks as needed, and update
+ *   the map.  The header of the active erase block is not written; the
+ *   caller must use ftl_flushheader() to make the new copies durable.
+ *
+ ****************************************************************************/
+
+static int ftl_append(FAR struct ftl_struct_s *dev, uint32_t lsector,
+                      FAR const uint8_t *buffer, size_t nsectors)
+{
+  uint32_t pblock;
+  uint32_t old;
+  ssize_t  nxfrd;
+  size_t   nxfr;
+  size_t   i;
+  int      ret;
+
+  while (nsectors > 0)
+    {
+      /* Is there an active erase block with unused slots? */
+
+      if (dev->active < 0 || dev->nextslot >= dev->nslots)
+        {
+          ret = ftl_closeblock(dev);
+          if (ret < 0)
+            {
+              return ret;
+            }
+
+          ret = ftl_openblock(dev);
+          if (ret < 0)
+            {
+              return ret;
+            }
+        }
+
+      /* Write as many sectors as will fit in the active erase block with
+       * one transfer.
+       */
+
+      nxfr = dev->nslots - dev->nextslot;
+      if (nxfr > nsectors)
+        {
+          nxfr = nsectors;
+        }
+
+      pblock = FTL_PBLOCK(dev, dev->active, dev->nextslot);
+      nxfrd  = MTD_BWRITE(dev->mtd, pblock, nxfr, buffer);
+      if (nxfrd != nxfr)
+        {
+          fdbg("Write %d blocks at block %d failed: %d\n",
+               nxfr, pblock, nxfrd);
+          return -EIO;
+        }
+
+      /* Record the new locations.  The old copies become stale. */
+
+      for (i = 0; i < nxfr; i++)
+        {
+          dev->hdr[FTL_HDR_MAP + dev->nextslot + i] = lsector + i;
+
+          old = dev->l2p[lsector + i];
+          if (old != FTL_UNMAPPED)
+            {
+              dev->nvalid[FTL_EBLOCK(dev, old)]--;
+            }
+
+          dev->l2p[lsector + i] = pblock + i;
+          dev->nvalid[dev->active]++;
+        }
+
+      dev->nextslot += nxfr;
+
+      lsector  += nxfr;
+      buffer   += nxfr * dev->geo.blocksize;
+      nsectors -= nxfr;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: ftl_victim
+ *
+ * Description:
+ *   Select the erase block to be reclaimed next.  An erase block without
+ *   valid data costs nothing to reclaim and is selected at once.  Otherwise
+ *   the cost-benefit policy is used:  The free space gained, weighted by
+ *   the age of the data (older data is less likely to become stale soon),
+ *   relative to the cost of reading and writing the valid data.
+ *
+ *   Only erase blocks with no more than 'maxvalid' valid data slots are
+ *   considered.
+ *
+ * Returned Value:
+ *   The erase block number or -1 if there is nothing to be gained.
+ *
+ ****************************************************************************/
+
+static int32_t ftl_victim(FAR struct ftl_struct_s *dev, uint32_t maxvalid)
+{
+  uint64_t score;
+  uint64_t bestscore = 0;
+  uint32_t eblock;
+  uint32_t stale;
+  uint32_t age;
+  int32_t  best = -1;
+
+  for (eblock = 0; eblock < dev->geo.neraseblocks; eblock++)
+    {
+      if (dev->state[eblock] != FTL_BLOCK_USED)
+        {
+          continue;
+        }
+
+      stale = dev->nslots - dev->nvalid[eblock];
+      if (stale == 0 || dev->nvalid[eblock] > maxvalid)
+        {
+          continue;
+        }
+      else if (dev->nvalid[eblock] == 0)
+        {
+          return eblock;
+        }
+
+      age   = dev->seqno - dev->blkseq[eblock];
+      score = ((uint64_t)stale * age << 8) / (2 * dev->nvalid[eblock]);
+
+      if (best < 0 || score > bestscore ||
+          (score == bestscore &&
+           dev->erasecount[eblock] < dev->erasecount[best]))
+        {
+          bestscore = score;
+          best      = eblock;
+        }
+    }
+
+  return best;
+}
+
+/****************************************************************************
+ * Name: ftl_coldest
+ *
+ * Description:
+ *   Garbage collection alone never erases an erase block that holds only
+ *   static data.  If the erase counts have drifted too far apart, select
+ *   the least worn erase block that holds data so that its (cold) data can
+ *   be moved and the erase block put back into use (static wear leveling).
+ *
+ * Returned Value:
+ *   The erase block number or -1 if wear leveling is not needed.
+ *
+ ****************************************************************************/
+
+#if CONFIG_FTL_LOG_WEARLEVEL > 0
+static int32_t ftl_coldest(FAR struct ftl_struct_s *dev)
+{
+  uint32_t eblock;
+  uint32_t maxcount = 0;
+  int32_t  coldest  = -1;
+
+  for (eblock = 0; eblock < dev->geo.neraseblocks; eblock++)
+    {
+      if (dev->erasecount[eblock] > maxcount)
+        {
+          maxcount = dev->erasecount[eblock];
+        }
+
+      if (dev->state[eblock] == FTL_BLOCK_USED &&
+          (coldest < 0 ||
+           dev->erasecount[eblock] < dev->erasecount[coldest]))
+        {
+          coldest = eblock;
+        }
+    }
+
+  if (coldest >= 0 &&
+      maxcount - dev->erasecount[coldest] > CONFIG_FTL_LOG_WEARLEVEL)
+    {
+      return coldest;
+    }
+
+  return -1;
+}
+#endif
+
+/****************************************************************************
+ * Name: ftl_collect
+ *
+ * Description:
+ *   Move the valid data of an erase block to the active erase block and
+ *   erase it.
+ *
+ ****************************************************************************/
+
+static int ftl_collect(FAR struct ftl_struct_s *dev, uint32_t eblock)
+{
+  uint32_t lsector;
+  uint32_t pblock;
+  ssize_t  nxfrd;
+  uint16_t slot;
+  int      ret;
+
+  fvdbg("Collecting erase block %d: %d valid slots\n",
+        eblock, dev->nvalid[eblock]);
+
+  /* Read the header to find out which logical sectors the slots hold */
+
+  ret = ftl_readheader(dev, eblock, dev->vhdr);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  for (slot = 0; slot < dev->nslots && dev->nvalid[eblock] > 0; slot++)
+    {
+      /* Only the current copy of a logical sector has to be moved */
+
+      lsector = dev->vhdr[FTL_HDR_MAP + slot];
+      pblock  = FTL_PBLOCK(dev, eblock, slot);
+
+      if (lsector >= dev->nsectors || dev->l2p[lsector] != pblock)
+        {
+          continue;
+        }
+
+      nxfrd = MTD_BREAD(dev->mtd, pblock, 1, dev->buffer);
+      if (nxfrd != 1)
+        {
+          fdbg("Read block %d failed: %d\n", pblock, nxfrd);
+          return -EIO;
+        }
+
+      ret = ftl_append(dev, lsector, dev->buffer, 1);
+      if (ret < 0)
+        {
+          return ret;
+        }
+    }
+
+  /* The new copies must be durable before the old ones are erased */
+
+  ret = ftl_flushheader(dev);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  return ftl_eraseblock(dev, eblock);
+}
+
+/****************************************************************************
+ * Name: ftl_reclaim
+ *
+ * Description:
+ *   Garbage collect erase blocks until there are at least 'nfree' free
+ *   erase blocks.  Collecting an erase block with stale data uses at most
+ *   one free erase block and frees one, so this always makes progress as
+ *   long as one free erase block remains.
+ *
+ ****************************************************************************/
+
+static int ftl_reclaim(FAR struct ftl_struct_s *dev, uint32_t nfree)
+{
+  uint32_t maxloops = 2 * dev->geo.neraseblocks;
+  uint32_t maxvalid;
+  int32_t  victim;
+  int      ret;
+
+  while (dev->nfree < nfree)
+    {
+      /* If power was lost while garbage collecting, there might be no free
+       * erase block left.  Then the valid data must fit into the unused
+       * slots of the active erase block.
+       */
+
+      maxvalid = dev->nslots - 1;
+      if (dev->nfree == 0)
+        {
+          maxvalid = dev->active < 0 ? 0 : dev->nslots - dev->nextslot;
+        }
+
+      victim = ftl_victim(dev, maxvalid);
+      if (victim < 0 || maxloops-- == 0)
+        {
+          /* Nothing left to reclaim.  This is only an error if there is
+           * no free erase block left at all.
+           */
+
+          return dev->nfree > 0 ? OK : -ENOSPC;
+        }
+
+      ret = ftl_collect(dev, victim);
+      if (ret < 0)
+        {
+          return ret;
+        }
+    }
+
+#if CONFIG_FTL_LOG_WEARLEVEL > 0
+  /* There is room to move one erase block full of valid data.  Use it to
+   * level the wear if necessary.
+   */
+
+  victim = ftl_coldest(dev);
+  if (victim >= 0)
+    {
+      fvdbg("Wear leveling erase block %d\n", victim);
+      return ftl_collect(dev, victim);
+    }
+#endif
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: ftl_gcworker
+ *
+ * Description:
+ *   Background garbage collection.  Reclaims one erase block at a time
+ *   (so that the FTL is not locked for long) until the free erase block
+ *   target is met.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FTL_LOG_BGGC
+static void ftl_gcworker(FAR void *arg)
+{
+  FAR struct ftl_struct_s *dev = (FAR struct ftl_struct_s *)arg;
+  int32_t victim;
+  bool more = false;
+
+  ftl_semtake(dev);
+  if (dev->nfree > 0 && dev->nfree < dev->gcfree)
+    {
+      victim = ftl_victim(dev, dev->nslots - 1);
+      if (victim >= 0 && ftl_collect(dev, victim) >= 0)
+        {
+          more = dev->nfree < dev->gcfree;
+        }
+    }
+
+  /* Continue later unless a write has already re-scheduled the work */
+
+  if (more && work_available(&dev->work))
+    {
+      (void)work_queue(LPWORK, &dev->work, ftl_gcworker, dev, 0);
+    }
+
+  ftl_semgive(dev);
+}
+#endif
+
+/****************************************************************************
+ * Name: ftl_resume
+ *
+ * Description:
+ *   Make the newest erase block the active erase block again.  Slots after
+ *   the last slot entry in its header might have been written when power
+ *   was lost, so writing resumes after the last slot that is not erased.
+ *
+ ****************************************************************************/
+
+static int ftl_resume(FAR struct ftl_struct_s *dev, uint32_t eblock)
+{
+  uint32_t pblock;
+  ssize_t  nxfrd;
+  size_t   i;
+  int      slot;
+  int      ret;
+
+  ret = ftl_readheader(dev, eblock, dev->hdr);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  for (slot = dev->nslots - 1; slot >= 0; slot--)
+    {
+      if (dev->hdr[FTL_HDR_MAP + slot] != FTL_ERASED32)
+        {
+          break;
+        }
+
+      pblock = FTL_PBLOCK(dev, eblock, slot);
+      nxfrd  = MTD_BREAD(dev->mtd, pblock, 1, dev->buffer);
+      if (nxfrd != 1)
+        {
+          fdbg("Read block %d failed: %d\n", pblock, nxfrd);
+          return -EIO;
+        }
+
+      for (i = 0; i < dev->geo.blocksize && dev->buffer[i] == 0xff; i++);
+      if (i < dev->geo.blocksize)
+        {
+          break;
+        }
+    }
+
+  if (slot + 1 < dev->nslots)
+    {
+      dev->state[eblock] = FTL_BLOCK_ACTIVE;
+      dev->active        = eblock;
+      dev->nextslot      = slot + 1;
+      dev->dirtyslot     = slot + 1;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: ftl_mount
+ *
+ * Description:
+ *   Scan the erase block headers and rebuild the map.  Erase blocks
+ *   without a valid header are erased.
+ *
+ ****************************************************************************/
+
+static int ftl_mount(FAR struct ftl_struct_s *dev)
+{
+  FAR struct ftl_seqblock_s *seqblocks;
+  struct ftl_seqblock_s tmp;
+  uint32_t neraseblocks = dev->geo.neraseblocks;
+  uint32_t nused = 0;
+  uint32_t nbad  = 0;
+  uint64_t total = 0;
+  uint32_t eblock;
+  uint32_t lsector;
+  uint32_t old;
+  uint32_t i;
+  uint32_t j;
+  uint16_t slot;
+  ssize_t  nxfrd;
+  int      ret = OK;
+
+  seqblocks = (FAR struct ftl_seqblock_s *)
+    kmalloc(neraseblocks * sizeof(struct ftl_seqblock_s));
+  if (!seqblocks)
+    {
+      return -ENOMEM;
+    }
+
+  memset(dev->l2p, 0xff, dev->nsectors * sizeof(uint32_t));
+  dev->nfree  = 0;
+  dev->seqno  = 0;
+  dev->active = -1;
+
+  /* Classify each erase block by the first R/W block of its header */
+
+  for (eblock = 0; eblock < neraseblocks; eblock++)
+    {
+      dev->nvalid[eblock] = 0;
+
+      nxfrd = MTD_BREAD(dev->mtd, eblock * dev->blkper, 1,
+                        (FAR uint8_t *)dev->vhdr);
+      if (nxfrd != 1 || dev->vhdr[FTL_HDR_MAGIC] != FTL_LOG_MAGIC)
+        {
+          /* Unformatted or interrupted while being erased */
+
+          dev->state[eblock]      = FTL_BLOCK_USED;
+          dev->erasecount[eblock] = FTL_ERASED32;
+          nbad++;
+          continue;
+        }
+
+      dev->erasecount[eblock] = dev->vhdr[FTL_HDR_ERASECOUNT];
+      total += dev->erasecount[eblock];
+
+      if (dev->vhdr[FTL_HDR_SEQNO] == FTL_ERASED32)
+        {
+          dev->state[eblock] = FTL_BLOCK_FREE;
+          dev->nfree++;
+        }
+      else
+        {
+          dev->state[eblock]      = FTL_BLOCK_USED;
+          dev->blkseq[eblock]     = dev->vhdr[FTL_HDR_SEQNO];
+          seqblocks[nused].seqno  = dev->vhdr[FTL_HDR_SEQNO];
+          seqblocks[nused].eblock = eblock;
+          nused++;
+
+          if (dev->vhdr[FTL_HDR_SEQNO] >= dev->seqno)
+            {
+              dev->seqno = dev->vhdr[FTL_HDR_SEQNO] + 1;
+            }
+        }
+    }
+
+  /* Sort the erase blocks that hold data into sequence order (insertion
+   * sort:  the list is nearly sorted in the common case).
+   */
+
+  for (i = 1; i < nused; i++)
+    {
+      tmp = seqblocks[i];
+      for (j = i; j > 0 && seqblocks[j - 1].seqno > tmp.seqno; j--)
+        {
+          seqblocks[j] = seqblocks[j - 1];
+        }
+
+      seqblocks[j] = tmp;
+    }
+
+  /* Replay the slot entries.  Later copies replace earlier ones. */
+
+  for (i = 0; i < nused; i++)
+    {
+      eblock = seqblocks[i].eblock;
+      ret    = ftl_readheader(dev, eblock, dev->vhdr);
+      if (ret < 0)
+        {
+          goto errout;
+        }
+
+      for (slot = 0; slot < dev->nslots; slot++)
+        {
+          lsector = dev->vhdr[FTL_HDR_MAP + slot];
+          if (lsector >= dev->nsectors)
+            {
+              continue;
+            }
+
+          old = dev->l2p[lsector];
+          if (old != FTL_UNMAPPED)
+            {
+              dev->nvalid[FTL_EBLOCK(dev, old)]--;
+            }
+
+          dev->l2p[lsector] = FTL_PBLOCK(dev, eblock, slot);
+          dev->nvalid[eblock]++;
+        }
+    }
+
+  /* Format the erase blocks without a valid header.  Their erase count is
+   * not known, so use the average of the others.
+   */
+
+  if (nbad > 0)
+    {
+      fvdbg("Formatting %d erase blocks\n", nbad);
+
+      for (eblock = 0; eblock < neraseblocks; eblock++)
+        {
+          if (dev->erasecount[eblock] == FTL_ERASED32)
+            {
+              dev->erasecount[eblock] = nbad < neraseblocks ?
+                (uint32_t)(total / (neraseblocks - nbad)) : 0;
+
+              ret = ftl_eraseblock(dev, eblock);
+              if (ret < 0)
+                {
+                  goto errout;
+                }
+            }
+        }
+    }
+
+  /* Resume writing in the newest erase block so that its unused slots are
+   * not lost.  Garbage collection might depend on them.
+   */
+
+  if (nused > 0)
+    {
+      ret = ftl_resume(dev, seqblocks[nused - 1].eblock);
+      if (ret < 0)
+        {
+          goto errout;
+        }
+    }
+
+  /* Complete garbage collection that was interrupted by a loss of power */
+
+  if (dev->nfree < FTL_GCRESERVE)
+    {
+      ret = ftl_reclaim(dev, FTL_GCRESERVE);
+      if (ret < 0)
+        {
+          goto errout;
+        }
+    }
+
+  fvdbg("%d erase blocks: %d free, %d used, next sequence %d\n",
+        neraseblocks, dev->nfree, nused, dev->seqno);
+
+errout:
+  kfree(seqblocks);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: ftl_open
+ *
+ * Description: Open the block device
+ *
+ ****************************************************************************/
+
+static int ftl_open(FAR struct inode *inode)
+{
+  fvdbg("Entry\n");
+  return OK;
+}
+
+/****************************************************************************
+ * Name: ftl_close
+ *
+ * Description: close the block device
+ *
+ ****************************************************************************/
+
+static int ftl_close(FAR struct inode *inode)
+{
+  fvdbg("Entry\n");
+  return OK;
+}
+
+/****************************************************************************
+ * Name: ftl_reload
+ *
+ * Description:  Read the specified numer of sectors
+ *
+ ****************************************************************************/
+
+static ssize_t ftl_reload(FAR void *priv, FAR uint8_t *buffer,
+                          off_t startblock, size_t nblocks)
+{
+  struct ftl_struct_s *dev = (struct ftl_struct_s *)priv;
+  uint32_t pblock;
+  ssize_t  nxfrd;
+  size_t   remaining;
+  size_t   nxfr;
+
+  if (startblock + nblocks > dev->nsectors)
+    {
+      return -EINVAL;
+    }
+
+  ftl_semtake(dev);
+  for (remaining = nblocks; remaining > 0; remaining -= nxfr)
+    {
+      pblock = dev->l2p[startblock];
+      if (pblock == FTL_UNMAPPED)
+        {
+          /* Never written:  Return erased data */
+
+          memset(buffer, 0xff, dev->geo.blocksize);
+          nxfr = 1;
+        }
+      else
+        {
+          /* Read as many physically contiguous sectors as possible with
+           * one transfer.
+           */
+
+          for (nxfr = 1;
+               nxfr < remaining &&
+               dev->l2p[startblock + nxfr] == pblock + nxfr &&
+               FTL_EBLOCK(dev, pblock + nxfr) == FTL_EBLOCK(dev, pblock);
+               nxfr++);
+
+          nxfrd = MTD_BREAD(dev->mtd, pblock, nxfr, buffer);
+          if (nxfrd != nxfr)
+            {
+              fdbg("Read %d blocks starting at block %d failed: %d\n",
+                   nxfr, pblock, nxfrd);
+              ftl_semgive(dev);
+              return -EIO;
+            }
+        }
+
+      startblock += nxfr;
+      buffer     += nxfr * dev->geo.blocksize;
+    }
+
+  ftl_semgive(dev);
+  return nblocks;
+}
+
+/****************************************************************************
+ * Name: ftl_read
+ *
+ * Description:  Read the specified numer of sectors
+ *
+ ****************************************************************************/
+
+static ssize_t ftl_read(FAR struct inode *inode, unsigned char *buffer,
+                        size_t start_sector, unsigned int nsectors)
+{
+  struct ftl_struct_s *dev;
+
+  fvdbg("sector: %d nsectors: %d\n", start_sector, nsectors);
+
+  DEBUGASSERT(inode && inode->i_private);
+  dev = (struct ftl_struct_s *)inode->i_private;
+#ifdef CONFIG_FTL_RWBUFFER
+  return rwb_read(&dev->rwb, start_sector, nsectors, buffer);
+#else
+  return ftl_reload(dev, buffer, start_sector, nsectors);
+#endif
+}
+
+/****************************************************************************
+ * Name: ftl_flush
+ *
+ * Description:
+ *   Write the specified number of sectors out-of-place to the log.
+ *
+ ****************************************************************************/
+
+static ssize_t ftl_flush(FAR void *priv, FAR const uint8_t *buffer,
+                         off_t startblock, size_t nblocks)
+{
+  struct ftl_struct_s *dev = (struct ftl_struct_s *)priv;
+  size_t remaining;
+  size_t nxfr;
+  int    ret = OK;
+
+  if (startblock + nblocks > dev->nsectors)
+    {
+      return -EINVAL;
+    }
+
+  ftl_semtake(dev);
+  for (remaining = nblocks; remaining > 0 && ret >= 0; remaining -= nxfr)
+    {
+      /* Before starting a new erase block, make sure that enough free
+       * erase blocks remain for garbage collection to make progress.
+       */
+
+      if (dev->active < 0 || dev->nextslot >= dev->nslots)
+        {
+          ret = ftl_closeblock(dev);
+          if (ret >= 0)
+            {
+              ret = ftl_reclaim(dev, FTL_GCRESERVE);
+            }
+
+          if (ret < 0)
+            {
+              break;
+            }
+
+          /* Garbage collection may have left a partially used active
+           * erase block.
+           */
+
+          if (dev->active >= 0 && dev->nextslot >= dev->nslots)
+            {
+              ret = ftl_closeblock(dev);
+              if (ret < 0)
+                {
+                  break;
+                }
+            }
+
+          if (dev->active < 0)
+            {
+              ret = ftl_openblock(dev);
+              if (ret < 0)
+                {
+                  break;
+                }
+            }
+        }
+
+      /* Write up to the end of the active erase block */
+
+      nxfr = dev->nslots - dev->nextslot;
+      if (nxfr > remaining)
+        {
+          nxfr = remaining;
+        }
+
+      ret = ftl_append(dev, startblock, buffer, nxfr);
+
+      startblock += nxfr;
+      buffer     += nxfr * dev->geo.blocksize;
+    }
+
+  /* The write is complete when the header entries are on the media */
+
+  if (ret >= 0)
+    {
+      ret = ftl_flushheader(dev);
+    }
+
+#ifdef CONFIG_FTL_LOG_BGGC
+  /* Restart the background garbage collection delay.  This is done with
+   * the FTL locked so that it cannot race with the worker re-queuing
+   * itself.
+   */
+
+  (void)work_cancel(LPWORK, &dev->work);
+  (void)work_queue(LPWORK, &dev->work, ftl_gcworker, dev,
+                   MSEC2TICK(CONFIG_FTL_LOG_GCDELAY));
+#endif
+
+  ftl_semgive(dev);
+
+  if (ret < 0)
+    {
+      fdbg("Write %d sectors failed: %d\n", nblocks, ret);
+      return ret;
+    }
+
+  return nblocks;
+}
+
+/****************************************************************************
+ * Name: ftl_write
+ *
+ * Description: Write (or buffer) the specified number of sectors
+ *
+ ****************************************************************************/
+
+static ssize_t ftl_write(FAR struct inode *inode, const unsigned char *buffer,
+                        size_t start_sector, unsigned int nsectors)
+{
+  struct ftl_struct_s *dev;
+
+  fvdbg("sector: %d nsectors: %d\n", start_sector, nsectors);
+
+  DEBUGASSERT(inode && inode->i_private);
+  dev = (struct ftl_struct_s *)inode->i_private;
+#ifdef CONFIG_FTL_RWBUFFER
+  return rwb_write(&dev->rwb, start_sector, nsectors, buffer);
+#else
+  return ftl_flush(dev, buffer, start_sector, nsectors);
+#endif
+}
+
+/****************************************************************************
+ * Name: ftl_geometry
+ *
+ * Description: Return device geometry
+ *
+ ****************************************************************************/
+
+static int ftl_geometry(FAR struct inode *inode, struct geometry *geometry)
+{
+  struct ftl_struct_s *dev;
+
+  fvdbg("Entry\n");
+
+  DEBUGASSERT(inode);
+  if (geometry)
+    {
+      dev = (struct ftl_struct_s *)inode->i_private;
+      geometry->geo_available     = true;
+      geometry->geo_mediachanged  = false;
+      geometry->geo_writeenabled  = true;
+      geometry->geo_nsectors      = dev->nsectors;
+      geometry->geo_sectorsize    = dev->geo.blocksize;
+
+      fvdbg("available: true mediachanged: false writeenabled: true\n");
+      fvdbg("nsectors: %d sectorsize: %d\n",
+            geometry->geo_nsectors, geometry->geo_sectorsize);
+
+      return OK;
+    }
+
+  return -EINVAL;
+}
+
+/****************************************************************************
+ * Name: ftl_ioctl
+ *
+ * Description: Pass ioctl commands through to the MTD driver
+ *
+ ****************************************************************************/
+
+static int ftl_ioctl(FAR struct inode *inode, int cmd, unsigned long arg)
+{
+  struct ftl_struct_s *dev ;
+  int ret;
+
+  fvdbg("Entry\n");
+  DEBUGASSERT(inode && inode->i_private);
+
+  /* Logical sectors are not at fixed locations on the media, so the media
+   * cannot be mapped into memory.  Erasing the media underneath the FTL
+   * would corrupt the map.
+   */
+
+  if (cmd == BIOC_XIPBASE || cmd == MTDIOC_XIPBASE ||
+      cmd == MTDIOC_BULKERASE)
+    {
+      return -ENOTTY;
+    }
+
+  /* Other possible MTD driver ioctl commands are passed through to the MTD
+   * driver (unchanged).
+   */
+
+  dev = (struct ftl_struct_s *)inode->i_private;
+  ret = MTD_IOCTL(dev->mtd, cmd, arg);
+  if (ret < 0)
+    {
+      fdbg("ERROR: MTD ioctl(%04x) failed: %d\n", cmd, ret);
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: ftl_free
+ ****************************************************************************/
+
+static void ftl_free(FAR struct ftl_struct_s *dev)
+{
+  if (dev->l2p)
+    {
+      kfree(dev->l2p);
+    }
+
+  if (dev->erasecount)
+    {
+      kfree(dev->erasecount);
+    }
+
+  if (dev->blkseq)
+    {
+      kfree(dev->blkseq);
+    }
+
+  if (dev->nvalid)
+    {
+      kfree(dev->nvalid);
+    }
+
+  if (dev->state)
+    {
+      kfree(dev->state);
+    }
+
+  if (dev->hdr)
+    {
+      kfree(dev->hdr);
+    }
+
+  if (dev->vhdr)
+    {
+      kfree(dev->vhdr);
+    }
+
+  if (dev->buffer)
+    {
+      kfree(dev->buffer);
+    }
+
+  sem_destroy(&dev->exclsem);
+  kfree(dev);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: ftl_initialize
+ *
+ * Description:
+ *   Initialize to provide a block driver wrapper around an MTD interface.
+ *   This version of the FTL manages the MTD as a log:  Sectors are written
+ *   out-of-place and erase blocks are reclaimed by garbage collection.  The
+ *   MTD is formatted if it does not hold a log yet.
+ *
+ * Input Parameters:
+ *   minor - The minor device number.  The MTD block device will be
+ *      registered as as /dev/mtdblockN where N is the minor number.
+ *   mtd - The MTD device that supports the FLASH interface.
+ *
+ ****************************************************************************/
+
+int ftl_initialize(int minor, FAR struct mtd_dev_s *mtd)
+{
+  struct ftl_struct_s *dev;
+  char devname[16];
+  uint32_t nspare;
+  size_t hdrsize;
+  int ret;
+
+  /* Sanity check */
+
+#ifdef CONFIG_DEBUG
+  if (minor < 0 || minor > 255 || !mtd)
+    {
+      return -EINVAL;
+    }
+#endif
+
+  /* Allocate a FTL device structure */
+
+  dev = (struct ftl_struct_s *)kzalloc(sizeof(struct ftl_struct_s));
+  if (!dev)
+    {
+      return -ENOMEM;
+    }
+
+  /* Initialize the FTL device structure */
+
+  dev->mtd    = mtd;
+  dev->active = -1;
+  sem_init(&dev->exclsem, 0, 1);
+
+  /* Get the device geometry. (casting to uintptr_t first eliminates
+   * complaints on some architectures where the sizeof long is different
+   * from the size of a pointer).
+   */
+
+  ret = MTD_IOCTL(mtd, MTDIOC_GEOMETRY, (unsigned long)((uintptr_t)&dev->geo));
+  if (ret < 0)
+    {
+      fdbg("MTD ioctl(MTDIOC_GEOMETRY) failed: %d\n", ret);
+      goto errout;
+    }
+
+  /* Get the number of R/W blocks per erase block.  The first ones hold
+   * the erase block header, which must be able to describe the others.
+   */
+
+  dev->blkper = dev->geo.erasesize / dev->geo.blocksize;
+  DEBUGASSERT(dev->blkper * dev->geo.blocksize == dev->geo.erasesize);
+
+  for (dev->hdrblocks = 1; dev->hdrblocks < dev->blkper; dev->hdrblocks++)
+    {
+      if ((FTL_HDR_MAP + dev->blkper - dev->hdrblocks) * sizeof(uint32_t) <=
+          dev->hdrblocks * dev->geo.blocksize)
+        {
+          break;
+        }
+    }
+
+  /* Some erase blocks are not exported.  They hold the stale data that
+   * garbage collection reclaims and the free erase blocks that it needs.
+   */
+
+  nspare = dev->geo.neraseblocks * CONFIG_FTL_LOG_OVERPROVISION / 100;
+  if (nspare < FTL_MINSPARE)
+    {
+      nspare = FTL_MINSPARE;
+    }
+
+  if (dev->hdrblocks >= dev->blkper || dev->geo.neraseblocks <= 2 * nspare)
+    {
+      fdbg("MTD geometry not supported\n");
+      ret = -EINVAL;
+      goto errout;
+    }
+
+  dev->nslots   = dev->blkper - dev->hdrblocks;
+  dev->nsectors = (dev->geo.neraseblocks - nspare) * dev->nslots;
+  hdrsize       = dev->hdrblocks * dev->geo.blocksize;
+
+#ifdef CONFIG_FTL_LOG_BGGC
+  /* Background garbage collection keeps half of the spare erase blocks
+   * beyond the reserve free.
+   */
+
+  dev->gcfree   = FTL_GCRESERVE + (nspare - FTL_GCRESERVE) / 2;
+#endif
+
+  /* Allocate the map and the per-erase block state */
+
+  dev->l2p        = (FAR uint32_t *)kmalloc(dev->nsectors * sizeof(uint32_t));
+  dev->erasecount = (FAR uint32_t *)
+    kmalloc(dev->geo.neraseblocks * sizeof(uint32_t));
+  dev->blkseq     = (FAR uint32_t *)
+    kmalloc(dev->geo.neraseblocks * sizeof(uint32_t));
+  dev->nvalid     = (FAR uint16_t *)
+    kmalloc(dev->geo.neraseblocks * sizeof(uint16_t));
+  dev->state      = (FAR uint8_t *)kmalloc(dev->geo.neraseblocks);
+  dev->hdr        = (FAR uint32_t *)kmalloc(hdrsize);
+  dev->vhdr       = (FAR uint32_t *)kmalloc(hdrsize);
+  dev->buffer     = (FAR uint8_t *)kmalloc(dev->geo.blocksize);
+
+  if (!dev->l2p || !dev->erasecount || !dev->blkseq || !dev->nvalid ||
+      !dev->state || !dev->hdr || !dev->vhdr || !dev->buffer)
+    {
+      fdbg("Failed to allocate the FTL state\n");
+      ret = -ENOMEM;
+      goto errout;
+    }
+
+  /* Rebuild the map from the media (formatting it if necessary) */
+
+  ret = ftl_mount(dev);
+  if (ret < 0)
+    {
+      fdbg("Failed to mount the FTL: %d\n", ret);
+      goto errout;
+    }
+
+  /* Configure read-ahead/write buffering */
+
+#ifdef CONFIG_FTL_RWBUFFER
+  dev->rwb.blocksize   = dev->geo.blocksize;
+  dev->rwb.nblocks     = dev->nsectors;
+  dev->rwb.dev         = (FAR void *)dev;
+  dev->rwb.rhreload    = ftl_reload;
+  dev->rwb.wrflush     = ftl_flush;
+
+#ifdef CONFIG_FS_WRITEBUFFER
+  dev->rwb.wrmaxblocks = dev->nslots;
+#endif
+
+#ifdef CONFIG_FS_READAHEAD
+  dev->rwb.rhmaxblocks = dev->nslots;
+#endif
+
+  ret = rwb_initialize(&dev->rwb);
+  if (ret < 0)
+    {
+      fdbg("rwb_initialize failed: %d\n", ret);
+      goto errout;
+    }
+#endif
+
+  /* Create a MTD block device name */
+
+  snprintf(devname, 16, "/dev/mtdblock%d", minor);
+
+  /* Inode private data is a reference to the FTL device structure */
+
+  ret = register_blockdriver(devname, &g_bops, 0, dev);
+  if (ret < 0)
+    {
+      fdbg("register_blockdriver failed: %d\n", -ret);
+#ifdef CONFIG_FTL_RWBUFFER
+      rwb_uninitialize(&dev->rwb);
+#endif
+      goto errout;
+    }
+
+  return OK;
+
+errout:
+  ftl_free(dev);
+  return ret;
+}
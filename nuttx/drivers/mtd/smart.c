@@ -49,10 +49,14 @@
 #include <stdlib.h>
 #include <stddef.h>
 #include <string.h>
+#include <semaphore.h>
+#include <assert.h>
 #include <debug.h>
 #include <errno.h>
 
 #include <nuttx/kmalloc.h>
+#include <nuttx/clock.h>
+#include <nuttx/wqueue.h>
 #include <nuttx/fs/fs.h>
 #include <nuttx/fs/ioctl.h>
 #include <nuttx/mtd/mtd.h>
@@ -66,7 +70,6 @@
 #define SMART_STATUS_RELEASED     0x40
 #define SMART_STATUS_SIZEBITS     0x1C
 #define SMART_STATUS_VERBITS      0x03
-#define SMART_STATUS_VERSION      0x01
 
 #define SMART_SECTSIZE_256        0x00
 #define SMART_SECTSIZE_512        0x04
@@ -93,11 +96,67 @@
 #define SMART_FMT_VERSION_POS     (SMART_FMT_POS1 + 4)
 #define SMART_FMT_NAMESIZE_POS    (SMART_FMT_POS1 + 5)
 #define SMART_FMT_ROOTDIRS_POS    (SMART_FMT_POS1 + 6)
+#define SMART_FMT_WEARBASE_POS    28
 #define SMARTFS_FMT_AGING_POS     32
 
-#define SMART_FMT_VERSION           1
 #define SMART_PARTNAME_SIZE         4
 
+/* Format version 1 uses 16-bit sector numbers.  Version 2 uses 32-bit
+ * sector numbers:  The upper half of the logical sector number follows the
+ * status byte in the sector header so that the status byte (and the
+ * version bits in it) are at the same place in both versions.
+ */
+
+#ifdef CONFIG_SMARTFS_32BIT_SECTORS
+#  define SMART_FMT_VERSION         2
+#  define SMART_STATUS_VERSION      0x02
+#  define SMART_MAX_SECTORS         0xfffffffe
+#else
+#  define SMART_FMT_VERSION         1
+#  define SMART_STATUS_VERSION      0x01
+#  define SMART_MAX_SECTORS         65534
+#endif
+
+/* Get and set the logical sector number in a sector header */
+
+#ifdef CONFIG_SMARTFS_32BIT_SECTORS
+#  define SMART_GETLOGSECTOR(h) \
+     ((uint32_t)*((FAR uint16_t *)(h)->logicalsector) | \
+      (uint32_t)*((FAR uint16_t *)(h)->logicalsector2) << 16)
+#  define SMART_SETLOGSECTOR(h,s) \
+     do \
+       { \
+         *((FAR uint16_t *)(h)->logicalsector)  = (uint16_t)(s); \
+         *((FAR uint16_t *)(h)->logicalsector2) = (uint16_t)((s) >> 16); \
+       } \
+     while (0)
+#else
+#  define SMART_GETLOGSECTOR(h) (*((FAR uint16_t *)(h)->logicalsector))
+#  define SMART_SETLOGSECTOR(h,s) \
+     (*((FAR uint16_t *)(h)->logicalsector) = (uint16_t)(s))
+#endif
+
+/* The erased state of sector numbers and sequence numbers */
+
+#if CONFIG_SMARTFS_ERASEDSTATE == 0xFF
+#  define SMART_ERASEDSECTOR        SMART_SECTOR_NONE
+#  define SMART_ERASEDSEQ           0xFFFF
+#else
+#  define SMART_ERASEDSECTOR        ((smart_sector_t) 0)
+#  define SMART_ERASEDSEQ           0x0000
+#endif
+
+/* The logical to physical sector map is kept in pages of
+ * SMART_MAP_PAGESIZE entries.  A page is allocated when the first logical
+ * sector in it is mapped and freed when the last one is released, so only
+ * the logical sectors in use (which are allocated from the bottom up) take
+ * up RAM.
+ */
+
+#define SMART_MAP_PAGESHIFT         7
+#define SMART_MAP_PAGESIZE          (1 << SMART_MAP_PAGESHIFT)
+#define SMART_MAP_PAGEMASK          (SMART_MAP_PAGESIZE - 1)
+
 #define SMART_FIRST_ALLOC_SECTOR    12      /* First logical sector number we will
                                              * use for assignment of requested Alloc
                                              * sectors.  All enries below this are
@@ -117,6 +176,44 @@
 #define offsetof(type, member) ( (size_t) &( ( (type *) 0)->member))
 #endif
 
+/* Wear leveling.  The wear level of each erase block is its erase count
+ * relative to the least worn erase block.  The levels are kept in the aging
+ * area of the format sector, one byte per erase block, along with the erase
+ * count of the least worn block.
+ */
+
+#ifdef CONFIG_MTD_SMART_WEAR_LEVEL
+#  ifndef CONFIG_MTD_SMART_WEAR_THRESHOLD
+#    define CONFIG_MTD_SMART_WEAR_THRESHOLD 8
+#  endif
+#endif
+
+/* Background garbage collection */
+
+#ifdef CONFIG_MTD_SMART_BGGC
+#  ifndef CONFIG_SCHED_WORKQUEUE
+#    error "Worker thread support is required (CONFIG_SCHED_WORKQUEUE)"
+#  endif
+#  ifndef CONFIG_MTD_SMART_GCDELAY
+#    define CONFIG_MTD_SMART_GCDELAY 500
+#  endif
+#  ifndef CONFIG_MTD_SMART_BGGC_FREE
+#    define CONFIG_MTD_SMART_BGGC_FREE 10
+#  endif
+#endif
+
+/* The number of free sectors that must be kept in reserve for garbage
+ * collection.
+ */
+
+#define SMART_RESERVED_SECTORS(d) ((d)->sectorsPerBlk + 4)
+
+/* Background garbage collection keeps this many sectors free */
+
+#define SMART_BGGC_FREESECTORS(d) \
+  (SMART_RESERVED_SECTORS(d) + \
+   (uint32_t)(d)->totalsectors * CONFIG_MTD_SMART_BGGC_FREE / 100)
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -126,15 +223,35 @@ struct smart_struct_s
   FAR struct mtd_dev_s *mtd;              /* Contained MTD interface */
   struct mtd_geometry_s geo;              /* Device geometry */
   uint16_t              neraseblocks;     /* Number of erase blocks or sub-sectors */
-  uint16_t              freesectors;      /* Total number of free sectors */
+  smart_sector_t        freesectors;      /* Total number of free sectors */
   uint16_t              mtdBlksPerSector; /* Number of MTD blocks per SMART Sector */
   uint16_t              sectorsPerBlk;    /* Number of sectors per erase block */
   uint16_t              sectorsize;       /* Sector size on device */
-  uint16_t              totalsectors;     /* Total number of sectors on device */
-  FAR uint16_t         *sMap;             /* Virtual to physical sector map */
+  smart_sector_t        totalsectors;     /* Total number of sectors on device */
+  FAR smart_sector_t  **sMap;             /* Pages of the virtual to physical sector map */
+  FAR uint8_t          *mapcount;         /* Number of mapped sectors in each page */
+  uint32_t              nmappages;        /* Number of pages in the map */
+  uint32_t              mappages;         /* Number of pages allocated */
   FAR uint8_t          *releasecount;     /* Count of released sectors per erase block */
   FAR uint8_t          *freecount;        /* Count of free sectors per erase block */
   FAR char             *rwbuffer;         /* Our sector read/write buffer */
+#ifdef CONFIG_MTD_SMART_WEAR_LEVEL
+  FAR uint8_t          *wearlevel;        /* Wear level of each erase block */
+  uint32_t              wearbase;         /* Erase count of the least worn block */
+  uint16_t              weardirty;        /* Erases since the levels were saved */
+#endif
+#ifdef CONFIG_MTD_SMART_BGGC
+  struct work_s         work;             /* Background garbage collection */
+  sem_t                 exclsem;          /* Exclusive access to the device */
+#endif
+  uint32_t              nerases;          /* Statistics: Erase operations */
+  uint32_t              ncollections;     /*   Foreground collections */
+  uint32_t              nbgcollections;   /*   Background collections */
+  uint32_t              nwearmoves;       /*   Static wear leveling collections */
+  uint32_t              gcmaxtime;        /*   Longest foreground GC (ticks) */
+  uint32_t              gctotaltime;      /*   Foreground GC time (ticks) */
+  uint32_t              bgtotaltime;      /*   Background GC time (ticks) */
+  uint32_t              scantime;         /*   Mount-time scan (ticks) */
   char                  partname[SMART_PARTNAME_SIZE]; /* Optional partition name */
   uint8_t               formatversion;    /* Format version on the device */
   uint8_t               formatstatus;     /* Indicates the status of the device format */
@@ -167,6 +284,10 @@ struct smart_sect_header_s
                                            * Bit 3:   Reserved - 1
                                            * Bit 2:   Reserved - 1
                                            * Bit 1-0: Format version    */
+#ifdef CONFIG_SMARTFS_32BIT_SECTORS
+  uint8_t               logicalsector2[2];/* Upper half of the logical sector
+                                           * number (format version 2) */
+#endif
 };
 
 /****************************************************************************
@@ -186,6 +307,14 @@ static ssize_t smart_write(FAR struct inode *inode, const unsigned char *buffer,
 static int     smart_geometry(FAR struct inode *inode, struct geometry *geometry);
 static int     smart_ioctl(FAR struct inode *inode, int cmd, unsigned long arg);
 
+#ifdef CONFIG_MTD_SMART_BGGC
+static void    smart_semtake(FAR struct smart_struct_s *dev);
+#  define      smart_semgive(d) sem_post(&(d)->exclsem)
+#else
+#  define      smart_semtake(d)
+#  define      smart_semgive(d)
+#endif
+
 /****************************************************************************
  * Private Data
  ****************************************************************************/
@@ -234,6 +363,30 @@ static int smart_close(FAR struct inode *inode)
   return OK;
 }
 
+/****************************************************************************
+ * Name: smart_semtake
+ *
+ * Description: Get exclusive access to the SMART device.  This is only
+ *              needed when garbage is collected in the background.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MTD_SMART_BGGC
+static void smart_semtake(FAR struct smart_struct_s *dev)
+{
+  /* Take the semaphore (perhaps waiting) */
+
+  while (sem_wait(&dev->exclsem) != 0)
+    {
+      /* The only case that an error should occur here is if the wait was
+       * awakened by a signal.
+       */
+
+      ASSERT(errno == EINTR);
+    }
+}
+#endif
+
 /****************************************************************************
  * Name: smart_reload
  *
@@ -461,6 +614,127 @@ static int smart_geometry(FAR struct inode *inode, struct geometry *geometry)
   return -EINVAL;
 }
 
+/****************************************************************************
+ * Name: smart_getmap
+ *
+ * Description: Returns the physical sector that a logical sector is mapped
+ *              to, or SMART_SECTOR_NONE.
+ *
+ ****************************************************************************/
+
+static smart_sector_t smart_getmap(struct smart_struct_s *dev,
+                                   smart_sector_t logsector)
+{
+  FAR smart_sector_t *page;
+
+  if (logsector >= dev->totalsectors)
+    {
+      return SMART_SECTOR_NONE;
+    }
+
+  page = dev->sMap[logsector >> SMART_MAP_PAGESHIFT];
+  if (page == NULL)
+    {
+      return SMART_SECTOR_NONE;
+    }
+
+  return page[logsector & SMART_MAP_PAGEMASK];
+}
+
+/****************************************************************************
+ * Name: smart_setmap
+ *
+ * Description: Maps a logical sector to a physical sector, or unmaps it if
+ *              physsector is SMART_SECTOR_NONE.  Allocates and frees the
+ *              pages of the map as needed.  Only mapping a logical sector
+ *              that was not mapped can fail (with -ENOMEM).
+ *
+ ****************************************************************************/
+
+static int smart_setmap(struct smart_struct_s *dev, smart_sector_t logsector,
+                        smart_sector_t physsector)
+{
+  FAR smart_sector_t **page;
+  FAR uint8_t *count;
+  smart_sector_t *entry;
+
+  DEBUGASSERT(logsector < dev->totalsectors);
+
+  page  = &dev->sMap[logsector >> SMART_MAP_PAGESHIFT];
+  count = &dev->mapcount[logsector >> SMART_MAP_PAGESHIFT];
+
+  if (*page == NULL)
+    {
+      if (physsector == SMART_SECTOR_NONE)
+        {
+          return OK;
+        }
+
+      /* Allocate the page.  All of its sectors are unmapped. */
+
+      *page = (FAR smart_sector_t *)
+        kmalloc(SMART_MAP_PAGESIZE * sizeof(smart_sector_t));
+      if (*page == NULL)
+        {
+          fdbg("Error allocating SMART map page\n");
+          return -ENOMEM;
+        }
+
+      memset(*page, 0xff, SMART_MAP_PAGESIZE * sizeof(smart_sector_t));
+      dev->mappages++;
+    }
+
+  entry = &(*page)[logsector & SMART_MAP_PAGEMASK];
+  if (*entry == SMART_SECTOR_NONE && physsector != SMART_SECTOR_NONE)
+    {
+      (*count)++;
+    }
+  else if (*entry != SMART_SECTOR_NONE && physsector == SMART_SECTOR_NONE)
+    {
+      if (--(*count) == 0)
+        {
+          /* That was the last mapped sector in the page */
+
+          kfree(*page);
+          *page = NULL;
+          dev->mappages--;
+          return OK;
+        }
+    }
+
+  *entry = physsector;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: smart_freemap
+ *
+ * Description: Frees the sector map, including the erase block counts that
+ *              are allocated with it.
+ *
+ ****************************************************************************/
+
+static void smart_freemap(struct smart_struct_s *dev)
+{
+  uint32_t  x;
+
+  if (dev->sMap != NULL)
+    {
+      for (x = 0; x < dev->nmappages; x++)
+        {
+          if (dev->sMap[x] != NULL)
+            {
+              kfree(dev->sMap[x]);
+            }
+        }
+
+      kfree(dev->sMap);
+      dev->sMap      = NULL;
+      dev->nmappages = 0;
+      dev->mappages  = 0;
+    }
+}
+
 /****************************************************************************
  * Name: smart_setsectorsize
  *
@@ -493,39 +767,58 @@ static int smart_setsectorsize(struct smart_struct_s *dev, uint16_t size)
       erasesize = 65536;
     }
 
+  /* The per erase block counts are 8 bits wide and the sector numbers are
+   * limited by the format version.
+   */
+
+  if (erasesize / size > 255)
+    {
+      fdbg("Too many sectors per erase block: %lu\n",
+           (unsigned long) (erasesize / size));
+      return -EINVAL;
+    }
+
+  totalsectors = dev->geo.neraseblocks * (erasesize / size);
+  if (dev->geo.neraseblocks > 65535 || totalsectors > SMART_MAX_SECTORS)
+    {
+      fdbg("SMART Sector size too small for device\n");
+      return -EINVAL;
+    }
+
   dev->sectorsize = size;
   dev->mtdBlksPerSector = dev->sectorsize / dev->geo.blocksize;
   dev->sectorsPerBlk = erasesize / dev->sectorsize;
 
   /* Release any existing rwbuffer and sMap */
 
-  if (dev->sMap != NULL)
-    {
-      kfree(dev->sMap);
-    }
+  smart_freemap(dev);
 
   if (dev->rwbuffer != NULL)
     {
       kfree(dev->rwbuffer);
     }
 
-  /* Allocate a virtual to physical sector map buffer.  Also allocate
-   * the storage space for releasecount and freecounts.
+  /* Allocate the page table of the virtual to physical sector map (the
+   * pages themselves are allocated as sectors are mapped).  Also allocate
+   * the storage space for the page counts, releasecount and freecounts.
    */
 
-  totalsectors = dev->neraseblocks * dev->sectorsPerBlk;
-  dev->totalsectors = (uint16_t) totalsectors;
+  dev->totalsectors = (smart_sector_t) totalsectors;
+  dev->nmappages = (totalsectors + SMART_MAP_PAGEMASK) >> SMART_MAP_PAGESHIFT;
+  dev->mappages = 0;
 
-  dev->sMap = (uint16_t *) kmalloc(totalsectors * sizeof(uint16_t) +
-              (dev->neraseblocks << 1));
+  dev->sMap = (FAR smart_sector_t **)
+    kzalloc(dev->nmappages * (sizeof(FAR smart_sector_t *) + 1) +
+            (dev->neraseblocks << 1));
   if (!dev->sMap)
     {
       fdbg("Error allocating SMART virtual map buffer\n");
       kfree(dev);
-      return -EINVAL;
+      return -ENOMEM;
     }
 
-  dev->releasecount = (uint8_t *) dev->sMap + (totalsectors * sizeof(uint16_t));
+  dev->mapcount = (FAR uint8_t *) &dev->sMap[dev->nmappages];
+  dev->releasecount = dev->mapcount + dev->nmappages;
   dev->freecount = dev->releasecount + dev->neraseblocks;
 
   /* Allocate a read/write buffer */
@@ -534,9 +827,9 @@ static int smart_setsectorsize(struct smart_struct_s *dev, uint16_t size)
   if (!dev->rwbuffer)
     {
       fdbg("Error allocating SMART read/write buffer\n");
-      kfree(dev->sMap);
+      smart_freemap(dev);
       kfree(dev);
-      return -EINVAL;
+      return -ENOMEM;
     }
 
   return OK;
@@ -572,7 +865,7 @@ static ssize_t smart_bytewrite(struct smart_struct_s *dev, size_t offset,
     {
       /* Perform block-based read-modify-write */
 
-      uint16_t  startblock;
+      uint32_t  startblock;
       uint16_t  nblocks;
 
       /* First calculate the start block and number of blocks affected */
@@ -610,6 +903,90 @@ errout:
   return ret;
 }
 
+/****************************************************************************
+ * Name: smart_normalizewear
+ *
+ * Description: Make the wear levels relative to the least worn erase block
+ *              again.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MTD_SMART_WEAR_LEVEL
+static void smart_normalizewear(struct smart_struct_s *dev)
+{
+  uint8_t   minlevel = 0xff;
+  uint16_t  x;
+
+  for (x = 0; x < dev->neraseblocks; x++)
+    {
+      if (dev->wearlevel[x] < minlevel)
+        {
+          minlevel = dev->wearlevel[x];
+        }
+    }
+
+  if (minlevel > 0)
+    {
+      for (x = 0; x < dev->neraseblocks; x++)
+        {
+          dev->wearlevel[x] -= minlevel;
+        }
+
+      dev->wearbase += minlevel;
+    }
+}
+#endif
+
+/****************************************************************************
+ * Name: smart_loadwear
+ *
+ * Description: Read the erase block wear levels from the format sector.
+ *              Erase blocks that do not fit in the format sector start at
+ *              the level of the least worn block.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MTD_SMART_WEAR_LEVEL
+static int smart_loadwear(struct smart_struct_s *dev)
+{
+  uint16_t  nlevels;
+  ssize_t   ret;
+
+  memset(dev->wearlevel, 0, dev->neraseblocks);
+  dev->wearbase  = 0;
+  dev->weardirty = 0;
+
+  ret = MTD_BREAD(dev->mtd, smart_getmap(dev, 0) * dev->mtdBlksPerSector,
+                  dev->mtdBlksPerSector, (uint8_t *) dev->rwbuffer);
+  if (ret != dev->mtdBlksPerSector)
+    {
+      fdbg("Error reading the format sector\n");
+      return -EIO;
+    }
+
+  /* Volumes formatted without wear leveling hold the erased state in the
+   * base erase count and zeros in the aging area.
+   */
+
+  memcpy(&dev->wearbase, &dev->rwbuffer[SMART_FMT_WEARBASE_POS],
+         sizeof(uint32_t));
+  if (dev->wearbase == 0xffffffff)
+    {
+      dev->wearbase = 0;
+    }
+
+  nlevels = dev->sectorsize - SMARTFS_FMT_AGING_POS;
+  if (nlevels > dev->neraseblocks)
+    {
+      nlevels = dev->neraseblocks;
+    }
+
+  memcpy(dev->wearlevel, &dev->rwbuffer[SMARTFS_FMT_AGING_POS], nlevels);
+  smart_normalizewear(dev);
+  return OK;
+}
+#endif
+
 /****************************************************************************
  * Name: smart_scan
  *
@@ -621,15 +998,18 @@ errout:
 
 static int smart_scan(struct smart_struct_s *dev)
 {
-  int       sector;
+  smart_sector_t sector;
   int       ret;
   int       offset;
-  uint16_t  totalsectors;
+  smart_sector_t totalsectors;
   uint16_t  sectorsize;
-  uint16_t  logicalsector;
+  smart_sector_t logicalsector;
+  smart_sector_t mapped;
+  smart_sector_t badversion = 0;
   uint16_t  seq1;
   uint16_t  seq2;
   size_t    readaddress;
+  uint32_t  start;
   struct    smart_sect_header_s header;
 #ifdef CONFIG_SMARTFS_MULTI_ROOT_DIRS
   int       x;
@@ -638,6 +1018,7 @@ static int smart_scan(struct smart_struct_s *dev)
 #endif
 
   fvdbg("Entry\n");
+  start = clock_systimer();
 
   /* Read the 1st header from the device.  We always keep the
    * 1st sector's header's sectorsize field accurate, even
@@ -669,11 +1050,13 @@ static int smart_scan(struct smart_struct_s *dev)
 
   /* Initialize the device variables */
 
-  totalsectors = dev->neraseblocks * dev->sectorsPerBlk;
+  totalsectors = dev->totalsectors;
   dev->formatstatus = SMART_FMT_STAT_NOFMT;
   dev->freesectors = totalsectors;
 
-  /* Initialize the freecount and releasecount arrays */
+  /* Initialize the freecount and releasecount arrays.  The sector map was
+   * left empty by smart_setsectorsize().
+   */
 
   for (sector = 0; sector < dev->neraseblocks; sector++)
     {
@@ -681,18 +1064,13 @@ static int smart_scan(struct smart_struct_s *dev)
       dev->releasecount[sector] = 0;
     }
 
-  /* Initialize the sector map */
-
-  for (sector = 0; sector < totalsectors; sector++)
-    {
-      dev->sMap[sector] = -1;
-    }
-
-  /* Now scan the MTD device */
+  /* Now scan the MTD device.  This reads one header per physical sector,
+   * so the mount time grows linearly with the size of the device.
+   */
 
   for (sector = 0; sector < totalsectors; sector++)
     {
-      fvdbg("Scan sector %d\n", sector);
+      fvdbg("Scan sector %lu\n", (unsigned long) sector);
 
       /* Calculate the read address for this sector */
 
@@ -709,11 +1087,11 @@ static int smart_scan(struct smart_struct_s *dev)
 
       /* Get the logical sector number for this physical sector */
 
-      logicalsector = *((uint16_t *) header.logicalsector);
+      logicalsector = SMART_GETLOGSECTOR(&header);
 #if CONFIG_SMARTFS_ERASEDSTATE == 0x00
       if (logicalsector == 0)
         {
-          logicalsector = -1;
+          logicalsector = SMART_SECTOR_NONE;
         }
 #endif
 
@@ -743,8 +1121,13 @@ static int smart_scan(struct smart_struct_s *dev)
           continue;
         }
 
+      /* Sectors written with a different sector number width (or by a
+       * different version of the driver) can't be interpreted.
+       */
+
       if ((header.status & SMART_STATUS_VERBITS) != SMART_STATUS_VERSION)
         {
+          badversion++;
           continue;
         }
 
@@ -754,8 +1137,8 @@ static int smart_scan(struct smart_struct_s *dev)
         {
           /* Error in logical sector read from the MTD device */
 
-          fdbg("Invalid logical sector %d at physical %d.\n",
-               logicalsector, sector);
+          fdbg("Invalid logical sector %lu at physical %lu.\n",
+               (unsigned long) logicalsector, (unsigned long) sector);
           continue;
         }
 
@@ -771,7 +1154,8 @@ static int smart_scan(struct smart_struct_s *dev)
                          (uint8_t*) dev->rwbuffer);
           if (ret != 32)
             {
-              fdbg("Error reading physical sector %d.\n", sector);
+              fdbg("Error reading physical sector %lu.\n",
+                   (unsigned long) sector);
               goto err_out;
             }
 
@@ -843,20 +1227,21 @@ static int smart_scan(struct smart_struct_s *dev)
 
       /* Test for duplicate logical sectors on the device */
 
-      if (dev->sMap[logicalsector] != 0xFFFF)
+      mapped = smart_getmap(dev, logicalsector);
+      if (mapped != SMART_SECTOR_NONE)
         {
           /* Uh-oh, we found more than 1 physical sector claiming to be
            * the * same logical sector.  Use the sequence number information
            * to resolve who wins.
            */
 
-          uint16_t loser;
+          smart_sector_t loser;
 
           seq2 = *((uint16_t *) header.seq);
 
           /* We must re-read the 1st physical sector to get it's seq number */
 
-          readaddress = dev->sMap[logicalsector]  * dev->mtdBlksPerSector * dev->geo.blocksize;
+          readaddress = mapped * dev->mtdBlksPerSector * dev->geo.blocksize;
           ret = MTD_READ(dev->mtd, readaddress, sizeof(struct smart_sect_header_s),
                   (uint8_t *) &header);
           if (ret != sizeof(struct smart_sect_header_s))
@@ -872,15 +1257,15 @@ static int smart_scan(struct smart_struct_s *dev)
             {
               /* Seq 2 is the winner ... we assume it wrapped */
 
-              loser = dev->sMap[logicalsector];
-              dev->sMap[logicalsector] = sector;
+              loser = mapped;
+              mapped = sector;
             }
           else if (seq2 > seq1)
             {
               /* Seq 2 is bigger, so it's the winner */
 
-              loser = dev->sMap[logicalsector];
-              dev->sMap[logicalsector] = sector;
+              loser = mapped;
+              mapped = sector;
             }
           else
             {
@@ -911,12 +1296,39 @@ static int smart_scan(struct smart_struct_s *dev)
               fdbg("Error %d releasing duplicate sector\n", -ret);
               goto err_out;
             }
+
+          dev->releasecount[loser / dev->sectorsPerBlk]++;
+        }
+      else
+        {
+          mapped = sector;
         }
 
       /* Update the logical to physical sector map */
 
-      dev->sMap[logicalsector] = sector;
+      ret = smart_setmap(dev, logicalsector, mapped);
+      if (ret < 0)
+        {
+          goto err_out;
+        }
+    }
+
+  if (badversion > 0)
+    {
+      fdbg("%lu sectors have an unsupported format version\n",
+           (unsigned long) badversion);
+    }
+
+#ifdef CONFIG_MTD_SMART_WEAR_LEVEL
+  /* Now that duplicates are resolved, get the wear levels from the format
+   * sector.
+   */
+
+  if (dev->formatstatus == SMART_FMT_STAT_FORMATTED)
+    {
+      (void)smart_loadwear(dev);
     }
+#endif
 
   fdbg("SMART Scan\n");
   fdbg("   Erase size:   %10d\n", dev->sectorsPerBlk * dev->sectorsize);
@@ -924,6 +1336,7 @@ static int smart_scan(struct smart_struct_s *dev)
   fdbg("   Sect/block:   %10d\n", dev->sectorsPerBlk);
   fdbg("   MTD Blk/Sect: %10d\n", dev->mtdBlksPerSector);
 
+  dev->scantime = clock_systimer() - start;
   ret = OK;
 
 err_out:
@@ -1000,7 +1413,7 @@ static inline int smart_getformat(struct smart_struct_s *dev,
 
   /* Subtract the reserved sector count */
 
-  fmt->nfreesectors -= dev->sectorsPerBlk + 4;
+  fmt->nfreesectors -= SMART_RESERVED_SECTORS(dev);
 
   ret = OK;
 
@@ -1022,10 +1435,12 @@ static inline int smart_llformat(struct smart_struct_s *dev, unsigned long arg)
 {
   struct    smart_sect_header_s  *sectorheader;
   size_t    wrcount;
-  size_t    totalsectors;
   int       x;
   int       ret;
   uint8_t   sectsize;
+#ifdef CONFIG_MTD_SMART_WEAR_LEVEL
+  uint16_t  nlevels;
+#endif
 
   fvdbg("Entry\n");
 
@@ -1037,6 +1452,8 @@ static inline int smart_llformat(struct smart_struct_s *dev, unsigned long arg)
       return ret;
     }
 
+  dev->nerases += dev->neraseblocks;
+
   /* Now construct a logical sector zero header to write to the device.
    * We fill it with zero so when we add sector aging, all the sector
    * ages will already be initialized to zero without needing special
@@ -1050,12 +1467,12 @@ static inline int smart_llformat(struct smart_struct_s *dev, unsigned long arg)
 
   sectsize = (CONFIG_MTD_SMART_SECTOR_SIZE >> 9) << 2;
 #if ( CONFIG_SMARTFS_ERASEDSTATE == 0xFF )
-  *((uint16_t *) sectorheader->logicalsector) = 0;
+  SMART_SETLOGSECTOR(sectorheader, 0);
   sectorheader->status = (uint8_t) ~(SMART_STATUS_COMMITTED | SMART_STATUS_VERBITS |
           SMART_STATUS_SIZEBITS) | SMART_STATUS_VERSION |
           sectsize;
 #else
-  *((uint16_t *) sectorheader->logicalsector) = 0xFFFF;
+  SMART_SETLOGSECTOR(sectorheader, SMART_SECTOR_NONE);
   sectorheader->status = (uint8_t) (SMART_STATUS_COMMITTED | SMART_STATUS_VERSION |
           sectsize);
 #endif
@@ -1074,6 +1491,27 @@ static inline int smart_llformat(struct smart_struct_s *dev, unsigned long arg)
 
   dev->rwbuffer[SMART_FMT_ROOTDIRS_POS] = (uint8_t) arg;
 
+#ifdef CONFIG_MTD_SMART_WEAR_LEVEL
+  /* The bulk erase wore every erase block once more.  Carry the wear levels
+   * over to the new format.
+   */
+
+  smart_normalizewear(dev);
+  dev->wearbase++;
+  dev->weardirty = 0;
+
+  memcpy(&dev->rwbuffer[SMART_FMT_WEARBASE_POS], &dev->wearbase,
+         sizeof(uint32_t));
+
+  nlevels = dev->sectorsize - SMARTFS_FMT_AGING_POS;
+  if (nlevels > dev->neraseblocks)
+    {
+      nlevels = dev->neraseblocks;
+    }
+
+  memcpy(&dev->rwbuffer[SMARTFS_FMT_AGING_POS], dev->wearlevel, nlevels);
+#endif
+
   /* Write the sector to the flash */
 
   wrcount = MTD_BWRITE(dev->mtd, 0, dev->mtdBlksPerSector,
@@ -1098,7 +1536,8 @@ static inline int smart_llformat(struct smart_struct_s *dev, unsigned long arg)
     }
 
   dev->formatstatus = SMART_FMT_STAT_UNKNOWN;
-  dev->freesectors = dev->neraseblocks * dev->sectorsPerBlk - 1;
+  dev->formatversion = SMART_FMT_VERSION;
+  dev->freesectors = dev->totalsectors - 1;
   for (x = 0; x < dev->neraseblocks; x++)
     {
       /* Initialize the released and free counts */
@@ -1111,16 +1550,14 @@ static inline int smart_llformat(struct smart_struct_s *dev, unsigned long arg)
 
   dev->freecount[0]--;
 
-  /* Now initialize the logical to physical sector map */
-
-  dev->sMap[0] = 0;     /* Logical sector zero = physical sector 0 */
+  /* Now initialize the logical to physical sector map.  It was left empty
+   * by smart_setsectorsize() so all other logical sectors are non-existant.
+   */
 
-  totalsectors = dev->neraseblocks * dev->sectorsPerBlk;
-  for (x = 1; x < totalsectors; x++)
+  ret = smart_setmap(dev, 0, 0);  /* Logical sector zero = physical sector 0 */
+  if (ret < 0)
     {
-      /* Mark all other logical sectors as non-existant */
-
-      dev->sMap[x] = -1;
+      return ret;
     }
 
 #ifdef CONFIG_SMARTFS_MULTI_ROOT_DIRS
@@ -1150,25 +1587,31 @@ static int smart_findfreephyssector(struct smart_struct_s *dev)
 {
   uint16_t  allocfreecount;
   uint16_t  allocblock;
-  uint16_t  physicalsector;
-  uint16_t  x;
+  smart_sector_t physicalsector;
+  smart_sector_t x;
   uint32_t  readaddr;
   struct    smart_sect_header_s header;
   int       ret;
 
   /* Determine which erase block we should allocate the new
    * sector from. This is based on the number of free sectors
-   * available in each erase block. */
+   * available in each erase block.  With wear leveling, the
+   * least worn of the blocks with the most free sectors is used. */
 
   allocfreecount = 0;
   allocblock = 0xFFFF;
-  physicalsector = 0xFFFF;
+  physicalsector = SMART_SECTOR_NONE;
   for (x = 0; x < dev->neraseblocks; x++)
     {
       /* Test if this block has more free blocks than the
        * currently selected block */
 
-      if (dev->freecount[x] > allocfreecount)
+      if (dev->freecount[x] > allocfreecount
+#ifdef CONFIG_MTD_SMART_WEAR_LEVEL
+          || (dev->freecount[x] == allocfreecount && allocfreecount > 0 &&
+              dev->wearlevel[x] < dev->wearlevel[allocblock])
+#endif
+         )
         {
           /* Assign this block to alloc from */
 
@@ -1188,8 +1631,8 @@ static int smart_findfreephyssector(struct smart_struct_s *dev)
   /* Now find a free physical sector within this selected
    * erase block to allocate. */
 
-  for (x = allocblock * dev->sectorsPerBlk;
-          x < (allocblock+1) * dev->sectorsPerBlk; x++)
+  for (x = (smart_sector_t) allocblock * dev->sectorsPerBlk;
+          x < (smart_sector_t) (allocblock+1) * dev->sectorsPerBlk; x++)
     {
       /* Check if this physical sector is available */
 
@@ -1198,12 +1641,12 @@ static int smart_findfreephyssector(struct smart_struct_s *dev)
               (uint8_t *) &header);
       if (ret != sizeof(struct smart_sect_header_s))
         {
-          fvdbg("Error reading phys sector %d\n", physicalsector);
+          fvdbg("Error reading phys sector %lu\n", (unsigned long) x);
           return -EIO;
         }
 
-      if ((*((uint16_t *) header.logicalsector) == 0xFFFF) &&
-          (*((uint16_t *) header.seq) == 0xFFFF) &&
+      if ((SMART_GETLOGSECTOR(&header) == SMART_ERASEDSECTOR) &&
+          (*((uint16_t *) header.seq) == SMART_ERASEDSEQ) &&
           ((header.status & SMART_STATUS_COMMITTED) ==
            (CONFIG_SMARTFS_ERASEDSTATE & SMART_STATUS_COMMITTED)))
         {
@@ -1212,237 +1655,652 @@ static int smart_findfreephyssector(struct smart_struct_s *dev)
         }
     }
 
-  return physicalsector;
+  if (physicalsector == SMART_SECTOR_NONE)
+    {
+      return -ENOSPC;
+    }
+
+  return (int) physicalsector;
 }
 
 /****************************************************************************
- * Name: smart_garbagecollect
+ * Name: smart_eraseblock
  *
- * Description:  Performs garbage collection if needed.  This is determined
- *               by the count of released sectors relative to free and
- *               total sectors.
+ * Description:  Erases one erase block and accounts for its wear.
  *
  ****************************************************************************/
 
 #ifdef CONFIG_FS_WRITABLE
-static int smart_garbagecollect(struct smart_struct_s *dev)
+static int smart_eraseblock(struct smart_struct_s *dev, uint16_t block)
 {
-  uint16_t  releasedsectors;
-  uint16_t  collectblock;
-  uint16_t  releasemax;
-  uint16_t  newsector;
-  bool      collect = TRUE;
-  int       x;
-  int       ret;
-  size_t    offset;
-  struct    smart_sect_header_s *header;
   uint8_t   newstatus;
+  int       ret;
 
-  while (collect)
+  ret = MTD_ERASE(dev->mtd, block, 1);
+  if (ret < 0)
     {
-      collect = FALSE;
+      fdbg("Error %d erasing block %d\n", -ret, block);
+      return ret;
+    }
 
-      /* Calculate the number of released sectors on the device */
+  dev->nerases++;
 
-      releasedsectors = 0;
-      collectblock = 0xFFFF;
-      releasemax = 0;
-      for (x = 0; x < dev->neraseblocks; x++)
-        {
-          releasedsectors += dev->releasecount[x];
-          if (dev->releasecount[x] > releasemax)
-            {
-              releasemax = dev->releasecount[x];
-              collectblock = x;
-            }
-        }
+#ifdef CONFIG_MTD_SMART_WEAR_LEVEL
+  if (dev->wearlevel[block] == 0xff)
+    {
+      smart_normalizewear(dev);
+    }
 
-      /* Test if the released sectors count is greater than the
-       * free sectors.  If it is, then we will do garbage collection.
-       */
+  if (dev->wearlevel[block] < 0xff)
+    {
+      dev->wearlevel[block]++;
+    }
 
-      if (releasedsectors > dev->freesectors)
-        collect = TRUE;
+  dev->weardirty++;
+#endif
 
-      /* Test if we have more reached our reserved free sector limit */
+  /* If this is block zero, then be sure to write the sector size */
 
-      if (dev->freesectors <= (dev->sectorsPerBlk << 0) + 4)
-        collect = TRUE;
+  if (block == 0)
+    {
+      /* Set the sector size in the 1st header */
 
-      /* Test if we need to garbage collect */
+      uint8_t sectsize = dev->sectorsize >> 7;
+#if ( CONFIG_SMARTFS_ERASEDSTATE == 0xFF )
+      newstatus = (uint8_t) ~SMART_STATUS_SIZEBITS | sectsize;
+#else
+      newstatus = (uint8_t) sectsize;
+#endif
+      /* Write the sector size to the device */
 
-      if (collect)
+      ret = smart_bytewrite(dev, offsetof(struct smart_sect_header_s, status),
+                            1, &newstatus);
+      if (ret < 0)
         {
-          if (collectblock == 0xFFFF)
-            {
-              /* Need to collect, but no sectors with released blocks! */
+          fdbg("Error %d setting sector 0 size\n", -ret);
+          return ret;
+        }
+    }
 
-              ret = -ENOSPC;
-              goto errout;
-            }
+  return OK;
+}
+#endif /* CONFIG_FS_WRITABLE */
 
-          fdbg("Collecting block %d, free=%d released=%d\n",
-              collectblock, dev->freecount[collectblock],
-              dev->releasecount[collectblock]);
+/****************************************************************************
+ * Name: smart_relocatesector
+ *
+ * Description:  Writes the content of the read/write buffer, including the
+ *               sector header read from the current physical sector, to a
+ *               new physical sector and releases the current one.
+ *
+ ****************************************************************************/
 
-          if (dev->freecount[collectblock] == 6)
-            {
-              fdbg("here!\n");
-            }
+#ifdef CONFIG_FS_WRITABLE
+static int smart_relocatesector(struct smart_struct_s *dev,
+                                smart_sector_t logsector)
+{
+  struct    smart_sect_header_s *header;
+  smart_sector_t oldsector;
+  smart_sector_t physsector;
+  size_t    offset;
+  uint8_t   byte;
+  int       ret;
 
-          /* Perform collection on block with the most released sectors.
-           * First mark the block as having no free sectors so we don't
-           * try to move sectors into the block we are trying to erase.
-           */
+  /* Find a new physical sector to save data to */
 
-          dev->freecount[collectblock] = 0;
+  ret = smart_findfreephyssector(dev);
+  if (ret < 0)
+    {
+      fdbg("Error relocating sector %lu\n", (unsigned long) logsector);
+      return -EIO;
+    }
 
-          /* Next move all live data in the block to a new home. */
+  physsector = (smart_sector_t) ret;
+  oldsector  = smart_getmap(dev, logsector);
 
-          for (x = collectblock * dev->sectorsPerBlk; x <
-             (collectblock + 1) * dev->sectorsPerBlk; x++)
-            {
-              /* Read the next sector from this erase block */
+  /* Update the sequence number to indicate the sector was moved */
+
+  header = (struct smart_sect_header_s *) dev->rwbuffer;
+  (*((uint16_t *) header->seq))++;
+  if (*((uint16_t *) header->seq) == 0xFFFF)
+    {
+      *((uint16_t *) header->seq) = 1;
+    }
+
+#if CONFIG_SMARTFS_ERASEDSTATE == 0xFF
+  header->status |= SMART_STATUS_COMMITTED;
+#else
+  header->status &= ~SMART_STATUS_COMMITTED;
+#endif
+
+  /* Write the entire sector to the new physical location, uncommitted. */
+
+  ret = MTD_BWRITE(dev->mtd, physsector * dev->mtdBlksPerSector,
+          dev->mtdBlksPerSector, (uint8_t *) dev->rwbuffer);
+  if (ret != dev->mtdBlksPerSector)
+    {
+      fdbg("Error writing to physical sector %lu\n",
+           (unsigned long) physsector);
+      return -EIO;
+    }
+
+  /* Commit the new physical sector */
+
+#if CONFIG_SMARTFS_ERASEDSTATE == 0xFF
+  byte = header->status & ~SMART_STATUS_COMMITTED;
+#else
+  byte = header->status | SMART_STATUS_COMMITTED;
+#endif
+  offset = physsector * dev->mtdBlksPerSector * dev->geo.blocksize +
+      offsetof(struct smart_sect_header_s, status);
+  ret = smart_bytewrite(dev, offset, 1, &byte);
+  if (ret != 1)
+    {
+      fvdbg("Error committing physical sector %lu\n",
+            (unsigned long) physsector);
+      return -EIO;
+    }
+
+  /* Release the old physical sector */
 
-              ret = MTD_BREAD(dev->mtd, x * dev->mtdBlksPerSector,
+#if CONFIG_SMARTFS_ERASEDSTATE == 0xFF
+  byte = header->status & ~SMART_STATUS_RELEASED;
+#else
+  byte = header->status | SMART_STATUS_RELEASED;
+#endif
+  offset = oldsector * dev->mtdBlksPerSector * dev->geo.blocksize +
+      offsetof(struct smart_sect_header_s, status);
+  ret = smart_bytewrite(dev, offset, 1, &byte);
+
+  /* Update releasecount for released sector and freecount for the
+   * newly allocated physical sector. */
+
+  dev->releasecount[oldsector / dev->sectorsPerBlk]++;
+  dev->freecount[physsector / dev->sectorsPerBlk]--;
+  dev->freesectors--;
+
+  /* Update the sector map */
+
+  return smart_setmap(dev, logsector, physsector);
+}
+#endif /* CONFIG_FS_WRITABLE */
+
+/****************************************************************************
+ * Name: smart_savewear
+ *
+ * Description:  Writes the erase block wear levels to the format sector.
+ *               The format sector is relocated like any other sector.
+ *
+ ****************************************************************************/
+
+#if defined(CONFIG_FS_WRITABLE) && defined(CONFIG_MTD_SMART_WEAR_LEVEL)
+static int smart_savewear(struct smart_struct_s *dev)
+{
+  uint16_t  nlevels;
+  int       ret;
+
+  /* Don't use the sectors reserved for garbage collection */
+
+  if (smart_getmap(dev, 0) == SMART_SECTOR_NONE ||
+      dev->freesectors <= SMART_RESERVED_SECTORS(dev))
+    {
+      return -ENOSPC;
+    }
+
+  ret = MTD_BREAD(dev->mtd, smart_getmap(dev, 0) * dev->mtdBlksPerSector,
                   dev->mtdBlksPerSector, (uint8_t *) dev->rwbuffer);
-              if (ret != dev->mtdBlksPerSector)
-                {
-                  fdbg("Error reading sector %d\n", x);
-                  ret = -EIO;
-                  goto errout;
-                }
+  if (ret != dev->mtdBlksPerSector)
+    {
+      fdbg("Error reading the format sector\n");
+      return -EIO;
+    }
 
-              /* Test if if the block is in use */
+  smart_normalizewear(dev);
+  memcpy(&dev->rwbuffer[SMART_FMT_WEARBASE_POS], &dev->wearbase,
+         sizeof(uint32_t));
 
-              header = (struct smart_sect_header_s *) dev->rwbuffer;
-              if (((header->status & SMART_STATUS_COMMITTED) ==
-                  (CONFIG_SMARTFS_ERASEDSTATE & SMART_STATUS_COMMITTED)) ||
-                  ((header->status & SMART_STATUS_RELEASED) !=
-                   (CONFIG_SMARTFS_ERASEDSTATE & SMART_STATUS_RELEASED)))
-                {
-                  /* This sector doesn't have live data (free or released).
-                   * just continue to the next sector and don't move it.
-                   */
+  nlevels = dev->sectorsize - SMARTFS_FMT_AGING_POS;
+  if (nlevels > dev->neraseblocks)
+    {
+      nlevels = dev->neraseblocks;
+    }
 
-                  continue;
-                }
+  memcpy(&dev->rwbuffer[SMARTFS_FMT_AGING_POS], dev->wearlevel, nlevels);
 
-              /* Find a new sector where it can live, NOT in this erase block */
+  ret = smart_relocatesector(dev, 0);
+  if (ret == OK)
+    {
+      dev->weardirty = 0;
+    }
 
-              newsector = smart_findfreephyssector(dev);
-              if (newsector == 0xFFFF)
-                {
-                  /* Unable to find a free sector!!! */
+  return ret;
+}
+#endif
 
-                  fdbg("Can't find a free sector for relocation\n");
-                  ret = -EIO;
-                  goto errout;
-                }
+/****************************************************************************
+ * Name: smart_findvictim
+ *
+ * Description:  Returns the erase block with the most released sectors (the
+ *               least worn one if there are several) or 0xFFFF if there are
+ *               no released sectors.  Also returns the total number of
+ *               released sectors.
+ *
+ ****************************************************************************/
 
-              /* Increment the sequence number and clear the "commit" flag */
+#ifdef CONFIG_FS_WRITABLE
+static uint16_t smart_findvictim(struct smart_struct_s *dev,
+                                 FAR uint16_t *releasedsectors)
+{
+  uint16_t  collectblock = 0xFFFF;
+  uint16_t  releasemax = 0;
+  uint16_t  released = 0;
+  int       x;
 
-              (*((uint16_t *) header->seq))++;
-              if (*((uint16_t *) header->seq) == 0xFFFF)
-                {
-                  *((uint16_t *) header->seq) = 1;
-                }
+  for (x = 0; x < dev->neraseblocks; x++)
+    {
+      released += dev->releasecount[x];
+      if (dev->releasecount[x] > releasemax
+#ifdef CONFIG_MTD_SMART_WEAR_LEVEL
+          || (dev->releasecount[x] == releasemax && releasemax > 0 &&
+              dev->wearlevel[x] < dev->wearlevel[collectblock])
+#endif
+         )
+        {
+          releasemax = dev->releasecount[x];
+          collectblock = x;
+        }
+    }
+
+  *releasedsectors = released;
+  return collectblock;
+}
+#endif
+
+/****************************************************************************
+ * Name: smart_collectblock
+ *
+ * Description:  Moves all live sectors out of an erase block and erases it.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FS_WRITABLE
+static int smart_collectblock(struct smart_struct_s *dev,
+                              uint16_t collectblock)
+{
+  smart_sector_t newsector;
+  smart_sector_t logsector;
+  smart_sector_t x;
+  int       ret;
+  size_t    offset;
+  struct    smart_sect_header_s *header;
+  uint8_t   newstatus;
+
+  fdbg("Collecting block %d, free=%d released=%d\n",
+      collectblock, dev->freecount[collectblock],
+      dev->releasecount[collectblock]);
+
+  /* Perform collection on the block.  First mark the block as having no
+   * free sectors so we don't try to move sectors into the block we are
+   * trying to erase.
+   */
+
+  dev->freecount[collectblock] = 0;
+
+  /* Next move all live data in the block to a new home. */
+
+  for (x = (smart_sector_t) collectblock * dev->sectorsPerBlk; x <
+     (smart_sector_t) (collectblock + 1) * dev->sectorsPerBlk; x++)
+    {
+      /* Read the next sector from this erase block */
+
+      ret = MTD_BREAD(dev->mtd, x * dev->mtdBlksPerSector,
+          dev->mtdBlksPerSector, (uint8_t *) dev->rwbuffer);
+      if (ret != dev->mtdBlksPerSector)
+        {
+          fdbg("Error reading sector %lu\n", (unsigned long) x);
+          return -EIO;
+        }
+
+      /* Test if if the block is in use */
+
+      header = (struct smart_sect_header_s *) dev->rwbuffer;
+      if (((header->status & SMART_STATUS_COMMITTED) ==
+          (CONFIG_SMARTFS_ERASEDSTATE & SMART_STATUS_COMMITTED)) ||
+          ((header->status & SMART_STATUS_RELEASED) !=
+           (CONFIG_SMARTFS_ERASEDSTATE & SMART_STATUS_RELEASED)))
+        {
+          /* This sector doesn't have live data (free or released).
+           * just continue to the next sector and don't move it.
+           */
+
+          continue;
+        }
+
+      /* Find a new sector where it can live, NOT in this erase block */
+
+      ret = smart_findfreephyssector(dev);
+      if (ret < 0)
+        {
+          /* Unable to find a free sector!!! */
+
+          fdbg("Can't find a free sector for relocation\n");
+          return -EIO;
+        }
+
+      newsector = (smart_sector_t) ret;
+
+      /* Increment the sequence number and clear the "commit" flag */
+
+      (*((uint16_t *) header->seq))++;
+      if (*((uint16_t *) header->seq) == 0xFFFF)
+        {
+          *((uint16_t *) header->seq) = 1;
+        }
 #if CONFIG_SMARTFS_ERASEDSTATE == 0xFF
-              header->status |= SMART_STATUS_COMMITTED;
+      header->status |= SMART_STATUS_COMMITTED;
 #else
-              header->status &= ~SMART_STATUS_COMMITTED;
+      header->status &= ~SMART_STATUS_COMMITTED;
 #endif
 
-              /* Write the data to the new physical sector location */
+      /* Write the data to the new physical sector location */
 
-              ret = MTD_BWRITE(dev->mtd, newsector * dev->mtdBlksPerSector,
-                               dev->mtdBlksPerSector, (uint8_t *) dev->rwbuffer);
+      ret = MTD_BWRITE(dev->mtd, newsector * dev->mtdBlksPerSector,
+                       dev->mtdBlksPerSector, (uint8_t *) dev->rwbuffer);
 
-              /* Commit the sector */
+      /* Commit the sector */
 
-              offset = newsector * dev->mtdBlksPerSector * dev->geo.blocksize +
-                  offsetof(struct smart_sect_header_s, status);
+      offset = newsector * dev->mtdBlksPerSector * dev->geo.blocksize +
+          offsetof(struct smart_sect_header_s, status);
 #if CONFIG_SMARTFS_ERASEDSTATE == 0xFF
-              newstatus = header->status & ~SMART_STATUS_COMMITTED;
+      newstatus = header->status & ~SMART_STATUS_COMMITTED;
 #else
-              newstatus = header->status | SMART_STATUS_COMMITTED;
+      newstatus = header->status | SMART_STATUS_COMMITTED;
 #endif
-              ret = smart_bytewrite(dev, offset, 1, &newstatus);
-              if (ret < 0)
-                {
-                  fdbg("Error %d committing new sector %d\n" -ret, newsector);
-                  goto errout;
-                }
+      ret = smart_bytewrite(dev, offset, 1, &newstatus);
+      if (ret < 0)
+        {
+          fdbg("Error %d committing new sector %lu\n", -ret,
+               (unsigned long) newsector);
+          return ret;
+        }
 
-              /* Release the old physical sector */
+      /* Release the old physical sector */
 
 #if CONFIG_SMARTFS_ERASEDSTATE == 0xFF
-              newstatus = header->status & ~SMART_STATUS_RELEASED;
+      newstatus = header->status & ~SMART_STATUS_RELEASED;
 #else
-              newstatus = header->status | SMART_STATUS_RELEASED;
+      newstatus = header->status | SMART_STATUS_RELEASED;
 #endif
-              offset = x * dev->mtdBlksPerSector * dev->geo.blocksize +
-                  offsetof(struct smart_sect_header_s, status);
-              ret = smart_bytewrite(dev, offset, 1, &newstatus);
-              if (ret < 0)
-                {
-                  fdbg("Error %d releasing old sector %d\n" -ret, x);
-                  goto errout;
-                }
+      offset = x * dev->mtdBlksPerSector * dev->geo.blocksize +
+          offsetof(struct smart_sect_header_s, status);
+      ret = smart_bytewrite(dev, offset, 1, &newstatus);
+      if (ret < 0)
+        {
+          fdbg("Error %d releasing old sector %lu\n", -ret,
+               (unsigned long) x);
+          return ret;
+        }
 
-              /* Update the variables */
+      /* Update the variables.  Sectors with an invalid logical sector number
+       * were never mapped by the scan.
+       */
 
-              dev->sMap[*((uint16_t *) header->logicalsector)] = newsector;
-              dev->freecount[newsector / dev->sectorsPerBlk]--;
-            }
+      logsector = SMART_GETLOGSECTOR(header);
+      if (logsector < dev->totalsectors)
+        {
+          (void)smart_setmap(dev, logsector, newsector);
+        }
 
-          /* Now erase the erase block */
+      dev->freecount[newsector / dev->sectorsPerBlk]--;
+    }
 
-          MTD_ERASE(dev->mtd, collectblock, 1);
+  /* Now erase the erase block */
 
-          dev->freesectors += dev->releasecount[collectblock];
-          dev->freecount[collectblock] = dev->sectorsPerBlk;
-          dev->releasecount[collectblock] = 0;
+  ret = smart_eraseblock(dev, collectblock);
 
-          /* If this is block zero, then be sure to write the sector size */
+  dev->freesectors += dev->releasecount[collectblock];
+  dev->freecount[collectblock] = dev->sectorsPerBlk;
+  dev->releasecount[collectblock] = 0;
+  return ret;
+}
+#endif /* CONFIG_FS_WRITABLE */
 
-          if (collectblock == 0)
-            {
-              /* Set the sector size in the 1st header */
+/****************************************************************************
+ * Name: smart_staticwear
+ *
+ * Description:  Static wear leveling.  If the least worn erase block that
+ *               holds live data lags the most worn erase block by more than
+ *               the threshold, its (cold) data is moved so that the block
+ *               can take its share of the writes.  Returns 1 if a block was
+ *               collected.
+ *
+ ****************************************************************************/
 
-              uint8_t sectsize = dev->sectorsize >> 7;
-#if ( CONFIG_SMARTFS_ERASEDSTATE == 0xFF )
-              newstatus = (uint8_t) ~SMART_STATUS_SIZEBITS | sectsize;
-#else
-              newstatus = (uint8_t) sectsize;
+#if defined(CONFIG_FS_WRITABLE) && defined(CONFIG_MTD_SMART_WEAR_LEVEL)
+static int smart_staticwear(struct smart_struct_s *dev)
+{
+  uint16_t  coldblock = 0xFFFF;
+  uint16_t  coldlive = 0;
+  uint16_t  live;
+  uint8_t   minlevel = 0xff;
+  uint8_t   maxlevel = 0;
+  int       x;
+  int       ret;
+
+  for (x = 0; x < dev->neraseblocks; x++)
+    {
+      if (dev->wearlevel[x] > maxlevel)
+        {
+          maxlevel = dev->wearlevel[x];
+        }
+
+      live = dev->sectorsPerBlk - dev->freecount[x] - dev->releasecount[x];
+      if (live > 0 && dev->wearlevel[x] < minlevel)
+        {
+          minlevel  = dev->wearlevel[x];
+          coldblock = x;
+          coldlive  = live;
+        }
+    }
+
+  if (coldblock == 0xFFFF ||
+      maxlevel - minlevel <= CONFIG_MTD_SMART_WEAR_THRESHOLD)
+    {
+      return 0;
+    }
+
+  /* The live sectors must fit outside of the block without using the
+   * sectors reserved for garbage collection.
+   */
+
+  if (dev->freesectors - dev->freecount[coldblock] <
+      coldlive + SMART_RESERVED_SECTORS(dev))
+    {
+      return 0;
+    }
+
+  fvdbg("Wear leveling block %d, level %d max %d\n",
+        coldblock, minlevel, maxlevel);
+
+  ret = smart_collectblock(dev, coldblock);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  dev->nwearmoves++;
+  return 1;
+}
 #endif
-              /* Write the sector size to the device */
 
-              offset = offsetof(struct smart_sect_header_s, status);
-              ret = smart_bytewrite(dev, offset, 1, &newstatus);
-              if (ret < 0)
-                {
-                  fdbg("Error %d setting sector 0 size\n", -ret);
-                }
+/****************************************************************************
+ * Name: smart_garbagecollect
+ *
+ * Description:  Performs garbage collection if needed.  This is determined
+ *               by the count of released sectors relative to free and
+ *               total sectors.  With background garbage collection, the
+ *               writer only collects when the reserved free sectors are
+ *               needed; otherwise the worker keeps sectors free.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FS_WRITABLE
+static int smart_garbagecollect(struct smart_struct_s *dev)
+{
+  uint16_t  releasedsectors;
+  uint16_t  collectblock;
+  uint32_t  start;
+  uint32_t  elapsed;
+  bool      collect = TRUE;
+  int       ncollected = 0;
+  int       ret = OK;
+
+  start = clock_systimer();
+  while (collect)
+    {
+      collect = FALSE;
+
+      /* Calculate the number of released sectors on the device */
+
+      collectblock = smart_findvictim(dev, &releasedsectors);
+
+#ifndef CONFIG_MTD_SMART_BGGC
+      /* Test if the released sectors count is greater than the
+       * free sectors.  If it is, then we will do garbage collection.
+       */
+
+      if (releasedsectors > dev->freesectors)
+        collect = TRUE;
+#endif
+
+      /* Test if we have more reached our reserved free sector limit */
+
+      if (dev->freesectors <= SMART_RESERVED_SECTORS(dev))
+        collect = TRUE;
+
+      /* Test if we need to garbage collect */
+
+      if (collect)
+        {
+          if (collectblock == 0xFFFF)
+            {
+              /* Need to collect, but no sectors with released blocks! */
+
+              ret = -ENOSPC;
+              break;
+            }
+
+          ret = smart_collectblock(dev, collectblock);
+          if (ret < 0)
+            {
+              break;
             }
 
-          /* Update the block aging information in the format signature sector */
+          ncollected++;
         }
-      else
+    }
+
+#ifdef CONFIG_MTD_SMART_WEAR_LEVEL
+  if (ret == OK)
+    {
+#ifndef CONFIG_MTD_SMART_BGGC
+      /* Test for aging sectors and push them to a new location
+       * so we wear evenly.
+       */
+
+      ret = smart_staticwear(dev);
+      if (ret > 0)
         {
-          /* Test for aging sectors and push them to a new location
-           * so we wear evenly.
-           */
+          ncollected++;
+          ret = OK;
+        }
+#endif
+
+      /* Update the block aging information in the format signature sector
+       * after about one erase per erase block.
+       */
+
+      if (dev->weardirty >= dev->neraseblocks)
+        {
+          (void)smart_savewear(dev);
         }
     }
+#endif
 
-  return OK;
+  /* Update the garbage collection latency statistics */
+
+  if (ncollected > 0)
+    {
+      elapsed = clock_systimer() - start;
+      dev->ncollections += ncollected;
+      dev->gctotaltime  += elapsed;
+      if (elapsed > dev->gcmaxtime)
+        {
+          dev->gcmaxtime = elapsed;
+        }
+    }
 
-errout:
   return ret;
 }
 #endif /* CONFIG_FS_WRITABLE */
 
+/****************************************************************************
+ * Name: smart_gcworker
+ *
+ * Description:  Background garbage collection.  Collects one erase block at
+ *               a time (so that the device is not locked for long) until
+ *               the free sector target is met, then levels static wear and
+ *               saves the wear levels.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MTD_SMART_BGGC
+static void smart_gcworker(FAR void *arg)
+{
+  FAR struct smart_struct_s *dev = (FAR struct smart_struct_s *)arg;
+  uint16_t  releasedsectors;
+  uint16_t  collectblock;
+  uint32_t  start;
+  int       ret = 0;
+
+  smart_semtake(dev);
+  start = clock_systimer();
+
+  collectblock = smart_findvictim(dev, &releasedsectors);
+  if (collectblock != 0xFFFF &&
+      dev->freesectors < SMART_BGGC_FREESECTORS(dev))
+    {
+      ret = smart_collectblock(dev, collectblock);
+      if (ret == OK)
+        {
+          dev->nbgcollections++;
+          ret = 1;
+        }
+    }
+#ifdef CONFIG_MTD_SMART_WEAR_LEVEL
+  else
+    {
+      ret = smart_staticwear(dev);
+      if (ret == 0 && dev->weardirty > 0)
+        {
+          (void)smart_savewear(dev);
+        }
+    }
+#endif
+
+  dev->bgtotaltime += clock_systimer() - start;
+
+  /* Continue later unless a writer has already re-scheduled the work */
+
+  if (ret > 0 && work_available(&dev->work))
+    {
+      (void)work_queue(LPWORK, &dev->work, smart_gcworker, dev, 0);
+    }
+
+  smart_semgive(dev);
+}
+#endif
+
 /****************************************************************************
  * Name: smart_writesector
  *
@@ -1460,10 +2318,9 @@ static inline int smart_writesector(struct smart_struct_s *dev, unsigned long ar
   int       ret;
   uint16_t  x;
   bool      needsrelocate = FALSE;
-  uint16_t  mtdblock;
-  uint16_t  physsector;
+  uint32_t  mtdblock;
+  smart_sector_t physsector;
   struct    smart_read_write_s *req;
-  struct    smart_sect_header_s *header;
   size_t    offset;
   uint8_t   byte;
 
@@ -1476,16 +2333,17 @@ static inline int smart_writesector(struct smart_struct_s *dev, unsigned long ar
 
   if (req->logsector >= dev->totalsectors)
     {
-      fdbg("Logical sector %d too large\n", req->logsector);
+      fdbg("Logical sector %lu too large\n", (unsigned long) req->logsector);
 
       ret = -EINVAL;
       goto errout;
     }
 
-  physsector = dev->sMap[req->logsector];
-  if (physsector == 0xFFFF)
+  physsector = smart_getmap(dev, req->logsector);
+  if (physsector == SMART_SECTOR_NONE)
     {
-      fdbg("Logical sector %d not allocated\n", req->logsector);
+      fdbg("Logical sector %lu not allocated\n",
+           (unsigned long) req->logsector);
       ret = -EINVAL;
       goto errout;
     }
@@ -1497,7 +2355,7 @@ static inline int smart_writesector(struct smart_struct_s *dev, unsigned long ar
           dev->rwbuffer);
   if (ret != dev->mtdBlksPerSector)
     {
-      fdbg("Error reading phys sector %d\n", physsector);
+      fdbg("Error reading phys sector %lu\n", (unsigned long) physsector);
       ret = -EIO;
       goto errout;
     }
@@ -1524,29 +2382,6 @@ static inline int smart_writesector(struct smart_struct_s *dev, unsigned long ar
 #endif
     }
 
-  if (needsrelocate)
-    {
-      /* Find a new physical sector to save data to */
-
-      physsector = smart_findfreephyssector(dev);
-      if (physsector == 0xFFFF)
-        {
-          fdbg("Error relocating sector %d\n", req->logsector);
-          ret = -EIO;
-          goto errout;
-        }
-
-      /* Update the sequence number to indicate the sector was moved */
-
-      header = (struct smart_sect_header_s *) dev->rwbuffer;
-      (*((uint16_t *) header->seq))++;
-#if CONFIG_SMARTFS_ERASEDSTATE == 0xFF
-      header->status |= SMART_STATUS_COMMITTED;
-#else
-      header->status &= SMART_STATUS_COMMITTED;
-#endif
-    }
-
   /* Now copy the data to the sector buffer. */
 
   memcpy(&dev->rwbuffer[sizeof(struct smart_sect_header_s) + req->offset],
@@ -1556,56 +2391,16 @@ static inline int smart_writesector(struct smart_struct_s *dev, unsigned long ar
 
   if (needsrelocate)
     {
-      /* Write the entire sector to the new physical location, uncommitted. */
-
-      ret = MTD_BWRITE(dev->mtd, physsector * dev->mtdBlksPerSector,
-              dev->mtdBlksPerSector, (uint8_t *) dev->rwbuffer);
-      if (ret != dev->mtdBlksPerSector)
-        {
-          fdbg("Error writing to physical sector %d\n", physsector);
-          ret = -EIO;
-          goto errout;
-        }
-
-      /* Commit the new physical sector */
+      /* Write the entire sector to a new physical location and release
+       * the old one.
+       */
 
-#if CONFIG_SMARTFS_ERASEDSTATE == 0xFF
-      byte = header->status & ~SMART_STATUS_COMMITTED;
-#else
-      byte = header->status | SMART_STATUS_COMMITTED;
-#endif
-      offset = physsector * dev->mtdBlksPerSector * dev->geo.blocksize +
-          offsetof(struct smart_sect_header_s, status);
-      ret = smart_bytewrite(dev, offset, 1, &byte);
-      if (ret != 1)
+      ret = smart_relocatesector(dev, req->logsector);
+      if (ret < 0)
         {
-          fvdbg("Error committing physical sector %d\n", physsector);
-          ret = -EIO;
           goto errout;
         }
 
-      /* Release the old physical sector */
-
-#if CONFIG_SMARTFS_ERASEDSTATE == 0xFF
-      byte = header->status & ~SMART_STATUS_RELEASED;
-#else
-      byte = header->status | SMART_STATUS_RELEASED;
-#endif
-      offset = mtdblock * dev->geo.blocksize +
-          offsetof(struct smart_sect_header_s, status);
-      ret = smart_bytewrite(dev, offset, 1, &byte);
-
-      /* Update releasecount for released sector and freecount for the
-       * newly allocated physical sector. */
-
-      dev->releasecount[dev->sMap[req->logsector] / dev->sectorsPerBlk]++;
-      dev->freecount[physsector / dev->sectorsPerBlk]--;
-      dev->freesectors--;
-
-      /* Update the sector map */
-
-      dev->sMap[req->logsector] = physsector;
-
       /* Since we performed a relocation, do garbage collection to
        * ensure we don't fill up our flash with released blocks.
        */
@@ -1641,7 +2436,7 @@ static inline int smart_readsector(struct smart_struct_s *dev, unsigned long arg
 {
   int       ret;
   uint32_t  readaddr;
-  uint16_t  physsector;
+  smart_sector_t physsector;
   struct smart_read_write_s *req;
   struct smart_sect_header_s header;
 
@@ -1654,16 +2449,17 @@ static inline int smart_readsector(struct smart_struct_s *dev, unsigned long arg
 
   if (req->logsector >= dev->totalsectors)
     {
-      fdbg("Logical sector %d too large\n", req->logsector);
+      fdbg("Logical sector %lu too large\n", (unsigned long) req->logsector);
 
       ret = -EINVAL;
       goto errout;
     }
 
-  physsector = dev->sMap[req->logsector];
-  if (physsector == 0xFFFF)
+  physsector = smart_getmap(dev, req->logsector);
+  if (physsector == SMART_SECTOR_NONE)
     {
-      fdbg("Logical sector %d not allocated\n", req->logsector);
+      fdbg("Logical sector %lu not allocated\n",
+           (unsigned long) req->logsector);
       ret = -EINVAL;
       goto errout;
     }
@@ -1674,21 +2470,21 @@ static inline int smart_readsector(struct smart_struct_s *dev, unsigned long arg
           sizeof(struct smart_sect_header_s), (uint8_t *) &header);
   if (ret != sizeof(struct smart_sect_header_s))
     {
-      fvdbg("Error reading sector %d header\n", physsector);
+      fvdbg("Error reading sector %lu header\n", (unsigned long) physsector);
       ret = -EIO;
       goto errout;
     }
 
   /* Do a sanity check on the header data */
 
-  if (((*(uint16_t *) header.logicalsector) != req->logsector) ||
+  if ((SMART_GETLOGSECTOR(&header) != req->logsector) ||
       ((header.status & SMART_STATUS_COMMITTED) ==
        (CONFIG_SMARTFS_ERASEDSTATE & SMART_STATUS_COMMITTED)))
     {
       /* Error in sector header! How do we handle this? */
 
-      fdbg("Error in logical sector %d header, phys=%d\n",
-          req->logsector, physsector);
+      fdbg("Error in logical sector %lu header, phys=%lu\n",
+          (unsigned long) req->logsector, (unsigned long) physsector);
       ret = -EIO;
       goto errout;
     }
@@ -1702,7 +2498,7 @@ static inline int smart_readsector(struct smart_struct_s *dev, unsigned long arg
           req->buffer);
   if (ret != req->count)
     {
-      fdbg("Error reading phys sector %d\n", physsector);
+      fdbg("Error reading phys sector %lu\n", (unsigned long) physsector);
       ret = -EIO;
       goto errout;
     }
@@ -1722,11 +2518,12 @@ errout:
 #ifdef CONFIG_FS_WRITABLE
 static inline int smart_allocsector(struct smart_struct_s *dev, unsigned long requested)
 {
-  int       x;
+  smart_sector_t x;
+  uint32_t  page;
   int       ret;
-  uint16_t  logsector = 0xFFFF; /* Logical sector number selected */
-  uint16_t  physicalsector;     /* The selected physical sector */
-  uint16_t  releasecount;
+  smart_sector_t logsector = SMART_SECTOR_NONE; /* Logical sector number selected */
+  smart_sector_t physicalsector;                /* The selected physical sector */
+  uint32_t  releasecount;
   struct    smart_sect_header_s  *header;
   uint8_t   sectsize;
 
@@ -1740,7 +2537,7 @@ static inline int smart_allocsector(struct smart_struct_s *dev, unsigned long re
       releasecount += dev->releasecount[x];
     }
 
-  if (dev->freesectors <= (dev->sectorsPerBlk << 0) + 4)
+  if (dev->freesectors <= SMART_RESERVED_SECTORS(dev))
     {
       /* We are at our free sector limit.  Test if we have
        * sectors we can release */
@@ -1754,13 +2551,15 @@ static inline int smart_allocsector(struct smart_struct_s *dev, unsigned long re
     }
 
   /* Check if a specific sector is being requested and allocate that
-   * sector if it isn't already in use */
+   * sector if it isn't already in use.  SMART_SECTOR_NONE (or any other
+   * out of range sector number) requests any free sector.
+   */
 
   if ((requested > 2) && (requested < dev->totalsectors))
     {
       /* Validate the sector is not already allocated */
 
-      if (dev->sMap[requested] == (uint16_t) -1)
+      if (smart_getmap(dev, requested) == SMART_SECTOR_NONE)
         {
           logsector = requested;
         }
@@ -1768,25 +2567,37 @@ static inline int smart_allocsector(struct smart_struct_s *dev, unsigned long re
 
   /* Check if we need to scan for an available logical sector */
 
-  if (logsector == 0xFFFF)
+  if (logsector == SMART_SECTOR_NONE)
     {
-      /* Loop through all sectors and find one to allocate */
+      /* Loop through all sectors and find one to allocate.  Pages of the
+       * map that are full are skipped without looking at their entries.
+       */
 
-      for (x = SMART_FIRST_ALLOC_SECTOR; x < dev->totalsectors; x++)
+      x = SMART_FIRST_ALLOC_SECTOR;
+      while (x < dev->totalsectors)
         {
-          if (dev->sMap[x] == (uint16_t) -1)
+          page = x >> SMART_MAP_PAGESHIFT;
+          if (dev->mapcount[page] == SMART_MAP_PAGESIZE)
+            {
+              x = (smart_sector_t) (page + 1) << SMART_MAP_PAGESHIFT;
+              continue;
+            }
+
+          if (smart_getmap(dev, x) == SMART_SECTOR_NONE)
             {
               /* Unused logical sector found.  Use this one */
 
               logsector = x;
               break;
             }
+
+          x++;
         }
     }
 
   /* Test for an error allocating a sector */
 
-  if (logsector == 0xFFFF)
+  if (logsector == SMART_SECTOR_NONE)
     {
       /* Hmmm.  We think we had enough logical sectors, but
        * something happened and we didn't find any free
@@ -1794,8 +2605,8 @@ static inline int smart_allocsector(struct smart_struct_s *dev, unsigned long re
        * rescan and try again to "self heal" in case of a
        * bug in our code? */
 
-      fdbg("No free logical sector numbers!  Free sectors = %d\n",
-              dev->freesectors);
+      fdbg("No free logical sector numbers!  Free sectors = %lu\n",
+              (unsigned long) dev->freesectors);
 
       return -EIO;
     }
@@ -1810,16 +2621,33 @@ static inline int smart_allocsector(struct smart_struct_s *dev, unsigned long re
 
   /* Find a free physical sector */
 
-  physicalsector = smart_findfreephyssector(dev);
-  fvdbg("Alloc: log=%d, phys=%d, erase block=%d, free=%d, released=%d\n",
-          logsector, physicalsector, physicalsector /
-          dev->sectorsPerBlk, dev->freesectors, releasecount);
+  ret = smart_findfreephyssector(dev);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  physicalsector = (smart_sector_t) ret;
+  fvdbg("Alloc: log=%lu, phys=%lu, erase block=%lu, free=%lu, released=%lu\n",
+          (unsigned long) logsector, (unsigned long) physicalsector,
+          (unsigned long) (physicalsector / dev->sectorsPerBlk),
+          (unsigned long) dev->freesectors, (unsigned long) releasecount);
+
+  /* Map the sector first.  This may need to allocate a page of the map and
+   * nothing has been written to the device if that fails.
+   */
+
+  ret = smart_setmap(dev, logsector, physicalsector);
+  if (ret < 0)
+    {
+      return ret;
+    }
 
   /* Create a header to assign the logical sector */
 
   memset(dev->rwbuffer, CONFIG_SMARTFS_ERASEDSTATE, dev->sectorsize);
   header = (struct smart_sect_header_s *) dev->rwbuffer;
-  *((uint16_t *) header->logicalsector) = logsector;
+  SMART_SETLOGSECTOR(header, logsector);
   *((uint16_t *) header->seq) = 0;
   sectsize = dev->sectorsize >> 7;
 
@@ -1834,22 +2662,22 @@ static inline int smart_allocsector(struct smart_struct_s *dev, unsigned long re
 
   x = physicalsector * dev->mtdBlksPerSector;
 
-  fvdbg("Write MTD block %d\n", x);
+  fvdbg("Write MTD block %lu\n", (unsigned long) x);
   ret = MTD_BWRITE(dev->mtd, x, 1, (uint8_t *) dev->rwbuffer);
   if (ret != 1)
     {
       /* The block is not empty!!  What to do? */
 
-      fdbg("Write block %d failed: %d.\n", x, ret);
+      fdbg("Write block %lu failed: %d.\n", (unsigned long) x, ret);
+      (void)smart_setmap(dev, logsector, SMART_SECTOR_NONE);
 
       /* Unlock the mutex if we add one */
 
       return -EIO;
     }
 
-  /* Map the sector and update the free sector counts */
+  /* Update the free sector counts */
 
-  dev->sMap[logsector] = physicalsector;
   dev->freecount[physicalsector / dev->sectorsPerBlk]--;
   dev->freesectors--;
 
@@ -1873,29 +2701,33 @@ static inline int smart_freesector(struct smart_struct_s *dev, unsigned long
         logicalsector)
 {
   int       ret;
-  int       readaddr;
-  uint16_t  physsector;
+  size_t    readaddr;
+  smart_sector_t physsector;
   uint16_t  block;
   struct    smart_sect_header_s  header;
   size_t    offset;
 
   /* Check if the logical sector is within bounds */
 
-  if ((logicalsector > 2) && (logicalsector < dev->totalsectors))
+  if (logicalsector >= dev->totalsectors)
     {
-      /* Validate the sector is actually allocated */
+      fdbg("Invalid release - sector %lu out of range\n", logicalsector);
+      ret = -EINVAL;
+      goto errout;
+    }
 
-      if (dev->sMap[logicalsector] == (uint16_t) -1)
-        {
-          fdbg("Invalid release - sector %d not allocated\n", logicalsector);
-          ret = -EINVAL;
-          goto errout;
-        }
+  /* Validate the sector is actually allocated */
+
+  physsector = smart_getmap(dev, logicalsector);
+  if (physsector == SMART_SECTOR_NONE)
+    {
+      fdbg("Invalid release - sector %lu not allocated\n", logicalsector);
+      ret = -EINVAL;
+      goto errout;
     }
 
   /* Okay to release the sector.  Read the sector header info */
 
-  physsector = dev->sMap[logicalsector];
   readaddr = physsector * dev->mtdBlksPerSector * dev->geo.blocksize;
   ret = MTD_READ(dev->mtd, readaddr, sizeof(struct smart_sect_header_s),
                  (uint8_t *) &header);
@@ -1906,11 +2738,11 @@ static inline int smart_freesector(struct smart_struct_s *dev, unsigned long
 
   /* Do a sanity check on the logical sector number */
 
-  if (*((uint16_t *) header.logicalsector) != (uint16_t) logicalsector)
+  if (SMART_GETLOGSECTOR(&header) != (smart_sector_t) logicalsector)
     {
       /* Hmmm... something is wrong.  This should always match!  Bug in our code? */
 
-      fdbg("Sector %d logical sector in header doesn't match\n", logicalsector);
+      fdbg("Sector %lu logical sector in header doesn't match\n", logicalsector);
       ret = -EINVAL;
       goto errout;
     }
@@ -1929,7 +2761,8 @@ static inline int smart_freesector(struct smart_struct_s *dev, unsigned long
   ret = smart_bytewrite(dev, offset, 1, &header.status);
   if (ret != 1)
     {
-      fdbg("Error updating physicl sector %d status\n", physsector);
+      fdbg("Error updating physicl sector %lu status\n",
+           (unsigned long) physsector);
       goto errout;
     }
 
@@ -1940,7 +2773,7 @@ static inline int smart_freesector(struct smart_struct_s *dev, unsigned long
 
   /* Unmap this logical sector */
 
-  dev->sMap[logicalsector] = (uint16_t) -1;
+  (void)smart_setmap(dev, logicalsector, SMART_SECTOR_NONE);
 
   /* If this block has only released blocks, then erase it */
 
@@ -1948,11 +2781,15 @@ static inline int smart_freesector(struct smart_struct_s *dev, unsigned long
     {
       /* Erase the block */
 
-      MTD_ERASE(dev->mtd, block, 1);
+      ret = smart_eraseblock(dev, block);
 
       dev->freesectors += dev->releasecount[block];
       dev->releasecount[block] = 0;
       dev->freecount[block] = dev->sectorsPerBlk;
+      if (ret < 0)
+        {
+          goto errout;
+        }
     }
 
   ret = OK;
@@ -1962,6 +2799,79 @@ errout:
 }
 #endif /* CONFIG_FS_WRITABLE */
 
+/****************************************************************************
+ * Name: smart_getprocfsd
+ *
+ * Description:  Returns the device status and statistics for the SMARTFS
+ *               procfs entries.
+ *
+ ****************************************************************************/
+
+static int smart_getprocfsd(struct smart_struct_s *dev, unsigned long arg)
+{
+  FAR struct smart_procfs_data_s *data;
+  int       x;
+
+  data = (FAR struct smart_procfs_data_s *) arg;
+  DEBUGASSERT(data);
+
+  data->sectorsize     = dev->sectorsize;
+  data->formatversion  = dev->formatversion;
+  data->totalsectors   = dev->totalsectors;
+  data->freesectors    = dev->freesectors;
+  data->neraseblocks   = dev->neraseblocks;
+  data->sectorsperblk  = dev->sectorsPerBlk;
+  data->nerases        = dev->nerases;
+  data->ncollections   = dev->ncollections;
+  data->nbgcollections = dev->nbgcollections;
+  data->nwearmoves     = dev->nwearmoves;
+  data->gcmaxtime      = TICK2MSEC(dev->gcmaxtime);
+  data->gctotaltime    = TICK2MSEC(dev->gctotaltime);
+  data->bgtotaltime    = TICK2MSEC(dev->bgtotaltime);
+  data->scantime       = TICK2MSEC(dev->scantime);
+
+  /* The RAM used by the sector map:  The page table, the page counts and
+   * the pages that are allocated.
+   */
+
+  data->mapsize        = dev->nmappages * (sizeof(FAR smart_sector_t *) + 1) +
+                         dev->mappages * SMART_MAP_PAGESIZE *
+                         sizeof(smart_sector_t);
+
+  data->releasesectors = 0;
+  for (x = 0; x < dev->neraseblocks; x++)
+    {
+      data->releasesectors += dev->releasecount[x];
+    }
+
+#ifdef CONFIG_MTD_SMART_WEAR_LEVEL
+  data->wearbase  = dev->wearbase;
+  data->minwear   = 0xff;
+  data->maxwear   = 0;
+  data->wearlevel = dev->wearlevel;
+
+  for (x = 0; x < dev->neraseblocks; x++)
+    {
+      if (dev->wearlevel[x] < data->minwear)
+        {
+          data->minwear = dev->wearlevel[x];
+        }
+
+      if (dev->wearlevel[x] > data->maxwear)
+        {
+          data->maxwear = dev->wearlevel[x];
+        }
+    }
+#else
+  data->wearbase  = 0;
+  data->minwear   = 0;
+  data->maxwear   = 0;
+  data->wearlevel = NULL;
+#endif
+
+  return OK;
+}
+
 /****************************************************************************
  * Name: smart_ioctl
  *
@@ -1987,6 +2897,7 @@ static int smart_ioctl(FAR struct inode *inode, int cmd, unsigned long arg)
    * to directly to the underlying MTD device.
    */
 
+  smart_semtake(dev);
   switch (cmd)
     {
     case BIOC_XIPBASE:
@@ -1999,7 +2910,8 @@ static int smart_ioctl(FAR struct inode *inode, int cmd, unsigned long arg)
       if (arg == 0)
         {
           fdbg("ERROR: BIOC_XIPBASE argument is NULL\n");
-          return -EINVAL;
+          ret = -EINVAL;
+          goto ok_out;
         }
 #endif
 
@@ -2026,6 +2938,13 @@ static int smart_ioctl(FAR struct inode *inode, int cmd, unsigned long arg)
       ret = smart_readsector(dev, arg);
       goto ok_out;
 
+    case BIOC_GETPROCFSD:
+
+      /* Return the status information for the procfs */
+
+      ret = smart_getprocfsd(dev, arg);
+      goto ok_out;
+
 #ifdef CONFIG_FS_WRITABLE
     case BIOC_LLFORMAT:
 
@@ -2039,21 +2958,21 @@ static int smart_ioctl(FAR struct inode *inode, int cmd, unsigned long arg)
       /* Allocate a logical sector for the upper layer file system */
 
       ret = smart_allocsector(dev, arg);
-      goto ok_out;
+      goto gc_out;
 
     case BIOC_FREESECT:
 
       /* Free the specified logical sector */
 
       ret = smart_freesector(dev, arg);
-      goto ok_out;
+      goto gc_out;
 
     case BIOC_WRITESECT:
 
       /* Write to the sector */
 
       ret = smart_writesector(dev, arg);
-      goto ok_out;
+      goto gc_out;
 #endif /* CONFIG_FS_WRITABLE */
 
     }
@@ -2069,7 +2988,21 @@ static int smart_ioctl(FAR struct inode *inode, int cmd, unsigned long arg)
       fdbg("ERROR: MTD ioctl(%04x) failed: %d\n", cmd, ret);
     }
 
+  goto ok_out;
+
+#ifdef CONFIG_FS_WRITABLE
+gc_out:
+#ifdef CONFIG_MTD_SMART_BGGC
+  /* Collect garbage after the device has been idle for a while */
+
+  (void)work_cancel(LPWORK, &dev->work);
+  (void)work_queue(LPWORK, &dev->work, smart_gcworker, dev,
+                   MSEC2TICK(CONFIG_MTD_SMART_GCDELAY));
+#endif
+#endif
+
 ok_out:
+  smart_semgive(dev);
   return ret;
 }
 
@@ -2094,7 +3027,6 @@ int smart_initialize(int minor, FAR struct mtd_dev_s *mtd, const char *partname)
 {
   struct smart_struct_s *dev;
   int ret = -ENOMEM;
-  uint32_t  totalsectors;
 #ifdef CONFIG_SMARTFS_MULTI_ROOT_DIRS
   struct smart_multiroot_device_s *rootdirdev;
 #endif
@@ -2135,26 +3067,26 @@ int smart_initialize(int minor, FAR struct mtd_dev_s *mtd, const char *partname)
       /* Set the sector size to the default for now */
 
       dev->sMap = NULL;
+      dev->nmappages = 0;
       dev->rwbuffer = NULL;
       ret = smart_setsectorsize(dev, CONFIG_MTD_SMART_SECTOR_SIZE);
       if (ret != OK)
         {
-          kfree(dev);
-          goto errout;
-        }
+          /* smart_setsectorsize() frees the device if an allocation
+           * failed.
+           */
 
-      /* Calculate the totalsectors on this device and validate */
+          if (ret != -ENOMEM)
+            {
+              kfree(dev);
+            }
 
-      totalsectors = dev->neraseblocks * dev->sectorsPerBlk;
-      if (totalsectors > 65534)
-        {
-          fdbg("SMART Sector size too small for device\n");
-          kfree(dev);
-          ret = -EINVAL;
           goto errout;
         }
 
-      dev->freesectors = (uint16_t) totalsectors;
+      dev->freesectors = dev->totalsectors;
+      dev->formatversion = 0;
+      dev->scantime = 0;
 
       /* Mark the device format status an unknown */
 
@@ -2173,6 +3105,39 @@ int smart_initialize(int minor, FAR struct mtd_dev_s *mtd, const char *partname)
       dev->minor = minor;
 #endif
 
+      dev->nerases        = 0;
+      dev->ncollections   = 0;
+      dev->nbgcollections = 0;
+      dev->nwearmoves     = 0;
+      dev->gcmaxtime      = 0;
+      dev->gctotaltime    = 0;
+      dev->bgtotaltime    = 0;
+
+#ifdef CONFIG_MTD_SMART_WEAR_LEVEL
+      /* Allocate the wear levels.  They are read from the format sector
+       * by the scan.
+       */
+
+      dev->wearlevel = (FAR uint8_t *) kzalloc(dev->neraseblocks);
+      if (!dev->wearlevel)
+        {
+          fdbg("Error allocating SMART wear levels\n");
+          smart_freemap(dev);
+          kfree(dev->rwbuffer);
+          kfree(dev);
+          ret = -ENOMEM;
+          goto errout;
+        }
+
+      dev->wearbase  = 0;
+      dev->weardirty = 0;
+#endif
+
+#ifdef CONFIG_MTD_SMART_BGGC
+      sem_init(&dev->exclsem, 0, 1);
+      dev->work.worker = NULL;
+#endif
+
       /* Create a MTD block device name */
 
 #ifdef CONFIG_SMARTFS_MULTI_ROOT_DIRS
@@ -2193,8 +3158,11 @@ int smart_initialize(int minor, FAR struct mtd_dev_s *mtd, const char *partname)
       if (rootdirdev == NULL)
         {
           fdbg("register_blockdriver failed: %d\n", -ret);
-          kfree(dev->sMap);
+          smart_freemap(dev);
           kfree(dev->rwbuffer);
+#ifdef CONFIG_MTD_SMART_WEAR_LEVEL
+          kfree(dev->wearlevel);
+#endif
           kfree(dev);
           ret = -ENOMEM;
           goto errout;
@@ -2224,8 +3192,11 @@ int smart_initialize(int minor, FAR struct mtd_dev_s *mtd, const char *partname)
       if (ret < 0)
         {
           fdbg("register_blockdriver failed: %d\n", -ret);
-          kfree(dev->sMap);
+          smart_freemap(dev);
           kfree(dev->rwbuffer);
+#ifdef CONFIG_MTD_SMART_WEAR_LEVEL
+          kfree(dev->wearlevel);
+#endif
           kfree(dev);
           goto errout;
         }
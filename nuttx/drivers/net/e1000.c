@@ -83,6 +83,25 @@
 
 #define BUF ((struct uip_eth_hdr *)e1000->uip_dev.d_buf)
 
+/* Address of the packet buffer attached to TX descriptor i */
+
+#define E1000_TXBUF(e,i) ((uint8_t *)((e)->tx_ring.buf + (i) * CONFIG_E1000_BUFF_SIZE))
+
+#ifdef CONFIG_NET_PKTQUEUE
+/* With driver packet queues, uIP builds outgoing frames directly in the TX
+ * ring buffers and responses in the RX ring buffers.  Each must be able to
+ * hold a full uIP buffer.
+ */
+
+#  if CONFIG_E1000_BUFF_SIZE < (CONFIG_NET_BUFSIZE + CONFIG_NET_GUARDSIZE)
+#    error CONFIG_E1000_BUFF_SIZE is too small for CONFIG_NET_PKTQUEUE
+#  endif
+
+/* Maximum number of received frames passed to uIP in one batch */
+
+#  define E1000_RXBATCH 16
+#endif
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -92,6 +111,9 @@ struct tx_ring
   struct tx_desc *desc;
   char *buf;
   int tail;      /* where to write desc */
+#ifdef CONFIG_NET_PKTQUEUE
+  int pending;   /* number of desc queued but not yet given to hardware */
+#endif
 };
 
 struct rx_ring
@@ -146,6 +168,10 @@ static struct e1000_dev_head e1000_list = {0};
 /* Common TX logic */
 
 static int  e1000_transmit(struct e1000_dev *e1000);
+#ifdef CONFIG_NET_PKTQUEUE
+static void e1000_txkick(struct e1000_dev *e1000);
+static int  e1000_txqueue(struct uip_driver_s *dev);
+#endif
 static int  e1000_uiptxpoll(struct uip_driver_s *dev);
 
 /* Interrupt handling */
@@ -347,6 +373,13 @@ void e1000_init(struct e1000_dev *dev)
     }
 
   dev->tx_ring.tail = 0;
+#ifdef CONFIG_NET_PKTQUEUE
+  dev->tx_ring.pending = 0;
+
+  /* uIP builds the next outgoing frame in place in the TX ring */
+
+  dev->uip_dev.d_buf = E1000_TXBUF(dev, 0);
+#endif
   e1000_outl(dev, E1000_TDT, 0);
   e1000_outl(dev, E1000_TDH, 0);
 
@@ -413,9 +446,12 @@ void e1000_init(struct e1000_dev *dev)
 static int e1000_transmit(struct e1000_dev *e1000)
 {
   int tail = e1000->tx_ring.tail;
-  unsigned char *cp = (unsigned char *)
-      (e1000->tx_ring.buf + tail * CONFIG_E1000_BUFF_SIZE);
+  unsigned char *cp = E1000_TXBUF(e1000, tail);
   int count = e1000->uip_dev.d_len;
+#ifdef CONFIG_NET_ZEROCOPY
+  int extlen = e1000->uip_dev.d_extlen;
+  int next = (tail + 1) % CONFIG_E1000_N_TX_DESC;
+#endif
 
   /* Verify that the hardware is ready to send another packet.  If we get
    * here, then we are committed to sending a packet; Higher level logic
@@ -429,19 +465,77 @@ static int e1000_transmit(struct e1000_dev *e1000)
 
   /* Increment statistics */
 
-  /* Send the packet: address=skel->sk_dev.d_buf, length=skel->sk_dev.d_len */
+  /* Send the packet: address=skel->sk_dev.d_buf, length=skel->sk_dev.d_len.
+   * With packet queues, the frame is usually already in place in the TX
+   * ring buffer.
+   */
+
+#ifdef CONFIG_NET_ZEROCOPY
+  /* Restore the descriptor in case it was last used for zero-copy data */
+
+  e1000->tx_ring.desc[tail].base_address = PADDR((uintptr_t)cp);
+  e1000->tx_ring.desc[tail].desc_command = (1<<0)|(1<<1)|(1<<3);
 
-  memcpy(cp, e1000->uip_dev.d_buf, e1000->uip_dev.d_len);
+  /* A payload outside of d_buf is sent from a second descriptor (without
+   * the EOP bit on the first).  If that descriptor is not free, or if the
+   * frame needs to be padded, then the payload is copied after all.
+   */
+
+  if (extlen > 0)
+    {
+      count -= extlen;
+      if (e1000->uip_dev.d_buf != cp)
+        {
+          memcpy(cp, e1000->uip_dev.d_buf, count);
+        }
+
+      if (count + extlen < 60 || !e1000->tx_ring.desc[next].desc_status)
+        {
+          memcpy(cp + count, e1000->uip_dev.d_extdata, extlen);
+          count += extlen;
+          extlen = 0;
+        }
+    }
+  else
+#endif
+  if (e1000->uip_dev.d_buf != cp)
+    {
+      memcpy(cp, e1000->uip_dev.d_buf, e1000->uip_dev.d_len);
+    }
 
   /* prepare the transmit-descriptor */
 
   e1000->tx_ring.desc[tail].packet_length = count<60 ? 60:count;
+
+#ifdef CONFIG_NET_ZEROCOPY
+  if (extlen > 0)
+    {
+      e1000->tx_ring.desc[tail].packet_length = count;
+      e1000->tx_ring.desc[tail].desc_command  = (1<<1)|(1<<3);
+
+      e1000->tx_ring.desc[next].base_address =
+        PADDR((uintptr_t)e1000->uip_dev.d_extdata);
+      e1000->tx_ring.desc[next].packet_length = extlen;
+      e1000->tx_ring.desc[next].desc_command  = (1<<0)|(1<<1)|(1<<3);
+      e1000->tx_ring.desc[next].desc_status   = 0;
+      e1000->tx_ring.desc[tail].desc_status   = 0;
+
+      tail = next;
+    }
+#endif
+
   e1000->tx_ring.desc[tail].desc_status = 0;
 
   /* give ownership of this descriptor to the network controller */
 
   tail = (tail + 1) % CONFIG_E1000_N_TX_DESC;
   e1000->tx_ring.tail = tail;
+
+#ifdef CONFIG_NET_PKTQUEUE
+  /* The hardware tail is updated once for the whole batch by e1000_txkick() */
+
+  e1000->tx_ring.pending++;
+#else
   e1000_outl(e1000, E1000_TDT, tail);
 
   /* Enable Tx interrupts */
@@ -449,9 +543,74 @@ static int e1000_transmit(struct e1000_dev *e1000)
   /* Setup the TX timeout watchdog (perhaps restarting the timer) */
 
   wd_start(e1000->txtimeout, E1000_TXTIMEOUT, e1000_txtimeout, 1, (uint32_t)e1000);
+#endif
   return OK;
 }
 
+/****************************************************************************
+ * Function: e1000_txkick
+ *
+ * Description:
+ *   Give all frames queued by e1000_transmit() to the hardware with a single
+ *   update of the TX tail register.
+ *
+ * Parameters:
+ *   e1000  - Reference to the driver state structure
+ *
+ * Returned Value:
+ *   None
+ *
+ * Assumptions:
+ *   Global interrupts are disabled.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_PKTQUEUE
+static void e1000_txkick(struct e1000_dev *e1000)
+{
+  /* The next outgoing frame will be built in the new tail buffer */
+
+  e1000->uip_dev.d_buf = E1000_TXBUF(e1000, e1000->tx_ring.tail);
+
+  if (e1000->tx_ring.pending > 0)
+    {
+      e1000->tx_ring.pending = 0;
+      e1000_outl(e1000, E1000_TDT, e1000->tx_ring.tail);
+
+      /* Setup the TX timeout watchdog (perhaps restarting the timer) */
+
+      wd_start(e1000->txtimeout, E1000_TXTIMEOUT, e1000_txtimeout, 1,
+               (uint32_t)e1000);
+    }
+}
+
+/****************************************************************************
+ * Function: e1000_txqueue
+ *
+ * Description:
+ *   Queue a response to a received frame.  This is the uip_inputq()
+ *   callback.  The response is in the RX buffer and is copied into the TX
+ *   ring.
+ *
+ * Parameters:
+ *   dev  - Reference to the NuttX driver state structure
+ *
+ * Returned Value:
+ *   OK on success; a negated errno on failure
+ *
+ * Assumptions:
+ *   Global interrupts are disabled by interrupt handling logic.
+ *
+ ****************************************************************************/
+
+static int e1000_txqueue(struct uip_driver_s *dev)
+{
+  struct e1000_dev *e1000 = (struct e1000_dev *)dev->d_private;
+
+  return e1000_transmit(e1000);
+}
+#endif
+
 /****************************************************************************
  * Function: e1000_uiptxpoll
  *
@@ -479,7 +638,6 @@ static int e1000_transmit(struct e1000_dev *e1000)
 static int e1000_uiptxpoll(struct uip_driver_s *dev)
 {
   struct e1000_dev *e1000 = (struct e1000_dev *)dev->d_private;
-  int tail = e1000->tx_ring.tail;
 
   /* If the polling resulted in data that should be sent out on the network,
    * the field d_len is set to a value > 0.
@@ -490,11 +648,17 @@ static int e1000_uiptxpoll(struct uip_driver_s *dev)
       uip_arp_out(&e1000->uip_dev);
       e1000_transmit(e1000);
 
+#ifdef CONFIG_NET_PKTQUEUE
+      /* Build the next frame in place in the next TX ring buffer */
+
+      e1000->uip_dev.d_buf = E1000_TXBUF(e1000, e1000->tx_ring.tail);
+#endif
+
       /* Check if there is room in the device to hold another packet. If not,
        * return a non-zero value to terminate the poll.
        */
 
-      if (!e1000->tx_ring.desc[tail].desc_status)
+      if (!e1000->tx_ring.desc[e1000->tx_ring.tail].desc_status)
         {
           return -1;
         }
@@ -524,6 +688,73 @@ static int e1000_uiptxpoll(struct uip_driver_s *dev)
  *
  ****************************************************************************/
 
+#ifdef CONFIG_NET_PKTQUEUE
+static void e1000_receive(struct e1000_dev *e1000)
+{
+  struct uip_pktdesc_s rxq[E1000_RXBATCH];
+  int head = e1000->rx_ring.head;
+  int first;
+  int nrx;
+  int cnt;
+
+  while (e1000->rx_ring.desc[head].desc_status)
+    {
+      /* Collect a batch of received frames.  The frames are left in the RX
+       * ring buffers and are processed there by uIP.
+       */
+
+      first = head;
+      nrx   = 0;
+
+      do
+        {
+          /* Here we do not handle packets that exceed packet-buffer size */
+
+          cnt = e1000->rx_ring.desc[head].packet_length;
+          if ((e1000->rx_ring.desc[head].desc_status & 3) == 1)
+            {
+              cprintf("NIC READ: Oversized packet\n");
+            }
+          else if (cnt > CONFIG_NET_BUFSIZE || cnt < 14)
+            {
+              cprintf("NIC READ: invalid package size\n");
+            }
+          else
+            {
+              rxq[nrx].pd_buf = (uint8_t *)
+                (e1000->rx_ring.buf + head * CONFIG_E1000_BUFF_SIZE);
+              rxq[nrx].pd_len = cnt;
+              nrx++;
+            }
+
+          head = (head + 1) % CONFIG_E1000_N_RX_DESC;
+        }
+      while (nrx < E1000_RXBATCH && head != first &&
+             e1000->rx_ring.desc[head].desc_status);
+
+      /* Pass the whole batch to uIP.  Responses are queued in the TX ring
+       * and given to the hardware together.
+       */
+
+      if (nrx > 0)
+        {
+          (void)uip_inputq(&e1000->uip_dev, rxq, nrx, e1000_txqueue);
+          e1000_txkick(e1000);
+        }
+
+      /* Now the RX descriptors of the batch may be recycled */
+
+      while (first != head)
+        {
+          e1000->rx_ring.desc[first].desc_status = 0;
+          e1000->rx_ring.free++;
+          first = (first + 1) % CONFIG_E1000_N_RX_DESC;
+        }
+
+      e1000->rx_ring.head = head;
+    }
+}
+#else
 static void e1000_receive(struct e1000_dev *e1000)
 {
   int head = e1000->rx_ring.head;
@@ -609,6 +840,7 @@ next:
       cp = (unsigned char *)(e1000->rx_ring.buf + head * CONFIG_E1000_BUFF_SIZE);
     }
 }
+#endif
 
 /****************************************************************************
  * Function: e1000_txtimeout
@@ -642,6 +874,9 @@ static void e1000_txtimeout(int argc, uint32_t arg, ...)
   /* Then poll uIP for new XMIT data */
 
   (void)uip_poll(&e1000->uip_dev, e1000_uiptxpoll);
+#ifdef CONFIG_NET_PKTQUEUE
+  e1000_txkick(e1000);
+#endif
 }
 
 /****************************************************************************
@@ -669,19 +904,21 @@ static void e1000_polltimer(int argc, uint32_t arg, ...)
 
   /* Check if there is room in the send another TX packet.  We cannot perform
    * the TX poll if he are unable to accept another packet for transmission.
+   * With a TX ring this only happens when the whole ring is in flight.
    */
 
-  if (!e1000->tx_ring.desc[tail].desc_status)
+  if (e1000->tx_ring.desc[tail].desc_status)
     {
-      return;
-    }
-
-  /* If so, update TCP timing states and poll uIP for new XMIT data. Hmmm..
-   * might be bug here.  Does this mean if there is a transmit in progress,
-   * we will missing TCP time state updates?
-   */
+      /* If so, update TCP timing states and poll uIP for new XMIT data.
+       * Hmmm.. might be bug here.  Does this mean if there is a transmit in
+       * progress, we will missing TCP time state updates?
+       */
 
-  (void)uip_timer(&e1000->uip_dev, e1000_uiptxpoll, E1000_POLLHSEC);
+      (void)uip_timer(&e1000->uip_dev, e1000_uiptxpoll, E1000_POLLHSEC);
+#ifdef CONFIG_NET_PKTQUEUE
+      e1000_txkick(e1000);
+#endif
+    }
 
   /* Setup the watchdog poll timer again */
 
@@ -820,6 +1057,9 @@ static int e1000_txavail(struct uip_driver_s *dev)
       if (e1000->tx_ring.desc[tail].desc_status)
         {
           (void)uip_poll(&e1000->uip_dev, e1000_uiptxpoll);
+#ifdef CONFIG_NET_PKTQUEUE
+          e1000_txkick(e1000);
+#endif
         }
     }
 
@@ -939,6 +1179,9 @@ static irqreturn_t e1000_interrupt_handler(int irq, void *dev_id)
   if (intr_cause & (1<<0))
     {
       uip_poll(&e1000->uip_dev, e1000_uiptxpoll);
+#ifdef CONFIG_NET_PKTQUEUE
+      e1000_txkick(e1000);
+#endif
     }
 
 
@@ -1078,6 +1321,9 @@ static int e1000_probe(uint16_t addr, pci_id_t id)
   dev->uip_dev.d_rmmac   = e1000_rmmac;    /* Remove multicast MAC address */
 #endif
   dev->uip_dev.d_private = dev;            /* Used to recover private state from dev */
+#ifdef CONFIG_NET_ZEROCOPY
+  dev->uip_dev.d_zerocopy = true;          /* Can send payload from outside d_buf */
+#endif
 
   /* Create a watchdog for timing polling for and timing of transmisstions */
 
@@ -1,7 +1,7 @@
 /****************************************************************************
  * drivers/rwbuffer.c
  *
- *   Copyright (C) 2009, 2011, 2013 Gregory Nutt. All rights reserved.
+ *   Copyright (C) 2009, 2011, 2013-2014 Gregory Nutt. All rights reserved.
  *   Author: Gregory Nutt <gnutt@nuttx.org>
  *
  * Redistribution and use in source and binary forms, with or without
@@ -51,6 +51,7 @@
 #include <debug.h>
 
 #include <nuttx/kmalloc.h>
+#include <nuttx/clock.h>
 #include <nuttx/wqueue.h>
 #include <nuttx/rwbuffer.h>
 
@@ -62,7 +63,7 @@
 
 /* Configuration ************************************************************/
 
-#ifndef CONFIG_SCHED_WORKQUEUE
+#if defined(CONFIG_FS_WRITEBUFFER) && !defined(CONFIG_SCHED_WORKQUEUE)
 #  error "Worker thread support is required (CONFIG_SCHED_WORKQUEUE)"
 #endif
 
@@ -112,6 +113,11 @@ static void rwb_semtake(sem_t *sem)
 
 /****************************************************************************
  * Name: rwb_overlap
+ *
+ * Description:
+ *   Return true if the two block ranges have any block in common.  Empty
+ *   ranges never overlap and ranges that are only adjacent do not overlap.
+ *
  ****************************************************************************/
 
 static inline bool rwb_overlap(off_t blockstart1, size_t nblocks1,
@@ -122,8 +128,9 @@ static inline bool rwb_overlap(off_t blockstart1, size_t nblocks1,
 
   /* If the buffer 1 is wholly outside of buffer 2, return false */
 
-  if ((blockend1   < blockstart2) || /* Wholly "below" */
-      (blockstart1 > blockend2))     /* Wholly "above" */
+  if ((nblocks1 == 0) || (nblocks2 == 0) ||
+      (blockend1   <= blockstart2) ||  /* Wholly "below" */
+      (blockstart1 >= blockend2))      /* Wholly "above" */
     {
       return false;
     }
@@ -150,36 +157,45 @@ static inline void rwb_resetwrbuffer(struct rwbuffer_s *rwb)
 
 /****************************************************************************
  * Name: rwb_wrflush
+ *
+ * Description:
+ *   Write the content of the write buffer to the media.  The caller must
+ *   hold the wrsem.
+ *
  ****************************************************************************/
 
 #ifdef CONFIG_FS_WRITEBUFFER
-static void rwb_wrflush(struct rwbuffer_s *rwb)
+static int rwb_wrflush(struct rwbuffer_s *rwb)
 {
-  int ret;
+  int ret = OK;
 
-  fvdbg("Timeout!\n");
-  
-  rwb_semtake(&rwb->wrsem);
   if (rwb->wrnblocks)
     {
       fvdbg("Flushing: blockstart=0x%08lx nblocks=%d from buffer=%p\n",
-      (long)rwb->wrblockstart, rwb->wrnblocks, rwb->wrbuffer);
+            (long)rwb->wrblockstart, rwb->wrnblocks, rwb->wrbuffer);
 
       /* Flush cache.  On success, the flush method will return the number
        * of blocks written.  Anything other than the number requested is
        * an error.
        */
 
-      ret = rwb->wrflush(rwb->dev, rwb->wrbuffer, rwb->wrblockstart, rwb->wrnblocks);
+      ret = rwb->wrflush(rwb->dev, rwb->wrbuffer, rwb->wrblockstart,
+                         rwb->wrnblocks);
       if (ret != rwb->wrnblocks)
         {
           fdbg("ERROR: Error flushing write buffer: %d\n", ret);
+          ret = ret < 0 ? ret : -EIO;
         }
-      
+      else
+        {
+          ret = OK;
+        }
+
+      rwb->wrflushes++;
       rwb_resetwrbuffer(rwb);
     }
 
-  rwb_semgive(&rwb->wrsem);
+  return ret;
 }
 #endif
 
@@ -187,6 +203,7 @@ static void rwb_wrflush(struct rwbuffer_s *rwb)
  * Name: rwb_wrtimeout
  ****************************************************************************/
 
+#ifdef CONFIG_FS_WRITEBUFFER
 static void rwb_wrtimeout(FAR void *arg)
 {
   /* The following assumes that the size of a pointer is 4-bytes or less */
@@ -199,88 +216,109 @@ static void rwb_wrtimeout(FAR void *arg)
    * worker thread.
    */
 
-  rwb_wrflush(rwb);
+  fvdbg("Timeout!\n");
+
+  rwb_semtake(&rwb->wrsem);
+  (void)rwb_wrflush(rwb);
+  rwb_semgive(&rwb->wrsem);
 }
+#endif
 
 /****************************************************************************
  * Name: rwb_wrstarttimeout
  ****************************************************************************/
 
+#ifdef CONFIG_FS_WRITEBUFFER
 static void rwb_wrstarttimeout(FAR struct rwbuffer_s *rwb)
 {
-  /* CONFIG_FS_WRDELAY provides the delay period in milliseconds. CLK_TCK
-   * provides the clock tick of the system (frequency in Hz).
-   */
+  /* CONFIG_FS_WRDELAY provides the delay period in milliseconds */
 
-  int ticks = (CONFIG_FS_WRDELAY + CLK_TCK/2) / CLK_TCK;
+  int ticks = MSEC2TICK(CONFIG_FS_WRDELAY);
   (void)work_queue(LPWORK, &rwb->work, rwb_wrtimeout, (FAR void *)rwb, ticks);
 }
+#endif
 
 /****************************************************************************
  * Name: rwb_wrcanceltimeout
  ****************************************************************************/
 
+#ifdef CONFIG_FS_WRITEBUFFER
 static inline void rwb_wrcanceltimeout(struct rwbuffer_s *rwb)
 {
   (void)work_cancel(LPWORK, &rwb->work);
 }
+#endif
 
 /****************************************************************************
  * Name: rwb_writebuffer
+ *
+ * Description:
+ *   Add blocks to the write buffer.  Blocks that start inside of or
+ *   immediately after the buffered range are merged into the buffer so
+ *   that repeated writes to the same block and sequential streams are
+ *   coalesced into one transfer.  Anything else causes the buffer to be
+ *   flushed first.  The caller must hold the wrsem and nblocks must not
+ *   exceed wrmaxblocks.
+ *
  ****************************************************************************/
 
 #ifdef CONFIG_FS_WRITEBUFFER
 static ssize_t rwb_writebuffer(FAR struct rwbuffer_s *rwb,
-                               off_t startblock, uint32_t nblocks,
+                               off_t startblock, size_t nblocks,
                                FAR const uint8_t *wrbuffer)
 {
+  off_t endblock = startblock + nblocks;
   int ret;
 
   /* Write writebuffer Logic */
 
   rwb_wrcanceltimeout(rwb);
-  
+
   /* First: Should we flush out our cache? We would do that if (1) we already
-   * buffering blocks and the next block writing is not in the same sequence,
-   * or (2) the number of blocks would exceed our allocated buffer capacity
+   * buffering blocks and the new blocks do not fall within or immediately
+   * follow them, or (2) the number of blocks would exceed our allocated
+   * buffer capacity
    */
 
-  if (((startblock != rwb->wrexpectedblock) && (rwb->wrnblocks)) ||
-      ((rwb->wrnblocks + nblocks) > rwb->wrmaxblocks))
+  if (rwb->wrnblocks > 0 &&
+      (startblock < rwb->wrblockstart ||
+       startblock > rwb->wrexpectedblock ||
+       endblock > rwb->wrblockstart + rwb->wrmaxblocks))
     {
       fvdbg("writebuffer miss, expected: %08x, given: %08x\n",
             rwb->wrexpectedblock, startblock);
-    
+
       /* Flush the write buffer */
 
-      ret = rwb->wrflush(rwb, rwb->wrbuffer, rwb->wrblockstart, rwb->wrnblocks);
+      ret = rwb_wrflush(rwb);
       if (ret < 0)
         {
           fdbg("ERROR: Error writing multiple from cache: %d\n", -ret);
           return ret;
         }
-
-      rwb_resetwrbuffer(rwb);
     }
-  
+
   /* writebuffer is empty? Then initialize it */
 
   if (!rwb->wrnblocks)
     {
       fvdbg("Fresh cache starting at block: 0x%08x\n", startblock);
-      rwb->wrblockstart = startblock;
+      rwb->wrblockstart    = startblock;
+      rwb->wrexpectedblock = startblock;
     }
-  
+
   /* Add data to cache */
 
-  fvdbg("writebuffer: copying %d bytes from %p to %p\n",
-        nblocks * rwb->blocksize, wrbuffer,
-        &rwb->wrbuffer[rwb->wrnblocks * rwb->blocksize]);
-  memcpy(&rwb->wrbuffer[rwb->wrnblocks * rwb->blocksize],
+  memcpy(&rwb->wrbuffer[(startblock - rwb->wrblockstart) * rwb->blocksize],
          wrbuffer, nblocks * rwb->blocksize);
 
-  rwb->wrnblocks      += nblocks;
-  rwb->wrexpectedblock = rwb->wrblockstart + rwb->wrnblocks;
+  if (endblock > rwb->wrexpectedblock)
+    {
+      rwb->wrexpectedblock = endblock;
+      rwb->wrnblocks       = endblock - rwb->wrblockstart;
+    }
+
+  rwb->wrmerges += nblocks;
   rwb_wrstarttimeout(rwb);
   return nblocks;
 }
@@ -334,6 +372,40 @@ rwb_bufferread(struct rwbuffer_s *rwb,  off_t startblock,
 }
 #endif
 
+/****************************************************************************
+ * Name: rwb_bufferupdate
+ *
+ * Description:
+ *   Copy newly written data over the blocks that it has in common with the
+ *   read-ahead buffer so that the read-ahead buffer never holds stale data.
+ *   The caller must hold the rhsem.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FS_READAHEAD
+static inline void
+rwb_bufferupdate(struct rwbuffer_s *rwb, off_t startblock, size_t nblocks,
+                 FAR const uint8_t *wrbuffer)
+{
+  off_t firstblock = startblock;
+  off_t endblock   = startblock + nblocks;
+
+  if (firstblock < rwb->rhblockstart)
+    {
+      firstblock = rwb->rhblockstart;
+    }
+
+  if (endblock > rwb->rhblockstart + rwb->rhnblocks)
+    {
+      endblock = rwb->rhblockstart + rwb->rhnblocks;
+    }
+
+  memcpy(&rwb->rhbuffer[(firstblock - rwb->rhblockstart) * rwb->blocksize],
+         &wrbuffer[(firstblock - startblock) * rwb->blocksize],
+         (endblock - firstblock) * rwb->blocksize);
+}
+#endif
+
 /****************************************************************************
  * Name: rwb_rhreload
  ****************************************************************************/
@@ -355,6 +427,11 @@ static int rwb_rhreload(struct rwbuffer_s *rwb, off_t startblock)
 
   /* Make sure that we don't read past the end of the device */
 
+  if (startblock >= rwb->nblocks)
+    {
+      return -EINVAL;
+    }
+
   if (endblock > rwb->nblocks)
     {
       endblock = rwb->nblocks;
@@ -362,6 +439,28 @@ static int rwb_rhreload(struct rwbuffer_s *rwb, off_t startblock)
 
   nblocks = endblock - startblock;
 
+#ifdef CONFIG_FS_WRITEBUFFER
+  /* Buffered write data is newer than the media content.  Flush it first
+   * if any of it falls within the blocks that we are about to read.
+   */
+
+  if (rwb->wrmaxblocks > 0)
+    {
+      ret = OK;
+      rwb_semtake(&rwb->wrsem);
+      if (rwb_overlap(rwb->wrblockstart, rwb->wrnblocks, startblock, nblocks))
+        {
+          ret = rwb_wrflush(rwb);
+        }
+      rwb_semgive(&rwb->wrsem);
+
+      if (ret < 0)
+        {
+          return ret;
+        }
+    }
+#endif
+
   /* Now perform the read */
 
   ret = rwb->rhreload(rwb->dev, rwb->rhbuffer, startblock, nblocks);
@@ -398,15 +497,17 @@ int rwb_initialize(FAR struct rwbuffer_s *rwb)
   DEBUGASSERT(rwb->blocksize > 0);
   DEBUGASSERT(rwb->nblocks > 0);
   DEBUGASSERT(rwb->dev != NULL);
+  DEBUGASSERT(rwb->rhreload != NULL);
+#ifdef CONFIG_FS_WRITEBUFFER
+  DEBUGASSERT(rwb->wrflush != NULL || rwb->wrmaxblocks == 0);
+#endif
 
   /* Setup so that rwb_uninitialize can handle a failure */
 
 #ifdef CONFIG_FS_WRITEBUFFER
-  DEBUGASSERT(rwb->wrflush!= NULL);
   rwb->wrbuffer = NULL;
 #endif
 #ifdef CONFIG_FS_READAHEAD
-  DEBUGASSERT(rwb->rhreload != NULL);
   rwb->rhbuffer = NULL;
 #endif
 
@@ -420,6 +521,8 @@ int rwb_initialize(FAR struct rwbuffer_s *rwb)
   /* Initialize write buffer parameters */
 
   rwb_resetwrbuffer(rwb);
+  rwb->wrmerges  = 0;
+  rwb->wrflushes = 0;
 
   /* Allocate the write buffer */
 
@@ -433,9 +536,9 @@ int rwb_initialize(FAR struct rwbuffer_s *rwb)
           fdbg("Write buffer kmalloc(%d) failed\n", allocsize);
           return -ENOMEM;
         }
+
+      fvdbg("Write buffer size: %d bytes\n", allocsize);
     }
-  
-  fvdbg("Write buffer size: %d bytes\n", allocsize);
 #endif /* CONFIG_FS_WRITEBUFFER */
 
 #ifdef CONFIG_FS_READAHEAD
@@ -448,6 +551,8 @@ int rwb_initialize(FAR struct rwbuffer_s *rwb)
   /* Initialize read-ahead buffer parameters */
 
   rwb_resetrhbuffer(rwb);
+  rwb->rhhits   = 0;
+  rwb->rhmisses = 0;
 
   /* Allocate the read-ahead buffer */
 
@@ -461,15 +566,20 @@ int rwb_initialize(FAR struct rwbuffer_s *rwb)
           fdbg("Read-ahead buffer kmalloc(%d) failed\n", allocsize);
           return -ENOMEM;
         }
+
+      fvdbg("Read-ahead buffer size: %d bytes\n", allocsize);
     }
-  
-  fvdbg("Read-ahead buffer size: %d bytes\n", allocsize);
 #endif /* CONFIG_FS_READAHEAD */
   return 0;
 }
 
 /****************************************************************************
  * Name: rwb_uninitialize
+ *
+ * Description:
+ *   Release the buffers.  Any buffered write data is discarded; call
+ *   rwb_flush() first to write it to the media.
+ *
  ****************************************************************************/
 
 void rwb_uninitialize(FAR struct rwbuffer_s *rwb)
@@ -494,16 +604,87 @@ void rwb_uninitialize(FAR struct rwbuffer_s *rwb)
 
 /****************************************************************************
  * Name: rwb_read
+ *
+ * Description:
+ *   Read blocks through the read-ahead buffer.  Requests that are at
+ *   least as large as the read-ahead buffer bypass it and are read
+ *   directly into the caller's buffer with a single transfer.
+ *
  ****************************************************************************/
 
-int rwb_read(FAR struct rwbuffer_s *rwb, off_t startblock, uint32_t nblocks,
-             FAR uint8_t *rdbuffer)
+ssize_t rwb_read(FAR struct rwbuffer_s *rwb, off_t startblock,
+                 size_t nblocks, FAR uint8_t *rdbuffer)
 {
-  uint32_t remaining;
- 
+  int ret = OK;
+
   fvdbg("startblock=%ld nblocks=%ld rdbuffer=%p\n",
         (long)startblock, (long)nblocks, rdbuffer);
 
+#ifdef CONFIG_FS_READAHEAD
+  if (nblocks < rwb->rhmaxblocks)
+    {
+      size_t remaining;
+      bool   reloaded = false;
+
+      /* Loop until we have read all of the requested blocks */
+
+      rwb_semtake(&rwb->rhsem);
+      for (remaining = nblocks; remaining > 0; )
+        {
+          /* Is the next block in the read-ahead buffer? */
+
+          if (rwb->rhnblocks > 0 &&
+              startblock >= rwb->rhblockstart &&
+              startblock <  rwb->rhblockstart + rwb->rhnblocks)
+            {
+              /* Yes.. read as many blocks as we can from the buffer */
+
+              size_t nbufblocks = rwb->rhblockstart + rwb->rhnblocks -
+                                  startblock;
+
+              if (nbufblocks > remaining)
+                {
+                  nbufblocks = remaining;
+                }
+
+              rwb_bufferread(rwb, startblock, nbufblocks, &rdbuffer);
+
+              /* The first block after a reload was a miss */
+
+              rwb->rhhits += reloaded ? nbufblocks - 1 : nbufblocks;
+              reloaded     = false;
+
+              startblock  += nbufblocks;
+              remaining   -= nbufblocks;
+            }
+          else
+            {
+              /* No.. we have to refill the buffer and try again. */
+
+              ret = rwb_rhreload(rwb, startblock);
+              if (ret < 0)
+                {
+                  fdbg("ERROR: Failed to fill the read-ahead buffer: %d\n",
+                       -ret);
+                  rwb_semgive(&rwb->rhsem);
+                  return ret;
+                }
+
+              rwb->rhmisses++;
+              reloaded = true;
+            }
+        }
+
+      /* On success, return the number of blocks that we were requested to
+       * read.  This is for compatibility with the normal return of a block
+       * driver read method
+       */
+
+      rwb_semgive(&rwb->rhsem);
+      return nblocks;
+    }
+#endif
+
 #ifdef CONFIG_FS_WRITEBUFFER
   /* If the new read data overlaps any part of the write buffer, then
    * flush the write data onto the physical media before reading.  We
@@ -520,125 +701,94 @@ int rwb_read(FAR struct rwbuffer_s *rwb, off_t startblock, uint32_t nblocks,
       rwb_semtake(&rwb->wrsem);
       if (rwb_overlap(rwb->wrblockstart, rwb->wrnblocks, startblock, nblocks))
         {
-          rwb_wrflush(rwb);
+          ret = rwb_wrflush(rwb);
         }
       rwb_semgive(&rwb->wrsem);
-    }
-#endif
 
-#ifdef CONFIG_FS_READAHEAD
-  /* Loop until we have read all of the requested blocks */
-
-  rwb_semtake(&rwb->rhsem);
-  for (remaining = nblocks; remaining > 0;)
-    {
-      /* Is there anything in the read-ahead buffer? */
-
-      if (rwb->rhnblocks > 0)
-        {
-          off_t  startblock = startblock;
-          size_t nbufblocks = 0;
-          off_t  bufferend;
-
-          /* Loop for each block we find in the read-head buffer.  Count the
-           * number of buffers that we can read from read-ahead buffer.
-           */
-
-          bufferend = rwb->rhblockstart + rwb->rhnblocks;
-
-          while ((startblock >= rwb->rhblockstart) &&
-                 (startblock < bufferend) &&
-                 (remaining > 0))
-            {
-              /* This is one more that we will read from the read ahead buffer */
-
-              nbufblocks++;
-
-              /* And one less that we will read from the media */
-
-              startblock++;
-              remaining--;
-            }
-
-          /* Then read the data from the read-ahead buffer */
-
-          rwb_bufferread(rwb, startblock, nbufblocks, &rdbuffer);
-        }
-
-      /* If we did not get all of the data from the buffer, then we have to refill
-       * the buffer and try again.
-       */
-
-      if (remaining > 0)
+      if (ret < 0)
         {
-          int ret = rwb_rhreload(rwb, startblock);
-          if (ret < 0)
-            {
-              fdbg("ERROR: Failed to fill the read-ahead buffer: %d\n", -ret);
-              return ret;
-            }
+          return ret;
         }
     }
+#endif
 
-  /* On success, return the number of blocks that we were requested to read.
-   * This is for compatibility with the normal return of a block driver read
-   * method
+  /* Read the data directly from the media.  The read-ahead buffer does not
+   * need to be consulted because it is kept consistent with the media by
+   * rwb_write().
    */
 
-  rwb_semgive(&rwb->rhsem);
-  return 0;
-#else
-  return rwb->rhreload(rwb->dev, startblock, nblocks, rdbuffer);
-#endif
+  return rwb->rhreload(rwb->dev, rdbuffer, startblock, nblocks);
 }
 
 /****************************************************************************
  * Name: rwb_write
  ****************************************************************************/
 
-int rwb_write(FAR struct rwbuffer_s *rwb, off_t startblock,
-              size_t nblocks, FAR const uint8_t *wrbuffer)
+ssize_t rwb_write(FAR struct rwbuffer_s *rwb, off_t startblock,
+                  size_t nblocks, FAR const uint8_t *wrbuffer)
 {
-  int ret;
+  ssize_t ret;
 
 #ifdef CONFIG_FS_READAHEAD
   /* If the new write data overlaps any part of the read buffer, then
-   * flush the data from the read buffer.  We could attempt some more
-   * exotic handling -- but this simple logic is well-suited for simple
-   * streaming applications.
+   * copy the new data into the read buffer so that the read-ahead
+   * content remains valid.  The rhsem is held until the write is
+   * complete so that a concurrent reload cannot pick up stale data.
    */
 
-  rwb_semtake(&rwb->rhsem);
-  if (rwb_overlap(rwb->rhblockstart, rwb->rhnblocks, startblock, nblocks))
+  if (rwb->rhmaxblocks > 0)
     {
-      rwb_resetrhbuffer(rwb);
+      rwb_semtake(&rwb->rhsem);
+      if (rwb_overlap(rwb->rhblockstart, rwb->rhnblocks, startblock, nblocks))
+        {
+          rwb_bufferupdate(rwb, startblock, nblocks, wrbuffer);
+        }
     }
-  rwb_semgive(&rwb->rhsem);
 #endif
 
 #ifdef CONFIG_FS_WRITEBUFFER
   fvdbg("startblock=%d wrbuffer=%p\n", startblock, wrbuffer);
 
-  /* Use the block cache unless the buffer size is bigger than block cache */   
-     
-  if (nblocks > rwb->wrmaxblocks)
+  if (rwb->wrmaxblocks > 0)
     {
-      /* First flush the cache */
+      /* Use the block cache unless the buffer size is bigger than block
+       * cache
+       */
 
       rwb_semtake(&rwb->wrsem);
-      rwb_wrflush(rwb);
-      rwb_semgive(&rwb->wrsem);
+      if (nblocks > rwb->wrmaxblocks)
+        {
+          /* First flush the cache, then transfer the data directly to the
+           * media
+           */
 
-      /* Then transfer the data directly to the media */
+          ret = rwb_wrflush(rwb);
+          if (ret >= 0)
+            {
+              ret = rwb->wrflush(rwb->dev, wrbuffer, startblock, nblocks);
+            }
+        }
+      else
+        {
+          /* Buffer the data in the write buffer */
+
+          ret = rwb_writebuffer(rwb, startblock, nblocks, wrbuffer);
+        }
 
-      ret = rwb->wrflush(rwb->dev, startblock, nblocks, wrbuffer);
+      rwb_semgive(&rwb->wrsem);
     }
   else
+#endif
     {
-      /* Buffer the data in the write buffer */
+      ret = rwb->wrflush(rwb->dev, wrbuffer, startblock, nblocks);
+    }
 
-      ret = rwb_writebuffer(rwb, startblock, nblocks, wrbuffer);
+#ifdef CONFIG_FS_READAHEAD
+  if (rwb->rhmaxblocks > 0)
+    {
+      rwb_semgive(&rwb->rhsem);
     }
+#endif
 
   /* On success, return the number of blocks that we were requested to write.
    * This is for compatibility with the normal return of a block driver write
@@ -646,12 +796,31 @@ int rwb_write(FAR struct rwbuffer_s *rwb, off_t startblock,
    */
 
   return ret;
+}
 
-#else
+/****************************************************************************
+ * Name: rwb_flush
+ *
+ * Description:
+ *   Write any buffered write data to the media now
+ *
+ ****************************************************************************/
 
-  return rwb->wrflush(rwb->dev, startblock, nblocks, wrbuffer);
+int rwb_flush(FAR struct rwbuffer_s *rwb)
+{
+  int ret = OK;
 
+#ifdef CONFIG_FS_WRITEBUFFER
+  if (rwb->wrmaxblocks > 0)
+    {
+      rwb_semtake(&rwb->wrsem);
+      rwb_wrcanceltimeout(rwb);
+      ret = rwb_wrflush(rwb);
+      rwb_semgive(&rwb->wrsem);
+    }
 #endif
+
+  return ret;
 }
 
 /****************************************************************************
@@ -679,4 +848,3 @@ int rwb_mediaremoved(FAR struct rwbuffer_s *rwb)
 }
 
 #endif /* CONFIG_FS_WRITEBUFFER || CONFIG_FS_READAHEAD */
-
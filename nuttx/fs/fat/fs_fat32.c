@@ -62,6 +62,7 @@
 #include <nuttx/fs/fs.h>
 #include <nuttx/fs/fat.h>
 #include <nuttx/fs/dirent.h>
+#include <nuttx/fs/ioctl.h>
 
 #include "fs_internal.h"
 #include "fs_fat32.h"
@@ -341,6 +342,10 @@ static int fat_open(FAR struct file *filep, const char *relpath,
   ff->ff_sectorsincluster = fs->fs_fatsecperclus;
   ff->ff_size             = DIR_GETFILESIZE(direntry);
 
+#ifdef CONFIG_FAT_EXTENTCACHE
+  fat_extentinit(ff);
+#endif
+
   /* Attach the private date to the struct file instance */
 
   filep->f_priv = ff;
@@ -444,6 +449,9 @@ static ssize_t fat_read(FAR struct file *filep, char *buffer, size_t buflen)
   unsigned int          nsectors;
   size_t                bytesleft;
   int32_t               cluster;
+#ifdef CONFIG_FAT_EXTENTCACHE
+  uint32_t              nclusters;
+#endif
   uint8_t               *userbuffer = (uint8_t*)buffer;
   int                   sectorindex;
   int                   ret;
@@ -526,7 +534,7 @@ static ssize_t fat_read(FAR struct file *filep, char *buffer, size_t buflen)
         {
           /* Find the next cluster in the FAT. */
 
-          cluster = fat_getcluster(fs, ff->ff_currentcluster);
+          cluster = fat_nextcluster(fs, ff, false);
           if (cluster < 2 || cluster >= fs->fs_nclusters)
             {
               ret = -EINVAL; /* Not the right error */
@@ -536,6 +544,7 @@ static ssize_t fat_read(FAR struct file *filep, char *buffer, size_t buflen)
           /* Setup to read the first sector from the new cluster */
 
           ff->ff_currentcluster   = cluster;
+          ff->ff_clusterindex++;
           ff->ff_currentsector    = fat_cluster2sector(fs, cluster);
           ff->ff_sectorsincluster = fs->fs_fatsecperclus;
         }
@@ -557,12 +566,26 @@ fat_read_restart:
            *
            * Limit the number of sectors that we read on this time
            * through the loop to the remaining contiguous sectors
-           * in this cluster
+           * in this cluster (or, with the extent cache, in this run of
+           * physically contiguous clusters).
            */
 
           if (nsectors > ff->ff_sectorsincluster)
             {
+#ifdef CONFIG_FAT_EXTENTCACHE
+              nclusters = (nsectors - ff->ff_sectorsincluster +
+                           fs->fs_fatsecperclus - 1) / fs->fs_fatsecperclus;
+              nclusters = fat_extentrun(fs, ff, nclusters + 1) - 1;
+
+              if (nsectors > ff->ff_sectorsincluster +
+                             nclusters * fs->fs_fatsecperclus)
+                {
+                  nsectors = ff->ff_sectorsincluster +
+                             nclusters * fs->fs_fatsecperclus;
+                }
+#else
               nsectors = ff->ff_sectorsincluster;
+#endif
             }
 
           /* We are not sure of the state of the file buffer so
@@ -595,7 +618,28 @@ fat_read_restart:
               goto errout_with_semaphore;
             }
 
-          ff->ff_sectorsincluster -= nsectors;
+#ifdef CONFIG_FAT_EXTENTCACHE
+          if (nsectors > ff->ff_sectorsincluster)
+            {
+              /* The read continued into the following clusters of the
+               * run.  Advance to the last cluster that was read.
+               */
+
+              nclusters = (nsectors - ff->ff_sectorsincluster +
+                           fs->fs_fatsecperclus - 1) / fs->fs_fatsecperclus;
+
+              ff->ff_currentcluster  += nclusters;
+              ff->ff_clusterindex    += nclusters;
+              ff->ff_sectorsincluster = ff->ff_sectorsincluster +
+                                        nclusters * fs->fs_fatsecperclus -
+                                        nsectors;
+            }
+          else
+#endif
+            {
+              ff->ff_sectorsincluster -= nsectors;
+            }
+
           ff->ff_currentsector    += nsectors;
           bytesread                = nsectors * fs->fs_hwsectorsize;
         }
@@ -728,9 +772,26 @@ static ssize_t fat_write(FAR struct file *filep, const char *buffer,
         {
           /* No.. we have to create a new cluster chain */
 
-          ff->ff_startcluster     = fat_createchain(fs);
+          cluster = fat_createchain(fs);
+          if (cluster < 0)
+            {
+              ret = cluster;
+              goto errout_with_semaphore;
+            }
+          else if (cluster < 2)
+            {
+              ret = -ENOSPC;
+              goto errout_with_semaphore;
+            }
+
+          ff->ff_startcluster     = cluster;
           ff->ff_currentcluster   = ff->ff_startcluster;
+          ff->ff_clusterindex     = 0;
           ff->ff_sectorsincluster = fs->fs_fatsecperclus;
+
+#ifdef CONFIG_FAT_EXTENTCACHE
+          fat_extentinit(ff);
+#endif
         }
 
       /* The current sector can then be determined from the currentcluster
@@ -764,7 +825,7 @@ static ssize_t fat_write(FAR struct file *filep, const char *buffer,
            * move the file position back from the end of the file)
            */
 
-          cluster = fat_extendchain(fs, ff->ff_currentcluster);
+          cluster = fat_nextcluster(fs, ff, true);
 
           /* Verify the cluster number */
 
@@ -782,6 +843,7 @@ static ssize_t fat_write(FAR struct file *filep, const char *buffer,
           /* Setup to write the first sector from the new cluster */
 
           ff->ff_currentcluster   = cluster;
+          ff->ff_clusterindex++;
           ff->ff_sectorsincluster = fs->fs_fatsecperclus;
           ff->ff_currentsector    = fat_cluster2sector(fs, cluster);
         }
@@ -955,6 +1017,7 @@ static off_t fat_seek(FAR struct file *filep, off_t offset, int whence)
   int32_t               cluster;
   off_t                 position;
   unsigned int          clustersize;
+  uint32_t              clusterindex;
   int                   ret;
 
   /* Sanity checks */
@@ -1046,6 +1109,10 @@ static off_t fat_seek(FAR struct file *filep, off_t offset, int whence)
         }
 
       ff->ff_startcluster = cluster;
+
+#ifdef CONFIG_FAT_EXTENTCACHE
+      fat_extentinit(ff);
+#endif
     }
 
   /* Move file position if necessary */
@@ -1056,7 +1123,25 @@ static off_t fat_seek(FAR struct file *filep, off_t offset, int whence)
        * requested position.
        */
 
-      clustersize = fs->fs_fatsecperclus * fs->fs_hwsectorsize;
+      clustersize  = fs->fs_fatsecperclus * fs->fs_hwsectorsize;
+      clusterindex = 0;
+
+#ifdef CONFIG_FAT_EXTENTCACHE
+      /* Skip directly to the cached cluster closest to the requested
+       * position.
+       */
+
+      cluster = fat_extentfind(ff, position / clustersize, &clusterindex);
+      if (cluster == 0)
+        {
+          cluster      = ff->ff_startcluster;
+          clusterindex = 0;
+        }
+
+      filep->f_pos = (off_t)clusterindex * clustersize;
+      position    -= filep->f_pos;
+#endif
+
       for (;;)
         {
           /* Skip over clusters prior to the one containing
@@ -1064,6 +1149,7 @@ static off_t fat_seek(FAR struct file *filep, off_t offset, int whence)
            */
 
           ff->ff_currentcluster = cluster;
+          ff->ff_clusterindex   = clusterindex;
           if (position < clustersize)
             {
               break;
@@ -1086,13 +1172,13 @@ static off_t fat_seek(FAR struct file *filep, off_t offset, int whence)
                * clusters as needed.
                */
 
-              cluster = fat_extendchain(fs, cluster);
+              cluster = fat_nextcluster(fs, ff, true);
             }
           else
             {
               /* Otherwise we can only follong the existing chain */
 
-              cluster = fat_getcluster(fs, cluster);
+              cluster = fat_nextcluster(fs, ff, false);
             }
 
           if (cluster < 0)
@@ -1104,10 +1190,13 @@ static off_t fat_seek(FAR struct file *filep, off_t offset, int whence)
             }
 
           /* Zero means that there is no further clusters available
-           * in the chain.
+           * in the chain.  The end of the chain is also reached when
+           * seeking to the end of a read-only file whose size is a
+           * multiple of the cluster size.
            */
 
-          if (cluster == 0)
+          if (cluster == 0 ||
+              (cluster >= fs->fs_nclusters && (ff->ff_oflags & O_WROK) == 0))
             {
               /* At the position to the current locaiton and
                * break out.
@@ -1127,6 +1216,7 @@ static off_t fat_seek(FAR struct file *filep, off_t offset, int whence)
 
           filep->f_pos += clustersize;
           position     -= clustersize;
+          clusterindex++;
         }
 
       /* We get here after we have found the sector containing
@@ -1179,6 +1269,7 @@ static int fat_ioctl(FAR struct file *filep, int cmd, unsigned long arg)
 {
   struct inode         *inode;
   struct fat_mountpt_s *fs;
+  struct fat_file_s    *ff;
   int                   ret;
 
   /* Sanity checks */
@@ -1187,6 +1278,7 @@ static int fat_ioctl(FAR struct file *filep, int cmd, unsigned long arg)
 
   /* Recover our private data from the struct file instance */
 
+  ff    = filep->f_priv;
   inode = filep->f_inode;
   fs    = inode->i_private;
 
@@ -1202,6 +1294,17 @@ static int fat_ioctl(FAR struct file *filep, int cmd, unsigned long arg)
       return ret;
     }
 
+  /* FIOC_MMAP is supported if the file lies in one contiguous run of
+   * clusters on a block device with XIP support (such as a RAM disk).
+   */
+
+  if (cmd == FIOC_MMAP)
+    {
+      ret = fat_mmap(fs, ff, (FAR void **)((uintptr_t)arg));
+      fat_semgive(fs);
+      return ret;
+    }
+
   /* ioctl calls are just passed through to the contained block driver */
 
   fat_semgive(fs);
@@ -1390,12 +1493,19 @@ static int fat_dup(FAR const struct file *oldp, FAR struct file *newp)
   newff->ff_sectorsincluster = oldff->ff_sectorsincluster; /* Sectors remaining in cluster */
   newff->ff_dirindex         = oldff->ff_dirindex;         /* Index to directory entry */
   newff->ff_currentcluster   = oldff->ff_currentcluster;   /* Current cluster */
+  newff->ff_clusterindex     = oldff->ff_clusterindex;     /* Index of current cluster */
   newff->ff_dirsector        = oldff->ff_dirsector;        /* Sector containing directory entry */
   newff->ff_size             = oldff->ff_size;             /* Size of the file */
   newff->ff_startcluster     = oldff->ff_startcluster;     /* Start cluster of file on media */
   newff->ff_currentsector    = oldff->ff_currentsector;    /* Current sector */
   newff->ff_cachesector      = 0;                          /* Sector in file buffer */
 
+#ifdef CONFIG_FAT_EXTENTCACHE
+  newff->ff_nextents         = oldff->ff_nextents;         /* Cached cluster runs */
+  memcpy(newff->ff_extents, oldff->ff_extents,
+         oldff->ff_nextents * sizeof(struct fat_extent_s));
+#endif
+
   /* Attach the private date to the struct file instance */
 
   newp->f_priv = newff;
@@ -1844,11 +1954,18 @@ static int fat_unbind(void *handle, FAR struct inode **blkdriver)
 
       /* Release the mountpoint private data */
 
-      if (fs->fs_buffer)
+      if (fs->fs_cachebuf)
         {
-          fat_io_free(fs->fs_buffer, fs->fs_hwsectorsize);
+          fat_io_free(fs->fs_cachebuf, FAT_CACHESIZE(fs));
         }
 
+#ifdef CONFIG_FAT_FREEMAP
+      if (fs->fs_freemap)
+        {
+          kfree(fs->fs_freemap);
+        }
+#endif
+
       kfree(fs);
     }
 
@@ -697,6 +697,52 @@
  *
  ****************************************************************************/
 
+/****************************************************************************
+ * Mountpoint sector cache.  CONFIG_FAT_NCACHESECTORS is the number of device
+ * sectors buffered for each mounted volume.  The default, one sector,
+ * corresponds to the historical single sector fs_buffer.
+ */
+
+#ifndef CONFIG_FAT_NCACHESECTORS
+#  define CONFIG_FAT_NCACHESECTORS 1
+#endif
+
+#if CONFIG_FAT_NCACHESECTORS < 1 || CONFIG_FAT_NCACHESECTORS > 255
+#  error "CONFIG_FAT_NCACHESECTORS must be in the range 1-255"
+#endif
+
+#define FAT_CACHESIZE(f)   (CONFIG_FAT_NCACHESECTORS * (f)->fs_hwsectorsize)
+
+/****************************************************************************
+ * Free cluster bitmap.  When CONFIG_FAT_FREEMAP is selected, one bit per
+ * cluster records whether the cluster is in use.  New clusters are taken
+ * from runs of at least CONFIG_FAT_ALLOCRUN free clusters when possible.
+ */
+
+#ifdef CONFIG_FAT_FREEMAP
+#  ifndef CONFIG_FAT_ALLOCRUN
+#    define CONFIG_FAT_ALLOCRUN 16
+#  endif
+
+#  define FAT_FREEMAP_ISSET(m,c) (((m)[(c) >> 5] & ((uint32_t)1 << ((c) & 31))) != 0)
+#  define FAT_FREEMAP_SET(m,c)   ((m)[(c) >> 5] |= ((uint32_t)1 << ((c) & 31)))
+#  define FAT_FREEMAP_CLR(m,c)   ((m)[(c) >> 5] &= ~((uint32_t)1 << ((c) & 31)))
+#endif
+
+/****************************************************************************
+ * Per-file extent cache.  CONFIG_FAT_NEXTENTS is the number of contiguous
+ * cluster runs remembered for each open file.
+ */
+
+#ifdef CONFIG_FAT_EXTENTCACHE
+#  ifndef CONFIG_FAT_NEXTENTS
+#    define CONFIG_FAT_NEXTENTS 8
+#  endif
+#  if CONFIG_FAT_NEXTENTS < 1 || CONFIG_FAT_NEXTENTS > 255
+#    error "CONFIG_FAT_NEXTENTS must be in the range 1-255"
+#  endif
+#endif
+
 #ifdef CONFIG_FAT_DMAMEMORY
 #  define fat_io_alloc(s)  fat_dma_alloc(s)
 #  define fat_io_free(m,s) fat_dma_free(m,s)
@@ -714,6 +760,22 @@
  * mounted with a fat32 filesystem.
  */
 
+/* This structure describes one entry in the mountpoint sector cache.  The
+ * entry that is currently accessible via fs_buffer is described by
+ * fs_currentsector and fs_dirty in struct fat_mountpt_s; its fc_sector and
+ * fc_dirty fields are only brought up to date when the current entry
+ * changes or when the cache is flushed.
+ */
+
+struct fat_cache_s
+{
+  off_t    fc_sector;              /* The sector number held in fc_buffer */
+  uint32_t fc_stamp;               /* Value of fs_cachestamp at last access */
+  bool     fc_valid;               /* true: fc_buffer holds fc_sector */
+  bool     fc_dirty;               /* true: fc_buffer must be written back */
+  uint8_t *fc_buffer;              /* One sector within fs_cachebuf */
+};
+
 struct fat_file_s;
 struct fat_mountpt_s
 {
@@ -741,9 +803,34 @@ struct fat_mountpt_s
   uint8_t  fs_type;                /* FSTYPE_FAT12, FSTYPE_FAT16, or FSTYPE_FAT32 */
   uint8_t  fs_fatnumfats;          /* MBR: Number of FATs (probably 2) */
   uint8_t  fs_fatsecperclus;       /* MBR: Sectors per allocation unit: 2**n, n=0..7 */
-  uint8_t *fs_buffer;              /* This is an allocated buffer to hold one sector
-                                    * from the device */
+  uint8_t  fs_cacheindex;          /* Index of the fs_cache[] entry in fs_buffer */
+  uint32_t fs_cachestamp;          /* Incremented on each cache access (for LRU) */
+  uint8_t *fs_buffer;              /* The sector buffer of the current cache entry */
+  uint8_t *fs_cachebuf;            /* This is an allocated buffer to hold
+                                    * CONFIG_FAT_NCACHESECTORS sectors from the
+                                    * device */
+  struct fat_cache_s fs_cache[CONFIG_FAT_NCACHESECTORS];
+#ifdef CONFIG_FAT_FREEMAP
+  uint32_t *fs_freemap;            /* One bit per cluster, set if the cluster is
+                                    * in use.  NULL until first needed */
+#endif
+};
+
+/* This structure describes one run of physically contiguous clusters in
+ * the cluster chain of an open file.  The extents of a file describe the
+ * chain from its start cluster up to the last cluster that has been
+ * visited; they are discovered as the chain is followed and are kept in
+ * order of fe_index.
+ */
+
+#ifdef CONFIG_FAT_EXTENTCACHE
+struct fat_extent_s
+{
+  uint32_t fe_index;               /* Index of the first cluster within the file */
+  uint32_t fe_cluster;             /* Cluster number of the first cluster */
+  uint32_t fe_nclusters;           /* Number of clusters in the run */
 };
+#endif
 
 /* This structure represents on open file under the mountpoint.  An instance
  * of this structure is retained as struct file specific information on each
@@ -758,12 +845,17 @@ struct fat_file_s
   uint8_t  ff_sectorsincluster;    /* Sectors remaining in cluster */
   uint16_t ff_dirindex;            /* Index into ff_dirsector to directory entry */
   uint32_t ff_currentcluster;      /* Current cluster being accessed */
+  uint32_t ff_clusterindex;        /* Index of ff_currentcluster within the file */
   off_t    ff_dirsector;           /* Sector containing the directory entry */
   off_t    ff_size;                /* Size of the file in bytes */
   off_t    ff_startcluster;        /* Start cluster of file on media */
   off_t    ff_currentsector;       /* Current sector being operated on */
   off_t    ff_cachesector;         /* Current sector in the file buffer */
   uint8_t *ff_buffer;              /* File buffer (for partial sector accesses) */
+#ifdef CONFIG_FAT_EXTENTCACHE
+  uint8_t  ff_nextents;            /* Number of valid entries in ff_extents[] */
+  struct fat_extent_s ff_extents[CONFIG_FAT_NEXTENTS];
+#endif
 };
 
 /* This structure holds the sequency of directory entries used by one
@@ -895,6 +987,23 @@ EXTERN int    fat_putcluster(struct fat_mountpt_s *fs, uint32_t clusterno,
                              off_t startsector);
 EXTERN int    fat_removechain(struct fat_mountpt_s *fs, uint32_t cluster);
 EXTERN int32_t fat_extendchain(struct fat_mountpt_s *fs, uint32_t cluster);
+EXTERN off_t  fat_nextcluster(struct fat_mountpt_s *fs, struct fat_file_s *ff,
+                              bool extend);
+
+/* Per-file extent cache */
+
+#ifdef CONFIG_FAT_EXTENTCACHE
+EXTERN void   fat_extentinit(struct fat_file_s *ff);
+EXTERN uint32_t fat_extentfind(struct fat_file_s *ff, uint32_t index,
+                               uint32_t *pindex);
+EXTERN uint32_t fat_extentrun(struct fat_mountpt_s *fs, struct fat_file_s *ff,
+                              uint32_t maxclusters);
+#endif
+
+/* Direct access to contiguous files on XIP media */
+
+EXTERN int    fat_mmap(struct fat_mountpt_s *fs, struct fat_file_s *ff,
+                       void **ppv);
 
 #define fat_createchain(fs) fat_extendchain(fs, 0)
 
@@ -59,6 +59,7 @@
 #include <nuttx/kmalloc.h>
 #include <nuttx/fs/fs.h>
 #include <nuttx/fs/fat.h>
+#include <nuttx/fs/ioctl.h>
 
 #include "fs_internal.h"
 #include "fs_fat32.h"
@@ -284,6 +285,442 @@ static int fat_checkbootrecord(struct fat_mountpt_s *fs)
   return OK;
 }
 
+/****************************************************************************
+ * Name: fat_cachewrite
+ *
+ * Desciption: Write one cached sector back to the device.  If the sector
+ *   lies in the FAT region, then the FAT copies are updated as well.
+ *
+ ****************************************************************************/
+
+static int fat_cachewrite(struct fat_mountpt_s *fs, uint8_t *buffer,
+                          off_t sector)
+{
+  int ret;
+
+  /* Write the dirty sector */
+
+  ret = fat_hwwrite(fs, buffer, sector, 1);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  /* Does the sector lie in the FAT region? */
+
+  if (sector >= fs->fs_fatbase &&
+      sector < fs->fs_fatbase + fs->fs_nfatsects)
+    {
+      /* Yes, then make the change in the FAT copy as well */
+      int i;
+
+      for (i = fs->fs_fatnumfats; i >= 2; i--)
+        {
+          sector += fs->fs_nfatsects;
+          ret = fat_hwwrite(fs, buffer, sector, 1);
+          if (ret < 0)
+            {
+              return ret;
+            }
+        }
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: fat_cachesync
+ *
+ * Desciption: Update the cache entry that is currently in fs_buffer from
+ *   fs_currentsector and fs_dirty.  Some logic (mkdir, for example) flushes
+ *   the cache and then re-uses fs_buffer for a different sector by setting
+ *   fs_currentsector directly.  Any other cache entry holding that sector
+ *   is then stale and must be discarded.
+ *
+ ****************************************************************************/
+
+static void fat_cachesync(struct fat_mountpt_s *fs)
+{
+  struct fat_cache_s *cache = &fs->fs_cache[fs->fs_cacheindex];
+
+  if (fs->fs_currentsector < 0)
+    {
+      /* fs_buffer does not hold any valid sector */
+
+      cache->fc_sector = -1;
+      cache->fc_valid  = false;
+      cache->fc_dirty  = false;
+      return;
+    }
+
+  if (!cache->fc_valid || cache->fc_sector != fs->fs_currentsector)
+    {
+#if CONFIG_FAT_NCACHESECTORS > 1
+      int i;
+
+      for (i = 0; i < CONFIG_FAT_NCACHESECTORS; i++)
+        {
+          if (i != fs->fs_cacheindex &&
+              fs->fs_cache[i].fc_valid &&
+              fs->fs_cache[i].fc_sector == fs->fs_currentsector)
+            {
+              fs->fs_cache[i].fc_valid = false;
+              fs->fs_cache[i].fc_dirty = false;
+            }
+        }
+#endif
+
+      cache->fc_sector = fs->fs_currentsector;
+      cache->fc_valid  = true;
+    }
+
+  cache->fc_dirty = fs->fs_dirty;
+}
+
+/****************************************************************************
+ * Name: fat_cacheinvalidate
+ *
+ * Desciption: Discard any cache entries that hold sectors which are about
+ *   to be over-written from a different buffer.  The current entry is not
+ *   affected; the caller is responsible for the contents of fs_buffer.
+ *
+ ****************************************************************************/
+
+#if CONFIG_FAT_NCACHESECTORS > 1
+static void fat_cacheinvalidate(struct fat_mountpt_s *fs, uint8_t *buffer,
+                                off_t sector, unsigned int nsectors)
+{
+  struct fat_cache_s *cache;
+  int i;
+
+  for (i = 0; i < CONFIG_FAT_NCACHESECTORS; i++)
+    {
+      cache = &fs->fs_cache[i];
+      if (i != fs->fs_cacheindex && cache->fc_valid &&
+          cache->fc_buffer != buffer &&
+          cache->fc_sector >= sector &&
+          cache->fc_sector < sector + nsectors)
+        {
+          cache->fc_valid = false;
+          cache->fc_dirty = false;
+        }
+    }
+}
+#endif
+
+/****************************************************************************
+ * Name: fat_extentsearch
+ *
+ * Desciption: Return the index of the last extent that starts at or before
+ *   the file cluster 'index'.  The extent list must not be empty.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FAT_EXTENTCACHE
+static int fat_extentsearch(struct fat_file_s *ff, uint32_t index)
+{
+  int low  = 0;
+  int high = ff->ff_nextents - 1;
+  int mid;
+
+  while (low < high)
+    {
+      mid = (low + high + 1) >> 1;
+      if (ff->ff_extents[mid].fe_index <= index)
+        {
+          low = mid;
+        }
+      else
+        {
+          high = mid - 1;
+        }
+    }
+
+  return low;
+}
+#endif
+
+/****************************************************************************
+ * Name: fat_extentnext
+ *
+ * Desciption: Use the extent cache to find the cluster that follows
+ *   'cluster', the cluster at file cluster 'index'.  Returns false if the
+ *   link is not in the cache.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FAT_EXTENTCACHE
+static bool fat_extentnext(struct fat_file_s *ff, uint32_t index,
+                           uint32_t cluster, uint32_t *pnext)
+{
+  struct fat_extent_s *extent;
+  int ndx;
+
+  if (ff->ff_nextents == 0)
+    {
+      return false;
+    }
+
+  ndx    = fat_extentsearch(ff, index);
+  extent = &ff->ff_extents[ndx];
+
+  /* The cluster must lie within the extent.  If it does not, then the
+   * caller's idea of the chain does not match ours; discard the cache
+   * rather than return something wrong.
+   */
+
+  if (index - extent->fe_index >= extent->fe_nclusters ||
+      extent->fe_cluster + (index - extent->fe_index) != cluster)
+    {
+      ff->ff_nextents = 0;
+      return false;
+    }
+
+  /* Is the next cluster in the same extent? Or the start of the next? */
+
+  if (index + 1 - extent->fe_index < extent->fe_nclusters)
+    {
+      *pnext = cluster + 1;
+      return true;
+    }
+  else if (ndx + 1 < ff->ff_nextents)
+    {
+      *pnext = ff->ff_extents[ndx + 1].fe_cluster;
+      return true;
+    }
+
+  return false;
+}
+#endif
+
+/****************************************************************************
+ * Name: fat_extentadd
+ *
+ * Desciption: Record that file cluster 'index' is 'cluster'.  The cache
+ *   describes a contiguous prefix of the cluster chain so only the cluster
+ *   immediately following the last cached cluster can be added.  If all
+ *   extents are in use, the link is simply not cached.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FAT_EXTENTCACHE
+static void fat_extentadd(struct fat_file_s *ff, uint32_t index,
+                          uint32_t cluster)
+{
+  struct fat_extent_s *extent;
+
+  if (ff->ff_nextents == 0)
+    {
+      return;
+    }
+
+  extent = &ff->ff_extents[ff->ff_nextents - 1];
+  if (index != extent->fe_index + extent->fe_nclusters)
+    {
+      return;
+    }
+
+  if (cluster == extent->fe_cluster + extent->fe_nclusters)
+    {
+      /* The run continues */
+
+      extent->fe_nclusters++;
+    }
+  else if (ff->ff_nextents < CONFIG_FAT_NEXTENTS)
+    {
+      /* Start a new run */
+
+      extent++;
+      extent->fe_index     = index;
+      extent->fe_cluster   = cluster;
+      extent->fe_nclusters = 1;
+      ff->ff_nextents++;
+    }
+}
+#endif
+
+/****************************************************************************
+ * Name: fat_freemapbuild
+ *
+ * Desciption: Build the free cluster bitmap by examining every entry in
+ *   the FAT.  This is done only once per mount, the first time that the
+ *   bitmap is needed.  The free cluster count is then known exactly and
+ *   replaces the FSINFO value if that value was wrong.  The FSINFO sector
+ *   is not marked dirty:  Building the bitmap may happen on the first
+ *   statfs() of a file system that is otherwise only read (or mounted
+ *   read-only), and must not cause a write.  The corrected count is written
+ *   back with the next allocation or release of a cluster.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FAT_FREEMAP
+static int fat_freemapbuild(struct fat_mountpt_s *fs)
+{
+  uint32_t *freemap;
+  uint32_t  nwords;
+  uint32_t  nfree;
+  uint32_t  cluster;
+  off_t     next;
+
+  nwords  = (fs->fs_nclusters + 31) >> 5;
+  freemap = (uint32_t*)kzalloc(nwords * sizeof(uint32_t));
+  if (!freemap)
+    {
+      return -ENOMEM;
+    }
+
+  /* Clusters 0 and 1 and the bits beyond the last cluster never represent
+   * free clusters.
+   */
+
+  freemap[0] |= 3;
+  for (cluster = fs->fs_nclusters; cluster < (nwords << 5); cluster++)
+    {
+      FAT_FREEMAP_SET(freemap, cluster);
+    }
+
+  /* Then examine each cluster in the FAT */
+
+  nfree = 0;
+  for (cluster = 2; cluster < fs->fs_nclusters; cluster++)
+    {
+      next = fat_getcluster(fs, cluster);
+      if (next < 0)
+        {
+          kfree(freemap);
+          return next;
+        }
+      else if (next == 0)
+        {
+          nfree++;
+        }
+      else
+        {
+          FAT_FREEMAP_SET(freemap, cluster);
+        }
+    }
+
+  fs->fs_freemap = freemap;
+
+  /* Correct the in-memory free cluster count */
+
+  fs->fs_fsifreecount = nfree;
+  return OK;
+}
+#endif
+
+/****************************************************************************
+ * Name: fat_freemapsearch
+ *
+ * Desciption: Search clusters 'from' up to (but not including) 'to' for
+ *   free space.  If 'group' is zero, return the first free cluster.
+ *   Otherwise, return the first cluster of a completely free, aligned group
+ *   of 'group' clusters.  Zero is returned if nothing is found.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FAT_FREEMAP
+static uint32_t fat_freemapsearch(struct fat_mountpt_s *fs, uint32_t from,
+                                  uint32_t to, uint32_t group)
+{
+  uint32_t *freemap = fs->fs_freemap;
+  uint32_t  cluster;
+  uint32_t  i;
+
+  if (group == 0)
+    {
+      for (cluster = from; cluster < to; cluster++)
+        {
+          /* Skip over 32 clusters in use at a time */
+
+          if ((cluster & 31) == 0 && freemap[cluster >> 5] == 0xffffffff)
+            {
+              cluster += 31;
+            }
+          else if (!FAT_FREEMAP_ISSET(freemap, cluster))
+            {
+              return cluster;
+            }
+        }
+    }
+  else
+    {
+      for (cluster = ((from + group - 1) / group) * group;
+           cluster + group <= to;
+           cluster += group)
+        {
+          for (i = 0; i < group; i++)
+            {
+              if (FAT_FREEMAP_ISSET(freemap, cluster + i))
+                {
+                  break;
+                }
+            }
+
+          if (i >= group)
+            {
+              return cluster;
+            }
+        }
+    }
+
+  return 0;
+}
+#endif
+
+/****************************************************************************
+ * Name: fat_freemapalloc
+ *
+ * Desciption: Select a free cluster to follow 'cluster' (or to start a new
+ *   chain if 'cluster' is zero).  The cluster immediately following
+ *   'cluster' is used if it is free.  Otherwise, the chain moves to the
+ *   next completely free, aligned group of CONFIG_FAT_ALLOCRUN clusters
+ *   after 'startcluster', so that files that grow at the same time do not
+ *   interleave their clusters.  When no such group remains, any free
+ *   cluster is used.  Returns zero if there are no free clusters.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FAT_FREEMAP
+static uint32_t fat_freemapalloc(struct fat_mountpt_s *fs, uint32_t cluster,
+                                 uint32_t startcluster)
+{
+  uint32_t newcluster;
+  uint32_t from;
+
+  if (cluster >= 2 && cluster + 1 < fs->fs_nclusters &&
+      !FAT_FREEMAP_ISSET(fs->fs_freemap, cluster + 1))
+    {
+      return cluster + 1;
+    }
+
+  from = startcluster + 1;
+  if (from < 2 || from >= fs->fs_nclusters)
+    {
+      from = 2;
+    }
+
+  newcluster = fat_freemapsearch(fs, from, fs->fs_nclusters,
+                                 CONFIG_FAT_ALLOCRUN);
+  if (newcluster == 0)
+    {
+      newcluster = fat_freemapsearch(fs, 2, from, CONFIG_FAT_ALLOCRUN);
+    }
+
+  if (newcluster == 0)
+    {
+      newcluster = fat_freemapsearch(fs, from, fs->fs_nclusters, 0);
+    }
+
+  if (newcluster == 0)
+    {
+      newcluster = fat_freemapsearch(fs, 2, from, 0);
+    }
+
+  return newcluster;
+}
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -513,6 +950,7 @@ int fat_mount(struct fat_mountpt_s *fs, bool writeable)
   FAR struct inode *inode;
   struct geometry geo;
   int ret;
+  int i;
 
   /* Assume that the mount is successful */
 
@@ -541,15 +979,34 @@ int fat_mount(struct fat_mountpt_s *fs, bool writeable)
   fs->fs_hwsectorsize = geo.geo_sectorsize;
   fs->fs_hwnsectors   = geo.geo_nsectors;
 
-  /* Allocate a buffer to hold one hardware sector */
+  /* Allocate a buffer to hold CONFIG_FAT_NCACHESECTORS hardware sectors */
 
-  fs->fs_buffer = (uint8_t*)fat_io_alloc(fs->fs_hwsectorsize);
-  if (!fs->fs_buffer)
+  fs->fs_cachebuf = (uint8_t*)fat_io_alloc(FAT_CACHESIZE(fs));
+  if (!fs->fs_cachebuf)
     {
       ret = -ENOMEM;
       goto errout;
     }
 
+  /* Initialize the sector cache.  All entries are initially empty.  The
+   * first entry is used to hold the boot record while it is examined below.
+   */
+
+  for (i = 0; i < CONFIG_FAT_NCACHESECTORS; i++)
+    {
+      fs->fs_cache[i].fc_sector = -1;
+      fs->fs_cache[i].fc_stamp  = 0;
+      fs->fs_cache[i].fc_valid  = false;
+      fs->fs_cache[i].fc_dirty  = false;
+      fs->fs_cache[i].fc_buffer = &fs->fs_cachebuf[i * fs->fs_hwsectorsize];
+    }
+
+  fs->fs_cacheindex    = 0;
+  fs->fs_cachestamp    = 0;
+  fs->fs_buffer        = fs->fs_cache[0].fc_buffer;
+  fs->fs_currentsector = -1;
+  fs->fs_dirty         = false;
+
   /* Search FAT boot record on the drive.  First check at sector zero.  This
    * could be either the boot record or a partition that refers to the boot
    * record.
@@ -574,7 +1031,6 @@ int fat_mount(struct fat_mountpt_s *fs, bool writeable)
        * indexed by 16x the partition number.
        */
 
-       int i;
        for (i = 0; i < 4; i++)
          {
            /* Check if the partition exists and, if so, get the bootsector for that
@@ -673,8 +1129,9 @@ int fat_mount(struct fat_mountpt_s *fs, bool writeable)
   return OK;
 
  errout_with_buffer:
-  fat_io_free(fs->fs_buffer, fs->fs_hwsectorsize);
-  fs->fs_buffer = 0;
+  fat_io_free(fs->fs_cachebuf, FAT_CACHESIZE(fs));
+  fs->fs_cachebuf = NULL;
+  fs->fs_buffer   = NULL;
 
  errout:
   fs->fs_mounted = false;
@@ -771,7 +1228,17 @@ int fat_hwwrite(struct fat_mountpt_s *fs, uint8_t *buffer, off_t sector,
       struct inode *inode = fs->fs_blkdriver;
       if (inode && inode->u.i_bops && inode->u.i_bops->write)
         {
-          ssize_t nSectorsWritten =
+          ssize_t nSectorsWritten;
+
+#if CONFIG_FAT_NCACHESECTORS > 1
+          /* Make sure that the sector cache does not retain stale copies of
+           * the sectors being written.
+           */
+
+          fat_cacheinvalidate(fs, buffer, sector, nsectors);
+#endif
+
+          nSectorsWritten =
               inode->u.i_bops->write(inode, buffer, sector, nsectors);
 
           if (nSectorsWritten == nsectors)
@@ -1091,6 +1558,23 @@ int fat_putcluster(struct fat_mountpt_s *fs, uint32_t clusterno, off_t nextclust
       /* Mark the modified sector as "dirty" and return success */
 
       fs->fs_dirty = true;
+
+#ifdef CONFIG_FAT_FREEMAP
+      /* Keep the free cluster bitmap in agreement with the FAT */
+
+      if (fs->fs_freemap && clusterno >= 2)
+        {
+          if (nextcluster != 0)
+            {
+              FAT_FREEMAP_SET(fs->fs_freemap, clusterno);
+            }
+          else
+            {
+              FAT_FREEMAP_CLR(fs->fs_freemap, clusterno);
+            }
+        }
+#endif
+
       return OK;
     }
 
@@ -1209,61 +1693,83 @@ int32_t fat_extendchain(struct fat_mountpt_s *fs, uint32_t cluster)
       startcluster = cluster;
     }
 
-  /* Loop until (1) we discover that there are not free clusters
-   * (return 0), an errors occurs (return -errno), or (3) we find
-   * the next cluster (return the new cluster number).
+#ifdef CONFIG_FAT_FREEMAP
+  /* Build the free cluster bitmap the first time that a cluster is
+   * allocated.  If that fails, fall back to searching the FAT.
    */
 
-  newcluster = startcluster;
-  for (;;)
+  if (!fs->fs_freemap)
     {
-      /* Examine the next cluster in the FAT */
+      (void)fat_freemapbuild(fs);
+    }
 
-      newcluster++;
-      if (newcluster >= fs->fs_nclusters)
+  if (fs->fs_freemap)
+    {
+      newcluster = fat_freemapalloc(fs, cluster, startcluster);
+      if (newcluster == 0)
         {
-          /* If we hit the end of the available clusters, then
-           * wrap back to the beginning because we might have
-           * started at a non-optimal place.  But don't continue
-           * past the start cluster.
-           */
+          return 0;
+        }
+    }
+  else
+#endif
+    {
+      /* Loop until (1) we discover that there are not free clusters
+       * (return 0), an errors occurs (return -errno), or (3) we find
+       * the next cluster (return the new cluster number).
+       */
+
+      newcluster = startcluster;
+      for (;;)
+        {
+          /* Examine the next cluster in the FAT */
 
-          newcluster = 2;
-          if (newcluster > startcluster)
+          newcluster++;
+          if (newcluster >= fs->fs_nclusters)
             {
-              /* We are back past the starting cluster, then there
-               * is no free cluster.
+              /* If we hit the end of the available clusters, then
+               * wrap back to the beginning because we might have
+               * started at a non-optimal place.  But don't continue
+               * past the start cluster.
                */
 
-              return 0;
+              newcluster = 2;
+              if (newcluster > startcluster)
+                {
+                  /* We are back past the starting cluster, then there
+                   * is no free cluster.
+                   */
+
+                  return 0;
+                }
             }
-        }
 
-      /* We have a candidate cluster.  Check if the cluster number is
-       * mapped to a group of sectors.
-       */
+          /* We have a candidate cluster.  Check if the cluster number is
+           * mapped to a group of sectors.
+           */
 
-      startsector = fat_getcluster(fs, newcluster);
-      if (startsector == 0)
-        {
-          /* Found have found a free cluster break out */
+          startsector = fat_getcluster(fs, newcluster);
+          if (startsector == 0)
+            {
+              /* Found have found a free cluster break out */
 
-          break;
-        }
-      else if (startsector < 0)
-        {
-          /* Some error occurred, return the error number */
+              break;
+            }
+          else if (startsector < 0)
+            {
+              /* Some error occurred, return the error number */
 
-          return startsector;
-        }
+              return startsector;
+            }
 
-      /* We wrap all the back to the starting cluster?  If so, then
-       * there are no free clusters.
-       */
+          /* We wrap all the back to the starting cluster?  If so, then
+           * there are no free clusters.
+           */
 
-      if (newcluster == startcluster)
-        {
-          return 0;
+          if (newcluster == startcluster)
+            {
+              return 0;
+            }
         }
     }
 
@@ -1306,6 +1812,237 @@ int32_t fat_extendchain(struct fat_mountpt_s *fs, uint32_t cluster)
   return newcluster;
 }
 
+/****************************************************************************
+ * Name: fat_nextcluster
+ *
+ * Desciption: Return the cluster that follows the current cluster of an
+ *   open file (ff_currentcluster at file cluster ff_clusterindex).  If
+ *   'extend' is true, the chain is extended as necessary as with
+ *   fat_extendchain(); otherwise the value is that of fat_getcluster().
+ *   The caller is responsible for updating ff_currentcluster and
+ *   ff_clusterindex.
+ *
+ ****************************************************************************/
+
+off_t fat_nextcluster(struct fat_mountpt_s *fs, struct fat_file_s *ff,
+                      bool extend)
+{
+  off_t cluster;
+
+#ifdef CONFIG_FAT_EXTENTCACHE
+  uint32_t next;
+
+  /* Try the extent cache first */
+
+  if (fat_extentnext(ff, ff->ff_clusterindex, ff->ff_currentcluster, &next))
+    {
+      return next;
+    }
+#endif
+
+  /* Then follow the chain in the FAT */
+
+  if (extend)
+    {
+      cluster = fat_extendchain(fs, ff->ff_currentcluster);
+    }
+  else
+    {
+      cluster = fat_getcluster(fs, ff->ff_currentcluster);
+    }
+
+#ifdef CONFIG_FAT_EXTENTCACHE
+  /* And remember the link for next time */
+
+  if (cluster >= 2 && cluster < fs->fs_nclusters)
+    {
+      fat_extentadd(ff, ff->ff_clusterindex + 1, cluster);
+    }
+#endif
+
+  return cluster;
+}
+
+/****************************************************************************
+ * Name: fat_extentinit
+ *
+ * Desciption: Reset the extent cache of an open file.  This must be called
+ *   whenever ff_startcluster is set.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FAT_EXTENTCACHE
+void fat_extentinit(struct fat_file_s *ff)
+{
+  ff->ff_nextents = 0;
+  if (ff->ff_startcluster >= 2)
+    {
+      ff->ff_extents[0].fe_index     = 0;
+      ff->ff_extents[0].fe_cluster   = ff->ff_startcluster;
+      ff->ff_extents[0].fe_nclusters = 1;
+      ff->ff_nextents                = 1;
+    }
+}
+#endif
+
+/****************************************************************************
+ * Name: fat_extentfind
+ *
+ * Desciption: Find the cached cluster nearest to, but not after, file
+ *   cluster 'index'.  The file cluster index of that cluster is returned in
+ *   'pindex'.  Zero is returned if nothing is cached.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FAT_EXTENTCACHE
+uint32_t fat_extentfind(struct fat_file_s *ff, uint32_t index,
+                        uint32_t *pindex)
+{
+  struct fat_extent_s *extent;
+
+  if (ff->ff_nextents == 0)
+    {
+      return 0;
+    }
+
+  extent = &ff->ff_extents[fat_extentsearch(ff, index)];
+  if (index - extent->fe_index >= extent->fe_nclusters)
+    {
+      /* Beyond the cached part of the chain.  Return the last cluster. */
+
+      index = extent->fe_index + extent->fe_nclusters - 1;
+    }
+
+  *pindex = index;
+  return extent->fe_cluster + (index - extent->fe_index);
+}
+#endif
+
+/****************************************************************************
+ * Name: fat_extentrun
+ *
+ * Desciption: Return the number of physically contiguous clusters, up to
+ *   'maxclusters', in the chain of an open file beginning with its current
+ *   cluster.  The FAT is consulted for links that are not yet cached.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FAT_EXTENTCACHE
+uint32_t fat_extentrun(struct fat_mountpt_s *fs, struct fat_file_s *ff,
+                       uint32_t maxclusters)
+{
+  uint32_t index   = ff->ff_clusterindex;
+  uint32_t cluster = ff->ff_currentcluster;
+  uint32_t nclusters;
+  uint32_t next;
+  off_t    link;
+
+  for (nclusters = 1; nclusters < maxclusters; nclusters++)
+    {
+      if (!fat_extentnext(ff, index, cluster, &next))
+        {
+          link = fat_getcluster(fs, cluster);
+          if (link < 2 || link >= fs->fs_nclusters)
+            {
+              break;
+            }
+
+          next = link;
+          fat_extentadd(ff, index + 1, next);
+        }
+
+      if (next != cluster + 1)
+        {
+          break;
+        }
+
+      index++;
+      cluster++;
+    }
+
+  return nclusters;
+}
+#endif
+
+/****************************************************************************
+ * Name: fat_mmap
+ *
+ * Desciption: Return the address of the data of an open file in directly
+ *   addressable media.  This is possible only if the block driver supports
+ *   the BIOC_XIPBASE ioctl and the clusters of the file are contiguous.
+ *
+ ****************************************************************************/
+
+int fat_mmap(struct fat_mountpt_s *fs, struct fat_file_s *ff, void **ppv)
+{
+  struct inode *inode = fs->fs_blkdriver;
+  uint8_t      *xipbase = NULL;
+  uint32_t      clustersize;
+  uint32_t      nclusters;
+  uint32_t      cluster;
+  off_t         next;
+  int           ret;
+
+  if (!ppv)
+    {
+      return -EINVAL;
+    }
+
+  /* Is the media directly addressable? */
+
+  if (!inode || !inode->u.i_bops || !inode->u.i_bops->ioctl)
+    {
+      return -ENOTTY;
+    }
+
+  ret = inode->u.i_bops->ioctl(inode, BIOC_XIPBASE,
+                               (unsigned long)((uintptr_t)&xipbase));
+  if (ret < 0 || !xipbase)
+    {
+      return -ENOTTY;
+    }
+
+  /* An empty file has no data to map */
+
+  if (ff->ff_size == 0 || ff->ff_startcluster < 2)
+    {
+      return -ENOTTY;
+    }
+
+  /* Make sure that any data buffered for this file is on the media */
+
+  ret = fat_ffcacheflush(fs, ff);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  /* Verify that each cluster of the file is followed by the next one */
+
+  clustersize = fs->fs_fatsecperclus * fs->fs_hwsectorsize;
+  nclusters   = (ff->ff_size + clustersize - 1) / clustersize;
+  cluster     = ff->ff_startcluster;
+
+  while (--nclusters > 0)
+    {
+      next = fat_getcluster(fs, cluster);
+      if (next < 0)
+        {
+          return (int)next;
+        }
+      else if (next != cluster + 1)
+        {
+          return -ENOTTY;
+        }
+
+      cluster++;
+    }
+
+  *ppv = (void *)(xipbase + fat_cluster2sector(fs, ff->ff_startcluster) *
+                            fs->fs_hwsectorsize);
+  return OK;
+}
+
 /****************************************************************************
  * Name: fat_nextdirentry
  *
@@ -1468,97 +2205,162 @@ int  fat_dirtruncate(struct fat_mountpt_s *fs, struct fat_dirinfo_s *dirinfo)
 /****************************************************************************
  * Name: fat_fscacheflush
  *
- * Desciption: Flush any dirty sector if fs_buffer as necessary
+ * Desciption: Write back all dirty sectors in the mountpoint sector cache
  *
  ****************************************************************************/
 
 int fat_fscacheflush(struct fat_mountpt_s *fs)
 {
+  struct fat_cache_s *cache;
   int ret;
+  int i;
 
-  /* Check if the fs_buffer is dirty.  In this case, we will write back the
-   * contents of fs_buffer.
+  /* Make sure that the state of the sector in fs_buffer is reflected in its
+   * cache entry.
    */
 
-  if (fs->fs_dirty)
-    {
-      /* Write the dirty sector */
-
-      ret = fat_hwwrite(fs, fs->fs_buffer, fs->fs_currentsector, 1);
-      if (ret < 0)
-        {
-          return ret;
-        }
+  fat_cachesync(fs);
 
-      /* Does the sector lie in the FAT region? */
+  /* Then write back every dirty sector */
 
-      if (fs->fs_currentsector >= fs->fs_fatbase &&
-          fs->fs_currentsector < fs->fs_fatbase + fs->fs_nfatsects)
+  for (i = 0; i < CONFIG_FAT_NCACHESECTORS; i++)
+    {
+      cache = &fs->fs_cache[i];
+      if (cache->fc_valid && cache->fc_dirty)
         {
-          /* Yes, then make the change in the FAT copy as well */
-          int i;
-
-          for (i = fs->fs_fatnumfats; i >= 2; i--)
+          ret = fat_cachewrite(fs, cache->fc_buffer, cache->fc_sector);
+          if (ret < 0)
             {
-              fs->fs_currentsector += fs->fs_nfatsects;
-              ret = fat_hwwrite(fs, fs->fs_buffer, fs->fs_currentsector, 1);
-              if (ret < 0)
-                {
-                  return ret;
-                }
+              return ret;
             }
-        }
 
-      /* No longer dirty */
+          /* No longer dirty */
 
-      fs->fs_dirty = false;
+          cache->fc_dirty = false;
+        }
     }
+
+  fs->fs_dirty = false;
   return OK;
 }
 
 /****************************************************************************
  * Name: fat_fscacheread
  *
- * Desciption: Read the specified sector into the sector cache, flushing any
- *   existing dirty sectors as necessary.
+ * Desciption: Make the specified sector the current sector in fs_buffer,
+ *   reading it from the device if it is not already in the sector cache.
+ *   When the cache is full, the least recently used sector is replaced,
+ *   writing it back first if it is dirty.
  *
  ****************************************************************************/
 
 int fat_fscacheread(struct fat_mountpt_s *fs, off_t sector)
 {
+  struct fat_cache_s *cache;
+  uint32_t stamp;
+  int victim;
   int ret;
 
   /* fs->fs_currentsector holds the current sector that is buffered in
    * fs->fs_buffer. If the requested sector is the same as this sector, then
-   * we do nothing. Otherwise, we will have to read the new sector.
+   * we do nothing.
    */
 
-    if (fs->fs_currentsector != sector)
-      {
-        /* We will need to read the new sector.  First, flush the cached
-         * sector if it is dirty.
-         */
+  if (fs->fs_currentsector == sector)
+    {
+      return OK;
+    }
+
+  /* Save the state of the current sector in its cache entry */
+
+  fat_cachesync(fs);
+  stamp = ++fs->fs_cachestamp;
+
+#if CONFIG_FAT_NCACHESECTORS > 1
+  {
+    uint32_t maxage = 0;
+    uint32_t age;
+    int i;
 
-        ret = fat_fscacheflush(fs);
-        if (ret < 0)
+    /* Search the cache for the sector, selecting the least recently used
+     * entry (preferring an empty one) as the victim in case it is not found.
+     */
+
+    victim = 0;
+    for (i = 0; i < CONFIG_FAT_NCACHESECTORS; i++)
+      {
+        cache = &fs->fs_cache[i];
+        if (!cache->fc_valid)
           {
-              return ret;
+            age = UINT32_MAX;
+          }
+        else if (cache->fc_sector == sector)
+          {
+            /* Cache hit.  Make this the current sector */
+
+            cache->fc_stamp      = stamp;
+            fs->fs_cacheindex    = i;
+            fs->fs_buffer        = cache->fc_buffer;
+            fs->fs_currentsector = sector;
+            fs->fs_dirty         = cache->fc_dirty;
+            return OK;
+          }
+        else
+          {
+            age = stamp - cache->fc_stamp;
           }
 
-        /* Then read the specified sector into the cache */
-
-        ret = fat_hwread(fs, fs->fs_buffer, sector, 1);
-        if (ret < 0)
+        if (age > maxage)
           {
-            return ret;
+            maxage = age;
+            victim = i;
           }
+      }
+  }
+#else
+  victim = 0;
+#endif
 
-        /* Update the cached sector number */
+  /* We will need to read the new sector.  First, write back the victim
+   * sector if it is dirty.
+   */
 
-        fs->fs_currentsector = sector;
+  cache = &fs->fs_cache[victim];
+  if (cache->fc_valid && cache->fc_dirty)
+    {
+      ret = fat_cachewrite(fs, cache->fc_buffer, cache->fc_sector);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      cache->fc_dirty = false;
     }
 
-    return OK;
+  /* The victim becomes the current entry */
+
+  cache->fc_stamp   = stamp;
+  fs->fs_cacheindex = victim;
+  fs->fs_buffer     = cache->fc_buffer;
+  fs->fs_dirty      = false;
+
+  /* Then read the specified sector into the cache */
+
+  ret = fat_hwread(fs, cache->fc_buffer, sector, 1);
+  if (ret < 0)
+    {
+      cache->fc_sector     = -1;
+      cache->fc_valid      = false;
+      fs->fs_currentsector = -1;
+      return ret;
+    }
+
+  /* Update the cached sector number */
+
+  cache->fc_sector     = sector;
+  cache->fc_valid      = true;
+  fs->fs_currentsector = sector;
+  return OK;
 }
 
 /****************************************************************************
@@ -1733,6 +2535,18 @@ int fat_nfreeclusters(struct fat_mountpt_s *fs, off_t *pfreeclusters)
 {
   uint32_t nfreeclusters;
 
+#ifdef CONFIG_FAT_FREEMAP
+  /* Building the free cluster bitmap also determines the exact number of
+   * free clusters.  It is then kept up to date as clusters are allocated
+   * and freed.
+   */
+
+  if (!fs->fs_freemap)
+    {
+      (void)fat_freemapbuild(fs);
+    }
+#endif
+
   /* If number of the first free cluster is valid, then just return that value. */
 
   if (fs->fs_fsifreecount <= fs->fs_nclusters - 2)
@@ -1779,7 +2593,7 @@ int fat_nfreeclusters(struct fat_mountpt_s *fs, off_t *pfreeclusters)
 
           if (offset >= fs->fs_hwsectorsize)
             {
-              ret = fat_fscacheread(fs, fatsector++);
+              ret = fat_fscacheread(fs, fatsector);
               if (ret < 0)
                 {
                   return ret;
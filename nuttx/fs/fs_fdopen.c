@@ -201,11 +201,20 @@ FAR struct file_struct *fs_fdopen(int fd, int oflags, FAR struct tcb_s *tcb)
 
   /* Find an unallocated FILE structure in the stream list */
 
+#ifdef CONFIG_MUTEX_FASTPATH
+  ret = pthread_mutex_lock(&slist->sl_lock);
+  if (ret != OK)
+    {
+      err = ret;
+      goto errout;
+    }
+#else
   ret = sem_wait(&slist->sl_sem);
   if (ret != OK)
     {
       goto errout_with_errno;
     }
+#endif
 
   for (i = 0 ; i < CONFIG_NFILE_STREAMS; i++)
     {
@@ -223,7 +232,11 @@ FAR struct file_struct *fs_fdopen(int fd, int oflags, FAR struct tcb_s *tcb)
 #if CONFIG_STDIO_BUFFER_SIZE > 0
           /* Initialize the semaphore the manages access to the buffer */
 
+#ifdef CONFIG_MUTEX_FASTPATH
+          (void)pthread_mutex_init(&stream->fs_lock, NULL);
+#else
           (void)sem_init(&stream->fs_sem, 0, 1);
+#endif
 
           /* Allocate the IO buffer */
 
@@ -248,7 +261,11 @@ FAR struct file_struct *fs_fdopen(int fd, int oflags, FAR struct tcb_s *tcb)
           stream->fs_fd      = fd;
           stream->fs_oflags  = (uint16_t)oflags;
 
+#ifdef CONFIG_MUTEX_FASTPATH
+          (void)pthread_mutex_unlock(&slist->sl_lock);
+#else
           sem_post(&slist->sl_sem);
+#endif
           return stream;
         }
     }
@@ -260,10 +277,16 @@ FAR struct file_struct *fs_fdopen(int fd, int oflags, FAR struct tcb_s *tcb)
 #if CONFIG_STDIO_BUFFER_SIZE > 0
 errout_with_sem:
 #endif
+#ifdef CONFIG_MUTEX_FASTPATH
+  (void)pthread_mutex_unlock(&slist->sl_lock);
+#else
   sem_post(&slist->sl_sem);
+#endif
 
 errout:
   set_errno(err);
+#ifndef CONFIG_MUTEX_FASTPATH
 errout_with_errno:
+#endif
   return NULL;
 }
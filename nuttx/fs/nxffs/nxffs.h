@@ -52,6 +52,10 @@
 #include <nuttx/mtd/mtd.h>
 #include <nuttx/fs/nxffs.h>
 
+#ifdef CONFIG_NXFFS_BGPACK
+#  include <nuttx/wqueue.h>
+#endif
+
 /****************************************************************************
  * Pre-processor Definitions
  ****************************************************************************/
@@ -118,10 +122,26 @@
  *   spans more than one logical block, then the inode data may be enclosed
  *   in multiple data blocks, one per logical block.
  *
+ *   Each data block header also holds the FLASH offset of the inode header
+ *   that owns the data.  This tag permits the data blocks of several files
+ *   to be interleaved in FLASH:  Each file opened for writing appends to
+ *   its own stream of data blocks and readers (and the packing logic)
+ *   simply skip over data blocks that belong to other inodes.  Volumes
+ *   written by older versions of NXFFS use an untagged data block header
+ *   (with a different magic number).  Such volumes can still be read; the
+ *   data blocks of an untagged inode follow its header contiguously.
+ *
+ * INODE INDEX:
+ *   When the volume is mounted, the FLASH is scanned once and an in-memory
+ *   index that maps a hash of each file name to the FLASH offset of its
+ *   inode header is constructed.  Opening, deleting, and stat'ing files
+ *   then require only a single read of the candidate inode header.
+ *
  * NXFFS Limitations:
- * 1. Since the files are contiguous in FLASH and since allocations always
- *    proceed toward the end of the FLASH, there can only be one file opened
- *    for writing at a time.  Multiple files may be opened for reading.
+ * 1. Since allocations always proceed toward the end of the FLASH, each
+ *    file opened for writing holds (at most) one partially written logical
+ *    block at a time.  Any number of files may be open for writing and for
+ *    reading at the same time.
  * 2. Files may not be increased in size after they have been closed.  The
  *    O_APPEND open flag is not supported.
  * 3. Files are always written sequential.  Seeking within a file opened for
@@ -133,10 +153,10 @@
  * 6. The re-packing process occurs only during a write when the free FLASH
  *    memory at the end of the FLASH is exhausted.  Thus, occasionally, file
  *    writing may take a long time.
- * 7. Another limitation is that there can be only a single NXFFS volume
- *    mounted at any time.  This has to do with the fact that we bind to
- *    an MTD driver (instead of a block driver) and bypass all of the normal
- *    mount operations.
+ * 7. NXFFS binds to an MTD driver (instead of a block driver) and bypasses
+ *    the normal mount operations.  Each call to nxffs_initialize() creates
+ *    a new volume; mount() binds the earliest initialized volume that is
+ *    not already mounted.
  */
 
 /* Values for logical block state.  Basically, there are only two, perhaps
@@ -184,6 +204,16 @@
 
 #define NXFFS_NERASED             128
 
+/* The in-memory inode index is grown by this number of entries at a time */
+
+#define NXFFS_INDEX_INCR          16
+
+/* Object types reported by nxffs_nextobject() */
+
+#define NXFFS_OBJ_INODE           0  /* A valid inode header */
+#define NXFFS_OBJ_DELETED         1  /* An inode header marked deleted */
+#define NXFFS_OBJ_DATA            2  /* A data block */
+
 /* Quasi-standard definitions */
 
 #ifndef MIN
@@ -222,15 +252,20 @@ struct nxffs_inode_s
 };
 #define SIZEOF_NXFFS_INODE_HDR 26
 
-/* This structure defines each packed NXFFS data header on the FLASH media */
+/* This structure defines each packed NXFFS data header on the FLASH media.
+ * Untagged data headers (g_datamagic) written by older versions of NXFFS
+ * end after the datlen field.
+ */
 
 struct nxffs_data_s
 {
   uint8_t                   magic[4];  /* 0-3: Magic number for valid data */
   uint8_t                   crc[4];    /* 4-7: CRC32 */
   uint8_t                   datlen[2]; /* 8-9: Length of data in bytes */
+  uint8_t                   owner[4];  /* 10-13: FLASH offset to the inode header */
 };
-#define SIZEOF_NXFFS_DATA_HDR 10
+#define SIZEOF_NXFFS_DATA_HDR 14
+#define SIZEOF_NXFFS_UNTAGGED_HDR 10
 
 /* This is an in-memory representation of the NXFFS inode as extracted from
  * FLASH and with additional state information.
@@ -251,8 +286,31 @@ struct nxffs_entry_s
 struct nxffs_blkentry_s
 {
   off_t                     hoffset;  /* Offset to the block data header */
+  off_t                     owner;    /* Offset to the inode header (0=untagged) */
   uint16_t                  datlen;   /* Length of data following the header */
   uint16_t                  foffset;  /* Offset to start of data */
+  uint8_t                   hdrlen;   /* Size of the data block header */
+};
+
+/* This structure describes one object found when scanning the FLASH */
+
+struct nxffs_object_s
+{
+  uint8_t                   type;     /* See NXFFS_OBJ_* definitions */
+  off_t                     next;     /* Offset to the first byte after the object */
+  struct nxffs_entry_s      entry;    /* Inode header (NXFFS_OBJ_INODE/DELETED) */
+  struct nxffs_blkentry_s   blkentry; /* Data block (NXFFS_OBJ_DATA) */
+};
+
+/* This structure describes one entry in the in-memory inode index.  The
+ * index is sorted by the FLASH offset of the inode header.
+ */
+
+struct nxffs_index_s
+{
+  off_t                     hoffset;  /* FLASH offset to the inode header */
+  off_t                     doffset;  /* FLASH offset to the first data block */
+  uint32_t                  hash;     /* CRC32 of the inode name */
 };
 
 /* This structure describes the state of one open file.  This structure
@@ -287,10 +345,11 @@ struct nxffs_wrfile_s
 
 struct nxffs_volume_s
 {
+  FAR struct nxffs_volume_s *flink;    /* Supports a singly linked list */
   FAR struct mtd_dev_s     *mtd;       /* Supports FLASH access */
   sem_t                     exclsem;   /* Used to assure thread-safe access */
-  sem_t                     wrsem;     /* Enforces single writer restriction */
   struct mtd_geometry_s     geo;       /* Device geometry */
+  bool                      mounted;   /* True: Volume is bound to a mountpoint */
   uint8_t                   blkper;    /* R/W blocks per erase block */
   uint16_t                  iooffset;  /* Next offset in read/write access (in ioblock) */
   off_t                     inoffset;  /* Offset to the first valid inode header */
@@ -301,6 +360,13 @@ struct nxffs_volume_s
   FAR struct nxffs_ofile_s *ofiles;    /* A singly-linked list of open files */
   FAR uint8_t              *cache;     /* On cached erase block for general I/O */
   FAR uint8_t              *pack;      /* A full erase block to support packing */
+  FAR struct nxffs_index_s *index;     /* In-memory index of valid inodes */
+  size_t                    ninodes;   /* Number of entries in the index */
+  size_t                    maxinodes; /* Allocated size of the index */
+  struct nxffs_packstats_s  stats;     /* Packing statistics */
+#ifdef CONFIG_NXFFS_BGPACK
+  struct work_s             work;      /* Supports background packing */
+#endif
 };
 
 /* This structure describes the state of the blocks on the NXFFS volume */
@@ -335,13 +401,11 @@ extern const uint8_t g_inodemagic[NXFFS_MAGICSIZE];
 
 extern const uint8_t g_datamagic[NXFFS_MAGICSIZE];
 
-/* If CONFIG_NXFFS_PREALLOCATED is defined, then this is the single, pre-
- * allocated NXFFS volume instance.
+/* The magic number that appears that the beginning of each NXFFS inode
+ * data block that is tagged with the offset of its inode header.
  */
 
-#ifdef CONFIG_NXFFS_PREALLOCATED
-extern struct nxffs_volume_s g_volume;
-#endif
+extern const uint8_t g_tagmagic[NXFFS_MAGICSIZE];
 
 /****************************************************************************
  * Public Function Prototypes
@@ -363,6 +427,8 @@ extern struct nxffs_volume_s g_volume;
  *   data is written, or (2) recalculated as part of the file system packing
  *   operation.
  *
+ *   The in-memory inode index is rebuilt as a side effect.
+ *
  * Input Parameters:
  *   volume - Identifies the NXFFS volume
  *
@@ -572,7 +638,7 @@ int nxffs_getc(FAR struct nxffs_volume_s *volume, uint16_t reserve);
  * Name: nxffs_freeentry
  *
  * Description:
- *   The inode values returned by nxffs_nextentry() include allocated memory
+ *   The inode values returned by nxffs_nextobject() include allocated memory
  *   (specifically, the file name string).  This function should be called
  *   to dispose of that memory when the inode entry is no longer needed.
  *
@@ -593,35 +659,65 @@ int nxffs_getc(FAR struct nxffs_volume_s *volume, uint16_t reserve);
 void nxffs_freeentry(FAR struct nxffs_entry_s *entry);
 
 /****************************************************************************
- * Name: nxffs_nextentry
+ * Name: nxffs_rdinode
  *
  * Description:
- *   Search for the next valid inode starting at the provided FLASH offset.
+ *   Read and verify the inode header at a known FLASH offset.
  *
  * Input Parameters:
  *   volume - Describes the NXFFS volume.
- *   offset - The FLASH memory offset to begin searching.
+ *   offset - The FLASH offset to the inode header.
  *   entry  - A pointer to memory provided by the caller in which to return
  *     the inode description.
- *  
+ *
  * Returned Value:
  *   Zero is returned on success. Otherwise, a negated errno is returned
- *   that indicates the nature of the failure.
+ *   that indicates the nature of the failure.  -ENOENT means that the
+ *   inode header is valid but has been deleted.
  *
  * Defined in nxffs_inode.c
  *
  ****************************************************************************/
 
-int nxffs_nextentry(FAR struct nxffs_volume_s *volume, off_t offset,
-                    FAR struct nxffs_entry_s *entry);
+int nxffs_rdinode(FAR struct nxffs_volume_s *volume, off_t offset,
+                  FAR struct nxffs_entry_s *entry);
+
+/****************************************************************************
+ * Name: nxffs_nextobject
+ *
+ * Description:
+ *   Search for the next valid inode header or data block starting at the
+ *   provided FLASH offset.  Deleted inode headers are also reported and
+ *   data blocks are parsed and skipped exactly, so that the FLASH content
+ *   can be walked object-by-object.
+ *
+ * Input Parameters:
+ *   volume - Describes the NXFFS volume.
+ *   offset - The FLASH memory offset to begin searching.
+ *   end    - Stop searching at this FLASH offset.
+ *   object - A pointer to memory provided by the caller in which to return
+ *     the object description.  For inode headers, object->entry holds an
+ *     allocated name that must be freed with nxffs_freeentry().
+ *
+ * Returned Value:
+ *   Zero is returned on success. Otherwise, a negated errno is returned
+ *   that indicates the nature of the failure.  -ENOENT is returned if the
+ *   end of the valid data was reached.  In that case, volume->ioblock and
+ *   volume->iooffset refer to the first byte of the erased region.
+ *
+ * Defined in nxffs_inode.c
+ *
+ ****************************************************************************/
+
+int nxffs_nextobject(FAR struct nxffs_volume_s *volume, off_t offset,
+                     off_t end, FAR struct nxffs_object_s *object);
 
 /****************************************************************************
  * Name: nxffs_findinode
  *
  * Description:
- *   Search for an inode with the provided name starting with the first
- *   valid inode and proceeding to the end FLASH or until the matching
- *   inode is found.
+ *   Search the in-memory inode index for an inode with the provided name.
+ *   Only the inode headers with a matching name hash are read from FLASH.
  *
  * Input Parameters:
  *   volume - Describes the NXFFS volume
@@ -640,31 +736,101 @@ int nxffs_findinode(FAR struct nxffs_volume_s *volume, FAR const char *name,
                     FAR struct nxffs_entry_s *entry);
 
 /****************************************************************************
- * Name: nxffs_inodeend
+ * Name: nxffs_hashname
  *
  * Description:
- *   Return an *approximiate* FLASH offset to end of the inode data.  The
- *   returned value is guaranteed to be be less then or equal to the offset
- *   of the thing-of-interest in FLASH.  Parsing for interesting things
- *   can begin at that point.
+ *   Return the hash of an inode name that is used in the inode index.
+ *
+ * Input Parameters:
+ *   name - The inode name.
+ *
+ * Returned Value:
+ *   The 32-bit hash value.
+ *
+ * Defined in nxffs_index.c
+ *
+ ****************************************************************************/
+
+uint32_t nxffs_hashname(FAR const char *name);
+
+/****************************************************************************
+ * Name: nxffs_addindex
  *
- *   Assumption:  The inode header has been verified by the caller and is
- *   known to contain valid data.
+ * Description:
+ *   Add a valid inode to the in-memory inode index.
  *
  * Input Parameters:
  *   volume - Describes the NXFFS volume
  *   entry  - Describes the inode.
  *
  * Returned Value:
- *   A FLASH offset to the (approximate) end of the inode data.  No errors
- *   are detected.
+ *   Zero is returned on success. Otherwise, a negated errno is returned
+ *   that indicates the nature of the failure.
  *
- * Defined in nxffs_inode.c
+ * Defined in nxffs_index.c
+ *
+ ****************************************************************************/
+
+int nxffs_addindex(FAR struct nxffs_volume_s *volume,
+                   FAR const struct nxffs_entry_s *entry);
+
+/****************************************************************************
+ * Name: nxffs_rmindex
+ *
+ * Description:
+ *   Remove the inode at the provided FLASH offset from the inode index.
+ *
+ * Input Parameters:
+ *   volume  - Describes the NXFFS volume
+ *   hoffset - The FLASH offset to the inode header.
+ *
+ * Returned Value:
+ *   None.
+ *
+ * Defined in nxffs_index.c
  *
  ****************************************************************************/
 
-off_t nxffs_inodeend(FAR struct nxffs_volume_s *volume,
-                     FAR struct nxffs_entry_s *entry);
+void nxffs_rmindex(FAR struct nxffs_volume_s *volume, off_t hoffset);
+
+/****************************************************************************
+ * Name: nxffs_findindex
+ *
+ * Description:
+ *   Find the index of the first inode index entry whose inode header lies
+ *   at or after the provided FLASH offset.
+ *
+ * Input Parameters:
+ *   volume  - Describes the NXFFS volume
+ *   hoffset - The FLASH offset to search for.
+ *
+ * Returned Value:
+ *   The index of the entry.  volume->ninodes is returned if there is no
+ *   such entry.
+ *
+ * Defined in nxffs_index.c
+ *
+ ****************************************************************************/
+
+size_t nxffs_findindex(FAR struct nxffs_volume_s *volume, off_t hoffset);
+
+/****************************************************************************
+ * Name: nxffs_clrindex
+ *
+ * Description:
+ *   Discard all entries in the inode index.
+ *
+ * Input Parameters:
+ *   volume - Describes the NXFFS volume
+ *
+ * Returned Value:
+ *   None.
+ *
+ * Defined in nxffs_index.c
+ *
+ ****************************************************************************/
+
+void nxffs_clrindex(FAR struct nxffs_volume_s *volume);
 
 /****************************************************************************
  * Name: nxffs_verifyblock
@@ -803,26 +969,6 @@ void nxffs_blkinit(FAR struct nxffs_volume_s *volume, FAR uint8_t *blkptr,
 FAR struct nxffs_ofile_s *nxffs_findofile(FAR struct nxffs_volume_s *volume,
                                           FAR const char *name);
 
-/****************************************************************************
- * Name: nxffs_findwriter
- *
- * Description:
- *   Search the list of already opened files and return the open file
- *   instance for the write.
- *
- * Input Parameters:
- *   volume - Describes the NXFFS volume.
- *
- * Returned Value:
- *   If there is an active writer of the volume, its open file instance is
- *   returned.  NULL is returned otherwise.
- *
- * Defined in nxffs_open.c
- *
- ****************************************************************************/
-
-FAR struct nxffs_wrfile_s *nxffs_findwriter(FAR struct nxffs_volume_s *volume);
-
 /****************************************************************************
  * Name: nxffs_wrinode
  *
@@ -858,16 +1004,19 @@ int nxffs_wrinode(FAR struct nxffs_volume_s *volume,
  *   this inode and, if so, move the data in the open file structure as well.
  *
  * Input parameters
- *   volume - Describes the NXFFS volume
- *   entry  - Describes the new inode entry
+ *   volume  - Describes the NXFFS volume
+ *   hoffset - The original FLASH offset to the inode header
+ *   entry   - Describes the new inode entry
  *
  * Returned Value:
  *   Zero is returned on success; Otherwise, a negated errno value is returned
  *   indicating the nature of the failure.
  *
+ * Defined in nxffs_open.c
+ *
  ****************************************************************************/
 
-int nxffs_updateinode(FAR struct nxffs_volume_s *volume,
+int nxffs_updateinode(FAR struct nxffs_volume_s *volume, off_t hoffset,
                       FAR struct nxffs_entry_s *entry);
 
 /****************************************************************************
@@ -960,7 +1109,9 @@ int nxffs_wrverify(FAR struct nxffs_volume_s *volume, size_t size);
  * Description:
  *   Write the block header information.  This is done (1) whenever the end-
  *   block is encountered and (2) also when the file is closed in order to
- *   flush the final block of data to FLASH.
+ *   flush the final block of data to FLASH.  The unused remainder of the
+ *   logical block that was reserved for the data block is returned to the
+ *   free FLASH region if nothing has been allocated after it.
  *
  * Input Parameters:
  *   volume - Describes the state of the NXFFS volume
@@ -981,13 +1132,14 @@ int nxffs_wrblkhdr(FAR struct nxffs_volume_s *volume,
  * Name: nxffs_nextblock
  *
  * Description:
- *   Search for the next valid data block starting at the provided
- *   FLASH offset.
+ *   Search for the next valid data block (of any inode) starting at the
+ *   provided FLASH offset.  The search ends at the free FLASH region.
  *
  * Input Parameters:
- *   volume - Describes the NXFFS volume.
- *   datlen  - A memory location to return the data block length.
- *  
+ *   volume   - Describes the NXFFS volume.
+ *   offset   - The FLASH memory offset to begin searching.
+ *   blkentry - A memory location to return the data block description.
+ *
  * Returned Value:
  *   Zero is returned on success. Otherwise, a negated errno is returned
  *   that indicates the nature of the failure.
@@ -1009,7 +1161,7 @@ int nxffs_nextblock(FAR struct nxffs_volume_s *volume, off_t offset,
  *   volume - Describes the current volume.
  *   offset - The byte offset from the beginning of FLASH where the data block
  *     header is expected.
- *   datlen  - A memory location to return the data block length.
+ *   blkentry - A memory location to return the data block description.
  *
  * Returned Value:
  *   Zero on success.  Otherwise, a negated errno value is returned
@@ -1020,14 +1172,14 @@ int nxffs_nextblock(FAR struct nxffs_volume_s *volume, off_t offset,
  ****************************************************************************/
 
 int nxffs_rdblkhdr(FAR struct nxffs_volume_s *volume, off_t offset,
-                   FAR uint16_t *datlen);
+                   FAR struct nxffs_blkentry_s *blkentry);
 
 /****************************************************************************
  * Name: nxffs_rminode
  *
  * Description:
- *   Remove an inode from FLASH.  This is the internal implementation of
- *   the file system unlinke operation.
+ *   Remove an inode from FLASH (and from the inode index).  This is the
+ *   internal implementation of the file system unlink operation.
  *
  * Input Parameters:
  *   volume - Describes the NXFFS volume.
@@ -1059,6 +1211,49 @@ int nxffs_rminode(FAR struct nxffs_volume_s *volume, FAR const char *name);
 
 int nxffs_pack(FAR struct nxffs_volume_s *volume);
 
+/****************************************************************************
+ * Name: nxffs_packstep
+ *
+ * Description:
+ *   Perform one bounded step of incremental packing:  Relocate the live
+ *   objects in about 'neblocks' erase blocks following the first gap of
+ *   unused FLASH.  The gap is moved toward the end of the valid data and
+ *   the step that reaches the end of the valid data frees the FLASH.
+ *
+ * Input Parameters:
+ *   volume   - The volume to be packed.
+ *   neblocks - The maximum number of erase blocks to relocate.
+ *
+ * Returned Values:
+ *   One if something was packed, zero if there is nothing worth packing.
+ *   Otherwise, a negated errno value is returned to indicate the nature of
+ *   the failure.
+ *
+ ****************************************************************************/
+
+int nxffs_packstep(FAR struct nxffs_volume_s *volume, int neblocks);
+
+/****************************************************************************
+ * Name: nxffs_packsched
+ *
+ * Description:
+ *   (Re-)schedule background packing after the volume was modified.  The
+ *   volume exclsem must be held by the caller.
+ *
+ * Input Parameters:
+ *   volume - The volume that was modified.
+ *
+ * Returned Values:
+ *   None
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NXFFS_BGPACK
+void nxffs_packsched(FAR struct nxffs_volume_s *volume);
+#else
+#  define nxffs_packsched(v)
+#endif
+
 /****************************************************************************
  * Standard mountpoint operation methods
  *
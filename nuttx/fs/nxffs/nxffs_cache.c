@@ -261,6 +261,13 @@ int nxffs_getc(FAR struct nxffs_volume_s *volume, uint16_t reserve)
           fdbg("ERROR: Failed to read valid data into cache: %d\n", ret);
 #endif
         }
+
+      /* Force the skip to the next block if this block is not usable */
+
+      if (ret != OK)
+        {
+          volume->iooffset = volume->geo.blocksize;
+        }
     }
   while (ret != OK);
 
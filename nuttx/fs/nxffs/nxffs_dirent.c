@@ -132,7 +132,7 @@ int nxffs_readdir(FAR struct inode *mountpt, FAR struct fs_dirent_s *dir)
 {
   FAR struct nxffs_volume_s *volume;
   FAR struct nxffs_entry_s entry;
-  off_t offset;
+  size_t index;
   int ret;
 
   /* Sanity checks */
@@ -148,10 +148,17 @@ int nxffs_readdir(FAR struct inode *mountpt, FAR struct fs_dirent_s *dir)
       goto errout;
     }
 
-  /* Read the next inode header from the offset */
+  /* Find the next inode in the inode index at or after the offset and
+   * read its inode header.
+   */
 
-  offset = dir->u.nxffs.nx_offset;
-  ret = nxffs_nextentry(volume, offset, &entry);
+  ret = -ENOENT;
+  for (index = nxffs_findindex(volume, dir->u.nxffs.nx_offset);
+       index < volume->ninodes && ret != OK;
+       index++)
+    {
+      ret = nxffs_rdinode(volume, volume->index[index].hoffset, &entry);
+    }
 
   /* If the read was successful, then handle the reported inode.  Note
    * that when the last inode has been reported, the value -ENOENT will
@@ -168,7 +175,7 @@ int nxffs_readdir(FAR struct inode *mountpt, FAR struct fs_dirent_s *dir)
 
       /* Discard this entry and set the next offset. */
 
-      dir->u.nxffs.nx_offset = nxffs_inodeend(volume, &entry);
+      dir->u.nxffs.nx_offset = entry.hoffset + 1;
       nxffs_freeentry(&entry);
       ret = OK;
     }
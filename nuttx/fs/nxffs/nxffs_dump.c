@@ -243,19 +243,42 @@ static inline ssize_t nxffs_analyzedata(FAR struct nxffs_blkinfo_s *blkinfo,
                                         int offset)
 {
   struct nxffs_data_s dathdr;
+  FAR const char *type;
   uint32_t ecrc;
   uint16_t datlen;
   uint32_t crc;
+  int hdrlen;
+
+  /* Tagged data block headers are longer than the untagged headers written
+   * by older versions of NXFFS.
+   */
+
+  if (blkinfo->buffer[offset + NXFFS_MAGICSIZE - 1] ==
+      g_tagmagic[NXFFS_MAGICSIZE - 1])
+    {
+      hdrlen = SIZEOF_NXFFS_DATA_HDR;
+      type   = "DATA ";
+    }
+  else
+    {
+      hdrlen = SIZEOF_NXFFS_UNTAGGED_HDR;
+      type   = "UDATA";
+    }
+
+  if (offset + hdrlen > blkinfo->geo.blocksize)
+    {
+      return ERROR;
+    }
 
   /* Copy and unpack the data block header */
 
-  memcpy(&dathdr, &blkinfo->buffer[offset], SIZEOF_NXFFS_DATA_HDR);
+  memcpy(&dathdr, &blkinfo->buffer[offset], hdrlen);
   ecrc   = nxffs_rdle32(dathdr.crc);
   datlen = nxffs_rdle16(dathdr.datlen);
 
   /* Sanity checks */
 
-  if (offset + SIZEOF_NXFFS_DATA_HDR + datlen > blkinfo->geo.blocksize)
+  if (offset + hdrlen + datlen > blkinfo->geo.blocksize)
     {
       /* Data does not fit in within the block, this can't be a data block */
 
@@ -266,12 +289,12 @@ static inline ssize_t nxffs_analyzedata(FAR struct nxffs_blkinfo_s *blkinfo,
 
   nxffs_wrle32(dathdr.crc, 0);
 
-  crc = crc32((FAR const uint8_t *)&dathdr, SIZEOF_NXFFS_DATA_HDR);
-  crc = crc32part(&blkinfo->buffer[offset + SIZEOF_NXFFS_DATA_HDR], datlen, crc);
+  crc = crc32((FAR const uint8_t *)&dathdr, hdrlen);
+  crc = crc32part(&blkinfo->buffer[offset + hdrlen], datlen, crc);
 
   if (crc != ecrc)
    {
-      fdbg(g_format, blkinfo->block, offset, "DATA ", "CRC BAD", datlen);
+      fdbg(g_format, blkinfo->block, offset, type, "CRC BAD", datlen);
       return ERROR;
    }
 
@@ -279,10 +302,10 @@ static inline ssize_t nxffs_analyzedata(FAR struct nxffs_blkinfo_s *blkinfo,
 
   if (blkinfo->verbose)
     {
-      fdbg(g_format, blkinfo->block, offset, "DATA ", "OK     ", datlen);
+      fdbg(g_format, blkinfo->block, offset, type, "OK     ", datlen);
     }
 
-  return SIZEOF_NXFFS_DATA_HDR + datlen;
+  return hdrlen + datlen;
 }
 #endif
 
@@ -371,7 +394,7 @@ static inline void nxffs_analyze(FAR struct nxffs_blkinfo_s *blkinfo)
               inndx = 0;
             }
         }
-      else if (ch == g_datamagic[datndx])
+      else if (ch == g_datamagic[datndx] || ch == g_tagmagic[datndx])
         {
           datndx++;
           inndx = 0;
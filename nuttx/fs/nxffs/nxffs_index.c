@@ -0,0 +1,257 @@
+/****************************************************************************
+ * fs/nxffs/nxffs_index.c
+ *
+ *   Copyright (C) 2014 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * References: Linux/Documentation/filesystems/romfs.txt
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <string.h>
+#include <crc32.h>
+#include <assert.h>
+#include <errno.h>
+#include <debug.h>
+
+#include <nuttx/kmalloc.h>
+
+#include "nxffs.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+/****************************************************************************
+ * Public Variables
+ ****************************************************************************/
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nxffs_setinoffset
+ *
+ * Description:
+ *   Keep the offset to the first valid inode in step with the inode index.
+ *
+ ****************************************************************************/
+
+static inline void nxffs_setinoffset(FAR struct nxffs_volume_s *volume)
+{
+  volume->inoffset = volume->ninodes > 0 ? volume->index[0].hoffset :
+                     volume->froffset;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nxffs_hashname
+ *
+ * Description:
+ *   Return the hash of an inode name that is used in the inode index.
+ *
+ * Input Parameters:
+ *   name - The inode name.
+ *
+ * Returned Value:
+ *   The 32-bit hash value.
+ *
+ ****************************************************************************/
+
+uint32_t nxffs_hashname(FAR const char *name)
+{
+  return crc32((FAR const uint8_t *)name, strlen(name));
+}
+
+/****************************************************************************
+ * Name: nxffs_findindex
+ *
+ * Description:
+ *   Find the index of the first inode index entry whose inode header lies
+ *   at or after the provided FLASH offset.
+ *
+ * Input Parameters:
+ *   volume  - Describes the NXFFS volume
+ *   hoffset - The FLASH offset to search for.
+ *
+ * Returned Value:
+ *   The index of the entry.  volume->ninodes is returned if there is no
+ *   such entry.
+ *
+ ****************************************************************************/
+
+size_t nxffs_findindex(FAR struct nxffs_volume_s *volume, off_t hoffset)
+{
+  size_t low  = 0;
+  size_t high = volume->ninodes;
+  size_t mid;
+
+  /* Binary search of the sorted index */
+
+  while (low < high)
+    {
+      mid = (low + high) >> 1;
+      if (volume->index[mid].hoffset < hoffset)
+        {
+          low = mid + 1;
+        }
+      else
+        {
+          high = mid;
+        }
+    }
+
+  return low;
+}
+
+/****************************************************************************
+ * Name: nxffs_addindex
+ *
+ * Description:
+ *   Add a valid inode to the in-memory inode index.
+ *
+ * Input Parameters:
+ *   volume - Describes the NXFFS volume
+ *   entry  - Describes the inode.
+ *
+ * Returned Value:
+ *   Zero is returned on success. Otherwise, a negated errno is returned
+ *   that indicates the nature of the failure.
+ *
+ ****************************************************************************/
+
+int nxffs_addindex(FAR struct nxffs_volume_s *volume,
+                   FAR const struct nxffs_entry_s *entry)
+{
+  FAR struct nxffs_index_s *index;
+  size_t ndx;
+
+  /* Grow the index if it is full */
+
+  if (volume->ninodes >= volume->maxinodes)
+    {
+      size_t maxinodes = volume->maxinodes + NXFFS_INDEX_INCR;
+
+      index = (FAR struct nxffs_index_s *)
+        krealloc(volume->index, maxinodes * sizeof(struct nxffs_index_s));
+
+      if (!index)
+        {
+          fdbg("ERROR: Failed to grow the inode index: %d\n", maxinodes);
+          return -ENOMEM;
+        }
+
+      volume->index     = index;
+      volume->maxinodes = maxinodes;
+    }
+
+  /* Find the insertion point.  Inodes are usually added in order of
+   * increasing FLASH offset so this is normally the end of the index.
+   */
+
+  ndx = nxffs_findindex(volume, entry->hoffset);
+  if (ndx < volume->ninodes)
+    {
+      DEBUGASSERT(volume->index[ndx].hoffset != entry->hoffset);
+      memmove(&volume->index[ndx + 1], &volume->index[ndx],
+              (volume->ninodes - ndx) * sizeof(struct nxffs_index_s));
+    }
+
+  index          = &volume->index[ndx];
+  index->hoffset = entry->hoffset;
+  index->doffset = entry->doffset;
+  index->hash    = nxffs_hashname(entry->name);
+
+  volume->ninodes++;
+  nxffs_setinoffset(volume);
+  return OK;
+}
+
+/****************************************************************************
+ * Name: nxffs_rmindex
+ *
+ * Description:
+ *   Remove the inode at the provided FLASH offset from the inode index.
+ *
+ * Input Parameters:
+ *   volume  - Describes the NXFFS volume
+ *   hoffset - The FLASH offset to the inode header.
+ *
+ * Returned Value:
+ *   None.
+ *
+ ****************************************************************************/
+
+void nxffs_rmindex(FAR struct nxffs_volume_s *volume, off_t hoffset)
+{
+  size_t ndx;
+
+  ndx = nxffs_findindex(volume, hoffset);
+  if (ndx < volume->ninodes && volume->index[ndx].hoffset == hoffset)
+    {
+      volume->ninodes--;
+      memmove(&volume->index[ndx], &volume->index[ndx + 1],
+              (volume->ninodes - ndx) * sizeof(struct nxffs_index_s));
+      nxffs_setinoffset(volume);
+    }
+}
+
+/****************************************************************************
+ * Name: nxffs_clrindex
+ *
+ * Description:
+ *   Discard all entries in the inode index.
+ *
+ * Input Parameters:
+ *   volume - Describes the NXFFS volume
+ *
+ * Returned Value:
+ *   None.
+ *
+ ****************************************************************************/
+
+void nxffs_clrindex(FAR struct nxffs_volume_s *volume)
+{
+  volume->ninodes = 0;
+}
@@ -42,6 +42,7 @@
 #include <nuttx/config.h>
 
 #include <string.h>
+#include <sched.h>
 #include <errno.h>
 #include <assert.h>
 #include <debug.h>
@@ -69,6 +70,12 @@
  * Private Variables
  ****************************************************************************/
 
+/* This is the list of all NXFFS volumes in the order that they were
+ * initialized.
+ */
+
+static FAR struct nxffs_volume_s *g_volumes;
+
 /* See fs_mount.c -- this structure is explicitly externed there.
  * We use the old-fashioned kind of initializers so that this will compile
  * with any compiler.
@@ -122,18 +129,39 @@ const uint8_t g_inodemagic[NXFFS_MAGICSIZE] = { 'I', 'n', 'o', 'd' };
 
 const uint8_t g_datamagic[NXFFS_MAGICSIZE] = { 'D', 'a', 't', 'a' };
 
-/* If CONFIG_NXFFS_PREALLOCATED is defined, then this is the single, pre-
- * allocated NXFFS volume instance.
+/* The magic number that appears that the beginning of each NXFFS inode
+ * data block that is tagged with the offset of its inode header.
  */
 
-#ifdef CONFIG_NXFFS_PREALLOCATED
-struct nxffs_volume_s g_volume;
-#endif
+const uint8_t g_tagmagic[NXFFS_MAGICSIZE] = { 'D', 'a', 't', 'T' };
 
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: nxffs_addvolume
+ *
+ * Description:
+ *   Add a new volume to the end of the list of volumes.  It will be bound
+ *   to a mountpoint after all earlier volumes have been bound.
+ *
+ ****************************************************************************/
+
+static void nxffs_addvolume(FAR struct nxffs_volume_s *volume)
+{
+  FAR struct nxffs_volume_s **pprev = &g_volumes;
+
+  sched_lock();
+  while (*pprev)
+    {
+      pprev = &(*pprev)->flink;
+    }
+
+  *pprev = volume;
+  sched_unlock();
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -162,17 +190,6 @@ int nxffs_initialize(FAR struct mtd_dev_s *mtd)
 #endif
   int ret;
 
-  /* If CONFIG_NXFFS_PREALLOCATED is defined, then this is the single, pre-
-   * allocated NXFFS volume instance.
-   */
-
-#ifdef CONFIG_NXFFS_PREALLOCATED
-
-  volume = &g_volume;
-  memset(volume, 0, sizeof(struct nxffs_volume_s));
-
-#else
-
   /* Allocate a NXFFS volume structure */
 
   volume = (FAR struct nxffs_volume_s *)kzalloc(sizeof(struct nxffs_volume_s));
@@ -180,14 +197,12 @@ int nxffs_initialize(FAR struct mtd_dev_s *mtd)
     {
       return -ENOMEM;
     }
-#endif
 
   /* Initialize the NXFFS volume structure */
 
   volume->mtd    = mtd;
   volume->cblock = (off_t)-1;
   sem_init(&volume->exclsem, 0, 1);
-  sem_init(&volume->wrsem, 0, 1);
 
   /* Get the volume geometry. (casting to uintptr_t first eliminates
    * complaints on some architectures where the sizeof long is different
@@ -276,6 +291,7 @@ int nxffs_initialize(FAR struct mtd_dev_s *mtd)
   ret = nxffs_limits(volume);
   if (ret == OK)
     {
+      nxffs_addvolume(volume);
       return OK;
     }
 
@@ -305,6 +321,7 @@ int nxffs_initialize(FAR struct mtd_dev_s *mtd)
   ret = nxffs_limits(volume);
   if (ret == OK)
     {
+      nxffs_addvolume(volume);
       return OK;
     }
 
@@ -313,13 +330,16 @@ int nxffs_initialize(FAR struct mtd_dev_s *mtd)
   fdbg("ERROR: Failed to calculate file system limits: %d\n", -ret);
 
 errout_with_buffer:
+  if (volume->index)
+    {
+      kfree(volume->index);
+    }
+
   kfree(volume->pack);
 errout_with_cache:
   kfree(volume->cache);
 errout_with_volume:
-#ifndef CONFIG_NXFFS_PREALLOCATED
   kfree(volume);
-#endif
   return ret;
 }
 
@@ -350,13 +370,16 @@ errout_with_volume:
 
 int nxffs_limits(FAR struct nxffs_volume_s *volume)
 {
-  FAR struct nxffs_entry_s entry;
+  struct nxffs_object_s object;
   off_t block;
   off_t offset;
-  bool noinodes = false;
-  int nerased;
+  off_t end;
   int ret;
 
+  /* Discard the old inode index */
+
+  nxffs_clrindex(volume);
+
   /* Get the offset to the first valid block on the FLASH */
 
   block = 0;
@@ -367,133 +390,69 @@ int nxffs_limits(FAR struct nxffs_volume_s *volume)
       return ret;
     }
 
-  /* Then find the first valid inode in or beyond the first valid block */
+  /* Then walk every object in the valid FLASH region, adding each valid
+   * inode to the inode index.
+   */
 
   offset = block * volume->geo.blocksize;
-  ret = nxffs_nextentry(volume, offset, &entry);
-  if (ret < 0)
-    {
-      /* The value -ENOENT is special.  This simply means that the FLASH
-       * was searched to the end and no valid inode was found... the file
-       * system is empty (or, in more perverse cases, all inodes are
-       * deleted or corrupted).
-       */
+  end    = volume->nblocks * volume->geo.blocksize;
 
-      if (ret != -ENOENT)
-        {
-          fdbg("ERROR: nxffs_nextentry failed: %d\n", -ret);
-          return ret;
-        }
-
-      /* Set a flag the just indicates that no inodes were found.  Later,
-       * we will set the location of the first inode to be the same as
-       * the location of the free FLASH region.
-       */
-
-      fvdbg("No inodes found\n");
-      noinodes = true;
-    }
-  else
+  while ((ret = nxffs_nextobject(volume, offset, end, &object)) == OK)
     {
-      /* Save the offset to the first inode */
-
-      volume->inoffset = entry.hoffset;
-      fvdbg("First inode at offset %d\n", volume->inoffset);
-
-      /* Discard this entry and set the next offset. */
-
-      offset = nxffs_inodeend(volume, &entry);
-      nxffs_freeentry(&entry);
-    }
+      if (object.type == NXFFS_OBJ_INODE)
+        {
+          fvdbg("Inode at offset %d\n", object.entry.hoffset);
 
-  /* Now, search for the last valid entry */
+          ret = nxffs_addindex(volume, &object.entry);
+          if (ret < 0)
+            {
+              nxffs_freeentry(&object.entry);
+              return ret;
+            }
+        }
 
-  if (!noinodes)
-    {
-      while ((ret = nxffs_nextentry(volume, offset, &entry)) == OK)
+      if (object.type != NXFFS_OBJ_DATA)
         {
-          /* Discard the entry and guess the next offset. */
-
-          offset = nxffs_inodeend(volume, &entry);
-          nxffs_freeentry(&entry);
+          nxffs_freeentry(&object.entry);
         }
 
-      fvdbg("Last inode before offset %d\n", offset);
+      offset = object.next;
     }
 
-  /* No inodes were found after this offset.  Now search for a block of
-   * erased flash.
+  /* The value -ENOENT is special.  This simply means that the end of the
+   * valid data was found.  The value -ENOSPC means that there is no free
+   * FLASH left at all.
    */
 
-  nxffs_ioseek(volume, offset);
-  nerased = 0;
-  for (;;)
+  if (ret == -ENOSPC)
     {
-      int ch = nxffs_getc(volume, 1);
-      if (ch < 0)
-        {
-          /* Failed to read the next byte... this could mean that the FLASH
-           * is full?
-           */
-
-          if (volume->ioblock + 1 >= volume->nblocks &&
-              volume->iooffset + 1 >= volume->geo.blocksize)
-            {
-              /* Yes.. the FLASH is full.  Force the offsets to the end of FLASH */
-
-              volume->froffset = volume->nblocks * volume->geo.blocksize;
-              fvdbg("Assume no free FLASH, froffset: %d\n", volume->froffset);
-              if (noinodes)
-                {
-                  volume->inoffset = volume->froffset;
-                  fvdbg("No inodes, inoffset: %d\n", volume->inoffset);
-                }
-
-              return OK;
-            }
-
-          /* No?  Then it is some other failure that we do not know how to handle */
+      /* Yes.. the FLASH is full.  Force the offsets to the end of FLASH */
 
-          fdbg("ERROR: nxffs_getc failed: %d\n", -ch);
-          return ch;
-        }
-
-      /* Check for another erased byte */
-
-      else if (ch == CONFIG_NXFFS_ERASEDSTATE)
-        {
-          /* If we have encountered NXFFS_NERASED number of consecutive
-           * erased bytes, then presume we have reached the end of valid
-           * data.
-           */
+      volume->froffset = end;
+      fvdbg("Assume no free FLASH, froffset: %d\n", volume->froffset);
+    }
+  else if (ret == -ENOENT)
+    {
+      /* Okay.. we have a long stretch of erased FLASH in a valid
+       * FLASH block.  Let's say that this is the beginning of
+       * the free FLASH region.
+       */
 
-          if (++nerased >= NXFFS_NERASED)
-            {
-              /* Okay.. we have a long stretch of erased FLASH in a valid
-               * FLASH block.  Let's say that this is the beginning of
-               * the free FLASH region.
-               */
-
-              volume->froffset = offset;
-              fvdbg("Free FLASH region begins at offset: %d\n", volume->froffset);
-              if (noinodes)
-                {
-                  volume->inoffset = offset;
-                  fvdbg("First inode at offset %d\n", volume->inoffset);
-                }
-
-              return OK;
-            }
-        }
-      else
-        {
-          offset += nerased + 1;
-          nerased = 0;
-        }
+      volume->froffset = nxffs_iotell(volume);
+      fvdbg("Free FLASH region begins at offset: %d\n", volume->froffset);
+    }
+  else
+    {
+      fdbg("ERROR: nxffs_nextobject failed: %d\n", -ret);
+      return ret;
     }
 
-  /* Won't get here */
+  /* The first inode is the first entry in the index */
 
+  volume->inoffset = volume->ninodes > 0 ? volume->index[0].hoffset :
+                     volume->froffset;
+  fvdbg("%d inodes, first inode at offset %d\n",
+        volume->ninodes, volume->inoffset);
   return OK;
 }
 
@@ -519,26 +478,36 @@ int nxffs_limits(FAR struct nxffs_volume_s *volume)
  *      mount operations have been bypassed and now we just need to provide
  *      the pre-allocated volume instance.
  *
- *   3. The tricky thing is that there is no mechanism to associate multiple
- *      NXFFS volumes to the multiple volumes bound to different MTD drivers.
- *      Hence, the limitation of a single NXFFS volume.
+ *   3. There is no mechanism to associate a mountpoint with a specific
+ *      MTD driver.  Instead, each call to nxffs_initialize() creates a new
+ *      volume and the volumes are bound to mountpoints in the order in
+ *      which they were initialized:  The first volume that is not already
+ *      mounted is returned.
  *
  ****************************************************************************/
 
 int nxffs_bind(FAR struct inode *blkdriver, FAR const void *data,
                FAR void **handle)
 {
-#ifndef CONFIG_NXFFS_PREALLOCATED
-#  error "No design to support dynamic allocation of volumes"
-#else
+  FAR struct nxffs_volume_s *volume;
 
-  /* If CONFIG_NXFFS_PREALLOCATED is defined, then this is the single, pre-
-   * allocated NXFFS volume instance.
-   */
+  /* Find the first volume that is not already mounted */
 
-  DEBUGASSERT(g_volume.cache);
-  *handle = &g_volume;
-#endif
+  sched_lock();
+  for (volume = g_volumes; volume && volume->mounted; volume = volume->flink);
+
+  if (!volume)
+    {
+      sched_unlock();
+      fdbg("ERROR: No unmounted NXFFS volume\n");
+      return -ENODEV;
+    }
+
+  DEBUGASSERT(volume->cache);
+  volume->mounted = true;
+  sched_unlock();
+
+  *handle = volume;
   return OK;
 }
 
@@ -552,9 +521,22 @@ int nxffs_bind(FAR struct inode *blkdriver, FAR const void *data,
 
 int nxffs_unbind(FAR void *handle, FAR struct inode **blkdriver)
 {
-#ifndef CONFIG_NXFFS_PREALLOCATED
-#  error "No design to support dynamic allocation of volumes"
-#else
-  return g_volume.ofiles ? -EBUSY : OK;
+  FAR struct nxffs_volume_s *volume = (FAR struct nxffs_volume_s *)handle;
+
+  DEBUGASSERT(volume);
+  if (volume->ofiles)
+    {
+      return -EBUSY;
+    }
+
+#ifdef CONFIG_NXFFS_BGPACK
+  /* Background packing only runs on mounted volumes */
+
+  (void)work_cancel(LPWORK, &volume->work);
 #endif
+
+  /* The volume is still bound to its MTD driver and may be mounted again */
+
+  volume->mounted = false;
+  return OK;
 }
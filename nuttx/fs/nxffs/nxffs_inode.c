@@ -72,7 +72,8 @@
  * Name: nxffs_rdentry
  *
  * Description:
- *   Read the inode entry at this offset.  Called only from nxffs_nextentry().
+ *   Read the inode entry at this offset.  The block containing the inode
+ *   header must already be in the volume cache.
  *
  * Input Parameters:
  *   volume - Describes the current volume.
@@ -80,6 +81,8 @@
  *     header is expected.
  *   entry  - A memory location to return the expanded inode header
  *     information.
+ *   state  - A memory location to return the inode state.  Deleted inodes
+ *     are also returned successfully (the CRC is still valid).
  *
  * Returned Value:
  *   Zero on success.  Otherwise, a negated errno value is returned
@@ -88,12 +91,12 @@
  ****************************************************************************/
 
 static int nxffs_rdentry(FAR struct nxffs_volume_s *volume, off_t offset,
-                         FAR struct nxffs_entry_s *entry)
+                         FAR struct nxffs_entry_s *entry,
+                         FAR uint8_t *state)
 {
   struct nxffs_inode_s inode;
   uint32_t ecrc;
   uint32_t crc;
-  uint8_t state;
   int namlen;
   int ret;
 
@@ -107,8 +110,8 @@ static int nxffs_rdentry(FAR struct nxffs_volume_s *volume, off_t offset,
 
   /* Check if the file state is recognized. */
 
-  state = inode.state;
-  if (state != INODE_STATE_FILE && state != INODE_STATE_DELETED)
+  *state = inode.state;
+  if (*state != INODE_STATE_FILE && *state != INODE_STATE_DELETED)
     {
       /* This can't be a valid inode.. don't bother with the rest */
 
@@ -172,27 +175,11 @@ static int nxffs_rdentry(FAR struct nxffs_volume_s *volume, off_t offset,
       goto errout_with_name;
     }
 
-  /* We have a good inode header.. but it still could a deleted file.
-   * Check the file state.
-   */
-
-  if (state != INODE_STATE_FILE)
-    {
-      /* It is a deleted file.  But still, the data offset and the
-       * start size are good so we can use this information to advance
-       * further in FLASH memory and reduce the search time.
-       */
-
-      offset = nxffs_inodeend(volume, entry);
-      nxffs_freeentry(entry);
-      ret = -ENOENT;
-      goto errout;
-    }
-
-  /* Everything is good.. leave the offset pointing to the valid inode
-   * header.
+  /* We have a good inode header (but it still could a deleted file).
+   * Leave the offset pointing to the end of the inode name.
    */
 
+  nxffs_ioseek(volume, entry->noffset + namlen);
   return OK;
 
   /* On errors where we are suspicious of the validity of the inode header,
@@ -203,9 +190,7 @@ static int nxffs_rdentry(FAR struct nxffs_volume_s *volume, off_t offset,
 errout_with_name:
   nxffs_freeentry(entry);
 errout_no_offset:
-  offset += NXFFS_MAGICSIZE;
-errout:
-  nxffs_ioseek(volume, offset);
+  nxffs_ioseek(volume, offset + NXFFS_MAGICSIZE);
   return ret;
 }
 
@@ -217,7 +202,7 @@ errout:
  * Name: nxffs_freeentry
  *
  * Description:
- *   The inode values returned by nxffs_nextentry() include allocated memory
+ *   The inode values returned by nxffs_nextobject() include allocated memory
  *   (specifically, the file name string).  This function should be called
  *   to dispose of that memory when the inode entry is no longer needed.
  *
@@ -243,135 +228,282 @@ void nxffs_freeentry(FAR struct nxffs_entry_s *entry)
 }
 
 /****************************************************************************
- * Name: nxffs_nextentry
+ * Name: nxffs_rdinode
  *
  * Description:
- *   Search for the next valid inode starting at the provided FLASH offset.
+ *   Read and verify the inode header at a known FLASH offset.
  *
  * Input Parameters:
  *   volume - Describes the NXFFS volume.
- *   offset - The FLASH memory offset to begin searching.
+ *   offset - The FLASH offset to the inode header.
  *   entry  - A pointer to memory provided by the caller in which to return
  *     the inode description.
  *
  * Returned Value:
  *   Zero is returned on success. Otherwise, a negated errno is returned
- *   that indicates the nature of the failure.
+ *   that indicates the nature of the failure.  -ENOENT means that the
+ *   inode header is valid but has been deleted.
  *
  ****************************************************************************/
 
-int nxffs_nextentry(FAR struct nxffs_volume_s *volume, off_t offset,
-                    FAR struct nxffs_entry_s *entry)
+int nxffs_rdinode(FAR struct nxffs_volume_s *volume, off_t offset,
+                  FAR struct nxffs_entry_s *entry)
 {
-  int nmagic;
-  int ch;
-  int nerased;
+  uint8_t state;
+  int ret;
+
+  /* Make sure that the block containing the inode header is in the cache */
+
+  nxffs_ioseek(volume, offset);
+  if (volume->iooffset + SIZEOF_NXFFS_INODE_HDR > volume->geo.blocksize)
+    {
+      return -EIO;
+    }
+
+  ret = nxffs_rdcache(volume, volume->ioblock);
+  if (ret < 0)
+    {
+      fdbg("ERROR: Failed to read block %d: %d\n", volume->ioblock, -ret);
+      return ret;
+    }
+
+  /* Check for the inode magic number */
+
+  if (memcmp(&volume->cache[volume->iooffset], g_inodemagic,
+             NXFFS_MAGICSIZE) != 0)
+    {
+      fdbg("ERROR: No inode header at offset %d\n", offset);
+      return -EIO;
+    }
+
+  /* Then read and verify the inode header */
+
+  ret = nxffs_rdentry(volume, offset, entry, &state);
+  if (ret == OK && state != INODE_STATE_FILE)
+    {
+      nxffs_freeentry(entry);
+      ret = -ENOENT;
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: nxffs_nextobject
+ *
+ * Description:
+ *   Search for the next valid inode header or data block starting at the
+ *   provided FLASH offset.  Deleted inode headers are also reported and
+ *   data blocks are parsed and skipped exactly, so that the FLASH content
+ *   can be walked object-by-object.
+ *
+ *   Because several files may be written at the same time, the unused
+ *   remainder of a logical block may lie in the middle of the valid FLASH
+ *   region.  But every logical block in the valid FLASH region begins with
+ *   an inode header (possibly not yet written, but followed by the name) or
+ *   a data block header.  So a long run of erased bytes is only taken to be
+ *   the end of the valid data if it extends NXFFS_NERASED bytes from the
+ *   beginning of the data in a logical block (or to the end of FLASH).
+ *
+ * Input Parameters:
+ *   volume - Describes the NXFFS volume.
+ *   offset - The FLASH memory offset to begin searching.
+ *   end    - Stop searching at this FLASH offset.
+ *   object - A pointer to memory provided by the caller in which to return
+ *     the object description.  For inode headers, object->entry holds an
+ *     allocated name that must be freed with nxffs_freeentry().
+ *
+ * Returned Value:
+ *   Zero is returned on success. Otherwise, a negated errno is returned
+ *   that indicates the nature of the failure.  -ENOENT is returned if the
+ *   end of the valid data was reached.  In that case, volume->ioblock and
+ *   volume->iooffset refer to the first byte of the erased region.
+ *   -ENOSPC is returned if the valid data extends to the end of FLASH.
+ *
+ ****************************************************************************/
+
+int nxffs_nextobject(FAR struct nxffs_volume_s *volume, off_t offset,
+                     off_t end, FAR struct nxffs_object_s *object)
+{
+  FAR const uint8_t *ptr;
+  off_t erased;
+  off_t dstart;
+  uint8_t state;
   int ret;
 
   /* Seek to the first FLASH offset provided by the caller. */
 
   nxffs_ioseek(volume, offset);
 
-  /* Then begin searching */
+  /* Then begin searching.  'erased' is the FLASH offset to the beginning
+   * of the current run of erased bytes and 'dstart' is the FLASH offset to
+   * the beginning of the data in the logical block where that run reached
+   * (if it did).
+   */
+
+  erased = -1;
+  dstart = -1;
 
-  nerased = 0;
-  nmagic  = 0;
   for (;;)
     {
-      /* Read the next character */
+      /* Skip the block header */
 
-      ch = nxffs_getc(volume, SIZEOF_NXFFS_INODE_HDR - nmagic);
-      if (ch < 0)
+      if (volume->iooffset < SIZEOF_NXFFS_BLOCK_HDR)
         {
-          fdbg("ERROR: nxffs_getc failed: %d\n", -ch);
-          return ch;
+          volume->iooffset = SIZEOF_NXFFS_BLOCK_HDR;
         }
 
-      /* Check for another erased byte */
+      /* Skip to the next block if there is no room left for any object */
 
-      else if (ch == CONFIG_NXFFS_ERASEDSTATE)
+      if (volume->iooffset + SIZEOF_NXFFS_UNTAGGED_HDR > volume->geo.blocksize)
         {
-          /* If we have encountered NXFFS_NERASED number of consecutive
-           * erased bytes, then presume we have reached the end of valid
-           * data.
+          /* A logical block that is erased from the beginning of its data
+           * to the end (possible with very small blocks) also ends the
+           * valid data.
            */
 
-          if (++nerased >= NXFFS_NERASED)
+          if (dstart >= 0)
             {
-              fvdbg("No entry found\n");
+              fvdbg("End of valid data at offset %d\n", erased);
+              nxffs_ioseek(volume, erased);
               return -ENOENT;
             }
+
+          volume->ioblock++;
+          volume->iooffset = SIZEOF_NXFFS_BLOCK_HDR;
         }
-      else
+
+      /* Check for the end of the search */
+
+      offset = nxffs_iotell(volume);
+      if (offset >= end || volume->ioblock >= volume->nblocks)
         {
-          nerased = 0;
+          /* An erased run at the end of FLASH is free FLASH memory */
 
-          /* Check for the magic sequence indicating the start of an NXFFS
-           * inode. There is the possibility of this magic sequnce occurring
-           * in FLASH data.  However, the header CRC should distinguish
-           * between real NXFFS inode headers and such false alarms.
-           */
+          if (erased >= 0)
+            {
+              nxffs_ioseek(volume, erased);
+              return -ENOENT;
+            }
+
+          nxffs_ioseek(volume, MIN(end, volume->nblocks * volume->geo.blocksize));
+          return offset >= end ? -ENOENT : -ENOSPC;
+        }
+
+      /* Make sure that the block is in the cache and that it is a good
+       * block.  Skip over bad blocks.
+       */
 
-          if (ch != g_inodemagic[nmagic])
+      ret = nxffs_verifyblock(volume, volume->ioblock);
+      if (ret < 0)
+        {
+#ifndef CONFIG_NXFFS_NAND
+          if (ret != -ENOENT && ret != -EINVAL)
             {
-              /* Ooops... this is the not the right character for the magic
-               * Sequence.  Check if we need to restart or to cancel the sequence:
-               */
+              /* Read errors are fatal */
 
-              if (ch == g_inodemagic[0])
-                {
-                  nmagic = 1;
-                }
-              else
-                {
-                  nmagic = 0;
-                }
+              fdbg("ERROR: Failed to read block %d: %d\n",
+                   volume->ioblock, -ret);
+              return ret;
             }
-          else if (nmagic < NXFFS_MAGICSIZE - 1)
+#endif
+          volume->iooffset = volume->geo.blocksize;
+          continue;
+        }
+
+      /* Check for another erased byte */
+
+      ptr = &volume->cache[volume->iooffset];
+      if (*ptr == CONFIG_NXFFS_ERASEDSTATE)
+        {
+          if (erased < 0)
             {
-              /* We have one more character in the magic sequence */
+              erased = offset;
+            }
 
-              nmagic++;
+          if (volume->iooffset == SIZEOF_NXFFS_BLOCK_HDR)
+            {
+              dstart = offset;
             }
 
-          /* We have found the magic sequence in the FLASH data that may
-           * indicate the beginning of an NXFFS inode.
+          /* If we have encountered NXFFS_NERASED number of consecutive
+           * erased bytes at the beginning of a logical block, then presume
+           * we have reached the end of valid data.
            */
 
-          else
+          if (dstart >= 0 && offset - dstart >= NXFFS_NERASED)
             {
-              /* The the FLASH offset where we found the matching magic number */
+              fvdbg("End of valid data at offset %d\n", erased);
+              nxffs_ioseek(volume, erased);
+              return -ENOENT;
+            }
 
-              offset = nxffs_iotell(volume) - NXFFS_MAGICSIZE;
+          volume->iooffset++;
+          continue;
+        }
 
-              /* Try to extract the inode header from that position */
+      erased = -1;
+      dstart = -1;
 
-              ret = nxffs_rdentry(volume, offset, entry);
-              if (ret == OK)
+      /* Check for the magic sequence indicating the start of an NXFFS
+       * inode.  The header CRC should distinguish between real NXFFS
+       * inode headers and false alarms in the file data.
+       */
+
+      if (volume->iooffset + SIZEOF_NXFFS_INODE_HDR <= volume->geo.blocksize &&
+          memcmp(ptr, g_inodemagic, NXFFS_MAGICSIZE) == 0)
+        {
+          ret = nxffs_rdentry(volume, offset, &object->entry, &state);
+          if (ret == OK)
+            {
+              object->type = state == INODE_STATE_FILE ?
+                             NXFFS_OBJ_INODE : NXFFS_OBJ_DELETED;
+              object->next = nxffs_iotell(volume);
+              if (object->next > offset)
                 {
-                  fvdbg("Found a valid fileheader, offset: %d\n", offset);
                   return OK;
                 }
 
-              /* False alarm.. keep looking */
+              nxffs_freeentry(&object->entry);
+              nxffs_ioseek(volume, offset + NXFFS_MAGICSIZE);
+            }
 
-              nmagic = 0;
+          continue;
+        }
+
+      /* Check for the magic sequence indicating the start of an NXFFS
+       * data block (either tagged or untagged).
+       */
+
+      if (memcmp(ptr, g_datamagic, NXFFS_MAGICSIZE - 1) == 0 &&
+          (ptr[NXFFS_MAGICSIZE - 1] == g_datamagic[NXFFS_MAGICSIZE - 1] ||
+           ptr[NXFFS_MAGICSIZE - 1] == g_tagmagic[NXFFS_MAGICSIZE - 1]))
+        {
+          ret = nxffs_rdblkhdr(volume, offset, &object->blkentry);
+          if (ret == OK)
+            {
+              object->type = NXFFS_OBJ_DATA;
+              object->next = offset + object->blkentry.hdrlen +
+                             object->blkentry.datlen;
+              return OK;
             }
+
+          nxffs_ioseek(volume, offset + NXFFS_MAGICSIZE);
+          continue;
         }
-    }
 
-  /* We won't get here, but to keep some compilers happy: */
+      /* Not the beginning of any object.. keep looking */
 
-  return -ENOENT;
+      volume->iooffset++;
+    }
 }
 
 /****************************************************************************
  * Name: nxffs_findinode
  *
  * Description:
- *   Search for an inode with the provided name starting with the first
- *   valid inode and proceeding to the end FLASH or until the matching
- *   inode is found.
+ *   Search the in-memory inode index for an inode with the provided name.
+ *   Only the inode headers with a matching name hash are read from FLASH.
  *
  * Input Parameters:
  *   volume - Describes the NXFFS volume
@@ -387,112 +519,44 @@ int nxffs_nextentry(FAR struct nxffs_volume_s *volume, off_t offset,
 int nxffs_findinode(FAR struct nxffs_volume_s *volume, FAR const char *name,
                     FAR struct nxffs_entry_s *entry)
 {
-  off_t offset;
+  uint32_t hash;
+  size_t ndx;
   int ret;
 
-  /* Start with the first valid inode that was discovered when the volume
-   * was created (or modified after the last file system re-packing).
-   */
-
-  offset = volume->inoffset;
+  /* Check each inode in the index with a matching name hash */
 
-  /* Loop, checking each NXFFS inode until either: (1) we find the NXFFS inode
-   * with the matching name, or (2) we reach the end of data written on the
-   * media.
-   */
+  hash = nxffs_hashname(name);
+  for (ndx = 0; ndx < volume->ninodes; ndx++)
+    {
+      if (volume->index[ndx].hash != hash)
+        {
+          continue;
+        }
 
-  for (;;)
-   {
-      /* Get the next, valid NXFFS inode entry */
+      /* Read the candidate inode header */
 
-      ret = nxffs_nextentry(volume, offset, entry);
+      ret = nxffs_rdinode(volume, volume->index[ndx].hoffset, entry);
       if (ret < 0)
         {
-          fvdbg("No inode found: %d\n", -ret);
-          return ret;
+          fdbg("ERROR: Bad inode at offset %d: %d\n",
+               volume->index[ndx].hoffset, -ret);
+          continue;
         }
 
       /* Is this the NXFFS inode we are looking for? */
 
-      else if (strcmp(name, entry->name) == 0)
+      if (strcmp(name, entry->name) == 0)
         {
           /* Yes, return success with the entry data in 'entry' */
 
           return OK;
         }
 
-      /* Discard this entry and try the next one.  Here we set the
-       * next offset using the raw data length as the offset
-       * increment.  This is, of course, not accurate because it
-       * does not account for the data headers that enclose the
-       * data.  But it is guaranteed to be less than or equal to
-       * the correct offset and, hence, better then searching
-       * byte-for-byte.
-       */
+      /* No.. a hash collision.  Discard this entry and try the next one. */
 
-      offset = nxffs_inodeend(volume, entry);
       nxffs_freeentry(entry);
     }
 
-  /* We won't get here, but for some compilers: */
-
+  fvdbg("No inode found: %s\n", name);
   return -ENOENT;
 }
-
-/****************************************************************************
- * Name: nxffs_inodeend
- *
- * Description:
- *   Return an *approximiate* FLASH offset to end of the inode data.  The
- *   returned value is guaranteed to be be less then or equal to the offset
- *   of the thing-of-interest in FLASH.  Parsing for interesting things
- *   can begin at that point.
- *
- *   Assumption:  The inode header has been verified by the caller and is
- *   known to contain valid data.
- *
- * Input Parameters:
- *   volume - Describes the NXFFS volume
- *   entry  - Describes the inode.
- *
- * Returned Value:
- *   A FLASH offset to the (approximate) end of the inode data.  No errors
- *   are detected.
- *
- ****************************************************************************/
-
-off_t nxffs_inodeend(FAR struct nxffs_volume_s *volume,
-                     FAR struct nxffs_entry_s *entry)
-{
-  /* A zero length file will have no data blocks */
-
-  if (entry->doffset)
-    {
-      /* This is the maximum size of one data block.  It is the physcal size
-       * of the block minus the minimum number of headers: block sna data
-       */
-
-      uint16_t maxsize = volume->geo.blocksize - SIZEOF_NXFFS_BLOCK_HDR - SIZEOF_NXFFS_DATA_HDR;
-
-      /* This is the minimum number of blocks require to span all of the
-       * inode data.  One additional block could possibly be required -- we
-       * could make this accurate by looking at the size of the first, perhaps
-       * partial, data block.
-       */
-
-      off_t minblocks = (entry->datlen + maxsize - 1) / maxsize;
-
-      /* And this is our best, simple guess at the end of the inode data */
-
-      return entry->doffset + entry->datlen + minblocks * SIZEOF_NXFFS_DATA_HDR;
-    }
-
-  /* Otherwise, return an offset that accounts only for the inode header and
-   * the inode name.
-   */
-
-  /* All valid inodes will have a name associated with them */
-
-  DEBUGASSERT(entry->noffset);
-  return entry->noffset + strlen(entry->name);
-}
@@ -108,7 +108,7 @@ int nxffs_ioctl(FAR struct file *filep, int cmd, unsigned long arg)
       goto errout;
     }
 
-  /* Only a reformat and optimize commands are supported */
+  /* Only the reformat, optimize and packing commands are supported */
 
   if (cmd == FIOC_REFORMAT)
     {
@@ -126,6 +126,12 @@ int nxffs_ioctl(FAR struct file *filep, int cmd, unsigned long arg)
       /* Re-format the volume -- all is lost */
 
       ret = nxffs_reformat(volume);
+      if (ret == OK)
+        {
+          /* Then recalculate the (now empty) limits and inode index */
+
+          ret = nxffs_limits(volume);
+        }
     }
 
   else if (cmd == FIOC_OPTIMIZE)
@@ -136,6 +142,34 @@ int nxffs_ioctl(FAR struct file *filep, int cmd, unsigned long arg)
 
       ret = nxffs_pack(volume);
     }
+
+  else if (cmd == FIOC_PACKSTEP)
+    {
+      fvdbg("Pack step command\n");
+
+      /* Relocate no more than the requested number of erase blocks */
+
+      ret = nxffs_packstep(volume, arg > 0 ? (int)arg : CONFIG_NXFFS_PACKSTEP);
+    }
+
+  else if (cmd == FIOC_PACKSTATS)
+    {
+      FAR struct nxffs_packstats_s *stats =
+        (FAR struct nxffs_packstats_s *)((uintptr_t)arg);
+
+      fvdbg("Pack statistics command\n");
+
+      if (!stats)
+        {
+          ret = -EINVAL;
+          goto errout_with_semaphore;
+        }
+
+      memcpy(stats, &volume->stats, sizeof(struct nxffs_packstats_s));
+      stats->ps_size     = volume->nblocks * volume->geo.blocksize;
+      stats->ps_froffset = volume->froffset;
+      ret = OK;
+    }
   else
     {
       /* No other commands supported */
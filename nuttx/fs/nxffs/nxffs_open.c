@@ -67,14 +67,6 @@
  * Private Data
  ****************************************************************************/
 
-/* Since we are limited to a single file opened for writing, it makes sense
- * to pre-allocate the write state structure.
- */
-
-#ifdef CONFIG_NXFFS_PREALLOCATED
-static struct nxffs_wrfile_s g_wrfile;
-#endif
-
 /****************************************************************************
  * Public Data
  ****************************************************************************/
@@ -379,8 +371,8 @@ static inline int nxffs_wrname(FAR struct nxffs_volume_s *volume,
  * Name: nxffs_wropen
  *
  * Description:
- *   Handle opening for writing.  Only a single writer is permitted and only
- *   file creation is supported.
+ *   Handle opening for writing.  Any number of files may be open for
+ *   writing at the same time, but only file creation is supported.
  *
  ****************************************************************************/
 
@@ -389,18 +381,18 @@ static inline int nxffs_wropen(FAR struct nxffs_volume_s *volume,
                                FAR struct nxffs_ofile_s **ppofile)
 {
   FAR struct nxffs_wrfile_s *wrfile;
+  FAR struct nxffs_ofile_s *ofile;
   FAR struct nxffs_entry_s entry;
   bool packed;
   bool truncate = false;
   int namlen;
   int ret;
 
-  /* Limitation: Only a single writer is permitted.  Writing may involve
-   * extension of the file system in FLASH.  Since files are contiguous
-   * in FLASH, only a single file may be extending the FLASH region.
+  /* Get exclusive access to the volume.  Note that the volume exclsem
+   * protects the open file list.
    */
 
-  ret = sem_wait(&volume->wrsem);
+  ret = sem_wait(&volume->exclsem);
   if (ret != OK)
     {
       fdbg("ERROR: sem_wait failed: %d\n", ret);
@@ -408,17 +400,29 @@ static inline int nxffs_wropen(FAR struct nxffs_volume_s *volume,
       goto errout;
     }
 
-  /* Get exclusive access to the volume.  Note that the volume exclsem
-   * protects the open file list.  Note that exclsem is ALWAYS taken
-   * after wrsem to avoid deadlocks.
+  /* Is the file already open?  It may not yet exist in FLASH if it is
+   * being created by another writer.
    */
 
-  ret = sem_wait(&volume->exclsem);
-  if (ret != OK)
+  ofile = nxffs_findofile(volume, name);
+  if (ofile)
     {
-      fdbg("ERROR: sem_wait failed: %d\n", ret);
-      ret = -errno;
-      goto errout_with_wrsem;
+      /* Limitation:  Files cannot be open both for reading and writing and
+       * there can be only one writer of each file.
+       */
+
+      if ((ofile->oflags & O_WROK) != 0)
+        {
+          fdbg("ERROR: File is already open for writing\n");
+          ret = -EBUSY;
+        }
+      else
+        {
+          fdbg("ERROR: File is open for reading\n");
+          ret = -ENOSYS;
+        }
+
+      goto errout_with_exclsem;
     }
 
   /* Check if the file exists */
@@ -426,31 +430,15 @@ static inline int nxffs_wropen(FAR struct nxffs_volume_s *volume,
   ret = nxffs_findinode(volume, name, &entry);
   if (ret == OK)
     {
-      FAR struct nxffs_ofile_s *ofile;
-
       /* It exists.  Release the entry. */
 
       nxffs_freeentry(&entry);
 
-      /* Is the file already open for reading? */
-
-      ofile = nxffs_findofile(volume, name);
-      if (ofile)
-        {
-          /* The file is already open.
-           * Limitation:  Files cannot be open both for reading and writing.
-           */
-
-          fdbg("ERROR: File is open for reading\n");
-          ret = -ENOSYS;
-          goto errout_with_exclsem;
-        }
-
       /* It would be an error if we are asked to create the file
        * exclusively.
        */
 
-      else if ((oflags & (O_CREAT|O_EXCL)) == (O_CREAT|O_EXCL))
+      if ((oflags & (O_CREAT|O_EXCL)) == (O_CREAT|O_EXCL))
         {
           fdbg("ERROR: File exists, can't create O_EXCL\n");
           ret = -EEXIST;
@@ -510,17 +498,12 @@ static inline int nxffs_wropen(FAR struct nxffs_volume_s *volume,
    * that includes additional information to support the write operation.
    */
 
-#ifdef CONFIG_NXFFS_PREALLOCATED
-  wrfile = &g_wrfile;
-  memset(wrfile, 0, sizeof(struct nxffs_wrfile_s));
-#else
   wrfile = (FAR struct nxffs_wrfile_s *)kzalloc(sizeof(struct nxffs_wrfile_s));
   if (!wrfile)
     {
       ret = -ENOMEM;
       goto errout_with_exclsem;
     }
-#endif
 
   /* Initialize the open file state structure */
 
@@ -540,9 +523,11 @@ static inline int nxffs_wropen(FAR struct nxffs_volume_s *volume,
 
   /* Allocate FLASH memory for the file and set up for the write.
    *
-   * Loop until the inode header is configured or until a failure occurs.
-   * Note that nothing is written to FLASH.  The inode header is not
-   * written until the file is closed.
+   * Loop until the inode header and the inode name are configured or until
+   * a failure occurs.  Note that only the name is written to FLASH.  The
+   * inode header is not written until the file is closed.  If the volume
+   * must be packed, then both reservations are started over because the
+   * packing logic will re-use the free FLASH region.
    */
 
   packed = false;
@@ -558,80 +543,42 @@ static inline int nxffs_wropen(FAR struct nxffs_volume_s *volume,
           /* Find a region of memory in the block that is fully erased */
 
           ret = nxffs_hdrerased(volume, wrfile);
-          if (ret == OK)
-            {
-              /* Valid memory for the inode header was found.  Break out of
-               * the loop.
-               */
-
-              break;
-            }
         }
 
-      /* If no valid memory is found searching to the end of the volume,
-       * then -ENOSPC will be returned.  Other errors are not handled.
+      /* Then find a valid location to position the inode name just after
+       * the inode header.
        */
 
-      if (ret != -ENOSPC || packed)
+      if (ret == OK)
         {
-          fdbg("ERROR: Failed to find inode header memory: %d\n", -ret);
-          goto errout_with_name;
-        }
-
-      /* -ENOSPC is a special case..  It means that the volume is full.
-       * Try to pack the volume in order to free up some space.
-       */
+          ret = nxffs_nampos(volume, wrfile, namlen);
+          if (ret == OK)
+            {
+              /* Find a region of memory in the block that is fully erased */
 
-      ret = nxffs_pack(volume);
-      if (ret < 0)
-        {
-          fdbg("ERROR: Failed to pack the volume: %d\n", -ret);
-          goto errout_with_name;
+              ret = nxffs_namerased(volume, wrfile, namlen);
+            }
         }
 
-      /* After packing the volume, froffset will be updated to point to the
-       * new free flash region.  Try again.
-       */
-
-      packed = true;
-    }
-
-  /* Loop until the inode name is configured or until a failure occurs.
-   * Note that nothing is written to FLASH.
-   */
-
-  for (;;)
-    {
-      /* File a valid location to position the inode name.  Start with the
-       * first byte in the free FLASH region.
-       */
-
-      ret = nxffs_nampos(volume, wrfile, namlen);
       if (ret == OK)
         {
-          /* Find a region of memory in the block that is fully erased */
+          /* Valid memory for the inode header and name was found.  Write
+           * the inode name to this location.
+           */
 
-          ret = nxffs_namerased(volume, wrfile, namlen);
-          if (ret == OK)
+          ret = nxffs_wrname(volume, &wrfile->ofile.entry, namlen);
+          if (ret < 0)
             {
-              /* Valid memory for the inode header was found.  Write the
-               * inode name to this location.
-               */
-
-              ret = nxffs_wrname(volume, &wrfile->ofile.entry, namlen);
-              if (ret < 0)
-                {
-                  fdbg("ERROR: Failed to write the inode name: %d\n", -ret);
-                  goto errout_with_name;
-                }
-
-              /* Then just break out of the loop reporting success.  Note
-               * that the alllocated inode name string is retained; it
-               * will be needed later to calculate the inode CRC.
-               */
-
-              break;
+              fdbg("ERROR: Failed to write the inode name: %d\n", -ret);
+              goto errout_with_name;
             }
+
+          /* Then just break out of the loop reporting success.  Note
+           * that the alllocated inode name string is retained; it
+           * will be needed later to calculate the inode CRC.
+           */
+
+          break;
         }
 
       /* If no valid memory is found searching to the end of the volume,
@@ -640,7 +587,7 @@ static inline int nxffs_wropen(FAR struct nxffs_volume_s *volume,
 
       if (ret != -ENOSPC || packed)
         {
-          fdbg("ERROR: Failed to find inode name memory: %d\n", -ret);
+          fdbg("ERROR: Failed to find inode header memory: %d\n", -ret);
           goto errout_with_name;
         }
 
@@ -667,10 +614,8 @@ static inline int nxffs_wropen(FAR struct nxffs_volume_s *volume,
   wrfile->ofile.flink = volume->ofiles;
   volume->ofiles      = &wrfile->ofile;
 
-  /* Indicate that the volume is open for writing and return the open file
-   * instance.  Releasing exclsem allows other readers while the write is
-   * in progress.  But wrsem is still held for this open file, preventing
-   * any further writers until this inode is closed.s
+  /* Return the open file instance.  Releasing exclsem allows other readers
+   * and writers while the write is in progress.
    */
 
   *ppofile = &wrfile->ofile;
@@ -680,14 +625,9 @@ static inline int nxffs_wropen(FAR struct nxffs_volume_s *volume,
 errout_with_name:
   kfree(wrfile->ofile.entry.name);
 errout_with_ofile:
-#ifndef CONFIG_NXFFS_PREALLOCATED
   kfree(wrfile);
-#endif
-
 errout_with_exclsem:
   sem_post(&volume->exclsem);
-errout_with_wrsem:
-  sem_post(&volume->wrsem);
 errout:
   return ret;
 }
@@ -848,16 +788,9 @@ static inline void nxffs_freeofile(FAR struct nxffs_volume_s *volume,
 
   nxffs_freeentry(&ofile->entry);
 
-  /* Then free the open file container (unless this the pre-alloated
-   * write-only open file container)
-   */
+  /* Then free the open file container */
 
-#ifdef CONFIG_NXFFS_PREALLOCATED
-  if ((FAR struct nxffs_wrfile_s*)ofile != &g_wrfile)
-#endif
-    {
-      kfree(ofile);
-    }
+  kfree(ofile);
 }
 
 /****************************************************************************
@@ -867,8 +800,9 @@ static inline void nxffs_freeofile(FAR struct nxffs_volume_s *volume,
  *   Perform special operations when a file is closed:
  *   1. Write the file block header
  *   2. Remove any file with the same name that was discovered when the
- *      file was open for writing, and finally,
- *   3. Write the new file inode.
+ *      file was open for writing,
+ *   3. Write the new file inode, and finally,
+ *   4. Add the new file inode to the inode index.
  *
  * Input parameters
  *   volume - Describes the NXFFS volume
@@ -881,9 +815,11 @@ static inline int nxffs_wrclose(FAR struct nxffs_volume_s *volume,
 {
   int ret;
 
-  /* Is there an unfinalized write data? */
+  /* Is there an unfinalized data block?  If the data block is empty,
+   * nxffs_wrblkhdr() will just release the reserved FLASH.
+   */
 
-  if (wrfile->datlen > 0)
+  if (wrfile->doffset > 0)
     {
       /* Yes.. Write the final file block header */
 
@@ -917,11 +853,16 @@ static inline int nxffs_wrclose(FAR struct nxffs_volume_s *volume,
   /* Write the inode header to FLASH */
 
   ret = nxffs_wrinode(volume, &wrfile->ofile.entry);
+  if (ret < 0)
+    {
+      goto errout;
+    }
 
-  /* The volume is now available for other writers */
+  /* And make the new inode visible in the inode index */
+
+  ret = nxffs_addindex(volume, &wrfile->ofile.entry);
 
 errout:
-  sem_post(&volume->wrsem);
   return ret;
 }
 
@@ -968,35 +909,6 @@ FAR struct nxffs_ofile_s *nxffs_findofile(FAR struct nxffs_volume_s *volume,
   return NULL;
 }
 
-/****************************************************************************
- * Name: nxffs_findwriter
- *
- * Description:
- *   Search the list of already opened files and return the open file
- *   instance for the write.
- *
- * Input Parameters:
- *   volume - Describes the NXFFS volume.
- *
- * Returned Value:
- *   If there is an active writer of the volume, its open file instance is
- *   returned.  NULL is returned otherwise.
- *
- ****************************************************************************/
-
-FAR struct nxffs_wrfile_s *nxffs_findwriter(FAR struct nxffs_volume_s *volume)
-{
-  /* We can tell if the write is in-use because it will have an allocated
-   * name attached.
-   */
-
-#ifdef CONFIG_NXFFS_PREALLOCATED
-  return g_wrfile.ofile.entry.name != NULL ? &g_wrfile : NULL;
-#else
-#  error "Missing implementation"
-#endif
-}
-
 /****************************************************************************
  * Name: nxffs_open
  *
@@ -1110,11 +1022,11 @@ int nxffs_dup(FAR const struct file *oldp, FAR struct file *newp)
   /* Limitations: I do not think we have to be concerned about the
    * usual NXFFS file limitations here:  dup'ing cannot resulting
    * in mixed reading and writing to the same file, or multiple
-   * writer to different file.
+   * writers of the same file.
    *
-   * I notice that nxffs_wropen will prohibit multiple opens for
-   * writing. But I do not thing that dup'ing a file already opened
-   * for writing suffers from any of these issues.
+   * I notice that nxffs_wropen will prohibit multiple opens of the same
+   * file for writing. But I do not thing that dup'ing a file already
+   * opened for writing suffers from any of these issues.
    */
 
   /* Just increment the reference count on the ofile */
@@ -1183,6 +1095,7 @@ int nxffs_close(FAR struct file *filep)
       if ((ofile->oflags & O_WROK) != 0)
         {
           ret = nxffs_wrclose(volume, (FAR struct nxffs_wrfile_s *)ofile);
+          nxffs_packsched(volume);
         }
 
       /* Release all resouces held by the open file */
@@ -1285,10 +1198,7 @@ int nxffs_wrinode(FAR struct nxffs_volume_s *volume,
            volume->ioblock, -ret);
     }
 
-  /* The volume is now available for other writers */
-
 errout:
-  sem_post(&volume->wrsem);
   return ret;
 }
 
@@ -1300,8 +1210,9 @@ errout:
  *   this inode and, if so, move the data in the open file structure as well.
  *
  * Input parameters
- *   volume - Describes the NXFFS volume
- *   entry  - Describes the new inode entry
+ *   volume  - Describes the NXFFS volume
+ *   hoffset - The original FLASH offset to the inode header
+ *   entry   - Describes the new inode entry
  *
  * Returned Value:
  *   Zero is returned on success; Otherwise, a negated errno value is returned
@@ -1309,21 +1220,29 @@ errout:
  *
  ****************************************************************************/
 
-int nxffs_updateinode(FAR struct nxffs_volume_s *volume,
+int nxffs_updateinode(FAR struct nxffs_volume_s *volume, off_t hoffset,
                       FAR struct nxffs_entry_s *entry)
 {
   FAR struct nxffs_ofile_s *ofile;
 
-  /* Find the open inode structure matching this name */
+  /* Find the open inode structure that refers to the original inode header.
+   * Names are not unique while a file is being re-written, but the inode
+   * header offsets are.
+   */
 
-  ofile = nxffs_findofile(volume, entry->name);
-  if (ofile)
+  for (ofile = volume->ofiles; ofile; ofile = ofile->flink)
     {
-      /* Yes.. the file is open.  Update the FLASH offsets to inode headers */
+      if (ofile->entry.hoffset == hoffset)
+        {
+          /* Yes.. the file is open.  Update the FLASH offsets to inode
+           * headers.
+           */
 
-      ofile->entry.hoffset = entry->hoffset;
-      ofile->entry.noffset = entry->noffset;
-      ofile->entry.doffset = entry->doffset;
+          ofile->entry.hoffset = entry->hoffset;
+          ofile->entry.noffset = entry->noffset;
+          ofile->entry.doffset = entry->doffset;
+          break;
+        }
     }
 
   return OK;
@@ -1,7 +1,7 @@
 /****************************************************************************
  * fs/nxffs/nxffs_pack.c
  *
- *   Copyright (C) 2011, 2013 Gregory Nutt. All rights reserved.
+ *   Copyright (C) 2011, 2013-2014 Gregory Nutt. All rights reserved.
  *   Author: Gregory Nutt <gnutt@nuttx.org>
  *
  * References: Linux/Documentation/filesystems/romfs.txt
@@ -42,12 +42,14 @@
 #include <nuttx/config.h>
 
 #include <string.h>
+#include <fcntl.h>
 #include <errno.h>
 #include <assert.h>
 #include <crc32.h>
 #include <debug.h>
 
 #include <nuttx/kmalloc.h>
+#include <nuttx/clock.h>
 
 #include "nxffs.h"
 
@@ -55,29 +57,69 @@
  * Pre-processor Definitions
  ****************************************************************************/
 
+/* In addition to the object types reported by nxffs_nextobject(), the
+ * packing logic reports the reserved (but not yet written) inode header of
+ * a file that is open for writing.
+ */
+
+#define NXFFS_OBJ_WRITER     3
+
+/* The map of relocated inode headers is grown by this number of entries at
+ * a time.
+ */
+
+#define NXFFS_PACKMAP_INCR   8
+
+/* Stale FLASH left between the relocated objects and the objects that are
+ * not moved by an incremental pack step is overwritten with this value.
+ * It is not the erased state and never matches a magic number, so the
+ * FLASH content can still be walked object-by-object.
+ */
+
+#define NXFFS_FILLSTATE      ((uint8_t)~CONFIG_NXFFS_ERASEDSTATE)
+
+/* An incremental pack step gives up after skipping over this many inode
+ * headers that cannot be moved without moving all of their data.
+ */
+
+#define NXFFS_PACKTRIES      4
+
 /****************************************************************************
  * Public Types
  ****************************************************************************/
-/* This structure supports access to one inode data stream */
 
-struct nxffs_packstream_s
+/* This structure describes one inode header that has been relocated by the
+ * packing logic.  Entries are added in order of the original FLASH offset.
+ */
+
+struct nxffs_packmap_s
 {
-  struct nxffs_entry_s entry;      /* Describes the inode header */
-  off_t                fpos;       /* Current file position */
-  off_t                blkoffset;  /* Offset to the current data block */
-  uint16_t             blklen;     /* Size of this block */
-  uint16_t             blkpos;     /* Position in block corresponding to fpos */
+  off_t                      hoffset;  /* Original offset to the inode header */
+  off_t                      doffset;  /* Original offset to the first data block */
+  FAR struct nxffs_wrfile_s *wrfile;   /* The writer of the inode (if any) */
+  struct nxffs_entry_s       entry;    /* The relocated inode header */
+  bool                       pending;  /* The inode header has not been written */
 };
 
-/* The structure supports the overall packing operation */
+/* This structure describes one inode header position (live, deleted, or
+ * only named by the data blocks of a deleted inode) in the region to be
+ * relocated by an incremental pack step.  Entries are sorted by the FLASH
+ * offset.
+ */
 
-struct nxffs_pack_s
+struct nxffs_packspan_s
 {
-  /* These describe the source and destination streams */
+  off_t                      hoffset;  /* Offset to the inode header */
+  off_t                      last;     /* End of the last data block owned */
+  bool                       whole;    /* The inode must be moved as a whole */
+  bool                       stale;    /* Owns data blocks before the first
+                                        * live object */
+};
 
-  struct nxffs_packstream_s src;
-  struct nxffs_packstream_s dest;
+/* The structure supports the overall packing operation */
 
+struct nxffs_pack_s
+{
   /* These describe the state of the current contents of the (destination)
    * volume->pack buffer.
    */
@@ -86,6 +128,33 @@ struct nxffs_pack_s
   off_t                ioblock;    /* I/O block number */
   off_t                block0;     /* First I/O block number in the erase block */
   uint16_t             iooffset;   /* I/O block offset */
+
+  /* This describes the destination data block that is being filled */
+
+  off_t                datoffset;  /* Offset to the data block header (0=none) */
+  off_t                datowner;   /* Offset to the owning inode header */
+  uint16_t             datlen;     /* Number of data bytes in the data block */
+
+  /* These describe the source region of FLASH */
+
+  off_t                start;      /* Offset where packing begins */
+  off_t                next;       /* Offset to the first live object */
+  off_t                end;        /* Offset where packing ends */
+  off_t                untagged;   /* Owner of untagged data blocks (-1=none) */
+  off_t                keep;       /* Stale objects before this offset may
+                                    * be left in FLASH */
+
+  /* The relocated inode headers */
+
+  FAR struct nxffs_packmap_s *map;
+  size_t               nmap;       /* Number of entries in the map */
+  size_t               maxmap;     /* Allocated size of the map */
+
+  /* The inode headers in the region of an incremental pack step */
+
+  FAR struct nxffs_packspan_s *span;
+  size_t               nspan;      /* Number of entries in the span list */
+  size_t               maxspan;    /* Allocated size of the span list */
 };
 
 /****************************************************************************
@@ -183,553 +252,664 @@ static inline bool nxffs_packvalid(FAR struct nxffs_pack_s *pack)
 }
 
 /****************************************************************************
- * Name: nxffs_mediacheck
+ * Name: nxffs_findwriter
  *
  * Description:
- *   Verify that there is at least one valid block and at least one valid
- *   inode header on the media.  On successful return, the volume packing
- *   structure is initialized and contains the offset to the first valid
- *   inode header is returned.
+ *   Return the open writer whose inode header is (or will be) at the
+ *   provided FLASH offset.
  *
  * Input Parameters:
- *   volume - The volume to be packed.
- *   pack   - The volume packing state structure.
+ *   volume  - The volume to be packed.
+ *   hoffset - The FLASH offset to the inode header.
  *
  * Returned Values:
- *   The offset to the data area on the first valid block.  Zero is return
- *   if there are no valid blocks or if there are no valid inode headers
- *   after the first valid block.
+ *   The open writer or NULL if there is no such writer.
  *
  ****************************************************************************/
 
-static inline off_t nxffs_mediacheck(FAR struct nxffs_volume_s *volume,
-                                     FAR struct nxffs_pack_s *pack)
+static FAR struct nxffs_wrfile_s *
+nxffs_findwriter(FAR struct nxffs_volume_s *volume, off_t hoffset)
 {
-  off_t froffset;
-  int ret;
+  FAR struct nxffs_ofile_s *ofile;
 
-  /* Initialize the packing structure to all zero */
+  for (ofile = volume->ofiles; ofile; ofile = ofile->flink)
+    {
+      if ((ofile->oflags & O_WROK) != 0 && ofile->entry.hoffset == hoffset)
+        {
+          return (FAR struct nxffs_wrfile_s *)ofile;
+        }
+    }
 
-  memset(pack, 0, sizeof(struct nxffs_pack_s));
+  return NULL;
+}
 
-  /* Find the FLASH offset to the first valid block */
+/****************************************************************************
+ * Name: nxffs_nextwriter
+ *
+ * Description:
+ *   Return the FLASH offset of the first inode header reserved by an open
+ *   writer at or after the provided offset.
+ *
+ * Input Parameters:
+ *   volume - The volume to be packed.
+ *   offset - The FLASH offset to begin the search.
+ *   end    - The value to return if there is no such writer.
+ *
+ * Returned Values:
+ *   The FLASH offset to the reserved inode header or end.
+ *
+ ****************************************************************************/
 
-  volume->ioblock = 0;
-  ret = nxffs_validblock(volume, &volume->ioblock);
-  if (ret < 0)
-   {
-     /* No valid blocks?  Return offset zero. */
+static off_t nxffs_nextwriter(FAR struct nxffs_volume_s *volume,
+                              off_t offset, off_t end)
+{
+  FAR struct nxffs_ofile_s *ofile;
+  off_t next = end;
 
-     return 0;
-   }
+  for (ofile = volume->ofiles; ofile; ofile = ofile->flink)
+    {
+      if ((ofile->oflags & O_WROK) != 0 &&
+          ofile->entry.hoffset >= offset && ofile->entry.hoffset < next)
+        {
+          next = ofile->entry.hoffset;
+        }
+    }
 
-  /* The offset to the free location to pack is then just after the block
-   * header in this block.
-   */
+  return next;
+}
 
-  volume->iooffset = SIZEOF_NXFFS_BLOCK_HDR;
-  froffset         = nxffs_iotell(volume);
+/****************************************************************************
+ * Name: nxffs_packlive
+ *
+ * Description:
+ *   Check if an inode header (that has not been relocated) is still in use,
+ *   i.e., that it is either in the inode index or that it belongs to an
+ *   open writer.
+ *
+ * Input Parameters:
+ *   volume  - The volume to be packed.
+ *   hoffset - The FLASH offset to the inode header.
+ *
+ * Returned Values:
+ *   True if the inode is in use.
+ *
+ ****************************************************************************/
 
-  /* Get the offset to the first valid inode entry after this free offset */
+static bool nxffs_packlive(FAR struct nxffs_volume_s *volume, off_t hoffset)
+{
+  size_t ndx = nxffs_findindex(volume, hoffset);
 
-  ret = nxffs_nextentry(volume, froffset, &pack->src.entry);
-  if (ret < 0)
+  if (ndx < volume->ninodes && volume->index[ndx].hoffset == hoffset)
     {
-      /* No valid entries on the media -- Return offset zero */
-
-     return 0;
+      return true;
     }
 
-  /* Okay.. the start block and first entry have been found */
-
-  return froffset;
+  return nxffs_findwriter(volume, hoffset) != NULL;
 }
 
 /****************************************************************************
- * Name: nxffs_startpos
+ * Name: nxffs_packobject
  *
  * Description:
- *   Find the position in FLASH memory where we should begin packing.  That
- *   position is the place where there is a gap between the last and the next
- *   valid inode.  On entry, the volume packing structure should be as it
- *   was initialized by nxffx_mediacheck.  on successful return, the volume
- *   packing state structure will be updated to begin the packing operation.
+ *   Return the next object in the source region.  This is nxffs_nextobject()
+ *   except that the inode headers reserved by open writers are also
+ *   reported (as NXFFS_OBJ_WRITER).  Those have no valid content on FLASH
+ *   yet and would otherwise look like the end of the valid data.
  *
  * Input Parameters:
- *   volume - The volume to be packed
- *   pack   - The volume packing state structure.
- *   froffset - On input, this is the location where we should be searching
- *     for the location to begin packing.  On successful return, froffset
- *     will be set to the offset in FLASH where the first inode should be
- *     copied to.  If -ENOSPC is returned -- meaning that the FLASH is full
- *     --  then no packing can be performed. In this case, then the free
- *     flash offset is returned through this location.
+ *   volume - The volume to be packed.
+ *   offset - The FLASH offset to begin the search.
+ *   end    - The end of the source region.
+ *   object - The location to return the object description.
+ *   wrfile - The location to return the writer (NXFFS_OBJ_WRITER only).
  *
  * Returned Values:
- *   Zero on success; Otherwise, a negated errno value is returned to
- *   indicate the nature of the failure.  If -ENOSPC is returned then the
- *   free FLASH offset is also returned.
+ *   Zero on success; -ENOENT or -ENOSPC at the end of the source region;
+ *   Otherwise, a negated errno value indicating the nature of the failure.
  *
  ****************************************************************************/
 
-static inline int nxffs_startpos(FAR struct nxffs_volume_s *volume,
-                                 FAR struct nxffs_pack_s *pack,
-                                 off_t *froffset)
+static int nxffs_packobject(FAR struct nxffs_volume_s *volume, off_t offset,
+                            off_t end, FAR struct nxffs_object_s *object,
+                            FAR struct nxffs_wrfile_s **wrfile)
 {
-  struct nxffs_blkentry_s blkentry;
-  off_t offset = *froffset;
-  off_t wasted;
-  off_t nbytes;
+  off_t limit;
   int ret;
 
-  /* Loop until we find a gap of unused FLASH large enough to warrant
-   * compacting.
-   */
-
-  for(;;)
+  limit = nxffs_nextwriter(volume, offset, end);
+  ret   = nxffs_nextobject(volume, offset, limit, object);
+  if ((ret == -ENOENT || ret == -ENOSPC) && limit < end)
     {
-      /* Is there wasted space between the offset where the we could have
-       * valid data and the offset to the beginning of the first valid
-       * inode header?  NOTE:  The threshold check is not accurate, there
-       * may or may not be intervening block headers making the separation
-       * seem larger than it is.
+      /* The next thing in FLASH is the inode header (and name) reserved by
+       * an open writer.
        */
 
-      DEBUGASSERT(pack->src.entry.hoffset >= offset);
-      wasted = pack->src.entry.hoffset - offset;
-      if (wasted > CONFIG_NXFFS_PACKTHRESHOLD)
-        {
-          /* This is where we must begin packing.  Describe the destination
-           * inode header (only non-zero entries need to be initialized).
-           */
+      *wrfile      = nxffs_findwriter(volume, limit);
+      object->type = NXFFS_OBJ_WRITER;
+      object->next = (*wrfile)->ofile.entry.noffset +
+                     strlen((*wrfile)->ofile.entry.name);
+      return OK;
+    }
 
-          pack->dest.entry.name    = pack->src.entry.name;
-          pack->dest.entry.utc     = pack->src.entry.utc;
-          pack->dest.entry.datlen  = pack->src.entry.datlen;
+  return ret;
+}
 
-          /* The destination entry now "owns" the name string */
+/****************************************************************************
+ * Name: nxffs_packstart
+ *
+ * Description:
+ *   Find the position where packing should begin.  That is the first byte
+ *   of the first gap of unused FLASH that is worth reclaiming, moved back
+ *   to the header of any live inode whose data follows that position (the
+ *   first data block of an inode must never be moved before its header).
+ *
+ * Input Parameters:
+ *   volume - The volume to be packed.
+ *   pack   - The volume packing state structure.
+ *   from   - Look for a gap at or after this object (0=the first object).
+ *
+ * Returned Values:
+ *   Zero on success; Otherwise, a negated errno value is returned to
+ *   indicate the nature of the failure.  pack->start is set to pack->end
+ *   if there is nothing worth packing.  pack->next is set to the offset of
+ *   the first live object after pack->start (pack->end if there is none).
+ *
+ ****************************************************************************/
 
-          pack->src.entry.name     = NULL;
+static int nxffs_packstart(FAR struct nxffs_volume_s *volume,
+                           FAR struct nxffs_pack_s *pack, off_t from)
+{
+  struct nxffs_object_s object;
+  FAR struct nxffs_wrfile_s *wrfile;
+  off_t offset;
+  off_t objstart;
+  off_t liveend;
+  off_t liveuntagged;
+  off_t untagged;
+  off_t start;
+  off_t block;
+  size_t ndx;
+  bool live;
+  int ret;
 
-          /* Return the FLASH offset to the destination inode header */
+  /* Start with the first valid block */
 
-          *froffset = offset;
-          return OK;
+  offset = from;
+  if (offset == 0)
+    {
+      block = 0;
+      ret = nxffs_validblock(volume, &block);
+      if (ret < 0)
+        {
+          fdbg("ERROR: Failed to find a valid block: %d\n", -ret);
+          return ret;
         }
 
-      /* Free the allocated memory in the entry */
-
-      nxffs_freeentry(&pack->src.entry);
+      offset = block * volume->geo.blocksize + SIZEOF_NXFFS_BLOCK_HDR;
+    }
 
-      /* Update the offset to the first byte at the end of the last data
-       * block.
-       */
+  liveend      = offset;
+  liveuntagged = -1;
+  untagged     = -1;
+  start        = -1;
 
-      nbytes = 0;
-      offset = pack->src.entry.doffset;
+  /* Walk the objects in FLASH looking for the first gap between live
+   * objects that is larger than the packing threshold.
+   */
 
-      while (nbytes < pack->src.entry.datlen)
+  while ((ret = nxffs_packobject(volume, offset, pack->end,
+                                 &object, &wrfile)) == OK)
+    {
+      switch (object.type)
         {
-          /* Read the next data block header */
+        case NXFFS_OBJ_INODE:
+        case NXFFS_OBJ_DELETED:
+          objstart = object.entry.hoffset;
+          live     = (object.type == NXFFS_OBJ_INODE &&
+                      nxffs_packlive(volume, objstart));
+          untagged = live ? objstart : -1;
+          nxffs_freeentry(&object.entry);
+          break;
+
+        case NXFFS_OBJ_WRITER:
+          objstart = wrfile->ofile.entry.hoffset;
+          live     = true;
+          untagged = -1;
+          break;
+
+        default:
+          /* Tagged data blocks name their owner; untagged data blocks
+           * belong to the preceding inode header.
+           */
 
-          ret = nxffs_nextblock(volume, offset, &blkentry);
-          if (ret < 0)
+          objstart = object.blkentry.hoffset;
+          if (object.blkentry.datlen == 0)
             {
-              fdbg("ERROR: Failed to find next data block: %d\n", -ret);
-              return ret;
+              live = false;
             }
-
-          /* Get the number of blocks and pointer to where the next
-           * data block might lie.
-           */
-
-          nbytes += blkentry.datlen;
-          offset  = blkentry.hoffset + SIZEOF_NXFFS_DATA_HDR + blkentry.datlen;
+          else if (object.blkentry.owner != 0)
+            {
+              live = nxffs_packlive(volume, object.blkentry.owner);
+            }
+          else
+            {
+              live = (untagged >= 0);
+            }
+          break;
         }
 
-      /* Make sure there is space at this location for an inode header */
-
-      nxffs_ioseek(volume, offset);
-      if (volume->iooffset + SIZEOF_NXFFS_INODE_HDR > volume->geo.blocksize)
+      if (live)
         {
-          /* No.. not enough space here. Find the next valid block */
-
-          volume->ioblock++;
-          ret = nxffs_validblock(volume, &volume->ioblock);
-          if (ret < 0)
+          if (objstart - liveend > CONFIG_NXFFS_PACKTHRESHOLD)
             {
-               /* No valid blocks? Then there is nothing we can do.  Return
-                * the end-of-flash indication.
-                */
-
-               *froffset = volume->froffset;
-               return -ENOSPC;
+              start          = liveend;
+              pack->next     = objstart;
+              pack->untagged = liveuntagged;
+              break;
             }
 
-          volume->iooffset = SIZEOF_NXFFS_BLOCK_HDR;
-          offset = nxffs_iotell(volume);
+          liveend      = object.next;
+          liveuntagged = untagged;
         }
 
-      /* Get the offset to the next valid inode entry */
+      offset = object.next;
+    }
 
-      ret = nxffs_nextentry(volume, offset, &pack->src.entry);
-      if (ret < 0)
-        {
-          /* No more valid inode entries.  Just return an end-of-flash error
-           * indication.  However, there could be many deleted inodes; set
-           * volume->froffset to indicate the true free FLASH position.
-           */
+  if (ret < 0 && ret != -ENOENT && ret != -ENOSPC)
+    {
+      fdbg("ERROR: Failed to find the next object: %d\n", -ret);
+      return ret;
+    }
 
-          *froffset = offset;
-          return -ENOSPC;
+  /* If there is no gap between live objects, then the only reclaimable
+   * FLASH is at the end.  Don't bother unless there is some particularly
+   * big FLASH savings (otherwise, we risk wearing out these final blocks).
+   */
+
+  if (start < 0)
+    {
+      if (liveend + CONFIG_NXFFS_TAILTHRESHOLD > pack->end)
+        {
+          pack->start = pack->end;
+          return OK;
         }
+
+      start          = liveend;
+      pack->next     = pack->end;
+      pack->untagged = liveuntagged;
     }
 
-  /* We won't get here */
+  /* The first data block of an inode lies after its header.  If the data
+   * of a live inode whose header precedes the starting position would be
+   * moved, then that header must be moved (and rewritten) as well.
+   */
+
+  for (ndx = nxffs_findindex(volume, start); ndx > 0; ndx--)
+    {
+      if (volume->index[ndx - 1].doffset >= start)
+        {
+          start          = volume->index[ndx - 1].hoffset;
+          pack->next     = start;
+          pack->untagged = -1;
+        }
+    }
 
-  return -ENOSYS;
+  pack->start = start;
+  return OK;
 }
 
 /****************************************************************************
- * Name: nxffs_srcsetup
+ * Name: nxffs_findmap
  *
  * Description:
- *   Given a valid src inode, configure the src data stream.
+ *   Find the map entry for a relocated inode header.
  *
  * Input Parameters:
- *   volume - The volume to be packed
- *   pack   - The volume packing state structure.
- *   offset - FLASH offset to the data block header (will be zero for zero-
- *     files.
+ *   pack    - The volume packing state structure.
+ *   hoffset - The original FLASH offset to the inode header.
  *
  * Returned Values:
- *   Zero on success; Otherwise, a negated errno value is returned to
- *   indicate the nature of the failure.
+ *   The map entry or NULL if the inode header was not relocated.
  *
  ****************************************************************************/
 
-static int nxffs_srcsetup(FAR struct nxffs_volume_s *volume,
-                          FAR struct nxffs_pack_s *pack, off_t offset)
+static FAR struct nxffs_packmap_s *
+nxffs_findmap(FAR struct nxffs_pack_s *pack, off_t hoffset)
 {
-  /* Start with the first data block */
-
-  pack->src.blkoffset = offset;
-  pack->src.blkpos    = 0;
+  size_t low  = 0;
+  size_t high = pack->nmap;
 
-  /* Zero-length files have no valid data block offset */
-
-  if (offset > 0)
+  while (low < high)
     {
-      /* Seek to the data block header, read and verify the block header */
+      size_t mid = (low + high) >> 1;
 
-      int ret = nxffs_rdblkhdr(volume, offset, &pack->src.blklen);
-      if (ret < 0)
+      if (pack->map[mid].hoffset == hoffset)
         {
-          fdbg("ERROR: Failed to verify the data block header: %d\n", -ret);
+          return &pack->map[mid];
+        }
+      else if (pack->map[mid].hoffset < hoffset)
+        {
+          low = mid + 1;
+        }
+      else
+        {
+          high = mid;
         }
-
-      return ret;
     }
 
-  DEBUGASSERT(pack->src.entry.datlen == 0);
-  return OK;
+  return NULL;
 }
 
 /****************************************************************************
- * Name: nxffs_destsetup
+ * Name: nxffs_addmap
  *
  * Description:
- *   Given a valid dest inode, configure the dest data stream.
+ *   Add a map entry for a relocated inode header.
  *
  * Input Parameters:
- *   volume - The volume to be packed
- *   pack   - The volume packing state structure.
+ *   pack    - The volume packing state structure.
+ *   hoffset - The original FLASH offset to the inode header.
+ *   doffset - The original FLASH offset to the first data block.
  *
  * Returned Values:
- *   Zero on success; Otherwise, a negated errno value is returned to
- *   indicate the nature of the failure.
+ *   The new map entry or NULL if memory could not be allocated.
  *
  ****************************************************************************/
 
-static int nxffs_destsetup(FAR struct nxffs_volume_s *volume,
-                           FAR struct nxffs_pack_s *pack)
+static FAR struct nxffs_packmap_s *
+nxffs_addmap(FAR struct nxffs_pack_s *pack, off_t hoffset, off_t doffset)
 {
-  size_t mindata;
-  int    namlen;
-  int    ret;
+  FAR struct nxffs_packmap_s *map;
 
-  /* The destination can be in one of three of states:
-   *
-   * State 1: The inode position was not yet been found.  This condition can
-   * only occur on initial entry into nxffs_packblock() when there we no space
-   * for the inode header at the end of the previous block.  We must now be
-   * at the beginning of a shiny new I/O block, so we should always have
-   * space for a new inode header right here.
-   */
-
-  if (pack->dest.entry.hoffset == 0)
+  if (pack->nmap >= pack->maxmap)
     {
-      /* Is there room for an inode structure in this block?  */
-
-      if(pack->iooffset + SIZEOF_NXFFS_INODE_HDR > volume->geo.blocksize)
+      map = (FAR struct nxffs_packmap_s *)
+        krealloc(pack->map, (pack->maxmap + NXFFS_PACKMAP_INCR) *
+                            sizeof(struct nxffs_packmap_s));
+      if (!map)
         {
-          /* No.. that inode name will not fit in this block. Return an
-           * indication that we are at the end of the block and try again
-           * later.
-           */
-
-          return -ENOSPC;
+          return NULL;
         }
 
-      /* The inode header will be placed at this position (but not until
-       * we are finished.
-       */
-
-      pack->dest.entry.hoffset = nxffs_packtell(volume, pack);
-
-      /* Make sure that the initialize state of the inode header memory is
-       * erased.  This is important because we may not write to inode header
-       * until it has already been written to FLASH.
-       */
-
-      memset(&pack->iobuffer[pack->iooffset], CONFIG_NXFFS_ERASEDSTATE,
-             SIZEOF_NXFFS_INODE_HDR);
+      pack->map     = map;
+      pack->maxmap += NXFFS_PACKMAP_INCR;
+    }
 
-      /* Then set the new FLASH offset */
+  map = &pack->map[pack->nmap++];
+  memset(map, 0, sizeof(struct nxffs_packmap_s));
+  map->hoffset = hoffset;
+  map->doffset = doffset;
+  return map;
+}
 
-      pack->iooffset += SIZEOF_NXFFS_INODE_HDR;
-    }
+/****************************************************************************
+ * Name: nxffs_findspan
+ *
+ * Description:
+ *   Find the span entry for an inode header.
+ *
+ * Input Parameters:
+ *   pack    - The volume packing state structure.
+ *   hoffset - The FLASH offset to the inode header.
+ *
+ * Returned Values:
+ *   The span entry or NULL if there is no inode header at that offset in
+ *   the region of the incremental pack step.
+ *
+ ****************************************************************************/
 
-  /* State 2: inode position found, inode header not written, inode name
-   * position not determined.
-   */
+static FAR struct nxffs_packspan_s *
+nxffs_findspan(FAR struct nxffs_pack_s *pack, off_t hoffset)
+{
+  size_t low  = 0;
+  size_t high = pack->nspan;
 
-  if (pack->dest.entry.noffset == 0)
+  while (low < high)
     {
-      /* Find the offset to the string memory.  Will if fit in this block?
-       * Note: iooffset has already been incremented to account for the
-       * size of the inode header.
-       */
+      size_t mid = (low + high) >> 1;
 
-      namlen = strlen(pack->dest.entry.name);
-      if (pack->iooffset + namlen > volume->geo.blocksize)
+      if (pack->span[mid].hoffset == hoffset)
         {
-          /* No.. that inode name will not fit in this block. Return an
-           * indication that we are at the end of the block and try again
-           * later.
-           */
-
-          return -ENOSPC;
+          return &pack->span[mid];
         }
+      else if (pack->span[mid].hoffset < hoffset)
+        {
+          low = mid + 1;
+        }
+      else
+        {
+          high = mid;
+        }
+    }
 
-      /* Yes.. Write the inode name to the volume packing buffer now, but do
-       * not free the name string memory yet; it will be needed later to\
-       * calculate the header CRC.
-       */
-
-      memcpy(&pack->iobuffer[pack->iooffset], pack->dest.entry.name, namlen);
-
-      /* Reserve space for the inode name  */
+  return NULL;
+}
 
-      pack->dest.entry.noffset = nxffs_packtell(volume, pack);
-      pack->iooffset += namlen;
-    }
+/****************************************************************************
+ * Name: nxffs_addspan
+ *
+ * Description:
+ *   Add a span entry for an inode header position.
+ *
+ * Input Parameters:
+ *   pack    - The volume packing state structure.
+ *   hoffset - The FLASH offset to the inode header.
+ *   last    - The end of the inode header and name (or of the data block).
+ *   whole   - True if the inode must be moved as a whole.
+ *   stale   - True if the data block lies before the first live object.
+ *
+ * Returned Values:
+ *   Zero on success; -ENOMEM if memory could not be allocated.
+ *
+ ****************************************************************************/
 
-  /* State 3: Inode header not-written, inode name written.  Still need the position
-   * of the first data block.
-   *
-   * Deal with the special case where the source inode is a zero length file
-   * with no data blocks to be transferred.
-   */
+static int nxffs_addspan(FAR struct nxffs_pack_s *pack, off_t hoffset,
+                         off_t last, bool whole, bool stale)
+{
+  FAR struct nxffs_packspan_s *span;
+  size_t ndx;
 
-  if (pack->src.entry.doffset > 0)
+  if (pack->nspan >= pack->maxspan)
     {
-      if (pack->dest.entry.doffset == 0)
+      span = (FAR struct nxffs_packspan_s *)
+        krealloc(pack->span, (pack->maxspan + NXFFS_PACKMAP_INCR) *
+                             sizeof(struct nxffs_packspan_s));
+      if (!span)
         {
-          /* Will the data block header plus a minimal amount of data fit in this
-           * block? (or the whole file if the file is very small).
-           */
-
-          mindata = MIN(NXFFS_MINDATA, pack->dest.entry.datlen);
-          if (pack->iooffset + SIZEOF_NXFFS_DATA_HDR + mindata > volume->geo.blocksize)
-            {
-              /* No.. return an indication that we are at the end of the block
-               * and try again later.
-               */
-
-              ret = -ENOSPC;
-              goto errout;
-           }
-
-          /* Yes.. reserve space for the data block header */
-
-          pack->dest.entry.doffset = nxffs_packtell(volume, pack);
-          pack->iooffset          += SIZEOF_NXFFS_DATA_HDR;
-
-          /* Initialize the output data stream to start with the first data block */
-
-          pack->dest.blkoffset     = pack->dest.entry.doffset;
-          pack->dest.blklen        = 0;
-          pack->dest.blkpos        = 0;
+          return -ENOMEM;
         }
 
-      /* State 4:  Starting a new block.  Verify that there is space in the current
-       * block for another (minimal sized) block
-       */
-
-      if (pack->dest.blkoffset == 0)
-        {
-          /* Will the data block header plus a minimal amount of data fit in this
-           * block? (or the whole file if the file is very small).
-           */
-
-          mindata = MIN(NXFFS_MINDATA, pack->dest.entry.datlen);
-          if (pack->iooffset + SIZEOF_NXFFS_DATA_HDR + mindata > volume->geo.blocksize)
-            {
-              /* No.. return an indication that we are at the end of the block
-               * and try again later.
-               */
-
-              ret = -ENOSPC;
-              goto errout;
-           }
+      pack->span     = span;
+      pack->maxspan += NXFFS_PACKMAP_INCR;
+    }
 
-          /* Yes.. reserve space for the data block header */
+  /* Inode headers are found in order, but the positions named by orphaned
+   * data blocks are not.
+   */
 
-          pack->dest.blkoffset = nxffs_packtell(volume, pack);
-          pack->iooffset      += SIZEOF_NXFFS_DATA_HDR;
-          pack->dest.blklen    = 0;
-          pack->dest.blkpos    = 0;
-        }
-    }
+  for (ndx = pack->nspan; ndx > 0 && pack->span[ndx - 1].hoffset > hoffset;
+       ndx--);
 
-  ret = OK;
+  span = &pack->span[ndx];
+  memmove(span + 1, span,
+          (pack->nspan - ndx) * sizeof(struct nxffs_packspan_s));
+  pack->nspan++;
 
-errout:
-  volume->froffset = nxffs_packtell(volume, pack);
-  return ret;
+  span->hoffset = hoffset;
+  span->last    = last;
+  span->whole   = whole;
+  span->stale   = stale;
+  return OK;
 }
 
 /****************************************************************************
- * Name: nxffs_wrinodehdr
+ * Name: nxffs_packplan
  *
  * Description:
- *   Write the destination inode header (only) to FLASH.  Note that the inode
- *   name has already been written to FLASH (thus greatly simplifying the
- *   the complexity of this operation).
+ *   Select the end of the region to be relocated by an incremental pack
+ *   step.  Objects beyond that end are not moved, so (1) no live inode
+ *   header inside the region may own data blocks beyond the end (those
+ *   data blocks name the original inode header position), (2) no inode
+ *   header may be removed from before its untagged data blocks, and (3) the
+ *   relocated inode headers must not be placed at a position that is still
+ *   named by the data blocks of a deleted inode that remain in FLASH:
+ *   Those beyond the end and those in the gap before the first live object
+ *   (erase blocks that hold nothing else are not rewritten).  The last
+ *   condition is enforced by nxffs_packhdr() using the span list built
+ *   here.
  *
  * Input Parameters:
- *   volume - The volume to be packed
+ *   volume - The volume to be packed.
  *   pack   - The volume packing state structure.
+ *   limit  - The region should end at or before this FLASH offset.
  *
  * Returned Values:
  *   Zero on success; Otherwise, a negated errno value is returned to
- *   indicate the nature of the failure (not used).
+ *   indicate the nature of the failure.  On success, pack->end is the end
+ *   of the region to be relocated and pack->keep is the first untagged data
+ *   block in the gap (untagged data blocks must not lose their inode
+ *   header).
  *
  ****************************************************************************/
 
-static int nxffs_wrinodehdr(FAR struct nxffs_volume_s *volume,
-                            FAR struct nxffs_pack_s *pack)
+static int nxffs_packplan(FAR struct nxffs_volume_s *volume,
+                          FAR struct nxffs_pack_s *pack, off_t limit)
 {
-  FAR struct nxffs_inode_s *inode;
-  off_t ioblock;
-  uint16_t iooffset;
-  uint32_t crc;
-  int namlen;
+  struct nxffs_object_s object;
+  FAR struct nxffs_packspan_s *span;
+  FAR struct nxffs_wrfile_s *wrfile;
+  off_t offset = pack->start;
+  off_t untagged = -1;
+  off_t bound = pack->start;
+  off_t owner;
+  off_t objstart;
+  bool whole;
+  bool stale;
+  size_t i;
   int ret;
 
-  /* Get seek positions corresponding to the inode header location */
+  pack->keep = pack->next;
 
-  ioblock   = nxffs_getblock(volume, pack->dest.entry.hoffset);
-  iooffset  = nxffs_getoffset(volume, pack->dest.entry.hoffset, ioblock);
+  /* Walk all objects from the start of the region to the end of the valid
+   * data, recording the extent of the data owned by each inode header that
+   * lies before the limit.
+   */
 
-  /* The inode header is not written until all of the inode data has been
-   * packed into its new location.  As a result, there are two possibilities:
-   *
-   * 1. The inode header lies in the current, unwritten erase block,
-   * 2. The inode header resides in an earlier erase block and has already
-   *    been written to FLASH.
-   *
-   * Recall that the inode name has already been written to FLASH.  If that
-   * were not the case, then there would be other complex possibilities.
-   *
-   * Case 2: Does the inode header reside in a block before the beginning
-   * of the current erase block?
-   */
-
-  if (ioblock < pack->block0)
-    {
-      /* Case 2:  The inode header lies in an earlier erase block that has
-       * already been written to FLASH.  In this case, if we are very
-       * careful, we can just use the standard routine to write the inode
-       * header that is called during the normal file close operation:
-       */
-
-      ret = nxffs_wrinode(volume, &pack->dest.entry);
-    }
-  else
+  while ((ret = nxffs_packobject(volume, offset, pack->end,
+                                 &object, &wrfile)) == OK)
     {
-      /* Cases 1:  Both the inode header and name are in the unwritten cache
-       * memory.
-       *
-       * Initialize the inode header.
-       */
+      if (object.type == NXFFS_OBJ_DATA)
+        {
+          /* Tagged data blocks name their owner; untagged data blocks
+           * belong to the preceding inode header.
+           */
 
-      iooffset += (ioblock - pack->block0) * volume->geo.blocksize;
-      inode     = (FAR struct nxffs_inode_s *)&volume->pack[iooffset];
-      memcpy(inode->magic, g_inodemagic, NXFFS_MAGICSIZE);
+          objstart = object.blkentry.hoffset;
+          owner    = object.blkentry.owner != 0 ? object.blkentry.owner :
+                     untagged;
+          stale    = (objstart < pack->next);
+          span     = nxffs_findspan(pack, owner);
 
-      nxffs_wrle32(inode->noffs,  pack->dest.entry.noffset);
-      nxffs_wrle32(inode->doffs,  pack->dest.entry.doffset);
-      nxffs_wrle32(inode->utc,    pack->dest.entry.utc);
-      nxffs_wrle32(inode->crc,    0);
-      nxffs_wrle32(inode->datlen, pack->dest.entry.datlen);
+          if (object.blkentry.owner == 0 && objstart < pack->keep)
+            {
+              pack->keep = objstart;
+            }
 
-      /* Get the length of the inode name */
+          if (span)
+            {
+              span->last   = object.next;
+              span->whole |= (object.blkentry.owner == 0);
+              span->stale |= stale;
+            }
+          else if (owner >= pack->start && owner < limit)
+            {
+              /* The inode header of this data block was already removed
+               * by an earlier pack step.
+               */
 
-      namlen = strlen(pack->dest.entry.name);
-      DEBUGASSERT(namlen < CONFIG_NXFFS_MAXNAMLEN);
+              ret = nxffs_addspan(pack, owner, object.next, false, stale);
+              if (ret < 0)
+                {
+                  return ret;
+                }
+            }
+        }
+      else
+        {
+          if (object.type == NXFFS_OBJ_WRITER)
+            {
+              objstart = wrfile->ofile.entry.hoffset;
+              whole    = true;
+            }
+          else
+            {
+              objstart = object.entry.hoffset;
+              whole    = (object.type == NXFFS_OBJ_INODE &&
+                          nxffs_packlive(volume, objstart));
+              nxffs_freeentry(&object.entry);
+            }
 
-      inode->state  = CONFIG_NXFFS_ERASEDSTATE;
-      inode->namlen = namlen;
+          untagged = objstart;
+          if (objstart < limit)
+            {
+              ret = nxffs_addspan(pack, objstart, object.next, whole,
+                                  false);
+              if (ret < 0)
+                {
+                  return ret;
+                }
+            }
+        }
 
-      /* Calculate the CRC */
+      /* The region can only end at the beginning of an object */
 
-      crc = crc32((FAR const uint8_t *)inode, SIZEOF_NXFFS_INODE_HDR);
-      crc = crc32part((FAR const uint8_t *)pack->dest.entry.name, namlen, crc);
+      if (objstart <= limit)
+        {
+          bound = objstart;
+        }
 
-      /* Finish the inode header */
+      offset = object.next;
+    }
 
-      inode->state = INODE_STATE_FILE;
-      nxffs_wrle32(inode->crc, crc);
+  if (ret != -ENOENT && ret != -ENOSPC)
+    {
+      fdbg("ERROR: Failed to find the next object: %d\n", -ret);
+      return ret;
+    }
 
-      /* If any open files reference this inode, then update the open file
-       * state.
-       */
+  /* Then end the region before any inode header that must be moved as a
+   * whole but owns data beyond the end of the region.  Going backward, each
+   * inode header only has to be checked against the end selected by the
+   * ones that follow it.
+   */
 
-      ret = nxffs_updateinode(volume, &pack->dest.entry);
-      if (ret < 0)
+  for (i = pack->nspan; i > 0; i--)
+    {
+      span = &pack->span[i - 1];
+      if (span->whole && span->hoffset < bound && span->last > bound)
         {
-          fdbg("ERROR: Failed to update inode info: %s\n", -ret);
+          bound = span->hoffset;
         }
     }
 
-  /* Reset the dest inode information */
-
-  nxffs_freeentry(&pack->dest.entry);
-  memset(&pack->dest, 0, sizeof(struct nxffs_packstream_s));
-  return ret;
+  pack->end = bound;
+  return OK;
 }
 
 /****************************************************************************
- * Name: nxffs_wrdatthdr
+ * Name: nxffs_packskip
  *
  * Description:
- *   Write the destination data block header to FLASH.
+ *   An incremental pack step cannot move the inode header at hoffset.
+ *   Return the position after which packing may begin instead:  After the
+ *   inode header and name, after the first data block (moving that would
+ *   require the inode header to be rewritten), and after any untagged data
+ *   blocks that follow (those must stay behind their inode header).
  *
  * Input Parameters:
- *   volume - The volume to be packed
- *   pack   - The volume packing state structure.
+ *   volume  - The volume to be packed.
+ *   hoffset - The FLASH offset to the inode header.
+ *   from    - The location to return the new starting position.
  *
  * Returned Values:
  *   Zero on success; Otherwise, a negated errno value is returned to
@@ -737,98 +917,147 @@ static int nxffs_wrinodehdr(FAR struct nxffs_volume_s *volume,
  *
  ****************************************************************************/
 
-static void nxffs_wrdathdr(FAR struct nxffs_volume_s *volume,
-                           FAR struct nxffs_pack_s *pack)
+static int nxffs_packskip(FAR struct nxffs_volume_s *volume, off_t hoffset,
+                          FAR off_t *from)
 {
-  FAR struct nxffs_data_s *dathdr;
-  off_t    ioblock;
-  uint16_t iooffset;
-  uint32_t crc;
+  struct nxffs_object_s object;
+  FAR struct nxffs_wrfile_s *wrfile;
+  off_t offset;
+  off_t doffset = -1;
+  size_t ndx;
+  int ret;
 
-  if (pack->dest.blklen > 0)
+  ret = nxffs_packobject(volume, hoffset, volume->froffset, &object,
+                         &wrfile);
+  if (ret < 0)
     {
-      /* Get the offset in the block corresponding to the location of the data
-       * block header.  NOTE:  This must lie in the same block as we currently have
-       * buffered.
-       */
+      return ret;
+    }
 
-      ioblock  = nxffs_getblock(volume, pack->dest.blkoffset);
-      iooffset = nxffs_getoffset(volume, pack->dest.blkoffset, ioblock);
-      DEBUGASSERT(pack->dest.blkoffset && ioblock == pack->ioblock);
+  if (object.type == NXFFS_OBJ_INODE || object.type == NXFFS_OBJ_DELETED)
+    {
+      nxffs_freeentry(&object.entry);
+    }
 
-      /* Write the data block header to memory */
+  offset = object.next;
 
-      dathdr = (FAR struct nxffs_data_s *)&pack->iobuffer[iooffset];
-      memcpy(dathdr->magic, g_datamagic, NXFFS_MAGICSIZE);
-      nxffs_wrle32(dathdr->crc, 0);
-      nxffs_wrle16(dathdr->datlen, pack->dest.blklen);
+  ndx = nxffs_findindex(volume, hoffset);
+  if (ndx < volume->ninodes && volume->index[ndx].hoffset == hoffset &&
+      volume->index[ndx].doffset > 0)
+    {
+      doffset = volume->index[ndx].doffset;
+      offset  = doffset;
+    }
 
-      /* Update the entire data block CRC (including the header) */
+  while ((ret = nxffs_packobject(volume, offset, volume->froffset,
+                                 &object, &wrfile)) == OK)
+    {
+      if (object.type != NXFFS_OBJ_DATA)
+        {
+          if (object.type != NXFFS_OBJ_WRITER)
+            {
+              nxffs_freeentry(&object.entry);
+            }
 
-      crc = crc32(&pack->iobuffer[iooffset], pack->dest.blklen + SIZEOF_NXFFS_DATA_HDR);
-      nxffs_wrle32(dathdr->crc, crc);
+          break;
+        }
+
+      if (object.blkentry.owner != 0 && object.blkentry.hoffset != doffset)
+        {
+          break;
+        }
+
+      offset = object.next;
     }
 
-  /* Setup state to allocate the next data block */
+  if (ret < 0 && ret != -ENOENT && ret != -ENOSPC)
+    {
+      return ret;
+    }
 
-  pack->dest.blkoffset = 0;
-  pack->dest.blklen    = 0;
-  pack->dest.blkpos    = 0;
+  *from = offset;
+  return OK;
 }
 
 /****************************************************************************
- * Name: nxffs_packtransfer
+ * Name: nxffs_packread
  *
  * Description:
- *   Transfer data from the source to the destination buffer.
+ *   Read the erase block that contains pack->ioblock into the pack buffer.
  *
  * Input Parameters:
  *   volume - The volume to be packed
  *   pack   - The volume packing state structure.
  *
  * Returned Values:
- *   None.
+ *   Zero on success; Otherwise, a negated errno value is returned to
+ *   indicate the nature of the failure.
  *
  ****************************************************************************/
 
-static void nxffs_packtransfer(FAR struct nxffs_volume_s *volume,
-                               FAR struct nxffs_pack_s *pack)
+static int nxffs_packread(FAR struct nxffs_volume_s *volume,
+                          FAR struct nxffs_pack_s *pack)
 {
-   /* Determine how much data is available in the dest pack buffer */
+  int ret;
+#ifdef CONFIG_NXFFS_NAND
+  FAR uint8_t *iobuffer;
+  off_t block;
+  int i;
+#endif
 
-   uint16_t destlen = volume->geo.blocksize - pack->iooffset;
+  pack->block0   = (pack->ioblock / volume->blkper) * volume->blkper;
+  pack->iobuffer = &volume->pack[(pack->ioblock - pack->block0) *
+                                 volume->geo.blocksize];
 
-   /* Dermined how much data is available in the src data block */
+#ifndef CONFIG_NXFFS_NAND
+  /* Read the erase block into the pack buffer.  We need to do this even
+   * if we are overwriting the entire block so that we skip over
+   * previously marked bad blocks.
+   */
 
-   uint16_t srclen = pack->src.blklen - pack->src.blkpos;
+  ret = MTD_BREAD(volume->mtd, pack->block0, volume->blkper, volume->pack);
+  if (ret < 0)
+    {
+      fdbg("ERROR: Failed to read erase block %d: %d\n",
+           pack->block0 / volume->blkper, -ret);
+      return ret;
+    }
 
-   /* Transfer the smaller of the two amounts data */
+#else
+  /* Read the entire erase block into the pack buffer, one-block-at-a-
+   * time.  We need to do this even if we are overwriting the entire
+   * block so that (1) we skip over previously marked bad blocks, and
+   * (2) we can handle individual block read failures.
+   *
+   * For most FLASH, a read failure indicates a fatal hardware failure.
+   * But for NAND FLASH, the read failure probably indicates a block
+   * with uncorrectable bit errors.
+   */
 
-   uint16_t xfrlen = MIN(srclen, destlen);
-   if (xfrlen > 0)
-     {
-       nxffs_ioseek(volume, pack->src.blkoffset + SIZEOF_NXFFS_DATA_HDR + pack->src.blkpos);
-       memcpy(&pack->iobuffer[pack->iooffset], &volume->cache[volume->iooffset], xfrlen);
+  for (i = 0, block = pack->block0, iobuffer = volume->pack;
+       i < volume->blkper;
+       i++, block++, iobuffer += volume->geo.blocksize)
+    {
+      ret = MTD_BREAD(volume->mtd, block, 1, iobuffer);
+      if (ret < 0)
+        {
+          /* Force a the block to be an NXFFS bad block */
 
-       /* Increment counts and offset for this data transfer */
+          fdbg("ERROR: Failed to read block %d: %d\n", block, ret);
+          nxffs_blkinit(volume, iobuffer, BLOCK_STATE_BAD);
+        }
+    }
+#endif
 
-       pack->src.fpos    += xfrlen; /* Source data offsets */
-       pack->src.blkpos  += xfrlen;
-       pack->dest.fpos   += xfrlen; /* Destination data offsets */
-       pack->dest.blkpos += xfrlen;
-       pack->dest.blklen += xfrlen; /* Destination data block size */
-       pack->iooffset    += xfrlen; /* Destination I/O block offset */
-       volume->iooffset  += xfrlen; /* Source I/O block offset */
-       volume->froffset  += xfrlen; /* Free FLASH offset */
-     }
+  return OK;
 }
 
 /****************************************************************************
- * Name: nxffs_endsrcblock
+ * Name: nxffs_packwrite
  *
  * Description:
- *   The end of a source data block has been encountered.  Locate the next
- *   source block and setup to continue the transfer.
+ *   Erase the erase block in the pack buffer and write the pack buffer back
+ *   to FLASH.
  *
  * Input Parameters:
  *   volume - The volume to be packed
@@ -840,294 +1069,218 @@ static void nxffs_packtransfer(FAR struct nxffs_volume_s *volume,
  *
  ****************************************************************************/
 
-static int nxffs_endsrcblock(FAR struct nxffs_volume_s *volume,
-                             FAR struct nxffs_pack_s *pack)
+static int nxffs_packwrite(FAR struct nxffs_volume_s *volume,
+                           FAR struct nxffs_pack_s *pack)
 {
-  struct nxffs_blkentry_s blkentry;
-  off_t offset;
+  off_t eblock = pack->block0 / volume->blkper;
   int ret;
 
-  /* Yes.. find the next data block in the source input stream. */
+  ret = MTD_ERASE(volume->mtd, eblock, 1);
+  if (ret < 0)
+    {
+      fdbg("ERROR: Failed to erase block %d [%d]: %d\n",
+           eblock, pack->block0, -ret);
+      return ret;
+    }
 
-  offset = pack->src.blkoffset + SIZEOF_NXFFS_DATA_HDR + pack->src.blklen;
-  ret    = nxffs_nextblock(volume, offset, &blkentry);
+  volume->stats.ps_nerases++;
+
+  ret = MTD_BWRITE(volume->mtd, pack->block0, volume->blkper, volume->pack);
   if (ret < 0)
     {
-      fdbg("ERROR: Failed to find next data block: %d\n", -ret);
+      fdbg("ERROR: Failed to write erase block %d [%d]: %d\n",
+           eblock, pack->block0, -ret);
       return ret;
     }
 
-  /* Set up the source stream */
+  /* The cached block (if any) in that erase block is now stale */
+
+  if (volume->cblock >= pack->block0 &&
+      volume->cblock < pack->block0 + volume->blkper)
+    {
+      volume->cblock = -1;
+    }
 
-  pack->src.blkoffset = blkentry.hoffset;
-  pack->src.blklen    = blkentry.datlen;
-  pack->src.blkpos    = 0;
   return OK;
 }
 
 /****************************************************************************
- * Name: nxffs_packblock
+ * Name: nxffs_wrdathdr
  *
  * Description:
- *   Resume packing from the source stream into the newly identified
- *   destination block.
+ *   Finish the destination data block:  Write the data block header into
+ *   the pack buffer.
  *
  * Input Parameters:
  *   volume - The volume to be packed
  *   pack   - The volume packing state structure.
  *
  * Returned Values:
- *   Zero on success; Otherwise, a negated errno value is returned to
- *   indicate the nature of the failure.
+ *   None.
  *
  ****************************************************************************/
 
-static inline int nxffs_packblock(FAR struct nxffs_volume_s *volume,
-                                  FAR struct nxffs_pack_s *pack)
+static void nxffs_wrdathdr(FAR struct nxffs_volume_s *volume,
+                           FAR struct nxffs_pack_s *pack)
 {
-  off_t offset;
-  int ret;
-
-  /* Are we currently processing a block from the source stream? */
+  FAR struct nxffs_data_s *dathdr;
+  off_t    ioblock;
+  uint16_t iooffset;
+  uint32_t crc;
 
-  if (pack->src.blkoffset == 0)
+  if (pack->datoffset > 0)
     {
-      /* No.. setup the source stream */
+      /* Get the offset in the block corresponding to the location of the
+       * data block header.  NOTE:  This must lie in the same block as we
+       * currently have buffered.
+       */
 
-      ret = nxffs_srcsetup(volume, pack, pack->src.entry.doffset);
-      if (ret < 0)
-        {
-          fdbg("ERROR: Failed to configure the src stream: %d\n", -ret);
-          return ret;
-        }
-    }
+      ioblock  = nxffs_getblock(volume, pack->datoffset);
+      iooffset = nxffs_getoffset(volume, pack->datoffset, ioblock);
+      DEBUGASSERT(ioblock == pack->ioblock);
 
-  /* We enter here on a new block every time, so we always have to setup
-   * the dest data stream.  There should never be data block allocated at
-   * this point in time.
-   */
+      /* Write the data block header to memory */
 
-  DEBUGASSERT(pack->dest.blkoffset == 0 && pack->dest.blkpos == 0);
+      dathdr = (FAR struct nxffs_data_s *)&pack->iobuffer[iooffset];
+      memcpy(dathdr->magic, g_tagmagic, NXFFS_MAGICSIZE);
+      nxffs_wrle32(dathdr->crc, 0);
+      nxffs_wrle16(dathdr->datlen, pack->datlen);
+      nxffs_wrle32(dathdr->owner, pack->datowner);
 
-  ret = nxffs_destsetup(volume, pack);
-  if (ret < 0)
-    {
-      /* -ENOSPC is a special return value which simply means that all of
-       * the FLASH has been used up to the end of the current.  We need to
-       * return OK in this case and resume at the next block.
-       */
+      /* Update the entire data block CRC (including the header) */
 
-      if (ret == -ENOSPC)
-        {
-          return OK;
-        }
-      else
-        {
-          fdbg("ERROR: Failed to configure the dest stream: %d\n", -ret);
-          return ret;
-        }
+      crc = crc32(&pack->iobuffer[iooffset],
+                  pack->datlen + SIZEOF_NXFFS_DATA_HDR);
+      nxffs_wrle32(dathdr->crc, crc);
     }
 
-  /* Loop, transferring data from the source block to the destination pack
-   * buffer until either (1) the source stream is exhausted, (2) the destination
-   * block is full, or (3) an error occurs.
-   */
-
-  for (;;)
-    {
-      /* Transfer data from the source buffer to the destination buffer */
+  /* Setup state to allocate the next data block */
 
-      nxffs_packtransfer(volume, pack);
+  pack->datoffset = 0;
+  pack->datlen    = 0;
+}
 
-      /* Now, either the (1) src block has been fully transferred, (2) all
-       * of the source data has been transferred, or (3) the destination
-       * block is full, .. or all three.
-       *
-       * Check if all of the bytes in the source inode have been transferred.
-       */
+/****************************************************************************
+ * Name: nxffs_packnext
+ *
+ * Description:
+ *   Finish the current destination block and move to the beginning of the
+ *   next valid block, writing the pack buffer to FLASH when the end of the
+ *   erase block is reached.
+ *
+ * Input Parameters:
+ *   volume - The volume to be packed
+ *   pack   - The volume packing state structure.
+ *
+ * Returned Values:
+ *   Zero on success; Otherwise, a negated errno value is returned to
+ *   indicate the nature of the failure.
+ *
+ ****************************************************************************/
 
-      if (pack->src.fpos >= pack->src.entry.datlen)
-        {
-          /* Write the final destination data block header and inode
-           * headers.
-           */
+static int nxffs_packnext(FAR struct nxffs_volume_s *volume,
+                          FAR struct nxffs_pack_s *pack)
+{
+  int ret;
 
-          nxffs_wrdathdr(volume, pack);
-          nxffs_wrinodehdr(volume, pack);
+  nxffs_wrdathdr(volume, pack);
 
-          /* Find the next valid source inode */
+  do
+    {
+      /* Anything left at the end of the block is no longer used */
 
-          offset = pack->src.blkoffset + pack->src.blklen;
-          memset(&pack->src, 0, sizeof(struct nxffs_packstream_s));
+      if (nxffs_packvalid(pack) && pack->iooffset < volume->geo.blocksize)
+        {
+          memset(&pack->iobuffer[pack->iooffset], CONFIG_NXFFS_ERASEDSTATE,
+                 volume->geo.blocksize - pack->iooffset);
+        }
 
-          ret = nxffs_nextentry(volume, offset, &pack->src.entry);
-          if (ret < 0)
-            {
-              /* No more valid inode entries.  Just return an end-of-flash error
-               * indication.
-               */
+      pack->ioblock++;
+      pack->iooffset = SIZEOF_NXFFS_BLOCK_HDR;
 
-              return -ENOSPC;
-            }
+      /* The packed data can never be larger than the source data */
 
-          /* Setup the new source stream */
+      DEBUGASSERT(pack->ioblock < volume->nblocks);
+      if (pack->ioblock >= volume->nblocks)
+        {
+          return -ENOSPC;
+        }
 
-          ret = nxffs_srcsetup(volume, pack, pack->src.entry.doffset);
+      if (pack->ioblock >= pack->block0 + volume->blkper)
+        {
+          ret = nxffs_packwrite(volume, pack);
           if (ret < 0)
             {
               return ret;
             }
 
-          /* Setup the dest stream */
-
-          memset(&pack->dest, 0, sizeof(struct nxffs_packstream_s));
-          pack->dest.entry.name   = pack->src.entry.name;
-          pack->dest.entry.utc    = pack->src.entry.utc;
-          pack->dest.entry.datlen = pack->src.entry.datlen;
-          pack->src.entry.name    = NULL;
-
-          /* Is there sufficient space at the end of the I/O block to hold
-           * the inode header?
-           */
-
-          if (pack->iooffset + SIZEOF_NXFFS_INODE_HDR > volume->geo.blocksize)
-            {
-              /* No, just return success... we will handle this condition when
-               * this function is called on the next I/O block.
-               */
-
-              return OK;
-            }
-
-          /* Configure the destination stream */
-
-          ret = nxffs_destsetup(volume, pack);
+          ret = nxffs_packread(volume, pack);
           if (ret < 0)
             {
-              /* -ENOSPC is a special return value which simply means that all of the
-               * has been used up to the end.  We need to return OK in this case and
-               * resume at the next block.
-               */
-
-              if (ret == -ENOSPC)
-                {
-                  return OK;
-                }
-              else
-                {
-                  fdbg("ERROR: Failed to configure the dest stream: %d\n", -ret);
-                  return ret;
-                }
+              return ret;
             }
         }
-
-      /* Not at the end of the source data stream.  Check if we are at the
-       * end of the current source data block.
-       */
-
-      else if (pack->src.blkpos >= pack->src.blklen)
+      else
         {
-          ret = nxffs_endsrcblock(volume, pack);
-          if (ret < 0)
-            {
-              return ret;
-            }
+          pack->iobuffer += volume->geo.blocksize;
         }
-
-     /* Check if the destination block is full */
-
-     if (pack->iooffset >= volume->geo.blocksize)
-       {
-         /* Yes.. Write the destination data block header and return success */
-
-         nxffs_wrdathdr(volume, pack);
-         return OK;
-       }
     }
+  while (!nxffs_packvalid(pack));
 
-  return -ENOSYS;
+  return OK;
 }
 
 /****************************************************************************
- * Name: nxffs_setupwriter
+ * Name: nxffs_packreserve
  *
  * Description:
- *   Writing is performed at the end of the free FLASH region.  When we
- *   finish packing the other inodes, we still need to pack the partially
- *   written file at the end of FLASH.  This function performs the setup
- *   necessary to perform that packing phase.
+ *   Reserve space for an object in the destination.  The object is not
+ *   split across blocks.
  *
  * Input Parameters:
  *   volume - The volume to be packed
  *   pack   - The volume packing state structure.
+ *   size   - The size of the object
+ *   offset - The location to return FLASH offset to the object.
  *
  * Returned Values:
- *   If there is an active writer of the volume, its open file instance is
- *   returned.  NULL is returned otherwise.
+ *   Zero on success; Otherwise, a negated errno value is returned to
+ *   indicate the nature of the failure.
  *
  ****************************************************************************/
 
-static FAR struct nxffs_wrfile_s *
-nxffs_setupwriter(FAR struct nxffs_volume_s *volume,
-                  FAR struct nxffs_pack_s *pack)
+static int nxffs_packreserve(FAR struct nxffs_volume_s *volume,
+                             FAR struct nxffs_pack_s *pack, size_t size,
+                             FAR off_t *offset)
 {
-  FAR struct nxffs_wrfile_s *wrfile;
-
-  /* Is there a writer? */
+  int ret;
 
-  wrfile = nxffs_findwriter(volume);
-  if (wrfile)
+  if (pack->iooffset + size > volume->geo.blocksize)
     {
-      /* Yes...  It is the activity of this write that probably initiated
-       * this packing activity.  The writer may have failed in one of several
-       * different stages:
-       *
-       *   hoffset == 0: The write failed early before even FLASH for the inode
-       *     header was set aside.
-       *   noffset == 0: The write failed after the inode header was set aside,
-       *     but before the inode name was written.
-       *   doffset == 0: The write failed after writing the inode name, bue
-       *     before any data blocks were written to FLASH.
-       *
-       * If no FLASH has been set aside for the write, then we don't need to
-       * do anything here.
-       */
-
-      if (wrfile->ofile.entry.hoffset > 0)
+      ret = nxffs_packnext(volume, pack);
+      if (ret < 0)
         {
-          /* Initialize for the packing operation. */
-
-           memset(&pack->dest, 0, sizeof(struct nxffs_packstream_s));
-           pack->dest.entry.name   = strdup(wrfile->ofile.entry.name);
-           pack->dest.entry.utc    = wrfile->ofile.entry.utc;
-           pack->dest.entry.datlen = wrfile->ofile.entry.datlen;
-
-           memset(&pack->src, 0, sizeof(struct nxffs_packstream_s));
-           memcpy(&pack->src.entry, &wrfile->ofile.entry, sizeof(struct nxffs_entry_s));
-           pack->src.entry.name    = NULL;
-           return wrfile;
+          return ret;
         }
     }
 
-  return NULL;
+  *offset = nxffs_packtell(volume, pack);
+  return OK;
 }
 
 /****************************************************************************
- * Name: nxffs_packwriter
+ * Name: nxffs_packhdr
  *
  * Description:
- *   There is a write in progress at the time that the volume is packed.
- *   This is the normal case because it is the write failures that trigger
- *   the packing operation to begin with.
- *
- *   Writing is performed at the end of the free FLASH region and this
- *   implemenation is restricted to a single writer.  The new inode is not
- *   written to FLASH until the writer is closed and so will not be
- *   found by nxffs_packblock().
+ *   Relocate an inode header and its name.  Only the name is copied; the
+ *   inode header itself is written later by nxffs_wrinodehdr() (or by the
+ *   writer when the file is closed) when the first data block position is
+ *   known.
  *
  * Input Parameters:
  *   volume - The volume to be packed
  *   pack   - The volume packing state structure.
+ *   entry  - The inode entry.  The new offsets are returned here.
  *
  * Returned Values:
  *   Zero on success; Otherwise, a negated errno value is returned to
@@ -1135,131 +1288,195 @@ nxffs_setupwriter(FAR struct nxffs_volume_s *volume,
  *
  ****************************************************************************/
 
-static inline int nxffs_packwriter(FAR struct nxffs_volume_s *volume,
-                                   FAR struct nxffs_pack_s *pack,
-                                   FAR struct nxffs_wrfile_s *wrfile)
+static int nxffs_packhdr(FAR struct nxffs_volume_s *volume,
+                         FAR struct nxffs_pack_s *pack,
+                         FAR struct nxffs_entry_s *entry)
 {
+  FAR struct nxffs_packspan_s *span;
+  size_t namlen = strlen(entry->name);
   int ret;
 
-  /* Are we currently processing a block from the source stream? */
+  nxffs_wrdathdr(volume, pack);
 
-  if (pack->src.blkoffset == 0)
-    {
-      /* No.. setup the source stream */
+  /* Reserve (and erase) the inode header.  Skip over any position that is
+   * still named by data blocks left in FLASH by an incremental pack step;
+   * those data blocks would otherwise appear to belong to this inode.
+   */
 
-      ret = nxffs_srcsetup(volume, pack, pack->src.entry.doffset);
+  for (;;)
+    {
+      ret = nxffs_packreserve(volume, pack, SIZEOF_NXFFS_INODE_HDR,
+                              &entry->hoffset);
       if (ret < 0)
         {
-          fdbg("ERROR: Failed to configure the src stream: %d\n", -ret);
           return ret;
         }
+
+      span = nxffs_findspan(pack, entry->hoffset);
+      if (!span || (span->last <= pack->end && !span->stale))
+        {
+          break;
+        }
+
+      pack->iobuffer[pack->iooffset++] = NXFFS_FILLSTATE;
     }
 
-  /* We enter here on a new block every time, so we always have to setup
-   * the dest data stream.  There should never be data block allocated at
-   * this point in time.
-   */
+  memset(&pack->iobuffer[pack->iooffset], CONFIG_NXFFS_ERASEDSTATE,
+         SIZEOF_NXFFS_INODE_HDR);
+  pack->iooffset += SIZEOF_NXFFS_INODE_HDR;
 
-  DEBUGASSERT(pack->dest.blkoffset == 0 && pack->dest.blkpos == 0);
+  /* Then copy the name */
 
-  ret = nxffs_destsetup(volume, pack);
+  ret = nxffs_packreserve(volume, pack, namlen, &entry->noffset);
   if (ret < 0)
     {
-      /* -ENOSPC is a special return value which simply means that all of the
-       * has been used up to the end.  We need to return OK in this case and
-       * resume at the next block.
-       */
-
-      if (ret == -ENOSPC)
-        {
-          return OK;
-        }
-      else
-        {
-          fdbg("ERROR: Failed to configure the dest stream: %d\n", -ret);
-          return ret;
-        }
+      return ret;
     }
 
-  /* Loop, transferring data from the source block to the destination pack
-   * buffer until either (1) the source stream is exhausted, (2) the destination
-   * block is full, or (3) an error occurs.
+  memcpy(&pack->iobuffer[pack->iooffset], entry->name, namlen);
+  pack->iooffset += namlen;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: nxffs_wrinodehdr
+ *
+ * Description:
+ *   Write the relocated inode header.
+ *
+ * Input Parameters:
+ *   volume - The volume to be packed
+ *   pack   - The volume packing state structure.
+ *   map    - Describes the relocated inode header
+ *
+ * Returned Values:
+ *   Zero on success; Otherwise, a negated errno value is returned to
+ *   indicate the nature of the failure.
+ *
+ ****************************************************************************/
+
+static int nxffs_wrinodehdr(FAR struct nxffs_volume_s *volume,
+                            FAR struct nxffs_pack_s *pack,
+                            FAR struct nxffs_packmap_s *map)
+{
+  FAR struct nxffs_inode_s *inode;
+  off_t ioblock;
+  uint16_t iooffset;
+  uint32_t crc;
+  size_t ndx;
+  int namlen;
+  int ret = OK;
+
+  /* Get seek positions corresponding to the inode header location */
+
+  ioblock  = nxffs_getblock(volume, map->entry.hoffset);
+  iooffset = nxffs_getoffset(volume, map->entry.hoffset, ioblock);
+
+  /* The inode header is not written until the first data block has been
+   * packed into its new location.  As a result, there are two
+   * possibilities:
+   *
+   * 1. The inode header lies in the current, unwritten erase block,
+   * 2. The inode header resides in an earlier erase block and has already
+   *    been written to FLASH.
+   *
+   * Recall that the inode name has already been written to FLASH.  If that
+   * were not the case, then there would be other complex possibilities.
    */
 
-  for (;;)
+  if (ioblock < pack->block0)
     {
-       /* Transfer data from the source buffer to the destination buffer */
+      /* Case 2:  The inode header lies in an earlier erase block that has
+       * already been written to FLASH.  In this case, if we are very
+       * careful, we can just use the standard routine to write the inode
+       * header that is called during the normal file close operation:
+       */
 
-       nxffs_packtransfer(volume, pack);
+      ret = nxffs_wrinode(volume, &map->entry);
+    }
+  else
+    {
+      /* Cases 1:  Both the inode header and name are in the unwritten cache
+       * memory.
+       *
+       * Initialize the inode header.
+       */
 
-       /* Now, either the (1) src block has been fully transferred, (2) all
-        * of the source data has been transferred, or (3) the destination
-        * block is full, .. or all three.
-        *
-        * Check if all of the bytes in the source inode have been transferred.
-        */
+      iooffset += (ioblock - pack->block0) * volume->geo.blocksize;
+      inode     = (FAR struct nxffs_inode_s *)&volume->pack[iooffset];
+      memcpy(inode->magic, g_inodemagic, NXFFS_MAGICSIZE);
 
-       if (pack->src.fpos >= pack->src.entry.datlen)
-         {
-           /* Write the final destination data block header and inode
-            * headers.
-            */
+      nxffs_wrle32(inode->noffs,  map->entry.noffset);
+      nxffs_wrle32(inode->doffs,  map->entry.doffset);
+      nxffs_wrle32(inode->utc,    map->entry.utc);
+      nxffs_wrle32(inode->crc,    0);
+      nxffs_wrle32(inode->datlen, map->entry.datlen);
 
-           nxffs_wrdathdr(volume, pack);
+      /* Get the length of the inode name */
 
-           /* Set the new offsets in the open file instance. */
+      namlen = strlen(map->entry.name);
+      DEBUGASSERT(namlen < CONFIG_NXFFS_MAXNAMLEN);
 
-           wrfile->ofile.entry.hoffset = pack->dest.entry.hoffset;
-           wrfile->ofile.entry.noffset = pack->dest.entry.noffset;
-           wrfile->ofile.entry.doffset = pack->dest.entry.doffset;
+      inode->state  = CONFIG_NXFFS_ERASEDSTATE;
+      inode->namlen = namlen;
 
-           /* Return an end-of-flash error to indicate that all of the write
-            * data has been transferred.
-            */
+      /* Calculate the CRC */
 
-           return -ENOSPC;
-         }
+      crc = crc32((FAR const uint8_t *)inode, SIZEOF_NXFFS_INODE_HDR);
+      crc = crc32part((FAR const uint8_t *)map->entry.name, namlen, crc);
 
-      /* Not at the end of the source data stream.  Check if we are at the
-       * end of the current source data block.
-       */
+      /* Finish the inode header */
 
-      else if (pack->src.blkpos >= pack->src.blklen)
-        {
-          ret = nxffs_endsrcblock(volume, pack);
-          if (ret < 0)
-            {
-              return ret;
-            }
-        }
+      inode->state = INODE_STATE_FILE;
+      nxffs_wrle32(inode->crc, crc);
+    }
+
+  if (ret < 0)
+    {
+      fdbg("ERROR: Failed to write inode header: %d\n", -ret);
+      return ret;
+    }
 
-     /* Check if the destination block is full */
+  /* The index entry already refers to the new inode header position; now
+   * the position of the first data block is known as well.
+   */
+
+  ndx = nxffs_findindex(volume, map->entry.hoffset);
+  DEBUGASSERT(ndx < volume->ninodes &&
+              volume->index[ndx].hoffset == map->entry.hoffset);
+  volume->index[ndx].doffset = map->entry.doffset;
 
-     if (pack->iooffset >= volume->geo.blocksize)
-       {
-         /* Yes.. Write the destination data block header and return success */
+  /* Open files that reference this inode were already moved to the new
+   * inode header position.  Now update the position of the first data
+   * block as well.
+   */
 
-         nxffs_wrdathdr(volume, pack);
-         return OK;
-       }
+  ret = nxffs_updateinode(volume, map->entry.hoffset, &map->entry);
+  if (ret < 0)
+    {
+      fdbg("ERROR: Failed to update inode info: %d\n", -ret);
     }
 
-  return -ENOSYS;
+  map->pending = false;
+  nxffs_freeentry(&map->entry);
+  return ret;
 }
 
 /****************************************************************************
- * Public Functions
- ****************************************************************************/
-
-/****************************************************************************
- * Name: nxffs_pack
+ * Name: nxffs_packdata
  *
  * Description:
- *   Pack and re-write the filesystem in order to free up memory at the end
- *   of FLASH.
+ *   Copy the data of one tagged data block to the destination.  The data is
+ *   appended to the destination data block if that belongs to the same
+ *   inode and split across blocks as necessary.
  *
  * Input Parameters:
- *   volume - The volume to be packed.
+ *   volume   - The volume to be packed
+ *   pack     - The volume packing state structure.
+ *   blkentry - Describes the source data block
+ *   owner    - The new FLASH offset to the owning inode header
+ *   doffset  - If non-NULL, this is the first data block of the inode and
+ *              the offset to the new data block header is returned here.
  *
  * Returned Values:
  *   Zero on success; Otherwise, a negated errno value is returned to
@@ -1267,341 +1484,951 @@ static inline int nxffs_packwriter(FAR struct nxffs_volume_s *volume,
  *
  ****************************************************************************/
 
-int nxffs_pack(FAR struct nxffs_volume_s *volume)
+static int nxffs_packdata(FAR struct nxffs_volume_s *volume,
+                          FAR struct nxffs_pack_s *pack,
+                          FAR struct nxffs_blkentry_s *blkentry,
+                          off_t owner, FAR off_t *doffset)
 {
-  struct nxffs_pack_s pack;
-  FAR struct nxffs_wrfile_s *wrfile;
-  off_t iooffset;
-  off_t eblock;
-  off_t block;
-  bool packed;
-  int i;
-  int ret = OK;
-
-  /* Get the offset to the first valid inode entry */
+  off_t srcoffset = blkentry->hoffset + blkentry->hdrlen;
+  uint16_t remaining = blkentry->datlen;
+  uint16_t xfrlen;
+  int ret;
 
-  wrfile = NULL;
-  packed = false;
+  /* The first data block of an inode is never merged with a preceding
+   * data block.
+   */
 
-  iooffset = nxffs_mediacheck(volume, &pack);
-  if (iooffset == 0)
+  if (doffset || pack->datowner != owner)
     {
-      /* Offset zero is only returned if no valid blocks were found on the
-       * FLASH media or if there are no valid inode entries on the FLASH after
-       * the first valid block.  There are two possibilities:  (1) there
-       * really is nothing on the FLASH, or (2) there is a file being written
-       * to the FLASH now.
-       */
-
-      /* Is there a writer? */
+      nxffs_wrdathdr(volume, pack);
+    }
 
-      wrfile = nxffs_setupwriter(volume, &pack);
-      if (wrfile)
+  while (remaining > 0)
+    {
+      if (pack->datoffset == 0)
         {
-          /* If there is a write, just set ioffset to the offset of data in
-           * first block. Setting 'packed' to true will supress normal inode
-           * packing operation.  Then we can start compacting the FLASH.
+          /* Start a new data block.  Make sure that there is space for the
+           * header and a meaningful amount of data.
            */
 
-          iooffset = SIZEOF_NXFFS_BLOCK_HDR;
-          packed   = true;
-          goto start_pack;
-        }
-      else
-        {
-          /* No, there is no write in progress.  We just have an empty flash
-           * full of deleted files.  In this case, the media needs to be re-
-           * formatted.
-            */
-
-          ret = nxffs_reformat(volume);
-          if (ret == OK)
+          if (pack->iooffset + SIZEOF_NXFFS_DATA_HDR +
+              MIN(NXFFS_MINDATA, remaining) > volume->geo.blocksize)
             {
-              /* The free flash offset will be in the first valid block of
-               * the FLASH.
-               */
-
-              block = 0;
-              ret = nxffs_validblock(volume, &block);
-              if (ret == OK)
+              ret = nxffs_packnext(volume, pack);
+              if (ret < 0)
                 {
-                  /* Set to the offset past the block header in the first
-                   * valid block
-                   */
-
-                  volume->froffset =
-                    block * volume->geo.blocksize + SIZEOF_NXFFS_BLOCK_HDR;
+                  return ret;
                 }
             }
 
-          return ret;
-        }
-    }
+          pack->datoffset = nxffs_packtell(volume, pack);
+          pack->datowner  = owner;
+          pack->datlen    = 0;
+          pack->iooffset += SIZEOF_NXFFS_DATA_HDR;
 
-  /* There is a valid format and valid inodes on the media.. setup up to
-   * begin the packing operation.
-   */
+          if (doffset)
+            {
+              *doffset = pack->datoffset;
+              doffset  = NULL;
+            }
+        }
 
-  ret = nxffs_startpos(volume, &pack, &iooffset);
-  if (ret < 0)
-    {
-      /* This is a normal situation if the volume is full */
+      /* Copy as much as fits in this block */
 
-      if (ret == -ENOSPC)
+      xfrlen = MIN(remaining, volume->geo.blocksize - pack->iooffset);
+      if (xfrlen == 0)
         {
-          /* In the case where the volume is full, nxffs_startpos() will
-           * recalculate the free FLASH offset and store it in iooffset.  There
-           * may be deleted files at the end of FLASH.  In this case, we don't
-           * have to pack any files, we simply have to erase FLASH at the end.
-           * But don't do this unless there is some particularly big FLASH
-           * savings (otherwise, we risk wearing out these final blocks).
-           */
-
-          if (iooffset + CONFIG_NXFFS_TAILTHRESHOLD < volume->froffset)
+          ret = nxffs_packnext(volume, pack);
+          if (ret < 0)
             {
-               /* Setting 'packed' to true will supress normal inode packing
-                * operation.
-                */
-
-               packed = true;
-
-               /* Writing is performed at the end of the free FLASH region.
-                * If we are not packing files, we could still need to pack
-                * the partially written file at the end of FLASH.
-                */
+              return ret;
+            }
 
-               wrfile = nxffs_setupwriter(volume, &pack);
-             }
+          continue;
+        }
 
-          /* Otherwise return OK.. meaning that there is nothing more we can
-           * do to recover FLASH space.
-           */
+      /* The source block may have been replaced in the cache by any other
+       * FLASH access.
+       */
 
-          else
-            {
-              return OK;
-            }
-        }
-      else
+      nxffs_ioseek(volume, srcoffset);
+      ret = nxffs_rdcache(volume, volume->ioblock);
+      if (ret < 0)
         {
-          fdbg("ERROR: Failed to find a packing position: %d\n", -ret);
+          fdbg("ERROR: Failed to read block %d: %d\n", volume->ioblock, -ret);
           return ret;
         }
+
+      DEBUGASSERT(nxffs_packtell(volume, pack) <= srcoffset);
+      memcpy(&pack->iobuffer[pack->iooffset],
+             &volume->cache[volume->iooffset], xfrlen);
+
+      pack->iooffset += xfrlen;
+      pack->datlen   += xfrlen;
+      srcoffset      += xfrlen;
+      remaining      -= xfrlen;
     }
 
-  /* Otherwise, begin pack at this src/dest block combination.  Initialize
-   * ioblock and iooffset with the position of the first inode header.  In
-   * this case, the FLASH offset to the first inode header is return in
-   * iooffset.
-   */
+  return OK;
+}
 
-start_pack:
+/****************************************************************************
+ * Name: nxffs_packraw
+ *
+ * Description:
+ *   Copy one untagged data block (header and data) to the destination
+ *   without modification.
+ *
+ * Input Parameters:
+ *   volume   - The volume to be packed
+ *   pack     - The volume packing state structure.
+ *   blkentry - Describes the source data block
+ *   doffset  - If non-NULL, this is the first data block of the inode and
+ *              the offset to the new data block header is returned here.
+ *
+ * Returned Values:
+ *   Zero on success; Otherwise, a negated errno value is returned to
+ *   indicate the nature of the failure.
+ *
+ ****************************************************************************/
 
-  pack.ioblock     = nxffs_getblock(volume, iooffset);
-  pack.iooffset    = nxffs_getoffset(volume, iooffset, pack.ioblock);
-  volume->froffset = iooffset;
+static int nxffs_packraw(FAR struct nxffs_volume_s *volume,
+                         FAR struct nxffs_pack_s *pack,
+                         FAR struct nxffs_blkentry_s *blkentry,
+                         FAR off_t *doffset)
+{
+  size_t size = blkentry->hdrlen + blkentry->datlen;
+  off_t offset;
+  int ret;
 
-  /* Then pack all erase blocks starting with the erase block that contains
-   * the ioblock and through the final erase block on the FLASH.
-   */
+  nxffs_wrdathdr(volume, pack);
 
-  for (eblock = pack.ioblock / volume->blkper;
-       eblock < volume->geo.neraseblocks;
-       eblock++)
+  ret = nxffs_packreserve(volume, pack, size, &offset);
+  if (ret < 0)
     {
-      /* Get the starting block number of the erase block */
-
-      pack.block0 = eblock * volume->blkper;
+      return ret;
+    }
 
-#ifndef CONFIG_NXFFS_NAND
-      /* Read the erase block into the pack buffer.  We need to do this even
-       * if we are overwriting the entire block so that we skip over
-       * previously marked bad blocks.
-       */
+  nxffs_ioseek(volume, blkentry->hoffset);
+  ret = nxffs_rdcache(volume, volume->ioblock);
+  if (ret < 0)
+    {
+      fdbg("ERROR: Failed to read block %d: %d\n", volume->ioblock, -ret);
+      return ret;
+    }
 
-      ret = MTD_BREAD(volume->mtd, pack.block0, volume->blkper, volume->pack);
-      if (ret < 0)
-        {
-          fdbg("ERROR: Failed to read erase block %d: %d\n", eblock,-ret);
-          goto errout_with_pack;
-        }
+  DEBUGASSERT(offset <= blkentry->hoffset);
+  memcpy(&pack->iobuffer[pack->iooffset],
+         &volume->cache[volume->iooffset], size);
+  pack->iooffset += size;
 
-#else
-      /* Read the entire erase block into the pack buffer, one-block-at-a-
-       * time.  We need to do this even if we are overwriting the entire
-       * block so that (1) we skip over previously marked bad blocks, and
-       * (2) we can handle individual block read failures.
-       *
-       * For most FLASH, a read failure indicates a fatal hardware failure.
-       * But for NAND FLASH, the read failure probably indicates a block
-       * with uncorrectable bit errors.
-       */
+  if (doffset)
+    {
+      *doffset = offset;
+    }
 
-      /* Read each I/O block */
+  return OK;
+}
 
-      for (i = 0, block = pack.block0, pack.iobuffer = volume->pack;
-           i < volume->blkper;
-           i++, block++, pack.iobuffer += volume->geo.blocksize)
-        {
-          /* Read the next block in the erase block */
+/****************************************************************************
+ * Name: nxffs_packblock
+ *
+ * Description:
+ *   Relocate one data block.  Data blocks that no longer belong to a live
+ *   inode are dropped.
+ *
+ * Input Parameters:
+ *   volume   - The volume to be packed
+ *   pack     - The volume packing state structure.
+ *   blkentry - Describes the source data block
+ *
+ * Returned Values:
+ *   Zero on success; Otherwise, a negated errno value is returned to
+ *   indicate the nature of the failure.
+ *
+ ****************************************************************************/
 
-          ret = MTD_BREAD(volume->mtd, block, 1, pack.iobuffer);
-          if (ret < 0)
-            {
-              /* Force a the block to be an NXFFS bad block */
+static int nxffs_packblock(FAR struct nxffs_volume_s *volume,
+                           FAR struct nxffs_pack_s *pack,
+                           FAR struct nxffs_blkentry_s *blkentry)
+{
+  FAR struct nxffs_packmap_s *map = NULL;
+  FAR struct nxffs_wrfile_s *wrfile = NULL;
+  off_t owner;
+  off_t newowner;
+  off_t doffset;
+  bool first;
+  int ret;
 
-              fdbg("ERROR: Failed to read block %d: %d\n", block, ret);
-              nxffs_blkinit(volume, pack.iobuffer, BLOCK_STATE_BAD);
-            }
-        }
-#endif
+  /* Empty data blocks are left behind by closed writers */
 
-      /* Now pack each I/O block */
+  if (blkentry->datlen == 0)
+    {
+      return OK;
+    }
 
-      for (i = 0, block = pack.block0, pack.iobuffer = volume->pack;
-           i < volume->blkper;
-           i++, block++, pack.iobuffer += volume->geo.blocksize)
-        {
-           /* The first time here, the ioblock may point to an offset into
-            * the erase block.  We just need to skip over those cases.
-            */
+  /* Who owns this data block? */
 
-           if (block >= pack.ioblock)
-              {
-                /* Set the I/O position.  Note on the first time we get
-                 * pack.iooffset will hold the offset in the first I/O block
-                 * to the first inode header.  After that, it will always
-                 * refer to the first byte after the block header.
-                 */
-
-                pack.ioblock = block;
-
-                /* If this is not a valid block or if we have already
-                 * finished packing the valid inode entries, then just fall
-                 * through, reset the FLASH memory to the erase state, and
-                 * write the reset values to FLASH.  (The first block that
-                 * we want to process will always be valid -- we have
-                 * already verified that).
-                 */
-
-                if (nxffs_packvalid(&pack))
-                  {
-                    /* Have we finished packing inodes? */
-
-                    if (!packed)
-                      {
-                         DEBUGASSERT(wrfile == NULL);
-
-                         /* Pack inode data into this block */
-
-                         ret = nxffs_packblock(volume, &pack);
-                         if (ret < 0)
-                           {
-                             /* The error -ENOSPC is a special value that simply
-                              * means that there is nothing further to be packed.
-                              */
-
-                             if (ret == -ENOSPC)
-                               {
-                                 packed = true;
-
-                                 /* Writing is performed at the end of the free
-                                  * FLASH region and this implemenation is restricted
-                                  * to a single writer.  The new inode is not
-                                  * written to FLASH until the writer is closed
-                                  * and so will not be found by nxffs_packblock().
-                                  */
-
-                                 wrfile = nxffs_setupwriter(volume, &pack);
-                               }
-                             else
-                               {
-                                 /* Otherwise, something really bad happened */
-
-                                 fdbg("ERROR: Failed to pack into block %d: %d\n",
-                                      block, ret);
-                                 goto errout_with_pack;
-                               }
-                           }
-                       }
-
-                     /* If all of the "normal" inodes have been packed, then check if
-                      * we need to pack the current, in-progress write operation.
-                      */
-
-                     if (wrfile)
-                       {
-                         DEBUGASSERT(packed == true);
-
-                         /* Pack write data into this block */
-
-                         ret = nxffs_packwriter(volume, &pack, wrfile);
-                         if (ret < 0)
-                           {
-                             /* The error -ENOSPC is a special value that simply
-                              * means that there is nothing further to be packed.
-                              */
-
-                             if (ret == -ENOSPC)
-                               {
-                                 wrfile = NULL;
-                               }
-                             else
-                               {
-                                 /* Otherwise, something really bad happened */
-
-                                 fdbg("ERROR: Failed to pack into block %d: %d\n",
-                                      block, ret);
-                                 goto errout_with_pack;
-                               }
-                           }
-                       }
-                   }
-
-                 /* Set any unused portion at the end of the block to the
-                  * erased state.
-                  */
-
-                 if (pack.iooffset < volume->geo.blocksize)
-                   {
-                     memset(&pack.iobuffer[pack.iooffset],
-                            CONFIG_NXFFS_ERASEDSTATE,
-                            volume->geo.blocksize - pack.iooffset);
-                   }
-
-                 /* Next time through the loop, pack.iooffset will point to the
-                  * first byte after the block header.
-                  */
-
-                 pack.iooffset = SIZEOF_NXFFS_BLOCK_HDR;
-              }
-         }
+  owner = blkentry->owner != 0 ? blkentry->owner : pack->untagged;
+  if (owner < 0)
+    {
+      return OK;
+    }
 
-      /* We now have an in-memory image of how we want this erase block to
-       * appear. Now it is safe to erase the block.
-       */
+  if (owner >= pack->start)
+    {
+      /* The inode header has been relocated (or the inode is dead) */
 
-      ret = MTD_ERASE(volume->mtd, eblock, 1);
-      if (ret < 0)
+      map = nxffs_findmap(pack, owner);
+      if (!map)
         {
-          fdbg("ERROR: Failed to erase block %d [%d]: %d\n",
-               eblock, pack.block0, -ret);
-          goto errout_with_pack;
+          return OK;
         }
 
-      /* Write the packed I/O block to FLASH */
+      newowner = map->entry.hoffset;
+      wrfile   = map->wrfile;
+      first    = (blkentry->hoffset == map->doffset);
+    }
+  else
+    {
+      /* The inode header precedes the packed region and does not move */
 
-      ret = MTD_BWRITE(volume->mtd, pack.block0, volume->blkper, volume->pack);
-      if (ret < 0)
+      if (!nxffs_packlive(volume, owner))
         {
-          fdbg("ERROR: Failed to write erase block %d [%d]: %d\n",
-               eblock, pack.block0, -ret);
-          goto errout_with_pack;
+          return OK;
         }
+
+      newowner = owner;
+      wrfile   = nxffs_findwriter(volume, owner);
+      first    = (wrfile && blkentry->hoffset == wrfile->ofile.entry.doffset);
     }
 
-errout_with_pack:
-  nxffs_freeentry(&pack.src.entry);
-  nxffs_freeentry(&pack.dest.entry);
-  return ret;
-}
+  /* Copy the data */
+
+  if (blkentry->owner != 0)
+    {
+      ret = nxffs_packdata(volume, pack, blkentry, newowner,
+                           first ? &doffset : NULL);
+    }
+  else
+    {
+      ret = nxffs_packraw(volume, pack, blkentry, first ? &doffset : NULL);
+    }
+
+  if (ret < 0 || !first)
+    {
+      return ret;
+    }
+
+  /* The first data block was moved.  Writers record the new position in
+   * the inode header when they are closed.  Otherwise, the inode header
+   * can be written now.
+   */
+
+  if (wrfile)
+    {
+      wrfile->ofile.entry.doffset = doffset;
+      return OK;
+    }
+
+  DEBUGASSERT(map && map->pending);
+  map->entry.doffset = doffset;
+  return nxffs_wrinodehdr(volume, pack, map);
+}
+
+/****************************************************************************
+ * Name: nxffs_packobjects
+ *
+ * Description:
+ *   Relocate all live objects from pack->start to pack->end.
+ *
+ * Input Parameters:
+ *   volume - The volume to be packed
+ *   pack   - The volume packing state structure.
+ *
+ * Returned Values:
+ *   Zero on success; Otherwise, a negated errno value is returned to
+ *   indicate the nature of the failure.
+ *
+ ****************************************************************************/
+
+static int nxffs_packobjects(FAR struct nxffs_volume_s *volume,
+                             FAR struct nxffs_pack_s *pack)
+{
+  struct nxffs_object_s object;
+  FAR struct nxffs_packmap_s *map;
+  FAR struct nxffs_wrfile_s *wrfile;
+  off_t offset = pack->start;
+  size_t ndx;
+  int ret;
+
+  while ((ret = nxffs_packobject(volume, offset, pack->end,
+                                 &object, &wrfile)) == OK)
+    {
+      offset = object.next;
+
+      switch (object.type)
+        {
+        case NXFFS_OBJ_INODE:
+          {
+            /* Is this inode still in the index? */
+
+            ndx = nxffs_findindex(volume, object.entry.hoffset);
+            if (ndx >= volume->ninodes ||
+                volume->index[ndx].hoffset != object.entry.hoffset)
+              {
+                nxffs_freeentry(&object.entry);
+                pack->untagged = -1;
+                break;
+              }
+
+            map = nxffs_addmap(pack, object.entry.hoffset,
+                               object.entry.doffset);
+            if (!map)
+              {
+                nxffs_freeentry(&object.entry);
+                return -ENOMEM;
+              }
+
+            /* The map takes ownership of the name */
+
+            map->entry   = object.entry;
+            map->pending = true;
+            ret = nxffs_packhdr(volume, pack, &map->entry);
+            if (ret < 0)
+              {
+                return ret;
+              }
+
+            /* All inode headers before this one have already been moved to
+             * positions before the new one, so the index remains sorted.
+             */
+
+            volume->index[ndx].hoffset = map->entry.hoffset;
+            pack->untagged = map->hoffset;
+
+            /* Open files referring to the original inode header must be
+             * updated now:  The original position may be re-used by a
+             * relocated inode header before this one is written.
+             */
+
+            ret = nxffs_updateinode(volume, map->hoffset, &map->entry);
+            if (ret < 0)
+              {
+                return ret;
+              }
+
+            /* An empty file has no data block to wait for */
+
+            if (map->doffset == 0)
+              {
+                ret = nxffs_wrinodehdr(volume, pack, map);
+                if (ret < 0)
+                  {
+                    return ret;
+                  }
+              }
+          }
+          break;
+
+        case NXFFS_OBJ_DELETED:
+          nxffs_freeentry(&object.entry);
+          pack->untagged = -1;
+          break;
+
+        case NXFFS_OBJ_WRITER:
+          {
+            /* The writer will write its inode header when it is closed */
+
+            map = nxffs_addmap(pack, wrfile->ofile.entry.hoffset,
+                               wrfile->ofile.entry.doffset);
+            if (!map)
+              {
+                return -ENOMEM;
+              }
+
+            map->wrfile = wrfile;
+            ret = nxffs_packhdr(volume, pack, &wrfile->ofile.entry);
+            if (ret < 0)
+              {
+                return ret;
+              }
+
+            map->entry.hoffset = wrfile->ofile.entry.hoffset;
+            pack->untagged = -1;
+          }
+          break;
+
+        default:
+          ret = nxffs_packblock(volume, pack, &object.blkentry);
+          if (ret < 0)
+            {
+              return ret;
+            }
+          break;
+        }
+    }
+
+  if (ret != -ENOENT && ret != -ENOSPC)
+    {
+      fdbg("ERROR: Failed to find the next object: %d\n", -ret);
+      return ret;
+    }
+
+  nxffs_wrdathdr(volume, pack);
+
+  /* Any inode headers that are still pending lost their data.  Keep them
+   * as empty files.
+   */
+
+  for (ndx = 0; ndx < pack->nmap; ndx++)
+    {
+      map = &pack->map[ndx];
+      if (map->pending)
+        {
+          fdbg("ERROR: No data found for inode at %d\n", map->hoffset);
+
+          map->entry.doffset = 0;
+          map->entry.datlen  = 0;
+          ret = nxffs_wrinodehdr(volume, pack, map);
+          if (ret < 0)
+            {
+              return ret;
+            }
+        }
+    }
+
+  return OK;
+}
+
+
+/****************************************************************************
+ * Name: nxffs_packtail
+ *
+ * Description:
+ *   Finish a pack that reached the end of the valid data:  Erase the rest of
+ *   the current block and re-initialize every remaining block up to the end
+ *   of the old data, skipping over the blocks that are marked bad.
+ *
+ * Input Parameters:
+ *   volume - The volume to be packed
+ *   pack   - The volume packing state structure.
+ *
+ * Returned Values:
+ *   Zero on success; Otherwise, a negated errno value is returned to
+ *   indicate the nature of the failure.
+ *
+ ****************************************************************************/
+
+static int nxffs_packtail(FAR struct nxffs_volume_s *volume,
+                          FAR struct nxffs_pack_s *pack)
+{
+  off_t endblock;
+  int ret;
+
+  if (nxffs_packvalid(pack) && pack->iooffset < volume->geo.blocksize)
+    {
+      memset(&pack->iobuffer[pack->iooffset], CONFIG_NXFFS_ERASEDSTATE,
+             volume->geo.blocksize - pack->iooffset);
+    }
+
+  endblock = nxffs_getblock(volume, pack->end - 1);
+  for (;;)
+    {
+      pack->ioblock++;
+      if (pack->ioblock >= pack->block0 + volume->blkper)
+        {
+          ret = nxffs_packwrite(volume, pack);
+          if (ret < 0 || pack->ioblock > endblock ||
+              pack->ioblock >= volume->nblocks)
+            {
+              return ret;
+            }
+
+          ret = nxffs_packread(volume, pack);
+          if (ret < 0)
+            {
+              return ret;
+            }
+        }
+      else
+        {
+          pack->iobuffer += volume->geo.blocksize;
+        }
+
+      if (nxffs_packvalid(pack))
+        {
+          nxffs_blkinit(volume, pack->iobuffer, BLOCK_STATE_GOOD);
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: nxffs_packgap
+ *
+ * Description:
+ *   Finish an incremental pack step that ended before the end of the valid
+ *   data:  Everything between the relocated objects and pack->end is stale
+ *   and is replaced with filler.  Blocks in that range are left with at
+ *   least one byte of filler at the beginning of their data so that they
+ *   are not mistaken for the end of the valid data.  Erase blocks that
+ *   hold nothing but the garbage before pack->keep are not rewritten at
+ *   all.  The next pack step will find the gap there.
+ *
+ * Input Parameters:
+ *   volume - The volume to be packed
+ *   pack   - The volume packing state structure.
+ *
+ * Returned Values:
+ *   Zero on success; Otherwise, a negated errno value is returned to
+ *   indicate the nature of the failure.
+ *
+ ****************************************************************************/
+
+static int nxffs_packgap(FAR struct nxffs_volume_s *volume,
+                         FAR struct nxffs_pack_s *pack)
+{
+  off_t keepblock;
+  off_t endblock;
+  uint16_t endoffset;
+  int ret;
+
+  keepblock = nxffs_getblock(volume, pack->keep);
+  keepblock = (keepblock / volume->blkper) * volume->blkper;
+  endblock  = nxffs_getblock(volume, pack->end);
+  endoffset = nxffs_getoffset(volume, pack->end, endblock);
+
+  if (pack->ioblock < endblock)
+    {
+      /* Nothing more will be written to the current block */
+
+      if (pack->iooffset == SIZEOF_NXFFS_BLOCK_HDR)
+        {
+          pack->iobuffer[pack->iooffset++] = NXFFS_FILLSTATE;
+        }
+
+      memset(&pack->iobuffer[pack->iooffset], CONFIG_NXFFS_ERASEDSTATE,
+             volume->geo.blocksize - pack->iooffset);
+
+      /* Clear the blocks in between */
+
+      for (;;)
+        {
+          pack->ioblock++;
+          if (pack->ioblock >= pack->block0 + volume->blkper)
+            {
+              ret = nxffs_packwrite(volume, pack);
+              if (ret < 0)
+                {
+                  return ret;
+                }
+
+              if (pack->ioblock < keepblock)
+                {
+                  pack->ioblock = keepblock;
+                }
+
+              ret = nxffs_packread(volume, pack);
+              if (ret < 0)
+                {
+                  return ret;
+                }
+            }
+          else
+            {
+              pack->iobuffer += volume->geo.blocksize;
+            }
+
+          if (pack->ioblock >= endblock)
+            {
+              break;
+            }
+
+          if (nxffs_packvalid(pack))
+            {
+              nxffs_blkinit(volume, pack->iobuffer, BLOCK_STATE_GOOD);
+              pack->iobuffer[SIZEOF_NXFFS_BLOCK_HDR] = NXFFS_FILLSTATE;
+            }
+        }
+
+      pack->iooffset = SIZEOF_NXFFS_BLOCK_HDR;
+    }
+
+  /* Then overwrite the stale objects in front of the first object that is
+   * not moved.
+   */
+
+  DEBUGASSERT(nxffs_packvalid(pack) && pack->iooffset <= endoffset);
+  memset(&pack->iobuffer[pack->iooffset], NXFFS_FILLSTATE,
+         endoffset - pack->iooffset);
+
+  return nxffs_packwrite(volume, pack);
+}
+
+/****************************************************************************
+ * Name: nxffs_packvolume
+ *
+ * Description:
+ *   Relocate the live objects following the first gap of unused FLASH;  All
+ *   of them if neblocks is zero, or only those in about neblocks erase
+ *   blocks otherwise.
+ *
+ * Input Parameters:
+ *   volume   - The volume to be packed.
+ *   neblocks - The maximum number of erase blocks to relocate (0=all).
+ *
+ * Returned Values:
+ *   One if something was packed, zero if there is nothing to pack.
+ *   Otherwise, a negated errno value is returned to indicate the nature of
+ *   the failure.
+ *
+ ****************************************************************************/
+
+static int nxffs_packvolume(FAR struct nxffs_volume_s *volume, int neblocks)
+{
+  struct nxffs_pack_s pack;
+  FAR struct nxffs_ofile_s *ofile;
+  FAR struct nxffs_wrfile_s *wrfile;
+  off_t froffset;
+  off_t hoffset;
+  off_t offset;
+  off_t limit;
+  off_t from = 0;
+  int ntries;
+  size_t i;
+  int ret;
+
+  /* Close the current data block of each writer so that all data in FLASH
+   * is complete.
+   */
+
+  for (ofile = volume->ofiles; ofile; ofile = ofile->flink)
+    {
+      if ((ofile->oflags & O_WROK) != 0)
+        {
+          wrfile = (FAR struct nxffs_wrfile_s *)ofile;
+          if (wrfile->doffset > 0)
+            {
+              ret = nxffs_wrblkhdr(volume, wrfile);
+              if (ret < 0)
+                {
+                  fdbg("ERROR: Failed to write data block header: %d\n",
+                       -ret);
+                  return ret;
+                }
+            }
+        }
+    }
+
+  /* Find the position where packing begins */
+
+  memset(&pack, 0, sizeof(struct nxffs_pack_s));
+  pack.end = volume->froffset;
+
+  ret = nxffs_packstart(volume, &pack, 0);
+  if (ret < 0 || pack.start >= pack.end)
+    {
+      volume->stats.ps_packoffset = 0;
+      return ret;
+    }
+
+  /* An incremental step relocates the live objects in the neblocks erase
+   * blocks that follow the gap.  If there are no live objects to move, then
+   * the (big) garbage tail is simply erased.
+   */
+
+  for (ntries = 0; neblocks > 0 && pack.next < pack.end; )
+    {
+      limit = (pack.next / volume->geo.erasesize + neblocks) *
+              volume->geo.erasesize;
+      if (limit >= pack.end)
+        {
+          break;
+        }
+
+      /* The gap may lie in front of an inode header that cannot be moved
+       * by itself:  One whose first data block follows the gap (so that the
+       * packing begins at the inode header) or one that owns data beyond
+       * the limit (so that nothing before the limit can be moved).  Try
+       * the next gap after that inode instead.
+       */
+
+      hoffset = pack.start;
+      if (pack.start >= from)
+        {
+          ret = nxffs_packplan(volume, &pack, limit);
+          if (ret < 0)
+            {
+              goto errout_with_map;
+            }
+
+          if (pack.end > pack.next)
+            {
+              break;
+            }
+
+          hoffset = pack.end;
+        }
+
+      fvdbg("Cannot pack %d-%d incrementally\n", pack.start, limit);
+
+      ret = nxffs_packskip(volume, hoffset, &offset);
+      if (ret < 0 || offset <= from || ++ntries >= NXFFS_PACKTRIES)
+        {
+          goto errout_with_map;
+        }
+
+      from       = offset;
+      pack.nspan = 0;
+      pack.end   = volume->froffset;
+
+      ret = nxffs_packstart(volume, &pack, from);
+      if (ret < 0 || pack.start >= pack.end)
+        {
+          goto errout_with_map;
+        }
+    }
+
+  fvdbg("Packing %d-%d\n", pack.start, pack.end);
+
+  /* Setup the destination at the starting position */
+
+  pack.ioblock  = nxffs_getblock(volume, pack.start);
+  pack.iooffset = nxffs_getoffset(volume, pack.start, pack.ioblock);
+  if (pack.iooffset < SIZEOF_NXFFS_BLOCK_HDR)
+    {
+      pack.iooffset = SIZEOF_NXFFS_BLOCK_HDR;
+    }
+
+  ret = nxffs_packread(volume, &pack);
+  if (ret < 0)
+    {
+      goto errout_with_map;
+    }
+
+  if (!nxffs_packvalid(&pack))
+    {
+      ret = nxffs_packnext(volume, &pack);
+      if (ret < 0)
+        {
+          goto errout_with_map;
+        }
+    }
+
+  /* Move all of the live objects */
+
+  ret = nxffs_packobjects(volume, &pack);
+  if (ret < 0)
+    {
+      goto errout_with_map;
+    }
+
+  froffset = nxffs_packtell(volume, &pack);
+  if (pack.end < volume->froffset)
+    {
+      /* The gap now lies at the end of the relocated objects */
+
+      ret = nxffs_packgap(volume, &pack);
+      if (ret < 0)
+        {
+          goto errout_with_map;
+        }
+
+      volume->stats.ps_packoffset = froffset;
+    }
+  else
+    {
+      /* The free FLASH now begins at the end of the packed data */
+
+      ret = nxffs_packtail(volume, &pack);
+      if (ret < 0)
+        {
+          goto errout_with_map;
+        }
+
+      volume->stats.ps_reclaimed += volume->froffset - froffset;
+      volume->stats.ps_packoffset = 0;
+      volume->froffset = froffset;
+    }
+
+  volume->inoffset = volume->ninodes > 0 ? volume->index[0].hoffset :
+                     volume->froffset;
+  ret = 1;
+
+errout_with_map:
+  for (i = 0; i < pack.nmap; i++)
+    {
+      nxffs_freeentry(&pack.map[i].entry);
+    }
+
+  if (pack.map)
+    {
+      kfree(pack.map);
+    }
+
+  if (pack.span)
+    {
+      kfree(pack.span);
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: nxffs_packworker
+ *
+ * Description:
+ *   Background packing.  Performs one incremental pack step at a time (so
+ *   that the volume is not locked for long) while too little of the volume
+ *   is free.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NXFFS_BGPACK
+static void nxffs_packworker(FAR void *arg)
+{
+  FAR struct nxffs_volume_s *volume = (FAR struct nxffs_volume_s *)arg;
+  off_t size;
+  int ret = 0;
+
+  if (sem_wait(&volume->exclsem) != OK)
+    {
+      return;
+    }
+
+  size = volume->nblocks * volume->geo.blocksize;
+  if (volume->mounted &&
+      size - volume->froffset < (size / 100) * CONFIG_NXFFS_BGPACK_FREE)
+    {
+      ret = nxffs_packstep(volume, CONFIG_NXFFS_PACKSTEP);
+      if (ret > 0)
+        {
+          volume->stats.ps_nbgsteps++;
+        }
+    }
+
+  /* Continue unless a writer has already re-scheduled the work */
+
+  if (ret > 0 && work_available(&volume->work))
+    {
+      (void)work_queue(LPWORK, &volume->work, nxffs_packworker, volume, 0);
+    }
+
+  sem_post(&volume->exclsem);
+}
+#endif
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nxffs_pack
+ *
+ * Description:
+ *   Pack and re-write the filesystem in order to free up memory at the end
+ *   of FLASH.
+ *
+ *   Only the region of FLASH beginning at the first significant gap of
+ *   unused FLASH is rewritten.  Live inode headers, names and data blocks
+ *   in that region are moved down, in their original order, with data
+ *   blocks of the same inode merged where possible.  Files that are open
+ *   for writing are packed in place:  Their current data block is closed
+ *   and their reserved inode header is moved along with the other objects.
+ *
+ * Input Parameters:
+ *   volume - The volume to be packed.
+ *
+ * Returned Values:
+ *   Zero on success; Otherwise, a negated errno value is returned to
+ *   indicate the nature of the failure.
+ *
+ ****************************************************************************/
+
+int nxffs_pack(FAR struct nxffs_volume_s *volume)
+{
+  uint32_t start = clock_systimer();
+  uint32_t elapsed;
+  int ret;
+
+  ret = nxffs_packvolume(volume, 0);
+  if (ret > 0)
+    {
+      elapsed = TICK2MSEC(clock_systimer() - start);
+      if (elapsed > volume->stats.ps_maxpack)
+        {
+          volume->stats.ps_maxpack = elapsed;
+        }
+
+      volume->stats.ps_npacks++;
+      ret = OK;
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: nxffs_packstep
+ *
+ * Description:
+ *   Perform one bounded step of incremental packing:  Relocate the live
+ *   objects in about 'neblocks' erase blocks following the first gap of
+ *   unused FLASH.  The gap is moved toward the end of the valid data and
+ *   the step that reaches the end of the valid data frees the FLASH.
+ *
+ * Input Parameters:
+ *   volume   - The volume to be packed.
+ *   neblocks - The maximum number of erase blocks to relocate.
+ *
+ * Returned Values:
+ *   One if something was packed, zero if there is nothing worth packing.
+ *   Otherwise, a negated errno value is returned to indicate the nature of
+ *   the failure.
+ *
+ ****************************************************************************/
+
+int nxffs_packstep(FAR struct nxffs_volume_s *volume, int neblocks)
+{
+  uint32_t start = clock_systimer();
+  uint32_t elapsed;
+  int ret;
+
+  DEBUGASSERT(neblocks > 0);
+  ret = nxffs_packvolume(volume, neblocks);
+  if (ret > 0)
+    {
+      elapsed = TICK2MSEC(clock_systimer() - start);
+      if (elapsed > volume->stats.ps_maxstep)
+        {
+          volume->stats.ps_maxstep = elapsed;
+        }
+
+      volume->stats.ps_nsteps++;
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: nxffs_packsched
+ *
+ * Description:
+ *   (Re-)schedule background packing after the volume was modified.  The
+ *   volume exclsem must be held by the caller.
+ *
+ * Input Parameters:
+ *   volume - The volume that was modified.
+ *
+ * Returned Values:
+ *   None
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NXFFS_BGPACK
+void nxffs_packsched(FAR struct nxffs_volume_s *volume)
+{
+  (void)work_cancel(LPWORK, &volume->work);
+  (void)work_queue(LPWORK, &volume->work, nxffs_packworker, volume,
+                   MSEC2TICK(CONFIG_NXFFS_PACKDELAY));
+}
+#endif
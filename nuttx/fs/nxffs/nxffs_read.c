@@ -76,7 +76,8 @@
  *   Seek to the file position before read or write access.  Note that the
  *   simplier nxffs_ioseek() cannot be used for this purpose.  File offsets
  *   are not easily mapped to FLASH offsets due to intervening block and
- *   data headers.
+ *   data headers and due to the data blocks of other files that may be
+ *   interleaved with the data blocks of this file.
  *
  * Input Parameters:
  *   volume   - Describes the current volume
@@ -94,6 +95,7 @@ static ssize_t nxffs_rdseek(FAR struct nxffs_volume_s *volume,
   size_t datstart;
   size_t datend;
   off_t offset;
+  off_t owner;
   int ret;
 
   /* The initial FLASH offset will be the offset to first data block of
@@ -111,6 +113,7 @@ static ssize_t nxffs_rdseek(FAR struct nxffs_volume_s *volume,
   /* Loop until we read the data block containing the desired position */
 
   datend = 0;
+  owner  = -1;
   do
     {
       /* Check if the next data block contains the sought after file position */
@@ -122,21 +125,39 @@ static ssize_t nxffs_rdseek(FAR struct nxffs_volume_s *volume,
           return ret;
         }
 
+      /* Offset to search for the next data block */
+
+      offset = blkentry->hoffset + blkentry->hdrlen + blkentry->datlen;
+
+      /* The first data block determines how the remaining data blocks are
+       * identified:  Tagged data blocks must be tagged with the offset to
+       * this inode header; untagged data blocks (from older volumes) simply
+       * follow each other.
+       */
+
+      if (owner < 0)
+        {
+          owner = blkentry->owner ? entry->hoffset : 0;
+        }
+
+      /* Skip over data blocks that belong to other files */
+
+      if (blkentry->owner != owner)
+        {
+          continue;
+        }
+
       /* Get the range of data offsets for this data block */
 
       datstart  = datend;
       datend   += blkentry->datlen;
-
-      /* Offset to search for the next data block */
-
-      offset = blkentry->hoffset + SIZEOF_NXFFS_DATA_HDR + blkentry->datlen;
     }
   while (datend <= fpos);
 
   /* Return the offset to the data within the current data block */
 
   blkentry->foffset = fpos - datstart;
-  nxffs_ioseek(volume, blkentry->hoffset + SIZEOF_NXFFS_DATA_HDR + blkentry->foffset);
+  nxffs_ioseek(volume, blkentry->hoffset + blkentry->hdrlen + blkentry->foffset);
   return OK;
 }
 
@@ -257,12 +278,13 @@ errout:
  * Name: nxffs_nextblock
  *
  * Description:
- *   Search for the next valid data block starting at the provided
- *   FLASH offset.
+ *   Search for the next valid data block (of any inode) starting at the
+ *   provided FLASH offset.  The search ends at the free FLASH region.
  *
  * Input Parameters:
- *   volume - Describes the NXFFS volume.
- *   datlen  - A memory location to return the data block length.
+ *   volume   - Describes the NXFFS volume.
+ *   offset   - The FLASH memory offset to begin searching.
+ *   blkentry - A memory location to return the data block description.
  *
  * Returned Value:
  *   Zero is returned on success. Otherwise, a negated errno is returned
@@ -275,7 +297,6 @@ int nxffs_nextblock(FAR struct nxffs_volume_s *volume, off_t offset,
 {
   int nmagic;
   int ch;
-  int nerased;
   int ret;
 
   /* Seek to the first FLASH offset provided by the caller. */
@@ -289,99 +310,94 @@ int nxffs_nextblock(FAR struct nxffs_volume_s *volume, off_t offset,
       volume->iooffset = SIZEOF_NXFFS_BLOCK_HDR;
     }
 
-  /* Then begin searching */
+  /* Then begin searching.  NOTE:  Erased bytes cannot be used to detect
+   * the end of the valid data here:  The data blocks of files that are
+   * still being written may lie anywhere in the valid FLASH region and
+   * these may contain any data.  Instead, the search stops at the free
+   * FLASH region.
+   */
 
-  nerased = 0;
   nmagic  = 0;
-
   for (;;)
     {
+      /* Check for the end of the valid FLASH region */
+
+      if (nxffs_iotell(volume) >= volume->froffset)
+        {
+          fvdbg("No data block found\n");
+          return -ENOENT;
+        }
+
       /* Read the next character */
 
-      ch = nxffs_getc(volume, SIZEOF_NXFFS_DATA_HDR - nmagic);
+      ch = nxffs_getc(volume, SIZEOF_NXFFS_UNTAGGED_HDR - nmagic);
       if (ch < 0)
         {
           fdbg("ERROR: nxffs_getc failed: %d\n", -ch);
           return ch;
         }
 
-      /* Check for another erased byte */
-
-      else if (ch == CONFIG_NXFFS_ERASEDSTATE)
+      /* Check for the magic sequence indicating the start of an NXFFS
+       * data block or start of the next inode. There is the possibility
+       * of this magic sequnce occurring in FLASH data.  However, the
+       * data block CRC should distinguish between real NXFFS data blocks
+       * headers and such false alarms.
+       *
+       * The tagged and untagged data block magic numbers differ only in
+       * the final character.
+       */
+
+      if (ch != g_datamagic[nmagic] &&
+          (nmagic < NXFFS_MAGICSIZE - 1 || ch != g_tagmagic[nmagic]))
         {
-          /* If we have encountered NXFFS_NERASED number of consecutive
-           * erased bytes, then presume we have reached the end of valid
-           * data.
+          /* Ooops... this is the not the right character for the magic
+           * Sequence.  Check if we need to restart or to cancel the sequence:
            */
 
-          if (++nerased >= NXFFS_NERASED)
+          if (ch == g_datamagic[0])
             {
-              fvdbg("No entry found\n");
-              return -ENOENT;
+              nmagic = 1;
+            }
+          else
+            {
+              nmagic = 0;
             }
         }
-      else
+      else if (nmagic < NXFFS_MAGICSIZE - 1)
         {
-          nerased = 0;
-
-          /* Check for the magic sequence indicating the start of an NXFFS
-           * data block or start of the next inode. There is the possibility
-           * of this magic sequnce occurring in FLASH data.  However, the
-           * data block CRC should distinguish between real NXFFS data blocks
-           * headers and such false alarms.
-           */
+          /* We have one more character in the magic sequence */
 
-          if (ch != g_datamagic[nmagic])
-            {
-              /* Ooops... this is the not the right character for the magic
-               * Sequence.  Check if we need to restart or to cancel the sequence:
-               */
-
-              if (ch == g_datamagic[0])
-                {
-                  nmagic = 1;
-                }
-              else
-                {
-                  nmagic = 0;
-                }
-            }
-          else if (nmagic < NXFFS_MAGICSIZE - 1)
-            {
-              /* We have one more character in the magic sequence */
+          nmagic++;
+        }
 
-              nmagic++;
-            }
+      /* We have found the magic sequence in the FLASH data that may
+       * indicate the beginning of an NXFFS data block.
+       */
 
-          /* We have found the magic sequence in the FLASH data that may
-           * indicate the beginning of an NXFFS data block.
+      else
+        {
+          /* The offset to the header must be 4 bytes before the current
+           * FLASH seek location.
            */
 
-          else
-            {
-              /* The offset to the header must be 4 bytes before the current
-               * FLASH seek location.
-               */
+          offset = nxffs_iotell(volume) - NXFFS_MAGICSIZE;
 
-              blkentry->hoffset = nxffs_iotell(volume) - NXFFS_MAGICSIZE;
+          /* Read the block header and verify the block at that address */
 
-              /* Read the block header and verify the block at that address */
-
-              ret = nxffs_rdblkhdr(volume, blkentry->hoffset, &blkentry->datlen);
-              if (ret == OK)
-                {
-                  fvdbg("Found a valid data block, offset: %d datlen: %d\n",
-                        blkentry->hoffset, blkentry->datlen);
-                  return OK;
-                }
+          ret = nxffs_rdblkhdr(volume, offset, blkentry);
+          if (ret == OK)
+            {
+              fvdbg("Found a valid data block, offset: %d datlen: %d\n",
+                    blkentry->hoffset, blkentry->datlen);
+              return OK;
+            }
 
-              /* False alarm.. Restore the volume cache position (that was
-               * destroyed by nxfs_rdblkhdr()) and keep looking.
-               */
+          /* False alarm.. Restore the volume cache position (that was
+           * destroyed by nxfs_rdblkhdr()) and keep looking.
+           */
 
-              nxffs_ioseek(volume, blkentry->hoffset + NXFFS_MAGICSIZE);
-              nmagic = 0;
-            }
+          nxffs_ioseek(volume, offset + NXFFS_MAGICSIZE);
+          nmagic = 0;
         }
     }
 
@@ -394,13 +410,14 @@ int nxffs_nextblock(FAR struct nxffs_volume_s *volume, off_t offset,
  * Name: nxffs_rdblkhdr
  *
  * Description:
- *   Read and verify the data block header at the specified offset.
+ *   Read and verify the data block header at the specified offset.  Both
+ *   tagged and untagged data block headers are supported.
  *
  * Input Parameters:
  *   volume - Describes the current volume.
  *   offset - The byte offset from the beginning of FLASH where the data block
  *     header is expected.
- *   datlen  - A memory location to return the data block length.
+ *   blkentry - A memory location to return the data block description.
  *
  * Returned Value:
  *   Zero on success.  Otherwise, a negated errno value is returned
@@ -409,13 +426,14 @@ int nxffs_nextblock(FAR struct nxffs_volume_s *volume, off_t offset,
  ****************************************************************************/
 
 int nxffs_rdblkhdr(FAR struct nxffs_volume_s *volume, off_t offset,
-                   FAR uint16_t *datlen)
+                   FAR struct nxffs_blkentry_s *blkentry)
 {
   struct nxffs_data_s blkhdr;
   uint32_t ecrc;
   uint32_t crc;
   uint16_t doffset;
   uint16_t dlen;
+  uint8_t hdrlen;
   int ret;
 
   /* Make sure that the block containing the data block header is in the cache */
@@ -428,10 +446,35 @@ int nxffs_rdblkhdr(FAR struct nxffs_volume_s *volume, off_t offset,
       return ret;
     }
 
-  /* Read the header at the FLASH offset */
+  /* Determine the kind of data block header from the magic number */
 
   doffset = volume->iooffset;
-  memcpy(&blkhdr, &volume->cache[doffset], SIZEOF_NXFFS_DATA_HDR);
+  if ((uint32_t)doffset + SIZEOF_NXFFS_UNTAGGED_HDR > (uint32_t)volume->geo.blocksize)
+    {
+      return -EIO;
+    }
+
+  if (memcmp(&volume->cache[doffset], g_tagmagic, NXFFS_MAGICSIZE) == 0)
+    {
+      hdrlen = SIZEOF_NXFFS_DATA_HDR;
+    }
+  else if (memcmp(&volume->cache[doffset], g_datamagic, NXFFS_MAGICSIZE) == 0)
+    {
+      hdrlen = SIZEOF_NXFFS_UNTAGGED_HDR;
+    }
+  else
+    {
+      return -EIO;
+    }
+
+  if ((uint32_t)doffset + hdrlen > (uint32_t)volume->geo.blocksize)
+    {
+      return -EIO;
+    }
+
+  /* Read the header at the FLASH offset */
+
+  memcpy(&blkhdr, &volume->cache[doffset], hdrlen);
 
   /* Extract the data length */
 
@@ -439,7 +482,7 @@ int nxffs_rdblkhdr(FAR struct nxffs_volume_s *volume, off_t offset,
 
   /* Get the offset to the beginning of the data */
 
-  doffset += SIZEOF_NXFFS_DATA_HDR;
+  doffset += hdrlen;
 
   /* Make sure that all of the data fits within the block */
 
@@ -454,7 +497,7 @@ int nxffs_rdblkhdr(FAR struct nxffs_volume_s *volume, off_t offset,
   ecrc = nxffs_rdle32(blkhdr.crc);
 
   nxffs_wrle32(blkhdr.crc, 0);
-  crc = crc32((FAR const uint8_t *)&blkhdr, SIZEOF_NXFFS_DATA_HDR);
+  crc = crc32((FAR const uint8_t *)&blkhdr, hdrlen);
   crc = crc32part(&volume->cache[doffset], dlen, crc);
 
   if (crc != ecrc)
@@ -463,8 +506,13 @@ int nxffs_rdblkhdr(FAR struct nxffs_volume_s *volume, off_t offset,
       return -EIO;
     }
 
-  /* Looks good! Return the data length and success */
+  /* Looks good! Return the data block description and success */
 
-  *datlen = dlen;
+  blkentry->hoffset = offset;
+  blkentry->owner   = hdrlen == SIZEOF_NXFFS_DATA_HDR ?
+                      (off_t)nxffs_rdle32(blkhdr.owner) : 0;
+  blkentry->datlen  = dlen;
+  blkentry->foffset = 0;
+  blkentry->hdrlen  = hdrlen;
   return OK;
 }
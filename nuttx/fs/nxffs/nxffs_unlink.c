@@ -75,8 +75,8 @@
  * Name: nxffs_rminode
  *
  * Description:
- *   Remove an inode from FLASH.  This is the internal implementation of
- *   the file system unlinke operation.
+ *   Remove an inode from FLASH (and from the inode index).  This is the
+ *   internal implementation of the file system unlink operation.
  *
  * Input Parameters:
  *   volume - Describes the NXFFS volume.
@@ -144,8 +144,13 @@ int nxffs_rminode(FAR struct nxffs_volume_s *volume, FAR const char *name)
     {
       fdbg("ERROR: Failed to write block %d: %d\n",
            volume->ioblock, ret);
+      goto errout_with_entry;
     }
 
+  /* And forget about the inode */
+
+  nxffs_rmindex(volume, entry.hoffset);
+
 errout_with_entry:
   nxffs_freeentry(&entry);
 errout:
@@ -182,6 +187,10 @@ int nxffs_unlink(FAR struct inode *mountpt, FAR const char *relpath)
   /* Then remove the NXFFS inode */
 
   ret = nxffs_rminode(volume, relpath);
+  if (ret == OK)
+    {
+      nxffs_packsched(volume);
+    }
 
   sem_post(&volume->exclsem);
 errout:
@@ -48,6 +48,7 @@
 #include <errno.h>
 #include <debug.h>
 
+#include <nuttx/clock.h>
 #include <nuttx/fs/fs.h>
 #include <nuttx/mtd/mtd.h>
 
@@ -198,7 +199,9 @@ static inline int nxffs_hdrerased(FAR struct nxffs_volume_s *volume,
  * Name: nxffs_wralloc
  *
  * Description:
- *   Allocate FLASH memory for the data block.
+ *   Allocate FLASH memory for the data block.  The remainder of the logical
+ *   block that holds the new data block is reserved for this writer so that
+ *   the data block may grow without interference from other writers.
  *
  * Input Parameters:
  *   volume - Describes the NXFFS volume
@@ -243,12 +246,22 @@ static inline int nxffs_wralloc(FAR struct nxffs_volume_s *volume,
           ret = nxffs_hdrerased(volume, wrfile, mindata);
           if (ret == OK)
             {
-              /* Valid memory for the data block was found.  Return success. */
+              /* Valid memory for the data block was found.  Reserve the
+               * rest of the logical block and return success.
+               */
 
+              volume->froffset = (wrfile->doffset / volume->geo.blocksize + 1) *
+                                 volume->geo.blocksize;
               return OK;
             }
         }
 
+      /* Forget about any partial reservation.  The packing logic must not
+       * mistake it for an unfinished data block.
+       */
+
+      wrfile->doffset = 0;
+
       /* If no valid memory is found searching to the end of the volume,
        * then -ENOSPC will be returned.  Other errors are not handled.
        */
@@ -450,10 +463,16 @@ ssize_t nxffs_write(FAR struct file *filep, FAR const char *buffer, size_t bufle
   ssize_t remaining;
   ssize_t nwritten;
   ssize_t total;
+  uint32_t start;
+  uint32_t elapsed;
   int ret;
 
   fvdbg("Write %d bytes to offset %d\n", buflen, filep->f_pos);
 
+  /* The write latency includes the time spent waiting for the volume */
+
+  start = clock_systimer();
+
   /* Sanity checks */
 
   DEBUGASSERT(filep->f_priv != NULL && filep->f_inode != NULL);
@@ -511,9 +530,19 @@ ssize_t nxffs_write(FAR struct file *filep, FAR const char *buffer, size_t bufle
             }
         }
 
-      /* Seek to the FLASH block containing the data block */
+      /* Seek to the FLASH block containing the data block and make sure
+       * that it is in the cache.  Other writers may have used the cache
+       * since the last write.
+       */
 
       nxffs_ioseek(volume, wrfile->doffset);
+      ret = nxffs_rdcache(volume, volume->ioblock);
+      if (ret < 0)
+        {
+          fdbg("ERROR: Failed to read data block %d: %d\n",
+               volume->ioblock, -ret);
+          goto errout_with_semaphore;
+        }
 
       /* Verify that the FLASH data that was previously written is still intact */
 
@@ -543,9 +572,16 @@ ssize_t nxffs_write(FAR struct file *filep, FAR const char *buffer, size_t bufle
   /* Success.. return the number of bytes written */
 
   ret           = total;
-  filep->f_pos  = wrfile->datlen;
+  filep->f_pos  = wrfile->ofile.entry.datlen + wrfile->datlen;
+  nxffs_packsched(volume);
 
 errout_with_semaphore:
+  elapsed = TICK2MSEC(clock_systimer() - start);
+  if (elapsed > volume->stats.ps_maxwrite)
+    {
+      volume->stats.ps_maxwrite = elapsed;
+    }
+
   sem_post(&volume->exclsem);
 errout:
   return ret;
@@ -743,6 +779,7 @@ int nxffs_wrverify(FAR struct nxffs_volume_s *volume, size_t size)
 
                        /* Update the free flash offset and return success */
 
+                       volume->iooffset = iooffset;
                        volume->froffset = offset + size;
                        return OK;
                     }
@@ -792,7 +829,14 @@ int nxffs_wrverify(FAR struct nxffs_volume_s *volume, size_t size)
  * Description:
  *   Write the block header information.  This is done (1) whenever the end-
  *   block is encountered and (2) also when the file is closed in order to
- *   flush the final block of data to FLASH.
+ *   flush the final block of data to FLASH.  The data block header is
+ *   tagged with the offset to the inode header of the file so that data
+ *   blocks of concurrent writers can be interleaved.
+ *
+ *   The unused remainder of the logical block reserved by nxffs_wralloc()
+ *   is returned to the free FLASH region if nothing has been allocated
+ *   after it.  Otherwise, the remainder is simply abandoned; it will be
+ *   recovered when the volume is packed.
  *
  * Input Parameters:
  *   volume - Describes the state of the NXFFS volume
@@ -808,15 +852,48 @@ int nxffs_wrblkhdr(FAR struct nxffs_volume_s *volume,
                    FAR struct nxffs_wrfile_s *wrfile)
 {
   FAR struct nxffs_data_s *dathdr;
+  off_t blkend;
   int ret;
 
-  /* Write the data block header to memory */
+  /* Get the offset to the end of the logical block that was reserved for
+   * the data block.
+   */
+
+  blkend = (wrfile->doffset / volume->geo.blocksize + 1) *
+           volume->geo.blocksize;
+
+  /* If no data was written and no other object has been allocated after
+   * the data block, then simply release the reserved FLASH memory.
+   * Otherwise, an empty data block header must be written; an erased
+   * logical block within the valid FLASH region would look like the end of
+   * the valid data when the volume is next mounted.
+   */
+
+  if (wrfile->datlen == 0 && volume->froffset == blkend)
+    {
+      volume->froffset = wrfile->doffset;
+      ret = OK;
+      goto errout;
+    }
+
+  /* Make sure that the block containing the data block is in the cache */
 
   nxffs_ioseek(volume, wrfile->doffset);
+  ret = nxffs_rdcache(volume, volume->ioblock);
+  if (ret < 0)
+    {
+      fdbg("ERROR: Failed to read data block %d: %d\n",
+           volume->ioblock, -ret);
+      goto errout;
+    }
+
+  /* Write the data block header to memory */
+
   dathdr = (FAR struct nxffs_data_s *)&volume->cache[volume->iooffset];
-  memcpy(dathdr->magic, g_datamagic, NXFFS_MAGICSIZE);
+  memcpy(dathdr->magic, g_tagmagic, NXFFS_MAGICSIZE);
   nxffs_wrle32(dathdr->crc, 0);
   nxffs_wrle16(dathdr->datlen, wrfile->datlen);
+  nxffs_wrle32(dathdr->owner, wrfile->ofile.entry.hoffset);
 
   /* Update the entire data block CRC (including the header) */
 
@@ -836,22 +913,26 @@ int nxffs_wrblkhdr(FAR struct nxffs_volume_s *volume,
    * statistics and reset the write state.
    *
    * volume:
-   *   froffset - The offset the next free FLASH region.  Set to just after
-   *     the inode data block that we just wrote.  This is where we will
-   *     begin the search for the next inode header or data block.
+   *   froffset - The offset the next free FLASH region.  If nothing was
+   *     allocated after the reserved logical block, set to just after the
+   *     inode data block that we just wrote.  This is where we will begin
+   *     the search for the next inode header or data block.
    */
 
-  volume->froffset = (wrfile->doffset + wrfile->datlen + SIZEOF_NXFFS_DATA_HDR);
+  if (volume->froffset == blkend)
+    {
+      volume->froffset = (wrfile->doffset + wrfile->datlen + SIZEOF_NXFFS_DATA_HDR);
+    }
 
   /* wrfile->file.entry:
    *   datlen:  Total file length accumulated so far.  When the file is
    *     closed, this will hold the file length.
-   *   doffset: Offset to the first data block.  Only the offset to the
-   *     first data block is saved.
+   *   doffset: Offset to the first (non-empty) data block.  Only the offset
+   *     to the first data block is saved.
    */
 
   wrfile->ofile.entry.datlen += wrfile->datlen;
-  if (wrfile->ofile.entry.doffset == 0)
+  if (wrfile->ofile.entry.doffset == 0 && wrfile->datlen > 0)
     {
       wrfile->ofile.entry.doffset = wrfile->doffset;
     }
@@ -119,18 +119,23 @@
  *                 |               |
  *               --+---------------+
  *
+ * With CONFIG_SMARTFS_32BIT_SECTORS, logical sector numbers are 4 bytes:
+ * The upper 2 bytes of the logical sector number follow the status bits in
+ * the sector header and the number of the next logical sector in the chain
+ * is 4 bytes long.
+ *
  * General operation:
  *   Physical sectors are allocated and assigned a logical sector number
  *   and a starting sequence number of zero.
  *
  * SECTOR HEADER:
- *   The sector header (first 5 bytes) tracks the state of each sector and
+ *   The sector header (first 5 or 7 bytes) tracks the state of each sector and
  *   is used by the SMART MTD block driver.  At the block level, there is
  *   no notion of sector chaining, only allocated sectors within erase
  *   blocks.
  *
  * FILE SYSTEM (FS) HEADER:
- *   The file system header (next 5 bytes) tracks file and directory entries
+ *   The file system header (next 5 or 7 bytes) tracks file and directory entries
  *   and chains.
  *
  * SMART Limitations:
@@ -141,9 +146,11 @@
  *    existing sector data is overwritten with new data. Thus, occasionally,
  *    file writing may take longer than other times.
  * 3. The implementation curently does not track bad blocks on the device.
- * 4. There is no true wear-leveling implemented yet, though provesion have
- *    been made to reserve logical sectors to allow it to be added using
- *    a "sector aging" tracking mechanism.
+ * 4. Wear leveling is optional (CONFIG_MTD_SMART_WEAR_LEVEL).  The erase
+ *    block wear levels are kept in the "sector aging" area of the format
+ *    sector.
+ * 5. Without CONFIG_SMARTFS_32BIT_SECTORS, a volume is limited to 65534
+ *    logical sectors.
  */
 
 /* Values for SMART inode state.
@@ -206,11 +213,21 @@
 #define SMARTFS_ERASEDSTATE_16BIT (uint16_t) ((CONFIG_SMARTFS_ERASEDSTATE << 8) | \
                                     CONFIG_SMARTFS_ERASEDSTATE)
 
+/* The erased state of a sector number, marking the end of a sector chain */
+
+#ifdef CONFIG_SMARTFS_32BIT_SECTORS
+#define SMARTFS_ERASEDSTATE_SECTOR (smart_sector_t) \
+                                    (((uint32_t) SMARTFS_ERASEDSTATE_16BIT << 16) | \
+                                     SMARTFS_ERASEDSTATE_16BIT)
+#else
+#define SMARTFS_ERASEDSTATE_SECTOR SMARTFS_ERASEDSTATE_16BIT
+#endif
+
 #ifndef offsetof
 #define offsetof(type, member)   ( (size_t) &( ( (type *) 0)->member))
 #endif
 
-#define SMARTFS_NEXTSECTOR(h)    ( *((uint16_t *) h->nextsector))
+#define SMARTFS_NEXTSECTOR(h)    ( *((smart_sector_t *) h->nextsector))
 #define SMARTFS_USED(h)          ( *((uint16_t *) h->used))
 
 /****************************************************************************
@@ -225,10 +242,10 @@
 
 struct smartfs_entry_s
 {
-  uint16_t          firstsector;  /* Sector number of the name */
-  uint16_t          dsector;      /* Sector number of the directory entry */
+  smart_sector_t    firstsector;  /* Sector number of the name */
+  smart_sector_t    dsector;      /* Sector number of the directory entry */
   uint16_t          doffset;      /* Offset of the directory entry */
-  uint16_t          dfirst;       /* 1st sector number of the directory entry */
+  smart_sector_t    dfirst;       /* 1st sector number of the directory entry */
   uint16_t          flags;        /* Flags, including mode */
   FAR char          *name;        /* inode name */
   uint32_t          utc;          /* Time stamp */
@@ -245,7 +262,12 @@ struct smartfs_entry_header_s
                                       15:   Empty entry
                                       14:   Active entry
                                       12-0: Permissions bits */
+#ifdef CONFIG_SMARTFS_32BIT_SECTORS
+  uint16_t          reserved;     /* Keeps firstsector aligned (erased state) */
+  uint32_t          firstsector;  /* Sector number of the name */
+#else
   int16_t           firstsector;  /* Sector number of the name */
+#endif
   uint32_t          utc;          /* Time stamp */
   char              name[0];      /* inode name */
 };
@@ -257,7 +279,8 @@ struct smartfs_entry_header_s
 struct smartfs_chain_header_s
 {
   uint8_t           type;         /* Type of sector entry (file or dir) */
-  uint8_t           nextsector[2];/* Next logical sector in the chain */
+  uint8_t           nextsector[sizeof(smart_sector_t)];
+                                  /* Next logical sector in the chain */
   uint8_t           used[2];      /* Number of bytes used in this sector */
 };
 
@@ -272,7 +295,7 @@ struct smartfs_ofile_s
   mode_t                    oflags;     /* Open mode */
   struct smartfs_entry_s    entry;      /* Describes the SMARTFS inode entry */
   size_t                    filepos;    /* Current file position */
-  uint16_t                  currsector; /* Current sector of filepos */
+  smart_sector_t            currsector; /* Current sector of filepos */
   uint16_t                  curroffset; /* Current offset in sector */
   uint16_t                  byteswritten;/* Count of bytes written to currsector
                                           * that have not been recorded in the
@@ -289,9 +312,7 @@ struct smartfs_ofile_s
 
 struct smartfs_mountpt_s
 {
-#ifdef CONFIG_SMARTFS_MULTI_ROOT_DIRS
   struct smartfs_mountpt_s   *fs_next;      /* Pointer to next SMART filesystem */
-#endif
   FAR struct inode           *fs_blkdriver; /* Our underlying block device */
   sem_t                      *fs_sem;       /* Used to assure thread-safe access */
   FAR struct smartfs_ofile_s *fs_head;      /* A singly-linked list of open files */
@@ -327,13 +348,13 @@ int smartfs_unmount(struct smartfs_mountpt_s *fs);
 
 int smartfs_finddirentry(struct smartfs_mountpt_s *fs,
         struct smartfs_entry_s *direntry, const char *relpath,
-        uint16_t *parentdirsector, const char **filename);
+        smart_sector_t *parentdirsector, const char **filename);
 
 int smartfs_createentry(struct smartfs_mountpt_s *fs,
-        uint16_t parentdirsector, const char* filename,
+        smart_sector_t parentdirsector, const char* filename,
         uint16_t type,
         mode_t mode, struct smartfs_entry_s *direntry,
-        uint16_t sectorno);
+        smart_sector_t sectorno);
 
 int smartfs_deleteentry(struct smartfs_mountpt_s *fs,
         struct smartfs_entry_s *entry);
@@ -344,6 +365,10 @@ int smartfs_countdirentries(struct smartfs_mountpt_s *fs,
 int smartfs_truncatefile(struct smartfs_mountpt_s *fs,
         struct smartfs_entry_s *entry);
 
+#if defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_SMARTFS)
+FAR struct smartfs_mountpt_s *smartfs_get_first_mount(void);
+#endif
+
 struct file;        /* Forward references */
 struct inode;
 struct fs_dirent_s;
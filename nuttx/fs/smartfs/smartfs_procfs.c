@@ -59,46 +59,77 @@
 #include <nuttx/fs/fs.h>
 #include <nuttx/fs/procfs.h>
 #include <nuttx/fs/dirent.h>
+#include <nuttx/fs/ioctl.h>
+#include <nuttx/fs/smart.h>
 
 #include <arch/irq.h>
 
-#if defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_EXCLUDE_SMARTFS)
+#include "smartfs.h"
+
+#if defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_SMARTFS)
 
 /****************************************************************************
  * Pre-processor Definitions
  ****************************************************************************/
+/* Determines the size of an intermediate buffer that must be large enough
+ * to handle the longest line generated by this logic.
+ */
+
+#define SMARTFS_LINELEN       96
+
+/* The number of erase counts shown on each line of the erasemap */
+
+#define SMARTFS_ERASEMAP_COLS 8
 
 /****************************************************************************
  * Private Types
  ****************************************************************************/
-/* This enumeration identifies all of the thread attributes that can be
+/* This enumeration identifies all of the device attributes that can be
  * accessed via the procfs file system.
  */
 
+enum smartfs_attr_e
+{
+  SMARTFS_STATUS = 0,                 /* Device status and statistics */
+  SMARTFS_ERASEMAP,                   /* Erase count of each erase block */
+  SMARTFS_NATTRS
+};
+
 /* This structure describes one open "file" */
 
 struct smartfs_file_s
 {
-  struct procfs_file_s  base;        /* Base open file structure */
-
-  /* Add context specific data types for managing an open file here */
+  struct procfs_file_s  base;         /* Base open file structure */
+  FAR struct smartfs_mountpt_s *mount; /* The SMART mount being reported */
+  uint8_t attr;                       /* The attribute (see smartfs_attr_e) */
+  char line[SMARTFS_LINELEN];         /* Pre-allocated buffer for formatted lines */
 };
 
-/* Level 1 is the directory of attributes */
+/* Level 1 is the directory of mounted devices.  Level 2 is the directory
+ * of attributes of one device.
+ */
 
 struct smartfs_level1_s
 {
-  struct procfs_dir_priv_s  base;    /* Base directory private data */
-
-  /* Add context specific data types here for managing the directory
-   * open / read / stat, etc.
-   */
-
+  struct procfs_dir_priv_s  base;     /* Base directory private data */
+  FAR struct smartfs_mountpt_s *mount; /* The device (level 2 only) */
 };
 
 /****************************************************************************
  * Private Function Prototypes
  ****************************************************************************/
+/* Helpers */
+
+static int     smartfs_find_dirref(FAR const char *relpath,
+                 FAR struct smartfs_mountpt_s **mount, FAR int *attr);
+static bool    smartfs_ismounted(FAR struct smartfs_mountpt_s *mount);
+static ssize_t smartfs_status(FAR struct smartfs_file_s *priv,
+                 FAR struct smart_procfs_data_s *data, FAR char *buffer,
+                 size_t buflen, off_t offset);
+static ssize_t smartfs_erasemap(FAR struct smartfs_file_s *priv,
+                 FAR struct smart_procfs_data_s *data, FAR char *buffer,
+                 size_t buflen, off_t offset);
+
 /* File system methods */
 
 static int     smartfs_open(FAR struct file *filep, FAR const char *relpath,
@@ -121,6 +152,14 @@ static int     smartfs_stat(FAR const char *relpath, FAR struct stat *buf);
  * Private Variables
  ****************************************************************************/
 
+/* The names of the device attributes (indexed by smartfs_attr_e) */
+
+static FAR const char * const g_smartfs_attrs[SMARTFS_NATTRS] =
+{
+  "status",
+  "erasemap"
+};
+
 /****************************************************************************
  * Public Variables
  ****************************************************************************/
@@ -153,6 +192,288 @@ const struct procfs_operations smartfs_procfsoperations =
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: smartfs_find_dirref
+ *
+ * Description:
+ *   Analyze relpath to find the directory level it refers to.  Returns 1
+ *   for "fs/smartfs", 2 for "fs/smartfs/<dev>" and 3 for
+ *   "fs/smartfs/<dev>/<attr>", or -ENOENT if there is no such entry.
+ *
+ ****************************************************************************/
+
+static int smartfs_find_dirref(FAR const char *relpath,
+                               FAR struct smartfs_mountpt_s **mount,
+                               FAR int *attr)
+{
+  FAR struct smartfs_mountpt_s *fs;
+  FAR const char *str;
+  size_t len;
+  int x;
+
+  *mount = NULL;
+  *attr  = -1;
+
+  /* Skip the "fs/smartfs" part of the path */
+
+  if (strncmp(relpath, "fs/smartfs", 10) != 0)
+    {
+      return -ENOENT;
+    }
+
+  relpath += 10;
+  if (*relpath == '/')
+    {
+      relpath++;
+    }
+
+  if (*relpath == '\0')
+    {
+      return 1;
+    }
+
+  /* The next segment is the name of the block driver of a mounted device */
+
+  str = strchr(relpath, '/');
+  len = str ? str - relpath : strlen(relpath);
+
+  for (fs = smartfs_get_first_mount(); fs != NULL; fs = fs->fs_next)
+    {
+      if (fs->fs_blkdriver != NULL &&
+          strlen(fs->fs_blkdriver->i_name) == len &&
+          strncmp(fs->fs_blkdriver->i_name, relpath, len) == 0)
+        {
+          break;
+        }
+    }
+
+  if (fs == NULL)
+    {
+      return -ENOENT;
+    }
+
+  *mount = fs;
+  if (str == NULL || str[1] == '\0')
+    {
+      return 2;
+    }
+
+  /* The last segment is the attribute */
+
+  for (x = 0; x < SMARTFS_NATTRS; x++)
+    {
+      if (strcmp(&str[1], g_smartfs_attrs[x]) == 0)
+        {
+          *attr = x;
+          return 3;
+        }
+    }
+
+  return -ENOENT;
+}
+
+/****************************************************************************
+ * Name: smartfs_ismounted
+ *
+ * Description:
+ *   Test if the mount referenced by an open file is still mounted.
+ *
+ ****************************************************************************/
+
+static bool smartfs_ismounted(FAR struct smartfs_mountpt_s *mount)
+{
+  FAR struct smartfs_mountpt_s *fs;
+
+  for (fs = smartfs_get_first_mount(); fs != NULL; fs = fs->fs_next)
+    {
+      if (fs == mount)
+        {
+          return true;
+        }
+    }
+
+  return false;
+}
+
+/****************************************************************************
+ * Name: smartfs_status
+ ****************************************************************************/
+
+static ssize_t smartfs_status(FAR struct smartfs_file_s *priv,
+                              FAR struct smart_procfs_data_s *data,
+                              FAR char *buffer, size_t buflen, off_t offset)
+{
+  size_t remaining;
+  size_t linesize;
+  size_t copysize;
+  size_t totalsize;
+  int x;
+
+  remaining = buflen;
+  totalsize = 0;
+
+  for (x = 0; x < 13 && totalsize < buflen; x++)
+    {
+      switch (x)
+        {
+        case 0:
+          linesize = snprintf(priv->line, SMARTFS_LINELEN,
+                              "%-18s%d\n", "Format version:",
+                              data->formatversion);
+          break;
+
+        case 1:
+          linesize = snprintf(priv->line, SMARTFS_LINELEN,
+                              "%-18s%d\n", "Sector size:",
+                              data->sectorsize);
+          break;
+
+        case 2:
+          linesize = snprintf(priv->line, SMARTFS_LINELEN,
+                              "%-18s%lu (%d per erase block)\n", "Sectors:",
+                              (unsigned long)data->totalsectors,
+                              data->sectorsperblk);
+          break;
+
+        case 3:
+          linesize = snprintf(priv->line, SMARTFS_LINELEN,
+                              "%-18s%lu\n", "Free sectors:",
+                              (unsigned long)data->freesectors);
+          break;
+
+        case 4:
+          linesize = snprintf(priv->line, SMARTFS_LINELEN,
+                              "%-18s%lu\n", "Released sectors:",
+                              (unsigned long)data->releasesectors);
+          break;
+
+        case 5:
+          linesize = snprintf(priv->line, SMARTFS_LINELEN,
+                              "%-18s%lu bytes\n", "Sector map:",
+                              (unsigned long)data->mapsize);
+          break;
+
+        case 6:
+          linesize = snprintf(priv->line, SMARTFS_LINELEN,
+                              "%-18s%lu ms\n", "Mount scan:",
+                              (unsigned long)data->scantime);
+          break;
+
+        case 7:
+          linesize = snprintf(priv->line, SMARTFS_LINELEN,
+                              "%-18s%lu\n", "Erases:",
+                              (unsigned long)data->nerases);
+          break;
+
+        case 8:
+          linesize = snprintf(priv->line, SMARTFS_LINELEN,
+                              "%-18s%lu foreground, %lu background\n",
+                              "Collections:",
+                              (unsigned long)data->ncollections,
+                              (unsigned long)data->nbgcollections);
+          break;
+
+        case 9:
+          linesize = snprintf(priv->line, SMARTFS_LINELEN,
+                              "%-18s%lu\n", "Wear moves:",
+                              (unsigned long)data->nwearmoves);
+          break;
+
+        case 10:
+          linesize = snprintf(priv->line, SMARTFS_LINELEN,
+                              "%-18smax %lu ms, total %lu ms\n",
+                              "Collection time:",
+                              (unsigned long)data->gcmaxtime,
+                              (unsigned long)data->gctotaltime);
+          break;
+
+        case 11:
+          linesize = snprintf(priv->line, SMARTFS_LINELEN,
+                              "%-18s%lu ms\n", "Background time:",
+                              (unsigned long)data->bgtotaltime);
+          break;
+
+        default:
+          if (data->wearlevel != NULL)
+            {
+              linesize = snprintf(priv->line, SMARTFS_LINELEN,
+                                  "%-18s%lu - %lu erases\n", "Wear:",
+                                  (unsigned long)data->wearbase +
+                                    data->minwear,
+                                  (unsigned long)data->wearbase +
+                                    data->maxwear);
+            }
+          else
+            {
+              linesize = snprintf(priv->line, SMARTFS_LINELEN,
+                                  "%-18snot tracked\n", "Wear:");
+            }
+          break;
+        }
+
+      copysize   = procfs_memcpy(priv->line, linesize, buffer, remaining,
+                                 &offset);
+
+      totalsize += copysize;
+      buffer    += copysize;
+      remaining -= copysize;
+    }
+
+  return totalsize;
+}
+
+/****************************************************************************
+ * Name: smartfs_erasemap
+ ****************************************************************************/
+
+static ssize_t smartfs_erasemap(FAR struct smartfs_file_s *priv,
+                                FAR struct smart_procfs_data_s *data,
+                                FAR char *buffer, size_t buflen,
+                                off_t offset)
+{
+  size_t remaining;
+  size_t linesize;
+  size_t copysize;
+  size_t totalsize;
+  int block;
+  int x;
+
+  if (data->wearlevel == NULL)
+    {
+      linesize = snprintf(priv->line, SMARTFS_LINELEN, "not tracked\n");
+      return procfs_memcpy(priv->line, linesize, buffer, buflen, &offset);
+    }
+
+  remaining = buflen;
+  totalsize = 0;
+
+  /* Show the absolute erase count of each erase block, a few per line */
+
+  for (block = 0; block < data->neraseblocks && totalsize < buflen; )
+    {
+      linesize = snprintf(priv->line, SMARTFS_LINELEN, "%5d:", block);
+      for (x = 0; x < SMARTFS_ERASEMAP_COLS && block < data->neraseblocks;
+           x++, block++)
+        {
+          linesize += snprintf(&priv->line[linesize],
+                               SMARTFS_LINELEN - linesize, " %7lu",
+                               (unsigned long)data->wearbase +
+                                 data->wearlevel[block]);
+        }
+
+      priv->line[linesize++] = '\n';
+
+      copysize   = procfs_memcpy(priv->line, linesize, buffer, remaining,
+                                 &offset);
+
+      totalsize += copysize;
+      buffer    += copysize;
+      remaining -= copysize;
+    }
+
+  return totalsize;
+}
+
 /****************************************************************************
  * Name: smartfs_open
  ****************************************************************************/
@@ -161,6 +482,9 @@ static int smartfs_open(FAR struct file *filep, FAR const char *relpath,
                       int oflags, mode_t mode)
 {
   FAR struct smartfs_file_s *priv;
+  FAR struct smartfs_mountpt_s *mount;
+  int attr;
+  int ret;
 
   fvdbg("Open '%s'\n", relpath);
 
@@ -177,7 +501,21 @@ static int smartfs_open(FAR struct file *filep, FAR const char *relpath,
       return -EACCES;
     }
 
-  /* Allocate a container to hold the task and attribute selection */
+  /* Only the attributes of a mounted device can be opened as files */
+
+  ret = smartfs_find_dirref(relpath, &mount, &attr);
+  if (ret < 0)
+    {
+      fdbg("ERROR: '%s' not found\n", relpath);
+      return ret;
+    }
+  else if (ret != 3)
+    {
+      fdbg("ERROR: '%s' is a directory\n", relpath);
+      return -EISDIR;
+    }
+
+  /* Allocate a container to hold the device and attribute selection */
 
   priv = (FAR struct smartfs_file_s *)kzalloc(sizeof(struct smartfs_file_s));
   if (!priv)
@@ -186,8 +524,8 @@ static int smartfs_open(FAR struct file *filep, FAR const char *relpath,
       return -ENOMEM;
     }
 
-  /* TODO: Initialize the context specific data here */
-
+  priv->mount = mount;
+  priv->attr  = (uint8_t)attr;
 
   /* Save the index as the open-specific state in filep->f_priv */
 
@@ -223,6 +561,7 @@ static ssize_t smartfs_read(FAR struct file *filep, FAR char *buffer,
                            size_t buflen)
 {
   FAR struct smartfs_file_s *priv;
+  struct smart_procfs_data_s data;
   ssize_t ret;
 
   fvdbg("buffer=%p buflen=%d\n", buffer, (int)buflen);
@@ -232,9 +571,35 @@ static ssize_t smartfs_read(FAR struct file *filep, FAR char *buffer,
   priv = (FAR struct smartfs_file_s *)filep->f_priv;
   DEBUGASSERT(priv);
 
-  /* TODO: Provide the requested data */
+  /* The device may have been unmounted since the file was opened */
+
+  if (!smartfs_ismounted(priv->mount))
+    {
+      return -ENODEV;
+    }
+
+  /* Get the status of the device from the SMART block driver */
+
+  smartfs_semtake(priv->mount);
+  ret = FS_IOCTL(priv->mount, BIOC_GETPROCFSD, (unsigned long)&data);
+  smartfs_semgive(priv->mount);
 
-  ret = 0;
+  if (ret < 0)
+    {
+      fdbg("ERROR: BIOC_GETPROCFSD failed: %d\n", (int)ret);
+      return ret;
+    }
+
+  /* Provide the requested data */
+
+  if (priv->attr == SMARTFS_STATUS)
+    {
+      ret = smartfs_status(priv, &data, buffer, buflen, filep->f_pos);
+    }
+  else
+    {
+      ret = smartfs_erasemap(priv, &data, buffer, buflen, filep->f_pos);
+    }
 
   /* Update the file offset */
 
@@ -296,13 +661,27 @@ static int smartfs_dup(FAR const struct file *oldp, FAR struct file *newp)
 static int smartfs_opendir(FAR const char *relpath, FAR struct fs_dirent_s *dir)
 {
   FAR struct smartfs_level1_s *level1;
+  FAR struct smartfs_mountpt_s *mount;
+  FAR struct smartfs_mountpt_s *fs;
+  int attr;
+  int ret;
 
   fvdbg("relpath: \"%s\"\n", relpath ? relpath : "NULL");
   DEBUGASSERT(relpath && dir && !dir->u.procfs);
 
-  /* The path refers to the 1st level sbdirectory.  Allocate the level1
-   * dirent structure.
-   */
+  /* Only the list of devices and the devices are directories */
+
+  ret = smartfs_find_dirref(relpath, &mount, &attr);
+  if (ret < 0)
+    {
+      return ret;
+    }
+  else if (ret == 3)
+    {
+      return -ENOTDIR;
+    }
+
+  /* Allocate the level1 dirent structure. */
 
   level1 = (FAR struct smartfs_level1_s *)
      kzalloc(sizeof(struct smartfs_level1_s));
@@ -313,14 +692,24 @@ static int smartfs_opendir(FAR const char *relpath, FAR struct fs_dirent_s *dir)
       return -ENOMEM;
     }
 
-  /* TODO:  Initialze context specific data */
-
-
   /* Initialze base structure components */
 
-  level1->base.level    = 1;
-  level1->base.nentries = 0;
+  level1->base.level    = (uint8_t)ret;
   level1->base.index    = 0;
+  level1->mount         = mount;
+
+  if (ret == 1)
+    {
+      level1->base.nentries = 0;
+      for (fs = smartfs_get_first_mount(); fs != NULL; fs = fs->fs_next)
+        {
+          level1->base.nentries++;
+        }
+    }
+  else
+    {
+      level1->base.nentries = SMARTFS_NATTRS;
+    }
 
   dir->u.procfs = (FAR void *) level1;
   return OK;
@@ -359,17 +748,12 @@ static int smartfs_closedir(FAR struct fs_dirent_s *dir)
 static int smartfs_readdir(struct fs_dirent_s *dir)
 {
   FAR struct smartfs_level1_s *level1;
-  char  filename[16];
-  int ret, index;
+  FAR struct smartfs_mountpt_s *fs;
+  int ret, index, x;
 
   DEBUGASSERT(dir && dir->u.procfs);
   level1 = dir->u.procfs;
 
-  /* TODO: Perform device specific readdir function here.  This may
-   *       or may not involve validating the nentries variable
-   *       in the base depending on the implementation.
-   */
-
   /* Have we reached the end of the directory */
 
   index = level1->base.index;
@@ -383,25 +767,47 @@ static int smartfs_readdir(struct fs_dirent_s *dir)
       ret = -ENOENT;
     }
 
-  /* We are tranversing a subdirectory of task attributes */
+  /* Are we listing the mounted devices? */
 
-  else
+  else if (level1->base.level == 1)
     {
-      DEBUGASSERT(level1->base.level == 1);
+      /* Find the index'th mount.  Mounts may have come or gone since the
+       * directory was opened.
+       */
 
-      /* TODO: Add device specific entries */
+      fs = smartfs_get_first_mount();
+      for (x = 0; x < index && fs != NULL; x++)
+        {
+          fs = fs->fs_next;
+        }
 
-      strcpy(filename, "dummy");
+      if (fs == NULL || fs->fs_blkdriver == NULL)
+        {
+          fvdbg("Entry %d: End of directory\n", index);
+          return -ENOENT;
+        }
 
-      /* TODO:  Specify the type of entry */
+      dir->fd_dir.d_type = DTYPE_DIRECTORY;
+      strncpy(dir->fd_dir.d_name, fs->fs_blkdriver->i_name, NAME_MAX+1);
+
+      level1->base.index = index + 1;
+      ret = OK;
+    }
+
+  /* We are tranversing a subdirectory of device attributes */
+
+  else
+    {
+      DEBUGASSERT(level1->base.level == 2);
 
       dir->fd_dir.d_type = DTYPE_FILE;
-      strncpy(dir->fd_dir.d_name, filename, NAME_MAX+1);
+      strncpy(dir->fd_dir.d_name, g_smartfs_attrs[index], NAME_MAX+1);
 
       /* Set up the next directory entry offset.  NOTE that we could use the
        * standard f_pos instead of our own private index.
        */
 
+      level1->base.index = index + 1;
       ret = OK;
     }
 
@@ -435,18 +841,33 @@ static int smartfs_rewinddir(struct fs_dirent_s *dir)
 
 static int smartfs_stat(const char *relpath, struct stat *buf)
 {
-  /* TODO:  Decide if the relpath is valid and if it is a file
-   *        or a directory and set it's permissions.
-   */
+  FAR struct smartfs_mountpt_s *mount;
+  int attr;
+  int ret;
+
+  /* Decide if the relpath is valid and if it is a file or a directory */
 
-  buf->st_mode = S_IFDIR|S_IROTH|S_IRGRP|S_IRUSR;
+  ret = smartfs_find_dirref(relpath, &mount, &attr);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  if (ret == 3)
+    {
+      buf->st_mode = S_IFREG|S_IROTH|S_IRGRP|S_IRUSR;
+    }
+  else
+    {
+      buf->st_mode = S_IFDIR|S_IROTH|S_IRGRP|S_IRUSR;
+    }
 
   /* File/directory size, access block size */
 
   buf->st_size    = 0;
   buf->st_blksize = 0;
   buf->st_blocks  = 0;
-  
+
   return OK;
 }
 
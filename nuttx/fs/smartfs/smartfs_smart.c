@@ -166,7 +166,7 @@ static int smartfs_open(FAR struct file *filep, const char *relpath,
   struct inode             *inode;
   struct smartfs_mountpt_s *fs;
   int                       ret;
-  uint16_t                  parentdirsector;
+  smart_sector_t            parentdirsector;
   const char               *filename;
   struct smartfs_ofile_s   *sf;
 
@@ -262,13 +262,13 @@ static int smartfs_open(FAR struct file *filep, const char *relpath,
 
       /* Yes... test if the parent directory is valid */
       
-      if (parentdirsector != 0xFFFF)
+      if (parentdirsector != SMART_SECTOR_NONE)
         {
           /* We can create in the given parent directory */
 
           ret = smartfs_createentry(fs, parentdirsector, filename, 
                                     SMARTFS_DIRENT_TYPE_FILE, mode,
-                                    &sf->entry, 0xFFFF);
+                                    &sf->entry, SMART_SECTOR_NONE);
           if (ret != OK)
             {
               goto errout_with_buffer;
@@ -472,7 +472,7 @@ static ssize_t smartfs_read(FAR struct file *filep, char *buffer, size_t buflen)
     {
       /* Test if we are at the end of data */
 
-      if (sf->currsector == SMARTFS_ERASEDSTATE_16BIT)
+      if (sf->currsector == SMARTFS_ERASEDSTATE_SECTOR)
         {
           /* Break and return the number of bytes we read (may be zero) */
 
@@ -499,7 +499,7 @@ static ssize_t smartfs_read(FAR struct file *filep, char *buffer, size_t buflen)
       /* Get number of used bytes in this sector */
 
       bytesinsector = *((uint16_t *) header->used);
-      if (bytesinsector == SMARTFS_ERASEDSTATE_16BIT)
+      if (bytesinsector == SMARTFS_ERASEDSTATE_SECTOR)
         {
           /* No bytes to read from this sector */
 
@@ -540,7 +540,7 @@ static ssize_t smartfs_read(FAR struct file *filep, char *buffer, size_t buflen)
 
           /* Test if at end of data */
 
-          if (sf->currsector == SMARTFS_ERASEDSTATE_16BIT)
+          if (sf->currsector == SMARTFS_ERASEDSTATE_SECTOR)
             {
               /* No more data!  Return what we have */
 
@@ -801,7 +801,7 @@ static ssize_t smartfs_write(FAR struct file *filep, const char *buffer,
             {
               /* Allocate a new sector */
 
-              ret = FS_IOCTL(fs, BIOC_ALLOCSECT, 0xFFFF);
+              ret = FS_IOCTL(fs, BIOC_ALLOCSECT, SMART_SECTOR_NONE);
               if (ret < 0)
                 {
                   fdbg("Error %d allocating new sector\n", ret);
@@ -811,11 +811,11 @@ static ssize_t smartfs_write(FAR struct file *filep, const char *buffer,
               /* Copy the new sector to the old one and chain it */
 
               header = (struct smartfs_chain_header_s *) fs->fs_rwbuffer;
-              *((uint16_t *) header->nextsector) = (uint16_t) ret;
+              SMARTFS_NEXTSECTOR(header) = (smart_sector_t) ret;
               readwrite.offset = offsetof(struct smartfs_chain_header_s,
                 nextsector);
               readwrite.buffer = (uint8_t *) header->nextsector;
-              readwrite.count = sizeof(uint16_t);
+              readwrite.count = sizeof(smart_sector_t);
               ret = FS_IOCTL(fs, BIOC_WRITESECT, (unsigned long) &readwrite);
               if (ret < 0)
                 {
@@ -939,7 +939,7 @@ static off_t smartfs_seek_internal(struct smartfs_mountpt_s *fs,
     }
 
   header = (struct smartfs_chain_header_s *) fs->fs_rwbuffer;
-  while ((sf->currsector != SMARTFS_ERASEDSTATE_16BIT) && 
+  while ((sf->currsector != SMARTFS_ERASEDSTATE_SECTOR) && 
       (sf->filepos + fs->fs_llformat.availbytes -
       sizeof(struct smartfs_chain_header_s) < newpos))
     {
@@ -1105,7 +1105,7 @@ static int smartfs_opendir(struct inode *mountpt, const char *relpath, struct fs
   struct smartfs_mountpt_s *fs;
   int                       ret;
   struct smartfs_entry_s    entry;
-  uint16_t                  parentdirsector;
+  smart_sector_t            parentdirsector;
   const char               *filename;
 
   /* Sanity checks */
@@ -1184,7 +1184,7 @@ static int smartfs_readdir(struct inode *mountpt, struct fs_dirent_s *dir)
 
   entrysize = sizeof(struct smartfs_entry_header_s) + 
     fs->fs_llformat.namesize;
-  while (dir->u.smartfs.fs_currsector != SMARTFS_ERASEDSTATE_16BIT)
+  while (dir->u.smartfs.fs_currsector != SMARTFS_ERASEDSTATE_SECTOR)
     {
       /* Read the logical sector */
 
@@ -1481,7 +1481,7 @@ static int smartfs_unlink(struct inode *mountpt, const char *relpath)
   int                             ret = OK;
   struct smartfs_entry_s          entry;
   const char                     *filename;
-  uint16_t                        parentdirsector;
+  smart_sector_t                  parentdirsector;
 
   /* Sanity checks */
 
@@ -1542,7 +1542,7 @@ static int smartfs_mkdir(struct inode *mountpt, const char *relpath, mode_t mode
   struct smartfs_mountpt_s *fs;
   int                       ret;
   struct smartfs_entry_s    entry;
-  uint16_t                  parentdirsector;
+  smart_sector_t            parentdirsector;
   const char               *filename;
 
   /* Sanity checks */
@@ -1578,7 +1578,7 @@ static int smartfs_mkdir(struct inode *mountpt, const char *relpath, mode_t mode
       /* It doesn't exist ... we can create it, but only if we have
        * the right permissions and if the parentdirsector is valid. */
 
-      if (parentdirsector == 0xFFFF)
+      if (parentdirsector == SMART_SECTOR_NONE)
         {
           /* Invalid entry in the path (non-existant dir segment) */
 
@@ -1590,7 +1590,7 @@ static int smartfs_mkdir(struct inode *mountpt, const char *relpath, mode_t mode
       /* Create the directory */
 
       ret = smartfs_createentry(fs, parentdirsector, filename, 
-          SMARTFS_DIRENT_TYPE_DIR, mode, &entry, 0xFFFF);
+          SMARTFS_DIRENT_TYPE_DIR, mode, &entry, SMART_SECTOR_NONE);
       if (ret != OK)
         {
           goto errout_with_semaphore;
@@ -1625,7 +1625,7 @@ int smartfs_rmdir(struct inode *mountpt, const char *relpath)
   int                             ret = OK;
   struct smartfs_entry_s          entry;
   const char                     *filename;
-  uint16_t                        parentdirsector;
+  smart_sector_t                  parentdirsector;
 
   /* Sanity checks */
 
@@ -1708,14 +1708,14 @@ int smartfs_rename(struct inode *mountpt, const char *oldrelpath,
   struct smartfs_mountpt_s *fs;
   int                       ret;
   struct smartfs_entry_s    oldentry;
-  uint16_t                  oldparentdirsector;
+  smart_sector_t            oldparentdirsector;
   const char               *oldfilename;
   struct smartfs_entry_s    newentry;
-  uint16_t                  newparentdirsector;
+  smart_sector_t            newparentdirsector;
   const char               *newfilename;
   mode_t                    mode;
   uint16_t                  type;
-  uint16_t                  sector;
+  smart_sector_t            sector;
   uint16_t                  offset;
   uint16_t                  entrysize;
   struct smartfs_entry_header_s *direntry;
@@ -1766,7 +1766,7 @@ int smartfs_rename(struct inode *mountpt, const char *oldrelpath,
       /* Nope, it's a directory.  Now search the directory for oldfilename */
 
       sector = newentry.firstsector;
-      while (sector != SMARTFS_ERASEDSTATE_16BIT)
+      while (sector != SMARTFS_ERASEDSTATE_SECTOR)
         {
           /* Read the next sector of diretory entries */
 
@@ -1827,7 +1827,7 @@ int smartfs_rename(struct inode *mountpt, const char *oldrelpath,
 
   /* Test if the new parent directory is valid */
   
-  if (newparentdirsector != 0xFFFF)
+  if (newparentdirsector != SMART_SECTOR_NONE)
     {
       /* We can move to the given parent directory */
 
@@ -1911,7 +1911,7 @@ static int smartfs_stat(struct inode *mountpt, const char *relpath, struct stat
   struct smartfs_mountpt_s *fs;
   struct smartfs_entry_s    entry;
   int                       ret = -ENOENT;
-  uint16_t                  parentdirsector;
+  smart_sector_t            parentdirsector;
   const char               *filename;
 
   /* Sanity checks */
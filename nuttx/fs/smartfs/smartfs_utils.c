@@ -72,9 +72,7 @@
  * Private Variables
  ****************************************************************************/
 
-#ifdef CONFIG_SMARTFS_MULTI_ROOT_DIRS
 static struct smartfs_mountpt_s* g_mounthead = NULL;
-#endif
 
 /****************************************************************************
  * Public Variables
@@ -230,6 +228,11 @@ int smartfs_mount(struct smartfs_mountpt_s *fs, bool writeable)
   fs->fs_rwbuffer = (char *) kmalloc(fs->fs_llformat.availbytes);
   fs->fs_workbuffer = (char *) kmalloc(256);
   fs->fs_rootsector = SMARTFS_ROOT_DIR_SECTOR;
+
+  /* Add ourselves to the linked list of SMART mounts */
+
+  fs->fs_next = g_mounthead;
+  g_mounthead = fs;
 #endif
 
   /* We did it! */
@@ -267,9 +270,9 @@ int smartfs_unmount(struct smartfs_mountpt_s *fs)
 {
   int           ret = OK;
   struct inode *inode;
-#ifdef CONFIG_SMARTFS_MULTI_ROOT_DIRS
   struct smartfs_mountpt_s *nextfs;
   struct smartfs_mountpt_s *prevfs;
+#ifdef CONFIG_SMARTFS_MULTI_ROOT_DIRS
   int           count = 0;
   int           found = FALSE;
 #endif
@@ -380,11 +383,47 @@ int smartfs_unmount(struct smartfs_mountpt_s *fs)
 
   kfree(fs->fs_rwbuffer);
   kfree(fs->fs_workbuffer);
+
+  /* Remove ourselves from the linked list of SMART mounts */
+
+  prevfs = NULL;
+  for (nextfs = g_mounthead; nextfs != NULL && nextfs != fs;
+       nextfs = nextfs->fs_next)
+    {
+      prevfs = nextfs;
+    }
+
+  if (nextfs != NULL)
+    {
+      if (prevfs == NULL)
+        {
+          g_mounthead = fs->fs_next;
+        }
+      else
+        {
+          prevfs->fs_next = fs->fs_next;
+        }
+    }
 #endif
 
   return ret;
 }
 
+/****************************************************************************
+ * Name: smartfs_get_first_mount
+ *
+ * Desciption: Returns the head of the linked list of SMART mounts.  Used
+ *   by the procfs to enumerate the mounted SMART devices.
+ *
+ ****************************************************************************/
+
+#if defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_SMARTFS)
+FAR struct smartfs_mountpt_s *smartfs_get_first_mount(void)
+{
+  return g_mounthead;
+}
+#endif
+
 /****************************************************************************
  * Name: smartfs_finddirentry
  *
@@ -403,15 +442,15 @@ int smartfs_unmount(struct smartfs_mountpt_s *fs)
 
 int smartfs_finddirentry(struct smartfs_mountpt_s *fs,
         struct smartfs_entry_s *direntry, const char *relpath,
-        uint16_t *parentdirsector, const char **filename)
+        smart_sector_t *parentdirsector, const char **filename)
 {
   int ret = -ENOENT;
   const char *segment;
   const char *ptr;
   uint16_t    seglen;
   uint16_t    depth = 0;
-  uint16_t    dirstack[CONFIG_SMARTFS_DIRDEPTH];
-  uint16_t    dirsector;
+  smart_sector_t dirstack[CONFIG_SMARTFS_DIRDEPTH];
+  smart_sector_t dirsector;
   uint16_t    entrysize;
   uint16_t    offset;
   struct      smartfs_chain_header_s *header;
@@ -504,11 +543,7 @@ int smartfs_finddirentry(struct smartfs_mountpt_s *fs,
 
           offset = 0xFFFF;
 
-#if CONFIG_SMARTFS_ERASEDSTATE == 0xFF
-          while (dirsector != 0xFFFF)
-#else
-          while (dirsector != 0)
-#endif
+          while (dirsector != SMARTFS_ERASEDSTATE_SECTOR)
             {
               /* Read the next directory in the chain */
 
@@ -592,7 +627,7 @@ int smartfs_finddirentry(struct smartfs_mountpt_s *fs,
                               readwrite.buffer = (uint8_t *)fs->fs_rwbuffer;
                               readwrite.offset = 0;
 
-                              while (dirsector != SMARTFS_ERASEDSTATE_16BIT)
+                              while (dirsector != SMARTFS_ERASEDSTATE_SECTOR)
                                 {
                                   /* Read the next sector of the file */
 
@@ -690,7 +725,7 @@ int smartfs_finddirentry(struct smartfs_mountpt_s *fs,
             }
           else
             {
-              *parentdirsector = 0xFFFF;
+              *parentdirsector = SMART_SECTOR_NONE;
               *filename = NULL;
             }
 
@@ -708,21 +743,22 @@ errout:
  *
  * Description: Creates a new entry in the specified parent directory, using
  *              the specified type and name.  If the given sectorno is
- *              0xFFFF, then a new sector is allocated for the new entry,
+ *              SMART_SECTOR_NONE, then a new sector is allocated for the
+ *              new entry,
  *              otherwise the supplied sectorno is used.
  *
  ****************************************************************************/
 
 int smartfs_createentry(struct smartfs_mountpt_s *fs,
-        uint16_t parentdirsector, const char* filename,
+        smart_sector_t parentdirsector, const char* filename,
         uint16_t type,
         mode_t mode, struct smartfs_entry_s *direntry,
-        uint16_t sectorno)
+        smart_sector_t sectorno)
 {
   struct    smart_read_write_s readwrite;
   int       ret;
-  uint16_t  psector;
-  uint16_t  nextsector;
+  smart_sector_t psector;
+  smart_sector_t nextsector;
   uint16_t  offset;
   uint16_t  found;
   uint16_t  entrysize;
@@ -803,24 +839,24 @@ int smartfs_createentry(struct smartfs_mountpt_s *fs,
        * room for the new entry.
        */
 
-      if (nextsector == SMARTFS_ERASEDSTATE_16BIT)
+      if (nextsector == SMARTFS_ERASEDSTATE_SECTOR)
         {
           /* Allocate a new sector and chain it to the last one */
 
-          ret = FS_IOCTL(fs, BIOC_ALLOCSECT, 0xFFFF);
+          ret = FS_IOCTL(fs, BIOC_ALLOCSECT, SMART_SECTOR_NONE);
           if (ret < 0)
             {
               goto errout;
             }
 
-          nextsector = (uint16_t) ret;
+          nextsector = (smart_sector_t) ret;
 
           /* Chain the next sector into this sector sector */
 
-          *((uint16_t *) chainheader->nextsector) = nextsector;
+          SMARTFS_NEXTSECTOR(chainheader) = nextsector;
           readwrite.offset = offsetof(struct smartfs_chain_header_s,
               nextsector);
-          readwrite.count = sizeof(uint16_t);
+          readwrite.count = sizeof(smart_sector_t);
           readwrite.buffer = chainheader->nextsector;
           ret = FS_IOCTL(fs, BIOC_WRITESECT, (unsigned long) &readwrite);
           if (ret < 0)
@@ -844,17 +880,17 @@ int smartfs_createentry(struct smartfs_mountpt_s *fs,
   entry->flags = (uint16_t) (SMARTFS_DIRENT_EMPTY | type | (mode & SMARTFS_DIRENT_MODE));
 #endif
 
-  if (sectorno == 0xFFFF)
+  if (sectorno == SMART_SECTOR_NONE)
     {
       /* Allocate a new sector for the file / dir */
 
-      ret = FS_IOCTL(fs, BIOC_ALLOCSECT, 0xFFFF);
+      ret = FS_IOCTL(fs, BIOC_ALLOCSECT, SMART_SECTOR_NONE);
       if (ret < 0)
         {
           goto errout;
         }
 
-      nextsector = (uint16_t) ret;
+      nextsector = (smart_sector_t) ret;
 
       /* Set the newly allocated sector's type (file or dir) */
 
@@ -941,8 +977,8 @@ int smartfs_deleteentry(struct smartfs_mountpt_s *fs,
         struct smartfs_entry_s *entry)
 {
   int                             ret;
-  uint16_t                        nextsector;
-  uint16_t                        sector;
+  smart_sector_t                  nextsector;
+  smart_sector_t                  sector;
   uint16_t                        count;
   uint16_t                        entrysize;
   uint16_t                        offset;
@@ -968,7 +1004,7 @@ int smartfs_deleteentry(struct smartfs_mountpt_s *fs,
   readwrite.offset = 0;
   readwrite.count = sizeof(struct smartfs_chain_header_s);
   readwrite.buffer = (uint8_t *) fs->fs_rwbuffer;
-  while (nextsector != SMARTFS_ERASEDSTATE_16BIT)
+  while (nextsector != SMARTFS_ERASEDSTATE_SECTOR)
     {
       /* Read the next sector into our buffer */
 
@@ -1067,7 +1103,7 @@ int smartfs_deleteentry(struct smartfs_mountpt_s *fs,
           readwrite.offset = 0;
           readwrite.count = sizeof(struct smartfs_chain_header_s);
           readwrite.buffer = (uint8_t *) fs->fs_rwbuffer;
-          while (sector != SMARTFS_ERASEDSTATE_16BIT)
+          while (sector != SMARTFS_ERASEDSTATE_SECTOR)
             {
               /* Read the header for the next sector */
 
@@ -1087,7 +1123,7 @@ int smartfs_deleteentry(struct smartfs_mountpt_s *fs,
 
                   SMARTFS_NEXTSECTOR(header) = nextsector;
                   readwrite.offset = offsetof(struct smartfs_chain_header_s, nextsector);
-                  readwrite.count = sizeof(uint16_t);
+                  readwrite.count = sizeof(smart_sector_t);
                   readwrite.buffer = header->nextsector;
                   ret = FS_IOCTL(fs, BIOC_WRITESECT, (unsigned long) &readwrite);
                   if (ret < 0)
@@ -1137,7 +1173,7 @@ int smartfs_countdirentries(struct smartfs_mountpt_s *fs,
         struct smartfs_entry_s *entry)
 {
   int                             ret;
-  uint16_t                        nextsector;
+  smart_sector_t                  nextsector;
   uint16_t                        offset;
   uint16_t                        entrysize;
   int                             count;
@@ -1149,7 +1185,7 @@ int smartfs_countdirentries(struct smartfs_mountpt_s *fs,
 
   count = 0;
   nextsector = entry->firstsector;
-  while (nextsector != SMARTFS_ERASEDSTATE_16BIT)
+  while (nextsector != SMARTFS_ERASEDSTATE_SECTOR)
     {
       /* Read the next sector into our buffer */
 
@@ -1216,8 +1252,8 @@ int smartfs_truncatefile(struct smartfs_mountpt_s *fs,
         struct smartfs_entry_s *entry)
 {
   int                             ret;
-  uint16_t                        nextsector;
-  uint16_t                        sector;
+  smart_sector_t                  nextsector;
+  smart_sector_t                  sector;
   struct smartfs_chain_header_s  *header;
   struct smart_read_write_s       readwrite;
 
@@ -1226,7 +1262,7 @@ int smartfs_truncatefile(struct smartfs_mountpt_s *fs,
   nextsector = entry->firstsector;
   header = (struct smartfs_chain_header_s *) fs->fs_rwbuffer;
 
-  while (nextsector != SMARTFS_ERASEDSTATE_16BIT)
+  while (nextsector != SMARTFS_ERASEDSTATE_SECTOR)
     {
       /* Read the next sector's header into our buffer */
 
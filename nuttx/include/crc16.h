@@ -1,7 +1,7 @@
 /****************************************************************************
  * include/crc16.h
  *
- *   Copyright (C) 2013 Gregory Nutt. All rights reserved.
+ *   Copyright (C) 2013-2014 Gregory Nutt. All rights reserved.
  *   Author: Gregory Nutt <gnutt@nuttx.org>
  *
  * Redistribution and use in source and binary forms, with or without
@@ -43,6 +43,19 @@
 #include <sys/types.h>
 #include <stdint.h>
 
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+/* Context for the CRC calculation of a stream of data that is provided in
+ * parts.
+ */
+
+struct crc16ctx_s
+{
+  uint16_t crc;             /* The CRC of the data so far */
+};
+
 /****************************************************************************
  * Public Function Prototypes
  ****************************************************************************/
@@ -75,6 +88,21 @@ uint16_t crc16part(FAR const uint8_t *src, size_t len, uint16_t crc16val);
 
 uint16_t crc16(FAR const uint8_t *src, size_t len);
 
+/****************************************************************************
+ * Name: crc16init, crc16update, crc16final
+ *
+ * Description:
+ *   Calculate the same 16-bit CRC as crc16() over a stream of data that is
+ *   provided in parts:  crc16init() prepares the context, crc16update()
+ *   is called for each part, and crc16final() returns the CRC.
+ *
+ ****************************************************************************/
+
+void crc16init(FAR struct crc16ctx_s *ctx);
+void crc16update(FAR struct crc16ctx_s *ctx, FAR const uint8_t *src,
+                 size_t len);
+uint16_t crc16final(FAR struct crc16ctx_s *ctx);
+
 #undef EXTERN
 #ifdef __cplusplus
 }
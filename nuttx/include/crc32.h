@@ -1,7 +1,7 @@
 /****************************************************************************
  * include/crc32.h
  *
- *   Copyright (C) 2010 Gregory Nutt. All rights reserved.
+ *   Copyright (C) 2010, 2014 Gregory Nutt. All rights reserved.
  *   Author: Gregory Nutt <gnutt@nuttx.org>
  *
  * Redistribution and use in source and binary forms, with or without
@@ -40,9 +40,24 @@
  * Included Files
  ****************************************************************************/
 
+#include <nuttx/config.h>
+
 #include <sys/types.h>
 #include <stdint.h>
 
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+/* Context for the CRC calculation of a stream of data that is provided in
+ * parts (for example, a large file that is read in chunks).
+ */
+
+struct crc32ctx_s
+{
+  uint32_t crc;             /* The CRC of the data so far */
+};
+
 /****************************************************************************
  * Public Function Prototypes
  ****************************************************************************/
@@ -75,6 +90,60 @@ uint32_t crc32part(FAR const uint8_t *src, size_t len, uint32_t crc32val);
 
 uint32_t crc32(FAR const uint8_t *src, size_t len);
 
+/****************************************************************************
+ * Name: crc32init, crc32update, crc32final
+ *
+ * Description:
+ *   Calculate the same 32-bit CRC as crc32() over a stream of data that is
+ *   provided in parts:  crc32init() prepares the context, crc32update()
+ *   is called for each part, and crc32final() returns the CRC.
+ *
+ ****************************************************************************/
+
+void crc32init(FAR struct crc32ctx_s *ctx);
+void crc32update(FAR struct crc32ctx_s *ctx, FAR const uint8_t *src,
+                 size_t len);
+uint32_t crc32final(FAR struct crc32ctx_s *ctx);
+
+/****************************************************************************
+ * Name: crc32cpart
+ *
+ * Description:
+ *   Continue CRC-32C (Castagnoli) calculation on a part of the buffer.  No
+ *   initial or final inversion is applied.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_LIBC_CRC32C
+uint32_t crc32cpart(FAR const uint8_t *src, size_t len, uint32_t crc32val);
+
+/****************************************************************************
+ * Name: crc32c
+ *
+ * Description:
+ *   Return the standard CRC-32C (Castagnoli, as used by iSCSI and several
+ *   file systems) of the contents of the 'src' buffer, length 'len'.  Unlike
+ *   crc32(), the initial value is 0xffffffff and the result is inverted.
+ *
+ ****************************************************************************/
+
+uint32_t crc32c(FAR const uint8_t *src, size_t len);
+
+/****************************************************************************
+ * Name: crc32cinit, crc32cupdate, crc32cfinal
+ *
+ * Description:
+ *   Calculate the same CRC-32C as crc32c() over a stream of data that is
+ *   provided in parts.
+ *
+ ****************************************************************************/
+
+void crc32cinit(FAR struct crc32ctx_s *ctx);
+void crc32cupdate(FAR struct crc32ctx_s *ctx, FAR const uint8_t *src,
+                  size_t len);
+uint32_t crc32cfinal(FAR struct crc32ctx_s *ctx);
+#endif
+
 #undef EXTERN
 #ifdef __cplusplus
 }
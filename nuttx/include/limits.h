@@ -159,7 +159,9 @@
 #define _POSIX_DELAYTIMER_MAX 32
 #define _POSIX_TIMER_MAX      32
 
-#ifdef CONFIG_MSEC_PER_TICK
+#if defined(CONFIG_SCHED_TICKLESS) && defined(CONFIG_USEC_PER_TICK)
+# define _POSIX_CLOCKRES_MIN  ((CONFIG_USEC_PER_TICK)*1000)
+#elif defined(CONFIG_MSEC_PER_TICK)
 # define _POSIX_CLOCKRES_MIN  ((CONFIG_MSEC_PER_TICK)*1000000)
 #else
 # define _POSIX_CLOCKRES_MIN  (10*1000000)
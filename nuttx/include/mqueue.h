@@ -101,6 +101,15 @@ EXTERN int     mq_setattr(mqd_t mqdes, const struct mq_attr *mq_stat,
                   struct mq_attr *oldstat);
 EXTERN int     mq_getattr(mqd_t mqdes, struct mq_attr *mq_stat);
 
+#ifdef CONFIG_MQ_ZEROCOPY
+/* Non-standard, zero-copy interfaces to the per-queue message pool */
+
+EXTERN void   *mq_allocbuf(mqd_t mqdes);
+EXTERN int     mq_sendbuf(mqd_t mqdes, void *buf, size_t msglen, int prio);
+EXTERN ssize_t mq_receivebuf(mqd_t mqdes, void **buf, int *prio);
+EXTERN int     mq_freebuf(mqd_t mqdes, void *buf);
+#endif
+
 #undef EXTERN
 #ifdef __cplusplus
 }
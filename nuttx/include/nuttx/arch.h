@@ -883,6 +883,68 @@ int up_addrenv_release(FAR struct tcb_s *tcb);
 
 bool up_interrupt_context(void);
 
+/****************************************************************************
+ * Name: up_cpu_index
+ *
+ * Description:
+ *   Return an index in the range of 0 through (CONFIG_SMP_NCPUS-1) that
+ *   corresponds to the currently executing CPU.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SMP
+int up_cpu_index(void);
+#endif
+
+/****************************************************************************
+ * Name: up_cpu_start
+ *
+ * Description:
+ *   In an SMP configuration, only one CPU is initially active (CPU 0).
+ *   System initialization occurs on that single thread.  At the completion
+ *   of the initialization of the OS, just before beginning normal
+ *   multitasking, the additional CPUs are started by calling this function.
+ *
+ *   The IDLE task TCB of the new CPU is already the running task of that
+ *   CPU when this function is called.  The new CPU must run its IDLE loop
+ *   (calling up_idle() forever) and never return.
+ *
+ * Input Parameters:
+ *   cpu - The index of the CPU being started.  This will be a numeric
+ *         value in the range of one to (CONFIG_SMP_NCPUS-1).  (CPU 0 is
+ *         already active).
+ *
+ * Returned Value:
+ *   Zero on success; a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SMP
+int up_cpu_start(int cpu);
+#endif
+
+/****************************************************************************
+ * Name: up_cpu_reschedule
+ *
+ * Description:
+ *   Send an inter-processor interrupt to another CPU to request that it
+ *   re-schedule:  The scheduler has selected a different task for that
+ *   CPU.  When the interrupt is taken (i.e., when the other CPU is not in
+ *   a critical section), the other CPU must call sched_smp_resume() and
+ *   switch to its new running task if that function returns true.
+ *
+ * Input Parameters:
+ *   cpu - The index of the CPU to be interrupted.
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SMP
+void up_cpu_reschedule(int cpu);
+#endif
+
 /****************************************************************************
  * Name: up_enable_irq
  *
@@ -1010,6 +1072,152 @@ void up_udelay(useconds_t microseconds);
 void up_cxxinitialize(void);
 #endif
 
+/****************************************************************************
+ * Tickless OS Support.
+ *
+ * When CONFIG_SCHED_TICKLESS is enabled, all support for timer interrupts
+ * is suppressed and the platform specific code is expected to provide the
+ * following custom functions.
+ *
+ *   void up_timer_initialize(void): Initializes the timer facilities.
+ *     Called early in the initialization sequence (by up_initialize()).
+ *   int up_timer_gettime(FAR struct timespec *ts):  Returns the current
+ *     time from the platform specific time source.
+ *   int up_timer_cancel(FAR struct timespec *ts):  Cancels the interval
+ *     timer.
+ *   int up_timer_start(FAR const struct timespec *ts): Start (or re-starts)
+ *     the interval timer.
+ *
+ * The RTOS will provide the following interfaces for use by the platform-
+ * specific interval timer implementation:
+ *
+ *   void sched_timer_expiration(void):  Called by the platform-specific
+ *     logic when the interval timer expires.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: up_timer_initialize
+ *
+ * Description:
+ *   Initializes all platform-specific timer facilities.  This function is
+ *   called early in the initialization sequence by up_intialize().
+ *   On return, the current up-time should be available from
+ *   up_timer_gettime() and the interval timer is ready for use (but not
+ *   actively timing).
+ *
+ * Input Parameters:
+ *   None
+ *
+ * Returned Value:
+ *   None
+ *
+ * Assumptions:
+ *   Called early in the initialization sequence before any special
+ *   concurrency protections are required.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_TICKLESS
+void up_timer_initialize(void);
+#endif
+
+/****************************************************************************
+ * Name: up_timer_gettime
+ *
+ * Description:
+ *   Return the elapsed time since power-up (or, more correctly, since
+ *   up_timer_initialize() was called).  This function is functionally
+ *   equivalent to:
+ *
+ *      int clock_gettime(clockid_t clockid, FAR struct timespec *ts);
+ *
+ *   when clockid is CLOCK_MONOTONIC.
+ *
+ *   This function provides the basis for reporting the current time and
+ *   also is used to eliminate error build-up from small errors in interval
+ *   time calculations.
+ *
+ * Input Parameters:
+ *   ts - Provides the location in which to return the up-time.
+ *
+ * Returned Value:
+ *   Zero (OK) is returned on success; a negated errno value is returned on
+ *   any failure.
+ *
+ * Assumptions:
+ *   Called from the the normal tasking context.  The implementation must
+ *   provide whatever mutual exclusion is necessary for correct operation.
+ *   This can include disabling interrupts in order to assure atomic register
+ *   operations.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_TICKLESS
+int up_timer_gettime(FAR struct timespec *ts);
+#endif
+
+/****************************************************************************
+ * Name: up_timer_cancel
+ *
+ * Description:
+ *   Cancel the interval timer and return the time remaining on the timer.
+ *   These two steps need to be as nearly atomic as possible.
+ *   sched_timer_expiration() will not be called unless the timer is
+ *   restarted with up_timer_start().
+ *
+ *   If, as a race condition, the timer has already expired when this
+ *   function is called, then that pending interrupt must be cleared so
+ *   that sched_timer_expiration() is not called spuriously and a remaining
+ *   time of zero should be returned.
+ *
+ * Input Parameters:
+ *   ts - Location to return the remaining time.  Zero should be returned
+ *        if the timer is not active.  ts may be NULL if the remaining time
+ *        is not needed.
+ *
+ * Returned Value:
+ *   Zero (OK) is returned on success; a negated errno value is returned on
+ *   any failure.
+ *
+ * Assumptions:
+ *   May be called from interrupt level handling or from the normal tasking
+ *   level.  Interrupts may need to be disabled internally to assure
+ *   non-reentrancy.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_TICKLESS
+int up_timer_cancel(FAR struct timespec *ts);
+#endif
+
+/****************************************************************************
+ * Name: up_timer_start
+ *
+ * Description:
+ *   Start the interval timer.  sched_timer_expiration() will be called at
+ *   the completion of the timeout (unless up_timer_cancel is called to stop
+ *   the timing).
+ *
+ * Input Parameters:
+ *   ts - Provides the time interval until sched_timer_expiration() is
+ *        called.
+ *
+ * Returned Value:
+ *   Zero (OK) is returned on success; a negated errno value is returned on
+ *   any failure.
+ *
+ * Assumptions:
+ *   May be called from interrupt level handling or from the normal tasking
+ *   level.  Interrupts may need to be disabled internally to assure
+ *   non-reentrancy.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_TICKLESS
+int up_timer_start(FAR const struct timespec *ts);
+#endif
+
 /****************************************************************************
  * These are standard interfaces that are exported by the OS
  * for use by the architecture specific logic
@@ -1027,7 +1235,60 @@ void up_cxxinitialize(void);
  *
  ****************************************************************************/
 
+#ifndef CONFIG_SCHED_TICKLESS
 void sched_process_timer(void);
+#endif
+
+/****************************************************************************
+ * Name:  sched_timer_expiration
+ *
+ * Description:
+ *   If CONFIG_SCHED_TICKLESS is defined, then this function is provided by
+ *   the RTOS base code and called from platform-specific code when the
+ *   interval timer used to implemented the tick-less OS expires.
+ *
+ * Input Parameters:
+ *   None
+ *
+ * Returned Value:
+ *   None
+ *
+ * Assumptions:
+ *   Base code implementation assumes that this function is called from
+ *   interrupt handling logic with interrupts disabled.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_TICKLESS
+void sched_timer_expiration(void);
+#endif
+
+/****************************************************************************
+ * Name:  sched_smp_resume
+ *
+ * Description:
+ *   In an SMP configuration, this function must be called by the
+ *   architecture-specific logic on the CPU that receives the inter-
+ *   processor interrupt sent by up_cpu_reschedule().  It makes the task
+ *   that the scheduler has selected for this CPU the running task of the
+ *   CPU.
+ *
+ * Input Parameters:
+ *   None
+ *
+ * Returned Value:
+ *   true if the running task of this CPU has changed and a context switch
+ *   to the new running task (see this_task()) must be performed.
+ *
+ * Assumptions:
+ *   Called from the inter-processor interrupt handler within a critical
+ *   section (i.e., with irqsave() held).
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SMP
+bool sched_smp_resume(void);
+#endif
 
 /****************************************************************************
  * Name: irq_dispatch
@@ -92,32 +92,47 @@
  * setting can be overridden by defining the interval in milliseconds as
  * CONFIG_MSEC_PER_TICK in the board configuration file.
  *
+ * In the tick-less mode (CONFIG_SCHED_TICKLESS), there is no timer
+ * interrupt and the duration of one tick is given in microseconds by
+ * CONFIG_USEC_PER_TICK.  That value need not be a multiple of one
+ * millisecond.
+ *
  * The following calculations are only accurate when (1) there is no
  * truncation involved and (2) the underlying system timer is an even
  * multiple of milliseconds.  If (2) is not true, you will probably want
  * to redefine all of the following.
  */
 
-#ifdef CONFIG_MSEC_PER_TICK
-# define MSEC_PER_TICK        (CONFIG_MSEC_PER_TICK)
+#if defined(CONFIG_SCHED_TICKLESS) && defined(CONFIG_USEC_PER_TICK)
+# define USEC_PER_TICK        (CONFIG_USEC_PER_TICK)
+#elif defined(CONFIG_MSEC_PER_TICK)
+# define USEC_PER_TICK        (CONFIG_MSEC_PER_TICK * USEC_PER_MSEC)
 #else
-# define MSEC_PER_TICK        (10)
+# define USEC_PER_TICK        (10 * USEC_PER_MSEC)
 #endif
 
-#define TICK_PER_DSEC         (MSEC_PER_DSEC / MSEC_PER_TICK)            /* Truncates! */
-#define TICK_PER_SEC          (MSEC_PER_SEC / MSEC_PER_TICK)             /* Truncates! */
-#define NSEC_PER_TICK         (MSEC_PER_TICK * NSEC_PER_MSEC)            /* Exact */
-#define USEC_PER_TICK         (MSEC_PER_TICK * USEC_PER_MSEC)            /* Exact */
+#define MSEC_PER_TICK         (USEC_PER_TICK / USEC_PER_MSEC)            /* Truncates! */
+#define NSEC_PER_TICK         (USEC_PER_TICK * NSEC_PER_USEC)            /* Exact */
+#define TICK_PER_DSEC         (USEC_PER_DSEC / USEC_PER_TICK)            /* Truncates! */
+#define TICK_PER_SEC          (USEC_PER_SEC / USEC_PER_TICK)             /* Truncates! */
 
 #define NSEC2TICK(nsec)       (((nsec)+(NSEC_PER_TICK/2))/NSEC_PER_TICK) /* Rounds */
 #define USEC2TICK(usec)       (((usec)+(USEC_PER_TICK/2))/USEC_PER_TICK) /* Rounds */
-#define MSEC2TICK(msec)       (((msec)+(MSEC_PER_TICK/2))/MSEC_PER_TICK) /* Rounds */
-#define DSEC2TICK(dsec)       MSEC2TICK((dsec)*MSEC_PER_DSEC)
-#define SEC2TICK(sec)         MSEC2TICK((sec)*MSEC_PER_SEC)              /* Exact */
+
+#if (USEC_PER_TICK % USEC_PER_MSEC) == 0
+#  define MSEC2TICK(msec)     (((msec)+(MSEC_PER_TICK/2))/MSEC_PER_TICK) /* Rounds */
+#  define DSEC2TICK(dsec)     MSEC2TICK((dsec)*MSEC_PER_DSEC)
+#  define SEC2TICK(sec)       MSEC2TICK((sec)*MSEC_PER_SEC)              /* Exact */
+#  define TICK2MSEC(tick)     ((tick)*MSEC_PER_TICK)                     /* Exact */
+#else
+#  define MSEC2TICK(msec)     USEC2TICK((msec)*USEC_PER_MSEC)            /* Rounds */
+#  define DSEC2TICK(dsec)     ((dsec)*TICK_PER_DSEC)                     /* Truncates! */
+#  define SEC2TICK(sec)       ((sec)*TICK_PER_SEC)                       /* Truncates! */
+#  define TICK2MSEC(tick)     (((tick)*USEC_PER_TICK+(USEC_PER_MSEC/2))/USEC_PER_MSEC) /* Rounds */
+#endif
 
 #define TICK2NSEC(tick)       ((tick)*NSEC_PER_TICK)                     /* Exact */
 #define TICK2USEC(tick)       ((tick)*USEC_PER_TICK)                     /* Exact */
-#define TICK2MSEC(tick)       ((tick)*MSEC_PER_TICK)                     /* Exact */
 #define TICK2DSEC(tick)       (((tick)+(TICK_PER_DSEC/2))/TICK_PER_DSEC) /* Rounds */
 #define TICK2SEC(tick)        (((tick)+(TICK_PER_SEC/2))/TICK_PER_SEC)   /* Rounds */
 
@@ -144,10 +159,11 @@ struct cpuload_s
 /* Direct access to the system timer/counter is supported only if (1) the
  * system timer counter is available (i.e., we are not configured to use
  * a hardware periodic timer), and (2) the execution environment has direct
- * access to kernel global data
+ * access to kernel global data.  In the tick-less mode, there is no system
+ * timer counter; the time is derived from a free-running hardware timer.
  */
 
-#if __HAVE_KERNEL_GLOBALS
+#if __HAVE_KERNEL_GLOBALS && !defined(CONFIG_SCHED_TICKLESS)
 #  ifdef CONFIG_SYSTEM_TIME64
 
 extern volatile uint64_t g_system_timer;
@@ -225,7 +241,7 @@ void clock_synchronize(void);
  *
  ****************************************************************************/
 
-#if !__HAVE_KERNEL_GLOBALS
+#if !__HAVE_KERNEL_GLOBALS || defined(CONFIG_SCHED_TICKLESS)
 #  ifdef CONFIG_SYSTEM_TIME64
 #    define clock_systimer()  (uint32_t)(clock_systimer64() & 0x00000000ffffffff)
 #  else
@@ -252,7 +268,8 @@ uint32_t clock_systimer(void);
  *
  ****************************************************************************/
 
-#if !__HAVE_KERNEL_GLOBALS && defined(CONFIG_SYSTEM_TIME64)
+#if (!__HAVE_KERNEL_GLOBALS || defined(CONFIG_SCHED_TICKLESS)) && \
+    defined(CONFIG_SYSTEM_TIME64)
 uint64_t clock_systimer64(void);
 #endif
 
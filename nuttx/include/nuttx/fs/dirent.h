@@ -142,8 +142,13 @@ struct nfsdir_s
 
 struct fs_smartfsdir_s
 {
+#ifdef CONFIG_SMARTFS_32BIT_SECTORS
+  uint32_t fs_firstsector;                    /* First sector of directory list */
+  uint32_t fs_currsector;                     /* Current sector of directory list */
+#else
   uint16_t fs_firstsector;                    /* First sector of directory list */
   uint16_t fs_currsector;                     /* Current sector of directory list */
+#endif
   uint16_t fs_curroffset;                     /* Current offset withing current sector */
 };
 #endif
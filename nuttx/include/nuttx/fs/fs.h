@@ -48,6 +48,10 @@
 #include <stdbool.h>
 #include <semaphore.h>
 
+#ifdef CONFIG_MUTEX_FASTPATH
+#  include <pthread.h>
+#endif
+
 /****************************************************************************
  * Definitions
  ****************************************************************************/
@@ -102,6 +106,23 @@ struct geometry
   size_t geo_sectorsize;   /* Size of one sector */
 };
 
+/* This structure is returned by the DIOC_CACHESTATS ioctl command of BCH
+ * character drivers.  It reports the effectiveness of the BCH sector
+ * buffer and of the read-ahead and write buffers (if enabled).
+ */
+
+struct bch_cachestats_s
+{
+  uint32_t cs_hits;        /* Sector accesses served by the sector buffer */
+  uint32_t cs_misses;      /* Sector accesses that required a new sector */
+  uint32_t cs_rhhits;      /* Sectors read from the read-ahead buffer */
+  uint32_t cs_rhmisses;    /* Sectors that required a read-ahead reload */
+  uint32_t cs_wrmerges;    /* Sectors accepted by the write buffer */
+  uint32_t cs_wrflushes;   /* Write buffer flushes */
+  uint32_t cs_devreads;    /* Read requests passed to the block driver */
+  uint32_t cs_devwrites;   /* Write requests passed to the block driver */
+};
+
 /* This structure is provided by block devices when they register with the
  * system.  It is used by file systems to perform filesystem transfers.  It
  * differs from the normal driver vtable in several ways -- most notably in
@@ -275,7 +296,11 @@ struct file_struct
 {
   int                fs_fd;        /* File descriptor associated with stream */
 #if CONFIG_STDIO_BUFFER_SIZE > 0
+#ifdef CONFIG_MUTEX_FASTPATH
+  pthread_mutex_t    fs_lock;      /* For thread safety */
+#else
   sem_t              fs_sem;       /* For thread safety */
+#endif
   pid_t              fs_holder;    /* Holder of sem */
   int                fs_counts;    /* Number of times sem is held */
   FAR unsigned char *fs_bufstart;  /* Pointer to start of buffer */
@@ -293,7 +318,11 @@ struct file_struct
 
 struct streamlist
 {
+#ifdef CONFIG_MUTEX_FASTPATH
+  pthread_mutex_t     sl_lock;  /* For thread safety */
+#else
   sem_t               sl_sem;   /* For thread safety */
+#endif
   struct file_struct sl_streams[CONFIG_NFILE_STREAMS];
 };
 #endif /* CONFIG_NFILE_STREAMS */
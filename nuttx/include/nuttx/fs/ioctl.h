@@ -121,6 +121,15 @@
 #define FIONWRITE       _FIOC(0x0006)     /* IN:  Location to return value (int *)
                                            * OUT: Bytes writable to this fd
                                            */
+#define FIOC_PACKSTEP   _FIOC(0x0007)     /* IN:  Maximum number of erase blocks
+                                           *      to relocate (0=default)
+                                           * OUT: None.  Returns 1 if more can be
+                                           *      packed, 0 if not.
+                                           */
+#define FIOC_PACKSTATS  _FIOC(0x0008)     /* IN:  Pointer to a writable instance
+                                           *      of struct nxffs_packstats_s
+                                           * OUT: NXFFS packing statistics
+                                           */
 
 /* NuttX file system ioctl definitions **************************************/
 
@@ -136,6 +145,10 @@
                                            * OUT: None, reference obtained by
                                            *      FIOC_GETPRIV released.
                                            */
+#define DIOC_CACHESTATS _DIOC(0x0004)     /* IN:  Pointer to a writable instance
+                                           *      of struct bch_cachestats_s
+                                           * OUT: BCH cache statistics
+                                           */
 
 /* NuttX block driver ioctl definitions *************************************/
 
@@ -186,6 +199,11 @@
                                            *      buffer address
                                            * OUT: None (ioctl return value provides
                                            *      success/failure indication). */
+#define BIOC_GETPROCFSD _BIOC(0x000a)     /* Get SMART status information for
+                                           * the procfs file system.
+                                           * IN:  Pointer to a write-able struct
+                                           *      smart_procfs_data_s
+                                           * OUT: SMART status information */
 
 /* NuttX MTD driver ioctl definitions ***************************************/
 
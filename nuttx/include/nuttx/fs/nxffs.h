@@ -41,6 +41,10 @@
  ****************************************************************************/
 
 #include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <stdint.h>
+
 #include <nuttx/fs/fs.h>
 
 /****************************************************************************
@@ -85,14 +89,30 @@
 #  define CONFIG_NXFFS_TAILTHRESHOLD (8*1024)
 #endif
 
-/* At present, only a single pre-allocated NXFFS volume is supported.  This
- * is because here can be only a single NXFFS volume mounted at any time.
- * This has to do with the fact that we bind to an MTD driver (instead of a
- * block driver) and bypass all of the normal mount operations.
+/* The incremental packing logic relocates the content of no more than this
+ * number of erase blocks in one step.
+ */
+
+#ifndef CONFIG_NXFFS_PACKSTEP
+#  define CONFIG_NXFFS_PACKSTEP 4
+#endif
+
+/* Background packing starts this number of milliseconds after the last
+ * modification of the volume and continues until this percentage of the
+ * volume is free (or until there is nothing left to pack).
  */
 
-#undef CONFIG_NXFSS_PREALLOCATED
-#define CONFIG_NXFSS_PREALLOCATED 1
+#ifdef CONFIG_NXFFS_BGPACK
+#  ifndef CONFIG_NXFFS_PACKDELAY
+#    define CONFIG_NXFFS_PACKDELAY 500
+#  endif
+#  ifndef CONFIG_NXFFS_BGPACK_FREE
+#    define CONFIG_NXFFS_BGPACK_FREE 25
+#  endif
+#  if CONFIG_NXFFS_BGPACK_FREE < 0 || CONFIG_NXFFS_BGPACK_FREE > 100
+#    error CONFIG_NXFFS_BGPACK_FREE is not a valid percentage
+#  endif
+#endif
 
 /* If we were asked to scan the volume, then a re-formatting threshold must
  * also be provided.
@@ -107,6 +127,30 @@
 #  endif
 #endif
 
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+/* This structure is returned by the FIOC_PACKSTATS ioctl command.  It
+ * reports the progress of incremental packing and the cost of packing.
+ * All times are in milliseconds.
+ */
+
+struct nxffs_packstats_s
+{
+  off_t    ps_size;       /* Size of the volume in bytes */
+  off_t    ps_froffset;   /* Offset to the first free byte (end of the data) */
+  off_t    ps_packoffset; /* Where the next pack step begins (0=not packing) */
+  uint32_t ps_npacks;     /* Number of complete packs */
+  uint32_t ps_nsteps;     /* Number of incremental pack steps */
+  uint32_t ps_nbgsteps;   /* Incremental pack steps done in the background */
+  uint32_t ps_nerases;    /* Erase blocks erased by packing */
+  uint32_t ps_reclaimed;  /* Bytes returned to the free FLASH region */
+  uint32_t ps_maxpack;    /* Longest complete pack */
+  uint32_t ps_maxstep;    /* Longest incremental pack step */
+  uint32_t ps_maxwrite;   /* Longest write(), including any packing */
+};
+
 /****************************************************************************
  * Public Function Prototypes
  ****************************************************************************/
@@ -55,10 +55,28 @@
 #define SMART_FMT_ISFORMATTED   0x01
 #define SMART_FMT_HASBYTEWRITE  0x02
 
+/* A sector number that refers to no sector.  Passed to BIOC_ALLOCSECT to
+ * allocate any free logical sector.
+ */
+
+#define SMART_SECTOR_NONE       ((smart_sector_t) -1)
+
 /****************************************************************************
  * Public Types
  ****************************************************************************/
 
+/* Logical and physical sector numbers.  These are 16 bits wide, limiting a
+ * device to 65534 sectors, unless CONFIG_SMARTFS_32BIT_SECTORS is selected.
+ * The width is also the width of the sector numbers stored on the media
+ * (SMART format version 1 or 2, respectively).
+ */
+
+#ifdef CONFIG_SMARTFS_32BIT_SECTORS
+typedef uint32_t smart_sector_t;
+#else
+typedef uint16_t smart_sector_t;
+#endif
+
 /* The following defines the format information for the device.  This 
  * information is retrieved via the BIOC_GETFORMAT ioctl.
  */
@@ -67,8 +85,8 @@ struct smart_format_s
 {
   uint16_t sectorsize;      /* Size of one read/write sector */
   uint16_t availbytes;      /* Number of bytes available in each sector */
-  uint16_t nsectors;        /* Total number of sectors on device */
-  uint16_t nfreesectors;    /* Number of free sectors on device */
+  uint32_t nsectors;        /* Total number of sectors on device */
+  uint32_t nfreesectors;    /* Number of free sectors on device */
   uint8_t  flags;           /* Format flags (see above) */  
   uint8_t  namesize;        /* Size of filenames on this volume */
 #ifdef CONFIG_SMARTFS_MULTI_ROOT_DIRS
@@ -83,12 +101,41 @@ struct smart_format_s
 
 struct smart_read_write_s
 {
-  uint16_t logsector;     /* The logical sector number */
+  smart_sector_t logsector; /* The logical sector number */
   uint16_t offset;        /* Offset within the sector to write to */
   uint16_t count;         /* Number of bytes to write */
   const uint8_t *buffer;  /* Pointer to the data to write */
 };
 
+/* The following defines the status information returned by the
+ * BIOC_GETPROCFSD ioctl.  Times are in milliseconds.
+ */
+
+struct smart_procfs_data_s
+{
+  uint16_t sectorsize;      /* Size of one read/write sector */
+  uint16_t neraseblocks;    /* Number of erase blocks */
+  uint16_t sectorsperblk;   /* Number of sectors per erase block */
+  uint8_t  formatversion;   /* Format version on the device */
+  uint32_t totalsectors;    /* Total number of sectors on device */
+  uint32_t freesectors;     /* Number of erased sectors */
+  uint32_t releasesectors;  /* Number of released sectors */
+  uint32_t mapsize;         /* Bytes of RAM used by the sector map */
+  uint32_t scantime;        /* Time taken by the mount-time scan (ms) */
+  uint32_t nerases;         /* Erase blocks erased since initialization */
+  uint32_t ncollections;    /* Erase blocks collected by writers */
+  uint32_t nbgcollections;  /* Erase blocks collected in the background */
+  uint32_t nwearmoves;      /* Erase blocks collected to level wear */
+  uint32_t gcmaxtime;       /* Longest time a writer spent collecting */
+  uint32_t gctotaltime;     /* Total time writers spent collecting */
+  uint32_t bgtotaltime;     /* Total time spent collecting in the background */
+  uint32_t wearbase;        /* Erase count of the least worn erase block */
+  uint8_t  minwear;         /* Wear level range, relative to wearbase */
+  uint8_t  maxwear;
+  FAR const uint8_t *wearlevel; /* Wear level of each erase block (relative
+                                 * to wearbase) or NULL if not tracked */
+};
+
 /****************************************************************************
  * Public Data
  ****************************************************************************/
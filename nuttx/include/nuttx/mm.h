@@ -43,6 +43,7 @@
 #include <nuttx/config.h>
 
 #include <sys/types.h>
+#include <stdbool.h>
 #include <semaphore.h>
 
 /****************************************************************************
@@ -113,6 +114,71 @@
 #define MM_IS_ALLOCATED(n) \
   ((int)((struct mm_allocnode_s*)(n)->preceding) < 0))
 
+/* TLSF Definitions *********************************************************/
+/* If CONFIG_MM_TLSF is selected, then free chunks are kept in a two-level
+ * segregated fit (TLSF) structure instead of the sorted nodelist.  The
+ * first level divides the chunk sizes into powers of two; the second level
+ * divides each power of two range into MM_TLSF_SLCOUNT equal sub-ranges.
+ * Chunks smaller than (1 << MM_TLSF_FLSHIFT) are all kept in the first
+ * level list zero, one second level list per granule.  A bitmap at each
+ * level allows the free list to be searched in constant time.
+ */
+
+#ifdef CONFIG_MM_TLSF
+#  ifndef CONFIG_MM_TLSF_SLSHIFT
+#    define CONFIG_MM_TLSF_SLSHIFT 3
+#  endif
+
+#  define MM_TLSF_SLSHIFT  CONFIG_MM_TLSF_SLSHIFT
+#  define MM_TLSF_SLCOUNT  (1 << MM_TLSF_SLSHIFT)
+#  define MM_TLSF_FLSHIFT  (MM_TLSF_SLSHIFT + MM_MIN_SHIFT)
+
+/* The largest chunk size is limited by the allocated bit in the 'preceding'
+ * field of the chunk header.
+ */
+
+#  ifdef CONFIG_MM_SMALL
+#    define MM_TLSF_FLMAX  14
+#  else
+#    define MM_TLSF_FLMAX  30
+#  endif
+
+#  define MM_TLSF_FLCOUNT  (MM_TLSF_FLMAX - MM_TLSF_FLSHIFT + 2)
+#endif
+
+/* Small Block Cache Definitions ********************************************/
+/* If CONFIG_MM_CACHE is selected, then recently freed chunks of up to
+ * CONFIG_MM_CACHE_MAXSIZE bytes (including the chunk header) are held in
+ * one list per chunk size so that they can be re-allocated in constant time.
+ *
+ * CONFIG_MM_CACHE_DEPTH - The maximum number of chunks held in each list.
+ * CONFIG_MM_CACHE_BATCH - The number of chunks that are allocated from the
+ *   heap when a list is found empty.
+ */
+
+#ifdef CONFIG_MM_CACHE
+#  ifndef CONFIG_MM_CACHE_MAXSIZE
+#    define CONFIG_MM_CACHE_MAXSIZE 256
+#  endif
+
+#  ifndef CONFIG_MM_CACHE_DEPTH
+#    define CONFIG_MM_CACHE_DEPTH 16
+#  endif
+
+#  ifndef CONFIG_MM_CACHE_BATCH
+#    define CONFIG_MM_CACHE_BATCH 4
+#  endif
+
+#  if CONFIG_MM_CACHE_DEPTH + CONFIG_MM_CACHE_BATCH > 255
+#    error CONFIG_MM_CACHE_DEPTH is too large
+#  endif
+
+#  define MM_CACHE_MAXSIZE   MM_ALIGN_DOWN(CONFIG_MM_CACHE_MAXSIZE)
+#  define MM_CACHE_NLISTS    (MM_CACHE_MAXSIZE >> MM_MIN_SHIFT)
+#  define MM_CACHE_NDX(s)    (((s) >> MM_MIN_SHIFT) - 1)
+#  define MM_CACHEABLE(s)    ((s) <= MM_CACHE_MAXSIZE)
+#endif
+
 /****************************************************************************
  * Public Types
  ****************************************************************************/
@@ -199,12 +265,34 @@ struct mm_heap_s
   int mm_nregions;
 #endif
 
+#ifdef CONFIG_MM_TLSF
+  /* Free nodes are maintained in doubly linked lists, one per TLSF size
+   * class.  A bit is set in the second level bitmap of each first level
+   * for every non-empty list; a bit is set in the first level bitmap for
+   * every non-empty second level bitmap.
+   */
+
+  uint32_t mm_flbitmap;
+  uint32_t mm_slbitmap[MM_TLSF_FLCOUNT];
+  FAR struct mm_freenode_s *mm_freelist[MM_TLSF_FLCOUNT][MM_TLSF_SLCOUNT];
+#else
   /* All free nodes are maintained in a doubly linked list.  This
    * array provides some hooks into the list at various points to
    * speed searches for free nodes.
    */
 
   struct mm_freenode_s mm_nodelist[MM_NNODES];
+#endif
+
+#ifdef CONFIG_MM_CACHE
+  /* Small chunks that have been freed, but are still marked as allocated in
+   * the heap, are held in these lists (one per chunk size).  These lists
+   * are protected by disabling interrupts, not by the MM semaphore.
+   */
+
+  FAR struct mm_freenode_s *mm_cache[MM_CACHE_NLISTS];
+  uint8_t mm_ncached[MM_CACHE_NLISTS];
+#endif
 };
 
 /****************************************************************************
@@ -276,6 +364,10 @@ FAR void *mm_malloc(FAR struct mm_heap_s *heap, size_t size);
 void mm_free(FAR struct mm_heap_s *heap, FAR void *mem);
 #endif
 
+#ifdef CONFIG_MM_CACHE
+void mm_cacheflush(FAR struct mm_heap_s *heap);
+#endif
+
 /* Functions contained in mm_realloc.c **************************************/
 
 #ifdef CONFIG_MM_MULTIHEAP
@@ -313,14 +405,42 @@ int  mm_mallinfo(FAR struct mm_heap_s *heap, FAR struct mallinfo *info);
 void mm_shrinkchunk(FAR struct mm_heap_s *heap,
                     FAR struct mm_allocnode_s *node, size_t size);
 
-/* Functions contained in mm_addfreechunk.c *********************************/
+/* Functions contained in mm_addfreechunk.c (or mm_tlsf.c) ******************/
 
 void mm_addfreechunk(FAR struct mm_heap_s *heap,
                      FAR struct mm_freenode_s *node);
 
+/* Functions contained in mm_remfreechunk.c (or mm_tlsf.c) ******************/
+
+void mm_remfreechunk(FAR struct mm_heap_s *heap,
+                     FAR struct mm_freenode_s *node);
+
+/* Functions contained in mm_findfreechunk.c (or mm_tlsf.c) *****************/
+
+FAR struct mm_freenode_s *mm_findfreechunk(FAR struct mm_heap_s *heap,
+                                           size_t size);
+
+/* Functions contained in mm_tlsf.c *****************************************/
+
+#ifdef CONFIG_MM_TLSF
+void mm_tlsfinitialize(FAR struct mm_heap_s *heap);
+#endif
+
 /* Functions contained in mm_size2ndx.c.c ***********************************/
 
+#ifndef CONFIG_MM_TLSF
 int mm_size2ndx(size_t size);
+#endif
+
+/* Functions contained in mm_cache.c ****************************************/
+
+#ifdef CONFIG_MM_CACHE
+FAR void *mm_cachealloc(FAR struct mm_heap_s *heap, size_t size);
+bool mm_cachefree(FAR struct mm_heap_s *heap, FAR struct mm_allocnode_s *node);
+void mm_cacheadd(FAR struct mm_heap_s *heap, FAR struct mm_allocnode_s *node);
+FAR struct mm_freenode_s *mm_cacheremove(FAR struct mm_heap_s *heap, int ndx);
+size_t mm_cachesize(FAR struct mm_heap_s *heap);
+#endif
 
 #undef EXTERN
 #ifdef __cplusplus
@@ -73,10 +73,17 @@ struct msgq_s
   int16_t      nconnect;      /* Number of connections to message queue */
   int16_t      nwaitnotfull;  /* Number tasks waiting for not full */
   int16_t      nwaitnotempty; /* Number tasks waiting for not empty */
-#if CONFIG_MQ_MAXMSGSIZE < 256
+  dq_queue_t   waitnotfull;   /* Prioritized list of tasks waiting for not full */
+  dq_queue_t   waitnotempty;  /* Prioritized list of tasks waiting for not empty */
+#if CONFIG_MQ_MAXMSGSIZE < 256 && !defined(CONFIG_MQ_POOL)
   uint8_t      maxmsgsize;    /* Max size of message in message queue */
 #else
   uint16_t     maxmsgsize;    /* Max size of message in message queue */
+#endif
+#ifdef CONFIG_MQ_POOL
+  size_t       msgstride;     /* Size of one message in the message pool */
+  sq_queue_t   msgpool;       /* Free messages in the message pool */
+  FAR uint8_t *poolbase;      /* First message in the message pool */
 #endif
   bool         unlinked;      /* true if the msg queue has been unlinked */
 #ifndef CONFIG_DISABLE_SIGNALS
@@ -0,0 +1,299 @@
+/****************************************************************************
+ * include/nuttx/net/iob.h
+ * Network I/O buffer (IOB) support
+ *
+ *   Copyright (C) 2014 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+#ifndef __INCLUDE_NUTTX_NET_IOB_H
+#define __INCLUDE_NUTTX_NET_IOB_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef CONFIG_NET_IOB
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Configuration ************************************************************/
+
+#ifndef CONFIG_IOB_NBUFFERS
+#  define CONFIG_IOB_NBUFFERS 24
+#endif
+
+#ifndef CONFIG_IOB_BUFSIZE
+#  define CONFIG_IOB_BUFSIZE 196
+#endif
+
+#ifndef CONFIG_IOB_NCHAINS
+#  define CONFIG_IOB_NCHAINS 8
+#endif
+
+#ifndef CONFIG_IOB_THROTTLE
+#  define CONFIG_IOB_THROTTLE 0
+#endif
+
+#if CONFIG_IOB_THROTTLE >= CONFIG_IOB_NBUFFERS
+#  error CONFIG_IOB_THROTTLE must be less than CONFIG_IOB_NBUFFERS
+#endif
+
+/* Queue helpers */
+
+#define IOB_QINIT(q)   do { (q)->qh_head = 0; (q)->qh_tail = 0; } while (0)
+#define IOB_QEMPTY(q)  ((q)->qh_head == NULL)
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+/* Represents one I/O buffer.  A packet is contained by one or more I/O
+ * buffers in a chain.  The io_pktlen is only valid for the I/O buffer at
+ * the head of the chain.
+ */
+
+struct iob_s
+{
+  /* Singly-link list support */
+
+  FAR struct iob_s *io_flink;
+
+  /* Payload */
+
+  uint16_t io_len;      /* Length of the data in the entry */
+  uint16_t io_offset;   /* Data begins at this offset */
+  uint16_t io_pktlen;   /* Total length of the packet (head only) */
+  uint8_t  io_data[CONFIG_IOB_BUFSIZE];
+};
+
+/* A container that holds one I/O buffer chain in a queue.  Queues of chains
+ * are used where packet boundaries must be preserved (UDP datagrams) or
+ * where whole packets are handed from one layer to the next.
+ */
+
+struct iob_qentry_s
+{
+  /* Singly-link list support */
+
+  FAR struct iob_qentry_s *qe_flink;
+
+  /* Payload -- Head of the I/O buffer chain */
+
+  FAR struct iob_s *qe_head;
+};
+
+/* The head of a queue of I/O buffer chains */
+
+struct iob_queue_s
+{
+  FAR struct iob_qentry_s *qh_head;
+  FAR struct iob_qentry_s *qh_tail;
+};
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: iob_initialize
+ *
+ * Description:
+ *   Set up the I/O buffers for normal operations.
+ *
+ ****************************************************************************/
+
+void iob_initialize(void);
+
+/****************************************************************************
+ * Name: iob_alloc
+ *
+ * Description:
+ *   Allocate an I/O buffer by taking the buffer at the head of the free
+ *   list.  This function will wait until a buffer becomes available and so
+ *   may not be called from interrupt handlers.  If the caller holds the
+ *   uIP lock, the lock is released while waiting (see uip_lockedwait()) so
+ *   that the network can free buffers in the meantime.
+ *
+ ****************************************************************************/
+
+FAR struct iob_s *iob_alloc(void);
+
+/****************************************************************************
+ * Name: iob_tryalloc
+ *
+ * Description:
+ *   Try to allocate an I/O buffer by taking the buffer at the head of the
+ *   free list.  NULL is returned immediately if there is no free buffer.
+ *   If 'throttled' is true, NULL is also returned when taking the buffer
+ *   would leave fewer than CONFIG_IOB_THROTTLE buffers in the pool.  This
+ *   function may be called from interrupt handlers.
+ *
+ ****************************************************************************/
+
+FAR struct iob_s *iob_tryalloc(bool throttled);
+
+/****************************************************************************
+ * Name: iob_free
+ *
+ * Description:
+ *   Free the I/O buffer at the head of a buffer chain returning it to the
+ *   free list.  The link to the next I/O buffer in the chain is returned.
+ *
+ ****************************************************************************/
+
+FAR struct iob_s *iob_free(FAR struct iob_s *iob);
+
+/****************************************************************************
+ * Name: iob_free_chain
+ *
+ * Description:
+ *   Free an entire buffer chain, starting at the beginning of the I/O
+ *   buffer chain
+ *
+ ****************************************************************************/
+
+void iob_free_chain(FAR struct iob_s *iob);
+
+/****************************************************************************
+ * Name: iob_add_queue
+ *
+ * Description:
+ *   Add one I/O buffer chain to the end of a queue.  The chain is added by
+ *   reference; no data is copied.  Returns -ENOMEM if there is no free
+ *   queue container.  This function may be called from interrupt handlers.
+ *
+ ****************************************************************************/
+
+int iob_add_queue(FAR struct iob_s *iob, FAR struct iob_queue_s *iobq);
+
+/****************************************************************************
+ * Name: iob_remove_queue
+ *
+ * Description:
+ *   Remove and return one I/O buffer chain from the head of a queue.
+ *
+ ****************************************************************************/
+
+FAR struct iob_s *iob_remove_queue(FAR struct iob_queue_s *iobq);
+
+/****************************************************************************
+ * Name: iob_peek_queue
+ *
+ * Description:
+ *   Return a reference to the I/O buffer chain at the head of a queue
+ *   without removing it from the queue.
+ *
+ ****************************************************************************/
+
+#define iob_peek_queue(q) ((q)->qh_head ? (q)->qh_head->qe_head : NULL)
+
+/****************************************************************************
+ * Name: iob_free_queue
+ *
+ * Description:
+ *   Free an entire queue of I/O buffer chains.
+ *
+ ****************************************************************************/
+
+void iob_free_queue(FAR struct iob_queue_s *qhead);
+
+/****************************************************************************
+ * Name: iob_trimhead_queue
+ *
+ * Description:
+ *   Remove bytes from the beginning of the I/O buffer chain at the head of
+ *   a queue.  The chain is removed from the queue and freed when it becomes
+ *   empty.
+ *
+ ****************************************************************************/
+
+void iob_trimhead_queue(FAR struct iob_queue_s *qhead, unsigned int trimlen);
+
+/****************************************************************************
+ * Name: iob_copyin
+ *
+ * Description:
+ *  Copy data 'len' bytes from a user buffer into the I/O buffer chain,
+ *  starting at 'offset', extending the chain as necessary.  If 'can_block'
+ *  is true, buffers are taken with iob_alloc() and the caller may block.
+ *  Otherwise they are taken with iob_tryalloc(true), as is appropriate for
+ *  read-ahead buffering, and -ENOMEM is returned if none is available.
+ *
+ ****************************************************************************/
+
+int iob_copyin(FAR struct iob_s *iob, FAR const uint8_t *src,
+               unsigned int len, unsigned int offset, bool can_block);
+
+/****************************************************************************
+ * Name: iob_copyout
+ *
+ * Description:
+ *  Copy data 'len' bytes of data into the user buffer starting at 'offset'
+ *  in the I/O buffer, returning the number of bytes actually copied.
+ *
+ ****************************************************************************/
+
+int iob_copyout(FAR uint8_t *dest, FAR const struct iob_s *iob,
+                unsigned int len, unsigned int offset);
+
+/****************************************************************************
+ * Name: iob_concat
+ *
+ * Description:
+ *   Concatenate iob_s chain iob2 to iob1.
+ *
+ ****************************************************************************/
+
+void iob_concat(FAR struct iob_s *iob1, FAR struct iob_s *iob2);
+
+/****************************************************************************
+ * Name: iob_trimhead
+ *
+ * Description:
+ *   Remove bytes from the beginning of an I/O chain.  Emptied I/O buffers
+ *   are freed and, hence, the beginning of the chain may change.  The new
+ *   head of the chain is returned (NULL if the chain was emptied).
+ *
+ ****************************************************************************/
+
+FAR struct iob_s *iob_trimhead(FAR struct iob_s *iob, unsigned int trimlen);
+
+#endif /* CONFIG_NET_IOB */
+#endif /* __INCLUDE_NUTTX_NET_IOB_H */
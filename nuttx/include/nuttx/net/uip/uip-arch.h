@@ -169,6 +169,18 @@ struct uip_driver_s
 
   uint16_t d_sndlen;
 
+#ifdef CONFIG_NET_ZEROCOPY
+  /* When d_extlen is nonzero, the last d_extlen bytes of the d_len byte
+   * outgoing packet are not in d_buf but in the memory at d_extdata.  This
+   * can happen only if the driver has set d_zerocopy.  See the discussion
+   * of zero-copy transmission below.
+   */
+
+  FAR const uint8_t *d_extdata;
+  uint16_t d_extlen;
+  bool     d_zerocopy;
+#endif
+
   /* IGMP group list */
 
 #ifdef CONFIG_NET_IGMP
@@ -254,6 +266,62 @@ struct uip_driver_s
 
 int uip_input(struct uip_driver_s *dev);
 
+/* Batched input from a driver receive queue
+ *
+ * If CONFIG_NET_PKTQUEUE is selected, a driver that manages a ring of
+ * receive descriptors may hand all of the frames that it has harvested
+ * in one interrupt to uIP with a single call to uip_inputq().  Each frame
+ * is described by a struct uip_pktdesc_s that refers to the driver's own
+ * buffer; no copy into d_buf is performed.  Instead, uip_inputq() points
+ * d_buf at each frame in turn, performs the link-level dispatch shown
+ * above (including ARP processing for Ethernet), and then calls the
+ * driver-provided txqueue() function whenever a response is left in
+ * d_buf (d_len > 0).  The txqueue() function should queue the response on
+ * the driver's transmit ring.  The original value of d_buf is restored
+ * before uip_inputq() returns.
+ *
+ * Since the response is built in place, every buffer described in the
+ * receive queue must be at least CONFIG_NET_BUFSIZE + CONFIG_NET_GUARDSIZE
+ * bytes in size, regardless of the length of the received frame.
+ *
+ * The transmit side needs no special interface:  When a driver that uses
+ * CONFIG_NET_PKTQUEUE is polled via uip_poll() or uip_timer(), its
+ * callback function may queue the outgoing frame in d_buf, point d_buf at
+ * the next free transmit buffer, and return zero so that polling
+ * continues.  Polling is stopped (non-zero return) only when the transmit
+ * ring is full.  In this way, several outgoing segments are queued per
+ * poll.
+ *
+ * uip_inputq() returns the number of frames that were processed.  It has
+ * the same calling requirements as uip_input().
+ */
+
+#ifdef CONFIG_NET_PKTQUEUE
+struct uip_pktdesc_s
+{
+  FAR uint8_t *pd_buf;    /* Start of the frame (link-level header) */
+  uint16_t     pd_len;    /* Length of the frame in bytes */
+};
+
+typedef int (*uip_txqueue_t)(FAR struct uip_driver_s *dev);
+int uip_inputq(FAR struct uip_driver_s *dev, FAR struct uip_pktdesc_s *rxq,
+               int nrx, uip_txqueue_t txqueue);
+#endif
+
+/* Zero-copy transmission
+ *
+ * If CONFIG_NET_ZEROCOPY is selected, a TCP application callback may use
+ * uip_extsend() to send data that lies in stable memory (such as a file
+ * mapped with FIOC_MMAP) without copying it into d_buf.  This happens only
+ * for drivers that set d_zerocopy when they are initialized.  For such a
+ * driver, an outgoing packet may then have a nonzero d_extlen:  The
+ * headers, d_len - d_extlen bytes, are in d_buf as usual and the payload,
+ * d_extlen bytes, is at d_extdata.  The driver must transmit both pieces
+ * as one frame, for example by using two DMA descriptors, or it must copy
+ * the payload into place after the headers.  The data at d_extdata
+ * remains valid until it has been acknowledged by the peer.
+ */
+
 /* Polling of connections
  *
  * These functions will traverse each active uIP connection structure and
@@ -57,6 +57,10 @@
 #include <stdbool.h>
 #include <nuttx/net/uip/uipopt.h>
 
+#if defined(CONFIG_NET_TCP_READAHEAD) || defined(CONFIG_NET_TCP_WRITE_BUFFERS)
+#  include <nuttx/net/iob.h>
+#endif
+
 /****************************************************************************
  * Pre-processor Definitions
  ****************************************************************************/
@@ -168,14 +172,26 @@ struct uip_conn
   uint16_t unacked;       /* Number bytes sent but not yet ACKed */
 #endif
 
+  /* Hashed connection lookup
+   *
+   *   hlink - Links the active connections with the same hash of their
+   *     local port, remote port, and remote IP address.
+   *   plink - Links the connections with the same hash of their local port.
+   */
+
+#ifdef CONFIG_NET_TCP_HASH
+  FAR struct uip_conn *hlink;
+  FAR struct uip_conn *plink;
+#endif
+
   /* Read-ahead buffering.
    *
-   * readahead - A singly linked list of type struct uip_readahead_s
+   * readahead - A queue of I/O buffer chains, one per received segment,
    *   where the TCP/IP read-ahead data is retained.
    */
 
 #ifdef CONFIG_NET_TCP_READAHEAD
-  sq_queue_t readahead;   /* Read-ahead buffering */
+  struct iob_queue_s readahead; /* Read-ahead buffering */
 #endif
 
   /* Write buffering */
@@ -243,33 +259,21 @@ struct uip_conn
   void (*connection_event)(FAR struct uip_conn *conn, uint16_t flags);
 };
 
-/* The following structure is used to handle read-ahead buffering for TCP
- * connection.  When incoming TCP data is received while no application is
- * listening for the data, that data will be retained in these read-ahead
- * buffers so that no data is lost.
+/* This structure supports TCP write buffering.  The segment data is held
+ * in a chain of I/O buffers; wb_iob->io_pktlen is the size of the segment.
  */
 
-#ifdef CONFIG_NET_TCP_READAHEAD
-struct uip_readahead_s
-{
-  sq_entry_t rh_node;      /* Supports a singly linked list */
-  uint16_t   rh_nbytes;    /* Number of bytes available in this buffer */
-  uint8_t    rh_buffer[CONFIG_NET_TCP_READAHEAD_BUFSIZE];
-};
-#endif
-
-/* This structure supports TCP write buffering */
-
 #ifdef CONFIG_NET_TCP_WRITE_BUFFERS
 struct uip_wrbuffer_s
 {
   sq_entry_t wb_node;      /* Supports a singly linked list */
   uint32_t   wb_seqno;     /* Sequence number of the write segment */
-  uint16_t   wb_nbytes;    /* Number of bytes available in this buffer */
   uint8_t    wb_nrtx;      /* The number of retransmissions for the last
                             * segment sent */
-  uint8_t    wb_buffer[CONFIG_NET_TCP_WRITE_BUFSIZE];
+  FAR struct iob_s *wb_iob; /* Head of the I/O buffer chain */
 };
+
+#define WRB_PKTLEN(wrb)    ((wrb)->wb_iob->io_pktlen)
 #endif
 
 /* Support for listen backlog:
@@ -428,13 +432,6 @@ int uip_listen(struct uip_conn *conn);
 
 int uip_unlisten(struct uip_conn *conn);
 
-/* Access to TCP read-ahead buffers */
-
-#ifdef CONFIG_NET_TCP_READAHEAD
-FAR struct uip_readahead_s *uip_tcpreadahead_alloc(void);
-void uip_tcpreadahead_release(FAR struct uip_readahead_s *readahead);
-#endif /* CONFIG_NET_TCP_READAHEAD */
-
 /* Access to TCP write buffers */
 
 #ifdef CONFIG_NET_TCP_WRITE_BUFFERS
@@ -54,6 +54,10 @@
 #include <stdint.h>
 #include <nuttx/net/uip/uipopt.h>
 
+#ifdef CONFIG_NET_UDP_READAHEAD
+#  include <nuttx/net/iob.h>
+#endif
+
 /****************************************************************************
  * Pre-processor Definitions
  ****************************************************************************/
@@ -79,6 +83,21 @@ struct uip_udp_conn
   uint16_t rport;         /* The remote port number in network byte order */
   uint8_t  ttl;           /* Default time-to-live */
   uint8_t  crefs;         /* Reference counts on this instance */
+#ifdef CONFIG_NET_UDP_HASH
+  FAR struct uip_udp_conn *plink; /* Links connections with the same hash of
+                                   * their local port */
+#endif
+
+  /* Read-ahead buffering.
+   *
+   * readahead - A queue of I/O buffer chains, one per datagram, that
+   *   arrived while no recvfrom() was in place to receive it.  Each chain
+   *   begins with the address of the sender.
+   */
+
+#ifdef CONFIG_NET_UDP_READAHEAD
+  struct iob_queue_s readahead;
+#endif
 
   /* Defines the list of UDP callbacks */
 
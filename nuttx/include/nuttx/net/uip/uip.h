@@ -390,6 +390,33 @@ extern int uip_lockedwait(sem_t *sem);
 
 extern void uip_send(struct uip_driver_s *dev, const void *buf, int len);
 
+/* Send data from an I/O buffer chain.
+ *
+ * This is the same as uip_send() except that the data is taken from
+ * 'len' bytes of the I/O buffer chain 'iob' beginning at 'offset'.
+ * The data is copied directly from the chain into the device buffer.
+ */
+
+#ifdef CONFIG_NET_IOB
+struct iob_s;
+extern void uip_iobsend(struct uip_driver_s *dev, FAR struct iob_s *iob,
+                        unsigned int len, unsigned int offset);
+#endif
+
+/* Send TCP data from stable memory.
+ *
+ * This is the same as uip_send() except that, if the driver supports it
+ * (d_zerocopy), the data is not copied into the device buffer but is
+ * transmitted directly from 'buf'.  The caller must therefore keep the
+ * data unchanged until it has been acknowledged.  Only TCP callbacks may
+ * use this function.
+ */
+
+#ifdef CONFIG_NET_ZEROCOPY
+extern void uip_extsend(struct uip_driver_s *dev, FAR const void *buf,
+                        int len);
+#endif
+
 /* uIP convenience and converting functions.
  *
  * These functions can be used for converting between different data
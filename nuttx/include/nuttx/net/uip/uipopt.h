@@ -287,22 +287,15 @@
 # define CONFIG_NET_BUFSIZE 400
 #endif
 
-#ifdef CONFIG_NET_TCP_READAHEAD
-  /* Number of TCP read-ahead buffers */
-
-#  ifndef CONFIG_NET_NTCP_READAHEAD_BUFFERS
-#   define CONFIG_NET_NTCP_READAHEAD_BUFFERS 4
-#  endif
-
-  /* The size of one TCP read buffer */
+/* TCP read-ahead, TCP write buffering, and UDP read-ahead buffering all
+ * keep their data in the shared network I/O buffer pool.
+ */
 
-#  ifndef CONFIG_NET_TCP_READAHEAD_BUFSIZE
-#    define CONFIG_NET_TCP_READAHEAD_BUFSIZE UIP_TCP_MSS
+#if defined(CONFIG_NET_TCP_READAHEAD) || defined(CONFIG_NET_TCP_WRITE_BUFFERS) || \
+    defined(CONFIG_NET_UDP_READAHEAD)
+#  ifndef CONFIG_NET_IOB
+#    error CONFIG_NET_IOB is required for TCP/UDP buffering
 #  endif
-
-#else
-#  undef CONFIG_NET_TCP_READAHEAD_BUFSIZE
-#  undef CONFIG_NET_NTCP_READAHEAD_BUFFERS
 #endif
 
 #ifdef CONFIG_NET_TCP_WRITE_BUFFERS
@@ -312,7 +305,7 @@
 #    define CONFIG_NET_NTCP_WRITE_BUFFERS 1
 #  endif
 
-  /* The size of one TCP write buffer */
+  /* The maximum payload of one buffered TCP segment */
 
 #  ifndef CONFIG_NET_TCP_WRITE_BUFSIZE
 #    define CONFIG_NET_TCP_WRITE_BUFSIZE UIP_TCP_MSS
@@ -51,13 +51,40 @@
 
 /* Default pthread attribute initializer */
 
-#define PTHREAD_ATTR_INITIALIZER \
+#ifdef CONFIG_SMP
+#  define PTHREAD_ATTR_INITIALIZER \
 { \
   PTHREAD_STACK_DEFAULT,    /* stacksize */ \
   PTHREAD_DEFAULT_PRIORITY, /* priority */ \
   SCHED_RR,                 /* policy */ \
   PTHREAD_EXPLICIT_SCHED,   /* inheritsched */ \
+  0,                        /* affinity (all CPUs) */ \
 }
+#else
+#  define PTHREAD_ATTR_INITIALIZER \
+{ \
+  PTHREAD_STACK_DEFAULT,    /* stacksize */ \
+  PTHREAD_DEFAULT_PRIORITY, /* priority */ \
+  SCHED_RR,                 /* policy */ \
+  PTHREAD_EXPLICIT_SCHED,   /* inheritsched */ \
+}
+#endif
+
+/* With CONFIG_MUTEX_FASTPATH, the 'pid' field of a mutex is the lock word
+ * that the C library updates with up_cmpxchg():  It holds the ID of the
+ * holder of the mutex (zero if the mutex is available).
+ * PTHREAD_MUTEX_CONTENDED is also set when the OS has made the holder a
+ * holder of the mutex semaphore.  Then the mutex can only be released by
+ * pthread_mutex_give().  The bit is set alone while a released mutex is
+ * being handed over to the highest priority waiter.
+ */
+
+#ifdef CONFIG_MUTEX_FASTPATH
+#  define PTHREAD_MUTEX_CONTENDED  0x40000000
+#  define PTHREAD_MUTEX_HOLDER(m)  ((m)->pid & ~PTHREAD_MUTEX_CONTENDED)
+#else
+#  define PTHREAD_MUTEX_HOLDER(m)  ((m)->pid)
+#endif
 
 /****************************************************************************
  * Public Data
@@ -80,6 +107,45 @@ EXTERN pthread_attr_t g_default_pthread_attr;
  * Public Function Prototypes
  ****************************************************************************/
 
+#ifdef CONFIG_MUTEX_FASTPATH
+/****************************************************************************
+ * Name: pthread_mutex_take
+ *
+ * Description:
+ *   The OS part of pthread_mutex_lock():  Wait until the mutex becomes
+ *   available, then lock it.  This is called from the C library when the
+ *   fast path failed.  Recursive and error checking mutexes are handled by
+ *   the caller.
+ *
+ * Parameters:
+ *   mutex - A reference to the mutex to be locked.
+ *
+ * Return Value:
+ *   0 on success or an errno value on failure.
+ *
+ ****************************************************************************/
+
+int pthread_mutex_take(FAR pthread_mutex_t *mutex);
+
+/****************************************************************************
+ * Name: pthread_mutex_give
+ *
+ * Description:
+ *   The OS part of pthread_mutex_unlock():  Release a mutex that the OS
+ *   knows about because some other thread waited for it, waking up the
+ *   highest priority waiter.
+ *
+ * Parameters:
+ *   mutex - A reference to the mutex to be released.
+ *
+ * Return Value:
+ *   0 on success or an errno value on failure.
+ *
+ ****************************************************************************/
+
+int pthread_mutex_give(FAR pthread_mutex_t *mutex);
+#endif
+
 #undef EXTERN
 #ifdef __cplusplus
 }
@@ -1,7 +1,7 @@
 /****************************************************************************
  * include/nuttx/rwbuffer.h
  *
- *   Copyright (C) 2009 Gregory Nutt. All rights reserved.
+ *   Copyright (C) 2009, 2014 Gregory Nutt. All rights reserved.
  *   Author: Gregory Nutt <gnutt@nuttx.org>
  *
  * Redistribution and use in source and binary forms, with or without
@@ -91,8 +91,8 @@ typedef ssize_t (*rwbflush_t)(FAR void *dev, FAR const uint8_t *buffer,
  *
  *  struct foo_dev_s *priv;
  *  ...
- *  ... [Setup blocksize, nblocks, dev, wrmaxblocks, wrflush,
- *       rhmaxblocks, rhreload] ...
+ *  ... [Setup blocksize, nblocks, dev, rhreload, wrflush, wrmaxblocks,
+ *       rhmaxblocks] ...
  *  ret = rwb_initialize(&priv->rwbuffer);
  */
 
@@ -109,24 +109,33 @@ struct rwbuffer_s
   size_t        nblocks;         /* The total number blocks supported */
   FAR void     *dev;             /* Device state passed to callout functions */
 
+  /* Data transfer callouts.  rhreload is used to read blocks from the
+   * media and wrflush is used to write blocks to the media.  rhreload is
+   * required, even if only the write buffer is enabled, because transfers
+   * that are not buffered go directly to the media.  wrflush is required
+   * unless the media is never written (rwb_write() is never called and
+   * wrmaxblocks is zero).
+   */
+
+  rwbreload_t   rhreload;        /* Callout to read blocks from the media */
+  rwbflush_t    wrflush;         /* Callout to write blocks to the media */
+
   /* Write buffer setup.  If CONFIG_FS_WRITEBUFFER is defined, but you
-   * want read-ahead-only operation, (1) set wrmaxblocks to zero and do
-   * not use rwb_write().
+   * want read-ahead-only operation, set wrmaxblocks to zero.  Writes are
+   * then passed directly to the media.
    */
 
 #ifdef CONFIG_FS_WRITEBUFFER
   uint16_t      wrmaxblocks;     /* The number of blocks to buffer in memory */
-  rwbflush_t    wrflush;         /* Callout to flush the write buffer */
 #endif
 
   /* Read-ahead buffer setup.  If CONFIG_FS_READAHEAD is defined but you
-   * want write-buffer-only operation, then (1) set rhmaxblocks to zero and
-   * do not use rwb_read().
+   * want write-buffer-only operation, set rhmaxblocks to zero.  Reads are
+   * then taken directly from the media.
    */
 
 #ifdef CONFIG_FS_READAHEAD
   uint16_t      rhmaxblocks;     /* The number of blocks to buffer in memory */
-  rwbreload_t   rhreload;        /* Callout to reload the read-ahead buffer */
 #endif
 
   /********************************************************************/
@@ -141,15 +150,19 @@ struct rwbuffer_s
   uint16_t      wrnblocks;       /* Number of blocks in write buffer */
   off_t         wrblockstart;    /* First block in write buffer */
   off_t         wrexpectedblock; /* Next block expected */
+  uint32_t      wrmerges;        /* Number of blocks accepted into the buffer */
+  uint32_t      wrflushes;       /* Number of buffer flushes to the media */
 #endif
 
   /* This is the state of the read-ahead buffer */
 
 #ifdef CONFIG_FS_READAHEAD
-  sem_t         rhsem;           /* Enforces exclusive access to the write buffer */
+  sem_t         rhsem;           /* Enforces exclusive access to the read-ahead buffer */
   uint8_t      *rhbuffer;        /* Allocated read-ahead buffer */
   uint16_t      rhnblocks;       /* Number of blocks in read-ahead buffer */
   off_t         rhblockstart;    /* First block in read-ahead buffer */
+  uint32_t      rhhits;          /* Blocks read that were already buffered */
+  uint32_t      rhmisses;        /* Blocks read that required a reload */
 #endif
 };
 
@@ -159,8 +172,8 @@ struct rwbuffer_s
 
 #undef EXTERN
 #if defined(__cplusplus)
-#define EXTERN EXTERN "C"
-EXTERN "C" {
+#define EXTERN extern "C"
+extern "C" {
 #else
 #define EXTERN extern
 #endif
@@ -181,6 +194,7 @@ EXTERN ssize_t rwb_read(FAR struct rwbuffer_s *rwb, off_t startblock,
 EXTERN ssize_t rwb_write(FAR struct rwbuffer_s *rwb,
                          off_t startblock, size_t blockcount,
                          FAR const uint8_t *wrbuffer);
+EXTERN int rwb_flush(FAR struct rwbuffer_s *rwb);
 EXTERN int rwb_mediaremoved(FAR struct rwbuffer_s *rwb);
 
 #undef EXTERN
@@ -459,6 +459,12 @@ struct tcb_s
   uint16_t flags;                        /* Misc. general status flags          */
   int16_t  lockcount;                    /* 0=preemptable (not-locked)          */
 
+#ifdef CONFIG_SMP
+  uint8_t  cpu;                          /* CPU the thread runs or last ran on  */
+  int16_t  irqcount;                     /* Nesting of irqsave() critical sect. */
+  cpu_set_t affinity;                    /* CPUs the thread may run on          */
+#endif
+
 #if CONFIG_RR_INTERVAL > 0
   int      timeslice;                    /* RR timeslice interval remaining     */
 #endif
@@ -486,6 +492,14 @@ struct tcb_s
 
   sem_t *waitsem;                        /* Semaphore ID waiting on             */
 
+  /* Wait List Fields ***********************************************************/
+  /* A task blocked on a semaphore or a message queue is also kept in a
+   * prioritized wait list that belongs to that object.
+   */
+
+  dq_entry_t waitlink;                   /* Link in the object's wait list      */
+  FAR dq_queue_t *waitlist;              /* The wait list (NULL if none)        */
+
   /* POSIX Signal Control Fields ************************************************/
 
 #ifndef CONFIG_DISABLE_SIGNALS
@@ -0,0 +1,185 @@
+/****************************************************************************
+ * include/nuttx/spinlock.h
+ *
+ *   Copyright (C) 2014 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+#ifndef __INCLUDE_NUTTX_SPINLOCK_H
+#define __INCLUDE_NUTTX_SPINLOCK_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#if defined(CONFIG_SPINLOCK) || defined(CONFIG_ARCH_HAVE_CMPXCHG)
+
+/* The architecture specific header file must provide the following:
+ *
+ *   spinlock_t   - The type of a spinlock (usually an integer type)
+ *   SP_LOCKED    - The value of a locked spinlock
+ *   SP_UNLOCKED  - The value of an unlocked spinlock
+ *   SP_DMB()     - A data memory barrier
+ *
+ * And, if CONFIG_ARCH_HAVE_CMPXCHG is selected:
+ *
+ *   up_cmpxchg() - Atomically replace the int at 'addr' with 'newval' if
+ *                  it is equal to 'oldval'.  Returns true if the value was
+ *                  replaced:
+ *
+ *                  bool up_cmpxchg(FAR volatile int *addr, int oldval,
+ *                                  int newval);
+ *
+ *                  This is used in the C library (see CONFIG_MUTEX_FASTPATH)
+ *                  so it must be an inline function or a macro that does
+ *                  not depend on any OS or privileged instruction.
+ */
+
+#include <arch/spinlock.h>
+#endif
+
+#ifdef CONFIG_SPINLOCK
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: spin_initialize
+ *
+ * Description:
+ *   Initialize a spinlock object to its initial, unlocked state.
+ *
+ ****************************************************************************/
+
+#define spin_initialize(l)  do { *(l) = SP_UNLOCKED; } while (0)
+
+/****************************************************************************
+ * Name: spin_trylock
+ *
+ * Description:
+ *   Try once to lock the spinlock.  Do not wait if the spinlock is already
+ *   locked.  Returns true if the spinlock was locked.
+ *
+ ****************************************************************************/
+
+#define spin_trylock(l)     (up_testset(l) == SP_UNLOCKED)
+
+/****************************************************************************
+ * Name: spin_islocked
+ *
+ * Description:
+ *   Return true if the spinlock is locked.
+ *
+ ****************************************************************************/
+
+#define spin_islocked(l)    (*(l) == SP_LOCKED)
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+#ifdef __cplusplus
+#define EXTERN extern "C"
+extern "C"
+{
+#else
+#define EXTERN extern
+#endif
+
+/****************************************************************************
+ * Name: up_testset
+ *
+ * Description:
+ *   Perform an atomic test and set operation on the provided spinlock.
+ *   This function must be provided via the architecture-specific logic.
+ *
+ * Input Parameters:
+ *   lock - The address of spinlock object.
+ *
+ * Returned Value:
+ *   The spinlock is always locked upon return.  The value of previous value
+ *   of the spinlock variable is returned, either SP_LOCKED if the spinlock
+ *   was previously locked (meaning that the test-and-set operation failed
+ *   to obtain the lock) or SP_UNLOCKED if the spinlock was previously
+ *   unlocked (meaning that we successfully obtained the lock).
+ *
+ ****************************************************************************/
+
+spinlock_t up_testset(volatile FAR spinlock_t *lock);
+
+/****************************************************************************
+ * Name: spin_lock
+ *
+ * Description:
+ *   Wait until the spinlock can be locked, then lock it.  The spinlock is
+ *   not recursive:  Locking a spinlock that the caller already holds will
+ *   deadlock.
+ *
+ * Input Parameters:
+ *   lock - A reference to the spinlock object to lock.
+ *
+ * Returned Value:
+ *   None.  When the function returns, the spinlock was successfully locked
+ *   by this CPU.
+ *
+ ****************************************************************************/
+
+void spin_lock(volatile FAR spinlock_t *lock);
+
+/****************************************************************************
+ * Name: spin_unlock
+ *
+ * Description:
+ *   Release a spinlock that was locked by spin_lock() or spin_trylock().
+ *
+ * Input Parameters:
+ *   lock - A reference to the spinlock object to unlock.
+ *
+ * Returned Value:
+ *   None.
+ *
+ ****************************************************************************/
+
+void spin_unlock(volatile FAR spinlock_t *lock);
+
+#undef EXTERN
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CONFIG_SPINLOCK */
+#endif /* __INCLUDE_NUTTX_SPINLOCK_H */
@@ -45,7 +45,9 @@
 #include <sys/types.h>
 #include <stdint.h>
 #include <signal.h>
+#include <semaphore.h>
 #include <queue.h>
+#include <wdog.h>
 
 /****************************************************************************
  * Pre-Processor Definitions
@@ -67,12 +69,10 @@
  *   in order to build the high priority work queue.
  * CONFIG_SCHED_WORKPRIORITY - The execution priority of the worker
  *   thread.  Default: 192
- * CONFIG_SCHED_WORKPERIOD - How often the worker thread checks for
- *   work in units of microseconds.  Default: 50*1000 (50 MS).
+ * CONFIG_SCHED_HPNTHREADS - The number of threads that service the high
+ *   priority work queue.  Default: 1
  * CONFIG_SCHED_WORKSTACKSIZE - The stack size allocated for the worker
  *   thread.  Default: CONFIG_IDLETHREAD_STACKSIZE.
- * CONFIG_SIG_SIGWORK - The signal number that will be used to wake-up
- *   the worker thread.  Default: 17
  *
  * CONFIG_SCHED_LPWORK. If CONFIG_SCHED_WORKQUEUE is defined, then a single
  *   work queue is created by default.  If CONFIG_SCHED_LPWORK is also defined
@@ -81,10 +81,15 @@
  *   (such as file system clean-up operations)
  * CONFIG_SCHED_LPWORKPRIORITY - The execution priority of the lower priority
  *   worker thread.  Default: 50
- * CONFIG_SCHED_LPWORKPERIOD - How often the lower priority worker thread
- *  checks for work in units of microseconds.  Default: 50*1000 (50 MS).
+ * CONFIG_SCHED_LPNTHREADS - The number of threads that service the lower
+ *   priority work queue.  Default: 1
  * CONFIG_SCHED_LPWORKSTACKSIZE - The stack size allocated for the lower
  *   priority worker thread.  Default: CONFIG_IDLETHREAD_STACKSIZE.
+ *
+ * The worker threads do not poll.  Work that is ready to be performed is
+ * kept in a FIFO and delayed work is kept in a list ordered by expiration
+ * time.  An idle worker thread sleeps until new work is queued or until
+ * the next delayed work expires.
  */
 
 /* Is this a kernel build (CONFIG_NUTTX_KERNEL=y) */
@@ -148,6 +153,14 @@
 #  warning "Worker thread support requires signals"
 #endif
 
+/* Watchdog timers are not available to user-space code in the kernel
+ * build.  In that case, the worker thread uses a timed wait instead.
+ */
+
+#if !defined(CONFIG_NUTTX_KERNEL) || defined(__KERNEL__)
+#  define WORK_HAVE_WDOG 1
+#endif
+
 /* High priority, kernel work queue configuration ***************************/
 
 #ifdef CONFIG_SCHED_HPWORK
@@ -156,8 +169,8 @@
 #    define CONFIG_SCHED_WORKPRIORITY 192
 #  endif
 
-#  ifndef CONFIG_SCHED_WORKPERIOD
-#    define CONFIG_SCHED_WORKPERIOD (50*1000) /* 50 milliseconds */
+#  ifndef CONFIG_SCHED_HPNTHREADS
+#    define CONFIG_SCHED_HPNTHREADS 1
 #  endif
 
 #  ifndef CONFIG_SCHED_WORKSTACKSIZE
@@ -172,8 +185,8 @@
 #    define CONFIG_SCHED_LPWORKPRIORITY 50
 #  endif
 
-#  ifndef CONFIG_SCHED_LPWORKPERIOD
-#    define CONFIG_SCHED_LPWORKPERIOD (50*1000) /* 50 milliseconds */
+#  ifndef CONFIG_SCHED_LPNTHREADS
+#    define CONFIG_SCHED_LPNTHREADS 1
 #  endif
 
 #  ifndef CONFIG_SCHED_LPWORKSTACKSIZE
@@ -199,10 +212,6 @@
 #    define CONFIG_SCHED_USRWORKPRIORITY 50
 #  endif
 
-#  ifndef CONFIG_SCHED_USRWORKPERIOD
-#    define CONFIG_SCHED_USRWORKPERIOD (50*1000) /* 50 milliseconds */
-#  endif
-
 #  ifndef CONFIG_SCHED_USRWORKSTACKSIZE
 #    define CONFIG_SCHED_USRWORKSTACKSIZE CONFIG_IDLETHREAD_STACKSIZE
 #  endif
@@ -262,6 +271,17 @@
 
 #endif /* CONFIG_NUTTX_KERNEL && !__KERNEL__ */
 
+/* What is the largest number of threads that service any one work queue? */
+
+#if defined(CONFIG_SCHED_LPWORK) && \
+    CONFIG_SCHED_LPNTHREADS > CONFIG_SCHED_HPNTHREADS
+#  define WORK_MAXTHREADS CONFIG_SCHED_LPNTHREADS
+#elif defined(CONFIG_SCHED_HPWORK)
+#  define WORK_MAXTHREADS CONFIG_SCHED_HPNTHREADS
+#else
+#  define WORK_MAXTHREADS 1
+#endif
+
 /****************************************************************************
  * Public Types
  ****************************************************************************/
@@ -275,8 +295,13 @@
 
 struct wqueue_s
 {
-  pid_t             pid; /* The task ID of the worker thread */
-  struct dq_queue_s q;   /* The queue of pending work */
+  sem_t             sem;     /* Idle worker threads wait here for work */
+  struct dq_queue_s q;       /* FIFO of work that is ready to be performed */
+  struct dq_queue_s delayed; /* Delayed work ordered by expiration time */
+#ifdef WORK_HAVE_WDOG
+  WDOG_ID           wdog;    /* Wakes a worker when delayed work expires */
+#endif
+  pid_t             pid[WORK_MAXTHREADS]; /* Task IDs of the worker threads */
 };
 
 /* Defines the work callback */
@@ -294,7 +319,7 @@ struct work_s
   worker_t  worker;      /* Work callback */
   FAR void *arg;         /* Callback argument */
   uint32_t  qtime;       /* Time work queued */
-  uint32_t  delay;       /* Delay until work performed */
+  uint32_t  delay;       /* Delay until work performed (zero if ready) */
 };
 
 /****************************************************************************
@@ -453,9 +478,9 @@ int work_cancel(int qid, FAR struct work_s *work);
  * Name: work_signal
  *
  * Description:
- *   Signal the worker thread to process the work queue now.  This function
- *   is used internally by the work logic but could also be used by the
- *   user to force an immediate re-assessment of pending work.
+ *   Wake an idle worker thread to process the work queue now.  This
+ *   function is used internally by the work logic but could also be used
+ *   by the user to force an immediate re-assessment of pending work.
  *
  * Input parameters:
  *   qid    - The work queue ID
@@ -175,6 +175,9 @@ struct pthread_attr_s
   int16_t priority;     /* Priority of the pthread */
   uint8_t policy;       /* Pthread scheduler policy */
   uint8_t inheritsched; /* Inherit parent prio/policy? */
+#ifdef CONFIG_SMP
+  cpu_set_t affinity;   /* CPUs the pthread may run on (0 = all) */
+#endif
 };
 typedef struct pthread_attr_s pthread_attr_t;
 
@@ -187,7 +190,7 @@ struct pthread_cond_s
   sem_t sem;
 };
 typedef struct pthread_cond_s pthread_cond_t;
-#define PTHREAD_COND_INITIALIZER {{0, 0xffff}}
+#define PTHREAD_COND_INITIALIZER {SEM_INITIALIZER(0)}
 
 struct pthread_mutexattr_s
 {
@@ -270,6 +273,15 @@ int pthread_attr_getinheritsched(FAR const pthread_attr_t *attr,
 int pthread_attr_setstacksize(FAR pthread_attr_t *attr, long stacksize);
 int pthread_attr_getstacksize(FAR pthread_attr_t *attr, long *stackaddr);
 
+/* Set or obtain the set of CPUs that the thread may run on (non-standard) */
+
+#ifdef CONFIG_SMP
+int pthread_attr_setaffinity_np(FAR pthread_attr_t *attr, size_t cpusetsize,
+                                FAR const cpu_set_t *cpuset);
+int pthread_attr_getaffinity_np(FAR const pthread_attr_t *attr,
+                                size_t cpusetsize, FAR cpu_set_t *cpuset);
+#endif
+
 /* To create a thread object and runnable thread, a routine must be specified
  * as the new thread's start routine.  An argument may be passed to this
  * routine, as an untyped address; an untyped address may also be returned as
@@ -321,6 +333,15 @@ int pthread_setschedparam(pthread_t thread, int policy,
                           FAR const struct sched_param *param);
 int pthread_setschedprio(pthread_t thread, int prio);
 
+/* Thread CPU affinity (non-standard) */
+
+#ifdef CONFIG_SMP
+int pthread_setaffinity_np(pthread_t thread, size_t cpusetsize,
+                           FAR const cpu_set_t *cpuset);
+int pthread_getaffinity_np(pthread_t thread, size_t cpusetsize,
+                           FAR cpu_set_t *cpuset);
+#endif
+
 /* Thread-specific Data Interfaces */
 
 int pthread_key_create(FAR pthread_key_t *key,
@@ -63,6 +63,19 @@
 
 #define PTHREAD_KEYS_MAX CONFIG_NPTHREAD_KEYS
 
+/* CPU affinity *****************************************************************/
+/* Operations on a cpu_set_t.  These are modelled after the GNU macros of the
+ * same name but a cpu_set_t is simply a bit set with one bit per CPU.
+ */
+
+#ifdef CONFIG_SMP
+#  define CPU_SETSIZE         CONFIG_SMP_NCPUS
+#  define CPU_ZERO(s)         do { *(s) = 0; } while (0)
+#  define CPU_SET(c,s)        do { *(s) |= (1 << (c)); } while (0)
+#  define CPU_CLR(c,s)        do { *(s) &= ~(1 << (c)); } while (0)
+#  define CPU_ISSET(c,s)      ((*(s) & (1 << (c))) != 0)
+#endif
+
 /* Non-standard Helper **********************************************************/
 /* One processor family supported by NuttX has a single, fixed hardware stack.
  * That is the 8051 family.  So for that family only, there is a variant form
@@ -140,6 +153,15 @@ int    sched_get_priority_max(int policy);
 int    sched_get_priority_min(int policy);
 int    sched_rr_get_interval(pid_t pid, FAR struct timespec *interval);
 
+#ifdef CONFIG_SMP
+/* Task affinity interfaces (based on the GNU/Linux APIs) */
+
+int    sched_setaffinity(pid_t pid, size_t cpusetsize,
+                         FAR const cpu_set_t *mask);
+int    sched_getaffinity(pid_t pid, size_t cpusetsize, FAR cpu_set_t *mask);
+int    sched_getcpu(void);
+#endif
+
 /* Task Switching Interfaces (non-standard) */
 
 int    sched_lock(void);
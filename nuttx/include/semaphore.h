@@ -44,6 +44,7 @@
 
 #include <stdint.h>
 #include <limits.h>
+#include <queue.h>
 
 #ifdef __cplusplus
 #define EXTERN extern "C"
@@ -86,6 +87,10 @@ struct sem_s
 {
   int16_t semcount;              /* >0 -> Num counts available */
                                  /* <0 -> Num tasks waiting for semaphore */
+#ifdef CONFIG_SEM_WAITLIST
+  dq_queue_t waitlist;           /* Tasks waiting for the semaphore, in
+                                  * priority order (managed by the OS) */
+#endif
   /* If priority inheritance is enabled, then we have to keep track of which
    * tasks hold references to the semaphore.
    */
@@ -103,14 +108,23 @@ typedef struct sem_s sem_t;
 
 /* Initializers */
 
+#ifdef CONFIG_SEM_WAITLIST
+#  define SEM_WAITLIST_INITIALIZER {NULL, NULL},
+#else
+#  define SEM_WAITLIST_INITIALIZER
+#endif
+
 #ifdef CONFIG_PRIORITY_INHERITANCE
 # if CONFIG_SEM_PREALLOCHOLDERS > 0
-#  define SEM_INITIALIZER(c) {(c), NULL}  /* semcount, hhead */
+#  define SEM_INITIALIZER(c) /* semcount, waitlist, hhead */ \
+     {(c), SEM_WAITLIST_INITIALIZER NULL}
 # else
-#  define SEM_INITIALIZER(c) {(c), SEMHOLDER_INITIALIZER} /* semcount, holder */
+#  define SEM_INITIALIZER(c) /* semcount, waitlist, holder */ \
+     {(c), SEM_WAITLIST_INITIALIZER SEMHOLDER_INITIALIZER}
 # endif
 #else
-#  define SEM_INITIALIZER(c) {(c)} /* semcount */
+#  define SEM_INITIALIZER(c) /* semcount, waitlist */ \
+     {(c), SEM_WAITLIST_INITIALIZER}
 #endif
 
 /****************************************************************************
@@ -296,23 +296,36 @@
 #  define SYS_pthread_key_delete       (__SYS_pthread+16)
 #  define SYS_pthread_mutex_destroy    (__SYS_pthread+17)
 #  define SYS_pthread_mutex_init       (__SYS_pthread+18)
-#  define SYS_pthread_mutex_lock       (__SYS_pthread+19)
-#  define SYS_pthread_mutex_trylock    (__SYS_pthread+20)
-#  define SYS_pthread_mutex_unlock     (__SYS_pthread+21)
-#  define SYS_pthread_once             (__SYS_pthread+22)
-#  define SYS_pthread_setcancelstate   (__SYS_pthread+23)
-#  define SYS_pthread_setschedparam    (__SYS_pthread+24)
-#  define SYS_pthread_setschedprio     (__SYS_pthread+25)
-#  define SYS_pthread_setspecific      (__SYS_pthread+26)
-#  define SYS_pthread_yield            (__SYS_pthread+27)
+
+/* With CONFIG_MUTEX_FASTPATH, mutexes are locked and unlocked in the C
+ * library.  Only the slow paths are system calls.
+ */
+
+#  ifdef CONFIG_MUTEX_FASTPATH
+#    define SYS_pthread_mutex_give     (__SYS_pthread+19)
+#    define SYS_pthread_mutex_take     (__SYS_pthread+20)
+#    define __SYS_pthread_once         (__SYS_pthread+21)
+#  else
+#    define SYS_pthread_mutex_lock     (__SYS_pthread+19)
+#    define SYS_pthread_mutex_trylock  (__SYS_pthread+20)
+#    define SYS_pthread_mutex_unlock   (__SYS_pthread+21)
+#    define __SYS_pthread_once         (__SYS_pthread+22)
+#  endif
+
+#  define SYS_pthread_once             (__SYS_pthread_once+0)
+#  define SYS_pthread_setcancelstate   (__SYS_pthread_once+1)
+#  define SYS_pthread_setschedparam    (__SYS_pthread_once+2)
+#  define SYS_pthread_setschedprio     (__SYS_pthread_once+3)
+#  define SYS_pthread_setspecific      (__SYS_pthread_once+4)
+#  define SYS_pthread_yield            (__SYS_pthread_once+5)
 
 #  ifndef CONFIG_DISABLE_SIGNAL
-#    define SYS_pthread_cond_timedwait (__SYS_pthread+28)
-#    define SYS_pthread_kill           (__SYS_pthread+29)
-#    define SYS_pthread_sigmask        (__SYS_pthread+30)
-#    define __SYS_mqueue               (__SYS_pthread+31)
+#    define SYS_pthread_cond_timedwait (__SYS_pthread_once+6)
+#    define SYS_pthread_kill           (__SYS_pthread_once+7)
+#    define SYS_pthread_sigmask        (__SYS_pthread_once+8)
+#    define __SYS_mqueue               (__SYS_pthread_once+9)
 #  else
-#    define __SYS_mqueue               (__SYS_pthread+28)
+#    define __SYS_mqueue               (__SYS_pthread_once+6)
 #  endif
 
 #else
@@ -232,6 +232,12 @@ typedef uint32_t     clock_t;
 typedef uint32_t     useconds_t;
 typedef int32_t      suseconds_t;
 
+/* A set of CPUs, one bit per CPU (see sched_setaffinity()) */
+
+#ifdef CONFIG_SMP
+typedef uint32_t     cpu_set_t;
+#endif
+
 /* Task entry point */
 
 typedef CODE int (*main_t)(int argc, char *argv[]);
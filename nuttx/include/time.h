@@ -56,10 +56,14 @@
  *
  * The default value is 100Hz, but this default setting can be overridden by
  * defining the clock interval in milliseconds as CONFIG_MSEC_PER_TICK in the
- * board configuration file.
+ * board configuration file (or in microseconds as CONFIG_USEC_PER_TICK in the
+ * tick-less mode).
  */
 
-#ifdef CONFIG_MSEC_PER_TICK
+#if defined(CONFIG_SCHED_TICKLESS) && defined(CONFIG_USEC_PER_TICK)
+# define CLK_TCK           (1000000/CONFIG_USEC_PER_TICK)
+# define CLOCKS_PER_SEC    (1000000/CONFIG_USEC_PER_TICK)
+#elif defined(CONFIG_MSEC_PER_TICK)
 # define CLK_TCK           (1000/CONFIG_MSEC_PER_TICK)
 # define CLOCKS_PER_SEC    (1000/CONFIG_MSEC_PER_TICK)
 #else
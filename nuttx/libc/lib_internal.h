@@ -43,6 +43,7 @@
 #include <nuttx/config.h>
 
 #include <sys/types.h>
+#include <stdint.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <limits.h>
@@ -119,6 +120,38 @@
 
 #define LIB_BUFLEN_UNKNOWN INT_MAX
 
+/* The number of CRC lookup tables (and bytes processed per step) used by
+ * the CRC functions in libc/misc.
+ */
+
+#if defined(CONFIG_LIBC_CRC_SLICE8)
+#  define LIB_CRC_NTABLES   8
+#elif defined(CONFIG_LIBC_CRC_SLICE4)
+#  define LIB_CRC_NTABLES   4
+#else
+#  define LIB_CRC_NTABLES   1
+#endif
+
+/* Support for the word-at-a-time string functions.  A word is the native
+ * register width as represented by uintptr_t.
+ *
+ *   LIB_WORDSIZE      - Size of one word in bytes
+ *   LIB_WORDMASK      - Mask of the byte offset within a word
+ *   LIB_ONES          - 0x01 repeated in each byte of a word
+ *   LIB_HIGHS         - 0x80 repeated in each byte of a word
+ *   LIB_HASZERO(w)    - Non-zero if any byte of the word w is zero
+ *   LIB_ALIGNED(p)    - True if p is word aligned
+ */
+
+#ifdef CONFIG_LIBC_STRING_OPTSPEED
+#  define LIB_WORDSIZE      sizeof(uintptr_t)
+#  define LIB_WORDMASK      (sizeof(uintptr_t) - 1)
+#  define LIB_ONES          ((uintptr_t)-1 / 0xff)
+#  define LIB_HIGHS         (LIB_ONES << 7)
+#  define LIB_HASZERO(w)    (((w) - LIB_ONES) & ~(w) & LIB_HIGHS)
+#  define LIB_ALIGNED(p)    ((((uintptr_t)(p)) & LIB_WORDMASK) == 0)
+#endif
+
 /****************************************************************************
  * Public Types
  ****************************************************************************/
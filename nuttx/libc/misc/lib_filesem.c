@@ -42,6 +42,7 @@
 #include <sys/types.h>
 #include <unistd.h>
 #include <semaphore.h>
+#include <pthread.h>
 #include <errno.h>
 #include <assert.h>
 
@@ -53,6 +54,12 @@
  * Pre-processor Definitions
  ************************************************************************/
 
+/* With CONFIG_MUTEX_FASTPATH, the stream is protected by a mutex so that
+ * taking and releasing an uncontended stream does not enter the OS.  The
+ * recursion for nested stdio calls is still handled here by fs_holder and
+ * fs_counts.
+ */
+
 /************************************************************************
  * Private Data
  ************************************************************************/
@@ -71,7 +78,11 @@ void lib_sem_initialize(FAR struct file_struct *stream)
    * to private data sets.
    */
 
+#ifdef CONFIG_MUTEX_FASTPATH
+  (void)pthread_mutex_init(&stream->fs_lock, NULL);
+#else
   (void)sem_init(&stream->fs_sem, 0, 1);
+#endif
 
   stream->fs_holder = -1;
   stream->fs_counts = 0;
@@ -95,6 +106,13 @@ void lib_take_semaphore(FAR struct file_struct *stream)
     }
   else
     {
+#ifdef CONFIG_MUTEX_FASTPATH
+      /* Lock the mutex (perhaps waiting).  This is not interrupted by
+       * signals.
+       */
+
+      ASSERT(pthread_mutex_lock(&stream->fs_lock) == 0);
+#else
       /* Take the semaphore (perhaps waiting) */
 
       while (sem_wait(&stream->fs_sem) != 0)
@@ -105,6 +123,7 @@ void lib_take_semaphore(FAR struct file_struct *stream)
 
           ASSERT(get_errno() == EINTR);
         }
+#endif
 
       /* We have it.  Claim the stak and return */
 
@@ -139,7 +158,11 @@ void lib_give_semaphore(FAR struct file_struct *stream)
 
       stream->fs_holder = -1;
       stream->fs_counts = 0;
+#ifdef CONFIG_MUTEX_FASTPATH
+      ASSERT(pthread_mutex_unlock(&stream->fs_lock) == 0);
+#else
       ASSERT(sem_post(&stream->fs_sem) == 0);
+#endif
     }
 }
 #endif /* CONFIG_STDIO_BUFFER_SIZE */
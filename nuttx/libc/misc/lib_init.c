@@ -92,7 +92,11 @@ void lib_streaminit(FAR struct streamlist *list)
 
   /* Initialize the list access mutex */
 
+#ifdef CONFIG_MUTEX_FASTPATH
+  (void)pthread_mutex_init(&list->sl_lock, NULL);
+#else
   (void)sem_init(&list->sl_sem, 0, 1);
+#endif
 
   /* Initialize each FILE structure */
 
@@ -129,7 +133,11 @@ void lib_releaselist(FAR struct streamlist *list)
 
   /* Destroy the semaphore and release the filelist */
 
+#ifdef CONFIG_MUTEX_FASTPATH
+  (void)pthread_mutex_destroy(&list->sl_lock);
+#else
   (void)sem_destroy(&list->sl_sem);
+#endif
 
   /* Release each stream in the list */
 
@@ -138,7 +146,11 @@ void lib_releaselist(FAR struct streamlist *list)
     {
       /* Destroy the semaphore that protects the IO buffer */
 
+#ifdef CONFIG_MUTEX_FASTPATH
+      (void)pthread_mutex_destroy(&list->sl_streams[i].fs_lock);
+#else
       (void)sem_destroy(&list->sl_streams[i].fs_sem);
+#endif
 
       /* Release the IO buffer */
 
@@ -43,6 +43,7 @@
 #include <string.h>
 #include <assert.h>
 #include <semaphore.h>
+#include <pthread.h>
 #include <errno.h>
 #include <nuttx/fs/fs.h>
 
@@ -70,6 +71,11 @@
 
 void stream_semtake(FAR struct streamlist *list)
 {
+#ifdef CONFIG_MUTEX_FASTPATH
+  /* Lock the mutex (perhaps waiting) */
+
+  ASSERT(pthread_mutex_lock(&list->sl_lock) == 0);
+#else
   /* Take the semaphore (perhaps waiting) */
 
   while (sem_wait(&list->sl_sem) != 0)
@@ -80,9 +86,14 @@ void stream_semtake(FAR struct streamlist *list)
 
       ASSERT(get_errno() == EINTR);
     }
+#endif
 }
 
 void stream_semgive(FAR struct streamlist *list)
 {
+#ifdef CONFIG_MUTEX_FASTPATH
+  (void)pthread_mutex_unlock(&list->sl_lock);
+#else
   sem_post(&list->sl_sem);
+#endif
 }
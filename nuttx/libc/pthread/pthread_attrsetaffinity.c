@@ -0,0 +1,97 @@
+/****************************************************************************
+ * libc/pthread/pthread_attrsetaffinity.c
+ *
+ *   Copyright (C) 2014 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <pthread.h>
+#include <sched.h>
+#include <debug.h>
+#include <errno.h>
+
+#ifdef CONFIG_SMP
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Function:  pthread_attr_setaffinity_np
+ *
+ * Description:
+ *   The pthread_attr_setaffinity_np() function sets the CPU affinity mask
+ *   attribute of the thread attributes object referred to by attr to the
+ *   value specified in cpuset.  This attribute determines the CPU affinity
+ *   mask of a thread created using the thread attributes object attr.
+ *
+ * Parameters:
+ *   attr       - The handle to the pthread attributes object
+ *   cpusetsize - The size of the cpuset.  MUST be sizeof(cpu_set_t).
+ *   cpuset     - The CPU set.  An empty set means that the thread may run
+ *                on any CPU.
+ *
+ * Return Value:
+ *   0 if successful.  Otherwise, an error code.
+ *
+ * Assumptions:
+ *
+ ****************************************************************************/
+
+int pthread_attr_setaffinity_np(FAR pthread_attr_t *attr, size_t cpusetsize,
+                                FAR const cpu_set_t *cpuset)
+{
+  int ret;
+
+  sdbg("attr=0x%p cpusetsize=%d cpuset=0x%p\n",
+       attr, (int)cpusetsize, cpuset);
+
+  if (!attr || !cpuset || cpusetsize < sizeof(cpu_set_t))
+    {
+      ret = EINVAL;
+    }
+  else
+    {
+      attr->affinity = *cpuset;
+      ret = OK;
+    }
+
+  sdbg("Returning %d\n", ret);
+  return ret;
+}
+
+#endif /* CONFIG_SMP */
@@ -0,0 +1,151 @@
+/****************************************************************************
+ * libc/pthread/pthread_mutexunlock.c
+ *
+ *   Copyright (C) 2014 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <unistd.h>
+#include <pthread.h>
+#include <errno.h>
+
+#include <nuttx/spinlock.h>
+#include <nuttx/pthread.h>
+
+#ifdef CONFIG_MUTEX_FASTPATH
+
+/****************************************************************************
+ * Definitions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Private Type Declarations
+ ****************************************************************************/
+
+/****************************************************************************
+ * Global Variables
+ ****************************************************************************/
+
+/****************************************************************************
+ * Private Variables
+ ****************************************************************************/
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: pthread_mutex_unlock
+ *
+ * Description:
+ *   The pthread_mutex_unlock() function releases the mutex object referenced
+ *   by mutex. The manner in which a mutex is released is dependent upon the
+ *   mutex's type attribute. If there are threads blocked on the mutex object
+ *   referenced by mutex when pthread_mutex_unlock() is called, resulting in
+ *   the mutex becoming available, the scheduling policy is used to determine
+ *   which thread shall acquire the mutex. (In the case of PTHREAD_MUTEX_RECURSIVE
+ *   mutexes, the mutex becomes available when the count reaches zero and the
+ *   calling thread no longer has any locks on this mutex).
+ *
+ *   If a signal is delivered to a thread waiting for a mutex, upon return from
+ *   the signal handler the thread resumes waiting for the mutex as if it was
+ *   not interrupted.
+ *
+ *   This is the C library fast path:  The mutex is released with a single
+ *   compare-and-swap unless another thread has waited for it.  Then the OS
+ *   has to wake up the waiter and the mutex is released by
+ *   pthread_mutex_give().
+ *
+ * Parameters:
+ *   mutex - A reference to the mutex to be released.
+ *
+ * Return Value:
+ *   0 on success or an errno value on failure.
+ *
+ * Assumptions:
+ *
+ ****************************************************************************/
+
+int pthread_mutex_unlock(FAR pthread_mutex_t *mutex)
+{
+  int mypid = (int)getpid();
+
+  if (!mutex)
+    {
+      return EINVAL;
+    }
+
+  /* Does the calling thread hold the mutex? */
+
+  if (PTHREAD_MUTEX_HOLDER(mutex) != mypid)
+    {
+      /* No... return an error (default behavior is like PTHREAD_MUTEX_ERRORCHECK) */
+
+      return EPERM;
+    }
+
+#ifdef CONFIG_MUTEX_TYPES
+  /* Is this a recursive mutex with multiple locks held?  Then just
+   * decrement the count of locks held.
+   */
+
+  if (mutex->type == PTHREAD_MUTEX_RECURSIVE && mutex->nlocks > 1)
+    {
+      mutex->nlocks--;
+      return OK;
+    }
+
+  mutex->nlocks = 0;
+#endif
+
+  /* Release the mutex.  This fails only if the mutex has been marked
+   * contended by a waiter.
+   */
+
+  if (up_cmpxchg((FAR volatile int *)&mutex->pid, mypid, 0))
+    {
+      return OK;
+    }
+
+  return pthread_mutex_give(mutex);
+}
+
+#endif /* CONFIG_MUTEX_FASTPATH */
@@ -104,6 +104,9 @@ int sem_init(FAR sem_t *sem, int pshared, unsigned int value)
       /* Initialize the seamphore count */
 
       sem->semcount      = (int16_t)value;
+#ifdef CONFIG_SEM_WAITLIST
+      dq_init(&sem->waitlist);
+#endif
 
       /* Initialize to support priority inheritance */
 
@@ -110,7 +110,11 @@ int fclose(FAR FILE *stream)
 #if CONFIG_STDIO_BUFFER_SIZE > 0
       /* Destroy the semaphore */
 
+#ifdef CONFIG_MUTEX_FASTPATH
+      pthread_mutex_destroy(&stream->fs_lock);
+#else
       sem_destroy(&stream->fs_sem);
+#endif
 
       /* Release the buffer */
 
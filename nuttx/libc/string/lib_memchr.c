@@ -1,7 +1,7 @@
 /****************************************************************************
  * libc/string/lib_memchr.c
  *
- *   Copyright (C) 2012 Gregory Nutt. All rights reserved.
+ *   Copyright (C) 2012, 2014 Gregory Nutt. All rights reserved.
  *   Author: Gregory Nutt <gnutt@nuttx.org>
  *
  * Redistribution and use in source and binary forms, with or without
@@ -39,8 +39,11 @@
 
 #include <nuttx/config.h>
 
+#include <stdint.h>
 #include <string.h>
 
+#include "lib_internal.h"
+
 /****************************************************************************
  * Global Functions
  ****************************************************************************/
@@ -65,6 +68,40 @@ FAR void *memchr(FAR const void *s, int c, size_t n)
 
   if (s)
     {
+#ifdef CONFIG_LIBC_STRING_OPTSPEED
+      if (n >= 2 * LIB_WORDSIZE)
+        {
+          FAR const uintptr_t *w;
+          uintptr_t pattern = LIB_ONES * (unsigned char)c;
+
+          /* Check bytes until the pointer is word aligned */
+
+          while (!LIB_ALIGNED(p))
+            {
+              if (*p == (unsigned char)c)
+                {
+                  return (FAR void *)p;
+                }
+
+              p++;
+              n--;
+            }
+
+          /* Skip over words that do not contain the byte.  A word contains
+           * the byte if the XOR of the word and the pattern has a zero byte.
+           */
+
+          w = (FAR const uintptr_t *)p;
+          while (n >= LIB_WORDSIZE && !LIB_HASZERO(*w ^ pattern))
+            {
+              w++;
+              n -= LIB_WORDSIZE;
+            }
+
+          p = (FAR const unsigned char *)w;
+        }
+#endif
+
       while (n--)
         {
           if (*p == (unsigned char)c)
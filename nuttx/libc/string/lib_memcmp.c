@@ -1,7 +1,7 @@
 /************************************************************
  * libc/string/lib_memcmp.c
  *
- *   Copyright (C) 2007, 2011-2012 Gregory Nutt. All rights reserved.
+ *   Copyright (C) 2007, 2011-2012, 2014 Gregory Nutt. All rights reserved.
  *   Author: Gregory Nutt <gnutt@nuttx.org>
  *
  * Redistribution and use in source and binary forms, with or without
@@ -43,8 +43,11 @@
 
 #include <nuttx/config.h>
 #include <sys/types.h>
+#include <stdint.h>
 #include <string.h>
 
+#include "lib_internal.h"
+
 /************************************************************
  * Global Functions
  ************************************************************/
@@ -55,6 +58,48 @@ int memcmp(FAR const void *s1, FAR const void *s2, size_t n)
   unsigned char *p1 = (unsigned char *)s1;
   unsigned char *p2 = (unsigned char *)s2;
 
+#ifdef CONFIG_LIBC_STRING_OPTSPEED
+  /* Word comparisons are possible only if both buffers have the same
+   * alignment.
+   */
+
+  if (n >= 2 * LIB_WORDSIZE &&
+      (((uintptr_t)p1 ^ (uintptr_t)p2) & LIB_WORDMASK) == 0)
+    {
+      FAR const uintptr_t *w1;
+      FAR const uintptr_t *w2;
+
+      while (!LIB_ALIGNED(p1))
+        {
+          if (*p1 != *p2)
+            {
+              return *p1 < *p2 ? -1 : 1;
+            }
+
+          p1++;
+          p2++;
+          n--;
+        }
+
+      /* Skip over equal words.  The byte loop below locates the difference
+       * within the first unequal word.
+       */
+
+      w1 = (FAR const uintptr_t *)p1;
+      w2 = (FAR const uintptr_t *)p2;
+
+      while (n >= LIB_WORDSIZE && *w1 == *w2)
+        {
+          w1++;
+          w2++;
+          n -= LIB_WORDSIZE;
+        }
+
+      p1 = (unsigned char *)w1;
+      p2 = (unsigned char *)w2;
+    }
+#endif
+
   while (n-- > 0)
     {
       if (*p1 < *p2)
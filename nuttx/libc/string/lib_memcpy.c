@@ -1,7 +1,7 @@
 /****************************************************************************
  * libc/string/lib_memcpy.c
  *
- *   Copyright (C) 2007, 2011 Gregory Nutt. All rights reserved.
+ *   Copyright (C) 2007, 2011, 2014 Gregory Nutt. All rights reserved.
  *   Author: Gregory Nutt <gnutt@nuttx.org>
  *
  * Redistribution and use in source and binary forms, with or without
@@ -43,8 +43,62 @@
 
 #include <nuttx/config.h>
 #include <sys/types.h>
+#include <stdint.h>
 #include <string.h>
 
+#include "lib_internal.h"
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: memcpy_shifted
+ *
+ * Description:
+ *   Copy whole words to the word-aligned destination 'dw' from a source
+ *   that is not word aligned.  Each output word is assembled from two
+ *   aligned source words.  Every aligned source word that is read contains
+ *   at least one byte that is part of the copy, so the copy never touches
+ *   memory outside of the word that holds the last source byte.
+ *
+ *   Returns the number of bytes copied (a multiple of the word size).
+ *
+ ****************************************************************************/
+
+#if !defined(CONFIG_ARCH_MEMCPY) && defined(CONFIG_LIBC_STRING_OPTSPEED)
+static size_t memcpy_shifted(FAR uintptr_t *dw, FAR const unsigned char *src,
+                             size_t n)
+{
+  FAR const uintptr_t *sw;
+  unsigned int lshift;
+  unsigned int rshift;
+  uintptr_t w0;
+  uintptr_t w1;
+  size_t nwords;
+  size_t i;
+
+  lshift = 8 * ((uintptr_t)src & LIB_WORDMASK);
+  rshift = 8 * LIB_WORDSIZE - lshift;
+  sw     = (FAR const uintptr_t *)((uintptr_t)src & ~LIB_WORDMASK);
+  nwords = n / LIB_WORDSIZE;
+  w0     = *sw++;
+
+  for (i = 0; i < nwords; i++)
+    {
+      w1 = *sw++;
+#ifdef CONFIG_ENDIAN_BIG
+      *dw++ = (w0 << lshift) | (w1 >> rshift);
+#else
+      *dw++ = (w0 >> lshift) | (w1 << rshift);
+#endif
+      w0 = w1;
+    }
+
+  return nwords * LIB_WORDSIZE;
+}
+#endif
+
 /****************************************************************************
  * Global Functions
  ****************************************************************************/
@@ -58,6 +112,66 @@ FAR void *memcpy(FAR void *dest, FAR const void *src, size_t n)
 {
   FAR unsigned char *pout = (FAR unsigned char*)dest;
   FAR unsigned char *pin  = (FAR unsigned char*)src;
+
+#ifdef CONFIG_LIBC_STRING_OPTSPEED
+  /* Short copies are not worth the setup */
+
+  if (n >= 4 * LIB_WORDSIZE)
+    {
+      FAR uintptr_t *dw;
+      FAR const uintptr_t *sw;
+      size_t nbytes;
+
+      /* Copy bytes until the destination is word aligned */
+
+      while (!LIB_ALIGNED(pout))
+        {
+          *pout++ = *pin++;
+          n--;
+        }
+
+      dw = (FAR uintptr_t *)pout;
+      if (LIB_ALIGNED(pin))
+        {
+          /* Both are aligned:  Copy four words per iteration, then single
+           * words.
+           */
+
+          sw = (FAR const uintptr_t *)pin;
+          while (n >= 4 * LIB_WORDSIZE)
+            {
+              dw[0] = sw[0];
+              dw[1] = sw[1];
+              dw[2] = sw[2];
+              dw[3] = sw[3];
+              dw   += 4;
+              sw   += 4;
+              n    -= 4 * LIB_WORDSIZE;
+            }
+
+          while (n >= LIB_WORDSIZE)
+            {
+              *dw++ = *sw++;
+              n    -= LIB_WORDSIZE;
+            }
+
+          pout = (FAR unsigned char *)dw;
+          pin  = (FAR unsigned char *)sw;
+        }
+      else
+        {
+          /* Only the destination is aligned */
+
+          nbytes = memcpy_shifted(dw, pin, n);
+          pout  += nbytes;
+          pin   += nbytes;
+          n     -= nbytes;
+        }
+    }
+#endif
+
+  /* Copy the remaining bytes (or all of them if optimized for size) */
+
   while (n-- > 0) *pout++ = *pin++;
   return dest;
 }
@@ -2,7 +2,7 @@
 /****************************************************************************
  * libc/string/lib_memset.c
  *
- *   Copyright (C) 2007, 2011 Gregory Nutt. All rights reserved.
+ *   Copyright (C) 2007, 2011, 2014 Gregory Nutt. All rights reserved.
  *   Author: Gregory Nutt <gnutt@nuttx.org>
  *
  * Redistribution and use in source and binary forms, with or without
@@ -55,6 +55,15 @@
  * integer types.
  */
 
+/* Use 64-bit stores if the native word is 64-bits wide and the word-at-a-
+ * time string functions are selected.
+ */
+
+#if defined(CONFIG_LIBC_STRING_OPTSPEED) && UINTPTR_MAX > UINT32_MAX
+#  undef  CONFIG_MEMSET_64BIT
+#  define CONFIG_MEMSET_64BIT 1
+#endif
+
 #ifndef CONFIG_HAVE_LONG_LONG
 #  undef CONFIG_MEMSET_64BIT
 #endif
@@ -108,7 +117,19 @@ void *memset(void *s, int c, size_t n)
             }
 
 #ifndef CONFIG_MEMSET_64BIT
-          /* Loop while there are at least 32-bits left to be written */
+          /* Loop while there are at least four 32-bit words left to be
+           * written, then while there are at least 32-bits left.
+           */
+
+          while (n >= 16)
+            {
+              ((uint32_t*)addr)[0] = val32;
+              ((uint32_t*)addr)[1] = val32;
+              ((uint32_t*)addr)[2] = val32;
+              ((uint32_t*)addr)[3] = val32;
+              addr += 16;
+              n    -= 16;
+            }
 
           while (n >= 4)
             {
@@ -132,7 +153,19 @@ void *memset(void *s, int c, size_t n)
                   n    -= 4;
                 }
 
-              /* Loop while there are at least 64-bits left to be written */
+              /* Loop while there are at least four 64-bit words left to be
+               * written, then while there are at least 64-bits left.
+               */
+
+              while (n >= 32)
+                {
+                  ((uint64_t*)addr)[0] = val64;
+                  ((uint64_t*)addr)[1] = val64;
+                  ((uint64_t*)addr)[2] = val64;
+                  ((uint64_t*)addr)[3] = val64;
+                  addr += 32;
+                  n    -= 32;
+                }
 
               while (n >= 8)
                 {
@@ -1,7 +1,7 @@
 /****************************************************************************
  * libc/string/lib_strlen.c
  *
- *   Copyright (C) 2007, 2008, 2011 Gregory Nutt. All rights reserved.
+ *   Copyright (C) 2007, 2008, 2011, 2014 Gregory Nutt. All rights reserved.
  *   Author: Gregory Nutt <gnutt@nuttx.org>
  *
  * Redistribution and use in source and binary forms, with or without
@@ -39,8 +39,11 @@
 
 #include <nuttx/config.h>
 #include <sys/types.h>
+#include <stdint.h>
 #include <string.h>
 
+#include "lib_internal.h"
+
 /****************************************************************************
  * Global Functions
  ****************************************************************************/
@@ -49,7 +52,32 @@
 size_t strlen(const char *s)
 {
   const char *sc;
+
+#ifdef CONFIG_LIBC_STRING_OPTSPEED
+  FAR const uintptr_t *w;
+
+  /* Check bytes until the pointer is word aligned */
+
+  for (sc = s; !LIB_ALIGNED(sc); ++sc)
+    {
+      if (*sc == '\0')
+        {
+          return sc - s;
+        }
+    }
+
+  /* Then check a word at a time.  An aligned word never crosses a page
+   * boundary so it is safe to read past the terminator within that word.
+   */
+
+  for (w = (FAR const uintptr_t *)sc; !LIB_HASZERO(*w); w++);
+
+  /* Find the terminator within the word */
+
+  for (sc = (const char *)w; *sc != '\0'; ++sc);
+#else
   for (sc = s; *sc != '\0'; ++sc);
+#endif
   return sc - s;
 }
 #endif
@@ -1,7 +1,7 @@
 /****************************************************************************
  * libc/wqueue/work_cancel.c
  *
- *   Copyright (C) 2009-2010, 2012-2013 Gregory Nutt. All rights reserved.
+ *   Copyright (C) 2009-2010, 2012-2014 Gregory Nutt. All rights reserved.
  *   Author: Gregory Nutt <gnutt@nuttx.org>
  *
  * Redistribution and use in source and binary forms, with or without
@@ -105,16 +105,24 @@ int work_cancel(int qid, FAR struct work_s *work)
   flags = irqsave();
   if (work->worker != NULL)
     {
+      /* Work that is ready to be performed is in the FIFO; work that is
+       * still delayed is in the list of delayed work.  If the work was the
+       * first delayed work, the worker may be awakened needlessly when the
+       * watchdog expires but that is harmless.
+       */
+
+      FAR dq_queue_t *q = work->delay ? &wqueue->delayed : &wqueue->q;
+
       /* A little test of the integrity of the work queue */
 
-      DEBUGASSERT(work->dq.flink ||(FAR dq_entry_t *)work == wqueue->q.tail);
-      DEBUGASSERT(work->dq.blink ||(FAR dq_entry_t *)work == wqueue->q.head);
+      DEBUGASSERT(work->dq.flink ||(FAR dq_entry_t *)work == q->tail);
+      DEBUGASSERT(work->dq.blink ||(FAR dq_entry_t *)work == q->head);
 
       /* Remove the entry from the work queue and make sure that it is
        * mark as availalbe (i.e., the worker field is nullified).
        */
 
-      dq_rem((FAR dq_entry_t *)work, &wqueue->q);
+      dq_rem((FAR dq_entry_t *)work, q);
       work->worker = NULL;
     }
 
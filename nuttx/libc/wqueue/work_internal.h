@@ -0,0 +1,108 @@
+/****************************************************************************
+ * libc/wqueue/work_internal.h
+ *
+ *   Copyright (C) 2014 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+#ifndef __LIBC_WQUEUE_WORK_INTERNAL_H
+#define __LIBC_WQUEUE_WORK_INTERNAL_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+#include <nuttx/wqueue.h>
+
+#ifdef CONFIG_SCHED_WORKQUEUE
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* The absolute time (in clock ticks) when delayed work expires */
+
+#define WORK_EXPIRATION(w) ((w)->qtime + (w)->delay)
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: work_notify
+ *
+ * Description:
+ *   Wake one idle worker thread, if there is one.  If all of the worker
+ *   threads are busy, then nothing need be done:  Each worker thread
+ *   re-examines the work queue before it waits again.
+ *
+ * Input parameters:
+ *   wqueue - The work queue to be notified
+ *
+ * Returned Value:
+ *   None
+ *
+ * Assumptions:
+ *   Interrupts are disabled.  This function may be called from interrupt
+ *   handlers.
+ *
+ ****************************************************************************/
+
+void work_notify(FAR struct wqueue_s *wqueue);
+
+/****************************************************************************
+ * Name: work_timeout
+ *
+ * Description:
+ *   This is the watchdog handler that runs when the first delayed work in
+ *   a work queue expires.  It wakes an idle worker thread.
+ *
+ * Input parameters:
+ *   argc - The number of arguments (always 1)
+ *   qid  - The work queue ID
+ *
+ * Returned Value:
+ *   None
+ *
+ * Assumptions:
+ *   Runs in the context of the timer interrupt handler.
+ *
+ ****************************************************************************/
+
+#ifdef WORK_HAVE_WDOG
+void work_timeout(int argc, uint32_t qid);
+#endif
+
+#endif /* CONFIG_SCHED_WORKQUEUE */
+#endif /* __LIBC_WQUEUE_WORK_INTERNAL_H */
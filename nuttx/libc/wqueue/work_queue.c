@@ -1,7 +1,7 @@
 /****************************************************************************
  * libc/wqueue/work_queue.c
  *
- *   Copyright (C) 2009-2011, 2013 Gregory Nutt. All rights reserved.
+ *   Copyright (C) 2009-2011, 2013-2014 Gregory Nutt. All rights reserved.
  *   Author: Gregory Nutt <gnutt@nuttx.org>
  *
  * Redistribution and use in source and binary forms, with or without
@@ -40,6 +40,7 @@
 #include <nuttx/config.h>
 
 #include <stdint.h>
+#include <stdbool.h>
 #include <queue.h>
 #include <assert.h>
 #include <errno.h>
@@ -49,6 +50,8 @@
 #include <nuttx/clock.h>
 #include <nuttx/wqueue.h>
 
+#include "work_internal.h"
+
 #ifdef CONFIG_SCHED_WORKQUEUE
 
 /****************************************************************************
@@ -71,6 +74,51 @@
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: work_delayed
+ *
+ * Description:
+ *   Insert delayed work into the list of delayed work which is ordered by
+ *   expiration time.  The search begins at the tail of the list because
+ *   newly queued work usually expires after the work that is already
+ *   queued.
+ *
+ * Input parameters:
+ *   wqueue - The work queue
+ *   work   - The time-tagged work structure to be added
+ *
+ * Returned Value:
+ *   true if the work was added at the head of the list (i.e., if this work
+ *   will now be the first to expire).
+ *
+ * Assumptions:
+ *   Interrupts are disabled.
+ *
+ ****************************************************************************/
+
+static bool work_delayed(FAR struct wqueue_s *wqueue,
+                         FAR struct work_s *work)
+{
+  FAR struct work_s *prev;
+  uint32_t expire = WORK_EXPIRATION(work);
+
+  prev = (FAR struct work_s *)wqueue->delayed.tail;
+  while (prev && (int32_t)(expire - WORK_EXPIRATION(prev)) < 0)
+    {
+      prev = (FAR struct work_s *)prev->dq.blink;
+    }
+
+  if (prev)
+    {
+      dq_addafter((FAR dq_entry_t *)prev, (FAR dq_entry_t *)work,
+                  &wqueue->delayed);
+      return false;
+    }
+
+  dq_addfirst((FAR dq_entry_t *)work, &wqueue->delayed);
+  return true;
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -126,8 +174,33 @@ int work_queue(int qid, FAR struct work_s *work, worker_t worker,
   flags        = irqsave();
   work->qtime  = clock_systimer(); /* Time work queued */
 
-  dq_addlast((FAR dq_entry_t *)work, &wqueue->q);
-  kill(wqueue->pid, SIGWORK);      /* Wake up the worker thread */
+  if (delay == 0)
+    {
+      /* The work is ready now.  Add it to the end of the FIFO and wake up
+       * an idle worker thread.
+       */
+
+      dq_addlast((FAR dq_entry_t *)work, &wqueue->q);
+      work_notify(wqueue);
+    }
+  else if (work_delayed(wqueue, work))
+    {
+      /* This work will expire before any other delayed work.  The worker
+       * threads must be re-awakened at the new time.  The watchdog delay is
+       * extended by one tick internally so that it expires on the tick when
+       * the work becomes ready.
+       */
+
+#ifdef WORK_HAVE_WDOG
+      if (wqueue->wdog)
+        {
+          (void)wd_start(wqueue->wdog, (int)delay - 1,
+                         (wdentry_t)work_timeout, 1, (uint32_t)qid);
+        }
+#else
+      work_notify(wqueue);
+#endif
+    }
 
   irqrestore(flags);
   return OK;
@@ -1,7 +1,7 @@
 /****************************************************************************
  * libc/wqueue/work_signal.c
  *
- *   Copyright (C) 2009-2013 Gregory Nutt. All rights reserved.
+ *   Copyright (C) 2009-2014 Gregory Nutt. All rights reserved.
  *   Author: Gregory Nutt <gnutt@nuttx.org>
  *
  * Redistribution and use in source and binary forms, with or without
@@ -39,11 +39,14 @@
 
 #include <nuttx/config.h>
 
-#include <signal.h>
+#include <semaphore.h>
 #include <assert.h>
 
+#include <nuttx/arch.h>
 #include <nuttx/wqueue.h>
 
+#include "work_internal.h"
+
 #ifdef CONFIG_SCHED_WORKQUEUE
 
 /****************************************************************************
@@ -69,13 +72,45 @@
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
+
+/****************************************************************************
+ * Name: work_notify
+ *
+ * Description:
+ *   Wake one idle worker thread, if there is one.  If all of the worker
+ *   threads are busy, then nothing need be done:  Each worker thread
+ *   re-examines the work queue before it waits again.
+ *
+ * Input parameters:
+ *   wqueue - The work queue to be notified
+ *
+ * Returned Value:
+ *   None
+ *
+ * Assumptions:
+ *   Interrupts are disabled.  This function may be called from interrupt
+ *   handlers.
+ *
+ ****************************************************************************/
+
+void work_notify(FAR struct wqueue_s *wqueue)
+{
+  int semcount;
+
+  /* A negative count is the number of worker threads waiting for work */
+
+  if (sem_getvalue(&wqueue->sem, &semcount) == OK && semcount < 0)
+    {
+      (void)sem_post(&wqueue->sem);
+    }
+}
 /****************************************************************************
  * Name: work_signal
  *
  * Description:
- *   Signal the worker thread to process the work queue now.  This function
- *   is used internally by the work logic but could also be used by the
- *   user to force an immediate re-assessment of pending work.
+ *   Wake an idle worker thread to process the work queue now.  This
+ *   function is used internally by the work logic but could also be used
+ *   by the user to force an immediate re-assessment of pending work.
  *
  * Input parameters:
  *   qid    - The work queue ID
@@ -87,8 +122,14 @@
 
 int work_signal(int qid)
 {
+  irqstate_t flags;
+
   DEBUGASSERT((unsigned)qid < NWORKERS);
-  return kill(g_work[qid].pid, SIGWORK);
+
+  flags = irqsave();
+  work_notify(&g_work[qid]);
+  irqrestore(flags);
+  return OK;
 }
 
 #endif /* CONFIG_SCHED_WORKQUEUE */
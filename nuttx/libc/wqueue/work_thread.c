@@ -1,7 +1,7 @@
 /****************************************************************************
  * libc/wqueue/work_thread.c
  *
- *   Copyright (C) 2009-2013 Gregory Nutt. All rights reserved.
+ *   Copyright (C) 2009-2014 Gregory Nutt. All rights reserved.
  *   Author: Gregory Nutt <gnutt@nuttx.org>
  *
  * Redistribution and use in source and binary forms, with or without
@@ -40,7 +40,8 @@
 #include <nuttx/config.h>
 
 #include <stdint.h>
-#include <unistd.h>
+#include <semaphore.h>
+#include <time.h>
 #include <queue.h>
 #include <assert.h>
 #include <errno.h>
@@ -51,6 +52,8 @@
 #include <nuttx/clock.h>
 #include <nuttx/kmalloc.h>
 
+#include "work_internal.h"
+
 #ifdef CONFIG_SCHED_WORKQUEUE
 
 /****************************************************************************
@@ -97,109 +100,193 @@ struct wqueue_s g_work[NWORKERS];
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: work_timedwait
+ *
+ * Description:
+ *   Wait until more work is queued or until the specified number of clock
+ *   ticks has elapsed.  This is used only in the user-space portion of the
+ *   kernel build where watchdog timers are not available.
+ *
+ * Input parameters:
+ *   wqueue - Describes the work queue to wait on
+ *   ticks  - The maximum time to wait
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+#ifndef WORK_HAVE_WDOG
+static void work_timedwait(FAR struct wqueue_s *wqueue, uint32_t ticks)
+{
+  struct timespec abstime;
+
+  (void)clock_gettime(CLOCK_REALTIME, &abstime);
+
+  abstime.tv_sec  += ticks / TICK_PER_SEC;
+  abstime.tv_nsec += (ticks % TICK_PER_SEC) * NSEC_PER_TICK;
+  if (abstime.tv_nsec >= NSEC_PER_SEC)
+    {
+      abstime.tv_sec++;
+      abstime.tv_nsec -= NSEC_PER_SEC;
+    }
+
+  (void)sem_timedwait(&wqueue->sem, &abstime);
+}
+#endif
+
 /****************************************************************************
  * Name: work_process
  *
  * Description:
- *   This is the logic that performs actions placed on any work list.
+ *   This is the logic that performs actions placed on any work list.  Each
+ *   call performs at most one piece of work.  If there is no work ready,
+ *   the worker thread sleeps until more work is queued or until the first
+ *   delayed work expires.
  *
  * Input parameters:
- *   wqueue - Describes the work queue to be processed
+ *   qid - The ID of the work queue to be processed
  *
  * Returned Value:
  *   None
  *
  ****************************************************************************/
 
-static void work_process(FAR struct wqueue_s *wqueue)
+static void work_process(int qid)
 {
-  volatile FAR struct work_s *work;
+  FAR struct wqueue_s *wqueue = &g_work[qid];
+  FAR struct work_s *work;
   worker_t  worker;
   irqstate_t flags;
   FAR void *arg;
-  uint32_t elapsed;
+  uint32_t now;
   uint32_t remaining;
-  uint32_t next;
 
-  /* Then process queued work.  We need to keep interrupts disabled while
-   * we process items in the work list.
+  /* Interrupts must be disabled while the work lists are examined because
+   * work may be queued or cancelled from interrupt handlers.
    */
 
-  next  = CONFIG_SCHED_WORKPERIOD / USEC_PER_TICK;
   flags = irqsave();
-  work  = (FAR struct work_s *)wqueue->q.head;
-  while (work)
-    {
-      /* Is this work ready?  It is ready if there is no delay or if
-       * the delay has elapsed. qtime is the time that the work was added
-       * to the work queue.  It will always be greater than or equal to
-       * zero.  Therefore a delay of zero will always execute immediately.
-       */
 
-      elapsed = clock_systimer() - work->qtime;
-      if (elapsed >= work->delay)
-        {
-          /* Remove the ready-to-execute work from the list */
+#ifdef WORK_HAVE_WDOG
+  /* Allocate the watchdog that will wake up the worker threads when
+   * delayed work expires.
+   */
 
-          (void)dq_rem((struct dq_entry_s *)work, &wqueue->q);
+  if (!wqueue->wdog)
+    {
+      wqueue->wdog = wd_create();
+      DEBUGASSERT(wqueue->wdog != NULL);
+    }
+#endif
 
-          /* Extract the work description from the entry (in case the work
-           * instance by the re-used after it has been de-queued).
-           */
+  /* Move all delayed work that has expired to the end of the FIFO of ready
+   * work.  Delayed work is ordered by expiration time so only the head of
+   * the list needs to be examined.
+   */
 
-          worker = work->worker;
-          arg    = work->arg;
+  now = clock_systimer();
+  while ((work = (FAR struct work_s *)wqueue->delayed.head) != NULL &&
+         (int32_t)(now - WORK_EXPIRATION(work)) >= 0)
+    {
+      (void)dq_remfirst(&wqueue->delayed);
+      work->delay = 0;
+      dq_addlast((FAR dq_entry_t *)work, &wqueue->q);
+    }
 
-          /* Mark the work as no longer being queued */
+  /* Take the oldest work that is ready to be performed */
 
-          work->worker = NULL;
+  work = (FAR struct work_s *)dq_remfirst(&wqueue->q);
+  if (work)
+    {
+      /* If there is still more work ready, wake another worker thread (if
+       * there is an idle one) to perform it in parallel.
+       */
 
-          /* Do the work.  Re-enable interrupts while the work is being
-           * performed... we don't have any idea how long that will take!
-           */
+      if (wqueue->q.head)
+        {
+          work_notify(wqueue);
+        }
 
-          irqrestore(flags);
-          worker(arg);
+      /* Extract the work description from the entry (in case the work
+       * instance by the re-used after it has been de-queued).
+       */
 
-          /* Now, unfortunately, since we re-enabled interrupts we don't
-           * know the state of the work list and we will have to start
-           * back at the head of the list.
-           */
+      worker = work->worker;
+      arg    = work->arg;
 
-          flags = irqsave();
-          work  = (FAR struct work_s *)wqueue->q.head;
-        }
-      else
-        {
-          /* This one is not ready.. will it be ready before the next
-           * scheduled wakeup interval?
-           */
+      /* Mark the work as no longer being queued */
 
-          remaining = elapsed - work->delay;
-          if (remaining < next)
-            {
-              /* Yes.. Then schedule to wake up when the work is ready */
+      work->worker = NULL;
 
-              next = remaining;
-            }
-              
-          /* Then try the next in the list. */
+      /* Do the work.  Re-enable interrupts while the work is being
+       * performed... we don't have any idea how long that will take!
+       */
 
-          work = (FAR struct work_s *)work->dq.flink;
-        }
+      irqrestore(flags);
+      worker(arg);
+      return;
     }
 
-  /* Wait awhile to check the work list.  We will wait here until either
-   * the time elapses or until we are awakened by a signal.
+  /* There is no work ready.  Wait here until more work is queued or until
+   * the first delayed work expires.
    */
 
-  usleep(next * USEC_PER_TICK);
+  work = (FAR struct work_s *)wqueue->delayed.head;
+  if (work)
+    {
+      /* The watchdog delay is extended by one tick internally so that it
+       * expires on the tick when the work becomes ready.
+       */
+
+      remaining = WORK_EXPIRATION(work) - now;
+#ifdef WORK_HAVE_WDOG
+      (void)wd_start(wqueue->wdog, (int)remaining - 1,
+                     (wdentry_t)work_timeout, 1, (uint32_t)qid);
+      (void)sem_wait(&wqueue->sem);
+#else
+      work_timedwait(wqueue, remaining);
+#endif
+    }
+  else
+    {
+      (void)sem_wait(&wqueue->sem);
+    }
+
   irqrestore(flags);
 }
 
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
+
+/****************************************************************************
+ * Name: work_timeout
+ *
+ * Description:
+ *   This is the watchdog handler that runs when the first delayed work in
+ *   a work queue expires.  It wakes an idle worker thread.
+ *
+ * Input parameters:
+ *   argc - The number of arguments (always 1)
+ *   qid  - The work queue ID
+ *
+ * Returned Value:
+ *   None
+ *
+ * Assumptions:
+ *   Runs in the context of the timer interrupt handler.
+ *
+ ****************************************************************************/
+
+#ifdef WORK_HAVE_WDOG
+void work_timeout(int argc, uint32_t qid)
+{
+  work_notify(&g_work[qid]);
+}
+#endif
+
 /****************************************************************************
  * Name: work_hpthread, work_lpthread, and work_usrthread
  *
@@ -250,11 +337,11 @@ int work_hpthread(int argc, char *argv[])
       sched_garbagecollection();
 #endif
 
-      /* Then process queued work.  We need to keep interrupts disabled while
-       * we process items in the work list.
+      /* Then process queued work.  This will block if there is no work
+       * ready to be performed.
        */
 
-      work_process(&g_work[HPWORK]);
+      work_process(HPWORK);
     }
 
   return OK; /* To keep some compilers happy */
@@ -277,11 +364,11 @@ int work_lpthread(int argc, char *argv[])
 
       sched_garbagecollection();
 
-      /* Then process queued work.  We need to keep interrupts disabled while
-       * we process items in the work list.
+      /* Then process queued work.  This will block if there is no work
+       * ready to be performed.
        */
 
-      work_process(&g_work[LPWORK]);
+      work_process(LPWORK);
     }
 
   return OK; /* To keep some compilers happy */
@@ -298,11 +385,11 @@ int work_usrthread(int argc, char *argv[])
 
   for (;;)
     {
-      /* Then process queued work.  We need to keep interrupts disabled while
-       * we process items in the work list.
+      /* Then process queued work.  This will block if there is no work
+       * ready to be performed.
        */
 
-      work_process(&g_work[USRWORK]);
+      work_process(USRWORK);
     }
 
   return OK; /* To keep some compilers happy */
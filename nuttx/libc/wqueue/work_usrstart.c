@@ -40,6 +40,7 @@
 #include <nuttx/config.h>
 
 #include <sched.h>
+#include <semaphore.h>
 #include <errno.h>
 #include <assert.h>
 #include <debug.h>
@@ -93,14 +94,18 @@ int work_usrstart(void)
 
   svdbg("Starting user-mode worker thread\n");
 
-  g_usrwork[USRWORK].pid = TASK_CREATE("usrwork",
+  /* Initialize the semaphore that the idle worker thread waits on */
+
+  (void)sem_init(&g_usrwork[USRWORK].sem, 0, 0);
+
+  g_usrwork[USRWORK].pid[0] = TASK_CREATE("usrwork",
                                        CONFIG_SCHED_USRWORKPRIORITY,
                                        CONFIG_SCHED_USRWORKSTACKSIZE,
                                        (main_t)work_usrthread,
                                        (FAR char * const *)NULL);
 
-  DEBUGASSERT(g_usrwork[USRWORK].pid > 0);
-  if (g_usrwork[USRWORK].pid < 0)
+  DEBUGASSERT(g_usrwork[USRWORK].pid[0] > 0);
+  if (g_usrwork[USRWORK].pid[0] < 0)
     {
       int errcode = errno;
       DEBUGASSERT(errcode > 0);
@@ -109,7 +114,7 @@ int work_usrstart(void)
       return -errcode;
     }
 
-  return g_usrwork[USRWORK].pid;
+  return g_usrwork[USRWORK].pid[0];
 }
 
 #endif /* CONFIG_NUTTX_KERNEL && !__KERNEL__ CONFIG_SCHED_WORKQUEUE && CONFIG_SCHED_USRWORK */
@@ -0,0 +1,258 @@
+/****************************************************************************
+ * mm/mm_cache.c
+ *
+ *   Copyright (C) 2014 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdbool.h>
+#include <assert.h>
+
+#include <arch/irq.h>
+#include <nuttx/mm.h>
+
+#ifdef CONFIG_MM_CACHE
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: mm_cachealloc
+ *
+ * Description:
+ *   Take a chunk of exactly the requested size from the small block cache.
+ *   The chunk is still marked as allocated in the heap so neither the MM
+ *   semaphore nor the nodelist is involved.
+ *
+ * Input Parameters:
+ *   heap - The heap that holds the cache
+ *   size - The chunk size, including the chunk header and aligned to the
+ *          granule size.
+ *
+ * Returned Value:
+ *   The address of the user memory in the chunk; NULL if the size is not
+ *   cached or if there is no chunk of that size in the cache.
+ *
+ ****************************************************************************/
+
+FAR void *mm_cachealloc(FAR struct mm_heap_s *heap, size_t size)
+{
+  FAR struct mm_freenode_s *node;
+  irqstate_t flags;
+  int ndx;
+
+  if (!MM_CACHEABLE(size))
+    {
+      return NULL;
+    }
+
+  ndx   = MM_CACHE_NDX(size);
+  flags = irqsave();
+
+  node = heap->mm_cache[ndx];
+  if (node)
+    {
+      heap->mm_cache[ndx] = node->flink;
+      heap->mm_ncached[ndx]--;
+    }
+
+  irqrestore(flags);
+
+  if (!node)
+    {
+      return NULL;
+    }
+
+  DEBUGASSERT(node->size == size && (node->preceding & MM_ALLOC_BIT) != 0);
+  return (FAR void *)((FAR char *)node + SIZEOF_MM_ALLOCNODE);
+}
+
+/****************************************************************************
+ * Name: mm_cachefree
+ *
+ * Description:
+ *   Hold a small chunk that is being freed in the cache (if there is space
+ *   in the cache for a chunk of that size).
+ *
+ * Input Parameters:
+ *   heap - The heap that holds the cache
+ *   node - The allocated chunk being freed
+ *
+ * Returned Value:
+ *   True if the chunk was added to the cache; false if the chunk must be
+ *   returned to the heap.
+ *
+ ****************************************************************************/
+
+bool mm_cachefree(FAR struct mm_heap_s *heap, FAR struct mm_allocnode_s *node)
+{
+  FAR struct mm_freenode_s *fnode = (FAR struct mm_freenode_s *)node;
+  irqstate_t flags;
+  bool ret = false;
+  int ndx;
+
+  /* Chunks are cached only if they are of one of the cached sizes.  Chunks
+   * carved out by memalign() may not be a multiple of the granule size.
+   */
+
+  if (!MM_CACHEABLE(node->size) || (node->size & MM_GRAN_MASK) != 0)
+    {
+      return false;
+    }
+
+  ndx   = MM_CACHE_NDX(node->size);
+  flags = irqsave();
+
+  if (heap->mm_ncached[ndx] < CONFIG_MM_CACHE_DEPTH)
+    {
+      fnode->flink        = heap->mm_cache[ndx];
+      heap->mm_cache[ndx] = fnode;
+      heap->mm_ncached[ndx]++;
+      ret = true;
+    }
+
+  irqrestore(flags);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: mm_cacheadd
+ *
+ * Description:
+ *   Add a newly allocated, small chunk to the cache.  This is used when
+ *   the cache is refilled in a batch.  Unlike mm_cachefree(), the chunk is
+ *   always accepted so the chunk must be exactly of one of the cached
+ *   sizes.
+ *
+ * Input Parameters:
+ *   heap - The heap that holds the cache
+ *   node - The allocated chunk
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+void mm_cacheadd(FAR struct mm_heap_s *heap, FAR struct mm_allocnode_s *node)
+{
+  FAR struct mm_freenode_s *fnode = (FAR struct mm_freenode_s *)node;
+  irqstate_t flags;
+  int ndx;
+
+  DEBUGASSERT(MM_CACHEABLE(node->size) && (node->size & MM_GRAN_MASK) == 0);
+
+  ndx   = MM_CACHE_NDX(node->size);
+  flags = irqsave();
+
+  fnode->flink        = heap->mm_cache[ndx];
+  heap->mm_cache[ndx] = fnode;
+  heap->mm_ncached[ndx]++;
+
+  irqrestore(flags);
+}
+
+/****************************************************************************
+ * Name: mm_cacheremove
+ *
+ * Description:
+ *   Remove all of the chunks of one size from the cache.
+ *
+ * Input Parameters:
+ *   heap - The heap that holds the cache
+ *   ndx  - The index of the cache list
+ *
+ * Returned Value:
+ *   The first chunk in the list of removed chunks (linked through the
+ *   flink field); NULL if there were no chunks of that size in the cache.
+ *
+ ****************************************************************************/
+
+FAR struct mm_freenode_s *mm_cacheremove(FAR struct mm_heap_s *heap, int ndx)
+{
+  FAR struct mm_freenode_s *node;
+  irqstate_t flags;
+
+  flags = irqsave();
+
+  node                  = heap->mm_cache[ndx];
+  heap->mm_cache[ndx]   = NULL;
+  heap->mm_ncached[ndx] = 0;
+
+  irqrestore(flags);
+  return node;
+}
+
+/****************************************************************************
+ * Name: mm_cachesize
+ *
+ * Description:
+ *   Return the total size of the chunks held in the cache.
+ *
+ ****************************************************************************/
+
+size_t mm_cachesize(FAR struct mm_heap_s *heap)
+{
+  irqstate_t flags;
+  size_t size = 0;
+  int ndx;
+
+  flags = irqsave();
+
+  for (ndx = 0; ndx < MM_CACHE_NLISTS; ndx++)
+    {
+      size += ((size_t)heap->mm_ncached[ndx] * (ndx + 1)) << MM_MIN_SHIFT;
+    }
+
+  irqrestore(flags);
+  return size;
+}
+
+#endif /* CONFIG_MM_CACHE */
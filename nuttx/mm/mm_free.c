@@ -1,7 +1,7 @@
 /****************************************************************************
  * mm/mm_free.c
  *
- *   Copyright (C) 2007, 2009, 2013 Gregory Nutt. All rights reserved.
+ *   Copyright (C) 2007, 2009, 2013-2014 Gregory Nutt. All rights reserved.
  *   Author: Gregory Nutt <gnutt@nuttx.org>
  *
  * Redistribution and use in source and binary forms, with or without
@@ -54,41 +54,23 @@
  ****************************************************************************/
 
 /****************************************************************************
- * Name: mm_free
+ * Name: mm_freechunk
  *
  * Description:
- *   Returns a chunk of memory to the list of free nodes,  merging with
- *   adjacent free chunks if possible.
+ *   Returns an allocated chunk to the list of free nodes,  merging with
+ *   adjacent free chunks if possible.  The caller must hold the MM
+ *   semaphore.
  *
  ****************************************************************************/
 
-#ifndef CONFIG_MM_MULTIHEAP
-static inline
-#endif
-void mm_free(FAR struct mm_heap_s *heap, FAR void *mem)
+static void mm_freechunk(FAR struct mm_heap_s *heap,
+                         FAR struct mm_freenode_s *node)
 {
-  FAR struct mm_freenode_s *node;
   FAR struct mm_freenode_s *prev;
   FAR struct mm_freenode_s *next;
 
-  mvdbg("Freeing %p\n", mem);
-
-  /* Protect against attempts to free a NULL reference */
-
-  if (!mem)
-    {
-      return;
-    }
-
-  /* We need to hold the MM semaphore while we muck with the
-   * nodelist.
-   */
-
-  mm_takesemaphore(heap);
-
-  /* Map the memory chunk into a free node */
+  /* Mark the chunk as free */
 
-  node = (FAR struct mm_freenode_s *)((char*)mem - SIZEOF_MM_ALLOCNODE);
   node->preceding &= ~MM_ALLOC_BIT;
 
   /* Check if the following node is free and, if so, merge it */
@@ -105,16 +87,9 @@ void mm_free(FAR struct mm_heap_s *heap, FAR void *mem)
 
       andbeyond = (FAR struct mm_allocnode_s*)((char*)next + next->size);
 
-      /* Remove the next node.  There must be a predecessor,
-       * but there may not be a successor node.
-       */
+      /* Remove the next node from the nodelist */
 
-      DEBUGASSERT(next->blink);
-      next->blink->flink = next->flink;
-      if (next->flink)
-        {
-          next->flink->blink = next->blink;
-        }
+      mm_remfreechunk(heap, next);
 
       /* Then merge the two chunks */
 
@@ -130,16 +105,9 @@ void mm_free(FAR struct mm_heap_s *heap, FAR void *mem)
   prev = (FAR struct mm_freenode_s *)((char*)node - node->preceding);
   if ((prev->preceding & MM_ALLOC_BIT) == 0)
     {
-      /* Remove the node.  There must be a predecessor, but there may
-       * not be a successor node.
-       */
+      /* Remove the previous node from the nodelist */
 
-      DEBUGASSERT(prev->blink);
-      prev->blink->flink = prev->flink;
-      if (prev->flink)
-        {
-          prev->flink->blink = prev->blink;
-        }
+      mm_remfreechunk(heap, prev);
 
       /* Then merge the two chunks */
 
@@ -151,6 +119,54 @@ void mm_free(FAR struct mm_heap_s *heap, FAR void *mem)
   /* Add the merged node to the nodelist */
 
   mm_addfreechunk(heap, node);
+}
+
+/****************************************************************************
+ * Name: mm_free
+ *
+ * Description:
+ *   Returns a chunk of memory to the list of free nodes,  merging with
+ *   adjacent free chunks if possible.
+ *
+ ****************************************************************************/
+
+#ifndef CONFIG_MM_MULTIHEAP
+static inline
+#endif
+void mm_free(FAR struct mm_heap_s *heap, FAR void *mem)
+{
+  FAR struct mm_freenode_s *node;
+
+  mvdbg("Freeing %p\n", mem);
+
+  /* Protect against attempts to free a NULL reference */
+
+  if (!mem)
+    {
+      return;
+    }
+
+  /* Map the memory chunk into a free node */
+
+  node = (FAR struct mm_freenode_s *)((char*)mem - SIZEOF_MM_ALLOCNODE);
+
+#ifdef CONFIG_MM_CACHE
+  /* Small chunks are held in the cache (if there is space) without
+   * touching the nodelist.
+   */
+
+  if (mm_cachefree(heap, (FAR struct mm_allocnode_s *)node))
+    {
+      return;
+    }
+#endif
+
+  /* We need to hold the MM semaphore while we muck with the
+   * nodelist.
+   */
+
+  mm_takesemaphore(heap);
+  mm_freechunk(heap, node);
   mm_givesemaphore(heap);
 }
 
@@ -158,6 +174,43 @@ void mm_free(FAR struct mm_heap_s *heap, FAR void *mem)
  * Public Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: mm_cacheflush
+ *
+ * Description:
+ *   Return all of the chunks held in the small block cache to the list of
+ *   free nodes.  This is done when an allocation cannot otherwise be
+ *   satisfied so that the cached chunks can be merged with their free
+ *   neighbors.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MM_CACHE
+void mm_cacheflush(FAR struct mm_heap_s *heap)
+{
+  FAR struct mm_freenode_s *node;
+  FAR struct mm_freenode_s *next;
+  int ndx;
+
+  mm_takesemaphore(heap);
+
+  for (ndx = 0; ndx < MM_CACHE_NLISTS; ndx++)
+    {
+      for (node = mm_cacheremove(heap, ndx); node; node = next)
+        {
+          /* Get the next cached chunk before the link is lost in the
+           * merge.
+           */
+
+          next = node->flink;
+          mm_freechunk(heap, node);
+        }
+    }
+
+  mm_givesemaphore(heap);
+}
+#endif
+
 /****************************************************************************
  * Name: free
  *
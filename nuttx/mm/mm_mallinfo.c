@@ -1,7 +1,7 @@
 /****************************************************************************
  * mm/mm_mallinfo.c
  *
- *   Copyright (C) 2007, 2009, 2013 Gregory Nutt. All rights reserved.
+ *   Copyright (C) 2007, 2009, 2013-2014 Gregory Nutt. All rights reserved.
  *   Author: Gregory Nutt <gnutt@nuttx.org>
  *
  * Redistribution and use in source and binary forms, with or without
@@ -75,6 +75,9 @@ int mm_mallinfo(FAR struct mm_heap_s *heap, FAR struct mallinfo *info)
   int    ordblks  = 0;  /* Number of non-inuse chunks */
   size_t uordblks = 0;  /* Total allocated space */
   size_t fordblks = 0;  /* Total non-inuse space */
+#ifdef CONFIG_MM_CACHE
+  size_t cached;        /* Total space held in the cache */
+#endif
 #if CONFIG_MM_REGIONS > 1
   int region;
 #else
@@ -125,6 +128,16 @@ int mm_mallinfo(FAR struct mm_heap_s *heap, FAR struct mallinfo *info)
 
   DEBUGASSERT(uordblks + fordblks == heap->mm_heapsize);
 
+#ifdef CONFIG_MM_CACHE
+  /* Chunks held in the small block cache appear to be allocated in the
+   * heap, but they are available for re-allocation.
+   */
+
+  cached    = mm_cachesize(heap);
+  uordblks -= cached;
+  fordblks += cached;
+#endif
+
   info->arena    = heap->mm_heapsize;
   info->ordblks  = ordblks;
   info->mxordblk = mxordblk;
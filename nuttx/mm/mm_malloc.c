@@ -1,7 +1,7 @@
 /****************************************************************************
  * mm/mm_malloc.c
  *
- *   Copyright (C) 2007, 2009, 2013  Gregory Nutt. All rights reserved.
+ *   Copyright (C) 2007, 2009, 2013-2014  Gregory Nutt. All rights reserved.
  *   Author: Gregory Nutt <gnutt@nuttx.org>
  *
  * Redistribution and use in source and binary forms, with or without
@@ -53,6 +53,17 @@
 #  define NULL ((void*)0)
 #endif
 
+/* If multiple heaps are used, then the heap must be passed as a parameter to
+ * mm_free().  In the single heap case, mm_free() is not available and we
+ * have to use free() (which, internally, will use the same heap).
+ */
+
+#ifdef CONFIG_MM_MULTIHEAP
+#  define MM_FREE(h,m) mm_free(h,m)
+#else
+#  define MM_FREE(h,m) free(m)
+#endif
+
 /****************************************************************************
  * Type Definitions
  ****************************************************************************/
@@ -70,87 +81,41 @@
  ****************************************************************************/
 
 /****************************************************************************
- * Name: mm_malloc
+ * Name: mm_allocchunk
  *
  * Description:
- *  Find the smallest chunk that satisfies the request. Take the memory from
- *  that chunk, save the remaining, smaller chunk (if any).
+ *  Find the smallest free chunk that satisfies the request. Take the memory
+ *  from that chunk, save the remaining, smaller chunk (if any).  The caller
+ *  must hold the MM semaphore.
  *
- *  8-byte alignment of the allocated data is assured.
+ * Input Parameters:
+ *   heap - The heap to allocate from
+ *   size - The chunk size, including the chunk header and aligned to the
+ *          granule size.
+ *
+ * Returned Value:
+ *   The address of the user memory in the allocated chunk; NULL if there
+ *   is no free chunk large enough.
  *
  ****************************************************************************/
 
-#ifndef CONFIG_MM_MULTIHEAP
-static inline
-#endif
-FAR void *mm_malloc(FAR struct mm_heap_s *heap, size_t size)
+static FAR void *mm_allocchunk(FAR struct mm_heap_s *heap, size_t size)
 {
   FAR struct mm_freenode_s *node;
   void *ret = NULL;
-  int ndx;
 
-  /* Handle bad sizes */
-
-  if (size <= 0)
-    {
-      return NULL;
-    }
-
-  /* Adjust the size to account for (1) the size of the allocated node and
-   * (2) to make sure that it is an even multiple of our granule size.
-   */
-
-  size = MM_ALIGN_UP(size + SIZEOF_MM_ALLOCNODE);
-
-  /* We need to hold the MM semaphore while we muck with the nodelist. */
-
-  mm_takesemaphore(heap);
-
-  /* Get the location in the node list to start the search. Special case
-   * really big allocations
-   */
-
-  if (size >= MM_MAX_CHUNK)
-    {
-      ndx = MM_NNODES-1;
-    }
-  else
-    {
-      /* Convert the request size into a nodelist index */
-
-      ndx = mm_size2ndx(size);
-    }
-
-  /* Search for a large enough chunk in the list of nodes. This list is
-   * ordered by size, but will have occasional zero sized nodes as we visit
-   * other mm_nodelist[] entries.
-   */
-
-  for (node = heap->mm_nodelist[ndx].flink;
-       node && node->size < size;
-       node = node->flink);
-
-  /* If we found a node with non-zero size, then this is one to use. Since
-   * the list is ordered, we know that is must be best fitting chunk
-   * available.
-   */
+  /* Search for a large enough free chunk */
 
+  node = mm_findfreechunk(heap, size);
   if (node)
     {
       FAR struct mm_freenode_s *remainder;
       FAR struct mm_freenode_s *next;
       size_t remaining;
 
-      /* Remove the node.  There must be a predecessor, but there may not be
-       * a successor node.
-       */
+      /* Remove the node from the nodelist */
 
-      DEBUGASSERT(node->blink);
-      node->blink->flink = node->flink;
-      if (node->flink)
-        {
-          node->flink->blink = node->blink;
-        }
+      mm_remfreechunk(heap, node);
 
       /* Check if we have to split the free node into one of the allocated
        * size and another smaller freenode.  In some cases, the remaining
@@ -193,6 +158,104 @@ FAR void *mm_malloc(FAR struct mm_heap_s *heap, size_t size)
       ret = (void*)((char*)node + SIZEOF_MM_ALLOCNODE);
     }
 
+  return ret;
+}
+
+/****************************************************************************
+ * Name: mm_malloc
+ *
+ * Description:
+ *  Find the smallest chunk that satisfies the request. Take the memory from
+ *  that chunk, save the remaining, smaller chunk (if any).
+ *
+ *  8-byte alignment of the allocated data is assured.
+ *
+ ****************************************************************************/
+
+#ifndef CONFIG_MM_MULTIHEAP
+static inline
+#endif
+FAR void *mm_malloc(FAR struct mm_heap_s *heap, size_t size)
+{
+  void *ret;
+#ifdef CONFIG_MM_CACHE
+  FAR struct mm_allocnode_s *node;
+  FAR char *chunk;
+  int i;
+#endif
+
+  /* Handle bad sizes */
+
+  if (size <= 0)
+    {
+      return NULL;
+    }
+
+  /* Adjust the size to account for (1) the size of the allocated node and
+   * (2) to make sure that it is an even multiple of our granule size.
+   */
+
+  size = MM_ALIGN_UP(size + SIZEOF_MM_ALLOCNODE);
+
+#ifdef CONFIG_MM_CACHE
+  /* Small allocations are satisfied from the cache when possible.  This
+   * does not require the MM semaphore.
+   */
+
+  ret = mm_cachealloc(heap, size);
+  if (ret)
+    {
+      mvdbg("Allocated %p, size %d (cached)\n", ret, size);
+      return ret;
+    }
+#endif
+
+  /* We need to hold the MM semaphore while we muck with the nodelist. */
+
+  mm_takesemaphore(heap);
+  ret = mm_allocchunk(heap, size);
+
+#ifdef CONFIG_MM_CACHE
+  if (!ret)
+    {
+      /* Chunks held in the cache may be preventing free chunks from being
+       * merged.  Return them to the heap and try again.
+       */
+
+      mm_cacheflush(heap);
+      ret = mm_allocchunk(heap, size);
+    }
+  else if (MM_CACHEABLE(size))
+    {
+      /* The cache for this size is empty.  Refill it with a batch of
+       * chunks while we hold the semaphore.
+       */
+
+      for (i = 1; i < CONFIG_MM_CACHE_BATCH; i++)
+        {
+          chunk = (FAR char *)mm_allocchunk(heap, size);
+          if (!chunk)
+            {
+              break;
+            }
+
+          /* The chunk may be larger than requested if the remainder of the
+           * free chunk was too small to keep.  Such a chunk cannot be
+           * cached.
+           */
+
+          node = (FAR struct mm_allocnode_s *)(chunk - SIZEOF_MM_ALLOCNODE);
+          if (node->size != size)
+            {
+              MM_FREE(heap, chunk);
+              break;
+            }
+
+          mm_cacheadd(heap, node);
+        }
+    }
+#endif
+
   mm_givesemaphore(heap);
 
   /* If CONFIG_DEBUG_MM is defined, then output the result of the allocation
@@ -0,0 +1,302 @@
+/****************************************************************************
+ * mm/mm_tlsf.c
+ *
+ *   Copyright (C) 2014 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include <nuttx/mm.h>
+
+#ifdef CONFIG_MM_TLSF
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: mm_tlsf_fls and mm_tlsf_ffs
+ *
+ * Description:
+ *   Return the bit number of the most (fls) or least (ffs) significant bit
+ *   that is set in a non-zero word.  These execute in constant time.
+ *
+ ****************************************************************************/
+
+static inline int mm_tlsf_fls(uint32_t word)
+{
+  int bit = 0;
+
+  if ((word & 0xffff0000) != 0)
+    {
+      word >>= 16;
+      bit   += 16;
+    }
+
+  if ((word & 0x0000ff00) != 0)
+    {
+      word >>= 8;
+      bit   += 8;
+    }
+
+  if ((word & 0x000000f0) != 0)
+    {
+      word >>= 4;
+      bit   += 4;
+    }
+
+  if ((word & 0x0000000c) != 0)
+    {
+      word >>= 2;
+      bit   += 2;
+    }
+
+  if ((word & 0x00000002) != 0)
+    {
+      bit += 1;
+    }
+
+  return bit;
+}
+
+static inline int mm_tlsf_ffs(uint32_t word)
+{
+  return mm_tlsf_fls(word & (~word + 1));
+}
+
+/****************************************************************************
+ * Name: mm_tlsf_mapping
+ *
+ * Description:
+ *   Convert a chunk size into first and second level list indices.
+ *
+ ****************************************************************************/
+
+static inline void mm_tlsf_mapping(size_t size, FAR int *fl, FAR int *sl)
+{
+  int msb;
+
+  if (size < (1 << MM_TLSF_FLSHIFT))
+    {
+      /* Small chunks:  One list per granule in the first level zero */
+
+      *fl = 0;
+      *sl = (int)(size >> MM_MIN_SHIFT);
+    }
+  else
+    {
+      /* The first level is given by the most significant bit; the second
+       * level by the next MM_TLSF_SLSHIFT bits.
+       */
+
+      msb = mm_tlsf_fls((uint32_t)size);
+      *fl = msb - MM_TLSF_FLSHIFT + 1;
+      *sl = (int)(size >> (msb - MM_TLSF_SLSHIFT)) - MM_TLSF_SLCOUNT;
+    }
+
+  DEBUGASSERT(*fl < MM_TLSF_FLCOUNT && *sl < MM_TLSF_SLCOUNT);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: mm_tlsfinitialize
+ *
+ * Description:
+ *   Initialize the (empty) TLSF free lists of a heap.
+ *
+ ****************************************************************************/
+
+void mm_tlsfinitialize(FAR struct mm_heap_s *heap)
+{
+  heap->mm_flbitmap = 0;
+  memset(heap->mm_slbitmap, 0, sizeof(heap->mm_slbitmap));
+  memset(heap->mm_freelist, 0, sizeof(heap->mm_freelist));
+}
+
+/****************************************************************************
+ * Name: mm_addfreechunk
+ *
+ * Description:
+ *   Add a free chunk to the head of the free list for its size class.  It
+ *   is assumed that the caller holds the mm semaphore
+ *
+ ****************************************************************************/
+
+void mm_addfreechunk(FAR struct mm_heap_s *heap,
+                     FAR struct mm_freenode_s *node)
+{
+  FAR struct mm_freenode_s *next;
+  int fl;
+  int sl;
+
+  mm_tlsf_mapping(node->size, &fl, &sl);
+
+  next        = heap->mm_freelist[fl][sl];
+  node->blink = NULL;
+  node->flink = next;
+
+  if (next)
+    {
+      next->blink = node;
+    }
+
+  heap->mm_freelist[fl][sl] = node;
+  heap->mm_slbitmap[fl]    |= (uint32_t)1 << sl;
+  heap->mm_flbitmap        |= (uint32_t)1 << fl;
+}
+
+/****************************************************************************
+ * Name: mm_remfreechunk
+ *
+ * Description:
+ *   Remove a free chunk from the free list for its size class.  It is
+ *   assumed that the caller holds the mm semaphore
+ *
+ ****************************************************************************/
+
+void mm_remfreechunk(FAR struct mm_heap_s *heap,
+                     FAR struct mm_freenode_s *node)
+{
+  int fl;
+  int sl;
+
+  mm_tlsf_mapping(node->size, &fl, &sl);
+
+  if (node->blink)
+    {
+      node->blink->flink = node->flink;
+    }
+  else
+    {
+      DEBUGASSERT(heap->mm_freelist[fl][sl] == node);
+      heap->mm_freelist[fl][sl] = node->flink;
+    }
+
+  if (node->flink)
+    {
+      node->flink->blink = node->blink;
+    }
+
+  /* Clear the bitmap bits if the list is now empty */
+
+  if (!heap->mm_freelist[fl][sl])
+    {
+      heap->mm_slbitmap[fl] &= ~((uint32_t)1 << sl);
+      if (heap->mm_slbitmap[fl] == 0)
+        {
+          heap->mm_flbitmap &= ~((uint32_t)1 << fl);
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: mm_findfreechunk
+ *
+ * Description:
+ *   Find a free chunk that is at least 'size' bytes in size.  The chunk is
+ *   not removed from the free list.  It is assumed that the caller holds
+ *   the mm semaphore
+ *
+ *   The request is rounded up to the next size class so that any chunk in
+ *   the first non-empty list found is large enough.  Finding that list
+ *   requires only a few bitmap operations so the search time does not
+ *   depend on the number of free chunks.  As usual for TLSF, a chunk in
+ *   the same size class as the request that happens to be large enough is
+ *   not found.
+ *
+ ****************************************************************************/
+
+FAR struct mm_freenode_s *mm_findfreechunk(FAR struct mm_heap_s *heap,
+                                           size_t size)
+{
+  uint32_t map;
+  size_t rounded;
+  int fl;
+  int sl;
+
+  /* Round the size up to the next size class */
+
+  rounded = size;
+  if (size >= (1 << MM_TLSF_FLSHIFT))
+    {
+      rounded += ((size_t)1 << (mm_tlsf_fls((uint32_t)size) -
+                                MM_TLSF_SLSHIFT)) - 1;
+    }
+
+  if (rounded < ((size_t)1 << (MM_TLSF_FLMAX + 1)))
+    {
+      mm_tlsf_mapping(rounded, &fl, &sl);
+
+      /* Look for a non-empty list in this first level at or above the
+       * second level index.
+       */
+
+      map = heap->mm_slbitmap[fl] & (~(uint32_t)0 << sl);
+      if (map == 0)
+        {
+          /* None.. look for a non-empty first level above this one */
+
+          map = heap->mm_flbitmap & (~(uint32_t)0 << (fl + 1));
+          if (map != 0)
+            {
+              fl  = mm_tlsf_ffs(map);
+              map = heap->mm_slbitmap[fl];
+            }
+        }
+
+      if (map != 0)
+        {
+          sl = mm_tlsf_ffs(map);
+          return heap->mm_freelist[fl][sl];
+        }
+    }
+
+  return NULL;
+}
+
+#endif /* CONFIG_MM_TLSF */
@@ -0,0 +1,161 @@
+/****************************************************************************
+ * net/iob/iob_alloc.c
+ *
+ *   Copyright (C) 2014 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <semaphore.h>
+#include <errno.h>
+#include <assert.h>
+
+#include <arch/irq.h>
+#include <nuttx/net/uip/uip.h>
+#include <nuttx/net/iob.h>
+
+#include "iob.h"
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: iob_takefirst
+ *
+ * Description:
+ *   Remove the I/O buffer at the head of the free list and prepare it for
+ *   use.  The caller has already accounted for the buffer in g_iob_sem so
+ *   the free list cannot be empty.
+ *
+ ****************************************************************************/
+
+static FAR struct iob_s *iob_takefirst(void)
+{
+  FAR struct iob_s *iob;
+  irqstate_t flags;
+
+  flags = irqsave();
+  iob = g_iob_freelist;
+  DEBUGASSERT(iob != NULL);
+  g_iob_freelist = iob->io_flink;
+  irqrestore(flags);
+
+  iob->io_flink  = NULL;
+  iob->io_len    = 0;
+  iob->io_offset = 0;
+  iob->io_pktlen = 0;
+  return iob;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: iob_alloc
+ *
+ * Description:
+ *   Allocate an I/O buffer by taking the buffer at the head of the free
+ *   list.  This function will wait until a buffer becomes available and so
+ *   may not be called from interrupt handlers.  If the caller holds the
+ *   uIP lock, the lock is released while waiting (see uip_lockedwait()) so
+ *   that the network can free buffers in the meantime.
+ *
+ ****************************************************************************/
+
+FAR struct iob_s *iob_alloc(void)
+{
+  int ret;
+
+  /* The semaphore count is the number of free buffers.  Wait until we can
+   * reserve one of them.  Never wait while holding the uIP lock:  With
+   * CONFIG_NET_NOINTS, the network could then never free a buffer.
+   */
+
+  do
+    {
+      ret = uip_lockedwait(&g_iob_sem);
+
+      /* The only case that an error should occur here is if the wait was
+       * awakened by a signal.
+       */
+
+      DEBUGASSERT(ret == OK || get_errno() == EINTR);
+    }
+  while (ret < 0);
+
+  return iob_takefirst();
+}
+
+/****************************************************************************
+ * Name: iob_tryalloc
+ *
+ * Description:
+ *   Try to allocate an I/O buffer by taking the buffer at the head of the
+ *   free list.  NULL is returned immediately if there is no free buffer.
+ *   If 'throttled' is true, NULL is also returned when taking the buffer
+ *   would leave fewer than CONFIG_IOB_THROTTLE buffers in the pool.  This
+ *   function may be called from interrupt handlers.
+ *
+ ****************************************************************************/
+
+FAR struct iob_s *iob_tryalloc(bool throttled)
+{
+  irqstate_t flags;
+  int16_t reserve = throttled ? CONFIG_IOB_THROTTLE : 0;
+  bool avail = false;
+
+  /* Reserve a buffer by decrementing the semaphore count directly.  This
+   * cannot block and is safe from interrupt handlers.  A positive count
+   * means that there are no waiters and at least one free buffer.
+   * Throttled (read-ahead) allocations may not take the last
+   * CONFIG_IOB_THROTTLE buffers.
+   */
+
+  flags = irqsave();
+  if (g_iob_sem.semcount > reserve)
+    {
+      g_iob_sem.semcount--;
+      avail = true;
+    }
+
+  irqrestore(flags);
+  return avail ? iob_takefirst() : NULL;
+}
@@ -0,0 +1,178 @@
+/****************************************************************************
+ * net/iob/iob_copyin.c
+ *
+ *   Copyright (C) 2014 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+
+#include <nuttx/net/iob.h>
+
+#include "iob.h"
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: iob_copyin
+ *
+ * Description:
+ *  Copy data 'len' bytes from a user buffer into the I/O buffer chain,
+ *  starting at 'offset', extending the chain as necessary.  If 'can_block'
+ *  is true, buffers are taken with iob_alloc() and the caller may block.
+ *  Otherwise they are taken with iob_tryalloc(true), as is appropriate for
+ *  read-ahead buffering, and -ENOMEM is returned if none is available.
+ *
+ * Returned Value:
+ *   The number of bytes copied on success; a negated errno value on
+ *   failure.  On failure, any data that was copied remains in the chain.
+ *
+ ****************************************************************************/
+
+int iob_copyin(FAR struct iob_s *iob, FAR const uint8_t *src,
+               unsigned int len, unsigned int offset, bool can_block)
+{
+  FAR struct iob_s *head = iob;
+  FAR struct iob_s *next;
+  FAR uint8_t *dest;
+  unsigned int pktend = offset + len;
+  unsigned int maxlen;
+  unsigned int avail;
+  unsigned int ncopy;
+  unsigned int total = 0;
+
+  DEBUGASSERT(iob != NULL && src != NULL);
+
+  if (offset > iob->io_pktlen)
+    {
+      /* Would leave a hole in the packet */
+
+      return -ESPIPE;
+    }
+
+  /* Skip to the I/O buffer containing the data offset */
+
+  while (offset > iob->io_len)
+    {
+      offset -= iob->io_len;
+      iob     = iob->io_flink;
+      DEBUGASSERT(iob != NULL);
+    }
+
+  /* Then loop until all of the I/O data is copied from the user buffer */
+
+  while (len > 0)
+    {
+      /* Get the destination I/O buffer address and the amount of data
+       * available from that address.
+       */
+
+      dest  = &iob->io_data[iob->io_offset + offset];
+      avail = iob->io_len - offset;
+
+      /* Will the rest of the copy fit into this buffer, overwriting
+       * existing data?
+       */
+
+      if (len <= avail)
+        {
+          ncopy = len;
+        }
+
+      /* No.. Is this the last buffer in the chain? */
+
+      else if (iob->io_flink)
+        {
+          /* No.. overwrite what is there and move to the next buffer */
+
+          ncopy = avail;
+        }
+      else
+        {
+          /* Yes.. extend this buffer to its end */
+
+          maxlen = CONFIG_IOB_BUFSIZE - iob->io_offset - offset;
+          ncopy  = len < maxlen ? len : maxlen;
+          iob->io_len = offset + ncopy;
+        }
+
+      /* Copy from the user buffer to the I/O buffer */
+
+      memcpy(dest, src, ncopy);
+
+      total += ncopy;
+      src   += ncopy;
+      len   -= ncopy;
+
+      /* Do we need to extend the chain? */
+
+      if (len > 0 && !iob->io_flink)
+        {
+          next = can_block ? iob_alloc() : iob_tryalloc(true);
+          if (!next)
+            {
+              if (head->io_pktlen < pktend - len)
+                {
+                  head->io_pktlen = pktend - len;
+                }
+
+              return -ENOMEM;
+            }
+
+          iob->io_flink = next;
+        }
+
+      iob    = iob->io_flink;
+      offset = 0;
+    }
+
+  /* Update the packet length if the copy extended the packet */
+
+  if (head->io_pktlen < pktend)
+    {
+      head->io_pktlen = pktend;
+    }
+
+  return total;
+}
@@ -0,0 +1,105 @@
+/****************************************************************************
+ * net/iob/iob_qentry.c
+ *
+ *   Copyright (C) 2014 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stddef.h>
+#include <assert.h>
+
+#include <arch/irq.h>
+#include <nuttx/net/iob.h>
+
+#include "iob.h"
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: iob_alloc_qentry
+ *
+ * Description:
+ *   Allocate an I/O buffer chain container by taking the buffer at the head
+ *   of the free list.  NULL is returned if there is no free container.
+ *
+ ****************************************************************************/
+
+FAR struct iob_qentry_s *iob_alloc_qentry(void)
+{
+  FAR struct iob_qentry_s *iobq;
+  irqstate_t flags;
+
+  flags = irqsave();
+  iobq  = g_iob_freeqlist;
+  if (iobq)
+    {
+      g_iob_freeqlist = iobq->qe_flink;
+      iobq->qe_flink  = NULL;
+      iobq->qe_head   = NULL;
+    }
+
+  irqrestore(flags);
+  return iobq;
+}
+
+/****************************************************************************
+ * Name: iob_free_qentry
+ *
+ * Description:
+ *   Free the I/O buffer chain container by returning it to the free list.
+ *   The link to the next container is returned.
+ *
+ ****************************************************************************/
+
+FAR struct iob_qentry_s *iob_free_qentry(FAR struct iob_qentry_s *iobq)
+{
+  FAR struct iob_qentry_s *next;
+  irqstate_t flags;
+
+  DEBUGASSERT(iobq != NULL);
+
+  next  = iobq->qe_flink;
+  flags = irqsave();
+  iobq->qe_flink  = g_iob_freeqlist;
+  g_iob_freeqlist = iobq;
+  irqrestore(flags);
+
+  return next;
+}
@@ -0,0 +1,96 @@
+/****************************************************************************
+ * net/iob/iob_trimhead_queue.c
+ *
+ *   Copyright (C) 2014 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stddef.h>
+#include <assert.h>
+
+#include <nuttx/net/iob.h>
+
+#include "iob.h"
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: iob_trimhead_queue
+ *
+ * Description:
+ *   Remove bytes from the beginning of the I/O buffer chain at the head of
+ *   a queue.  The chain is removed from the queue and freed when it becomes
+ *   empty.
+ *
+ * Assumptions:
+ *   The caller holds the lock that protects the queue (normally uip_lock).
+ *
+ ****************************************************************************/
+
+void iob_trimhead_queue(FAR struct iob_queue_s *qhead, unsigned int trimlen)
+{
+  FAR struct iob_qentry_s *qentry;
+  FAR struct iob_s *iob;
+
+  DEBUGASSERT(qhead != NULL);
+
+  qentry = qhead->qh_head;
+  if (qentry && trimlen > 0)
+    {
+      /* Trim the I/O buffer chain at the head of the queue */
+
+      iob = iob_trimhead(qentry->qe_head, trimlen);
+      if (iob)
+        {
+          /* Some data remains.  The head of the chain may have changed. */
+
+          qentry->qe_head = iob;
+        }
+      else
+        {
+          /* The chain was emptied and freed.  Remove its container from
+           * the queue.
+           */
+
+          qentry->qe_head = NULL;
+          (void)iob_remove_queue(qhead);
+        }
+    }
+}
@@ -58,6 +58,7 @@
 #include <nuttx/clock.h>
 #include <nuttx/net/uip/uip-arp.h>
 #include <nuttx/net/uip/uip-arch.h>
+#include <nuttx/net/iob.h>
 
 #ifdef CONFIG_NET_ARP_IPIN
 #  include <nuttx/net/uip/uip-arp.h>
@@ -176,7 +177,7 @@ static uint16_t send_interrupt(FAR struct uip_driver_s *dev, FAR void *pvconn,
           if (segment->wb_seqno < ackno)
             {
               nllvdbg("ACK: acked=%d buflen=%d ackno=%d\n",
-                      segment->wb_seqno, segment->wb_nbytes, ackno);
+                      segment->wb_seqno, WRB_PKTLEN(segment), ackno);
 
               /* Segment was ACKed. Remove from ACK waiting queue */
 
@@ -217,7 +218,7 @@ static uint16_t send_interrupt(FAR struct uip_driver_s *dev, FAR void *pvconn,
 
           if (segment->wb_nrtx >= UIP_MAXRTX)
             {
-              //conn->unacked -= segment->wb_nbytes;
+              //conn->unacked -= WRB_PKTLEN(segment);
 
               /* Return the write buffer */
 
@@ -279,7 +280,6 @@ static uint16_t send_interrupt(FAR struct uip_driver_s *dev, FAR void *pvconn,
 #endif
         {
           FAR struct uip_wrbuffer_s *segment;
-          FAR void *sndbuf;
           size_t sndlen;
 
           /* Get the amount of data that we can send in the next packet */
@@ -287,8 +287,7 @@ static uint16_t send_interrupt(FAR struct uip_driver_s *dev, FAR void *pvconn,
           segment = (FAR struct uip_wrbuffer_s *)sq_remfirst(&conn->write_q);
           if (segment)
             {
-              sndbuf = segment->wb_buffer;
-              sndlen = segment->wb_nbytes;
+              sndlen = WRB_PKTLEN(segment);
 
               DEBUGASSERT(sndlen <= uip_mss(conn));
 
@@ -311,11 +310,12 @@ static uint16_t send_interrupt(FAR struct uip_driver_s *dev, FAR void *pvconn,
 
               uip_tcpsetsequence(conn->sndseq, segment->wb_seqno);
 
-              /* Then set-up to send that amount of data. (this won't
-               * actually happen until the polling cycle completes).
+              /* Then set-up to send that amount of data from the I/O
+               * buffer chain. (this won't actually happen until the
+               * polling cycle completes).
                */
 
-              uip_send(dev, sndbuf, sndlen);
+              uip_iobsend(dev, segment->wb_iob, sndlen, 0);
 
               /* Remember how much data we send out now so that we know
                * when everything has been acknowledged.  Just increment
@@ -498,8 +498,22 @@ ssize_t psock_send(FAR struct socket *psock, FAR const void *buf, size_t len,
                   cnt = len - completed;
                 }
 
-              segment->wb_nbytes = cnt;
-              memcpy(segment->wb_buffer, (char*)buf + completed, cnt);
+              /* Copy the user data into the I/O buffer chain.  Only as
+               * many I/O buffers as are needed to hold the data are used.
+               * This may block waiting for free I/O buffers.  The uIP lock
+               * is released while waiting so that the network can free
+               * buffers.
+               */
+
+              ret = iob_copyin(segment->wb_iob,
+                               (FAR const uint8_t *)buf + completed,
+                               cnt, 0, true);
+              if (ret < 0)
+                {
+                  uip_tcpwrbuffer_release(segment);
+                  break;
+                }
+
               completed += cnt;
 
               /* send_interrupt() will refer to all the write buffer by
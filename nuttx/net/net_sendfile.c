@@ -58,6 +58,7 @@
 #include <arch/irq.h>
 #include <nuttx/clock.h>
 #include <nuttx/fs/fs.h>
+#include <nuttx/fs/ioctl.h>
 #include <nuttx/net/uip/uip-arp.h>
 #include <nuttx/net/uip/uip-arch.h>
 
@@ -88,6 +89,9 @@ struct sendfile_s
   FAR struct uip_callback_s *snd_datacb;  /* Data callback */
   FAR struct uip_callback_s *snd_ackcb;   /* ACK callback */
   FAR struct file           *snd_file;    /* File structure of the input file */
+#ifdef CONFIG_NET_ZEROCOPY
+  FAR const uint8_t         *snd_xipbase; /* File data mapped in memory (or NULL) */
+#endif
   sem_t                      snd_sem;     /* Used to wake up the waiting thread */
   off_t                      snd_foffset; /* Input file offset */
   size_t                     snd_flen;    /* File length */
@@ -274,61 +278,101 @@ static uint16_t sendfile_interrupt(FAR struct uip_driver_s *dev, FAR void *pvcon
            * happen until the polling cycle completes).
            */
 
-          ret = file_seek(pstate->snd_file,
-                          pstate->snd_foffset + pstate->snd_sent, SEEK_SET);
-          if (ret < 0)
+#ifdef CONFIG_NET_ZEROCOPY
+          if (pstate->snd_xipbase != NULL)
             {
-              int errcode = errno;
-              nlldbg("failed to lseek: %d\n", errcode);
-              pstate->snd_sent = -errcode;
-              goto end_wait;
-            }
+              /* The file is mapped in memory.  Send the data directly from
+               * there; there is no need to read it.
+               */
 
-          ret = file_read(pstate->snd_file, dev->d_snddata, sndlen);
-          if (ret < 0)
+              uip_extsend(dev, pstate->snd_xipbase + pstate->snd_foffset +
+                          pstate->snd_sent, sndlen);
+            }
+          else
+#endif
             {
-              int errcode = errno;
-              nlldbg("failed to read from input file: %d\n", errcode);
-              pstate->snd_sent = -errcode;
-              goto end_wait;
+              off_t pos = pstate->snd_foffset + pstate->snd_sent;
+
+              /* The file position is usually already correct unless data
+               * is being retransmitted.
+               */
+
+              if (pstate->snd_file->f_pos != pos)
+                {
+                  ret = file_seek(pstate->snd_file, pos, SEEK_SET);
+                  if (ret < 0)
+                    {
+                      int errcode = errno;
+                      nlldbg("failed to lseek: %d\n", errcode);
+                      pstate->snd_sent = -errcode;
+                      goto end_wait;
+                    }
+                }
+
+              ret = file_read(pstate->snd_file, dev->d_snddata, sndlen);
+              if (ret < 0)
+                {
+                  int errcode = errno;
+                  nlldbg("failed to read from input file: %d\n", errcode);
+                  pstate->snd_sent = -errcode;
+                  goto end_wait;
+                }
+
+              /* The file may have been truncated after the transfer was
+               * started.  Send only what was actually read.
+               */
+
+              sndlen = ret;
+              if (sndlen == 0)
+                {
+                  pstate->snd_flen = pstate->snd_sent;
+                }
+
+              dev->d_sndlen = sndlen;
             }
 
-          dev->d_sndlen = sndlen;
-
-          /* Set the sequence number for this packet.  NOTE:  uIP updates
-           * sndseq on recept of ACK *before* this function is called.  In that
-           * case sndseq will point to the next unacknowledge byte (which might
-           * have already been sent).  We will overwrite the value of sndseq
-           * here before the packet is sent.
-           */
-
-          seqno = pstate->snd_sent + pstate->snd_isn;
-          nllvdbg("SEND: sndseq %08x->%08x len: %d\n", conn->sndseq, seqno, ret);
-
-          uip_tcpsetsequence(conn->sndseq, seqno);
-
-          /* Check if the destination IP address is in the ARP table.  If not,
-           * then the send won't actually make it out... it will be replaced with
-           * an ARP request.
-           *
-           * NOTE 1: This could be an expensive check if there are a lot of entries
-           * in the ARP table.  Hence, we only check on the first packet -- when
-           * snd_sent is zero.
-           *
-           * NOTE 2: If we are actually harvesting IP addresses on incomming IP
-           * packets, then this check should not be necessary; the MAC mapping
-           * should already be in the ARP table.
-           */
+          if (sndlen > 0)
+            {
+              /* Set the sequence number for this packet.  NOTE:  uIP updates
+               * sndseq on recept of ACK *before* this function is called.  In
+               * that case sndseq will point to the next unacknowledge byte
+               * (which might have already been sent).  We will overwrite the
+               * value of sndseq here before the packet is sent.
+               */
+
+              seqno = pstate->snd_sent + pstate->snd_isn;
+              nllvdbg("SEND: sndseq %08x->%08x len: %d\n",
+                      conn->sndseq, seqno, sndlen);
+
+              uip_tcpsetsequence(conn->sndseq, seqno);
+
+              /* Check if the destination IP address is in the ARP table.  If
+               * not, then the send won't actually make it out... it will be
+               * replaced with an ARP request.
+               *
+               * NOTE 1: This could be an expensive check if there are a lot
+               * of entries in the ARP table.  Hence, we only check on the
+               * first packet -- when snd_sent is zero.
+               *
+               * NOTE 2: If we are actually harvesting IP addresses on
+               * incomming IP packets, then this check should not be
+               * necessary; the MAC mapping should already be in the ARP
+               * table.
+               */
 
 #if defined(CONFIG_NET_ETHERNET) && !defined (CONFIG_NET_ARP_IPIN)
-          if (pstate->snd_sent != 0 || uip_arp_find(conn->ripaddr) != NULL)
+              if (pstate->snd_sent != 0 || uip_arp_find(conn->ripaddr) != NULL)
 #endif
-            {
-              /* Update the amount of data sent (but not necessarily ACKed) */
-
-              pstate->snd_sent += sndlen;
-              nllvdbg("pid: %d SEND: acked=%d sent=%d flen=%d\n", getpid(),
-                     pstate->snd_acked, pstate->snd_sent, pstate->snd_flen);
+                {
+                  /* Update the amount of data sent (but not necessarily
+                   * ACKed)
+                   */
+
+                  pstate->snd_sent += sndlen;
+                  nllvdbg("pid: %d SEND: acked=%d sent=%d flen=%d\n",
+                          getpid(), pstate->snd_acked, pstate->snd_sent,
+                          pstate->snd_flen);
+                }
             }
         }
       else
@@ -452,7 +496,10 @@ ssize_t net_sendfile(int outfd, struct file *infile, off_t *offset,
   FAR struct uip_conn *conn = (FAR struct uip_conn*)psock->s_conn;
   struct sendfile_s state;
   uip_lock_t save;
-  int err;
+  off_t curpos;
+  off_t startpos;
+  off_t endpos;
+  int err = OK;
 
   /* Verify that the sockfd corresponds to valid, allocated socket */
 
@@ -470,6 +517,53 @@ ssize_t net_sendfile(int outfd, struct file *infile, off_t *offset,
       goto errout;
     }
 
+  /* Find where to start and do not try to send beyond the end of the
+   * file.
+   */
+
+  curpos   = infile->f_pos;
+  startpos = offset ? *offset : curpos;
+  endpos   = file_seek(infile, 0, SEEK_END);
+  if (endpos != (off_t)ERROR)
+    {
+      if (startpos >= endpos)
+        {
+          count = 0;
+        }
+      else if (count > endpos - startpos)
+        {
+          count = endpos - startpos;
+        }
+    }
+
+  (void)file_seek(infile, startpos, SEEK_SET);
+
+  memset(&state, 0, sizeof(struct sendfile_s));
+  if (count == 0)
+    {
+      goto errout_seek;
+    }
+
+#ifdef CONFIG_NET_ZEROCOPY
+  /* If the file system can map the file into memory (ROMFS on XIP media,
+   * for example), then the data can be sent from there without reading it.
+   */
+
+  if (infile->f_inode && infile->f_inode->u.i_ops &&
+      infile->f_inode->u.i_ops->ioctl)
+    {
+      FAR void *addr;
+      int ret;
+
+      ret = infile->f_inode->u.i_ops->ioctl(infile, FIOC_MMAP,
+                                            (unsigned long)((uintptr_t)&addr));
+      if (ret == OK)
+        {
+          state.snd_xipbase = (FAR const uint8_t *)addr;
+        }
+    }
+#endif
+
   /* Set the socket state to sending */
 
   psock->s_flags = _SS_SETSTATE(psock->s_flags, _SF_SEND);
@@ -481,10 +575,9 @@ ssize_t net_sendfile(int outfd, struct file *infile, off_t *offset,
 
   save  = uip_lock();
 
-  memset(&state, 0, sizeof(struct sendfile_s));
   sem_init(&state. snd_sem, 0, 0);          /* Doesn't really fail */
   state.snd_sock    = psock;                /* Socket descriptor to use */
-  state.snd_foffset = offset ? *offset : 0; /* Input file offset */
+  state.snd_foffset = startpos;             /* Input file offset */
   state.snd_flen    = count;                /* Number of bytes to send */
   state.snd_file    = infile;               /* File to read from */
 
@@ -560,6 +653,28 @@ ssize_t net_sendfile(int outfd, struct file *infile, off_t *offset,
   sem_destroy(&state. snd_sem);
   uip_unlock(save);
 
+ errout_seek:
+
+  /* If an offset was provided, it is updated and the file position is left
+   * unchanged.  Otherwise, the file position is advanced past the data that
+   * was sent.
+   */
+
+  if (state.snd_sent > 0)
+    {
+      startpos += state.snd_sent;
+    }
+
+  if (offset)
+    {
+      *offset = startpos;
+      (void)file_seek(infile, curpos, SEEK_SET);
+    }
+  else
+    {
+      (void)file_seek(infile, startpos, SEEK_SET);
+    }
+
  errout:
 
   if (err)
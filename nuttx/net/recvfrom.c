@@ -44,13 +44,16 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <stdint.h>
+#include <stdbool.h>
 #include <string.h>
 #include <errno.h>
+#include <assert.h>
 #include <debug.h>
 
 #include <arch/irq.h>
 #include <nuttx/clock.h>
 #include <nuttx/net/uip/uip-arch.h>
+#include <nuttx/net/iob.h>
 
 #include "net_internal.h"
 #include "uip/uip_internal.h"
@@ -266,71 +269,102 @@ static inline void recvfrom_newudpdata(FAR struct uip_driver_s *dev,
 #if defined(CONFIG_NET_TCP) && defined(CONFIG_NET_TCP_READAHEAD)
 static inline void recvfrom_readahead(struct recvfrom_s *pstate)
 {
-  FAR struct uip_conn        *conn = (FAR struct uip_conn *)pstate->rf_sock->s_conn;
-  FAR struct uip_readahead_s *readahead;
-  size_t                      recvlen;
+  FAR struct uip_conn *conn = (FAR struct uip_conn *)pstate->rf_sock->s_conn;
+  FAR struct iob_s    *iob;
+  int                  recvlen;
 
   /* Check there is any TCP data already buffered in a read-ahead
    * buffer.
    */
 
-  do
+  while ((iob = iob_peek_queue(&conn->readahead)) != NULL &&
+         pstate->rf_buflen > 0)
     {
-      /* Get the read-ahead buffer at the head of the list (if any) */
+      DEBUGASSERT(iob->io_pktlen > 0);
 
-      readahead = (struct uip_readahead_s *)sq_remfirst(&conn->readahead);
-      if (readahead)
-        {
-          /* We have a new buffer... transfer that buffered data into
-           * the user buffer.
-           *
-           * First, get the length of the data to transfer.
-           */
+      /* Transfer that buffered data from the I/O buffer chain into
+       * the user buffer.
+       */
 
-          if (readahead->rh_nbytes > pstate->rf_buflen)
-            {
-              recvlen = pstate->rf_buflen;
-            }
-          else
-            {
-              recvlen = readahead->rh_nbytes;
-            }
+      recvlen = iob_copyout((FAR uint8_t *)pstate->rf_buffer, iob,
+                            pstate->rf_buflen, 0);
+      nllvdbg("Received %d bytes (of %d)\n", recvlen, iob->io_pktlen);
 
-          if (recvlen > 0)
-            {
-              /* Copy the read-ahead data into the user buffer */
+      /* Update the accumulated size of the data read */
 
-              memcpy(pstate->rf_buffer, readahead->rh_buffer, recvlen);
-              nllvdbg("Received %d bytes (of %d)\n", recvlen, readahead->rh_nbytes);
+      pstate->rf_recvlen += recvlen;
+      pstate->rf_buffer  += recvlen;
+      pstate->rf_buflen  -= recvlen;
 
-              /* Update the accumulated size of the data read */
+      /* Remove the I/O buffer chain from the head of the read-ahead
+       * buffer queue.  Emptied I/O buffers are freed; if data remains,
+       * it stays at the head of the queue without being moved.
+       */
 
-              pstate->rf_recvlen += recvlen;
-              pstate->rf_buffer  += recvlen;
-              pstate->rf_buflen  -= recvlen;
-            }
+      iob_trimhead_queue(&conn->readahead, recvlen);
+    }
+}
+#endif /* CONFIG_NET_TCP && CONFIG_NET_TCP_READAHEAD */
 
-          /* If the read-ahead buffer is empty, then release it.  If not, then
-           * we will have to move the data down and return the buffer to the
-           * front of the list.
-           */
+/****************************************************************************
+ * Function: recvfrom_udpreadahead
+ *
+ * Description:
+ *   Copy the oldest buffered UDP datagram, if any, into the user buffer.
+ *   As with any UDP receive, data that does not fit into the user buffer
+ *   is discarded.
+ *
+ * Parameters:
+ *   pstate   recvfrom state structure
+ *
+ * Returned Value:
+ *   true if a buffered datagram was received.
+ *
+ * Assumptions:
+ *   Running with the network locked.
+ *
+ ****************************************************************************/
 
-          if (recvlen < readahead->rh_nbytes)
-            {
-              readahead->rh_nbytes -= recvlen;
-              memcpy(readahead->rh_buffer, &readahead->rh_buffer[recvlen],
-                     readahead->rh_nbytes);
-              sq_addfirst(&readahead->rh_node, &conn->readahead);
-            }
-          else
-            {
-              uip_tcpreadahead_release(readahead);
-            }
-        }
+#if defined(CONFIG_NET_UDP) && defined(CONFIG_NET_UDP_READAHEAD)
+static inline bool recvfrom_udpreadahead(struct recvfrom_s *pstate)
+{
+  FAR struct uip_udp_conn *conn = (FAR struct uip_udp_conn *)pstate->rf_sock->s_conn;
+  FAR struct iob_s        *iob;
+  int                      recvlen;
+
+  /* Remove the oldest datagram from the read-ahead queue */
+
+  iob = iob_remove_queue(&conn->readahead);
+  if (!iob)
+    {
+      return false;
     }
-  while (readahead && pstate->rf_buflen > 0);
+
+  /* The chain begins with the sender's address */
+
+  if (pstate->rf_from)
+    {
+      (void)iob_copyout((FAR uint8_t *)pstate->rf_from, iob,
+                        sizeof(*pstate->rf_from), 0);
+    }
+
+  /* Followed by the payload of the datagram */
+
+  recvlen = iob_copyout((FAR uint8_t *)pstate->rf_buffer, iob,
+                        pstate->rf_buflen, sizeof(*pstate->rf_from));
+  nllvdbg("Received %d bytes (of %d)\n",
+          recvlen, iob->io_pktlen - (int)sizeof(*pstate->rf_from));
+
+  pstate->rf_recvlen += recvlen;
+  pstate->rf_buffer  += recvlen;
+  pstate->rf_buflen  -= recvlen;
+
+  /* Free the whole datagram */
+
+  iob_free_chain(iob);
+  return true;
 }
-#endif /* CONFIG_NET_UDP || CONFIG_NET_TCP */
+#endif /* CONFIG_NET_UDP && CONFIG_NET_UDP_READAHEAD */
 
 /****************************************************************************
  * Function: recvfrom_timeout
@@ -934,6 +968,16 @@ static ssize_t udp_recvfrom(FAR struct socket *psock, FAR void *buf, size_t len,
   save = uip_lock();
   recvfrom_init(psock, buf, len, infrom, &state);
 
+#ifdef CONFIG_NET_UDP_READAHEAD
+  /* Return a datagram that was buffered before we got here, if any */
+
+  if (recvfrom_udpreadahead(&state))
+    {
+      ret = state.rf_recvlen;
+      goto errout_with_state;
+    }
+#endif
+
   /* Setup the UDP remote connection */
 
   ret = uip_udpconnect(conn, NULL);
@@ -67,6 +67,8 @@
 #include <nuttx/net/uip/uip-arch.h>
 #include <nuttx/net/uip/uip-arp.h>
 
+#include "uip_internal.h"
+
 #ifdef CONFIG_NET_ARP
 
 /****************************************************************************
@@ -234,6 +236,7 @@ void uip_arp_arpin(struct uip_driver_s *dev)
   struct arp_hdr_s *parp = ARPBUF;
   in_addr_t ipaddr;
 
+  uip_extreset(dev);
   if (dev->d_len < (sizeof(struct arp_hdr_s) + UIP_LLH_LEN))
     {
       nlldbg("Too small\n");
@@ -423,6 +426,7 @@ void uip_arp_out(struct uip_driver_s *dev)
 
           peth->type        = HTONS(UIP_ETHTYPE_ARP);
           dev->d_len        = sizeof(struct arp_hdr_s) + UIP_LLH_LEN;
+          uip_extreset(dev);
           return;
         }
 
@@ -126,7 +126,23 @@ static uint16_t upper_layer_chksum(struct uip_driver_s *dev, uint8_t proto)
 
   /* Sum TCP header and data. */
 
-  sum = chksum(sum, &dev->d_buf[UIP_IPH_LEN + UIP_LLH_LEN], upper_layer_len);
+#ifdef CONFIG_NET_ZEROCOPY
+  if (dev->d_extlen > 0)
+    {
+      /* The payload is not in d_buf.  The part in d_buf (the TCP header)
+       * always has an even length so the two sums may simply be chained.
+       */
+
+      sum = chksum(sum, &dev->d_buf[UIP_IPH_LEN + UIP_LLH_LEN],
+                   upper_layer_len - dev->d_extlen);
+      sum = chksum(sum, dev->d_extdata, dev->d_extlen);
+    }
+  else
+#endif
+    {
+      sum = chksum(sum, &dev->d_buf[UIP_IPH_LEN + UIP_LLH_LEN],
+                   upper_layer_len);
+    }
 
   return (sum == 0) ? 0xffff : htons(sum);
 }
@@ -0,0 +1,95 @@
+/****************************************************************************
+ * net/uip/uip_extsend.c
+ *
+ *   Copyright (C) 2014 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+#if defined(CONFIG_NET) && defined(CONFIG_NET_ZEROCOPY)
+
+#include <string.h>
+#include <debug.h>
+
+#include <nuttx/net/uip/uip.h>
+#include <nuttx/net/uip/uip-arch.h>
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: uip_extsend
+ *
+ * Description:
+ *   Called from TCP socket logic in response to a xmit or poll request from
+ *   the network interface driver.  This is identical to uip_send() except
+ *   that, if the driver can transmit the payload of a packet from separate
+ *   memory, the data is left in place and only referenced.  The data must
+ *   then remain unchanged until it is acknowledged.
+ *
+ * Assumptions:
+ *   Called from the interrupt level or, at a mimimum, with interrupts
+ *   disabled.
+ *
+ ****************************************************************************/
+
+void uip_extsend(FAR struct uip_driver_s *dev, FAR const void *buf, int len)
+{
+  /* Some sanity checks -- note that the actually available length in the
+   * buffer is considerably less than CONFIG_NET_BUFSIZE.
+   */
+
+  if (dev && len > 0 && len < CONFIG_NET_BUFSIZE)
+    {
+      if (dev->d_zerocopy)
+        {
+          /* Just remember where the data is.  uip_tcprexmit() will attach
+           * it to the outgoing packet.
+           */
+
+          dev->d_extdata = (FAR const uint8_t *)buf;
+        }
+      else
+        {
+          memcpy(dev->d_snddata, buf, len);
+        }
+
+      dev->d_sndlen = len;
+    }
+}
+
+#endif /* CONFIG_NET && CONFIG_NET_ZEROCOPY */
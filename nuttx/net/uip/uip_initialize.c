@@ -46,6 +46,7 @@
 
 #include <stdint.h>
 #include <nuttx/net/uip/uip.h>
+#include <nuttx/net/iob.h>
 
 #include "uip_internal.h"
 
@@ -123,6 +124,14 @@ void uip_initialize(void)
 
   uip_callbackinit();
 
+  /* Initialize the network I/O buffer pool.  This is shared by the TCP
+   * read-ahead and write buffering and by UDP read-ahead buffering.
+   */
+
+#ifdef CONFIG_NET_IOB
+  iob_initialize();
+#endif
+
   /* Initialize the listening port structures */
 
 #ifdef CONFIG_NET_TCP
@@ -131,12 +140,6 @@ void uip_initialize(void)
   /* Initialize the TCP/IP connection structures */
 
   uip_tcpinit();
-
-  /* Initialize the TCP/IP read-ahead buffering */
-
-#ifdef CONFIG_NET_TCP_READAHEAD
-  uip_tcpreadahead_init();
-#endif
 #endif /* CONFIG_NET_TCP */
 
   /* Initialize the TCP/IP write buffering */
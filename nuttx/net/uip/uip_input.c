@@ -307,7 +307,11 @@ int uip_input(struct uip_driver_s *dev)
   struct uip_ip_hdr *pbuf = BUF;
   uint16_t iplen;
 
-  /* This is where the input processing starts. */
+  /* This is where the input processing starts.  Any response will be built
+   * entirely in d_buf until a TCP callback provides zero-copy data.
+   */
+
+  uip_extreset(dev);
 
 #ifdef CONFIG_NET_STATISTICS
   uip_stat.ip.recv++;
@@ -0,0 +1,175 @@
+/****************************************************************************
+ * net/uip/uip_inputq.c
+ *
+ *   Copyright (C) 2014 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+#if defined(CONFIG_NET) && defined(CONFIG_NET_PKTQUEUE)
+
+#include <stdint.h>
+#include <debug.h>
+
+#include <arpa/inet.h>
+
+#include <nuttx/net/uip/uipopt.h>
+#include <nuttx/net/uip/uip.h>
+#include <nuttx/net/uip/uip-arch.h>
+#include <nuttx/net/uip/uip-arp.h>
+
+#include "uip_internal.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define ETHBUF ((FAR struct uip_eth_hdr *)dev->d_buf)
+
+#ifdef CONFIG_NET_IPv6
+#  define UIP_ETHTYPE_THISIP UIP_ETHTYPE_IP6
+#else
+#  define UIP_ETHTYPE_THISIP UIP_ETHTYPE_IP
+#endif
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Function: uip_input1
+ *
+ * Description:
+ *   Perform the link-level dispatch of the single frame in d_buf.
+ *
+ * Returned Value:
+ *   true if a response for the link-level was left in d_buf.
+ *
+ ****************************************************************************/
+
+static inline bool uip_input1(FAR struct uip_driver_s *dev)
+{
+#ifdef CONFIG_NET_ETHERNET
+  if (dev->d_len <= UIP_LLH_LEN)
+    {
+      return false;
+    }
+
+  if (ETHBUF->type == HTONS(UIP_ETHTYPE_THISIP))
+    {
+      uip_arp_ipin(dev);
+      uip_input(dev);
+
+      /* Add the Ethernet header to any IP response */
+
+      if (dev->d_len > 0)
+        {
+          uip_arp_out(dev);
+          return true;
+        }
+    }
+  else if (ETHBUF->type == HTONS(UIP_ETHTYPE_ARP))
+    {
+      /* Any ARP response is complete as it is */
+
+      uip_arp_arpin(dev);
+      return dev->d_len > 0;
+    }
+
+  return false;
+#else
+  uip_input(dev);
+  return dev->d_len > 0;
+#endif
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Function: uip_inputq
+ *
+ * Description:
+ *   Process a batch of frames taken from a driver's receive queue.  Each
+ *   frame is processed in place:  d_buf is pointed at the driver's buffer
+ *   for the duration of its processing and any response is passed to the
+ *   driver's txqueue() function.  See include/nuttx/net/uip/uip-arch.h.
+ *
+ * Parameters:
+ *   dev     - The network device that received the frames.
+ *   rxq     - An array of frame descriptors.
+ *   nrx     - The number of frames in rxq.
+ *   txqueue - The driver function that will queue any response in d_buf.
+ *
+ * Returned Value:
+ *   The number of frames processed.
+ *
+ * Assumptions:
+ *   Called from the same context as uip_input().
+ *
+ ****************************************************************************/
+
+int uip_inputq(FAR struct uip_driver_s *dev, FAR struct uip_pktdesc_s *rxq,
+               int nrx, uip_txqueue_t txqueue)
+{
+  FAR uint8_t *savebuf = dev->d_buf;
+  int i;
+
+  for (i = 0; i < nrx; i++)
+    {
+      /* Process the frame in the driver's receive buffer */
+
+      dev->d_buf = rxq[i].pd_buf;
+      dev->d_len = rxq[i].pd_len;
+
+      if (uip_input1(dev))
+        {
+          /* Let the driver queue the response.  The driver may switch d_buf
+           * to a new transmit buffer here; that does not matter because
+           * d_buf is set again for the next frame.
+           */
+
+          (void)txqueue(dev);
+        }
+    }
+
+  dev->d_buf = savebuf;
+  dev->d_len = 0;
+  return nrx;
+}
+
+#endif /* CONFIG_NET && CONFIG_NET_PKTQUEUE */
@@ -56,6 +56,22 @@
  * Public Macro Definitions
  ****************************************************************************/
 
+/* Forget any zero-copy payload left over from a previous packet.  This must
+ * be done each time that uIP starts to build a new packet in d_buf.
+ */
+
+#ifdef CONFIG_NET_ZEROCOPY
+#  define uip_extreset(dev) \
+  do \
+    { \
+      (dev)->d_extdata = NULL; \
+      (dev)->d_extlen  = 0; \
+    } \
+  while (0)
+#else
+#  define uip_extreset(dev)
+#endif
+
 /****************************************************************************
  * Public Type Definitions
  ****************************************************************************/
@@ -161,16 +177,6 @@ uint16_t uip_datahandler(FAR struct uip_conn *conn,
                          FAR uint8_t *buffer, uint16_t nbytes);
 #endif
 
-/* Defined in uip_tcpreadahead.c ********************************************/
-
-#ifdef CONFIG_NET_TCP_READAHEAD
-void uip_tcpreadahead_init(void);
-
-struct uip_readahead_s;
-FAR struct uip_readahead_s *uip_tcpreadahead_alloc(void);
-void uip_tcpreadahead_release(FAR struct uip_readahead_s *readahead);
-#endif /* CONFIG_NET_TCP_READAHEAD */
-
 /* Defined in uip_tcpwrbuffer.c *********************************************/
 
 #ifdef CONFIG_NET_TCP_WRITE_BUFFERS
@@ -73,6 +73,7 @@ static inline int uip_pollicmp(struct uip_driver_s *dev, uip_poll_callback_t cal
 {
   /* Perform the UDP TX poll */
 
+  uip_extreset(dev);
   uip_icmppoll(dev);
 
   /* Call back into the driver */
@@ -98,6 +99,7 @@ static inline int uip_polligmp(struct uip_driver_s *dev, uip_poll_callback_t cal
 {
   /* Perform the UDP TX poll */
 
+  uip_extreset(dev);
   uip_igmppoll(dev);
 
   /* Call back into the driver */
@@ -131,6 +133,7 @@ static int uip_polludpconnections(struct uip_driver_s *dev,
     {
       /* Perform the UDP TX poll */
 
+      uip_extreset(dev);
       uip_udppoll(dev, udp_conn);
 
       /* Call back into the driver */
@@ -167,6 +170,7 @@ static inline int uip_polltcpconnections(struct uip_driver_s *dev,
     {
       /* Perform the TCP TX poll */
 
+      uip_extreset(dev);
       uip_tcppoll(dev, conn);
 
       /* Call back into the driver */
@@ -206,6 +210,7 @@ static inline int uip_polltcptimer(struct uip_driver_s *dev,
     {
       /* Perform the TCP timer poll */
 
+      uip_extreset(dev);
       uip_tcptimer(dev, conn, hsec);
 
       /* Call back into the driver */
@@ -199,6 +199,15 @@ void uip_tcprexmit(struct uip_driver_s *dev, struct uip_conn *conn,
   if (dev->d_sndlen > 0 && conn->unacked > 0)
 #endif
     {
+#ifdef CONFIG_NET_ZEROCOPY
+      /* If the data was provided by uip_extsend(), then the payload of the
+       * packet is not in d_buf.  It will be checksummed and transmitted
+       * from d_extdata.
+       */
+
+      dev->d_extlen = dev->d_extdata ? dev->d_sndlen : 0;
+#endif
+
       /* We always set the ACK flag in response packets adding the length of
        * the IP and TCP headers.
        */
@@ -210,6 +219,7 @@ void uip_tcprexmit(struct uip_driver_s *dev, struct uip_conn *conn,
 
   else if ((result & UIP_SNDACK) != 0)
     {
+      uip_extreset(dev);
       uip_tcpsend(dev, conn, TCP_ACK, UIP_TCPIP_HLEN);
     }
 
@@ -217,6 +227,7 @@ void uip_tcprexmit(struct uip_driver_s *dev, struct uip_conn *conn,
 
   else
     {
+      uip_extreset(dev);
       dev->d_len = 0;
     }
 }
@@ -42,9 +42,9 @@
 #if defined(CONFIG_NET) && defined(CONFIG_NET_TCP)
 
 #include <stdint.h>
-#include <string.h>
 #include <debug.h>
 
+#include <nuttx/net/iob.h>
 #include <nuttx/net/uip/uipopt.h>
 #include <nuttx/net/uip/uip.h>
 #include <nuttx/net/uip/uip-arch.h>
@@ -59,46 +59,6 @@
  * Private Functions
  ****************************************************************************/
 
-/****************************************************************************
- * Function: uip_readahead
- *
- * Description:
- *   Copy as much received data as possible into the readahead buffer
- *
- * Assumptions:
- *   This function is called at the interrupt level with interrupts disabled.
- *
- ****************************************************************************/
-
-#ifdef CONFIG_NET_TCP_READAHEAD
-static int uip_readahead(struct uip_readahead_s *readahead, uint8_t *buf,
-                         int len)
-{
-  int available = CONFIG_NET_TCP_READAHEAD_BUFSIZE - readahead->rh_nbytes;
-  int recvlen   = 0;
-
-  if (len > 0 && available > 0)
-    {
-      /* Get the length of the data to buffer. */
-
-      if (len > available)
-        {
-          recvlen = available;
-        }
-      else
-        {
-          recvlen = len;
-        }
-
-      /* Copy the new appdata into the read-ahead buffer */
-
-      memcpy(&readahead->rh_buffer[readahead->rh_nbytes], buf, recvlen);
-      readahead->rh_nbytes += recvlen;
-    }
-  return recvlen;
-}
-#endif
-
 /****************************************************************************
  * Function: uip_dataevent
  *
@@ -140,14 +100,12 @@ uip_dataevent(FAR struct uip_driver_s *dev, FAR struct uip_conn *conn,
       nllvdbg("No listener on connection\n");
 
 #ifdef CONFIG_NET_TCP_READAHEAD
-      /* Save as much data as possible in the read-ahead buffers */
+      /* Save the data in the read-ahead buffers */
 
       recvlen = uip_datahandler(conn, buffer, buflen);
 
-      /* There are several complicated buffering issues that are not addressed
-       * properly here.  For example, what if we cannot buffer the entire
-       * packet?  In that case, some data will be accepted but not ACKed.
-       * Therefore it will be resent and duplicated.  Fixing this could be tricky.
+      /* The packet is buffered all or nothing.  If it cannot be buffered,
+       * then it is not ACKed and the peer will retransmit it.
        */
 
      if (recvlen < buflen)
@@ -266,8 +224,9 @@ uint16_t uip_tcpcallback(struct uip_driver_s *dev, struct uip_conn *conn,
  *   buflen - The number of bytes to copy to the read-ahead buffer.
  *
  * Returned value:
- *   The number of bytes actually buffered.  This could be less than 'nbytes'
- *   if there is insufficient buffering available.
+ *   The number of bytes actually buffered.  The data is buffered all or
+ *   nothing so this is either 'buflen' or zero if there is insufficient
+ *   buffering available.
  *
  * Assumptions:
  * - The caller has checked that UIP_NEWDATA is set in flags and that is no
@@ -280,57 +239,52 @@ uint16_t uip_tcpcallback(struct uip_driver_s *dev, struct uip_conn *conn,
 uint16_t uip_datahandler(FAR struct uip_conn *conn, FAR uint8_t *buffer,
                          uint16_t buflen)
 {
-  FAR struct uip_readahead_s *readahead1;
-  FAR struct uip_readahead_s *readahead2 = NULL;
-  uint16_t remaining;
-  uint16_t recvlen = 0;
-
-  /* First, we need to determine if we have space to buffer the data.  This
-   * needs to be verified before we actually begin buffering the data. We
-   * will use any remaining space in the last allocated readahead buffer
-   * plus as much one additional buffer.  It is expected that the size of
-   * readahead buffers are tuned so that one full packet will always fit
-   * into one readahead buffer (for example if the buffer size is 420, then
-   * a readahead buffer of 366 will hold a full packet of TCP data).
+  FAR struct iob_s *iob;
+  int ret;
+
+  /* Allocate an I/O buffer to start the chain.  This must not block and
+   * must not use the buffers held back for write buffering.
    */
 
-  readahead1 = (FAR struct uip_readahead_s*)conn->readahead.tail;
-  if ((readahead1 &&
-      (CONFIG_NET_TCP_READAHEAD_BUFSIZE - readahead1->rh_nbytes) > buflen) ||
-      (readahead2 = uip_tcpreadahead_alloc()) != NULL)
+  iob = iob_tryalloc(true);
+  if (iob == NULL)
     {
-      /* We have buffer space.  Now try to append add as much data as possible
-       * to the last readahead buffer attached to this connection.
-       */
+      nlldbg("ERROR: Failed to create new I/O buffer chain\n");
+      return 0;
+    }
 
-      remaining = buflen;
-      if (readahead1)
-        {
-          recvlen = uip_readahead(readahead1, buffer, remaining);
-          if (recvlen > 0)
-            {
-              buffer    += recvlen;
-              remaining -= recvlen;
-            }
-        }
+  /* Copy the new appdata into the I/O buffer chain.  The chain is extended
+   * with as many buffers as are needed to hold the data; a short segment
+   * consumes only one buffer.
+   */
 
-      /* Do we need to buffer into the newly allocated buffer as well? */
+  ret = iob_copyin(iob, buffer, buflen, 0, false);
+  if (ret < 0)
+    {
+      /* On a failure, iob_copyin() will return a negated error value but
+       * does not free any I/O buffers.  Buffer all or nothing so that any
+       * unbuffered data is not ACKed and will be retransmitted.
+       */
 
-      if (readahead2)
-        {
-          readahead2->rh_nbytes = 0;
-          recvlen += uip_readahead(readahead2, buffer, remaining);
+      nlldbg("ERROR: Failed to add data to the I/O buffer chain: %d\n", ret);
+      iob_free_chain(iob);
+      return 0;
+    }
 
-          /* Save the readahead buffer in the connection structure where
-           * it can be found with recv() is called.
-           */
+  /* Add the new I/O buffer chain to the tail of the read-ahead queue by
+   * reference.
+   */
 
-          sq_addlast(&readahead2->rh_node, &conn->readahead);
-        }
+  ret = iob_add_queue(iob, &conn->readahead);
+  if (ret < 0)
+    {
+      nlldbg("ERROR: Failed to queue the I/O buffer chain: %d\n", ret);
+      iob_free_chain(iob);
+      return 0;
     }
 
-  nllvdbg("Buffered %d bytes (of %d)\n", recvlen, buflen);
-  return recvlen;
+  nllvdbg("Buffered %d bytes\n", buflen);
+  return buflen;
 }
 #endif /* CONFIG_NET_TCP_READAHEAD */
 
@@ -57,6 +57,35 @@
 
 #include "uip_internal.h"
 
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_TCP_HASH
+#  ifndef CONFIG_NET_TCP_NHASH
+#    define CONFIG_NET_TCP_NHASH 16
+#  endif
+
+#  if (CONFIG_NET_TCP_NHASH & (CONFIG_NET_TCP_NHASH - 1)) != 0
+#    error "CONFIG_NET_TCP_NHASH must be a power of two"
+#  endif
+
+#  define TCP_HASHMASK (CONFIG_NET_TCP_NHASH - 1)
+
+/* With IPv6, only the port numbers contribute to the connection hash */
+
+#  ifdef CONFIG_NET_IPv6
+#    define TCP_HASHADDR(a) 0
+#  else
+#    define TCP_HASHADDR(a) (a)
+#  endif
+#else
+#  define uip_tcphashadd(c)
+#  define uip_tcphashrem(c)
+#  define uip_tcpportadd(c)
+#  define uip_tcpportrem(c)
+#endif
+
 /****************************************************************************
  * Public Data
  ****************************************************************************/
@@ -77,6 +106,18 @@ static dq_queue_t g_free_tcp_connections;
 
 static dq_queue_t g_active_tcp_connections;
 
+#ifdef CONFIG_NET_TCP_HASH
+/* The active TCP connections hashed by local port, remote port, and remote
+ * IP address.
+ */
+
+static FAR struct uip_conn *g_tcp_hash[CONFIG_NET_TCP_NHASH];
+
+/* All TCP connections with an assigned local port, hashed by that port */
+
+static FAR struct uip_conn *g_tcp_porthash[CONFIG_NET_TCP_NHASH];
+#endif
+
 /* Last port used by a TCP connection connection. */
 
 static uint16_t g_last_tcp_port;
@@ -85,6 +126,129 @@ static uint16_t g_last_tcp_port;
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: uip_tcphash() and uip_tcpporthash()
+ *
+ * Description:
+ *   Return the hash table index of a connection given its local port,
+ *   remote port, and remote IP address; or given only its local port.  All
+ *   values are in network order.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_TCP_HASH
+static inline unsigned int uip_tcphash(uint16_t lport, uint16_t rport,
+                                       in_addr_t ripaddr)
+{
+  uint32_t hash = (uint32_t)ripaddr ^ ((uint32_t)lport << 16 | rport);
+
+  hash ^= hash >> 16;
+  hash ^= hash >> 8;
+  return hash & TCP_HASHMASK;
+}
+
+static inline unsigned int uip_tcpporthash(uint16_t portno)
+{
+  return (portno ^ (portno >> 8)) & TCP_HASHMASK;
+}
+#endif
+
+/****************************************************************************
+ * Name: uip_tcphashadd() and uip_tcphashrem()
+ *
+ * Description:
+ *   Add an active connection to or remove it from the connection hash
+ *   table.
+ *
+ * Assumptions:
+ *   Interrupts are disabled
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_TCP_HASH
+static void uip_tcphashadd(FAR struct uip_conn *conn)
+{
+  unsigned int ndx = uip_tcphash(conn->lport, conn->rport,
+                                 TCP_HASHADDR(conn->ripaddr));
+
+  conn->hlink     = g_tcp_hash[ndx];
+  g_tcp_hash[ndx] = conn;
+}
+
+static void uip_tcphashrem(FAR struct uip_conn *conn)
+{
+  FAR struct uip_conn *prev;
+  FAR struct uip_conn *curr;
+  unsigned int ndx = uip_tcphash(conn->lport, conn->rport,
+                                 TCP_HASHADDR(conn->ripaddr));
+
+  for (prev = NULL, curr = g_tcp_hash[ndx];
+       curr && curr != conn;
+       prev = curr, curr = curr->hlink);
+
+  DEBUGASSERT(curr);
+  if (prev)
+    {
+      prev->hlink = conn->hlink;
+    }
+  else
+    {
+      g_tcp_hash[ndx] = conn->hlink;
+    }
+}
+#endif
+
+/****************************************************************************
+ * Name: uip_tcpportadd() and uip_tcpportrem()
+ *
+ * Description:
+ *   Add a connection to or remove it from the local port hash table.  A
+ *   connection is in the table if and only if it has a non-zero local port.
+ *
+ * Assumptions:
+ *   Interrupts are disabled
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_TCP_HASH
+static void uip_tcpportadd(FAR struct uip_conn *conn)
+{
+  unsigned int ndx;
+
+  if (conn->lport != 0)
+    {
+      ndx                 = uip_tcpporthash(conn->lport);
+      conn->plink         = g_tcp_porthash[ndx];
+      g_tcp_porthash[ndx] = conn;
+    }
+}
+
+static void uip_tcpportrem(FAR struct uip_conn *conn)
+{
+  FAR struct uip_conn *prev;
+  FAR struct uip_conn *curr;
+  unsigned int ndx;
+
+  if (conn->lport != 0)
+    {
+      ndx = uip_tcpporthash(conn->lport);
+      for (prev = NULL, curr = g_tcp_porthash[ndx];
+           curr && curr != conn;
+           prev = curr, curr = curr->plink);
+
+      DEBUGASSERT(curr);
+      if (prev)
+        {
+          prev->plink = conn->plink;
+        }
+      else
+        {
+          g_tcp_porthash[ndx] = conn->plink;
+        }
+    }
+}
+#endif
+
 /****************************************************************************
  * Name: uip_selectport()
  *
@@ -305,9 +469,6 @@ void uip_tcpfree(struct uip_conn *conn)
 {
   FAR struct uip_callback_s *cb;
   FAR struct uip_callback_s *next;
-#ifdef CONFIG_NET_TCP_READAHEAD
-  FAR struct uip_readahead_s *readahead;
-#endif
 #ifdef CONFIG_NET_TCP_WRITE_BUFFERS
   FAR struct uip_wrbuffer_s *wrbuffer;
 #endif
@@ -340,15 +501,17 @@ void uip_tcpfree(struct uip_conn *conn)
       /* Remove the connection from the active list */
 
       dq_rem(&conn->node, &g_active_tcp_connections);
+      uip_tcphashrem(conn);
     }
 
+  /* Release the local port number */
+
+  uip_tcpportrem(conn);
+
 #ifdef CONFIG_NET_TCP_READAHEAD
   /* Release any read-ahead buffers attached to the connection */
 
-  while ((readahead = (struct uip_readahead_s *)sq_remfirst(&conn->readahead)) != NULL)
-    {
-      uip_tcpreadahead_release(readahead);
-    }
+  iob_free_queue(&conn->readahead);
 #endif
 
 #ifdef CONFIG_NET_TCP_WRITE_BUFFERS
@@ -404,8 +567,14 @@ void uip_tcpfree(struct uip_conn *conn)
 
 struct uip_conn *uip_tcpactive(struct uip_tcpip_hdr *buf)
 {
-  struct uip_conn *conn      = (struct uip_conn *)g_active_tcp_connections.head;
   in_addr_t        srcipaddr = uip_ip4addr_conv(buf->srcipaddr);
+#ifdef CONFIG_NET_TCP_HASH
+  struct uip_conn *conn      = g_tcp_hash[uip_tcphash(buf->destport,
+                                                      buf->srcport,
+                                                      TCP_HASHADDR(srcipaddr))];
+#else
+  struct uip_conn *conn      = (struct uip_conn *)g_active_tcp_connections.head;
+#endif
 
   while (conn)
     {
@@ -422,9 +591,13 @@ struct uip_conn *uip_tcpactive(struct uip_tcpip_hdr *buf)
           break;
         }
 
-      /* Look at the next active connection */
+      /* Look at the next active connection (with the same hash) */
 
+#ifdef CONFIG_NET_TCP_HASH
+      conn = conn->hlink;
+#else
       conn = (struct uip_conn *)conn->node.flink;
+#endif
     }
 
   return conn;
@@ -469,6 +642,24 @@ struct uip_conn *uip_nexttcpconn(struct uip_conn *conn)
 struct uip_conn *uip_tcplistener(uint16_t portno)
 {
   struct uip_conn *conn;
+#ifdef CONFIG_NET_TCP_HASH
+
+  /* Check if this port number is in use by any connection with the same
+   * local port hash.
+   */
+
+  for (conn = g_tcp_porthash[uip_tcpporthash(portno)];
+       conn;
+       conn = conn->plink)
+    {
+      if (conn->tcpstateflags != UIP_CLOSED && conn->lport == portno)
+        {
+          /* The portnumber is in use, return the connection */
+
+          return conn;
+        }
+    }
+#else
   int i;
 
   /* Check if this port number is in use by any active UIP TCP connection */
@@ -483,6 +674,7 @@ struct uip_conn *uip_tcplistener(uint16_t portno)
           return conn;
         }
     }
+#endif
 
   return NULL;
 }
@@ -533,7 +725,7 @@ struct uip_conn *uip_tcpaccept(struct uip_tcpip_hdr *buf)
 #ifdef CONFIG_NET_TCP_READAHEAD
       /* Initialize the list of TCP read-ahead buffers */
 
-      sq_init(&conn->readahead);
+      IOB_QINIT(&conn->readahead);
 #endif
 
 #ifdef CONFIG_NET_TCP_WRITE_BUFFERS
@@ -548,6 +740,8 @@ struct uip_conn *uip_tcpaccept(struct uip_tcpip_hdr *buf)
        */
 
       dq_addlast(&conn->node, &g_active_tcp_connections);
+      uip_tcphashadd(conn);
+      uip_tcpportadd(conn);
     }
 
   return conn;
@@ -581,10 +775,9 @@ int uip_tcpbind(struct uip_conn *conn, const struct sockaddr_in *addr)
 
   flags = uip_lock();
   port = uip_selectport(ntohs(addr->sin_port));
-  uip_unlock(flags);
-
   if (port < 0)
     {
+      uip_unlock(flags);
       return port;
     }
 
@@ -593,7 +786,10 @@ int uip_tcpbind(struct uip_conn *conn, const struct sockaddr_in *addr)
    * interface is supported, the IP address is not of importance.
    */
 
+  uip_tcpportrem(conn);
   conn->lport = addr->sin_port;
+  uip_tcpportadd(conn);
+  uip_unlock(flags);
 
 #if 0 /* Not used */
 #ifdef CONFIG_NET_IPv6
@@ -651,6 +847,14 @@ int uip_tcpconnect(struct uip_conn *conn, const struct sockaddr_in *addr)
 
   flags = uip_lock();
   port = uip_selectport(ntohs(conn->lport));
+  if (port >= 0 && conn->lport == 0)
+    {
+      /* Bind the connection to the selected port number */
+
+      conn->lport = htons((uint16_t)port);
+      uip_tcpportadd(conn);
+    }
+
   uip_unlock(flags);
 
   if (port < 0)
@@ -670,7 +874,6 @@ int uip_tcpconnect(struct uip_conn *conn, const struct sockaddr_in *addr)
   conn->rto        = UIP_RTO;
   conn->sa         = 0;
   conn->sv         = 16;   /* Initial value of the RTT variance. */
-  conn->lport      = htons((uint16_t)port);
 #ifdef CONFIG_NET_TCP_WRITE_BUFFERS
   conn->expired    = 0;
   conn->isn        = 0;
@@ -688,7 +891,7 @@ int uip_tcpconnect(struct uip_conn *conn, const struct sockaddr_in *addr)
 #ifdef CONFIG_NET_TCP_READAHEAD
   /* Initialize the list of TCP read-ahead buffers */
 
-  sq_init(&conn->readahead);
+  IOB_QINIT(&conn->readahead);
 #endif
 
 #ifdef CONFIG_NET_TCP_WRITE_BUFFERS
@@ -706,6 +909,7 @@ int uip_tcpconnect(struct uip_conn *conn, const struct sockaddr_in *addr)
 
   flags = uip_lock();
   dq_addlast(&conn->node, &g_active_tcp_connections);
+  uip_tcphashadd(conn);
   uip_unlock(flags);
 
   return OK;
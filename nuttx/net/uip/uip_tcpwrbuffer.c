@@ -43,8 +43,11 @@
 
 #include <queue.h>
 #include <semaphore.h>
+#include <assert.h>
 #include <debug.h>
 
+#include <nuttx/net/iob.h>
+
 #include "uip_internal.h"
 
 /****************************************************************************
@@ -63,7 +66,9 @@ struct wrbuffer_s
 
   sq_queue_t freebuffers;
 
-  /* These are the pre-allocated write buffers */
+  /* These are the pre-allocated write buffer descriptors.  The data itself
+   * is held in I/O buffer chains taken from the common I/O buffer pool.
+   */
 
   struct uip_wrbuffer_s buffers[CONFIG_NET_NTCP_WRITE_BUFFERS];
 };
@@ -114,8 +119,9 @@ void uip_tcpwrbuffer_init(void)
  *
  * Description:
  *   Allocate a TCP write buffer by taking a pre-allocated buffer from
- *   the free list.  This function is called from TCP logic when a buffer
- *   of TCP data is about to sent
+ *   the free list and attaching the first I/O buffer of its data chain.
+ *   This function is called from TCP logic when a buffer of TCP data is
+ *   about to sent
  *
  * Assumptions:
  *   Called from user logic with interrupts enabled.
@@ -124,6 +130,7 @@ void uip_tcpwrbuffer_init(void)
 
 FAR struct uip_wrbuffer_s *uip_tcpwrbuffer_alloc(FAR const struct timespec *abstime)
 {
+  FAR struct uip_wrbuffer_s *wrbuffer;
   int ret;
 
   if (abstime)
@@ -132,7 +139,11 @@ FAR struct uip_wrbuffer_s *uip_tcpwrbuffer_alloc(FAR const struct timespec *abst
     }
   else
     {
-      ret = sem_wait(&g_wrbuffer.sem);
+      /* Release the uIP lock while waiting:  Write buffers are freed by
+       * the network when data is ACKed.
+       */
+
+      ret = uip_lockedwait(&g_wrbuffer.sem);
     }
 
   if (ret != 0)
@@ -140,16 +151,24 @@ FAR struct uip_wrbuffer_s *uip_tcpwrbuffer_alloc(FAR const struct timespec *abst
       return NULL;
     }
 
-  return (FAR struct uip_wrbuffer_s*)sq_remfirst(&g_wrbuffer.freebuffers);
+  wrbuffer = (FAR struct uip_wrbuffer_s*)sq_remfirst(&g_wrbuffer.freebuffers);
+  DEBUGASSERT(wrbuffer != NULL);
+
+  /* Now get the first I/O buffer for the write buffer structure.  This
+   * may block (without the uIP lock) until an I/O buffer is freed.
+   */
+
+  wrbuffer->wb_iob = iob_alloc();
+  return wrbuffer;
 }
 
 /****************************************************************************
  * Function: uip_tcpwrbuffer_release
  *
  * Description:
- *   Release a TCP write buffer by returning the buffer to the free list.
- *   This function is called from user logic after it is consumed the buffered
- *   data.
+ *   Release a TCP write buffer by returning the buffer to the free list
+ *   and its I/O buffer chain to the I/O buffer pool.  This function is
+ *   called from user logic after it is consumed the buffered data.
  *
  * Assumptions:
  *   Called from interrupt level with interrupts disabled.
@@ -158,6 +177,15 @@ FAR struct uip_wrbuffer_s *uip_tcpwrbuffer_alloc(FAR const struct timespec *abst
 
 void uip_tcpwrbuffer_release(FAR struct uip_wrbuffer_s *wrbuffer)
 {
+  DEBUGASSERT(wrbuffer && wrbuffer->wb_iob);
+
+  /* Free the I/O buffer chain holding the segment data */
+
+  iob_free_chain(wrbuffer->wb_iob);
+  wrbuffer->wb_iob = NULL;
+
+  /* Then return the write buffer to the free list */
+
   sq_addlast(&wrbuffer->wb_node, &g_wrbuffer.freebuffers);
   sem_post(&g_wrbuffer.sem);
 }
@@ -41,14 +41,28 @@
 #if defined(CONFIG_NET) && defined(CONFIG_NET_UDP)
 
 #include <stdint.h>
+#include <string.h>
+#include <errno.h>
 #include <debug.h>
 
+#ifdef CONFIG_NET_UDP_READAHEAD
+#  include <sys/socket.h>
+#  include <netinet/in.h>
+#  include <nuttx/net/iob.h>
+#endif
+
 #include <nuttx/net/uip/uipopt.h>
 #include <nuttx/net/uip/uip.h>
 #include <nuttx/net/uip/uip-arch.h>
 
 #include "uip_internal.h"
 
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define UDPBUF ((struct uip_udpip_hdr *)&dev->d_buf[UIP_LLH_LEN])
+
 /****************************************************************************
  * Private Data
  ****************************************************************************/
@@ -57,6 +71,85 @@
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Function: uip_udpdatahandler
+ *
+ * Description:
+ *   Retain a UDP datagram that was not accepted by the application in the
+ *   read-ahead queue of the connection.  The datagram is held in one I/O
+ *   buffer chain that begins with the sender's address followed by the
+ *   UDP payload.
+ *
+ * Returned value:
+ *   OK if the datagram was buffered; a negated errno value if there is
+ *   insufficient buffering available.
+ *
+ * Assumptions:
+ *   This function is called at the interrupt level with interrupts disabled.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_UDP_READAHEAD
+static int uip_udpdatahandler(FAR struct uip_driver_s *dev,
+                              FAR struct uip_udp_conn *conn)
+{
+#ifdef CONFIG_NET_IPv6
+  struct sockaddr_in6 src;
+#else
+  struct sockaddr_in src;
+#endif
+  FAR struct iob_s *iob;
+  int ret;
+
+  /* Get the sender's address from the UDP packet */
+
+  memset(&src, 0, sizeof(src));
+#ifdef CONFIG_NET_IPv6
+  src.sin_family = AF_INET6;
+  src.sin_port   = UDPBUF->srcport;
+  uip_ipaddr_copy(src.sin6_addr.s6_addr, UDPBUF->srcipaddr);
+#else
+  src.sin_family = AF_INET;
+  src.sin_port   = UDPBUF->srcport;
+  uip_ipaddr_copy(src.sin_addr.s_addr, uip_ip4addr_conv(UDPBUF->srcipaddr));
+#endif
+
+  /* Allocate an I/O buffer to start the chain.  This must not block and
+   * must not use the buffers held back for write buffering.
+   */
+
+  iob = iob_tryalloc(true);
+  if (iob == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  /* Copy the sender's address and then the payload into the chain */
+
+  ret = iob_copyin(iob, (FAR const uint8_t *)&src, sizeof(src), 0, false);
+  if (ret >= 0)
+    {
+      ret = iob_copyin(iob, dev->d_appdata, dev->d_len, sizeof(src), false);
+    }
+
+  /* Then add the chain to the read-ahead queue by reference */
+
+  if (ret >= 0)
+    {
+      ret = iob_add_queue(iob, &conn->readahead);
+    }
+
+  if (ret < 0)
+    {
+      iob_free_chain(iob);
+      return ret;
+    }
+
+  nllvdbg("Buffered %d bytes\n", dev->d_len);
+  return OK;
+}
+#endif /* CONFIG_NET_UDP_READAHEAD */
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -87,6 +180,27 @@ uint16_t uip_udpcallback(struct uip_driver_s *dev, struct uip_udp_conn *conn,
       /* Perform the callback */
 
       flags = uip_callbackexecute(dev, conn, flags, conn->list);
+
+#ifdef CONFIG_NET_UDP_READAHEAD
+      /* If the new data was not consumed by a receiver, then try to retain
+       * it in the read-ahead buffers.
+       */
+
+      if ((flags & UIP_NEWDATA) != 0 && dev->d_len > 0)
+        {
+          if (uip_udpdatahandler(dev, conn) == OK)
+            {
+              /* Indicate that the data has been consumed */
+
+              flags     &= ~UIP_NEWDATA;
+              dev->d_len = 0;
+            }
+          else
+            {
+              nllvdbg("Dropped %d bytes\n", dev->d_len);
+            }
+        }
+#endif
     }
 
   return flags;
@@ -62,6 +62,24 @@
 
 #include "uip_internal.h"
 
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_UDP_HASH
+#  ifndef CONFIG_NET_UDP_NHASH
+#    define CONFIG_NET_UDP_NHASH 8
+#  endif
+
+#  if (CONFIG_NET_UDP_NHASH & (CONFIG_NET_UDP_NHASH - 1)) != 0
+#    error "CONFIG_NET_UDP_NHASH must be a power of two"
+#  endif
+
+/* Return the hash table index for a local port number in network order */
+
+#  define uip_udpporthash(p) (((p) ^ ((p) >> 8)) & (CONFIG_NET_UDP_NHASH - 1))
+#endif
+
 /****************************************************************************
  * Private Data
  ****************************************************************************/
@@ -79,6 +97,12 @@ static sem_t g_free_sem;
 
 static dq_queue_t g_active_udp_connections;
 
+#ifdef CONFIG_NET_UDP_HASH
+/* The UDP connections with an assigned local port, hashed by that port */
+
+static FAR struct uip_udp_conn *g_udp_porthash[CONFIG_NET_UDP_NHASH];
+#endif
+
 /* Last port used by a UDP connection connection. */
 
 static uint16_t g_last_udp_port;
@@ -122,6 +146,21 @@ static inline void _uip_semtake(sem_t *sem)
 
 static struct uip_udp_conn *uip_find_conn(uint16_t portno)
 {
+#ifdef CONFIG_NET_UDP_HASH
+  struct uip_udp_conn *conn;
+
+  /* Search only the connections with the same local port hash */
+
+  for (conn = g_udp_porthash[uip_udpporthash(portno)];
+       conn;
+       conn = conn->plink)
+    {
+      if (conn->lport == portno)
+        {
+          return conn;
+        }
+    }
+#else
   int i;
 
   /* Now search each connection structure.*/
@@ -133,10 +172,70 @@ static struct uip_udp_conn *uip_find_conn(uint16_t portno)
           return &g_udp_connections[ i ];
         }
     }
+#endif
 
   return NULL;
 }
 
+/****************************************************************************
+ * Name: uip_udpsetport()
+ *
+ * Description:
+ *   Set the local port number (in network order) of a UDP connection.  A
+ *   port number of zero unbinds the connection.  If CONFIG_NET_UDP_HASH is
+ *   selected, the connection is also moved to its new place in the local
+ *   port hash table.
+ *
+ ****************************************************************************/
+
+static void uip_udpsetport(struct uip_udp_conn *conn, uint16_t portno)
+{
+#ifdef CONFIG_NET_UDP_HASH
+  struct uip_udp_conn *prev;
+  struct uip_udp_conn *curr;
+  uip_lock_t flags;
+  int ndx;
+
+  /* The hash table is accessed from interrupt level */
+
+  flags = uip_lock();
+
+  /* Remove the connection from the chain for its old port number */
+
+  if (conn->lport != 0)
+    {
+      ndx = uip_udpporthash(conn->lport);
+      for (prev = NULL, curr = g_udp_porthash[ndx];
+           curr && curr != conn;
+           prev = curr, curr = curr->plink);
+
+      DEBUGASSERT(curr);
+      if (prev)
+        {
+          prev->plink = conn->plink;
+        }
+      else
+        {
+          g_udp_porthash[ndx] = conn->plink;
+        }
+    }
+
+  /* And add it to the chain for the new port number */
+
+  conn->lport = portno;
+  if (portno != 0)
+    {
+      ndx                 = uip_udpporthash(portno);
+      conn->plink         = g_udp_porthash[ndx];
+      g_udp_porthash[ndx] = conn;
+    }
+
+  uip_unlock(flags);
+#else
+  conn->lport = portno;
+#endif
+}
+
 /****************************************************************************
  * Name: uip_selectport()
  *
@@ -251,6 +350,12 @@ struct uip_udp_conn *uip_udpalloc(void)
 
       conn->lport = 0;
 
+#ifdef CONFIG_NET_UDP_READAHEAD
+      /* Initialize the read-ahead buffer queue */
+
+      IOB_QINIT(&conn->readahead);
+#endif
+
       /* Enqueue the connection into the active list */
 
       dq_addlast(&conn->node, &g_active_udp_connections);
@@ -278,12 +383,18 @@ void uip_udpfree(struct uip_udp_conn *conn)
   DEBUGASSERT(conn->crefs == 0);
 
   _uip_semtake(&g_free_sem);
-  conn->lport = 0;
+  uip_udpsetport(conn, 0);
 
   /* Remove the connection from the active list */
 
   dq_rem(&conn->node, &g_active_udp_connections);
 
+#ifdef CONFIG_NET_UDP_READAHEAD
+  /* Release any datagrams still held in the read-ahead buffers */
+
+  iob_free_queue(&conn->readahead);
+#endif
+
   /* Free the connection */
 
   dq_addlast(&conn->node, &g_free_udp_connections);
@@ -304,7 +415,11 @@ void uip_udpfree(struct uip_udp_conn *conn)
 
 struct uip_udp_conn *uip_udpactive(struct uip_udpip_hdr *buf)
 {
+#ifdef CONFIG_NET_UDP_HASH
+  struct uip_udp_conn *conn = g_udp_porthash[uip_udpporthash(buf->destport)];
+#else
   struct uip_udp_conn *conn = (struct uip_udp_conn *)g_active_udp_connections.head;
+#endif
 
   while (conn)
     {
@@ -328,9 +443,13 @@ struct uip_udp_conn *uip_udpactive(struct uip_udpip_hdr *buf)
           break;
         }
 
-      /* Look at the next active connection */
+      /* Look at the next active connection (with the same hash) */
 
+#ifdef CONFIG_NET_UDP_HASH
+      conn = conn->plink;
+#else
       conn = (struct uip_udp_conn *)conn->node.flink;
+#endif
     }
 
   return conn;
@@ -387,8 +506,8 @@ int uip_udpbind(struct uip_udp_conn *conn, const struct sockaddr_in *addr)
     {
       /* Yes.. Find an unused local port number */
 
-      conn->lport = htons(uip_selectport());
-      ret         = OK;
+      uip_udpsetport(conn, htons(uip_selectport()));
+      ret = OK;
     }
   else
     {
@@ -402,8 +521,8 @@ int uip_udpbind(struct uip_udp_conn *conn, const struct sockaddr_in *addr)
         {
           /* No.. then bind the socket to the port */
 
-          conn->lport = addr->sin_port;
-          ret         = OK;
+          uip_udpsetport(conn, addr->sin_port);
+          ret = OK;
         }
 
       uip_unlock(flags);
@@ -445,7 +564,7 @@ int uip_udpconnect(struct uip_udp_conn *conn, const struct sockaddr_in *addr)
        * connection structure.
        */
 
-      conn->lport = htons(uip_selectport());
+      uip_udpsetport(conn, htons(uip_selectport()));
     }
 
   /* Is there a remote port (rport) */
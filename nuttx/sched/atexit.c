@@ -120,7 +120,7 @@ int atexit(void (*func)(void))
   return on_exit((onexitfunc_t)func, NULL);
 
 #elif defined(CONFIG_SCHED_ATEXIT_MAX) && CONFIG_SCHED_ATEXIT_MAX > 1
-  FAR struct tcb_s *tcb = (FAR struct tcb_s*)g_readytorun.head;
+  FAR struct tcb_s *tcb = this_task();
   FAR struct task_group_s *group = tcb->group;
   int index;
   int ret = ERROR;
@@ -155,7 +155,7 @@ int atexit(void (*func)(void))
 
   return ret;
 #else
-  FAR struct tcb_s *tcb = (FAR struct tcb_s*)g_readytorun.head;
+  FAR struct tcb_s *tcb = this_task();
   FAR struct task_group_s *group = tcb->group;
   int ret = ERROR;
 
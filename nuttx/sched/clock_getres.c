@@ -105,7 +105,7 @@ int clock_getres(clockid_t clock_id, struct timespec *res)
     {
       /* Get the clock resolution in nanoseconds */
 
-      time_res = MSEC_PER_TICK * NSEC_PER_MSEC;
+      time_res = NSEC_PER_TICK;
 
       /* And return this as a timespec. */
 
@@ -47,6 +47,7 @@
 #include <debug.h>
 
 #include <arch/irq.h>
+#include <nuttx/arch.h>
 
 #include "clock_internal.h"
 
@@ -128,6 +129,28 @@ int clock_gettime(clockid_t clock_id, struct timespec *tp)
       else
 #endif
         {
+#ifdef CONFIG_SCHED_TICKLESS
+          struct timespec ts;
+
+          /* In the tick-less mode, get the elapsed time since power up
+           * directly from the free-running timer, then remove the bias.
+           */
+
+          (void)up_timer_gettime(&ts);
+
+          msecs = TICK2MSEC(g_tickbias);
+          secs  = (uint32_t)ts.tv_sec - msecs / MSEC_PER_SEC;
+          nsecs = (uint32_t)ts.tv_nsec;
+          msecs = (msecs % MSEC_PER_SEC) * NSEC_PER_MSEC;
+
+          if (nsecs < msecs)
+            {
+              nsecs += NSEC_PER_SEC;
+              secs--;
+            }
+
+          nsecs -= msecs;
+#else
           /* Get the elapsed time since power up (in milliseconds) biased
            * as appropriate.
            */
@@ -141,6 +164,7 @@ int clock_gettime(clockid_t clock_id, struct timespec *tp)
 
           secs  = msecs / MSEC_PER_SEC;
           nsecs = (msecs - (secs * MSEC_PER_SEC)) * NSEC_PER_MSEC;
+#endif
 
           sdbg("secs = %d + %d nsecs = %d + %d\n",
                (int)msecs, (int)g_basetime.tv_sec,
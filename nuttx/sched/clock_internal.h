@@ -59,6 +59,15 @@
 #  undef CONFIG_SYSTEM_TIME64
 #endif
 
+/* In the tick-less mode, there is no periodic timer interrupt to sample the
+ * CPU load.
+ */
+
+#if defined(CONFIG_SCHED_TICKLESS) && defined(CONFIG_SCHED_CPULOAD) && \
+   !defined(CONFIG_SCHED_CPULOAD_EXTCLK)
+#  error CONFIG_SCHED_CPULOAD_EXTCLK is required in the tick-less mode
+#endif
+
 /********************************************************************************
  * Public Type Definitions
  ********************************************************************************/
@@ -80,7 +89,9 @@ extern struct timespec g_basetime;
  ********************************************************************************/
 
 void weak_function clock_initialize(void);
+#ifndef CONFIG_SCHED_TICKLESS
 void weak_function clock_timer(void);
+#endif
 
 int    clock_abstime2ticks(clockid_t clockid,
                            FAR const struct timespec *abstime,
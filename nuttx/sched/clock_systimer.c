@@ -42,6 +42,7 @@
 #include <stdint.h>
 
 #include <nuttx/clock.h>
+#include <nuttx/arch.h>
 
 #include "clock_internal.h"
 
@@ -53,6 +54,38 @@
  * Private Data
  ****************************************************************************/
 
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: clock_ticklesstime
+ *
+ * Description:
+ *   In the tick-less mode, there is no counter of timer interrupts.  The
+ *   system time is derived from the free-running platform timer instead.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_TICKLESS
+#ifdef CONFIG_SYSTEM_TIME64
+static uint64_t clock_ticklesstime(void)
+#else
+static uint32_t clock_ticklesstime(void)
+#endif
+{
+  struct timespec ts;
+
+  (void)up_timer_gettime(&ts);
+
+#ifdef CONFIG_SYSTEM_TIME64
+  return (uint64_t)ts.tv_sec * TICK_PER_SEC + ts.tv_nsec / NSEC_PER_TICK;
+#else
+  return (uint32_t)ts.tv_sec * TICK_PER_SEC + ts.tv_nsec / NSEC_PER_TICK;
+#endif
+}
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -76,7 +109,9 @@
 #if !defined(clock_systimer) /* See nuttx/clock.h */
 uint32_t clock_systimer(void)
 {
-#ifdef CONFIG_SYSTEM_TIME64
+#if defined(CONFIG_SCHED_TICKLESS)
+  return (uint32_t)clock_ticklesstime();
+#elif defined(CONFIG_SYSTEM_TIME64)
   return (uint32_t)(g_system_timer & 0x00000000ffffffff);
 #else
   return g_system_timer;
@@ -104,7 +139,11 @@ uint32_t clock_systimer(void)
 #ifdef CONFIG_SYSTEM_TIME64
 uint64_t clock_systimer64(void)
 {
+#ifdef CONFIG_SCHED_TICKLESS
+  return clock_ticklesstime();
+#else
   return g_system_timer;
+#endif
 }
 #endif
 #endif
@@ -94,7 +94,7 @@ FAR char *getenv(const char *name)
   /* Get a reference to the thread-private environ in the TCB. */
 
   sched_lock();
-  rtcb = (FAR struct tcb_s*)g_readytorun.head;
+  rtcb = this_task();
   group = rtcb->group;
 
   /* Check if the variable exists */
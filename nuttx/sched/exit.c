@@ -92,7 +92,7 @@
 
 void exit(int status)
 {
-  struct tcb_s *tcb = (struct tcb_s*)g_readytorun.head;
+  struct tcb_s *tcb = this_task();
 
   /* Only the lower 8-bits of status are used */
 
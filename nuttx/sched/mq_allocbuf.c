@@ -0,0 +1,165 @@
+/****************************************************************************
+ * sched/mq_allocbuf.c
+ *
+ *   Copyright (C) 2014 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include  <nuttx/config.h>
+
+#include  <sys/types.h>
+#include  <fcntl.h>
+#include  <stdint.h>
+#include  <mqueue.h>
+#include  <errno.h>
+#include  <debug.h>
+
+#include  <nuttx/arch.h>
+
+#include  "os_internal.h"
+#include  "mq_internal.h"
+
+#ifdef CONFIG_MQ_ZEROCOPY
+
+/****************************************************************************
+ * Definitions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Private Type Declarations
+ ****************************************************************************/
+
+/****************************************************************************
+ * Global Variables
+ ****************************************************************************/
+
+/****************************************************************************
+ * Private Variables
+ ****************************************************************************/
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: mq_allocbuf
+ *
+ * Description:
+ *   Take a message buffer from the message pool of the message queue.  The
+ *   caller owns the buffer until it passes it on with mq_sendbuf() or
+ *   returns it with mq_freebuf().  The buffer can hold the maximum message
+ *   size of the message queue (mq_msgsize).
+ *
+ *   The message pool is empty when the message queue is full or when all
+ *   of its buffers are owned by senders or receivers.  Then mq_allocbuf()
+ *   blocks until a buffer is returned unless O_NONBLOCK is set in the
+ *   message queue.
+ *
+ * Parameters:
+ *   mqdes - Message queue descriptor
+ *
+ * Return Value:
+ *   On success, mq_allocbuf() returns the address of the message buffer;
+ *   on error, NULL is returned, with errno set to indicate the error:
+ *
+ *   EINVAL   mqdes is NULL.
+ *   EPERM    Message queue opened not opened for writing.
+ *   EAGAIN   The message pool was empty, and the O_NONBLOCK flag was set
+ *            for the message queue description referred to by mqdes (or
+ *            the caller is an interrupt handler).
+ *   EINTR    The call was interrupted by a signal handler.
+ *
+ * Assumptions/restrictions:
+ *
+ ****************************************************************************/
+
+FAR void *mq_allocbuf(mqd_t mqdes)
+{
+  FAR msgq_t  *msgq;
+  FAR mqmsg_t *mqmsg = NULL;
+  irqstate_t   saved_state;
+
+  /* Verify the input parameters */
+
+  if (!mqdes)
+    {
+      set_errno(EINVAL);
+      return NULL;
+    }
+
+  if ((mqdes->oflags & O_WROK) == 0)
+    {
+      set_errno(EPERM);
+      return NULL;
+    }
+
+  /* Get a message from the message pool, waiting for one to be returned
+   * if necessary (the queue is "full" when the pool is empty).
+   */
+
+  sched_lock();
+  msgq = mqdes->msgq;
+
+  saved_state = irqsave();
+  if (up_interrupt_context() || /* In an interrupt handler */
+      !MQ_ISFULL(msgq)       || /* OR Message pool not empty */
+      mq_waitsend(mqdes) == OK) /* OR Successfully waited for a message */
+    {
+      mqmsg = mq_msgalloc(msgq);
+      if (!mqmsg)
+        {
+          set_errno(EAGAIN);
+        }
+    }
+
+  irqrestore(saved_state);
+  sched_unlock();
+
+  if (!mqmsg)
+    {
+      return NULL;
+    }
+
+  /* The caller owns the message now */
+
+  mqmsg->type = MQ_ALLOC_USER;
+  return mqmsg->mail;
+}
+
+#endif /* CONFIG_MQ_ZEROCOPY */
@@ -0,0 +1,184 @@
+/****************************************************************************
+ * sched/mq_freebuf.c
+ *
+ *   Copyright (C) 2014 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include  <nuttx/config.h>
+
+#include  <sys/types.h>
+#include  <stdint.h>
+#include  <mqueue.h>
+#include  <errno.h>
+#include  <debug.h>
+
+#include  <nuttx/arch.h>
+
+#include  "os_internal.h"
+#include  "mq_internal.h"
+
+#ifdef CONFIG_MQ_ZEROCOPY
+
+/****************************************************************************
+ * Definitions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Private Type Declarations
+ ****************************************************************************/
+
+/****************************************************************************
+ * Global Variables
+ ****************************************************************************/
+
+/****************************************************************************
+ * Private Variables
+ ****************************************************************************/
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: mq_bufmsg
+ *
+ * Description:
+ *   Get the message structure that holds a message buffer that was passed
+ *   to the user by mq_allocbuf() or mq_receivebuf() and take the buffer
+ *   back from the user.  The ownership check and the change of the
+ *   message type are one atomic operation so that the same buffer cannot
+ *   be sent or freed twice by concurrent callers.
+ *
+ * Parameters:
+ *   msgq - The message queue
+ *   buf - The message buffer
+ *
+ * Return Value:
+ *   The message structure (now of type MQ_ALLOC_POOL) or NULL if 'buf' is
+ *   not a buffer from the message pool of 'msgq' that is owned by the
+ *   user.
+ *
+ ****************************************************************************/
+
+FAR mqmsg_t *mq_bufmsg(FAR msgq_t *msgq, FAR void *buf)
+{
+  FAR mqmsg_t *mqmsg;
+  irqstate_t saved_state;
+  uintptr_t offset;
+
+  offset = (uintptr_t)buf - (uintptr_t)msgq->poolbase -
+           offsetof(mqmsg_t, mail);
+
+  if ((uintptr_t)buf < (uintptr_t)msgq->poolbase ||
+      offset % msgq->msgstride != 0 ||
+      offset / msgq->msgstride >= (uintptr_t)msgq->maxmsgs)
+    {
+      return NULL;
+    }
+
+  mqmsg = (FAR mqmsg_t *)(msgq->poolbase + offset);
+
+  saved_state = irqsave();
+  if (mqmsg->type == MQ_ALLOC_USER)
+    {
+      mqmsg->type = MQ_ALLOC_POOL;
+    }
+  else
+    {
+      mqmsg = NULL;
+    }
+
+  irqrestore(saved_state);
+  return mqmsg;
+}
+
+/****************************************************************************
+ * Name: mq_freebuf
+ *
+ * Description:
+ *   Return a message buffer from mq_allocbuf() or mq_receivebuf() to the
+ *   message pool of the message queue.  A task waiting in mq_send() or
+ *   mq_allocbuf() for the pool to become non-empty is awakened.
+ *
+ * Parameters:
+ *   mqdes - Message queue descriptor
+ *   buf - The message buffer
+ *
+ * Return Value:
+ *   On success, mq_freebuf() returns 0 (OK); on error, -1 (ERROR) is
+ *   returned, with errno set to indicate the error:
+ *
+ *   EINVAL   Either buf or mqdes is NULL or buf is not a buffer of this
+ *            message queue that is owned by the caller.
+ *
+ * Assumptions/restrictions:
+ *
+ ****************************************************************************/
+
+int mq_freebuf(mqd_t mqdes, FAR void *buf)
+{
+  FAR mqmsg_t *mqmsg;
+  FAR msgq_t  *msgq;
+
+  if (!buf || !mqdes)
+    {
+      set_errno(EINVAL);
+      return ERROR;
+    }
+
+  msgq  = mqdes->msgq;
+  mqmsg = mq_bufmsg(msgq, buf);
+  if (!mqmsg)
+    {
+      set_errno(EINVAL);
+      return ERROR;
+    }
+
+  /* Return the message to the pool and wake up a waiting sender */
+
+  sched_lock();
+  mq_msgfree(msgq, mqmsg);
+  mq_wakesend(msgq);
+  sched_unlock();
+
+  return OK;
+}
+
+#endif /* CONFIG_MQ_ZEROCOPY */
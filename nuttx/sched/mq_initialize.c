@@ -93,6 +93,7 @@ sq_queue_t  g_desfree;
  * Private Variables
  ************************************************************************/
 
+#ifndef CONFIG_MQ_POOL
 /* g_msgalloc is a pointer to the start of the allocated block of
  * messages.
  */
@@ -104,6 +105,7 @@ static mqmsg_t    *g_msgalloc;
  */
 
 static mqmsg_t    *g_msgfreeirqalloc;
+#endif
 
 /* g_desalloc is a list of allocated block of message queue descriptors. */
 
@@ -113,6 +115,7 @@ static sq_queue_t  g_desalloc;
  * Private Functions
  ************************************************************************/
 
+#ifndef CONFIG_MQ_POOL
 /************************************************************************
  * Name: mq_msgblockalloc
  *
@@ -148,6 +151,7 @@ static mqmsg_t *mq_msgblockalloc(sq_queue_t *queue, uint16_t nmsgs,
 
   return mqmsgblock;
 }
+#endif
 
 /************************************************************************
  * Public Functions
@@ -181,8 +185,12 @@ void mq_initialize(void)
   sq_init(&g_msgfreeirq);
   sq_init(&g_desalloc);
 
-  /* Allocate a block of messages for general use */
+  /* With CONFIG_MQ_POOL, messages come from the message pool of each
+   * message queue.  Otherwise, allocate a block of messages for general
+   * use.
+   */
 
+#ifndef CONFIG_MQ_POOL
   g_msgalloc =
     mq_msgblockalloc(&g_msgfree, CONFIG_PREALLOC_MQ_MSGS,
                      MQ_ALLOC_FIXED);
@@ -194,6 +202,7 @@ void mq_initialize(void)
   g_msgfreeirqalloc =
     mq_msgblockalloc(&g_msgfreeirq, NUM_INTERRUPT_MSGS,
                      MQ_ALLOC_IRQ);
+#endif
 
   /* Allocate a block of message queue descriptors */
 
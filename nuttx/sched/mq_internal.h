@@ -44,6 +44,7 @@
 #include <nuttx/compiler.h>
 
 #include <sys/types.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <limits.h>
@@ -75,6 +76,23 @@
 
 #define NUM_INTERRUPT_MSGS   8
 
+/* MQ_MAX_MSGSIZE is the largest mq_msgsize that mq_open() accepts.  With
+ * CONFIG_MQ_POOL, each message queue has its own pool of messages.
+ * MQ_MSGSTRIDE(n) is the size of one message with 'n' bytes of data in the
+ * pool.  A message queue is full when its pool is empty.
+ */
+
+#ifdef CONFIG_MQ_POOL
+#  define MQ_MAX_MSGSIZE  UINT16_MAX
+#  define MQ_MSGSTRIDE(n) \
+    ((offsetof(mqmsg_t, mail) + (n) + sizeof(uintptr_t) - 1) & \
+     ~(sizeof(uintptr_t) - 1))
+#  define MQ_ISFULL(q)    ((q)->msgpool.head == NULL)
+#else
+#  define MQ_MAX_MSGSIZE  MQ_MAX_BYTES
+#  define MQ_ISFULL(q)    ((q)->nmsgs >= (q)->maxmsgs)
+#endif
+
 /****************************************************************************
  * Global Type Declarations
  ****************************************************************************/
@@ -83,7 +101,9 @@ enum mqalloc_e
 {
   MQ_ALLOC_FIXED = 0,  /* pre-allocated; never freed */
   MQ_ALLOC_DYN,        /* dynamically allocated; free when unused */
-  MQ_ALLOC_IRQ         /* Preallocated, reserved for interrupt handling */
+  MQ_ALLOC_IRQ,        /* Preallocated, reserved for interrupt handling */
+  MQ_ALLOC_POOL,       /* In the message pool of a message queue */
+  MQ_ALLOC_USER        /* From a message pool, owned by the user (zero-copy) */
 };
 
 typedef enum mqalloc_e mqalloc_t;
@@ -95,12 +115,16 @@ struct mqmsg
   FAR struct mqmsg  *next;    /* Forward link to next message */
   uint8_t      type;          /* (Used to manage allocations) */
   uint8_t      priority;      /* priority of message          */
-#if MQ_MAX_BYTES < 256
+#if MQ_MAX_BYTES < 256 && !defined(CONFIG_MQ_POOL)
   uint8_t      msglen;        /* Message data length          */
 #else
   uint16_t     msglen;        /* Message data length          */
 #endif
+#ifdef CONFIG_MQ_POOL
+  uint8_t      mail[1];       /* Message data (mq_msgsize bytes) */
+#else
   uint8_t      mail[MQ_MAX_BYTES]; /* Message data            */
+#endif
 };
 
 typedef struct mqmsg mqmsg_t;
@@ -151,7 +175,7 @@ void mq_desblockalloc(void);
 
 mqd_t mq_descreate(FAR struct tcb_s* mtcb, FAR msgq_t* msgq, int oflags);
 FAR msgq_t  *mq_findnamed(const char *mq_name);
-void mq_msgfree(FAR mqmsg_t *mqmsg);
+void mq_msgfree(FAR msgq_t *msgq, FAR mqmsg_t *mqmsg);
 void mq_msgqfree(FAR msgq_t *msgq);
 
 /* mq_waitirq.c ************************************************************/
@@ -167,11 +191,18 @@ ssize_t mq_doreceive(mqd_t mqdes, mqmsg_t *mqmsg, void *ubuffer, int *prio);
 /* mq_sndinternal.c ********************************************************/
 
 int mq_verifysend(mqd_t mqdes, const void *msg, size_t msglen, int prio);
-FAR mqmsg_t *mq_msgalloc(void);
+FAR mqmsg_t *mq_msgalloc(FAR msgq_t *msgq);
 int mq_waitsend(mqd_t mqdes);
+void mq_wakesend(FAR msgq_t *msgq);
 int mq_dosend(mqd_t mqdes, FAR mqmsg_t *mqmsg, const void *msg,
               size_t msglen, int prio);
 
+/* mq_freebuf.c ************************************************************/
+
+#ifdef CONFIG_MQ_ZEROCOPY
+FAR mqmsg_t *mq_bufmsg(FAR msgq_t *msgq, FAR void *buf);
+#endif
+
 /* mq_release.c ************************************************************/
 
 struct task_group_s; /* Forward reference */
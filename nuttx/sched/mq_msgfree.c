@@ -74,9 +74,11 @@
  * Description:
  *   The mq_msgfree function will return a message to the free pool of
  *   messages if it was a pre-allocated message. If the message was
- *   allocated dynamically it will be deallocated.
+ *   allocated dynamically it will be deallocated.  A message from the
+ *   message pool of a queue goes back to that pool.
  *
  * Inputs:
+ *   msgq  - The message queue that the message belongs to
  *   mqmsg - message to free
  *
  * Return Value:
@@ -84,14 +86,29 @@
  *
  ************************************************************************/
 
-void mq_msgfree(FAR mqmsg_t *mqmsg)
+void mq_msgfree(FAR msgq_t *msgq, FAR mqmsg_t *mqmsg)
 {
   irqstate_t saved_state;
 
+#ifdef CONFIG_MQ_POOL
+  /* If the message came from the message pool of the queue, then put it
+   * back in that pool.
+   */
+
+  if (mqmsg->type == MQ_ALLOC_POOL || mqmsg->type == MQ_ALLOC_USER)
+    {
+      saved_state = irqsave();
+      mqmsg->type = MQ_ALLOC_POOL;
+      sq_addlast((FAR sq_entry_t*)mqmsg, &msgq->msgpool);
+      irqrestore(saved_state);
+    }
+
   /* If this is a generally available pre-allocated message,
    * then just put it back in the free list.
    */
 
+  else
+#endif
   if (mqmsg->type == MQ_ALLOC_FIXED)
     {
       /* Make sure we avoid concurrent access to the free
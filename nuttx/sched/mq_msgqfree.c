@@ -98,7 +98,7 @@ void mq_msgqfree(FAR msgq_t *msgq)
       /* Deallocate the message structure. */
 
       next = curr->next;
-      mq_msgfree(curr);
+      mq_msgfree(msgq, curr);
       curr = next;
     }
 
@@ -99,6 +99,9 @@
  *        is used at the time that the message queue is
  *        created to determine the maximum number of
  *        messages that may be placed in the message queue.
+ *        With CONFIG_MQ_POOL, mq_maxmsg messages of
+ *        mq_msgsize bytes are allocated together with the
+ *        message queue.
  *
  * Return Value:
  *   A message queue descriptor or -1 (ERROR)
@@ -109,12 +112,20 @@
 
 mqd_t mq_open(const char *mq_name, int oflags, ...)
 {
-  FAR struct tcb_s *rtcb = (FAR struct tcb_s*)g_readytorun.head;
+  FAR struct tcb_s *rtcb = this_task();
   FAR msgq_t *msgq;
   mqd_t mqdes = NULL;
   va_list arg;                  /* Points to each un-named argument */
   struct mq_attr *attr;         /* MQ creation attributes */
   int namelen;                  /* Length of MQ name */
+  int16_t maxmsgs;              /* Max number of messages in the queue */
+  size_t maxmsgsize;            /* Max message size */
+#ifdef CONFIG_MQ_POOL
+  FAR mqmsg_t *mqmsg;
+  size_t msgstride;             /* Size of one message in the message pool */
+  size_t poolofs;               /* Offset of the message pool */
+  int i;
+#endif
 
   /* Make sure that a non-NULL name is supplied */
 
@@ -151,12 +162,52 @@ mqd_t mq_open(const char *mq_name, int oflags, ...)
 
           else if ((oflags & O_CREAT) != 0)
             {
+              /* Set up to get the optional arguments needed to create
+               * a message queue.
+               */
+
+              va_start(arg, oflags);
+              (void)va_arg(arg, mode_t); /* MQ creation mode parameter (ignored) */
+              attr = va_arg(arg, struct mq_attr*);
+
+              /* Clean-up variable argument stuff */
+
+              va_end(arg);
+
+              /* Get the size of the message queue */
+
+              if (attr)
+                {
+                  maxmsgs = (int16_t)attr->mq_maxmsg;
+                  if (attr->mq_msgsize <= MQ_MAX_MSGSIZE)
+                    {
+                      maxmsgsize = attr->mq_msgsize;
+                    }
+                  else
+                    {
+                      maxmsgsize = MQ_MAX_MSGSIZE;
+                    }
+                }
+              else
+                {
+                  maxmsgs    = MQ_MAX_MSGS;
+                  maxmsgsize = MQ_MAX_BYTES;
+                }
+
               /* Allocate memory for the new message queue.  The size to
                * allocate is the size of the msgq_t header plus the size
-               * of the message queue name+1.
+               * of the message queue name+1.  With CONFIG_MQ_POOL, the
+               * message pool of the queue follows.
                */
 
+#ifdef CONFIG_MQ_POOL
+              msgstride = MQ_MSGSTRIDE(maxmsgsize);
+              poolofs   = (SIZEOF_MQ_HEADER + namelen + 1 +
+                           sizeof(uintptr_t) - 1) & ~(sizeof(uintptr_t) - 1);
+              msgq = (FAR msgq_t*)kzalloc(poolofs + msgstride * maxmsgs);
+#else
               msgq = (FAR msgq_t*)kzalloc(SIZEOF_MQ_HEADER + namelen + 1);
+#endif
               if (msgq)
                 {
                   /* Create a message queue descriptor for the TCB */
@@ -164,34 +215,29 @@ mqd_t mq_open(const char *mq_name, int oflags, ...)
                   mqdes = mq_descreate(rtcb, msgq, oflags);
                   if (mqdes)
                     {
-                      /* Set up to get the optional arguments needed to create
-                       * a message queue.
-                       */
-
-                      va_start(arg, oflags);
-                      (void)va_arg(arg, mode_t); /* MQ creation mode parameter (ignored) */
-                      attr = va_arg(arg, struct mq_attr*);
-
                       /* Initialize the new named message queue */
 
                       sq_init(&msgq->msglist);
-                      if (attr)
-                        {
-                          msgq->maxmsgs = (int16_t)attr->mq_maxmsg;
-                          if (attr->mq_msgsize <= MQ_MAX_BYTES)
-                            {
-                              msgq->maxmsgsize = (int16_t)attr->mq_msgsize;
-                            }
-                          else
-                            {
-                              msgq->maxmsgsize = MQ_MAX_BYTES;
-                            }
-                        }
-                      else
+                      dq_init(&msgq->waitnotfull);
+                      dq_init(&msgq->waitnotempty);
+                      msgq->maxmsgs    = maxmsgs;
+                      msgq->maxmsgsize = maxmsgsize;
+
+#ifdef CONFIG_MQ_POOL
+                      /* Put each message of the pool in the free list */
+
+                      msgq->msgstride  = msgstride;
+                      msgq->poolbase   = (FAR uint8_t *)msgq + poolofs;
+                      sq_init(&msgq->msgpool);
+
+                      for (i = 0; i < maxmsgs; i++)
                         {
-                          msgq->maxmsgs = MQ_MAX_MSGS;
-                          msgq->maxmsgsize = MQ_MAX_BYTES;
+                          mqmsg = (FAR mqmsg_t *)
+                            (msgq->poolbase + i * msgstride);
+                          mqmsg->type = MQ_ALLOC_POOL;
+                          sq_addlast((FAR sq_entry_t*)mqmsg, &msgq->msgpool);
                         }
+#endif
 
                       msgq->nconnect = 1;
 #ifndef CONFIG_DISABLE_SIGNALS
@@ -204,10 +250,6 @@ mqd_t mq_open(const char *mq_name, int oflags, ...)
                        */
 
                       sq_addlast((FAR sq_entry_t*)msgq, &g_msgqueues);
-
-                      /* Clean-up variable argument stuff */
-
-                      va_end(arg);
                     }
                   else
                     {
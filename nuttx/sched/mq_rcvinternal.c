@@ -176,7 +176,7 @@ FAR mqmsg_t *mq_waitreceive(mqd_t mqdes)
         {
           /* Yes.. Block and try again */
 
-          rtcb = (FAR struct tcb_s*)g_readytorun.head;
+          rtcb = this_task();
           rtcb->msgwaitq = msgq;
           msgq->nwaitnotempty++;
 
@@ -247,8 +247,6 @@ FAR mqmsg_t *mq_waitreceive(mqd_t mqdes)
 
 ssize_t mq_doreceive(mqd_t mqdes, mqmsg_t *mqmsg, void *ubuffer, int *prio)
 {
-  FAR struct tcb_s *btcb;
-  irqstate_t saved_state;
   FAR msgq_t *msgq;
   ssize_t rcvmsglen;
 
@@ -269,37 +267,12 @@ ssize_t mq_doreceive(mqd_t mqdes, mqmsg_t *mqmsg, void *ubuffer, int *prio)
 
   /* We are done with the message.  Deallocate it now. */
 
-  mq_msgfree(mqmsg);
-
-  /* Check if any tasks are waiting for the MQ not full event. */
-
   msgq = mqdes->msgq;
-  if (msgq->nwaitnotfull > 0)
-    {
-      /* Find the highest priority task that is waiting for
-       * this queue to be not-full in g_waitingformqnotfull list.
-       * This must be performed in a critical section because
-       * messages can be sent from interrupt handlers.
-       */
+  mq_msgfree(msgq, mqmsg);
 
-      saved_state = irqsave();
-      for (btcb = (FAR struct tcb_s*)g_waitingformqnotfull.head;
-           btcb && btcb->msgwaitq != msgq;
-           btcb = btcb->flink);
+  /* Wake up any task waiting for the MQ not full event. */
 
-      /* If one was found, unblock it.  NOTE:  There is a race
-       * condition here:  the queue might be full again by the
-       * time the task is unblocked
-       */
-
-      ASSERT(btcb);
-
-       btcb->msgwaitq = NULL;
-       msgq->nwaitnotfull--;
-       up_unblock_task(btcb);
-
-      irqrestore(saved_state);
-    }
+  mq_wakesend(msgq);
 
   /* Return the length of the message transferred to the user buffer */
 
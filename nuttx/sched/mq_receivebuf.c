@@ -0,0 +1,160 @@
+/****************************************************************************
+ * sched/mq_receivebuf.c
+ *
+ *   Copyright (C) 2014 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include  <nuttx/config.h>
+
+#include  <sys/types.h>
+#include  <fcntl.h>
+#include  <stdint.h>
+#include  <mqueue.h>
+#include  <assert.h>
+#include  <errno.h>
+#include  <debug.h>
+
+#include  <nuttx/arch.h>
+
+#include  "os_internal.h"
+#include  "mq_internal.h"
+
+#ifdef CONFIG_MQ_ZEROCOPY
+
+/****************************************************************************
+ * Definitions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Private Type Declarations
+ ****************************************************************************/
+
+/****************************************************************************
+ * Global Variables
+ ****************************************************************************/
+
+/****************************************************************************
+ * Private Variables
+ ****************************************************************************/
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: mq_receivebuf
+ *
+ * Description:
+ *   Receive the oldest of the highest priority messages from the message
+ *   queue without copying it.  This works like mq_receive(), but the
+ *   address of the message buffer is returned and the ownership of the
+ *   buffer passes to the caller.  The caller must return the buffer with
+ *   mq_freebuf() (or send it on with mq_sendbuf()) before it closes the
+ *   message queue.
+ *
+ * Parameters:
+ *   mqdes - Message queue descriptor
+ *   buf - The location to return the address of the message buffer
+ *   prio - If not NULL, the location to store message priority.
+ *
+ * Return Value:
+ *   On success, the length of the received message in bytes is returned.
+ *   Otherwise -1 (ERROR) is returned and the errno is set appropriately:
+ *
+ *   EAGAIN   The queue was empty, and the O_NONBLOCK flag was set
+ *            for the message queue description referred to by 'mqdes'.
+ *   EPERM    Message queue opened not opened for reading.
+ *   EINTR    The wait was interrupted by a signal handler.
+ *   EINVAL   Invalid 'buf' or 'mqdes'
+ *
+ * Assumptions:
+ *
+ ****************************************************************************/
+
+ssize_t mq_receivebuf(mqd_t mqdes, FAR void **buf, FAR int *prio)
+{
+  FAR mqmsg_t *mqmsg;
+  irqstate_t   saved_state;
+  ssize_t      ret = ERROR;
+
+  DEBUGASSERT(up_interrupt_context() == false);
+
+  /* Verify the input parameters */
+
+  if (!buf || !mqdes)
+    {
+      set_errno(EINVAL);
+      return ERROR;
+    }
+
+  if ((mqdes->oflags & O_RDOK) == 0)
+    {
+      set_errno(EPERM);
+      return ERROR;
+    }
+
+  /* Get the next mesage from the message queue (see mq_receive()) */
+
+  sched_lock();
+  saved_state = irqsave();
+  mqmsg = mq_waitreceive(mqdes);
+  irqrestore(saved_state);
+
+  if (mqmsg)
+    {
+      /* The caller owns the message now.  It is not returned to the
+       * message pool so there is no need to wake up any sender.
+       */
+
+      mqmsg->type = MQ_ALLOC_USER;
+      *buf        = mqmsg->mail;
+      ret         = mqmsg->msglen;
+
+      if (prio)
+        {
+          *prio = mqmsg->priority;
+        }
+    }
+
+  sched_unlock();
+  return ret;
+}
+
+#endif /* CONFIG_MQ_ZEROCOPY */
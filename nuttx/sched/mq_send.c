@@ -146,26 +146,30 @@ int mq_send(mqd_t mqdes, const void *msg, size_t msglen, int prio)
 
   saved_state = irqsave();
   if (up_interrupt_context()      || /* In an interrupt handler */
-      msgq->nmsgs < msgq->maxmsgs || /* OR Message queue not full */
+      !MQ_ISFULL(msgq)            || /* OR Message queue not full */
       mq_waitsend(mqdes) == OK)      /* OR Successfully waited for mq not full */
     {
-      /* Allocate the message */
-
-      irqrestore(saved_state);
-      mqmsg = mq_msgalloc();
-    }
-  else
-    {
-      /* We cannot send the message (and didn't even try to allocate it)
-       * because:
-       * - We are not in an interrupt handler AND
-       * - The message queue is full AND
-       * - When we tried waiting, the wait was unsuccessful.
+      /* Allocate the message.  This is done before leaving the critical
+       * section so that an interrupt handler cannot take the message
+       * that was found to be available.
        */
 
-      irqrestore(saved_state);
+      mqmsg = mq_msgalloc(msgq);
+      if (!mqmsg)
+        {
+          set_errno(EAGAIN);
+        }
     }
 
+  /* Otherwise, we cannot send the message (and didn't even try to
+   * allocate it) because:
+   * - We are not in an interrupt handler AND
+   * - The message queue is full AND
+   * - When we tried waiting, the wait was unsuccessful.
+   */
+
+  irqrestore(saved_state);
+
   /* Check if we were able to get a message structure -- this can fail
    * either because we cannot send the message (and didn't bother trying
    * to allocate it) or because the allocation failed.
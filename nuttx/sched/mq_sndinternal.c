@@ -151,20 +151,36 @@ int mq_verifysend(mqd_t mqdes, const void *msg, size_t msglen, int prio)
  *   the g_msgfreeirq list.  If this is unsuccessful, the calling interrupt
  *   handler will be notified.
  *
+ *   With CONFIG_MQ_POOL, the message is taken from the message pool of the
+ *   message queue instead.  Nothing is ever allocated then.
+ *
  * Inputs:
- *   None
+ *   msgq - The message queue that the message will be sent to
  *
  * Return Value:
  *   A reference to the allocated msg structure.  On a failure to allocate,
- *   this function PANICs.
+ *   this function PANICs.  With CONFIG_MQ_POOL, NULL is returned if the
+ *   message pool is empty.
  *
  ****************************************************************************/
 
-FAR mqmsg_t *mq_msgalloc(void)
+FAR mqmsg_t *mq_msgalloc(FAR msgq_t *msgq)
 {
   FAR mqmsg_t *mqmsg;
   irqstate_t   saved_state;
 
+#ifdef CONFIG_MQ_POOL
+  /* Take the message from the message pool of the queue.  Disable
+   * interrupts -- we might be called from an interrupt handler.
+   */
+
+  saved_state = irqsave();
+  mqmsg = (FAR mqmsg_t*)sq_remfirst(&msgq->msgpool);
+  irqrestore(saved_state);
+
+  return mqmsg;
+#else
+
   /* If we were called from an interrupt handler, then try to get the message
    * from generally available list of messages. If this fails, then try the
    * list of messages reserved for interrupt handlers
@@ -209,6 +225,7 @@ FAR mqmsg_t *mq_msgalloc(void)
     }
 
   return mqmsg;
+#endif
 }
 
 /****************************************************************************
@@ -248,7 +265,7 @@ int mq_waitsend(mqd_t mqdes)
 
   /* Verify that the queue is indeed full as the caller thinks */
 
-  if (msgq->nmsgs >= msgq->maxmsgs)
+  if (MQ_ISFULL(msgq))
     {
       /* Should we block until there is sufficient space in the
        * message queue?
@@ -272,13 +289,13 @@ int mq_waitsend(mqd_t mqdes)
            * receiving message queue
            */
 
-          while (msgq->nmsgs >= msgq->maxmsgs)
+          while (MQ_ISFULL(msgq))
             {
               /* Block until the message queue is no longer full.
                * When we are unblocked, we will try again
                */
 
-              rtcb = (FAR struct tcb_s*)g_readytorun.head;
+              rtcb = this_task();
               rtcb->msgwaitq = msgq;
               msgq->nwaitnotfull++;
 
@@ -301,6 +318,55 @@ int mq_waitsend(mqd_t mqdes)
   return OK;
 }
 
+/****************************************************************************
+ * Name: mq_wakesend
+ *
+ * Description:
+ *   Wake up the highest priority task that is waiting in mq_waitsend() for
+ *   the message queue to become non-full (if there is one).
+ *
+ * Parameters:
+ *   msgq - The message queue that is no longer full
+ *
+ * Return Value:
+ *   None
+ *
+ * Assumptions/restrictions:
+ * - Pre-emption should be disabled.
+ *
+ ****************************************************************************/
+
+void mq_wakesend(FAR msgq_t *msgq)
+{
+  FAR struct tcb_s *btcb;
+  irqstate_t saved_state;
+
+  if (msgq->nwaitnotfull > 0)
+    {
+      /* Get the highest priority task that is waiting for this queue to
+       * be not-full.  It is at the head of the queue's prioritized wait
+       * list.  This must be performed in a critical section because
+       * messages can be sent from interrupt handlers.
+       */
+
+      saved_state = irqsave();
+      btcb = sched_firstwaiter(&msgq->waitnotfull);
+
+      /* If one was found, unblock it.  NOTE:  There is a race
+       * condition here:  the queue might be full again by the
+       * time the task is unblocked
+       */
+
+      ASSERT(btcb);
+
+      btcb->msgwaitq = NULL;
+      msgq->nwaitnotfull--;
+      up_unblock_task(btcb);
+
+      irqrestore(saved_state);
+    }
+}
+
 /****************************************************************************
  * Name: mq_dosend
  *
@@ -313,7 +379,8 @@ int mq_waitsend(mqd_t mqdes)
  * 
  * Parameters:
  *   mqdes - Message queue descriptor
- *   msg - Message to send
+ *   mqmsg - The message structure to send
+ *   msg - Message to send (NULL if the message data is already in mqmsg)
  *   msglen - The length of the message in bytes
  *   prio - The priority of the message
  *
@@ -342,9 +409,12 @@ int mq_dosend(mqd_t mqdes, FAR mqmsg_t *mqmsg, const void *msg, size_t msglen, i
   mqmsg->priority = prio;
   mqmsg->msglen   = msglen;
 
-  /* Copy the message data into the message */
+  /* Copy the message data into the message (unless it is already there) */
 
-  memcpy((void*)mqmsg->mail, (const void*)msg, msglen);
+  if (msg)
+    {
+      memcpy((void*)mqmsg->mail, (const void*)msg, msglen);
+    }
 
   /* Insert the new message in the message queue */
 
@@ -414,15 +484,12 @@ int mq_dosend(mqd_t mqdes, FAR mqmsg_t *mqmsg, const void *msg, size_t msglen, i
   saved_state = irqsave();
   if (msgq->nwaitnotempty > 0)
     {
-      /* Find the highest priority task that is waiting for
-       * this queue to be non-empty in g_waitingformqnotempty
-       * list. sched_lock() should give us sufficent protection since
-       * interrupts should never cause a change in this list
+      /* Get the highest priority task that is waiting for this queue to
+       * be non-empty.  It is at the head of the queue's prioritized wait
+       * list.
        */
 
-      for (btcb = (FAR struct tcb_s*)g_waitingformqnotempty.head;
-           btcb && btcb->msgwaitq != msgq;
-           btcb = btcb->flink);
+      btcb = sched_firstwaiter(&msgq->waitnotempty);
 
       /* If one was found, unblock it */
 
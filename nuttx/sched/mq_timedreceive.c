@@ -182,7 +182,7 @@ static void mq_rcvtimeout(int argc, uint32_t pid)
 ssize_t mq_timedreceive(mqd_t mqdes, void *msg, size_t msglen,
                         int *prio, const struct timespec *abstime)
 {
-  FAR struct tcb_s *rtcb = (FAR struct tcb_s *)g_readytorun.head;
+  FAR struct tcb_s *rtcb = this_task();
   FAR mqmsg_t *mqmsg;
   irqstate_t saved_state;
   int ret = ERROR;
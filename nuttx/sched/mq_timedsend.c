@@ -182,7 +182,7 @@ static void mq_sndtimeout(int argc, uint32_t pid)
 int mq_timedsend(mqd_t mqdes, const char *msg, size_t msglen, int prio,
                  const struct timespec *abstime)
 {
-  FAR struct tcb_s *rtcb = (FAR struct tcb_s *)g_readytorun.head;
+  FAR struct tcb_s *rtcb = this_task();
   FAR msgq_t *msgq;
   FAR mqmsg_t *mqmsg = NULL;
   irqstate_t saved_state;
@@ -229,12 +229,20 @@ int mq_timedsend(mqd_t mqdes, const char *msg, size_t msglen, int prio,
   sched_lock();
   saved_state = irqsave();
   if (up_interrupt_context()      || /* In an interrupt handler */
-      msgq->nmsgs < msgq->maxmsgs)   /* OR Message queue not full */
+      !MQ_ISFULL(msgq))              /* OR Message queue not full */
     {
-      /* Allocate the message */
+      /* Allocate the message.  This is done before leaving the critical
+       * section so that an interrupt handler cannot take the message
+       * that was found to be available.
+       */
+
+      mqmsg = mq_msgalloc(msgq);
+      if (!mqmsg)
+        {
+          set_errno(EAGAIN);
+        }
 
       irqrestore(saved_state);
-      mqmsg = mq_msgalloc();
     }
   else
     {
@@ -285,19 +293,26 @@ int mq_timedsend(mqd_t mqdes, const char *msg, size_t msglen, int prio,
           wd_cancel(rtcb->waitdog);
         }
 
-      /* That is the end of the atomic operations */
-
-      irqrestore(saved_state);
-
-      /* If any of the above failed, set the errno.  Otherwise, there should
-       * be space for another message in the message queue.  NOW we can allocate
-       * the message structure.
+      /* If any of the above failed, the errno has been set.  Otherwise,
+       * there should be space for another message in the message queue.
+       * NOW we can allocate the message structure (before leaving the
+       * critical section so that the message cannot be taken by an
+       * interrupt handler).
        */
 
       if (ret == OK)
         {
-          mqmsg = mq_msgalloc();
+          mqmsg = mq_msgalloc(msgq);
+          if (!mqmsg)
+            {
+              set_errno(EAGAIN);
+              ret = ERROR;
+            }
         }
+
+      /* That is the end of the atomic operations */
+
+      irqrestore(saved_state);
     }
 
   /* Check if we were able to get a message structure -- this can fail
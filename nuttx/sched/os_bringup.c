@@ -44,6 +44,7 @@
 #include <nuttx/config.h>
 
 #include <sched.h>
+#include <semaphore.h>
 #include <stdlib.h>
 #include <debug.h>
 
@@ -131,6 +132,9 @@
 int os_bringup(void)
 {
   int taskid;
+#if defined(CONFIG_SCHED_WORKQUEUE) && defined(CONFIG_SCHED_HPWORK)
+  int i;
+#endif
 
   /* Setup up the initial environment for the idle task.  At present, this
    * may consist of only the initial PATH variable.  The PATH variable is
@@ -170,10 +174,18 @@ int os_bringup(void)
   svdbg("Starting kernel worker thread\n");
 #endif
 
-  g_work[HPWORK].pid = KERNEL_THREAD(HPWORKNAME, CONFIG_SCHED_WORKPRIORITY,
-                                     CONFIG_SCHED_WORKSTACKSIZE,
-                                     (main_t)work_hpthread, (FAR char * const *)NULL);
-  DEBUGASSERT(g_work[HPWORK].pid > 0);
+  /* Initialize the semaphore that the idle worker threads wait on */
+
+  (void)sem_init(&g_work[HPWORK].sem, 0, 0);
+
+  for (i = 0; i < CONFIG_SCHED_HPNTHREADS; i++)
+    {
+      g_work[HPWORK].pid[i] =
+        KERNEL_THREAD(HPWORKNAME, CONFIG_SCHED_WORKPRIORITY,
+                      CONFIG_SCHED_WORKSTACKSIZE,
+                      (main_t)work_hpthread, (FAR char * const *)NULL);
+      DEBUGASSERT(g_work[HPWORK].pid[i] > 0);
+    }
 
   /* Start a lower priority worker thread for other, non-critical continuation
    * tasks
@@ -183,10 +195,16 @@ int os_bringup(void)
 
   svdbg("Starting low-priority kernel worker thread\n");
 
-  g_work[LPWORK].pid = KERNEL_THREAD(LPWORKNAME, CONFIG_SCHED_LPWORKPRIORITY,
-                                     CONFIG_SCHED_LPWORKSTACKSIZE,
-                                     (main_t)work_lpthread, (FAR char * const *)NULL);
-  DEBUGASSERT(g_work[LPWORK].pid > 0);
+  (void)sem_init(&g_work[LPWORK].sem, 0, 0);
+
+  for (i = 0; i < CONFIG_SCHED_LPNTHREADS; i++)
+    {
+      g_work[LPWORK].pid[i] =
+        KERNEL_THREAD(LPWORKNAME, CONFIG_SCHED_LPWORKPRIORITY,
+                      CONFIG_SCHED_LPWORKSTACKSIZE,
+                      (main_t)work_lpthread, (FAR char * const *)NULL);
+      DEBUGASSERT(g_work[LPWORK].pid[i] > 0);
+    }
 
 #endif /* CONFIG_SCHED_LPWORK */
 #endif /* CONFIG_SCHED_HPWORK */
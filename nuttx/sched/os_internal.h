@@ -43,10 +43,13 @@
 #include <nuttx/config.h>
 
 #include <sys/types.h>
+#include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <queue.h>
 #include <sched.h>
 
+#include <nuttx/arch.h>
 #include <nuttx/kmalloc.h>
 
 /****************************************************************************
@@ -72,11 +75,55 @@
 /* A more efficient ways to access the errno */
 
 #define SET_ERRNO(e) \
-  { struct tcb_s *rtcb = struct tcb_s*)g_readytorun.head; rtcb->pterrno = (e); }
+  { struct tcb_s *rtcb = this_task(); rtcb->pterrno = (e); }
 
 #define _SET_TCB_ERRNO(t,e) \
   { (t)->pterrno = (e); }
 
+/* The currently executing task.  In the single CPU case, this is always
+ * the task at the head of the g_readytorun list.  In the SMP case, the
+ * g_readytorun list holds the ready-to-run tasks of all CPUs and each CPU
+ * keeps a reference to the task that it is currently executing.  The
+ * calling task cannot move to another CPU while it is within a critical
+ * section (irqsave()) or has pre-emption disabled (sched_lock()).
+ */
+
+#ifdef CONFIG_SMP
+#  define this_cpu()                 up_cpu_index()
+#  define this_task()                (g_runningtasks[up_cpu_index()])
+#  define SCHED_ALL_CPUS \
+     ((cpu_set_t)0xffffffff >> (32 - CONFIG_SMP_NCPUS))
+#else
+#  define this_cpu()                 (0)
+#  define this_task()                ((FAR struct tcb_s *)g_readytorun.head)
+#endif
+
+/* Recover the TCB from its link in a per-object wait list and return the
+ * TCB of the highest priority task in such a list (NULL if it is empty).
+ */
+
+#define WAITLINK2TCB(e) \
+  ((FAR struct tcb_s *)((uintptr_t)(e) - offsetof(struct tcb_s, waitlink)))
+
+#define sched_firstwaiter(list) \
+  ((list)->head ? WAITLINK2TCB((list)->head) : (FAR struct tcb_s *)NULL)
+
+/* Priority bitmap index of the g_readytorun and g_pendingtasks lists */
+
+#ifdef CONFIG_SCHED_READYBITMAP
+#  define PRIOBITMAP_NWORDS ((SCHED_PRIORITY_MAX + 32) >> 5)
+
+#  define sched_priobitmap(list) \
+     ((FAR dq_queue_t *)(list) == (FAR dq_queue_t *)&g_readytorun ? \
+       &g_readybitmap : \
+      (FAR dq_queue_t *)(list) == (FAR dq_queue_t *)&g_pendingtasks ? \
+       &g_pendingbitmap : (FAR struct priobitmap_s *)NULL)
+#else
+#  define sched_priobitmap(list)     NULL
+#  define sched_bitmap_add(b,t)
+#  define sched_bitmap_remove(b,t)
+#endif
+
 /****************************************************************************
  * Public Type Definitions
  ****************************************************************************/
@@ -116,6 +163,24 @@ struct tasklist_s
 
 typedef struct tasklist_s tasklist_t;
 
+/* This structure indexes a prioritized task list by priority.  The tasks
+ * of each priority form one contiguous, FIFO ordered run in the list.
+ * tail[] holds the last TCB of each run and the bitmaps record which
+ * priorities have a run at all:  Bit (p & 31) of map[p >> 5] is set if
+ * there is a task of priority p in the list and bit n of summary is set
+ * if map[n] is non-zero.  With this, the place in the list where a task
+ * must be inserted is found without searching the list.
+ */
+
+#ifdef CONFIG_SCHED_READYBITMAP
+struct priobitmap_s
+{
+  uint32_t summary;                         /* Non-zero words of map[] */
+  uint32_t map[PRIOBITMAP_NWORDS];          /* Priorities in the list */
+  FAR struct tcb_s *tail[SCHED_PRIORITY_MAX + 1]; /* Last TCB of each priority */
+};
+#endif
+
 /****************************************************************************
  * Global Variables
  ****************************************************************************/
@@ -133,10 +198,32 @@ typedef struct tasklist_s tasklist_t;
 /* This is the list of all tasks that are ready to run.  The head of this
  * list is the currently active task; the tail of this list is always the
  * IDLE task.
+ *
+ * In the SMP case, this list holds the tasks that are ready to run on any
+ * CPU, including the tasks that are currently running and the IDLE tasks
+ * of all CPUs.  Use this_task() to get the task of the current CPU.
  */
 
 extern volatile dq_queue_t g_readytorun;
 
+#ifdef CONFIG_SMP
+/* The task currently executing on each CPU and the task that the scheduler
+ * has selected to run on each CPU.  These differ only until the CPU
+ * responds to the re-schedule request sent by up_cpu_reschedule().
+ */
+
+extern FAR struct tcb_s * volatile g_runningtasks[CONFIG_SMP_NCPUS];
+extern FAR struct tcb_s * volatile g_assignedtasks[CONFIG_SMP_NCPUS];
+
+/* sched_lock() disables pre-emption on all CPUs:  This is the CPU whose
+ * running task holds the pre-emption lock (-1 if none).  Only one task at
+ * a time may hold it so that sched_lock() still provides mutual exclusion.
+ * The lock is released when the holder calls sched_unlock() or blocks.
+ */
+
+extern volatile int g_cpu_schedlock;
+#endif
+
 /* This is the list of all tasks that are ready-to-run, but cannot be placed
  * in the g_readytorun list because:  (1) They are higher priority than the
  * currently active task at the head of the g_readytorun list, and (2) the
@@ -145,7 +232,17 @@ extern volatile dq_queue_t g_readytorun;
 
 extern volatile dq_queue_t g_pendingtasks;
 
-/* This is the list of all tasks that are blocked waiting for a semaphore */
+/* Priority indices of the g_readytorun and g_pendingtasks lists */
+
+#ifdef CONFIG_SCHED_READYBITMAP
+extern struct priobitmap_s g_readybitmap;
+extern struct priobitmap_s g_pendingbitmap;
+#endif
+
+/* This is the list of all tasks that are blocked waiting for a semaphore.
+ * Each task is also in the wait list of its semaphore; that list, not this
+ * one, is used to select the task to wake up.
+ */
 
 extern volatile dq_queue_t g_waitingforsemaphore;
 
@@ -156,7 +253,8 @@ extern volatile dq_queue_t g_waitingforsignal;
 #endif
 
 /* This is the list of all tasks that are blocked waiting for a message
- * queue to become non-empty.
+ * queue to become non-empty.  As with semaphores, each task is also in a
+ * wait list of the message queue.
  */
 
 #ifndef CONFIG_DISABLE_MQUEUE
@@ -247,8 +345,25 @@ bool sched_addreadytorun(FAR struct tcb_s *rtrtcb);
 bool sched_removereadytorun(FAR struct tcb_s *rtrtcb);
 bool sched_addprioritized(FAR struct tcb_s *newTcb, DSEG dq_queue_t *list);
 bool sched_mergepending(void);
+#ifdef CONFIG_SMP
+void os_smp_start(void);
+bool sched_smp_assign(void);
+void sched_smp_stop(FAR struct tcb_s *tcb);
+#endif
+#ifdef CONFIG_SCHED_READYBITMAP
+FAR struct tcb_s *sched_bitmap_next(FAR struct priobitmap_s *bitmap,
+                                    DSEG dq_queue_t *list,
+                                    uint8_t sched_priority);
+void sched_bitmap_add(FAR struct priobitmap_s *bitmap,
+                      FAR struct tcb_s *tcb);
+void sched_bitmap_remove(FAR struct priobitmap_s *bitmap,
+                         FAR struct tcb_s *tcb);
+#endif
 void sched_addblocked(FAR struct tcb_s *btcb, tstate_t task_state);
 void sched_removeblocked(FAR struct tcb_s *btcb);
+FAR dq_queue_t *sched_waitlist(FAR struct tcb_s *tcb, tstate_t task_state);
+void sched_addwaiter(FAR struct tcb_s *tcb, FAR dq_queue_t *list);
+void sched_removewaiter(FAR struct tcb_s *tcb);
 int  sched_setpriority(FAR struct tcb_s *tcb, int sched_priority);
 #ifdef CONFIG_PRIORITY_INHERITANCE
 int  sched_reprioritize(FAR struct tcb_s *tcb, int sched_priority);
@@ -258,6 +373,15 @@ int  sched_reprioritize(FAR struct tcb_s *tcb, int sched_priority);
 #ifdef CONFIG_SCHED_CPULOAD
 void weak_function sched_process_cpuload(void);
 #endif
+#ifdef CONFIG_SCHED_TICKLESS
+void sched_timer_cancel(void);
+void sched_timer_resume(void);
+void sched_timer_reassess(void);
+#else
+#  define sched_timer_cancel()
+#  define sched_timer_resume()
+#  define sched_timer_reassess()
+#endif
 bool sched_verifytcb(FAR struct tcb_s *tcb);
 int  sched_releasetcb(FAR struct tcb_s *tcb, uint8_t ttype);
 
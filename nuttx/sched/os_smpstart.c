@@ -0,0 +1,149 @@
+/****************************************************************************
+ * sched/os_smpstart.c
+ *
+ *   Copyright (C) 2014 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <queue.h>
+#include <assert.h>
+#include <debug.h>
+
+#include <nuttx/arch.h>
+
+#include "os_internal.h"
+
+#ifdef CONFIG_SMP
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* These are the TCBs of the IDLE tasks of CPUs 1 through
+ * (CONFIG_SMP_NCPUS-1).  CPU 0 uses the TCB of the thread that started the
+ * OS (see os_start.c).
+ */
+
+static struct tcb_s g_cpuidletcb[CONFIG_SMP_NCPUS - 1];
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: os_smp_start
+ *
+ * Description:
+ *   Create the IDLE tasks of the other CPUs and start the CPUs.  This is
+ *   called by os_start() on CPU 0 after the OS has been initialized but
+ *   before the initial user tasks are created.
+ *
+ *   The IDLE task of CPU n has the PID n, priority zero and may run only
+ *   on CPU n.  It shares the task group of the IDLE task of CPU 0.
+ *
+ * Input Parameters:
+ *   None
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+void os_smp_start(void)
+{
+  FAR struct tcb_s *idle = this_task();
+  FAR struct tcb_s *tcb;
+  irqstate_t flags;
+  int cpu;
+
+  for (cpu = 1; cpu < CONFIG_SMP_NCPUS; cpu++)
+    {
+      tcb = &g_cpuidletcb[cpu - 1];
+
+      /* Initialize the IDLE TCB.  The IDLE task of the CPU runs on the
+       * stack provided by up_cpu_start() so only the (potentially)
+       * non-zero fields of the TCB need to be initialized.
+       */
+
+      memset(tcb, 0, sizeof(struct tcb_s));
+      tcb->pid        = (pid_t)cpu;
+      tcb->flags      = TCB_FLAG_TTYPE_KERNEL;
+      tcb->cpu        = (uint8_t)cpu;
+      tcb->affinity   = ((cpu_set_t)1 << cpu);
+      tcb->task_state = TSTATE_TASK_RUNNING;
+      tcb->entry.main = idle->entry.main;
+#ifdef HAVE_TASK_GROUP
+      tcb->group      = idle->group;
+#endif
+#if CONFIG_TASK_NAME_SIZE > 0
+      snprintf(tcb->name, CONFIG_TASK_NAME_SIZE, "CPU%d IDLE", cpu);
+#endif
+
+      /* Reserve its PID (os_start() did not assign the PIDs 1 through
+       * (CONFIG_SMP_NCPUS-1) to any other task).
+       */
+
+      g_pidhash[PIDHASH(cpu)].tcb = tcb;
+      g_pidhash[PIDHASH(cpu)].pid = (pid_t)cpu;
+
+      /* Add the IDLE task to the end of the ready-to-run list and make it
+       * the running task of the CPU.
+       */
+
+      flags = irqsave();
+      sched_addprioritized(tcb, (FAR dq_queue_t*)&g_readytorun);
+      g_runningtasks[cpu]  = tcb;
+      g_assignedtasks[cpu] = tcb;
+      irqrestore(flags);
+
+      sched_note_start(tcb);
+
+      /* Then start the CPU.  It will run the IDLE loop. */
+
+      sdbg("Starting CPU%d\n", cpu);
+      DEBUGVERIFY(up_cpu_start(cpu));
+    }
+}
+
+#endif /* CONFIG_SMP */
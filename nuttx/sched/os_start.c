@@ -96,6 +96,19 @@
 
 volatile dq_queue_t g_readytorun;
 
+#ifdef CONFIG_SMP
+/* The task currently executing on each CPU and the task that the scheduler
+ * has selected to run on each CPU.
+ */
+
+FAR struct tcb_s * volatile g_runningtasks[CONFIG_SMP_NCPUS];
+FAR struct tcb_s * volatile g_assignedtasks[CONFIG_SMP_NCPUS];
+
+/* The CPU whose running task holds the pre-emption lock (-1 if none) */
+
+volatile int g_cpu_schedlock = -1;
+#endif
+
 /* This is the list of all tasks that are ready-to-run, but cannot be placed
  * in the g_readytorun list because:  (1) They are higher priority than the
  * currently active task at the head of the g_readytorun list, and (2) the
@@ -274,6 +287,14 @@ void os_start(void)
   g_pidhash[PIDHASH(0)].tcb = &g_idletcb.cmn;
   g_pidhash[PIDHASH(0)].pid = 0;
 
+#ifdef CONFIG_SMP
+  /* The PIDs 1 through (CONFIG_SMP_NCPUS-1) are reserved for the IDLE
+   * tasks of the other CPUs (see os_smpstart.c).
+   */
+
+  g_lastpid = CONFIG_SMP_NCPUS - 1;
+#endif
+
   /* Initialize the IDLE task TCB *******************************************/
   /* Initialize a TCB for this thread of execution.  NOTE:  The default
    * value for most components of the g_idletcb are zero.  The entire
@@ -286,6 +307,14 @@ void os_start(void)
   g_idletcb.cmn.task_state = TSTATE_TASK_RUNNING;
   g_idletcb.cmn.entry.main = (main_t)os_start;
 
+#ifdef CONFIG_SMP
+  /* This is the IDLE task of CPU 0 and it may run only on CPU 0 */
+
+  g_idletcb.cmn.affinity   = 1;
+  g_runningtasks[0]        = &g_idletcb.cmn;
+  g_assignedtasks[0]       = &g_idletcb.cmn;
+#endif
+
   /* Set the IDLE task name */
 
 #if CONFIG_TASK_NAME_SIZE > 0
@@ -311,6 +340,7 @@ void os_start(void)
   /* Then add the idle task's TCB to the head of the ready to run list */
 
   dq_addfirst((FAR dq_entry_t*)&g_idletcb, (FAR dq_queue_t*)&g_readytorun);
+  sched_bitmap_add(sched_priobitmap(&g_readytorun), &g_idletcb.cmn);
 
   /* Initialize the processor-specific portion of the TCB */
 
@@ -499,6 +529,12 @@ void os_start(void)
   g_idletcb.cmn.group->tg_flags = GROUP_FLAG_NOCLDWAIT;
 #endif
 
+  /* Start the other CPUs ***************************************************/
+
+#ifdef CONFIG_SMP
+  os_smp_start();
+#endif
+
   /* Bring Up the System ****************************************************/
   /* Create initial tasks and bring-up the system */
 
@@ -101,7 +101,7 @@ int prctl(int option, ...)
 
         if (!pid)
           {
-            tcb = (FAR struct tcb_s *)g_readytorun.head;
+            tcb = this_task();
           }
         else
           {
@@ -50,6 +50,8 @@
 #include <wdog.h>
 #include <debug.h>
 
+#include <nuttx/pthread.h>
+
 #include "os_internal.h"
 #include "pthread_internal.h"
 #include "clock_internal.h"
@@ -180,7 +182,7 @@ static void pthread_condtimedout(int argc, uint32_t pid, uint32_t signo)
 int pthread_cond_timedwait(FAR pthread_cond_t *cond, FAR pthread_mutex_t *mutex,
                            FAR const struct timespec *abstime)
 {
-  FAR struct tcb_s *rtcb = (FAR struct tcb_s *)g_readytorun.head;
+  FAR struct tcb_s *rtcb = this_task();
   int ticks;
   int mypid = (int)getpid();
   irqstate_t int_state;
@@ -200,7 +202,7 @@ int pthread_cond_timedwait(FAR pthread_cond_t *cond, FAR pthread_mutex_t *mutex,
 
   /* Make sure that the caller holds the mutex */
 
-  else if (mutex->pid != mypid)
+  else if (PTHREAD_MUTEX_HOLDER(mutex) != mypid)
     {
       ret = EPERM;
     }
@@ -269,8 +271,12 @@ int pthread_cond_timedwait(FAR pthread_cond_t *cond, FAR pthread_mutex_t *mutex,
                 {
                   /* Give up the mutex */
 
+#ifdef CONFIG_MUTEX_FASTPATH
+                  ret = pthread_mutex_give(mutex);
+#else
                   mutex->pid = 0;
                   ret = pthread_givesemaphore((sem_t*)&mutex->sem);
+#endif
                   if (ret)
                     {
                       /* Restore interrupts  (pre-emption will be enabled when
@@ -326,12 +332,17 @@ int pthread_cond_timedwait(FAR pthread_cond_t *cond, FAR pthread_mutex_t *mutex,
                   /* Reacquire the mutex (retaining the ret). */
 
                   sdbg("Re-locking...\n");
+#ifdef CONFIG_MUTEX_FASTPATH
+                  status = pthread_mutex_take(mutex);
+                  if (status && !ret)
+#else
                   status = pthread_takesemaphore((sem_t*)&mutex->sem);
                   if (!status)
                     {
                       mutex->pid = mypid;
                     }
                   else if (!ret)
+#endif
                     {
                       ret = status;
                     }
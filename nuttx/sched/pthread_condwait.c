@@ -45,6 +45,8 @@
 #include <errno.h>
 #include <debug.h>
 
+#include <nuttx/pthread.h>
+
 #include "pthread_internal.h"
 
 /****************************************************************************
@@ -102,7 +104,7 @@ int pthread_cond_wait(FAR pthread_cond_t *cond, FAR pthread_mutex_t *mutex)
 
   /* Make sure that the caller holds the mutex */
 
-  else if (mutex->pid != (int)getpid())
+  else if (PTHREAD_MUTEX_HOLDER(mutex) != (int)getpid())
     {
       ret = EPERM;
     }
@@ -113,8 +115,12 @@ int pthread_cond_wait(FAR pthread_cond_t *cond, FAR pthread_mutex_t *mutex)
       sdbg("Give up mutex / take cond\n");
 
       sched_lock();
+#ifdef CONFIG_MUTEX_FASTPATH
+      ret = pthread_mutex_give(mutex);
+#else
       mutex->pid = 0;
       ret = pthread_givesemaphore((sem_t*)&mutex->sem);
+#endif
 
       /* Take the semaphore */
 
@@ -124,11 +130,15 @@ int pthread_cond_wait(FAR pthread_cond_t *cond, FAR pthread_mutex_t *mutex)
       /* Reacquire the mutex */
 
       sdbg("Reacquire mutex...\n");
+#ifdef CONFIG_MUTEX_FASTPATH
+      ret |= pthread_mutex_take(mutex);
+#else
       ret |= pthread_takesemaphore((sem_t*)&mutex->sem);
       if (!ret)
         {
           mutex->pid = getpid();;
         }
+#endif
     }
 
   sdbg("Returning %d\n", ret);
@@ -167,7 +167,7 @@ static inline void pthread_addjoininfo(FAR struct task_group_s *group,
 
 static void pthread_start(void)
 {
-  FAR struct pthread_tcb_s *ptcb = (FAR struct pthread_tcb_s*)g_readytorun.head;
+  FAR struct pthread_tcb_s *ptcb = (FAR struct pthread_tcb_s *)this_task();
   FAR struct task_group_s *group = ptcb->cmn.group;
   FAR struct join_s *pjoin = (FAR struct join_s*)ptcb->joininfo;
   pthread_addr_t exit_status;
@@ -230,6 +230,7 @@ int pthread_create(FAR pthread_t *thread, FAR pthread_attr_t *attr,
 {
   FAR struct pthread_tcb_s *ptcb;
   FAR struct join_s *pjoin;
+  irqstate_t flags;
   int priority;
 #if CONFIG_RR_INTERVAL > 0
   int policy;
@@ -273,7 +274,7 @@ int pthread_create(FAR pthread_t *thread, FAR pthread_attr_t *attr,
    */
 
 #ifdef CONFIG_ADDRENV
-  ret = up_addrenv_share((FAR const struct tcb_s *)g_readytorun.head,
+  ret = up_addrenv_share(this_task(),
                          (FAR struct tcb_s *)ptcb);
   if (ret < 0)
     {
@@ -358,6 +359,17 @@ int pthread_create(FAR pthread_t *thread, FAR pthread_attr_t *attr,
 
   pthread_argsetup(ptcb, arg);
 
+#ifdef CONFIG_SMP
+  /* Restrict the new thread to the CPUs selected in the attributes.  An
+   * empty CPU set means that the thread may run on any CPU.
+   */
+
+  if ((attr->affinity & SCHED_ALL_CPUS) != 0)
+    {
+      ptcb->cmn.affinity = attr->affinity & SCHED_ALL_CPUS;
+    }
+#endif
+
   /* Join the parent's task group */
 
 #ifdef HAVE_TASK_GROUP
@@ -381,7 +393,7 @@ int pthread_create(FAR pthread_t *thread, FAR pthread_attr_t *attr,
   if (policy == SCHED_RR)
     {
       ptcb->cmn.flags    |= TCB_FLAG_ROUND_ROBIN;
-      ptcb->cmn.timeslice = CONFIG_RR_INTERVAL / MSEC_PER_TICK;
+      ptcb->cmn.timeslice = MSEC2TICK(CONFIG_RR_INTERVAL);
     }
 #endif
 
@@ -435,7 +447,10 @@ int pthread_create(FAR pthread_t *thread, FAR pthread_attr_t *attr,
   else
     {
       sched_unlock();
+
+      flags = irqsave();
       dq_rem((FAR dq_entry_t*)ptcb, (dq_queue_t*)&g_inactivetasks);
+      irqrestore(flags);
       (void)sem_destroy(&pjoin->data_sem);
       (void)sem_destroy(&pjoin->exit_sem);
 
@@ -111,7 +111,7 @@
 int pthread_key_create(FAR pthread_key_t *key, CODE void (*destructor)(void*))
 {
 #if CONFIG_NPTHREAD_KEYS > 0
-  FAR struct tcb_s *rtcb = (FAR struct tcb_s*)g_readytorun.head;
+  FAR struct tcb_s *rtcb = this_task();
   FAR struct task_group_s *group = rtcb->group;
   int ret = EAGAIN;
 
@@ -1,7 +1,7 @@
 /****************************************************************************
- * net/uip/uip_tcpreadahead.c
+ * sched/pthread_mutexgive.c
  *
- *   Copyright (C) 2007-2009, 2013-2014 Gregory Nutt. All rights reserved.
+ *   Copyright (C) 2014 Gregory Nutt. All rights reserved.
  *   Author: Gregory Nutt <gnutt@nuttx.org>
  *
  * Redistribution and use in source and binary forms, with or without
@@ -37,40 +37,36 @@
  * Included Files
  ****************************************************************************/
 
-#include <nuttx/net/uip/uipopt.h>
-#if defined(CONFIG_NET) && defined(CONFIG_NET_TCP) && defined(CONFIG_NET_TCP_READAHEAD)
+#include <nuttx/config.h>
 
-#include <queue.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <errno.h>
 #include <debug.h>
 
-#include <nuttx/net/uip/uip.h>
+#include <nuttx/arch.h>
+#include <nuttx/pthread.h>
 
-#include "uip_internal.h"
+#include "pthread_internal.h"
+
+#ifdef CONFIG_MUTEX_FASTPATH
 
 /****************************************************************************
- * Private Types
+ * Definitions
  ****************************************************************************/
 
-/* Package all globals used by this logic into a structure */
-
-struct readahead_s
-{
-  /* This is the list of available write buffers */
-
-  sq_queue_t freebuffers;
-
-  /* These are the pre-allocated write buffers */
-
-  struct uip_readahead_s buffers[CONFIG_NET_NTCP_READAHEAD_BUFFERS];
-};
-
 /****************************************************************************
- * Private Data
+ * Private Type Declarations
  ****************************************************************************/
 
-/* This is the state of the global read-ahead resource */
+/****************************************************************************
+ * Global Variables
+ ****************************************************************************/
 
-static struct readahead_s g_readahead;
+/****************************************************************************
+ * Private Variables
+ ****************************************************************************/
 
 /****************************************************************************
  * Private Functions
@@ -81,63 +77,80 @@ static struct readahead_s g_readahead;
  ****************************************************************************/
 
 /****************************************************************************
- * Function: uip_tcpreadahead_init
+ * Name: pthread_mutex_give
  *
  * Description:
- *   Initialize the list of free read-ahead buffers
+ *   The OS part of pthread_mutex_unlock():  Release a mutex that the OS
+ *   knows about because some other thread waited for it, waking up the
+ *   highest priority waiter.  Also handles a mutex that was locked by the
+ *   fast path so that the OS may use it for any mutex that the caller
+ *   holds (see pthread_cond_wait()).
+ *
+ * Parameters:
+ *   mutex - A reference to the mutex to be released.
+ *
+ * Return Value:
+ *   0 on success or an errno value on failure.
  *
  * Assumptions:
- *   Called once early initialization.
  *
  ****************************************************************************/
 
-void uip_tcpreadahead_init(void)
+int pthread_mutex_give(FAR pthread_mutex_t *mutex)
 {
-  int i;
+  FAR volatile int *lockword;
+  irqstate_t flags;
+  int holder;
+  int ret = OK;
+
+  sdbg("mutex=0x%p\n", mutex);
 
-  sq_init(&g_readahead.freebuffers);
-  for (i = 0; i < CONFIG_NET_NTCP_READAHEAD_BUFFERS; i++)
+  if (!mutex)
     {
-      sq_addfirst(&g_readahead.buffers[i].rh_node, &g_readahead.freebuffers);
+      return EINVAL;
     }
-}
 
-/****************************************************************************
- * Function: uip_tcpreadahead_alloc
- *
- * Description:
- *   Allocate a TCP read-ahead buffer by taking a pre-allocated buffer from
- *   the free list.  This function is called from TCP logic when new,
- *   incoming TCP data is received but there is no user logic recving the
- *   the data.  Note: kmalloc() cannot be used because this function is
- *   called from interrupt level.
- *
- * Assumptions:
- *   Called from interrupt level with interrupts disabled.
- *
- ****************************************************************************/
+  lockword = (FAR volatile int *)&mutex->pid;
 
-FAR struct uip_readahead_s *uip_tcpreadahead_alloc(void)
-{
-  return (FAR struct uip_readahead_s*)sq_remfirst(&g_readahead.freebuffers);
-}
+  /* Only the holder changes a locked mutex without interrupts disabled and
+   * the holder is us.
+   */
 
-/****************************************************************************
- * Function: uip_tcpreadahead_release
- *
- * Description:
- *   Release a TCP read-ahead buffer by returning the buffer to the free list.
- *   This function is called from user logic after it is consumed the buffered
- *   data.
- *
- * Assumptions:
- *   Called from user logic BUT with interrupts disabled.
- *
- ****************************************************************************/
+  flags = irqsave();
+  holder = *lockword;
 
-void uip_tcpreadahead_release(FAR struct uip_readahead_s *readahead)
-{
-  sq_addfirst(&readahead->rh_node, &g_readahead.freebuffers);
+  /* Does the calling thread hold the mutex? */
+
+  if ((holder & ~PTHREAD_MUTEX_CONTENDED) != (int)getpid())
+    {
+      sdbg("Holder=%d returning EPERM\n", holder);
+      ret = EPERM;
+    }
+
+  /* Does the OS know about it?  If not, the semaphore was never taken. */
+
+  else if ((holder & PTHREAD_MUTEX_CONTENDED) == 0)
+    {
+      *lockword = 0;
+    }
+  else
+    {
+      /* If there are waiters, the semaphore will go to the highest priority
+       * one.  Keep the mutex marked contended until it has recorded itself
+       * as the holder so that the fast path cannot steal the mutex.
+       */
+
+      *lockword = mutex->sem.semcount < 0 ? PTHREAD_MUTEX_CONTENDED : 0;
+      if (pthread_givesemaphore((FAR sem_t *)&mutex->sem) != OK)
+        {
+          ret = EINVAL;
+        }
+    }
+
+  irqrestore(flags);
+
+  sdbg("Returning %d\n", ret);
+  return ret;
 }
 
-#endif /* CONFIG_NET && CONFIG_NET_TCP && CONFIG_NET_TCP_READAHEAD */
+#endif /* CONFIG_MUTEX_FASTPATH */
@@ -0,0 +1,206 @@
+/****************************************************************************
+ * sched/pthread_mutextake.c
+ *
+ *   Copyright (C) 2014 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <errno.h>
+#include <debug.h>
+
+#include <nuttx/arch.h>
+#include <nuttx/spinlock.h>
+#include <nuttx/pthread.h>
+
+#include "os_internal.h"
+#include "sem_internal.h"
+#include "pthread_internal.h"
+
+#ifdef CONFIG_MUTEX_FASTPATH
+
+/****************************************************************************
+ * Definitions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Private Type Declarations
+ ****************************************************************************/
+
+/****************************************************************************
+ * Global Variables
+ ****************************************************************************/
+
+/****************************************************************************
+ * Private Variables
+ ****************************************************************************/
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: pthread_mutex_take
+ *
+ * Description:
+ *   The OS part of pthread_mutex_lock():  Wait until the mutex becomes
+ *   available, then lock it.  This is called from the C library when the
+ *   fast path failed.  Recursive and error checking mutexes are handled by
+ *   the caller.
+ *
+ *   While a mutex is locked by the fast path, the OS knows nothing about
+ *   the holder and the mutex semaphore still has its initial count of one.
+ *   Before waiting, the first waiter takes that count on behalf of the
+ *   holder and marks the mutex PTHREAD_MUTEX_CONTENDED.  The holder then
+ *   is a holder of the semaphore, just as if it had locked the mutex with
+ *   sem_wait(), and will be boosted by priority inheritance.  It also has
+ *   to release the mutex with pthread_mutex_give() because its fast path
+ *   compare-and-swap can no longer succeed.
+ *
+ * Parameters:
+ *   mutex - A reference to the mutex to be locked.
+ *
+ * Return Value:
+ *   0 on success or an errno value on failure.
+ *
+ * Assumptions:
+ *
+ ****************************************************************************/
+
+int pthread_mutex_take(FAR pthread_mutex_t *mutex)
+{
+  FAR volatile int *lockword;
+  FAR struct tcb_s *htcb;
+  irqstate_t flags;
+  int mypid = (int)getpid();
+  int holder;
+  int ret = OK;
+
+  sdbg("mutex=0x%p\n", mutex);
+
+  if (!mutex)
+    {
+      return EINVAL;
+    }
+
+  lockword = (FAR volatile int *)&mutex->pid;
+
+  /* The holder may still release the mutex with its fast path until the
+   * mutex is marked as contended.  Everything else happens with interrupts
+   * disabled.
+   */
+
+  flags = irqsave();
+  for (;;)
+    {
+      holder = *lockword;
+
+      /* Has the mutex been released in the meantime? */
+
+      if (holder == 0)
+        {
+          if (up_cmpxchg(lockword, 0, mypid))
+            {
+              break;
+            }
+
+          continue;
+        }
+
+      /* Does this task already hold the mutex? */
+
+      if ((holder & ~PTHREAD_MUTEX_CONTENDED) == mypid)
+        {
+          sdbg("Returning EDEADLK\n");
+          ret = EDEADLK;
+          break;
+        }
+
+      /* Was the mutex locked by the fast path? */
+
+      if ((holder & PTHREAD_MUTEX_CONTENDED) == 0)
+        {
+          /* Yes.. take the semaphore count on behalf of the holder.  Try
+           * again if the holder got in first and released the mutex.
+           */
+
+          if (!up_cmpxchg(lockword, holder, holder | PTHREAD_MUTEX_CONTENDED))
+            {
+              continue;
+            }
+
+          DEBUGASSERT(mutex->sem.semcount == 1);
+          mutex->sem.semcount--;
+
+          htcb = sched_gettcb((pid_t)holder);
+          if (htcb)
+            {
+              sem_addholder_tcb(htcb, (FAR sem_t *)&mutex->sem);
+            }
+        }
+
+      /* Wait for the holder to give the semaphore to us.  The holder is
+       * boosted while we wait if priority inheritance is enabled.
+       */
+
+      if (pthread_takesemaphore((FAR sem_t *)&mutex->sem) != OK)
+        {
+          ret = EINVAL;
+        }
+      else
+        {
+          /* The OS knows that we hold the mutex */
+
+          *lockword = mypid | PTHREAD_MUTEX_CONTENDED;
+        }
+
+      break;
+    }
+
+  irqrestore(flags);
+
+  sdbg("Returning %d\n", ret);
+  return ret;
+}
+
+#endif /* CONFIG_MUTEX_FASTPATH */
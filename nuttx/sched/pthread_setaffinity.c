@@ -0,0 +1,96 @@
+/****************************************************************************
+ * sched/pthread_setaffinity.c
+ *
+ *   Copyright (C) 2014 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <pthread.h>
+#include <sched.h>
+#include <errno.h>
+#include <debug.h>
+
+#include "pthread_internal.h"
+
+#ifdef CONFIG_SMP
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: pthread_setaffinity_np
+ *
+ * Description:
+ *   The pthread_setaffinity_np() function sets the CPU affinity mask of
+ *   the thread thread to the CPU set pointed to by cpuset.  If the call is
+ *   successful, and the thread is not currently running on one of the CPUs
+ *   in cpuset, then it is migrated to one of those CPUs.
+ *
+ * Parameters:
+ *   thread     - The ID of thread whose affinity set will be modified.
+ *   cpusetsize - Size of cpuset.  MUST be sizeof(cpu_set_t).
+ *   cpuset     - The location of the new affinity set.
+ *
+ * Return Value:
+ *   0 if successful.  Otherwise, an error code (see sched_setaffinity()).
+ *
+ ****************************************************************************/
+
+int pthread_setaffinity_np(pthread_t thread, size_t cpusetsize,
+                           FAR const cpu_set_t *cpuset)
+{
+  int ret;
+
+  sdbg("thread ID=%d cpusetsize=%d cpuset=%p\n",
+       (int)thread, (int)cpusetsize, cpuset);
+
+  /* Let sched_setaffinity do all of the work */
+
+  ret = sched_setaffinity((pid_t)thread, cpusetsize, cpuset);
+  if (ret < 0)
+    {
+      /* If sched_setaffinity() fails, return the errno */
+
+      ret = get_errno();
+    }
+
+  return ret;
+}
+
+#endif /* CONFIG_SMP */
@@ -90,6 +90,8 @@
 
 void sched_addblocked(FAR struct tcb_s *btcb, tstate_t task_state)
 {
+  FAR dq_queue_t *list;
+
   /* Make sure that we received a valid blocked state */
 
   ASSERT(task_state >= FIRST_BLOCKED_STATE &&
@@ -115,6 +117,16 @@ void sched_addblocked(FAR struct tcb_s *btcb, tstate_t task_state)
                  (FAR dq_queue_t*)g_tasklisttable[task_state].list);
     }
 
+  /* If the task is waiting on a semaphore or message queue, then also
+   * add it to the wait list of that object.
+   */
+
+  list = sched_waitlist(btcb, task_state);
+  if (list)
+    {
+      sched_addwaiter(btcb, list);
+    }
+
   /* Make sure the TCB's state corresponds to the list */
 
   btcb->task_state = task_state;
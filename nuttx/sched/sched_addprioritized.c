@@ -99,6 +99,9 @@ bool sched_addprioritized(FAR struct tcb_s *tcb, DSEG dq_queue_t *list)
 {
   FAR struct tcb_s *next;
   FAR struct tcb_s *prev;
+#ifdef CONFIG_SCHED_READYBITMAP
+  FAR struct priobitmap_s *bitmap = sched_priobitmap(list);
+#endif
   uint8_t sched_priority = tcb->sched_priority;
   bool ret = false;
 
@@ -108,11 +111,22 @@ bool sched_addprioritized(FAR struct tcb_s *tcb, DSEG dq_queue_t *list)
 
   /* Search the list to find the location to insert the new Tcb.
    * Each is list is maintained in ascending sched_priority order.
+   * The ready-to-run and pending lists are indexed by priority so that
+   * no search is necessary.
    */
 
-  for (next = (FAR struct tcb_s*)list->head;
-      (next && sched_priority <= next->sched_priority);
-      next = next->flink);
+#ifdef CONFIG_SCHED_READYBITMAP
+  if (bitmap)
+    {
+      next = sched_bitmap_next(bitmap, list, sched_priority);
+    }
+  else
+#endif
+    {
+      for (next = (FAR struct tcb_s*)list->head;
+          (next && sched_priority <= next->sched_priority);
+          next = next->flink);
+    }
 
   /* Add the tcb to the spot found in the list.  Check if the tcb
    * goes at the end of the list. NOTE:  This could only happen if list
@@ -170,6 +184,12 @@ bool sched_addprioritized(FAR struct tcb_s *tcb, DSEG dq_queue_t *list)
         }
     }
 
+#ifdef CONFIG_SCHED_READYBITMAP
+  /* Then update the priority index of the list (if any) */
+
+  sched_bitmap_add(bitmap, tcb);
+#endif
+
   return ret;
 }
 
@@ -98,11 +98,20 @@
  *
  ****************************************************************************/
 
+#ifndef CONFIG_SMP
 bool sched_addreadytorun(FAR struct tcb_s *btcb)
 {
-  FAR struct tcb_s *rtcb = (FAR struct tcb_s*)g_readytorun.head;
+  FAR struct tcb_s *rtcb = this_task();
   bool ret;
 
+#if CONFIG_RR_INTERVAL > 0
+  /* In the tick-less mode, the time slice of the current task must be
+   * brought up to date before the head of the list can change.
+   */
+
+  sched_timer_cancel();
+#endif
+
   /* Check if pre-emption is disabled for the current running task and if
    * the new ready-to-run task would cause the current running task to be
    * preempted.
@@ -145,5 +154,28 @@ bool sched_addreadytorun(FAR struct tcb_s *btcb)
       ret = false;
     }
 
+#if CONFIG_RR_INTERVAL > 0
+  sched_timer_resume();
+#endif
   return ret;
 }
+
+#else /* !CONFIG_SMP */
+bool sched_addreadytorun(FAR struct tcb_s *btcb)
+{
+  /* In the SMP case, there is no g_pendingtasks list.  The new task is
+   * always added to the g_readytorun list; a CPU whose running task has
+   * disabled pre-emption simply keeps that task when the tasks are
+   * re-assigned to the CPUs.
+   */
+
+  sched_addprioritized(btcb, (FAR dq_queue_t*)&g_readytorun);
+  btcb->task_state = TSTATE_TASK_READYTORUN;
+
+  /* Re-assign the tasks to the CPUs.  This returns true if the running
+   * task of this CPU has changed.
+   */
+
+  return sched_smp_assign();
+}
+#endif /* !CONFIG_SMP */
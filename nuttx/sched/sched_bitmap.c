@@ -0,0 +1,252 @@
+/************************************************************************
+ * sched/sched_bitmap.c
+ *
+ *   Copyright (C) 2014 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ************************************************************************/
+
+/************************************************************************
+ * Included Files
+ ************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <queue.h>
+#include <assert.h>
+
+#include "os_internal.h"
+
+#ifdef CONFIG_SCHED_READYBITMAP
+
+/************************************************************************
+ * Pre-processor Definitions
+ ************************************************************************/
+
+/************************************************************************
+ * Private Type Declarations
+ ************************************************************************/
+
+/************************************************************************
+ * Global Variables
+ ************************************************************************/
+
+/* Priority indices of the g_readytorun and g_pendingtasks lists */
+
+struct priobitmap_s g_readybitmap;
+struct priobitmap_s g_pendingbitmap;
+
+/************************************************************************
+ * Private Variables
+ ************************************************************************/
+
+/* De Bruijn sequence lookup table used to find the lowest set bit of a
+ * 32-bit word with one multiplication and no loops.
+ */
+
+static const uint8_t g_debruijn[32] =
+{
+   0,  1, 28,  2, 29, 14, 24,  3, 30, 22, 20, 15, 25, 17,  4,  8,
+  31, 27, 13, 23, 21, 19, 16,  7, 26, 12, 18,  6, 11,  5, 10,  9
+};
+
+/************************************************************************
+ * Private Functions
+ ************************************************************************/
+
+/************************************************************************
+ * Name: sched_lowestbit
+ *
+ * Description:
+ *   Return the index of the lowest set bit of a non-zero word.
+ *
+ ************************************************************************/
+
+static inline int sched_lowestbit(uint32_t word)
+{
+  return g_debruijn[((word & -word) * 0x077cb531) >> 27];
+}
+
+/************************************************************************
+ * Public Functions
+ ************************************************************************/
+
+/************************************************************************
+ * Name: sched_bitmap_next
+ *
+ * Description:
+ *   Find the place in an indexed, prioritized list where a task of the
+ *   given priority must be inserted:  After every task with the same or
+ *   higher priority.  That is just after the last task of the lowest
+ *   priority that is present in the list and not lower than
+ *   sched_priority.
+ *
+ * Inputs:
+ *   bitmap - The priority index of the list
+ *   list - The prioritized list
+ *   sched_priority - The priority of the task to be inserted
+ *
+ * Return Value:
+ *   The TCB that the new task must be inserted before or NULL if the
+ *   new task goes at the end of the list.
+ *
+ * Assumptions:
+ * - The caller has established a critical section before
+ *   calling this function.
+ *
+ ************************************************************************/
+
+FAR struct tcb_s *sched_bitmap_next(FAR struct priobitmap_s *bitmap,
+                                    DSEG dq_queue_t *list,
+                                    uint8_t sched_priority)
+{
+  uint32_t word;
+  int ndx = sched_priority >> 5;
+
+  /* Look for a priority >= sched_priority in the same word of the map */
+
+  word = bitmap->map[ndx] & (0xffffffff << (sched_priority & 31));
+  if (word == 0)
+    {
+      /* None.  Look for the next non-zero word of the map */
+
+      word = bitmap->summary & ~((2 << ndx) - 1);
+      if (word == 0)
+        {
+          /* There is no task of the same or higher priority in the
+           * list.  The new task goes at the head of the list.
+           */
+
+          return (FAR struct tcb_s *)list->head;
+        }
+
+      ndx  = sched_lowestbit(word);
+      word = bitmap->map[ndx];
+    }
+
+  /* The new task goes just after the last task of that priority */
+
+  return bitmap->tail[(ndx << 5) + sched_lowestbit(word)]->flink;
+}
+
+/************************************************************************
+ * Name: sched_bitmap_add
+ *
+ * Description:
+ *   Record a task that was just added to an indexed, prioritized list.
+ *   The task must follow all other tasks of the same priority in the
+ *   list.
+ *
+ * Inputs:
+ *   bitmap - The priority index of the list
+ *   tcb - The TCB of the task that was added to the list
+ *
+ * Return Value:
+ *   None
+ *
+ * Assumptions:
+ * - The caller has established a critical section before
+ *   calling this function.
+ *
+ ************************************************************************/
+
+void sched_bitmap_add(FAR struct priobitmap_s *bitmap,
+                      FAR struct tcb_s *tcb)
+{
+  uint8_t sched_priority = tcb->sched_priority;
+  int ndx = sched_priority >> 5;
+
+  if (bitmap)
+    {
+      DEBUGASSERT(tcb->flink == NULL ||
+                  tcb->flink->sched_priority < sched_priority);
+
+      bitmap->tail[sched_priority] = tcb;
+      bitmap->map[ndx]            |= (uint32_t)1 << (sched_priority & 31);
+      bitmap->summary             |= (uint32_t)1 << ndx;
+    }
+}
+
+/************************************************************************
+ * Name: sched_bitmap_remove
+ *
+ * Description:
+ *   Update the index of a prioritized list before a task is removed from
+ *   the list.  This must be called while the task is still in the list
+ *   and before its priority is changed.
+ *
+ * Inputs:
+ *   bitmap - The priority index of the list (may be NULL)
+ *   tcb - The TCB of the task that is about to be removed
+ *
+ * Return Value:
+ *   None
+ *
+ * Assumptions:
+ * - The caller has established a critical section before
+ *   calling this function.
+ *
+ ************************************************************************/
+
+void sched_bitmap_remove(FAR struct priobitmap_s *bitmap,
+                         FAR struct tcb_s *tcb)
+{
+  FAR struct tcb_s *prev;
+  uint8_t sched_priority = tcb->sched_priority;
+  int ndx = sched_priority >> 5;
+
+  /* Nothing changes unless the task is the last of its priority */
+
+  if (bitmap && bitmap->tail[sched_priority] == tcb)
+    {
+      prev = tcb->blink;
+      if (prev && prev->sched_priority == sched_priority)
+        {
+          /* The previous task is now the last of this priority */
+
+          bitmap->tail[sched_priority] = prev;
+        }
+      else
+        {
+          /* This was the only task of this priority */
+
+          bitmap->tail[sched_priority] = NULL;
+          bitmap->map[ndx] &= ~((uint32_t)1 << (sched_priority & 31));
+          if (bitmap->map[ndx] == 0)
+            {
+              bitmap->summary &= ~((uint32_t)1 << ndx);
+            }
+        }
+    }
+}
+
+#endif /* CONFIG_SCHED_READYBITMAP */
@@ -43,6 +43,8 @@
 #include <assert.h>
 
 #include <nuttx/arch.h>
+#include <nuttx/spinlock.h>
+
 #include "os_internal.h"
 
 /************************************************************************
@@ -83,6 +85,22 @@
  *   either calls  sched_unlock() (the appropriate number of times) or
  *   until it blocks itself.
  *
+ *   In the SMP case, tasks on the other CPUs continue to run but no other
+ *   task can disable pre-emption at the same time:  sched_lock() waits
+ *   until the task that holds the pre-emption lock (g_cpu_schedlock)
+ *   releases it.  Code that disables pre-emption to protect data is then
+ *   still mutually exclusive on all CPUs.
+ *
+ *   The exception is a call from within a critical section (irqsave()).
+ *   Waiting there would keep the holder out of its critical sections so
+ *   pre-emption is then only disabled on this CPU and there is NO
+ *   exclusion of the tasks on the other CPUs beyond that of the critical
+ *   section itself.  sched_unlock() must then be called before the
+ *   critical section is left, as in the irqsave(), sched_lock(), ...,
+ *   sched_unlock(), irqrestore() sequence of sem_post(), sem_wait() and
+ *   uip_lockedwait().  The architecture-specific irqrestore() asserts
+ *   this.
+ *
  * Inputs
  *   None
  *
@@ -93,7 +111,18 @@
 
 int sched_lock(void)
 {
-  struct tcb_s *rtcb = (struct tcb_s*)g_readytorun.head;
+  struct tcb_s *rtcb;
+#ifdef CONFIG_SMP
+  irqstate_t flags;
+
+  /* Keep the task from moving to another CPU before this_task() is
+   * sampled.
+   */
+
+  flags = irqsave();
+#endif
+
+  rtcb = this_task();
 
   /* Check for some special cases:  (1) rtcb may be NULL only during
    * early boot-up phases, and (2) sched_lock() should have no
@@ -103,8 +132,35 @@ int sched_lock(void)
   if (rtcb && !up_interrupt_context())
     {
      ASSERT(rtcb->lockcount < MAX_LOCK_COUNT);
+
+#ifdef CONFIG_SMP
+     /* Take the pre-emption lock if this task does not already hold it.
+      * Wait outside of the critical section while the task on another CPU
+      * holds the lock.  The task may move to another CPU meanwhile.
+      */
+
+     if (rtcb->lockcount == 0 && rtcb->irqcount == 1)
+       {
+         while (g_cpu_schedlock >= 0 && g_cpu_schedlock != this_cpu())
+           {
+             irqrestore(flags);
+             while (g_cpu_schedlock >= 0)
+               {
+                 SP_DMB();
+               }
+
+             flags = irqsave();
+           }
+
+         g_cpu_schedlock = this_cpu();
+       }
+#endif
+
      rtcb->lockcount++;
     }
 
+#ifdef CONFIG_SMP
+  irqrestore(flags);
+#endif
   return OK;
 }
@@ -92,17 +92,29 @@
  *
  ************************************************************************/
 
+#ifndef CONFIG_SMP
 bool sched_mergepending(void)
 {
   FAR struct tcb_s *pndtcb;
   FAR struct tcb_s *pndnext;
   FAR struct tcb_s *rtrtcb;
   FAR struct tcb_s *rtrprev;
+#ifdef CONFIG_SCHED_READYBITMAP
+  int i;
+#endif
   bool ret = false;
 
+#if CONFIG_RR_INTERVAL > 0
+  /* In the tick-less mode, the time slice of the current task must be
+   * brought up to date before the head of the list can change.
+   */
+
+  sched_timer_cancel();
+#endif
+
   /* Initialize the inner search loop */
 
-  rtrtcb = (FAR struct tcb_s*)g_readytorun.head;
+  rtrtcb = this_task();
 
   /* Process every TCB in the g_pendingtasks list */
 
@@ -115,9 +127,18 @@ bool sched_mergepending(void)
        * order.
        */
 
+#ifdef CONFIG_SCHED_READYBITMAP
+      /* With the priority index, there is no need to search */
+
+      g_pendingbitmap.tail[pndtcb->sched_priority] = NULL;
+      rtrtcb = sched_bitmap_next(&g_readybitmap,
+                                 (FAR dq_queue_t*)&g_readytorun,
+                                 pndtcb->sched_priority);
+#else
       for (;
            (rtrtcb && pndtcb->sched_priority <= rtrtcb->sched_priority);
            rtrtcb = rtrtcb->flink);
+#endif
 
       /* Add the pndtcb to the spot found in the list.  Check if the
        * pndtcb goes at the ends of the g_readytorun list. This would be
@@ -158,6 +179,10 @@ bool sched_mergepending(void)
           pndtcb->task_state = TSTATE_TASK_READYTORUN;
         }
 
+#ifdef CONFIG_SCHED_READYBITMAP
+      sched_bitmap_add(&g_readybitmap, pndtcb);
+#endif
+
       /* Set up for the next time through */
 
       rtrtcb = pndtcb;
@@ -168,5 +193,31 @@ bool sched_mergepending(void)
   g_pendingtasks.head = NULL;
   g_pendingtasks.tail = NULL;
 
+#ifdef CONFIG_SCHED_READYBITMAP
+  /* And its priority index (the tail[] entries were cleared above) */
+
+  g_pendingbitmap.summary = 0;
+  for (i = 0; i < PRIOBITMAP_NWORDS; i++)
+    {
+      g_pendingbitmap.map[i] = 0;
+    }
+#endif
+
+#if CONFIG_RR_INTERVAL > 0
+  sched_timer_resume();
+#endif
+
   return ret;
 }
+
+#else /* !CONFIG_SMP */
+bool sched_mergepending(void)
+{
+  /* In the SMP case, tasks are never held in g_pendingtasks.  But this is
+   * called when pre-emption is re-enabled so the tasks must be re-assigned
+   * to the CPUs.
+   */
+
+  return sched_smp_assign();
+}
+#endif /* !CONFIG_SMP */
@@ -91,7 +91,7 @@
 #if CONFIG_RR_INTERVAL > 0
 static inline void sched_process_timeslice(void)
 {
-  FAR struct tcb_s *rtcb  = (FAR struct tcb_s*)g_readytorun.head;
+  FAR struct tcb_s *rtcb  = this_task();
 
   /* Check if the currently executing task uses round robin
    * scheduling.
@@ -115,7 +115,7 @@ static inline void sched_process_timeslice(void)
             {
               /* Reset the timeslice in any case. */
 
-              rtcb->timeslice = CONFIG_RR_INTERVAL / MSEC_PER_TICK;
+              rtcb->timeslice = MSEC2TICK(CONFIG_RR_INTERVAL);
 
               /* We know we are at the head of the ready to run
                * prioritized list.  We must be the highest priority
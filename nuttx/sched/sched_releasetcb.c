@@ -62,12 +62,15 @@
 static void sched_releasepid(pid_t pid)
 {
   int hash_ndx = PIDHASH(pid);
+  irqstate_t flags;
 
-  /* Make any pid associated with this hash available.  Note: 
-   * no special precautions need be taken here because the
-   * following action is atomic
+  /* Make any pid associated with this hash available.  This is done
+   * within a critical section because task_assignpid() may use
+   * g_pidhash[] on another CPU at the same time (and for the update of
+   * the CPU load total).
    */
 
+  flags = irqsave();
   g_pidhash[hash_ndx].tcb   = NULL;
   g_pidhash[hash_ndx].pid   = INVALID_PROCESS_ID;
 
@@ -80,6 +83,8 @@ static void sched_releasepid(pid_t pid)
   g_cpuload_total          -= g_pidhash[hash_ndx].ticks;
   g_pidhash[hash_ndx].ticks = 0;
 #endif
+
+  irqrestore(flags);
 }
 
 /************************************************************************
@@ -90,6 +90,7 @@
  *
  ****************************************************************************/
 
+#ifndef CONFIG_SMP
 bool sched_removereadytorun(FAR struct tcb_s *rtcb)
 {
   bool ret = false;
@@ -104,6 +105,14 @@ bool sched_removereadytorun(FAR struct tcb_s *rtcb)
 
       ASSERT(rtcb->flink != NULL);
 
+#if CONFIG_RR_INTERVAL > 0
+      /* In the tick-less mode, the time slice of the current task must be
+       * brought up to date before the head of the list changes.
+       */
+
+      sched_timer_cancel();
+#endif
+
       /* Inform the instrumentation layer that we are switching tasks */
 
       sched_note_switch(rtcb, rtcb->flink);
@@ -112,10 +121,38 @@ bool sched_removereadytorun(FAR struct tcb_s *rtcb)
       ret = true;
     }
 
-  /* Remove the TCB from the ready-to-run list */
+  /* Remove the TCB from the ready-to-run list and its priority index */
 
+  sched_bitmap_remove(sched_priobitmap(&g_readytorun), rtcb);
   dq_rem((FAR dq_entry_t*)rtcb, (dq_queue_t*)&g_readytorun);
 
   rtcb->task_state = TSTATE_TASK_INVALID;
+
+#if CONFIG_RR_INTERVAL > 0
+  if (ret)
+    {
+      sched_timer_resume();
+    }
+#endif
+
   return ret;
 }
+
+#else /* CONFIG_SMP */
+bool sched_removereadytorun(FAR struct tcb_s *rtcb)
+{
+  /* Remove the TCB from the ready-to-run list and its priority index */
+
+  sched_bitmap_remove(sched_priobitmap(&g_readytorun), rtcb);
+  dq_rem((FAR dq_entry_t*)rtcb, (dq_queue_t*)&g_readytorun);
+
+  rtcb->task_state = TSTATE_TASK_INVALID;
+
+  /* Re-assign the tasks to the CPUs.  If the task was running on this CPU,
+   * then this CPU will get a new running task.  If it was running on
+   * another CPU, that CPU is asked to re-schedule.
+   */
+
+  return sched_smp_assign();
+}
+#endif /* !CONFIG_SMP */
@@ -77,7 +77,7 @@
 
 FAR struct tcb_s *sched_self(void)
 {
-  return (FAR struct tcb_s*)g_readytorun.head;
+  return this_task();
 }
 
 
@@ -0,0 +1,140 @@
+/****************************************************************************
+ * sched/sched_setaffinity.c
+ *
+ *   Copyright (C) 2014 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <sched.h>
+#include <errno.h>
+
+#include <nuttx/arch.h>
+
+#include "os_internal.h"
+
+#ifdef CONFIG_SMP
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: sched_setaffinity
+ *
+ * Description:
+ *   sched_setaffinity() sets the CPU affinity mask of the thread whose ID
+ *   is pid to the value specified by mask.  If pid is zero, then the
+ *   calling thread is used.  The argument cpusetsize is the length (in
+ *   bytes) of the data pointed to by mask.  Normally this argument would
+ *   be specified as sizeof(cpu_set_t).
+ *
+ *   If the thread specified by pid is not currently running on one of the
+ *   CPUs specified in mask, then that thread is migrated to one of the
+ *   CPUs specified in mask.
+ *
+ * Inputs:
+ *   pid        - The ID of thread whose affinity set will be modified.
+ *   cpusetsize - Size of mask.  MUST be sizeof(cpu_set_t).
+ *   mask       - The location of the new affinity set.
+ *
+ * Return Value:
+ *   Zero (OK) if successful.  Otherwise, ERROR (-1) is returned, and
+ *   errno is set appropriately:
+ *
+ *      EINVAL The affinity bit mask mask is NULL, it contains no CPU that
+ *             is physically on the system, or cpusetsize is too small.
+ *      ESRCH  The task whose ID is pid could not be found.
+ *
+ ****************************************************************************/
+
+int sched_setaffinity(pid_t pid, size_t cpusetsize,
+                      FAR const cpu_set_t *mask)
+{
+  FAR struct tcb_s *tcb;
+  irqstate_t flags;
+  int errcode;
+
+  if (mask == NULL || cpusetsize < sizeof(cpu_set_t) ||
+      (*mask & SCHED_ALL_CPUS) == 0)
+    {
+      errcode = EINVAL;
+      goto errout;
+    }
+
+  /* Verify that the PID corresponds to a real task */
+
+  flags = irqsave();
+  if (!pid)
+    {
+      tcb = this_task();
+    }
+  else
+    {
+      tcb = sched_gettcb(pid);
+    }
+
+  if (!tcb)
+    {
+      irqrestore(flags);
+      errcode = ESRCH;
+      goto errout;
+    }
+
+  /* Set the new affinity.  If the task is in the ready-to-run list, then
+   * the tasks must be re-assigned to the CPUs:  The task may have to move
+   * to a different CPU now.  This is done just as if the priority of the
+   * task had changed.
+   */
+
+  tcb->affinity = *mask & SCHED_ALL_CPUS;
+
+  if (tcb->task_state == TSTATE_TASK_RUNNING ||
+      tcb->task_state == TSTATE_TASK_READYTORUN)
+    {
+      up_reprioritize_rtr(tcb, tcb->sched_priority);
+    }
+
+  irqrestore(flags);
+  return OK;
+
+errout:
+  set_errno(errcode);
+  return ERROR;
+}
+
+#endif /* CONFIG_SMP */
@@ -103,7 +103,9 @@
 
 int sched_setpriority(FAR struct tcb_s *tcb, int sched_priority)
 {
-  FAR struct tcb_s *rtcb = (FAR struct tcb_s*)g_readytorun.head;
+#ifndef CONFIG_SMP
+  FAR struct tcb_s *rtcb = this_task();
+#endif
   tstate_t task_state;
   irqstate_t saved_state;
 
@@ -127,6 +129,18 @@ int sched_setpriority(FAR struct tcb_s *tcb, int sched_priority)
   task_state = tcb->task_state;
   switch (task_state)
     {
+#ifdef CONFIG_SMP
+      /* CASE 1 and 2 in the SMP case.  The task may be running on any
+       * CPU and the change of its priority may change the task that runs
+       * on any CPU.  up_reprioritize_rtr() re-assigns the tasks to the
+       * CPUs and performs the context switch if one is needed.
+       */
+
+      case TSTATE_TASK_RUNNING:
+      case TSTATE_TASK_READYTORUN:
+        up_reprioritize_rtr(tcb, (uint8_t)sched_priority);
+        break;
+#else
       /* CASE 1. The task is running or ready-to-run and a context switch
        * may be caused by the re-prioritization 
        */
@@ -149,9 +163,13 @@ int sched_setpriority(FAR struct tcb_s *tcb, int sched_priority)
 
         else
           {
-            /* Change the task priority */
+            /* Change the task priority.  The task stays at the head of
+             * the list but its place in the priority index changes.
+             */
 
+            sched_bitmap_remove(sched_priobitmap(&g_readytorun), tcb);
             tcb->sched_priority = (uint8_t)sched_priority;
+            sched_bitmap_add(sched_priobitmap(&g_readytorun), tcb);
           }
         break;
 
@@ -191,6 +209,7 @@ int sched_setpriority(FAR struct tcb_s *tcb, int sched_priority)
             ASSERT(!sched_addreadytorun(tcb));
           }
         break;
+#endif
 
       /* CASE 3. The task is not in the ready to run list.  Changing its
        * Priority cannot effect the currently executing task.
@@ -204,6 +223,8 @@ int sched_setpriority(FAR struct tcb_s *tcb, int sched_priority)
           {
             /* Remove the TCB from the prioritized task list */
 
+            sched_bitmap_remove(sched_priobitmap(g_tasklisttable[task_state].list),
+                                tcb);
             dq_rem((FAR dq_entry_t*)tcb, (FAR dq_queue_t*)g_tasklisttable[task_state].list);
 
             /* Change the task priority */
@@ -215,6 +236,18 @@ int sched_setpriority(FAR struct tcb_s *tcb, int sched_priority)
              */
 
             sched_addprioritized(tcb, (FAR dq_queue_t*)g_tasklisttable[task_state].list);
+
+            /* Do the same in the wait list of the semaphore or message
+             * queue that the task is waiting for.
+             */
+
+            if (tcb->waitlist)
+              {
+                FAR dq_queue_t *list = tcb->waitlist;
+
+                sched_removewaiter(tcb);
+                sched_addwaiter(tcb, list);
+              }
           }
 
         /* CASE 3b. The task resides in a non-prioritized list. */
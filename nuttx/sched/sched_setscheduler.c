@@ -152,12 +152,14 @@ int sched_setscheduler(pid_t pid, int policy,
   /* Further, disable timer interrupts while we set up scheduling policy. */
 
   saved_state = irqsave();
+  sched_timer_cancel();
+
   if (policy == SCHED_RR)
     {
       /* Set round robin scheduling */
 
       tcb->flags    |= TCB_FLAG_ROUND_ROBIN;
-      tcb->timeslice = CONFIG_RR_INTERVAL / MSEC_PER_TICK;
+      tcb->timeslice = MSEC2TICK(CONFIG_RR_INTERVAL);
     }
   else
     {
@@ -167,6 +169,11 @@ int sched_setscheduler(pid_t pid, int policy,
       tcb->timeslice = 0;
     }
 
+  /* In the tick-less mode, the interval timer may need to be re-programmed
+   * for the new time slice.
+   */
+
+  sched_timer_resume();
   irqrestore(saved_state);
 #endif
 
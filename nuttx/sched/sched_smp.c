@@ -0,0 +1,342 @@
+/************************************************************************
+ * sched/sched_smp.c
+ *
+ *   Copyright (C) 2014 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ************************************************************************/
+
+/************************************************************************
+ * Included Files
+ ************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <queue.h>
+#include <assert.h>
+
+#include <nuttx/arch.h>
+#include <nuttx/spinlock.h>
+
+#include "os_internal.h"
+
+#ifdef CONFIG_SMP
+
+/************************************************************************
+ * Pre-processor Definitions
+ ************************************************************************/
+
+/************************************************************************
+ * Private Type Declarations
+ ************************************************************************/
+
+/************************************************************************
+ * Global Variables
+ ************************************************************************/
+
+/************************************************************************
+ * Private Variables
+ ************************************************************************/
+
+/************************************************************************
+ * Private Function Prototypes
+ ************************************************************************/
+
+/************************************************************************
+ * Private Functions
+ ************************************************************************/
+
+/************************************************************************
+ * Name: sched_smp_islocked
+ *
+ * Description:
+ *   Return true if tcb is the task running on cpu, it has disabled
+ *   pre-emption, and it is still in the g_readytorun list.
+ *
+ ************************************************************************/
+
+static inline bool sched_smp_islocked(FAR struct tcb_s *tcb, int cpu)
+{
+  return (tcb != NULL && tcb->lockcount > 0 && tcb->cpu == cpu &&
+          (tcb->task_state == TSTATE_TASK_RUNNING ||
+           tcb->task_state == TSTATE_TASK_READYTORUN));
+}
+
+/************************************************************************
+ * Public Functions
+ ************************************************************************/
+
+/************************************************************************
+ * Name: sched_smp_assign
+ *
+ * Description:
+ *   Decide which task each CPU should run.  The g_readytorun list is
+ *   walked in priority order and each task is given the first of the
+ *   still unassigned CPUs that it is allowed to run on, preferring the
+ *   CPU that it last ran on.  A task that is still executing on a CPU can
+ *   be assigned only to that CPU and a CPU whose running task has
+ *   disabled pre-emption keeps that task.
+ *
+ *   Only one task may hold the pre-emption lock (g_cpu_schedlock, see
+ *   sched_lock()).  The lock is released if its holder has blocked and
+ *   a task that has disabled pre-emption is not started while another
+ *   task holds the lock.
+ *
+ *   The new running task of this CPU is made current immediately.  The
+ *   other CPUs that need a different task are asked to re-schedule with
+ *   up_cpu_reschedule().
+ *
+ * Inputs:
+ *   None
+ *
+ * Return Value:
+ *   true if the running task of this CPU has changed.
+ *
+ * Assumptions:
+ *   Called within a critical section (irqsave()).
+ *
+ ************************************************************************/
+
+bool sched_smp_assign(void)
+{
+  FAR struct tcb_s *tcb;
+  cpu_set_t avail = 0;
+  cpu_set_t allowed;
+  int me = this_cpu();
+  int owner;
+  int cpu;
+
+  /* The holder of the pre-emption lock keeps it only while it runs */
+
+  owner = g_cpu_schedlock;
+  if (owner >= 0 && !sched_smp_islocked(g_runningtasks[owner], owner))
+    {
+      owner = -1;
+    }
+
+  /* Start with all of the CPUs that have been started.  A CPU whose
+   * running task has disabled pre-emption keeps that task.
+   */
+
+  for (cpu = 0; cpu < CONFIG_SMP_NCPUS; cpu++)
+    {
+      tcb = g_runningtasks[cpu];
+      if (sched_smp_islocked(tcb, cpu))
+        {
+          g_assignedtasks[cpu] = tcb;
+        }
+      else
+        {
+          g_assignedtasks[cpu] = NULL;
+          if (tcb != NULL)
+            {
+              avail |= ((cpu_set_t)1 << cpu);
+            }
+        }
+    }
+
+  /* Then hand out the remaining CPUs in priority order.  The IDLE task of
+   * each CPU is at the end of the list and may run only on its own CPU so
+   * every CPU gets a task.
+   */
+
+  for (tcb = (FAR struct tcb_s *)g_readytorun.head;
+       tcb != NULL && avail != 0;
+       tcb = tcb->flink)
+    {
+      allowed = tcb->affinity & avail;
+
+      if (g_runningtasks[tcb->cpu] == tcb)
+        {
+          /* The task is executing on tcb->cpu and its context has not been
+           * saved.  It cannot start on any other CPU.
+           */
+
+          allowed &= ((cpu_set_t)1 << tcb->cpu);
+        }
+      else if ((allowed & ((cpu_set_t)1 << tcb->cpu)) != 0)
+        {
+          /* Prefer the CPU that the task last ran on */
+
+          allowed = ((cpu_set_t)1 << tcb->cpu);
+        }
+
+      if (tcb->lockcount > 0 && owner >= 0)
+        {
+          /* The task resumes with pre-emption disabled.  It must wait
+           * while another task holds the pre-emption lock.
+           */
+
+          allowed = 0;
+        }
+
+      if (allowed != 0)
+        {
+          for (cpu = 0; (allowed & ((cpu_set_t)1 << cpu)) == 0; cpu++);
+
+          g_assignedtasks[cpu] = tcb;
+          avail &= ~((cpu_set_t)1 << cpu);
+
+          if (tcb->lockcount > 0 && owner < 0)
+            {
+              owner = cpu;
+            }
+        }
+    }
+
+  g_cpu_schedlock = owner;
+
+  /* Ask the other CPUs to pick up their new tasks */
+
+  for (cpu = 0; cpu < CONFIG_SMP_NCPUS; cpu++)
+    {
+      DEBUGASSERT(g_runningtasks[cpu] == NULL ||
+                  g_assignedtasks[cpu] != NULL);
+
+      if (cpu != me && g_assignedtasks[cpu] != g_runningtasks[cpu])
+        {
+          up_cpu_reschedule(cpu);
+        }
+    }
+
+  /* And pick up the new task of this CPU now */
+
+  return sched_smp_resume();
+}
+
+/************************************************************************
+ * Name: sched_smp_resume
+ *
+ * Description:
+ *   Make the task that sched_smp_assign() selected for this CPU the
+ *   running task of this CPU.  This is called from sched_smp_assign()
+ *   and by the architecture-specific handler of the inter-processor
+ *   interrupt sent by up_cpu_reschedule().
+ *
+ * Inputs:
+ *   None
+ *
+ * Return Value:
+ *   true if the running task of this CPU has changed and the caller
+ *   must switch to the context of this_task().
+ *
+ * Assumptions:
+ *   Called within a critical section (irqsave()).
+ *
+ ************************************************************************/
+
+bool sched_smp_resume(void)
+{
+  int me = this_cpu();
+  FAR struct tcb_s *rtcb = g_runningtasks[me];
+  FAR struct tcb_s *ntcb = g_assignedtasks[me];
+
+  if (ntcb == NULL || ntcb == rtcb)
+    {
+      return false;
+    }
+
+  /* A running task that has disabled pre-emption since the CPUs were
+   * assigned keeps the CPU.  The other task waits for the next
+   * assignment.
+   */
+
+  if (sched_smp_islocked(rtcb, me))
+    {
+      g_assignedtasks[me] = rtcb;
+      return false;
+    }
+
+  /* Inform the instrumentation layer that we are switching tasks */
+
+  sched_note_switch(rtcb, ntcb);
+
+  if (rtcb->task_state == TSTATE_TASK_RUNNING)
+    {
+      rtcb->task_state = TSTATE_TASK_READYTORUN;
+    }
+
+  ntcb->task_state = TSTATE_TASK_RUNNING;
+  ntcb->cpu        = me;
+
+  g_runningtasks[me] = ntcb;
+  return true;
+}
+
+/************************************************************************
+ * Name: sched_smp_stop
+ *
+ * Description:
+ *   Stop a task that is running on another CPU:  The task is moved to
+ *   the g_inactivetasks list and this function waits until the other
+ *   CPU has switched away from the task.  This is used before a task
+ *   that is running on another CPU is deleted or restarted.
+ *
+ * Inputs:
+ *   tcb - The TCB of the task to stop.
+ *
+ * Return Value:
+ *   None
+ *
+ * Assumptions:
+ *   Called with pre-emption disabled but NOT within a critical section:
+ *   The other CPU must be able to enter its critical section to handle
+ *   the re-schedule request.
+ *
+ ************************************************************************/
+
+void sched_smp_stop(FAR struct tcb_s *tcb)
+{
+  irqstate_t flags;
+  int cpu;
+
+  flags = irqsave();
+  if (tcb->task_state != TSTATE_TASK_RUNNING &&
+      tcb->task_state != TSTATE_TASK_READYTORUN)
+    {
+      irqrestore(flags);
+      return;
+    }
+
+  cpu = tcb->cpu;
+  up_block_task(tcb, TSTATE_TASK_INACTIVE);
+  irqrestore(flags);
+
+  /* Wait until the other CPU has saved the context of the task */
+
+  while (g_runningtasks[cpu] == tcb)
+    {
+      SP_DMB();
+    }
+}
+
+#endif /* CONFIG_SMP */
@@ -0,0 +1,406 @@
+/****************************************************************************
+ * sched/sched_timerexpiration.c
+ *
+ *   Copyright (C) 2014 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+#include <nuttx/compiler.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include <assert.h>
+
+#include <arch/irq.h>
+#include <nuttx/arch.h>
+#include <nuttx/clock.h>
+
+#include "os_internal.h"
+#include "wd_internal.h"
+#include "clock_internal.h"
+
+#ifdef CONFIG_SCHED_TICKLESS
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Private Type Declarations
+ ****************************************************************************/
+
+/****************************************************************************
+ * Public Variables
+ ****************************************************************************/
+
+/****************************************************************************
+ * Private Variables
+ ****************************************************************************/
+
+/* This is the system time (in ticks) when the watchdog and timeslice
+ * counts were last brought up to date.  All delays are relative to this
+ * time.
+ */
+
+static uint32_t g_timer_base;
+
+/* When this count is non-zero, the interval timer is not re-programmed.
+ * Timer updates are deferred until the outermost sched_timer_resume().
+ */
+
+static unsigned int g_timer_nesting;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name:  sched_timeslice
+ *
+ * Description:
+ *   Check if the currently executing task has exceeded its time slice.
+ *
+ * Inputs:
+ *   ticks - The number of ticks that have elapsed on the time slice of
+ *     the currently executing task.
+ *   noswitches - True:  Can't do context switches now.
+ *
+ * Return Value:
+ *   The number of ticks remaining on the time slice of the task now at the
+ *   head of the g_readytorun list or zero if that task does not use round
+ *   robin scheduling.
+ *
+ ****************************************************************************/
+
+#if CONFIG_RR_INTERVAL > 0
+static unsigned int sched_timeslice(unsigned int ticks, bool noswitches)
+{
+  FAR struct tcb_s *rtcb = this_task();
+
+  /* Check if the currently executing task uses round robin scheduling. */
+
+  if ((rtcb->flags & TCB_FLAG_ROUND_ROBIN) == 0)
+    {
+      return 0;
+    }
+
+  /* Check if the elapsed time would cause the timeslice to expire */
+
+  if (rtcb->timeslice > (int)ticks)
+    {
+      /* No.. just decrement the timeslice counter */
+
+      rtcb->timeslice -= ticks;
+      return rtcb->timeslice;
+    }
+
+  /* The timeslice has expired.  If we cannot perform a context switch now
+   * or if the task has pre-emption disabled, then freeze the timeslice
+   * count at zero and check again on the next tick.
+   */
+
+  if (noswitches || rtcb->lockcount > 0)
+    {
+      rtcb->timeslice = 0;
+      return 1;
+    }
+
+  /* Reset the timeslice in any case. */
+
+  rtcb->timeslice = MSEC2TICK(CONFIG_RR_INTERVAL);
+
+  /* We know we are at the head of the ready to run prioritized list.  We
+   * must be the highest priority task eligible for execution.  Check the
+   * next task in the ready to run list.  If it is the same priority, then
+   * we need to relinquish the CPU and give that task a shot.
+   */
+
+  if (rtcb->flink &&
+      rtcb->flink->sched_priority >= rtcb->sched_priority)
+    {
+      /* Just resetting the task priority to its current value.  This this
+       * will cause the task to be rescheduled behind any other tasks at the
+       * same priority.
+       */
+
+      up_reprioritize_rtr(rtcb, rtcb->sched_priority);
+    }
+
+  /* Return the time slice of the (possibly new) head of the list */
+
+  return sched_timeslice(0, true);
+}
+#else
+#  define sched_timeslice(t,n) (0)
+#endif
+
+/****************************************************************************
+ * Name:  sched_timer_process
+ *
+ * Description:
+ *   Bring the watchdog and timeslice counts up to date with the current
+ *   system time.
+ *
+ * Inputs:
+ *   noswitches - True:  Can't do context switches now.  No watchdog
+ *     functions will be called.
+ *
+ * Return Value:
+ *   The delay in ticks until the next timing event or zero if nothing
+ *   needs to be timed.
+ *
+ ****************************************************************************/
+
+static unsigned int sched_timer_process(bool noswitches)
+{
+  unsigned int elapsed;
+  unsigned int slice;
+  unsigned int delay;
+  uint32_t now;
+
+  /* How much time has elapsed since the timing counts were last updated? */
+
+  now          = clock_systimer();
+  elapsed      = now - g_timer_base;
+  g_timer_base = now;
+
+  /* Charge the elapsed time to the currently executing task first.  This
+   * may cause a context switch if its time slice has expired.
+   */
+
+  slice = sched_timeslice(elapsed, noswitches);
+
+  /* Then process the watchdogs.  Watchdog functions may also ready other
+   * tasks so the time slice must be re-evaluated afterward.
+   */
+
+  delay = wd_timer(elapsed, noswitches);
+  if (!noswitches)
+    {
+      slice = sched_timeslice(0, true);
+    }
+
+  /* Return the nearest of the two */
+
+  if (slice > 0 && (delay == 0 || slice < delay))
+    {
+      delay = slice;
+    }
+
+  return delay;
+}
+
+/****************************************************************************
+ * Name:  sched_timer_start
+ *
+ * Description:
+ *   Start the interval timer so that it expires 'delay' ticks after the
+ *   time base (or cancel it if there is nothing to time).
+ *
+ * Inputs:
+ *   delay - The delay in ticks relative to g_timer_base.  Zero means that
+ *     there is nothing to time.
+ *
+ * Return Value:
+ *   None
+ *
+ ****************************************************************************/
+
+static void sched_timer_start(unsigned int delay)
+{
+  struct timespec ts;
+  unsigned int elapsed;
+
+  (void)up_timer_cancel(NULL);
+  if (delay > 0)
+    {
+      /* Remove any time that has already elapsed since the time base so
+       * that there is no accumulated error.
+       */
+
+      elapsed = clock_systimer() - g_timer_base;
+      delay   = delay > elapsed ? delay - elapsed : 1;
+
+      ts.tv_sec  = delay / TICK_PER_SEC;
+      ts.tv_nsec = (delay - ts.tv_sec * TICK_PER_SEC) * NSEC_PER_TICK;
+
+      (void)up_timer_start(&ts);
+    }
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name:  sched_timer_expiration
+ *
+ * Description:
+ *   If CONFIG_SCHED_TICKLESS is defined, then this function is provided by
+ *   the RTOS base code and called from platform-specific code when the
+ *   interval timer used to implemented the tick-less OS expires.
+ *
+ * Inputs:
+ *   None
+ *
+ * Return Value:
+ *   None
+ *
+ * Assumptions:
+ *   Base code implementation assumes that this function is called from
+ *   interrupt handling logic with interrupts disabled.
+ *
+ ****************************************************************************/
+
+void sched_timer_expiration(void)
+{
+  unsigned int delay;
+
+  /* Process the timed events.  Any watchdog that is started by a watchdog
+   * function will not re-program the timer; that will be done below.
+   */
+
+  DEBUGASSERT(g_timer_nesting == 0);
+
+  g_timer_nesting++;
+  delay = sched_timer_process(false);
+  g_timer_nesting--;
+
+  /* Start the timer for the next event */
+
+  sched_timer_start(delay);
+}
+
+/****************************************************************************
+ * Name:  sched_timer_cancel
+ *
+ * Description:
+ *   Bring all timed events up to date with the current time and hold off
+ *   re-programming of the interval timer until sched_timer_resume() is
+ *   called.  This must be called before any change to the watchdog list
+ *   or to the head of the g_readytorun list.  No watchdog functions are
+ *   called and no context switches are performed.
+ *
+ * Inputs:
+ *   None
+ *
+ * Return Value:
+ *   None
+ *
+ * Assumptions:
+ *   Interrupts are disabled.  Calls must be paired with
+ *   sched_timer_resume() and may be nested.
+ *
+ ****************************************************************************/
+
+void sched_timer_cancel(void)
+{
+  if (g_timer_nesting++ == 0)
+    {
+      (void)sched_timer_process(true);
+    }
+}
+
+/****************************************************************************
+ * Name:  sched_timer_resume
+ *
+ * Description:
+ *   Re-program the interval timer for the nearest timed event after the
+ *   watchdog list or the head of the g_readytorun list was modified.
+ *
+ * Inputs:
+ *   None
+ *
+ * Return Value:
+ *   None
+ *
+ * Assumptions:
+ *   Interrupts are disabled.
+ *
+ ****************************************************************************/
+
+void sched_timer_resume(void)
+{
+  unsigned int delay;
+  unsigned int slice;
+
+  DEBUGASSERT(g_timer_nesting > 0);
+  if (--g_timer_nesting == 0)
+    {
+      /* The counts were updated by sched_timer_cancel().  Just find the
+       * nearest event and restart the timer.
+       */
+
+      delay = wd_timer(0, true);
+      slice = sched_timeslice(0, true);
+
+      if (slice > 0 && (delay == 0 || slice < delay))
+        {
+          delay = slice;
+        }
+
+      sched_timer_start(delay);
+    }
+}
+
+/****************************************************************************
+ * Name:  sched_timer_reassess
+ *
+ * Description:
+ *   It is necessary to re-assess the timer interval in several
+ *   circumstances, for example when the scheduling policy of the running
+ *   task changes.
+ *
+ * Inputs:
+ *   None
+ *
+ * Return Value:
+ *   None
+ *
+ ****************************************************************************/
+
+void sched_timer_reassess(void)
+{
+  irqstate_t flags;
+
+  flags = irqsave();
+  sched_timer_cancel();
+  sched_timer_resume();
+  irqrestore(flags);
+}
+
+#endif /* CONFIG_SCHED_TICKLESS */
@@ -86,7 +86,16 @@
 
 int sched_unlock(void)
 {
-  struct tcb_s *rtcb = (struct tcb_s*)g_readytorun.head;
+  struct tcb_s *rtcb;
+  irqstate_t flags;
+
+  /* Prevent context switches throughout the following.  In the SMP case,
+   * this also keeps the task from moving to another CPU before
+   * this_task() is sampled.
+   */
+
+  flags = irqsave();
+  rtcb  = this_task();
 
   /* Check for some special cases:  (1) rtcb may be NULL only during
    * early boot-up phases, and (2) sched_unlock() should have no
@@ -95,10 +104,6 @@ int sched_unlock(void)
 
   if (rtcb && !up_interrupt_context())
     {
-      /* Prevent context switches throughout the following */
-
-      irqstate_t flags = irqsave();
-
       /* Decrement the preemption lock counter */
 
       if (rtcb->lockcount)
@@ -114,6 +119,22 @@ int sched_unlock(void)
         {
           rtcb->lockcount = 0;
 
+#ifdef CONFIG_SMP
+          /* Release the pre-emption lock if this task holds it */
+
+          if (g_cpu_schedlock == this_cpu())
+            {
+              g_cpu_schedlock = -1;
+            }
+
+          /* There is no g_pendingtasks list in the SMP case.  Any
+           * higher priority task that became ready-to-run while pre-emption
+           * was disabled is waiting for a CPU:  Re-assign the tasks to the
+           * CPUs now.
+           */
+
+          up_release_pending();
+#else
           /* Release any ready-to-run tasks that have collected in
            * g_pendingtasks.
            */
@@ -122,10 +143,10 @@ int sched_unlock(void)
            {
              up_release_pending();
            }
+#endif
         }
-
-      irqrestore(flags);
     }
 
+  irqrestore(flags);
   return OK;
 }
@@ -0,0 +1,176 @@
+/************************************************************************
+ * sched/sched_waitlist.c
+ *
+ *   Copyright (C) 2014 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ************************************************************************/
+
+/************************************************************************
+ * Included Files
+ ************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+#include <queue.h>
+#include <assert.h>
+
+#include <nuttx/mqueue.h>
+
+#include "os_internal.h"
+
+/************************************************************************
+ * Public Functions
+ ************************************************************************/
+
+/************************************************************************
+ * Name: sched_waitlist
+ *
+ * Description:
+ *   Return the wait list of the object that a task is about to block on
+ *   in the given state.
+ *
+ * Inputs:
+ *   tcb - The TCB of the task that is about to block
+ *   task_state - The blocked state
+ *
+ * Return Value:
+ *   The per-object wait list or NULL if the state has none.
+ *
+ ************************************************************************/
+
+FAR dq_queue_t *sched_waitlist(FAR struct tcb_s *tcb, tstate_t task_state)
+{
+  switch (task_state)
+    {
+#ifdef CONFIG_SEM_WAITLIST
+      case TSTATE_WAIT_SEM:
+        if (tcb->waitsem)
+          {
+            return &tcb->waitsem->waitlist;
+          }
+        break;
+#endif
+
+#ifndef CONFIG_DISABLE_MQUEUE
+      case TSTATE_WAIT_MQNOTEMPTY:
+        if (tcb->msgwaitq)
+          {
+            return &tcb->msgwaitq->waitnotempty;
+          }
+        break;
+
+      case TSTATE_WAIT_MQNOTFULL:
+        if (tcb->msgwaitq)
+          {
+            return &tcb->msgwaitq->waitnotfull;
+          }
+        break;
+#endif
+
+      default:
+        break;
+    }
+
+  return NULL;
+}
+
+/************************************************************************
+ * Name: sched_addwaiter
+ *
+ * Description:
+ *   Add a task to a per-object wait list.  The list is kept in
+ *   descending priority order, with tasks of equal priority in FIFO
+ *   order, so the task to wake up is always at the head.
+ *
+ * Inputs:
+ *   tcb - The TCB of the waiting task
+ *   list - The wait list of the object
+ *
+ * Return Value:
+ *   None
+ *
+ * Assumptions:
+ * - The caller has established a critical section before
+ *   calling this function.
+ * - The task is not already in a wait list.
+ *
+ ************************************************************************/
+
+void sched_addwaiter(FAR struct tcb_s *tcb, FAR dq_queue_t *list)
+{
+  FAR dq_entry_t *next;
+  uint8_t sched_priority = tcb->sched_priority;
+
+  DEBUGASSERT(tcb->waitlist == NULL);
+
+  for (next = list->head;
+       next && sched_priority <= WAITLINK2TCB(next)->sched_priority;
+       next = next->flink);
+
+  if (next)
+    {
+      dq_addbefore(next, &tcb->waitlink, list);
+    }
+  else
+    {
+      dq_addlast(&tcb->waitlink, list);
+    }
+
+  tcb->waitlist = list;
+}
+
+/************************************************************************
+ * Name: sched_removewaiter
+ *
+ * Description:
+ *   Remove a task from the per-object wait list that it is in, if any.
+ *
+ * Inputs:
+ *   tcb - The TCB of the task
+ *
+ * Return Value:
+ *   None
+ *
+ * Assumptions:
+ *   The caller has established a critical section before calling this
+ *   function.
+ *
+ ************************************************************************/
+
+void sched_removewaiter(FAR struct tcb_s *tcb)
+{
+  if (tcb->waitlist)
+    {
+      dq_rem(&tcb->waitlink, tcb->waitlist);
+      tcb->waitlist = NULL;
+    }
+}
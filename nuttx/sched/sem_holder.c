@@ -559,7 +559,7 @@ static int sem_restoreholderprio(FAR struct semholder_s *pholder, FAR sem_t *sem
 static int sem_restoreholderprioA(FAR struct semholder_s *pholder,
                                   FAR sem_t *sem, FAR void *arg)
 {
-  FAR struct tcb_s *rtcb = (FAR struct tcb_s*)g_readytorun.head;
+  FAR struct tcb_s *rtcb = this_task();
   if (pholder->htcb != rtcb)
     {
       return sem_restoreholderprio(pholder, sem, arg);
@@ -579,7 +579,7 @@ static int sem_restoreholderprioA(FAR struct semholder_s *pholder,
 static int sem_restoreholderprioB(FAR struct semholder_s *pholder,
                                   FAR sem_t *sem, FAR void *arg)
 {
-  FAR struct tcb_s *rtcb = (FAR struct tcb_s*)g_readytorun.head;
+  FAR struct tcb_s *rtcb = this_task();
   if (pholder->htcb == rtcb)
     {
       (void)sem_restoreholderprio(pholder, sem, arg);
@@ -684,7 +684,7 @@ static inline void sem_restorebaseprio_irq(FAR struct tcb_s *stcb,
 
 static inline void sem_restorebaseprio_task(FAR struct tcb_s *stcb, FAR sem_t *sem)
 {
-  FAR struct tcb_s *rtcb = (FAR struct tcb_s*)g_readytorun.head;
+  FAR struct tcb_s *rtcb = this_task();
   FAR struct semholder_s *pholder;
 
   /* Perfom the following actions only if a new thread was given a count.
@@ -826,38 +826,62 @@ void sem_destroyholder(FAR sem_t *sem)
 }
 
 /****************************************************************************
- * Name: sem_addholder
+ * Name: sem_addholder_tcb
  *
  * Description:
- *   Called from sem_wait() when the calling thread obtains the semaphore
+ *   Record that the task 'htcb' holds one more count of the semaphore.  This
+ *   is used when a count is taken on behalf of another task (see
+ *   pthread_mutex_take()).
  *
  * Parameters:
- *   sem - A reference to the incremented semaphore
+ *   htcb - The TCB of the holder
+ *   sem  - A reference to the semaphore
  *
  * Return Value:
- *   0 (OK) or -1 (ERROR) if unsuccessful
+ *   None
  *
  * Assumptions:
+ *   Interrupts are disabled.
  *
  ****************************************************************************/
 
-void sem_addholder(FAR sem_t *sem)
+void sem_addholder_tcb(FAR struct tcb_s *htcb, FAR sem_t *sem)
 {
-  FAR struct tcb_s *rtcb = (FAR struct tcb_s*)g_readytorun.head;
   FAR struct semholder_s *pholder;
 
   /* Find or allocate a container for this new holder */
 
-  pholder = sem_findorallocateholder(sem, rtcb);
+  pholder = sem_findorallocateholder(sem, htcb);
   if (pholder)
     {
       /* Then set the holder and increment the number of counts held by this holder */
 
-      pholder->htcb = rtcb;
+      pholder->htcb = htcb;
       pholder->counts++;
     }
 }
 
+/****************************************************************************
+ * Name: sem_addholder
+ *
+ * Description:
+ *   Called from sem_wait() when the calling thread obtains the semaphore
+ *
+ * Parameters:
+ *   sem - A reference to the incremented semaphore
+ *
+ * Return Value:
+ *   0 (OK) or -1 (ERROR) if unsuccessful
+ *
+ * Assumptions:
+ *
+ ****************************************************************************/
+
+void sem_addholder(FAR sem_t *sem)
+{
+  sem_addholder_tcb(this_task(), sem);
+}
+
 /****************************************************************************
  * Name: void sem_boostpriority(sem_t *sem)
  *
@@ -876,7 +900,7 @@ void sem_addholder(FAR sem_t *sem)
 
 void sem_boostpriority(FAR sem_t *sem)
 {
-  FAR struct tcb_s *rtcb = (FAR struct tcb_s*)g_readytorun.head;
+  FAR struct tcb_s *rtcb = this_task();
 
   /* Boost the priority of every thread holding counts on this semaphore
    * that are lower in priority than the new thread that is waiting for a
@@ -905,7 +929,7 @@ void sem_boostpriority(FAR sem_t *sem)
 
 void sem_releaseholder(FAR sem_t *sem)
 {
-  FAR struct tcb_s *rtcb = (FAR struct tcb_s*)g_readytorun.head;
+  FAR struct tcb_s *rtcb = this_task();
   FAR struct semholder_s *pholder;
 
   /* Find the container for this holder */
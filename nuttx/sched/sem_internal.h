@@ -104,6 +104,7 @@ FAR nsem_t *sem_findnamed(const char *name);
 #ifdef CONFIG_PRIORITY_INHERITANCE
 void sem_initholders(void);
 void sem_destroyholder(FAR sem_t *sem);
+void sem_addholder_tcb(FAR struct tcb_s *htcb, FAR sem_t *sem);
 void sem_addholder(FAR sem_t *sem);
 void sem_boostpriority(FAR sem_t *sem);
 void sem_releaseholder(FAR sem_t *sem);
@@ -116,6 +117,7 @@ void sem_canceled(FAR struct tcb_s *stcb, FAR sem_t *sem);
 #else
 #  define sem_initholders()
 #  define sem_destroyholder(sem)
+#  define sem_addholder_tcb(htcb,sem)
 #  define sem_addholder(sem)
 #  define sem_boostpriority(sem)
 #  define sem_releaseholder(sem)
@@ -140,6 +140,14 @@ int sem_post(FAR sem_t *sem)
 
       if (sem->semcount <= 0)
         {
+#ifdef CONFIG_SEM_WAITLIST
+          /* Get the highest priority task that is waiting for this
+           * semaphore.  The semaphore's wait list is prioritized so this is
+           * the task at the head of the list.
+           */
+
+          stcb = sched_firstwaiter(&sem->waitlist);
+#else
           /* Check if there are any tasks in the waiting for semaphore
            * task list that are waiting for this semaphore. This is a
            * prioritized list so the first one we encounter is the one
@@ -149,6 +157,7 @@ int sem_post(FAR sem_t *sem)
           for (stcb = (FAR struct tcb_s*)g_waitingforsemaphore.head;
                (stcb && stcb->waitsem != sem);
                stcb = stcb->flink);
+#endif
 
           if (stcb)
             {
@@ -164,7 +164,7 @@ static void sem_timeout(int argc, uint32_t pid)
 
 int sem_timedwait(FAR sem_t *sem, FAR const struct timespec *abstime)
 {
-  FAR struct tcb_s *rtcb = (FAR struct tcb_s *)g_readytorun.head;
+  FAR struct tcb_s *rtcb = this_task();
   irqstate_t flags;
   int        ticks;
   int        err;
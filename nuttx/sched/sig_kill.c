@@ -85,7 +85,7 @@
 int kill(pid_t pid, int signo)
 {
 #ifdef CONFIG_SCHED_HAVE_PARENT
-  FAR struct tcb_s *rtcb = (FAR struct tcb_s *)g_readytorun.head;
+  FAR struct tcb_s *rtcb = this_task();
 #endif
   siginfo_t info;
   int ret;
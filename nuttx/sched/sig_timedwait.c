@@ -174,7 +174,7 @@ static void sig_timeout(int argc, uint32_t itcb)
 int sigtimedwait(FAR const sigset_t *set, FAR struct siginfo *info,
                  FAR const struct timespec *timeout)
 {
-  FAR struct tcb_s *rtcb = (FAR struct tcb_s*)g_readytorun.head;
+  FAR struct tcb_s *rtcb = this_task();
   sigset_t intersection;
   FAR sigpendq_t *sigpend;
   irqstate_t saved_state;
@@ -249,12 +249,12 @@ int sigtimedwait(FAR const sigset_t *set, FAR struct siginfo *info,
           DEBUGASSERT(waitticks64 <= UINT32_MAX);
           waitticks = (uint32_t)waitticks64;
 #else
-          uint32_t waitmsec;
+          uint32_t waitusec;
 
-          DEBUGASSERT(timeout->tv_sec < UINT32_MAX / MSEC_PER_SEC);
-          waitmsec = timeout->tv_sec * MSEC_PER_SEC +
-                    (timeout->tv_nsec + NSEC_PER_MSEC - 1) / NSEC_PER_MSEC;
-          waitticks = (waitmsec + MSEC_PER_TICK - 1) / MSEC_PER_TICK;
+          DEBUGASSERT(timeout->tv_sec < UINT32_MAX / USEC_PER_SEC);
+          waitusec = timeout->tv_sec * USEC_PER_SEC +
+                    (timeout->tv_nsec + NSEC_PER_USEC - 1) / NSEC_PER_USEC;
+          waitticks = (waitusec + USEC_PER_TICK - 1) / USEC_PER_TICK;
 #endif
 
           /* Create a watchdog */
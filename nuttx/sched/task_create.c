@@ -108,6 +108,7 @@ static int thread_create(FAR const char *name, uint8_t ttype, int priority,
 #endif
 {
   FAR struct task_tcb_s *tcb;
+  irqstate_t flags;
   pid_t pid;
   int errcode;
   int ret;
@@ -192,7 +193,9 @@ static int thread_create(FAR const char *name, uint8_t ttype, int priority,
 
       /* The TCB was added to the active task list by task_schedsetup() */
 
+      flags = irqsave();
       dq_rem((FAR dq_entry_t*)tcb, (dq_queue_t*)&g_inactivetasks);
+      irqrestore(flags);
       goto errout_with_tcb;
     }
 
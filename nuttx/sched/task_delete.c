@@ -116,7 +116,7 @@ int task_delete(pid_t pid)
 
   /* Check if the task to delete is the calling task */
 
-  rtcb = (FAR struct tcb_s*)g_readytorun.head;
+  rtcb = this_task();
   if (pid == 0 || pid == rtcb->pid)
     {
       /* If it is, then what we really wanted to do was exit. Note that we
@@ -103,7 +103,7 @@
 
 int task_exit(void)
 {
-  FAR struct tcb_s *dtcb = (FAR struct tcb_s*)g_readytorun.head;
+  FAR struct tcb_s *dtcb = this_task();
   FAR struct tcb_s *rtcb;
   int ret;
 
@@ -116,7 +116,7 @@ int task_exit(void)
    */
 
   (void)sched_removereadytorun(dtcb);
-  rtcb = (FAR struct tcb_s*)g_readytorun.head;
+  rtcb = this_task();
 
   /* We are now in a bad state -- the head of the ready to run task list
    * does not correspond to the thread that is running.  Disabling pre-
@@ -158,5 +158,15 @@ int task_exit(void)
    */
 
   rtcb->lockcount--;
+
+#ifdef CONFIG_SMP
+  /* Tasks that became ready-to-run while pre-emption was disabled above
+   * may now be waiting for this CPU.  Let the scheduler decide which task
+   * the architecture-specific logic must switch to.
+   */
+
+  (void)sched_smp_assign();
+#endif
+
   return ret;
 }
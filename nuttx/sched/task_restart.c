@@ -114,7 +114,7 @@ int task_restart(pid_t pid)
 
   /* Check if the task to restart is the calling task */
 
-  rtcb = (FAR struct tcb_s *)g_readytorun.head;
+  rtcb = this_task();
   if ((pid == 0) || (pid == rtcb->pid))
     {
       /* Not implemented */
@@ -148,6 +148,15 @@ int task_restart(pid_t pid)
  
       task_recover((FAR struct tcb_s *)tcb);
 
+#ifdef CONFIG_SMP
+      /* The task may be running on another CPU.  Stop it first. */
+
+      if (tcb->cmn.task_state == TSTATE_TASK_RUNNING)
+        {
+          sched_smp_stop((FAR struct tcb_s *)tcb);
+        }
+#endif
+
       /* Kill any children of this thread */
 
 #if HAVE_GROUP_MEMBERS
@@ -159,8 +168,11 @@ int task_restart(pid_t pid)
        */
 
       state = irqsave();
+      sched_bitmap_remove(sched_priobitmap(g_tasklisttable[tcb->cmn.task_state].list),
+                          (FAR struct tcb_s *)tcb);
       dq_rem((FAR dq_entry_t*)tcb,
              (dq_queue_t*)g_tasklisttable[tcb->cmn.task_state].list);
+      sched_removewaiter((FAR struct tcb_s *)tcb);
       tcb->cmn.task_state = TSTATE_TASK_INVALID;
       irqrestore(state);
 
@@ -189,8 +201,10 @@ int task_restart(pid_t pid)
 
       /* Add the task to the inactive task list */
 
+      state = irqsave();
       dq_addfirst((FAR dq_entry_t*)tcb, (dq_queue_t*)&g_inactivetasks);
       tcb->cmn.task_state = TSTATE_TASK_INACTIVE;
+      irqrestore(state);
 
       /* Activate the task */
 
@@ -98,15 +98,16 @@ static int task_assignpid(FAR struct tcb_s* tcb);
 
 static int task_assignpid(FAR struct tcb_s *tcb)
 {
+  irqstate_t flags;
   pid_t next_pid;
   int   hash_ndx;
   int   tries;
 
-  /* Disable pre-emption.  This should provide sufficient protection
-   * for the following operation.
+  /* Enter a critical section.  In the SMP case, sched_releasepid() may
+   * modify g_pidhash[] on another CPU at the same time.
    */
 
-  (void)sched_lock();
+  flags = irqsave();
 
   /* We'll try every allowable pid */
 
@@ -141,7 +142,7 @@ static int task_assignpid(FAR struct tcb_s *tcb)
 #endif
           tcb->pid = next_pid;
 
-          (void)sched_unlock();
+          irqrestore(flags);
           return OK;
         }
     }
@@ -150,7 +151,7 @@ static int task_assignpid(FAR struct tcb_s *tcb)
    * We cannot allow another task to be started.
    */
 
-  (void)sched_unlock();
+  irqrestore(flags);
   return ERROR;
 }
 
@@ -177,7 +178,7 @@ static int task_assignpid(FAR struct tcb_s *tcb)
 #ifdef CONFIG_SCHED_HAVE_PARENT
 static inline void task_saveparent(FAR struct tcb_s *tcb, uint8_t ttype)
 {
-  FAR struct tcb_s *rtcb = (FAR struct tcb_s*)g_readytorun.head;
+  FAR struct tcb_s *rtcb = this_task();
 
 #if defined(HAVE_GROUP_MEMBERS) || defined(CONFIG_SCHED_CHILD_STATUS)
   DEBUGASSERT(tcb && tcb->group && rtcb->group);
@@ -282,7 +283,7 @@ static inline void task_saveparent(FAR struct tcb_s *tcb, uint8_t ttype)
 #ifdef CONFIG_PIC
 static inline void task_dupdspace(FAR struct tcb_s *tcb)
 {
-  FAR struct tcb_s *rtcb = (FAR struct tcb_s*)g_readytorun.head;
+  FAR struct tcb_s *rtcb = this_task();
   if (rtcb->dspace != NULL)
     {
       /* Copy the D-Space structure reference and increment the reference
@@ -326,6 +327,7 @@ static inline void task_dupdspace(FAR struct tcb_s *tcb)
 static int thread_schedsetup(FAR struct tcb_s *tcb, int priority,
                              start_t start, CODE void *entry, uint8_t ttype)
 {
+  irqstate_t flags;
   int ret;
 
   /* Assign a unique task ID to the task. */
@@ -342,6 +344,12 @@ static int thread_schedsetup(FAR struct tcb_s *tcb, int priority,
       tcb->start          = start;
       tcb->entry.main     = (main_t)entry;
 
+#ifdef CONFIG_SMP
+      /* By default, the new thread may run on any CPU */
+
+      tcb->affinity       = SCHED_ALL_CPUS;
+#endif
+
       /* Save the thread type.  This setting will be needed in
        * up_initial_state() is called.
        */
@@ -383,10 +391,10 @@ static int thread_schedsetup(FAR struct tcb_s *tcb, int priority,
 
       /* Add the task to the inactive task list */
 
-      sched_lock();
+      flags = irqsave();
       dq_addfirst((FAR dq_entry_t*)tcb, (dq_queue_t*)&g_inactivetasks);
       tcb->task_state = TSTATE_TASK_INACTIVE;
-      sched_unlock();
+      irqrestore(flags);
     }
 
   return ret;
@@ -142,6 +142,17 @@ int task_terminate(pid_t pid, bool nonblocking)
       return -ESRCH;
     }
 
+#ifdef CONFIG_SMP
+  /* In the SMP case, the task may be running on another CPU.  It must be
+   * stopped before it can be deleted.
+   */
+
+  if (dtcb->task_state == TSTATE_TASK_RUNNING && dtcb != this_task())
+    {
+      sched_smp_stop(dtcb);
+    }
+#endif
+
   /* Verify our internal sanity */
 
   if (dtcb->task_state == TSTATE_TASK_RUNNING ||
@@ -167,7 +178,10 @@ int task_terminate(pid_t pid, bool nonblocking)
   /* Remove the task from the OS's tasks lists. */
 
   saved_state = irqsave();
+  sched_bitmap_remove(sched_priobitmap(g_tasklisttable[dtcb->task_state].list),
+                      dtcb);
   dq_rem((FAR dq_entry_t*)dtcb, (dq_queue_t*)g_tasklisttable[dtcb->task_state].list);
+  sched_removewaiter(dtcb);
   dtcb->task_state = TSTATE_TASK_INVALID;
   irqrestore(saved_state);
 
@@ -46,6 +46,7 @@
 #include <errno.h>
 #include <debug.h>
 
+#include <nuttx/irq.h>
 #include <nuttx/sched.h>
 
 #include "os_internal.h"
@@ -110,7 +111,7 @@
 
 FAR struct task_tcb_s *task_vforksetup(start_t retaddr)
 {
-  struct tcb_s *parent = (FAR struct tcb_s *)g_readytorun.head;
+  struct tcb_s *parent = this_task();
   struct task_tcb_s *child;
   uint8_t ttype;
   int priority;
@@ -235,14 +236,14 @@ errout_with_tcb:
 pid_t task_vforkstart(FAR struct task_tcb_s *child)
 {
 #if CONFIG_TASK_NAME_SIZE > 0
-  struct tcb_s *parent = (FAR struct tcb_s *)g_readytorun.head;
+  struct tcb_s *parent = this_task();
 #endif
   FAR const char *name;
   pid_t pid;
   int rc;
   int ret;
 
-  svdbg("Starting Child TCB=%p, parent=%p\n", child, g_readytorun.head);
+  svdbg("Starting Child TCB=%p, parent=%p\n", child, this_task());
   DEBUGASSERT(child);
 
   /* Setup to pass parameters to the new task */
@@ -330,9 +331,13 @@ pid_t task_vforkstart(FAR struct task_tcb_s *child)
 
 void task_vforkabort(FAR struct task_tcb_s *child, int errcode)
 {
+  irqstate_t flags;
+
   /* The TCB was added to the active task list by task_schedsetup() */
 
+  flags = irqsave();
   dq_rem((FAR dq_entry_t*)child, (dq_queue_t*)&g_inactivetasks);
+  irqrestore(flags);
 
   /* Release the TCB */
 
@@ -90,8 +90,6 @@
 
 int wd_cancel (WDOG_ID wdid)
 {
-  wdog_t    *curr;
-  wdog_t    *prev;
   irqstate_t saved_state;
   int        ret = ERROR;
 
@@ -105,47 +103,17 @@ int wd_cancel (WDOG_ID wdid)
 
   if (wdid && wdid->active)
     {
-      /* Search the g_wdactivelist for the target FCB.  We can't use sq_rem
-       * to do this because there are additional operations that need to be
-       * done.
+      /* In the tick-less mode, the watchdog time base must be brought up
+       * to date before the timer queue can be modified.
        */
 
-      prev = NULL;
-      curr = (wdog_t*)g_wdactivelist.head;
+      sched_timer_cancel();
 
-      while((curr) && (curr != wdid))
-        {
-          prev = curr;
-          curr = curr->next;
-        }
-
-      /* Check if the watchdog was found in the list.  If not, then an OS
-       * error has occurred because the watchdog is marked active!
+      /* Remove the watchdog from the timer queue.  The watchdog records its
+       * own position in the queue so no search is required.
        */
 
-      ASSERT(curr);
-
-      /* If there is a watchdog in the timer queue after the one that
-       * is being canceled, then it inherits the remaining ticks.
-       */
-
-      if (curr->next)
-        {
-          curr->next->lag += curr->lag;
-        }
-
-      /* Now, remove the watchdog from the timer queue */
-
-      if (prev)
-        {
-          (void)sq_remafter((FAR sq_entry_t*)prev, &g_wdactivelist);
-        }
-      else
-        {
-          (void)sq_remfirst(&g_wdactivelist);
-        }
-
-      wdid->next = NULL;
+      wd_heapremove(wdid);
 
       /* Return success */
 
@@ -154,6 +122,10 @@ int wd_cancel (WDOG_ID wdid)
       /* Mark the watchdog inactive */
 
       wdid->active = false;
+
+      /* Re-program the interval timer for the new head of the timer queue */
+
+      sched_timer_resume();
     }
 
   irqrestore(saved_state);
@@ -39,6 +39,7 @@
 
 #include <nuttx/config.h>
 
+#include <stdint.h>
 #include <wdog.h>
 
 #include "os_internal.h"
@@ -89,30 +90,27 @@
 int wd_gettime(WDOG_ID wdog)
 {
   irqstate_t flags;
+  int delay = 0;
 
   /* Verify the wdog */
 
   flags = irqsave();
   if (wdog && wdog->active)
     {
-      /* Traverse the watchdog list accumulating lag times until we find the wdog
-       * that we are looking for
+      /* The time remaining is the difference between the absolute
+       * expiration time and the current watchdog time.  In the tick-less
+       * mode, the watchdog time base must first be brought up to date.
        */
 
-      wdog_t *curr;
-      int delay = 0;
-
-      for (curr = (wdog_t*)g_wdactivelist.head; curr; curr = curr->next)
-        {
-          delay += curr->lag;
-          if (curr == wdog)
-            {
-              irqrestore(flags);
-              return delay;
-            }
-        }
+      int32_t remaining;
+
+      sched_timer_cancel();
+      remaining = (int32_t)(wdog->expire - g_wdclock);
+      sched_timer_resume();
+
+      delay = remaining > 0 ? (int)remaining : 0;
     }
 
   irqrestore(flags);
-  return 0;
+  return delay;
 }
@@ -0,0 +1,228 @@
+/****************************************************************************
+ * sched/wd_heap.c
+ *
+ *   Copyright (C) 2014 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <wdog.h>
+
+#include "wd_internal.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Heap index arithmetic */
+
+#define WD_PARENT(n) (((n) - 1) >> 1)
+#define WD_LEFT(n)   (((n) << 1) + 1)
+
+/* Compare two expiration times.  The watchdog clock wraps around so the
+ * comparison must be performed on the signed difference.
+ */
+
+#define WD_BEFORE(a,b) ((int32_t)((a)->expire - (b)->expire) < 0)
+
+/****************************************************************************
+ * Private Type Declarations
+ ****************************************************************************/
+
+/****************************************************************************
+ * Global Variables
+ ****************************************************************************/
+
+/****************************************************************************
+ * Private Variables
+ ****************************************************************************/
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: wd_heapset
+ *
+ * Description:
+ *   Place a watchdog at a position in the heap.
+ *
+ ****************************************************************************/
+
+static inline void wd_heapset(unsigned int ndx, FAR wdog_t *wdog)
+{
+  g_wdheap[ndx] = wdog;
+  wdog->hndx    = (uint16_t)ndx;
+}
+
+/****************************************************************************
+ * Name: wd_siftup
+ *
+ * Description:
+ *   Move a watchdog toward the top of the heap until its parent expires no
+ *   later than it does.
+ *
+ ****************************************************************************/
+
+static void wd_siftup(unsigned int ndx, FAR wdog_t *wdog)
+{
+  FAR wdog_t *parent;
+
+  while (ndx > 0)
+    {
+      parent = g_wdheap[WD_PARENT(ndx)];
+      if (!WD_BEFORE(wdog, parent))
+        {
+          break;
+        }
+
+      wd_heapset(ndx, parent);
+      ndx = WD_PARENT(ndx);
+    }
+
+  wd_heapset(ndx, wdog);
+}
+
+/****************************************************************************
+ * Name: wd_siftdown
+ *
+ * Description:
+ *   Move a watchdog toward the bottom of the heap until neither of its
+ *   children expires before it does.
+ *
+ ****************************************************************************/
+
+static void wd_siftdown(unsigned int ndx, FAR wdog_t *wdog)
+{
+  FAR wdog_t *child;
+  unsigned int cndx;
+
+  while ((cndx = WD_LEFT(ndx)) < g_wdnactive)
+    {
+      /* Select the child that expires first */
+
+      child = g_wdheap[cndx];
+      if (cndx + 1 < g_wdnactive && WD_BEFORE(g_wdheap[cndx + 1], child))
+        {
+          cndx++;
+          child = g_wdheap[cndx];
+        }
+
+      if (!WD_BEFORE(child, wdog))
+        {
+          break;
+        }
+
+      wd_heapset(ndx, child);
+      ndx = cndx;
+    }
+
+  wd_heapset(ndx, wdog);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: wd_heapinsert
+ *
+ * Description:
+ *   Add a watchdog to the timer queue.  The expiration time of the watchdog
+ *   must have been set by the caller.
+ *
+ * Parameters:
+ *   wdog - The watchdog to be added
+ *
+ * Return Value:
+ *   None
+ *
+ * Assumptions:
+ *   Interrupts are disabled and the watchdog is not already in the timer
+ *   queue.
+ *
+ ****************************************************************************/
+
+void wd_heapinsert(FAR wdog_t *wdog)
+{
+  DEBUGASSERT(g_wdnactive < CONFIG_PREALLOC_WDOGS);
+  wd_siftup(g_wdnactive++, wdog);
+}
+
+/****************************************************************************
+ * Name: wd_heapremove
+ *
+ * Description:
+ *   Remove a watchdog from any position in the timer queue.
+ *
+ * Parameters:
+ *   wdog - The watchdog to be removed
+ *
+ * Return Value:
+ *   None
+ *
+ * Assumptions:
+ *   Interrupts are disabled and the watchdog is in the timer queue.
+ *
+ ****************************************************************************/
+
+void wd_heapremove(FAR wdog_t *wdog)
+{
+  FAR wdog_t *last;
+  unsigned int ndx = wdog->hndx;
+
+  ASSERT(ndx < g_wdnactive && g_wdheap[ndx] == wdog);
+
+  /* Fill the hole with the last watchdog in the heap and restore the heap
+   * ordering from that position.
+   */
+
+  last = g_wdheap[--g_wdnactive];
+  if (last != wdog)
+    {
+      if (ndx > 0 && WD_BEFORE(last, g_wdheap[WD_PARENT(ndx)]))
+        {
+          wd_siftup(ndx, last);
+        }
+      else
+        {
+          wd_siftdown(ndx, last);
+        }
+    }
+}
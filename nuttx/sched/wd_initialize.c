@@ -39,6 +39,7 @@
 
 #include <nuttx/config.h>
 
+#include <stdint.h>
 #include <queue.h>
 #include <nuttx/kmalloc.h>
 
@@ -69,12 +70,21 @@ sq_queue_t g_wdfreelist;
 
 FAR wdog_t *g_wdpool;
 
-/* The g_wdactivelist data structure is a singly linked list ordered by
- * watchdog expiration time. When watchdog timers expire,the functions on
- * this linked list are removed and the function is called.
+/* The active watchdogs are retained in a binary min-heap ordered by
+ * absolute expiration time.  g_wdheap[0] is the watchdog that will expire
+ * next.  The heap is large enough to hold every watchdog in the pool so it
+ * is allocated statically and can never overflow.
  */
 
-sq_queue_t g_wdactivelist;
+FAR wdog_t *g_wdheap[CONFIG_PREALLOC_WDOGS];
+
+/* The number of active watchdogs in g_wdheap[] */
+
+unsigned int g_wdnactive;
+
+/* The watchdog time base in clock ticks */
+
+uint32_t g_wdclock;
 
 /************************************************************************
  * Private Variables
@@ -129,7 +139,8 @@ void wd_initialize(void)
         }
     }
 
-  /* The g_wdactivelist queue must be reset at initialization time. */
+  /* The timer queue must be reset at initialization time */
 
-  sq_init(&g_wdactivelist);
+  g_wdnactive = 0;
+  g_wdclock   = 0;
 }
@@ -1,5 +1,5 @@
 /************************************************************************
- * sched/d_internal.h
+ * sched/wd_internal.h
  *
  *   Copyright (C) 2007, 2009 Gregory Nutt. All rights reserved.
  *   Author: Gregory Nutt <gnutt@nuttx.org>
@@ -52,6 +52,20 @@
  * Pre-processor Definitions
  ************************************************************************/
 
+/* The position of each active watchdog in the timer queue is held in a
+ * 16-bit index.
+ */
+
+#if CONFIG_PREALLOC_WDOGS > 65535
+#  error CONFIG_PREALLOC_WDOGS is too large
+#endif
+
+/* Return the active watchdog that will expire next (or NULL if there are
+ * no active watchdogs).
+ */
+
+#define wd_heaphead() (g_wdnactive > 0 ? g_wdheap[0] : NULL)
+
 /************************************************************************
  * Public Type Declarations
  ************************************************************************/
@@ -67,9 +81,10 @@ struct wdog_s
 #ifdef CONFIG_PIC
   FAR void          *picbase;    /* PIC base address */
 #endif
-  int                lag;        /* Timer associated with the delay */
+  uint32_t           expire;     /* Absolute expiration time (g_wdclock) */
   bool               active;     /* true if the watchdog is actively timing */
   uint8_t            argc;       /* The number of parameters to pass */
+  uint16_t           hndx;       /* Position of the watchdog in g_wdheap[] */
   uint32_t           parm[CONFIG_MAX_WDOGPARMS];
 };
 typedef struct wdog_s wdog_t;
@@ -90,12 +105,26 @@ extern sq_queue_t g_wdfreelist;
 
 extern FAR wdog_t *g_wdpool;
 
-/* The g_wdactivelist data structure is a singly linked list ordered by
- * watchdog expiration time. When watchdog timers expire,the functions on
- * this linked list are removed and the function is called.
+/* The active watchdogs are retained in a binary min-heap ordered by
+ * absolute expiration time so that watchdogs can be started and cancelled
+ * in O(log n) time.  g_wdheap[0] is the watchdog that will expire next.
+ * The heap is statically sized to hold all CONFIG_PREALLOC_WDOGS
+ * watchdogs.
+ */
+
+extern FAR wdog_t *g_wdheap[CONFIG_PREALLOC_WDOGS];
+
+/* The number of active watchdogs in g_wdheap[] */
+
+extern unsigned int g_wdnactive;
+
+/* This is the watchdog time base in clock ticks.  It is incremented on each
+ * timer interrupt (or by the elapsed time in the tick-less mode).  Watchdog
+ * expiration times are absolute values of this free-running counter and
+ * are compared using modular arithmetic.
  */
 
-extern sq_queue_t g_wdactivelist;
+extern uint32_t g_wdclock;
 
 /************************************************************************
  * Public Function Prototypes
@@ -109,7 +138,44 @@ extern "C" {
 #endif
 
 EXTERN void weak_function wd_initialize(void);
+
+/****************************************************************************
+ * Name: wd_heapinsert and wd_heapremove
+ *
+ * Description:
+ *   Add an active watchdog to the timer queue or remove it from the timer
+ *   queue.  wdog->expire must be valid before wd_heapinsert() is called.
+ *
+ * Assumptions:
+ *   Interrupts are disabled.
+ *
+ ****************************************************************************/
+
+EXTERN void wd_heapinsert(FAR wdog_t *wdog);
+EXTERN void wd_heapremove(FAR wdog_t *wdog);
+
+/****************************************************************************
+ * Name: wd_timer
+ *
+ * Description:
+ *   This function is called from the timer interrupt handler to determine
+ *   if it is time to execute a watchdog function.  If so, the watchdog
+ *   function will be executed in the context of the timer interrupt
+ *   handler.
+ *
+ *   In the tick-less mode, the number of ticks that have elapsed since the
+ *   last call is provided.  If noswitches is true, then the watchdog time
+ *   base is updated but no watchdog functions are called.  The delay in ticks
+ *   until the next watchdog expiration is returned (zero if there are no
+ *   active watchdogs).
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_TICKLESS
+EXTERN unsigned int wd_timer(int ticks, bool noswitches);
+#else
 EXTERN void weak_function wd_timer(void);
+#endif
 
 #undef EXTERN
 #ifdef __cplusplus
@@ -88,6 +88,86 @@ typedef void (*wdentry4_t)(int argc, uint32_t arg1, uint32_t arg2,
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: wd_expiration
+ *
+ * Description:
+ *   Check if the watchdog at the head of the timer queue is ready to run.
+ *   If so, remove and run that watchdog and any other watchdogs that became
+ *   ready to run at this time.
+ *
+ * Parameters:
+ *   None
+ *
+ * Return Value:
+ *   None
+ *
+ * Assumptions:
+ *   Interrupts are disabled.
+ *
+ ****************************************************************************/
+
+static inline void wd_expiration(void)
+{
+  FAR wdog_t *wdog;
+
+  /* Process the watchdog at the head of the timer queue as well as any
+   * other watchdogs that became ready to run at this time
+   */
+
+  while ((wdog = wd_heaphead()) != NULL &&
+         (int32_t)(g_wdclock - wdog->expire) >= 0)
+    {
+      /* Remove the watchdog from the head of the timer queue */
+
+      wd_heapremove(wdog);
+
+      /* Indicate that the watchdog is no longer active. */
+
+      wdog->active = false;
+
+      /* Execute the watchdog function */
+
+      up_setpicbase(wdog->picbase);
+      switch (wdog->argc)
+        {
+          default:
+#ifdef CONFIG_DEBUG
+            PANIC();
+#endif
+          case 0:
+            (*((wdentry0_t)(wdog->func)))(0);
+            break;
+
+#if CONFIG_MAX_WDOGPARMS > 0
+          case 1:
+            (*((wdentry1_t)(wdog->func)))(1, wdog->parm[0]);
+            break;
+#endif
+#if CONFIG_MAX_WDOGPARMS > 1
+          case 2:
+            (*((wdentry2_t)(wdog->func)))(2,
+                            wdog->parm[0], wdog->parm[1]);
+            break;
+#endif
+#if CONFIG_MAX_WDOGPARMS > 2
+          case 3:
+            (*((wdentry3_t)(wdog->func)))(3,
+                            wdog->parm[0], wdog->parm[1],
+                            wdog->parm[2]);
+            break;
+#endif
+#if CONFIG_MAX_WDOGPARMS > 3
+          case 4:
+            (*((wdentry4_t)(wdog->func)))(4,
+                            wdog->parm[0], wdog->parm[1],
+                            wdog->parm[2] ,wdog->parm[3]);
+            break;
+#endif
+        }
+    }
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -128,10 +208,6 @@ typedef void (*wdentry4_t)(int argc, uint32_t arg1, uint32_t arg2,
 int wd_start(WDOG_ID wdog, int delay, wdentry_t wdentry,  int argc, ...)
 {
   va_list    ap;
-  FAR wdog_t *curr;
-  FAR wdog_t *prev;
-  FAR wdog_t *next;
-  int32_t    now;
   irqstate_t saved_state;
   int        i;
 
@@ -150,6 +226,13 @@ int wd_start(WDOG_ID wdog, int delay, wdentry_t wdentry,  int argc, ...)
    */
 
   saved_state = irqsave();
+
+  /* In the tick-less mode, the watchdog time base must be brought up to
+   * date before the timer queue can be modified.
+   */
+
+  sched_timer_cancel();
+
   if (wdog->active)
     {
       wd_cancel(wdog);
@@ -185,89 +268,17 @@ int wd_start(WDOG_ID wdog, int delay, wdentry_t wdentry,  int argc, ...)
       delay--;
     }
 
-  /* Do the easy case first -- when the watchdog timer queue is empty. */
-
-  if (g_wdactivelist.head == NULL)
-    {
-      sq_addlast((FAR sq_entry_t*)wdog,&g_wdactivelist);
-    }
-
-  /* There are other active watchdogs in the timer queue */
-
-  else
-    {
-      now = 0;
-      prev = curr = (FAR wdog_t*)g_wdactivelist.head;
-
-      /* Advance to positive time */
-
-      while ((now += curr->lag) < 0 && curr->next)
-        {
-          prev = curr;
-          curr = curr->next;
-        }
-
-      /* Advance past shorter delays */
-
-      while (now <= delay && curr->next)
-       {
-         prev = curr;
-         curr = curr->next;
-         now += curr->lag;
-       }
-
-      /* Check if the new wdog must be inserted before the curr. */
-
-      if (delay < now)
-        {
-          /* The relative delay time is smaller or equal to the current delay
-           * time, so decrement the current delay time by the new relative
-           * delay time.
-           */
-
-          delay -= (now - curr->lag);
-          curr->lag -= delay;
-
-          /* Insert the new watchdog in the list */
-
-          if (curr == (FAR wdog_t*)g_wdactivelist.head)
-            {
-              sq_addfirst((FAR sq_entry_t*)wdog, &g_wdactivelist);
-            }
-          else
-            {
-              sq_addafter((FAR sq_entry_t*)prev, (FAR sq_entry_t*)wdog,
-                          &g_wdactivelist);
-            }
-        }
-
-      /* The new watchdog delay time is greater than the curr delay time,
-       * so the new wdog must be inserted after the curr. This only occurs
-       * if the wdog is to be added to the end of the list.
-       */
-
-      else
-        {
-          delay -= now;
-          if (!curr->next)
-            {
-              sq_addlast((FAR sq_entry_t*)wdog, &g_wdactivelist);
-            }
-          else
-            {
-              next = curr->next;
-              next->lag -= delay;
-              sq_addafter((FAR sq_entry_t*)curr, (FAR sq_entry_t*)wdog,
-                          &g_wdactivelist);
-            }
-        }
-    }
-
-  /* Put the lag into the watchdog structure and mark it as active. */
+  /* Set the absolute expiration time and add the watchdog to the timer
+   * queue.  This is an O(log n) operation.
+   */
 
-  wdog->lag = delay;
+  wdog->expire = g_wdclock + (uint32_t)delay;
   wdog->active = true;
+  wd_heapinsert(wdog);
+
+  /* Re-program the interval timer if the head of the timer queue changed */
 
+  sched_timer_resume();
   irqrestore(saved_state);
   return OK;
 }
@@ -281,95 +292,73 @@ int wd_start(WDOG_ID wdog, int delay, wdentry_t wdentry,  int argc, ...)
  *   function will be executed in the context of the timer interrupt handler.
  *
  * Parameters:
- *   None
+ *   ticks - If CONFIG_SCHED_TICKLESS is defined then the number of ticks
+ *     in the interval that just expired is provided.  Otherwise, this
+ *     function is called on each timer interrupt and a value of one is
+ *     implicit.
+ *   noswitches - If CONFIG_SCHED_TICKLESS is defined and noswitches is
+ *     true, then the watchdog time base is updated but no watchdog
+ *     functions are called.
  *
  * Return Value:
- *   None
+ *   If CONFIG_SCHED_TICKLESS is defined then the number of ticks for the
+ *   next delay is provided (zero if no delay).  Otherwise, this function
+ *   has no returned value.
  *
  * Assumptions:
+ *   Called from interrupt handler logic with interrupts disabled.
  *
  ****************************************************************************/
 
-void wd_timer(void)
+#ifdef CONFIG_SCHED_TICKLESS
+unsigned int wd_timer(int ticks, bool noswitches)
 {
   FAR wdog_t *wdog;
+  int32_t delay;
 
-  /* Check if there are any active watchdogs to process */
-
-  if (g_wdactivelist.head)
-    {
-      /* There are.  Decrement the lag counter */
-
-      --(((FAR wdog_t*)g_wdactivelist.head)->lag);
+  /* Advance the watchdog time base by the elapsed time */
 
-      /* Check if the watchdog at the head of the list is ready to run */
+  g_wdclock += (uint32_t)ticks;
 
-      if (((FAR wdog_t*)g_wdactivelist.head)->lag <= 0)
-        {
-          /* Process the watchdog at the head of the list as well as any
-           * other watchdogs that became ready to run at this time
-           */
+  /* Then process the watchdogs that have expired (unless we are not
+   * permitted to do that now).
+   */
 
-          while (g_wdactivelist.head &&
-                 ((FAR wdog_t*)g_wdactivelist.head)->lag <= 0)
-            {
-              /* Remove the watchdog from the head of the list */
+  if (!noswitches)
+    {
+      wd_expiration();
+    }
 
-              wdog = (FAR wdog_t*)sq_remfirst(&g_wdactivelist);
+  /* Return the delay for the next watchdog to expire.  An overdue watchdog
+   * should be processed as soon as possible.
+   */
 
-              /* If there is another watchdog behind this one, update its
-               * its lag (this shouldn't be necessary).
-               */
+  wdog = wd_heaphead();
+  if (wdog == NULL)
+    {
+      return 0;
+    }
 
-              if (g_wdactivelist.head)
-                {
-                  ((FAR wdog_t*)g_wdactivelist.head)->lag += wdog->lag;
-                }
+  delay = (int32_t)(wdog->expire - g_wdclock);
+  return delay > 0 ? (unsigned int)delay : 1;
+}
 
-              /* Indicate that the watchdog is no longer active. */
+#else
+void wd_timer(void)
+{
+  /* Advance the watchdog time base */
 
-              wdog->active = false;
+  g_wdclock++;
 
-              /* Execute the watchdog function */
+  /* Check if there are any active watchdogs to process */
 
-              up_setpicbase(wdog->picbase);
-              switch (wdog->argc)
-                {
-                  default:
-#ifdef CONFIG_DEBUG
-                    PANIC();
-#endif
-                  case 0:
-                    (*((wdentry0_t)(wdog->func)))(0);
-                    break;
+  if (g_wdnactive > 0)
+    {
+      /* Check if the watchdog at the head of the timer queue is ready to
+       * run.
+       */
 
-#if CONFIG_MAX_WDOGPARMS > 0
-                  case 1:
-                    (*((wdentry1_t)(wdog->func)))(1, wdog->parm[0]);
-                    break;
-#endif
-#if CONFIG_MAX_WDOGPARMS > 1
-                  case 2:
-                    (*((wdentry2_t)(wdog->func)))(2,
-                                    wdog->parm[0], wdog->parm[1]);
-                    break;
-#endif
-#if CONFIG_MAX_WDOGPARMS > 2
-                  case 3:
-                    (*((wdentry3_t)(wdog->func)))(3,
-                                    wdog->parm[0], wdog->parm[1],
-                                    wdog->parm[2]);
-                    break;
-#endif
-#if CONFIG_MAX_WDOGPARMS > 3
-                  case 4:
-                    (*((wdentry4_t)(wdog->func)))(4,
-                                    wdog->parm[0], wdog->parm[1],
-                                    wdog->parm[2] ,wdog->parm[3]);
-                    break;
-#endif
-                }
-            }
-        }
+      wd_expiration();
     }
 }
+#endif /* CONFIG_SCHED_TICKLESS */
@@ -75,6 +75,7 @@
 #include <errno.h>
 
 #include <nuttx/clock.h>
+#include <nuttx/pthread.h>
 
 /* clock_systimer is a special case:  In the kernel build, proxying for
  * clock_systimer() must be handled specially.  In the kernel phase of
@@ -221,9 +221,14 @@ SYSCALL_LOOKUP(up_assert,                 2, STUB_up_assert)
   SYSCALL_LOOKUP(pthread_key_delete,      1, STUB_pthread_key_delete)
   SYSCALL_LOOKUP(pthread_mutex_destroy,   1, STUB_pthread_mutex_destroy)
   SYSCALL_LOOKUP(pthread_mutex_init,      2, STUB_pthread_mutex_init)
+#  ifdef CONFIG_MUTEX_FASTPATH
+  SYSCALL_LOOKUP(pthread_mutex_give,      1, STUB_pthread_mutex_give)
+  SYSCALL_LOOKUP(pthread_mutex_take,      1, STUB_pthread_mutex_take)
+#  else
   SYSCALL_LOOKUP(pthread_mutex_lock,      1, STUB_pthread_mutex_lock)
   SYSCALL_LOOKUP(pthread_mutex_trylock,   1, STUB_pthread_mutex_trylock)
   SYSCALL_LOOKUP(pthread_mutex_unlock,    1, STUB_pthread_mutex_unlock)
+#  endif
   SYSCALL_LOOKUP(pthread_once,            2, STUB_pthread_once)
   SYSCALL_LOOKUP(pthread_setcancelstate,  2, STUB_pthread_setcancelstate)
   SYSCALL_LOOKUP(pthread_setschedparam,   3, STUB_pthread_setschedparam)
@@ -238,7 +238,9 @@ uintptr_t STUB_pthread_key_delete(int nbr, uintptr_t parm1);
 uintptr_t STUB_pthread_mutex_destroy(int nbr, uintptr_t parm1);
 uintptr_t STUB_pthread_mutex_init(int nbr, uintptr_t parm1,
             uintptr_t parm2);
+uintptr_t STUB_pthread_mutex_give(int nbr, uintptr_t parm1);
 uintptr_t STUB_pthread_mutex_lock(int nbr, uintptr_t parm1);
+uintptr_t STUB_pthread_mutex_take(int nbr, uintptr_t parm1);
 uintptr_t STUB_pthread_mutex_trylock(int nbr, uintptr_t parm1);
 uintptr_t STUB_pthread_mutex_unlock(int nbr, uintptr_t parm1);
 uintptr_t STUB_pthread_once(int nbr, uintptr_t parm1, uintptr_t parm2);